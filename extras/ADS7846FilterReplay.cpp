@@ -0,0 +1,264 @@
+/*
+ * @file ADS7846FilterReplay.cpp
+ *
+ * Host replay of synthetic noisy touch traces through the touch filter lib/BlueDisplay/LocalDisplay/ADS7846Filter.hpp,
+ * compared with the former path of ADS7846, which read readData(4) 10 ms after the PENIRQ edge and then every 20 ms.
+ * The trace is a touch from 100 to 1100 ms with a drag from 600 to 900 ms. The pressure bounces during the first
+ * 8 ms and the last 8 ms of the contact. Each X and Y sample gets normal distributed noise and random outliers of 300 raw.
+ * The sampler is emulated like ADS7846.hpp does it: the first burst 1 ms after the edge, then 3 ms until touch down
+ * and 10 ms while touched.
+ *
+ * Checks for each noise level:
+ * - Exactly one touch down and one touch up event.
+ * - Touch down latency and touch up delay are below TOUCH_LATENCY_MILLIS_MAX.
+ * - The rms error of the filtered positions is below the one of the former path.
+ * - No event is dropped if the main loop reads the queue only every 50 ms, because moves are coalesced.
+ *
+ * Build from the repository root:
+ * g++ -O2 -Ilib/BlueDisplay/LocalDisplay -o ADS7846FilterReplay extras/ADS7846FilterReplay.cpp
+ * Usage: ADS7846FilterReplay
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "ADS7846Filter.hpp"
+
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include <random>
+
+#include "host/hostTest.h"
+
+#define TOUCH_START_MILLIS          100
+#define TOUCH_END_MILLIS            1100
+#define DRAG_START_MILLIS           600
+#define DRAG_MILLIS                 300
+#define BOUNCE_MILLIS               8
+#define TRACE_END_MILLIS            1300
+#define RAW_PER_PIXEL_X             6.4
+#define RAW_PER_PIXEL_Y             8.5
+#define TOUCH_LATENCY_MILLIS_MAX    20
+#define FORMER_DEBOUNCE_MILLIS      10
+#define FORMER_PERIOD_MILLIS        20
+#define SAMPLER_FIRST_MILLIS        1
+#define SAMPLER_DOWN_MILLIS         3
+#define SAMPLER_TOUCHED_MILLIS      10
+
+struct NoiseStruct {
+    const char *Name;
+    double SigmaX; // raw values
+    double SigmaY;
+    double OutlierProbability;
+};
+
+static const NoiseStruct sNoiseLevels[] = { { "normal noise", 6, 10, 0.03 }, { "3x noise, 10 % outliers", 18, 30, 0.10 } };
+
+struct ResultStruct {
+    int Downs;
+    int Ups;
+    int DownLatencyMillis;
+    int UpDelayMillis;
+    double SquaredErrorSum; // in pixel
+    int Positions;
+};
+
+static std::mt19937 sRandom(3);
+static bool isChance(double aProbability) {
+    return std::uniform_real_distribution<double>(0, 1)(sRandom) < aProbability;
+}
+
+/*
+ * @return false if not touched at aMillis
+ */
+static bool getTruth(int aMillis, double *aX, double *aY, uint8_t *aPressure) {
+    if (aMillis < TOUCH_START_MILLIS || aMillis > TOUCH_END_MILLIS) {
+        *aPressure = 0;
+        return false;
+    }
+    double tFraction = 0;
+    if (aMillis > DRAG_START_MILLIS) {
+        tFraction = fmin(1.0, (aMillis - DRAG_START_MILLIS) / (double) DRAG_MILLIS);
+    }
+    *aX = 1000 + 600 * tFraction;
+    *aY = 1000 + 300 * tFraction;
+    *aPressure = 40;
+    if (aMillis < TOUCH_START_MILLIS + BOUNCE_MILLIS) {
+        *aPressure = isChance(0.5) ? 0 : (aMillis - TOUCH_START_MILLIS) * 5;
+    } else if (aMillis > TOUCH_END_MILLIS - BOUNCE_MILLIS) {
+        *aPressure = isChance(0.5) ? 0 : 20;
+    }
+    return true;
+}
+
+static uint16_t getSample(double aValue, double aSigma, double aOutlierProbability) {
+    double tValue = aValue + std::normal_distribution<double>(0, aSigma)(sRandom);
+    if (isChance(aOutlierProbability)) {
+        tValue += isChance(0.5) ? 300 : -300;
+    }
+    return (tValue < 0) ? 0 : tValue;
+}
+
+static void addPosition(ResultStruct *aResult, int aMillis, double aX, double aY) {
+    double tX, tY;
+    uint8_t tPressure;
+    if (getTruth(aMillis, &tX, &tY, &tPressure)) {
+        double tError = hypot((aX - tX) / RAW_PER_PIXEL_X, (aY - tY) / RAW_PER_PIXEL_Y);
+        aResult->SquaredErrorSum += tError * tError;
+        aResult->Positions++;
+    }
+}
+
+static void readEvents(ResultStruct *aResult) {
+    TouchFilterEventStruct tEvent;
+    while (TouchFilter_getEvent(&tEvent)) {
+        if (tEvent.Type == TOUCH_FILTER_EVENT_DOWN) {
+            if (aResult->Downs++ == 0) {
+                aResult->DownLatencyMillis = tEvent.Millis - TOUCH_START_MILLIS;
+            }
+        } else if (tEvent.Type == TOUCH_FILTER_EVENT_UP) {
+            aResult->Ups++;
+            aResult->UpDelayMillis = tEvent.Millis - TOUCH_END_MILLIS;
+        }
+        if (tEvent.Type != TOUCH_FILTER_EVENT_UP) {
+            addPosition(aResult, tEvent.Millis, tEvent.RawX, tEvent.RawY);
+        }
+    }
+}
+
+/*
+ * Bursts by SPI DMA, processed by TouchFilter_processBurst() like the DMA end callback does it
+ * @param aReadPeriodMillis period of the main loop reading the queue
+ */
+static void replayFilter(const NoiseStruct *aNoise, int aReadPeriodMillis, ResultStruct *aResult, double *aNanosPerBurst) {
+    TouchFilter_reset();
+    TouchFilter_resetStatistics();
+    int tNextBurstMillis = -1;
+    long long tNanos = 0;
+    for (int tMillis = 0; tMillis < TRACE_END_MILLIS; tMillis++) {
+        double tX, tY;
+        uint8_t tPressure;
+        bool tIsTouched = getTruth(tMillis, &tX, &tY, &tPressure);
+        if (tNextBurstMillis < 0 && tIsTouched) {
+            // PENIRQ edge
+            tNextBurstMillis = tMillis + SAMPLER_FIRST_MILLIS;
+        }
+        if (tMillis == tNextBurstMillis) {
+            TouchBurstStruct tBurst;
+            tBurst.IsValid = true;
+            tBurst.PressureAtStart = tPressure;
+            for (int i = 0; i < TOUCH_FILTER_SAMPLES_PER_BURST; ++i) {
+                tBurst.RawX[i] = getSample(tX, aNoise->SigmaX, aNoise->OutlierProbability);
+                tBurst.RawY[i] = getSample(tY, aNoise->SigmaY, aNoise->OutlierProbability);
+            }
+            getTruth(tMillis, &tX, &tY, &tBurst.PressureAtEnd);
+            auto tStart = std::chrono::steady_clock::now();
+            TouchFilter_processBurst(&tBurst, tMillis);
+            tNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - tStart).count();
+            if (TouchFilter_isTouched()) {
+                tNextBurstMillis = tMillis + SAMPLER_TOUCHED_MILLIS;
+            } else if (tPressure >= TOUCH_FILTER_MIN_PRESSURE) {
+                tNextBurstMillis = tMillis + SAMPLER_DOWN_MILLIS;
+            } else {
+                // wait for next edge
+                tNextBurstMillis = -1;
+            }
+        }
+        if (tMillis % aReadPeriodMillis == 0) {
+            readEvents(aResult);
+        }
+    }
+    readEvents(aResult);
+    *aNanosPerBurst = (double) tNanos / TouchFilter_getStatistics()->Bursts;
+}
+
+/*
+ * Former path: PENIRQ edge, FORMER_DEBOUNCE_MILLIS delay, readData(4) with 4 X and 8 Y samples,
+ * then readData(4) every FORMER_PERIOD_MILLIS until the pressure is too low
+ */
+static void replayFormer(const NoiseStruct *aNoise, ResultStruct *aResult) {
+    int tNextReadMillis = -1;
+    bool tIsActive = false;
+    for (int tMillis = 0; tMillis < TRACE_END_MILLIS; tMillis++) {
+        double tX, tY;
+        uint8_t tPressure;
+        bool tIsTouched = getTruth(tMillis, &tX, &tY, &tPressure);
+        if (tNextReadMillis < 0 && tIsTouched && !tIsActive) {
+            tNextReadMillis = tMillis + FORMER_DEBOUNCE_MILLIS;
+        }
+        if (tMillis == tNextReadMillis) {
+            if (tPressure >= TOUCH_FILTER_MIN_PRESSURE) {
+                double tSumX = 0, tSumY = 0;
+                for (int i = 0; i < 4; ++i) {
+                    tSumX += getSample(tX, aNoise->SigmaX, aNoise->OutlierProbability);
+                    tSumY += getSample(tY, aNoise->SigmaY, aNoise->OutlierProbability);
+                    tSumY += getSample(tY, aNoise->SigmaY, aNoise->OutlierProbability);
+                }
+                if (!tIsActive && aResult->Downs++ == 0) {
+                    aResult->DownLatencyMillis = tMillis - TOUCH_START_MILLIS;
+                }
+                tIsActive = true;
+                addPosition(aResult, tMillis, tSumX / 4, tSumY / 8);
+                tNextReadMillis = tMillis + FORMER_PERIOD_MILLIS;
+            } else {
+                if (tIsActive) {
+                    aResult->Ups++;
+                    aResult->UpDelayMillis = tMillis - TOUCH_END_MILLIS;
+                }
+                tIsActive = false;
+                tNextReadMillis = -1;
+            }
+        }
+        if (!tIsTouched && tIsActive) {
+            tIsActive = false;
+            aResult->Ups++;
+            aResult->UpDelayMillis = tMillis - TOUCH_END_MILLIS;
+            tNextReadMillis = -1;
+        }
+    }
+}
+
+static double printResult(const char *aName, ResultStruct *aResult) {
+    double tRMSError = sqrt(aResult->SquaredErrorSum / aResult->Positions);
+    printf("  %-8s %d down, %d up, down latency %2d ms, up delay %2d ms, rms error %.1f pixel of %d positions\n", aName,
+            aResult->Downs, aResult->Ups, aResult->DownLatencyMillis, aResult->UpDelayMillis, tRMSError, aResult->Positions);
+    return tRMSError;
+}
+
+int main(void) {
+    for (unsigned int i = 0; i < sizeof(sNoiseLevels) / sizeof(sNoiseLevels[0]); ++i) {
+        const NoiseStruct *tNoise = &sNoiseLevels[i];
+        ResultStruct tFilterResult = { };
+        ResultStruct tFormerResult = { };
+        double tNanosPerBurst;
+        replayFilter(tNoise, 1, &tFilterResult, &tNanosPerBurst);
+        TouchFilterStatisticsTypeDef *tStatistics = TouchFilter_getStatistics();
+        printf("%s: %lu bursts, %lu noisy, %lu jumps rejected, %.0f ns per burst on host\n", tNoise->Name,
+                (unsigned long) tStatistics->Bursts, (unsigned long) tStatistics->NoisyBursts,
+                (unsigned long) tStatistics->JumpsRejected, tNanosPerBurst);
+        replayFormer(tNoise, &tFormerResult);
+        double tFilterError = printResult("filter", &tFilterResult);
+        double tFormerError = printResult("former", &tFormerResult);
+
+        check(tFilterResult.Downs == 1 && tFilterResult.Ups == 1, "one touch down and up");
+        check(tFilterResult.DownLatencyMillis <= TOUCH_LATENCY_MILLIS_MAX, "touch down latency");
+        check(tFilterResult.UpDelayMillis >= 0 && tFilterResult.UpDelayMillis <= TOUCH_LATENCY_MILLIS_MAX, "touch up delay");
+        check(tFilterError < tFormerError, "filter error greater than error of former path");
+
+        // slow main loop
+        ResultStruct tSlowResult = { };
+        replayFilter(tNoise, 50, &tSlowResult, &tNanosPerBurst);
+        printf("  read every 50 ms: %lu events coalesced, %lu dropped, max queue depth %u\n",
+                (unsigned long) tStatistics->EventsCoalesced, (unsigned long) tStatistics->EventsDropped,
+                tStatistics->QueueDepthMax);
+        check(tSlowResult.Downs == 1 && tSlowResult.Ups == 1 && tStatistics->EventsDropped == 0, "events of slow main loop");
+    }
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
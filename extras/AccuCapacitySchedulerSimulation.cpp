@@ -0,0 +1,247 @@
+/*
+ * @file AccuCapacitySchedulerSimulation.cpp
+ *
+ * Host simulation of the non blocking measurement scheduler src/AccuCapacityScheduler.hpp of AccuCapacity.
+ * Two NiMH cells are discharged over a 5 Ohm load until the voltage without load drops below 1 Volt.
+ * A cell is modeled by its open circuit voltage depending on the state of charge, an ohmic resistance of 150 mOhm
+ * and a RC element of 50 mOhm and 2000 F for the slow polarisation voltage. The ADC adds normal distributed noise of 1.5 LSB.
+ * Time advances in steps of 1 ms and the timer delay callback of changeDelayCallback() is emulated.
+ *
+ * Checks:
+ * - The measured capacity of each probe must be within 1 % of the integrated current of the model.
+ * - The mean error of the measured ESR against the ohmic resistance must be below 10 mOhm.
+ *   The RC element must not disturb the ESR, since the voltage without load is sampled LOAD_SWITCH_SETTLE_TIME_MILLIS after switching.
+ * - storeBatteryValues() must be called once per sample period for each probe.
+ * - The probes must never use the ADC at the same time.
+ *
+ * Build from the repository root:
+ * g++ -O2 -Isrc -o AccuCapacitySchedulerSimulation extras/AccuCapacitySchedulerSimulation.cpp
+ * Usage: AccuCapacitySchedulerSimulation
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+
+#include "host/hostTest.h"
+
+/*
+ * Values and reduced structures of AccuCapacity.hpp and the timing module, which are used by the scheduler
+ */
+#define NUMBER_OF_PROBES                2
+#define ONE_SECOND_MILLIS               1000
+#define MODE_DISCHARGING                0x00
+#define MODE_CHARGING                   0x01
+#define MODE_EXTERNAL_VOLTAGE           0x02
+#define LOAD_SWITCH_SETTLE_TIME_MILLIS  5
+#define DISABLE_TIMER_DELAY_VALUE       0
+#define SAMPLE_PERIOD_MILLIS            ONE_SECOND_MILLIS
+
+struct BatteryInfoStruct {
+    uint16_t VoltageNoLoadMillivolt;
+    uint16_t VoltageLoadMillivolt;
+    int16_t Milliampere;
+    uint16_t ESRMilliohm;
+    uint16_t sESRTestDeltaMillivolt;
+    uint32_t CapacityAccumulator;
+    uint16_t CapacityMilliampereHour;
+};
+
+struct DataloggerMeasurementControlStruct {
+    bool IsStarted;
+    uint8_t Mode;
+    uint8_t ProbeIndex;
+    uint16_t SamplePeriodSeconds;
+    uint16_t ChargeVoltageMillivolt;
+    struct BatteryInfoStruct BatteryInfo;
+    uint16_t LoadResistorMilliohm;
+    float ExternalAttenuatorFactor;
+};
+DataloggerMeasurementControlStruct BatteryControl[NUMBER_OF_PROBES];
+
+#define SIMULATION_MAX_MILLIS       (20UL * 3600 * 1000)
+#define START_MILLIS                3000
+#define STOP_VOLTAGE_MILLIVOLT      1000
+#define LOAD_RESISTOR_OHM           5.0
+#define ADC_MAX_READING             4095
+#define ADC_NOISE_LSB               1.5
+#define CAPACITY_ERROR_PERCENT_MAX  1.0
+#define ESR_ERROR_MILLIOHM_MAX      10.0
+
+float sADCToVoltFactor = 3.3f / ADC_MAX_READING;
+
+static uint32_t sMillis;
+static void (*sDelayCallback)(void);
+static int32_t sDelayMillis;
+
+uint32_t millis(void) {
+    return sMillis;
+}
+
+void changeDelayCallback(void (*aCallback)(void), int32_t aDelayMillis) {
+    sDelayCallback = aCallback;
+    sDelayMillis = aDelayMillis;
+}
+
+/*
+ * Battery model
+ */
+struct BatteryModelStruct {
+    double StateOfCharge;
+    double CapacityMilliampereHour;
+    double OhmicResistance;
+    double PolarisationResistance;
+    double PolarisationCapacity; // in Farad
+    double PolarisationVoltage;
+    bool IsLoaded;
+    double CurrentSumMilliseconds; // in Ampere * ms
+} sBattery[NUMBER_OF_PROBES];
+
+/*
+ * Shape of a single NiMH cell
+ */
+static double getOpenCircuitVoltage(double aStateOfCharge) {
+    return 1.0 + 0.35 * aStateOfCharge + 0.015 * log(aStateOfCharge / (1.001 - aStateOfCharge)) - 0.08 * exp(-aStateOfCharge * 30);
+}
+
+static double getBatteryCurrent(BatteryModelStruct *aBattery) {
+    if (!aBattery->IsLoaded) {
+        return 0;
+    }
+    return (getOpenCircuitVoltage(aBattery->StateOfCharge) - aBattery->PolarisationVoltage)
+            / (LOAD_RESISTOR_OHM + aBattery->OhmicResistance);
+}
+
+static double getTerminalVoltage(BatteryModelStruct *aBattery) {
+    return getOpenCircuitVoltage(aBattery->StateOfCharge) - aBattery->PolarisationVoltage
+            - getBatteryCurrent(aBattery) * aBattery->OhmicResistance;
+}
+
+static void doBatteryStep(BatteryModelStruct *aBattery) {
+    double tCurrent = getBatteryCurrent(aBattery);
+    aBattery->CurrentSumMilliseconds += tCurrent;
+    aBattery->StateOfCharge -= tCurrent * 1000 / (3600.0 * 1000) / aBattery->CapacityMilliampereHour;
+    if (aBattery->StateOfCharge < 0.001) {
+        aBattery->StateOfCharge = 0.001;
+    }
+    aBattery->PolarisationVoltage += (tCurrent * aBattery->PolarisationResistance - aBattery->PolarisationVoltage) * 0.001
+            / (aBattery->PolarisationResistance * aBattery->PolarisationCapacity);
+}
+
+/*
+ * ADC and switches of AccuCapacity.h
+ */
+static std::mt19937 sRandom(1);
+static std::normal_distribution<double> sNoise(0, ADC_NOISE_LSB);
+static uint8_t sADCProbe;
+static bool sConversionIsPending;
+static int sConversionValue;
+static int sStoreCount[NUMBER_OF_PROBES];
+static long sADCConflictCount;
+
+void AccuCapacity_ADCSelectProbe(uint8_t aProbeIndex) {
+    if (sConversionIsPending) {
+        // conversion of other probe was not read
+        sADCConflictCount++;
+    }
+    sADCProbe = aProbeIndex;
+}
+
+void AccuCapacity_ADCStartConversion(void) {
+    long tReading = lround(getTerminalVoltage(&sBattery[sADCProbe]) / sADCToVoltFactor + sNoise(sRandom));
+    sConversionValue = (tReading < 0) ? 0 : ((tReading > ADC_MAX_READING) ? ADC_MAX_READING : tReading);
+    sConversionIsPending = true;
+}
+
+int AccuCapacity_ADCGetConversion(void) {
+    if (!sConversionIsPending) {
+        return -1;
+    }
+    sConversionIsPending = false;
+    return sConversionValue;
+}
+
+void setSinkSource(unsigned int aProbeIndex, bool aDoActivate) {
+    sBattery[aProbeIndex].IsLoaded = aDoActivate && BatteryControl[aProbeIndex].Mode == MODE_DISCHARGING;
+}
+
+void storeBatteryValues(DataloggerMeasurementControlStruct *aProbe) {
+    sStoreCount[aProbe->ProbeIndex]++;
+}
+
+#include "AccuCapacityScheduler.hpp"
+
+int main(void) {
+    for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+        sBattery[i] = {1.0, 2000, 0.15, 0.05, 2000, 0, false, 0};
+        BatteryControl[i].ProbeIndex = i;
+        BatteryControl[i].Mode = MODE_DISCHARGING;
+        BatteryControl[i].SamplePeriodSeconds = 1;
+        BatteryControl[i].LoadResistorMilliohm = LOAD_RESISTOR_OHM * 1000;
+        BatteryControl[i].ChargeVoltageMillivolt = 1450;
+        BatteryControl[i].ExternalAttenuatorFactor = 1.0;
+    }
+    sMillis = 0;
+    startMeasurementScheduler();
+
+    double tESRErrorSum = 0;
+    long tESRCount = 0;
+    long tCallbackCount = 0;
+    uint32_t tEndMillis = 0;
+    for (sMillis = 0; sMillis < SIMULATION_MAX_MILLIS && tEndMillis == 0; sMillis++) {
+        if (sMillis == START_MILLIS) {
+            // like startStopMeasurement()
+            for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+                BatteryControl[i].IsStarted = true;
+                setSinkSource(i, true);
+                sMeasurementScheduler[i].MeasurementsUntilStore = getMeasurementsPerStore(&BatteryControl[i]);
+            }
+        }
+        for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+            doBatteryStep(&sBattery[i]);
+        }
+        if (sDelayMillis > 0 && --sDelayMillis == 0) {
+            sDelayCallback();
+            tCallbackCount++;
+        }
+        if (sMillis > START_MILLIS && sMillis % ONE_SECOND_MILLIS == ONE_SECOND_MILLIS - 1) {
+            for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+                if (BatteryControl[i].BatteryInfo.ESRMilliohm != 0) {
+                    tESRErrorSum += fabs(BatteryControl[i].BatteryInfo.ESRMilliohm - sBattery[i].OhmicResistance * 1000);
+                    tESRCount++;
+                }
+            }
+            if (BatteryControl[0].BatteryInfo.VoltageNoLoadMillivolt < STOP_VOLTAGE_MILLIVOLT) {
+                tEndMillis = sMillis;
+            }
+        }
+    }
+    check(tEndMillis != 0, "battery was not discharged in simulation time");
+
+    long tPeriods = (tEndMillis - START_MILLIS) / SAMPLE_PERIOD_MILLIS;
+    for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+        double tMilliampereHour = sBattery[i].CurrentSumMilliseconds * 1000 / (3600.0 * 1000);
+        double tErrorPercent = 100 * (BatteryControl[i].BatteryInfo.CapacityMilliampereHour - tMilliampereHour) / tMilliampereHour;
+        printf("Probe %d: %.1f mAh discharged, %u mAh measured, error %.2f %%, %d stores\n", i, tMilliampereHour,
+                BatteryControl[i].BatteryInfo.CapacityMilliampereHour, tErrorPercent, sStoreCount[i]);
+        check(fabs(tErrorPercent) < CAPACITY_ERROR_PERCENT_MAX, "capacity error");
+        check(labs(sStoreCount[i] - tPeriods) <= 1, "one store per sample period");
+    }
+    double tESRErrorMean = (tESRCount > 0) ? tESRErrorSum / tESRCount : 1000;
+    printf("Discharged after %.2f h, mean ESR error %.1f mOhm, %.1f callbacks per second\n", tEndMillis / (3600.0 * 1000),
+            tESRErrorMean, tCallbackCount / (tEndMillis / 1000.0));
+    check(tESRErrorMean < ESR_ERROR_MILLIOHM_MAX, "mean ESR error");
+    check(sADCConflictCount == 0, "ADC used by both probes");
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
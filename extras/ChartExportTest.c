@@ -0,0 +1,213 @@
+/*
+ * @file ChartExportTest.c
+ *
+ * Host test of the AccuCapacity chart export chartExport.c on the SPI level card simulator mmc_sim.c.
+ * ChartExport_formatFixedPoint() is compared with snprintf("%6.3f;%5u\n") for all 16 bit values.
+ * Then a history of a long measurement, of which most blocks are spilled to the card, is exported
+ * as CSV and as binary file by the write behind queue. Both files are read back and compared with the samples.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o ChartExportTest extras/ChartExportTest.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c
+ *     lib/fat_sd/writeBehind.c lib/fat_sd/sampleHistory.c lib/fat_sd/chartExport.c
+ * Usage: ChartExportTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "chartExport.h"
+#include "writeBehind.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "host/hostTest.h"
+
+#define SAMPLE_COUNT        4000    // more than the RAM blocks of the history can hold
+#define GUI_LOOP_MICROS     1000    // simulated duration of the rest of loopAccuCapacity()
+#define CSV_HEADER          "Probe Nr:1\nSample interval:1:00 min\nVolt no load;mOhm\n"
+#define FILE_BUFFER_SIZE    (SAMPLE_COUNT * CHART_EXPORT_CSV_LINE_LENGTH + 1024)
+
+static SampleHistoryTypeDef sHistory;
+static uint16_t sVoltage[SAMPLE_COUNT];
+static uint16_t sESR[SAMPLE_COUNT];
+static uint8_t sFile[FILE_BUFFER_SIZE];
+static char sExpected[FILE_BUFFER_SIZE];
+static int sCallbackCount;
+static FRESULT sCallbackResult;
+static void callbackCompleted(FRESULT aResult, void *aContext) {
+    (void) aContext;
+    sCallbackCount++;
+    sCallbackResult = aResult;
+}
+
+static uint16_t getWord(const uint8_t *aBuffer) {
+    return aBuffer[0] | (aBuffer[1] << 8);
+}
+
+static UINT readFile(const char *aFileName) {
+    FIL tFile;
+    UINT tCount = 0;
+    if (f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ) == FR_OK) {
+        f_read(&tFile, sFile, sizeof(sFile), &tCount);
+        f_close(&tFile);
+    }
+    return tCount;
+}
+
+static void checkFormatFixedPoint(void) {
+    char tExpected[32];
+    char tLine[32];
+    long tMismatches = 0;
+    for (uint32_t tValue = 0; tValue <= 0xFFFF; ++tValue) {
+        snprintf(tExpected, sizeof(tExpected), "%6.3f;%5u\n", tValue / 1000.0, (unsigned int) tValue);
+        char *tPointer = ChartExport_formatFixedPoint(tLine, tValue, CHART_EXPORT_VOLT_WIDTH, 3);
+        *tPointer++ = ';';
+        tPointer = ChartExport_formatFixedPoint(tPointer, tValue, CHART_EXPORT_MILLIOHM_WIDTH, 0);
+        *tPointer++ = '\n';
+        *tPointer = '\0';
+        if (strcmp(tExpected, tLine) != 0) {
+            if (tMismatches++ < 3) {
+                printf("\"%s\" instead of \"%s\"\n", tLine, tExpected);
+            }
+        }
+    }
+    check(tMismatches == 0, "formatFixedPoint differs from snprintf");
+
+    // leading digits which do not fit are discarded, the width is kept
+    *ChartExport_formatFixedPoint(tLine, 123456, 6, 3) = '\0';
+    check(strcmp(tLine, "23.456") == 0, "formatFixedPoint of too long value");
+    *ChartExport_formatFixedPoint(tLine, 7, 5, 3) = '\0';
+    check(strcmp(tLine, "0.007") == 0, "formatFixedPoint of value below 1");
+
+    static char tOutput[FILE_BUFFER_SIZE];
+    clock_t tStart = clock();
+    for (int k = 0; k < 100; ++k) {
+        int tIndex = 0;
+        for (int i = 0; i < 1200; ++i) {
+            tIndex += snprintf(&tOutput[tIndex], sizeof(tOutput) - tIndex, "%6.3f;%5d\n", 0.001f * sVoltage[i], sESR[i]);
+        }
+    }
+    double tSnprintfMicros = (clock() - tStart) * (1000000.0 / CLOCKS_PER_SEC) / 100;
+    tStart = clock();
+    for (int k = 0; k < 100; ++k) {
+        char *tPointer = tOutput;
+        for (int i = 0; i < 1200; ++i) {
+            tPointer = ChartExport_formatFixedPoint(tPointer, sVoltage[i], CHART_EXPORT_VOLT_WIDTH, 3);
+            *tPointer++ = ';';
+            tPointer = ChartExport_formatFixedPoint(tPointer, sESR[i], CHART_EXPORT_MILLIOHM_WIDTH, 0);
+            *tPointer++ = '\n';
+        }
+    }
+    double tFormatMicros = (clock() - tStart) * (1000000.0 / CLOCKS_PER_SEC) / 100;
+    printf("1200 lines on host: snprintf %.1f us, formatFixedPoint %.1f us\n", tSnprintfMicros, tFormatMicros);
+}
+
+/*
+ * Slowly falling voltage with noise, which requires escape codes, and a rising ESR
+ */
+static void fillHistory(void) {
+    SampleHistory_init(&sHistory, "history.bin");
+    srand(5);
+    bool tIsAppended = true;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        sVoltage[i] = 4150 - (i / 4) + (rand() % 40);
+        sESR[i] = 150 + (i / 100) + (rand() % 3);
+        tIsAppended &= SampleHistory_append(&sHistory, sVoltage[i], sESR[i]);
+        SampleHistory_service(&sHistory);
+        WriteBehind_service();
+        HostPlatform_spendMicros(GUI_LOOP_MICROS);
+    }
+    check(tIsAppended, "SampleHistory_append");
+    WriteBehind_waitForCompletion(1000);
+    printf("History: %u blocks, %u in RAM\n", sHistory.BlockCount, sHistory.BlockCount - sHistory.FirstRAMBlock);
+    check(sHistory.FirstRAMBlock > 0, "no block of history spilled");
+    HostPlatform_printCardStatistics("history of 4000 samples");
+}
+
+static void runQueue(const char *aName) {
+    WriteBehind_resetStatistics();
+    int tLoops = 0;
+    while (WriteBehind_getQueueDepth() > 0) {
+        WriteBehind_service();
+        HostPlatform_spendMicros(GUI_LOOP_MICROS);
+        tLoops++;
+    }
+    const WriteBehindStatisticsTypeDef *tStatistics = WriteBehind_getStatistics();
+    printf("%s: %d loops, loop blocked for max %lu us\n", aName, tLoops, (unsigned long) tStatistics->ServiceMicrosMax);
+    check(sCallbackCount == 1 && sCallbackResult == FR_OK && ChartExport_getReadResult() == FR_OK, "export completed");
+    HostPlatform_printCardStatistics(aName);
+}
+
+static void checkCSV(void) {
+    sCallbackCount = 0;
+    uint8_t tFileHandle = WriteBehind_open("probe1.csv");
+    check(ChartExport_queueCSV(tFileHandle, &sHistory, SAMPLE_COUNT, CSV_HEADER, strlen(CSV_HEADER)), "ChartExport_queueCSV");
+    WriteBehind_close(tFileHandle, &callbackCompleted, NULL);
+    runQueue("CSV export");
+
+    UINT tLength = readFile("probe1.csv");
+    MMCSim_resetStatistics(); // reading for the check is not part of the test
+    int tIndex = snprintf(sExpected, sizeof(sExpected), CSV_HEADER);
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        tIndex += snprintf(&sExpected[tIndex], sizeof(sExpected) - tIndex, "%6.3f;%5d\n", sVoltage[i] / 1000.0, sESR[i]);
+    }
+    check(tLength == (UINT) tIndex && memcmp(sFile, sExpected, tIndex) == 0, "CSV file differs from snprintf output");
+}
+
+static void checkBinary(void) {
+    sCallbackCount = 0;
+    ChartExportBinaryHeaderTypeDef tHeader;
+    memset(&tHeader, 0, sizeof(tHeader));
+    tHeader.ProbeNumber = 1;
+    tHeader.SamplePeriodSeconds = 60;
+    tHeader.SampleCount = SAMPLE_COUNT;
+    tHeader.CapacityMilliampereHour = 2000;
+    uint8_t tFileHandle = WriteBehind_open("probe1.acb");
+    check(ChartExport_queueBinary(tFileHandle, &sHistory, &tHeader), "ChartExport_queueBinary");
+    WriteBehind_close(tFileHandle, &callbackCompleted, NULL);
+    runQueue("binary export");
+
+    UINT tLength = readFile("probe1.acb");
+    MMCSim_resetStatistics();
+    const ChartExportBinaryHeaderTypeDef *tFileHeader = (const ChartExportBinaryHeaderTypeDef*) sFile;
+    check(tFileHeader->Magic == CHART_EXPORT_BINARY_MAGIC && tFileHeader->Version == CHART_EXPORT_BINARY_VERSION
+                    && tFileHeader->HeaderSize == sizeof(ChartExportBinaryHeaderTypeDef), "binary header");
+    check(tFileHeader->SampleCount == SAMPLE_COUNT && tFileHeader->CapacityMilliampereHour == 2000
+                    && tFileHeader->NumberOfColumns == 2, "binary header values");
+    uint32_t tVoltageOffset = tFileHeader->Columns[0].Offset;
+    uint32_t tESROffset = tFileHeader->Columns[1].Offset;
+    check(strcmp(tFileHeader->Columns[1].Name, "ESR") == 0 && tVoltageOffset % _MAX_SS == 0 && tESROffset % _MAX_SS == 0
+                    && tESROffset >= tVoltageOffset + SAMPLE_COUNT * 2, "binary columns");
+    check(tLength == tESROffset + SAMPLE_COUNT * 2, "size of binary file");
+    bool tDataIsValid = (tLength <= sizeof(sFile));
+    for (int i = 0; i < SAMPLE_COUNT && tDataIsValid; ++i) {
+        tDataIsValid = (getWord(&sFile[tVoltageOffset + i * 2]) == sVoltage[i] && getWord(&sFile[tESROffset + i * 2]) == sESR[i]);
+    }
+    check(tDataIsValid, "binary columns differ from samples");
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+
+    fillHistory();
+    checkFormatFixedPoint();
+    checkCSV();
+    checkBinary();
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
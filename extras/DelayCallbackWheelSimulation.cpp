@@ -0,0 +1,248 @@
+/*
+ * @file DelayCallbackWheelSimulation.cpp
+ *
+ * Host simulation of src/DelayCallbackWheel.hpp, compared with the former linear callback table of timing.cpp,
+ * which was scanned and decremented completely every millisecond and had 11 entries.
+ * Built with NUMBER_OF_CALLBACKS_MAX=11, the module has its default size and uses its table.
+ * Otherwise it is enlarged and uses its wheel.
+ * n callbacks, each re-arming itself with its period by change like the touch sampler does, run for 1 million ticks.
+ * Mixed periods are 1 to 20 ms, 0.1 to 2 s and 10 s to 10 min, idle timers have only the long periods.
+ * The duration of each tick including the callbacks is measured with the x86 time stamp counter,
+ * which adds about 50 cycles of measuring overhead.
+ *
+ * Checks:
+ * - Each callback is called at the same ticks by both schedulers.
+ * - An expired call is dropped by changing the delay before it is run.
+ * The cycles are only printed, since the noise of a shared host is up to 20% of the small averages.
+ *
+ * Build from the repository root on a x86 host:
+ * g++ -O2 -Isrc -o DelayCallbackWheelSimulation extras/DelayCallbackWheelSimulation.cpp
+ * g++ -O2 -Isrc -DNUMBER_OF_CALLBACKS_MAX=11 -o DelayCallbackTableSimulation extras/DelayCallbackWheelSimulation.cpp
+ * Usage: DelayCallbackWheelSimulation
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <x86intrin.h> // for __rdtsc()
+#include <algorithm>
+#include <vector>
+
+#include "host/hostTest.h"
+
+#if !defined(NUMBER_OF_CALLBACKS_MAX)
+#define NUMBER_OF_CALLBACKS_MAX     256
+#endif
+#define FORMER_CALLBACK_ENTRIES_SIZE    11
+#if NUMBER_OF_CALLBACKS_MAX > FORMER_CALLBACK_ENTRIES_SIZE
+#define DELAY_CALLBACK_ENTRIES_SIZE (NUMBER_OF_CALLBACKS_MAX + 44)
+#define LINEAR_TABLE_SIZE           NUMBER_OF_CALLBACKS_MAX
+#else
+#define LINEAR_TABLE_SIZE           FORMER_CALLBACK_ENTRIES_SIZE
+#endif
+#include "DelayCallbackWheel.hpp"
+
+#define NUMBER_OF_TICKS             1000000
+#define NUMBER_OF_RUNS              3
+#define SCHEDULER_LINEAR            0
+#define SCHEDULER_MODULE            1 // table or wheel
+
+#if DELAY_CALLBACK_ENTRIES_SIZE > DELAY_CALLBACK_TABLE_ENTRIES_MAX
+#define MODULE_NAME                 "wheel"
+#else
+#define MODULE_NAME                 "table"
+#endif
+
+static int sScheduler;
+static uint32_t sMillis;
+static uint32_t sPeriod[NUMBER_OF_CALLBACKS_MAX];
+static uint64_t sCallCount[2][NUMBER_OF_CALLBACKS_MAX];
+static uint64_t sCallHash[2]; // hash of index and time of all calls
+/*
+ * The former table of timing.cpp
+ */
+static void (*sDelayCallbackPointer[LINEAR_TABLE_SIZE])(void);
+static int32_t sDelayCallbackMillis[LINEAR_TABLE_SIZE];
+static int sLinearTableSize;
+
+static void registerLinearDelayCallback(void (*aCallback)(void), int32_t aTimeMillis) {
+    for (int i = 0; i < sLinearTableSize; ++i) {
+        if (sDelayCallbackMillis[i] == 0) {
+            sDelayCallbackPointer[i] = aCallback;
+            sDelayCallbackMillis[i] = aTimeMillis;
+            return;
+        }
+    }
+}
+
+static void changeLinearDelayCallback(void (*aCallback)(void), int32_t aTimeMillis) {
+    for (int i = 0; i < sLinearTableSize; ++i) {
+        if (sDelayCallbackPointer[i] == aCallback) {
+            sDelayCallbackMillis[i] = aTimeMillis;
+            return;
+        }
+    }
+    registerLinearDelayCallback(aCallback, aTimeMillis);
+}
+
+static void doLinearTick(void) {
+    for (int i = 0; i < sLinearTableSize; ++i) {
+        if (sDelayCallbackMillis[i] > 0) {
+            sDelayCallbackMillis[i]--;
+            if (sDelayCallbackMillis[i] == 0) {
+                sDelayCallbackPointer[i]();
+            }
+        }
+    }
+}
+
+/*
+ * Each callback needs its own address, since callbacks are identified by it
+ */
+template<int aIndex> void callback(void) {
+    sCallCount[sScheduler][aIndex]++;
+    sCallHash[sScheduler] += (uint64_t) (sMillis * 2654435761u) * (aIndex + 1);
+    if (sScheduler == SCHEDULER_LINEAR) {
+        changeLinearDelayCallback(&callback<aIndex>, sPeriod[aIndex]);
+    } else {
+        DelayCallbackWheel_change(&callback<aIndex>, sPeriod[aIndex]);
+    }
+}
+
+static void (*sCallbacks[NUMBER_OF_CALLBACKS_MAX])(void);
+
+template<int aIndex> struct CallbackTable {
+    static void fill(void) {
+        sCallbacks[aIndex - 1] = &callback<aIndex - 1>;
+        CallbackTable<aIndex - 1>::fill();
+    }
+};
+template<> struct CallbackTable<0> {
+    static void fill(void) {
+    }
+};
+
+/*
+ * Prints average and 99.9 percentile of the cycles per tick for both schedulers.
+ * Both run NUMBER_OF_RUNS times alternately and the run with the lowest average is taken,
+ * to suppress the time taken by other processes of the host.
+ * The former table had at least FORMER_CALLBACK_ENTRIES_SIZE entries to scan.
+ */
+static void simulate(int aNumberOfCallbacks, bool aOnlyLongPeriods) {
+    static std::vector<uint32_t> sCycles(NUMBER_OF_TICKS);
+    double tAverage[2] = { 1e9, 1e9 };
+    uint32_t tPercentile[2];
+    sLinearTableSize = std::max(aNumberOfCallbacks, FORMER_CALLBACK_ENTRIES_SIZE);
+    srand(aNumberOfCallbacks);
+    for (int i = 0; i < aNumberOfCallbacks; ++i) {
+        // short for touch and tone, medium for display refresh and accu capacity, long for dimming timeouts
+        int tKind = aOnlyLongPeriods ? 9 : rand() % 10;
+        if (tKind < 4) {
+            sPeriod[i] = 1 + rand() % 20;
+        } else if (tKind < 8) {
+            sPeriod[i] = 100 + rand() % 2000;
+        } else {
+            sPeriod[i] = 10000 + rand() % 600000;
+        }
+    }
+
+    for (int tRun = 0; tRun < NUMBER_OF_RUNS * 2; ++tRun) {
+        sScheduler = tRun % 2;
+        sCallHash[sScheduler] = 0;
+        for (int i = 0; i < aNumberOfCallbacks; ++i) {
+            sCallCount[sScheduler][i] = 0;
+            if (sScheduler == SCHEDULER_LINEAR) {
+                registerLinearDelayCallback(sCallbacks[i], sPeriod[i]);
+            } else {
+                DelayCallbackWheel_add(sCallbacks[i], sPeriod[i]);
+            }
+        }
+        sMillis = 0;
+        uint64_t tSum = 0;
+        for (uint32_t i = 0; i < NUMBER_OF_TICKS; ++i) {
+            sMillis++;
+            uint64_t tStart = __rdtsc();
+            if (sScheduler == SCHEDULER_LINEAR) {
+                doLinearTick();
+            } else {
+                // like doOneSystic()
+                DelayCallbackWheel_tick();
+                if (DelayCallbackWheel_hasExpired()) {
+                    DelayCallbackWheel_runExpired();
+                }
+            }
+            sCycles[i] = __rdtsc() - tStart;
+            tSum += sCycles[i];
+        }
+        if (tAverage[sScheduler] > (double) tSum / NUMBER_OF_TICKS) {
+            tAverage[sScheduler] = (double) tSum / NUMBER_OF_TICKS;
+            std::sort(sCycles.begin(), sCycles.end());
+            tPercentile[sScheduler] = sCycles[NUMBER_OF_TICKS - NUMBER_OF_TICKS / 1000];
+        }
+        // stop all callbacks
+        for (int i = 0; i < aNumberOfCallbacks; ++i) {
+            if (sScheduler == SCHEDULER_LINEAR) {
+                changeLinearDelayCallback(sCallbacks[i], 0);
+            } else {
+                DelayCallbackWheel_change(sCallbacks[i], 0);
+            }
+        }
+    }
+
+    bool tIsSame = (sCallHash[SCHEDULER_LINEAR] == sCallHash[SCHEDULER_MODULE]);
+    uint64_t tCalls = 0;
+    for (int i = 0; i < aNumberOfCallbacks; ++i) {
+        tIsSame &= (sCallCount[SCHEDULER_LINEAR][i] == sCallCount[SCHEDULER_MODULE][i]);
+        tCalls += sCallCount[SCHEDULER_MODULE][i];
+    }
+    DelayCallbackWheelStatisticsTypeDef *tStatistics = DelayCallbackWheel_getStatistics();
+    printf("%-5s %4d | %7.0f %7lu | %7.0f %7lu | %10.3f %10.3f\n", aOnlyLongPeriods ? "long" : "mixed", aNumberOfCallbacks,
+            tAverage[SCHEDULER_LINEAR], (unsigned long) tPercentile[SCHEDULER_LINEAR], tAverage[SCHEDULER_MODULE],
+            (unsigned long) tPercentile[SCHEDULER_MODULE], (double) tCalls / NUMBER_OF_TICKS,
+            (double) tStatistics->EntriesCascaded / tStatistics->Ticks);
+    check(tIsSame, "callbacks of former table and " MODULE_NAME " differ");
+    check(tStatistics->EntriesUsed == 0, "entries not freed");
+    DelayCallbackWheel_resetStatistics();
+}
+
+static int sDroppedCallbackCount;
+static void droppedCallback(void) {
+    sDroppedCallbackCount++;
+}
+
+static void checkDroppedCall(void) {
+    DelayCallbackWheel_add(&droppedCallback, 1);
+    DelayCallbackWheel_tick();
+    check(DelayCallbackWheel_hasExpired(), "callback not expired");
+    DelayCallbackWheel_change(&droppedCallback, 0);
+    check(!DelayCallbackWheel_hasExpired(), "expired call not dropped by change");
+    DelayCallbackWheel_runExpired();
+    check(sDroppedCallbackCount == 0, "dropped callback called");
+    check(DelayCallbackWheel_getStatistics()->EntriesUsed == 0, "entry of dropped call not freed");
+}
+
+int main(void) {
+#if NUMBER_OF_CALLBACKS_MAX > FORMER_CALLBACK_ENTRIES_SIZE
+    static const int sNumbersOfCallbacks[] = { 8, FORMER_CALLBACK_ENTRIES_SIZE, 32, NUMBER_OF_CALLBACKS_MAX };
+#else
+    static const int sNumbersOfCallbacks[] = { 4, 8, FORMER_CALLBACK_ENTRIES_SIZE };
+#endif
+    CallbackTable<NUMBER_OF_CALLBACKS_MAX>::fill();
+    checkDroppedCall();
+    printf("TSC cycles per tick including callbacks, module uses its %s\n", MODULE_NAME);
+    printf("periods  n | former avg  p99.9 | module avg  p99.9 | calls/tick cascades/tick\n");
+    for (int tOnlyLongPeriods = 0; tOnlyLongPeriods < 2; ++tOnlyLongPeriods) {
+        for (unsigned int i = 0; i < sizeof(sNumbersOfCallbacks) / sizeof(sNumbersOfCallbacks[0]); ++i) {
+            simulate(sNumbersOfCallbacks[i], tOnlyLongPeriods);
+        }
+    }
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,234 @@
+/*
+ * @file ImageWriterBenchmark.c
+ *
+ * Host benchmark of the screenshot writer imageWriter.c on the SPI level card simulator mmc_sim.c.
+ * A frame buffer with a typical GUI screen is stored like storeScreenshot() did before the image writer,
+ * then as pipelined BMP and as run length encoded TGA. Reading a display line costs READ_LINE_MICROS simulated time.
+ * The time, the lines read while the card is busy and the file size are printed
+ * and both files are decoded and compared with the frame buffer.
+ * The run length encoder is checked with lines of special content against its documented worst case overhead.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o ImageWriterBenchmark extras/ImageWriterBenchmark.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c lib/fat_sd/imageWriter.c
+ * Usage: ImageWriterBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "imageWriter.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define DISPLAY_WIDTH       320
+#define DISPLAY_HEIGHT      240
+#define READ_LINE_MICROS    75      // reading of 320 pixel from the display controller
+#define FILE_BUFFER_SIZE    (IMAGE_BMP_DATA_OFFSET + (DISPLAY_WIDTH * DISPLAY_HEIGHT * 2) + 1024)
+
+static uint16_t sFrameBuffer[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+static uint16_t sDecoded[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+static uint8_t sFile[FILE_BUFFER_SIZE];
+static uint16_t getWord(const uint8_t *aBuffer) {
+    return aBuffer[0] | (aBuffer[1] << 8);
+}
+
+/*
+ * Background, 6 buttons, some text pixel and a chart line
+ */
+static void drawScreen(void) {
+    for (int y = 0; y < DISPLAY_HEIGHT; ++y) {
+        for (int x = 0; x < DISPLAY_WIDTH; ++x) {
+            sFrameBuffer[y][x] = 0x7FFF;
+        }
+    }
+    for (int tButton = 0; tButton < 6; ++tButton) {
+        for (int y = 10 + tButton * 38; y < 40 + tButton * 38; ++y) {
+            for (int x = 10; x < 120; ++x) {
+                sFrameBuffer[y][x] = 0x001F + tButton * 0x400;
+            }
+        }
+    }
+    srand(3);
+    for (int i = 0; i < 1500; ++i) {
+        sFrameBuffer[rand() % 100][130 + rand() % 180] = 0;
+    }
+    for (int x = 0; x < DISPLAY_WIDTH; ++x) {
+        sFrameBuffer[160 + ((x / 8) % 20)][x] = 0x7C00;
+    }
+}
+
+static void readLine(uint16_t *aLineBuffer, uint16_t aLineNumber) {
+    memcpy(aLineBuffer, sFrameBuffer[aLineNumber], sizeof(sFrameBuffer[0]));
+    HostPlatform_spendMicros(READ_LINE_MICROS);
+}
+
+static UINT readFile(const char *aFileName) {
+    FIL tFile;
+    UINT tCount = 0;
+    if (f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ) == FR_OK) {
+        f_read(&tFile, sFile, sizeof(sFile), &tCount);
+        f_close(&tFile);
+    }
+    return tCount;
+}
+
+/*
+ * 54 bytes BMP header, then blocks of 4 display lines, read and written alternately
+ */
+static void storeScreenshotUnpipelined(void) {
+    FIL tFile;
+    UINT tCount;
+    static uint16_t tLines[4 * DISPLAY_WIDTH];
+    uint32_t tStartMicros = micros();
+    check(f_open(&tFile, "old.bmp", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for unpipelined screenshot");
+    memset(tLines, 0, 54);
+    f_write(&tFile, tLines, 54, &tCount);
+    for (int tLine = DISPLAY_HEIGHT - 1; tLine >= 0;) {
+        for (int i = 0; i < 4; ++i) {
+            readLine(&tLines[i * DISPLAY_WIDTH], tLine--);
+        }
+        f_write(&tFile, tLines, sizeof(tLines), &tCount);
+    }
+    check(f_close(&tFile) == FR_OK, "close of unpipelined screenshot");
+    printf("Unpipelined BMP: %lu us\n", (unsigned long) (micros() - tStartMicros));
+    HostPlatform_printCardStatistics("unpipelined BMP");
+}
+
+static bool decodeBMP(UINT aLength) {
+    UINT tOffset = getWord(&sFile[10]);
+    if (sFile[0] != 'B' || sFile[1] != 'M' || getWord(&sFile[18]) != DISPLAY_WIDTH || getWord(&sFile[22]) != DISPLAY_HEIGHT
+            || sFile[28] != 16 || aLength != tOffset + sizeof(sDecoded)) {
+        return false;
+    }
+    for (int tRow = 0; tRow < DISPLAY_HEIGHT; ++tRow) {
+        for (int x = 0; x < DISPLAY_WIDTH; ++x) {
+            sDecoded[DISPLAY_HEIGHT - 1 - tRow][x] = getWord(&sFile[tOffset + (tRow * DISPLAY_WIDTH + x) * 2]);
+        }
+    }
+    return true;
+}
+
+/*
+ * Packets do not cross lines
+ */
+static bool decodeTGALine(const uint8_t **aInput, const uint8_t *aEnd, uint16_t *aLine, uint16_t aWidth) {
+    const uint8_t *tInput = *aInput;
+    uint16_t x = 0;
+    while (x < aWidth) {
+        if (tInput >= aEnd) {
+            return false;
+        }
+        uint8_t tPacketHeader = *tInput++;
+        uint16_t tCount = (tPacketHeader & 0x7F) + 1;
+        if (x + tCount > aWidth) {
+            return false;
+        }
+        for (uint16_t i = 0; i < tCount; ++i) {
+            aLine[x++] = getWord(tInput);
+            if (!(tPacketHeader & 0x80)) {
+                tInput += 2;
+            }
+        }
+        if (tPacketHeader & 0x80) {
+            tInput += 2;
+        }
+    }
+    *aInput = tInput;
+    return true;
+}
+
+static bool decodeTGA(UINT aLength) {
+    if (sFile[2] != 10 || getWord(&sFile[12]) != DISPLAY_WIDTH || getWord(&sFile[14]) != DISPLAY_HEIGHT || sFile[16] != 16) {
+        return false;
+    }
+    const uint8_t *tInput = &sFile[IMAGE_TGA_HEADER_SIZE + sFile[0]];
+    for (int tRow = 0; tRow < DISPLAY_HEIGHT; ++tRow) {
+        if (!decodeTGALine(&tInput, &sFile[aLength], sDecoded[DISPLAY_HEIGHT - 1 - tRow], DISPLAY_WIDTH)) {
+            return false;
+        }
+    }
+    return tInput == &sFile[aLength];
+}
+
+static void storeScreenshot(const char *aFileName, uint8_t aFormat) {
+    FRESULT tResult = ImageWriter_store(aFileName, aFormat, DISPLAY_WIDTH, DISPLAY_HEIGHT, &readLine);
+    check(tResult == FR_OK, "ImageWriter_store");
+    const ImageWriterStatisticsTypeDef *tStatistics = ImageWriter_getStatistics();
+    printf("%s: %lu us, read %lu us, encode %lu us, write %lu us, %u lines read while writing, %lu bytes\n", aFileName,
+            (unsigned long) tStatistics->TotalMicros, (unsigned long) tStatistics->ReadMicros,
+            (unsigned long) tStatistics->EncodeMicros, (unsigned long) tStatistics->WriteMicros, tStatistics->LinesReadWhileWriting,
+            (unsigned long) tStatistics->FileSize);
+    check(tStatistics->IsPipelined, "image writer is not pipelined");
+    HostPlatform_printCardStatistics(aFileName);
+
+    UINT tLength = readFile(aFileName);
+    MMCSim_resetStatistics(); // reading for the check is not part of the benchmark
+    check(tLength == tStatistics->FileSize, "file size");
+    memset(sDecoded, 0xAA, sizeof(sDecoded));
+    bool tIsDecoded = (aFormat == IMAGE_FORMAT_BMP) ? decodeBMP(tLength) : decodeTGA(tLength);
+    check(tIsDecoded, "decoding of image file");
+    check(memcmp(sDecoded, sFrameBuffer, sizeof(sFrameBuffer)) == 0, "decoded image differs from frame buffer");
+}
+
+/*
+ * Encodes one line and checks the result and the worst case overhead, which is the gap for in place encoding
+ */
+static void checkLineRLE(const uint16_t *aPixels, uint16_t aWidth, const char *aMessage) {
+    static uint8_t tOutput[DISPLAY_WIDTH * 2 + 64];
+    static uint16_t tLine[DISPLAY_WIDTH];
+    UINT tLength = ImageWriter_encodeLineRLE(tOutput, aPixels, aWidth);
+    const uint8_t *tInput = tOutput;
+    check(tLength <= aWidth * 2U + 3 + (aWidth / IMAGE_TGA_MAX_PACKET_PIXELS), aMessage);
+    check(decodeTGALine(&tInput, &tOutput[tLength], tLine, aWidth) && tInput == &tOutput[tLength], aMessage);
+    check(memcmp(tLine, aPixels, aWidth * 2) == 0, aMessage);
+}
+
+static void checkEncoderRLE(void) {
+    uint16_t tPixels[DISPLAY_WIDTH];
+    for (int i = 0; i < DISPLAY_WIDTH; ++i) {
+        tPixels[i] = 0x1234;
+    }
+    checkLineRLE(tPixels, DISPLAY_WIDTH, "RLE of equal pixel");
+    for (int i = 0; i < DISPLAY_WIDTH; ++i) {
+        tPixels[i] = i;
+    }
+    checkLineRLE(tPixels, DISPLAY_WIDTH, "RLE of different pixel");
+    checkLineRLE(tPixels, 1, "RLE of one pixel");
+    tPixels[DISPLAY_WIDTH - 1] = tPixels[DISPLAY_WIDTH - 2];
+    checkLineRLE(tPixels, DISPLAY_WIDTH, "RLE of run at end of line");
+    for (int i = 0; i < DISPLAY_WIDTH; ++i) {
+        tPixels[i] = (i % 3 == 0) ? 0 : i;
+    }
+    tPixels[128] = tPixels[129];
+    checkLineRLE(tPixels, DISPLAY_WIDTH, "RLE of runs of 2");
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+    drawScreen();
+
+    storeScreenshotUnpipelined();
+    storeScreenshot("screen.bmp", IMAGE_FORMAT_BMP);
+    storeScreenshot("screen.tga", IMAGE_FORMAT_TGA_RLE);
+    checkEncoderRLE();
+    check(ImageWriter_store("odd.bmp", IMAGE_FORMAT_BMP, DISPLAY_WIDTH - 1, DISPLAY_HEIGHT, &readLine) == FR_INVALID_PARAMETER,
+            "BMP with odd width must be rejected");
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
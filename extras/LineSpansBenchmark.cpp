@@ -0,0 +1,265 @@
+/*
+ * @file LineSpansBenchmark.cpp
+ *
+ * Host benchmark of the span line drawing drawLineSpans() and drawPolylineSpans() of lib/BlueDisplay/LocalGUI/ThickLine.hpp
+ * against drawLineOverlap(..., LINE_OVERLAP_NONE, ...), which sets the cursor for each pixel,
+ * on the SSD1289 framebuffer emulator lib/BlueDisplay/LocalDisplay/LocalDisplayEmulator.hpp.
+ * The WR cycles of the display bus are printed for each line length and slope,
+ * for a chart trace drawn as polyline and for random lines.
+ *
+ * Checks:
+ * - Each line of each length and slope in all 4 directions has the same pixel as drawLineOverlap().
+ * - A 300 point chart trace drawn by drawPolylineSpans() has the same pixel as its segments drawn by drawLineOverlap().
+ * - 3000 random lines, also with ends outside the display, have the same pixel.
+ *
+ * Build from the repository root:
+ * g++ -O2 -DSTM32F30X -DLOCAL_DISPLAY_EMULATOR -DSUPPORT_LOCAL_DISPLAY -DDISABLE_REMOTE_DISPLAY -DFONT_8X12
+ *     -Iextras/host -Ilib/fat_sd -Ilib/BlueDisplay -Ilib/BlueDisplay/LocalDisplay -Ilib/BlueDisplay/LocalGUI
+ *     -o LineSpansBenchmark extras/LineSpansBenchmark.cpp
+ * Usage: LineSpansBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdio.h>  // for sprintf of SSD1289.hpp
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+extern int sLockCount;
+
+#define USE_SSD1289
+#include "LocalDisplay/fonts.hpp"
+#include "LocalDisplay/LocalDisplayInterface.hpp"
+#include "LocalDisplay/LocalDisplayEmulator.hpp"
+#include "LocalGUI/ThickLine.hpp"
+#include "GUIHelper.hpp"
+
+/*
+ * Target functions used by the driver, which have no effect on the host
+ */
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+int sLockCount;
+bool isLocalDisplayAvailable;
+
+uint32_t millis(void) {
+    return 0;
+}
+uint32_t micros(void) {
+    return 0;
+}
+void delay(int32_t aTimeMillis) {
+    (void) aTimeMillis;
+}
+void delayNanos(int32_t aTimeNanos) {
+    (void) aTimeNanos;
+}
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+uint32_t getLR14(void) {
+    return 0;
+}
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    printf("%s:%lu %s %d\n", aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+    (void) aLinkRegister;
+}
+void SSD1289_IO_initalize(void) {
+}
+void PWM_BL_initalize(void) {
+}
+void PWM_BL_setOnRatio(uint32_t power) {
+    (void) power;
+}
+bool MICROSD_isCardInserted(void) {
+    return false;
+}
+int RTC_getDateStringForFile(char *aStringBuffer) {
+    aStringBuffer[0] = '\0';
+    return 0;
+}
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        void (*aReadLineFunction)(uint16_t*, uint16_t)) {
+    (void) aFileName;
+    (void) aFormat;
+    (void) aWidth;
+    (void) aHeight;
+    (void) aReadLineFunction;
+    return FR_NOT_READY;
+}
+void LocalTouchButton::playFeedbackTone(bool aPlayErrorTone) {
+    (void) aPlayErrorTone;
+}
+
+#define NUMBER_OF_RANDOM_LINES  3000
+#define NUMBER_OF_TRACE_POINTS  300
+
+static uint16_t sReferenceFramebuffer[LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT];
+
+/*
+ * Slope as minor delta / major delta, the major axis is x for the first ones
+ */
+struct SlopeStruct {
+    const char *Name;
+    int16_t DeltaX;
+    int16_t DeltaY;
+};
+static const SlopeStruct sSlopes[] = { { "horizontal", 1, 0 }, { "1/8", 8, 1 }, { "1/4", 4, 1 }, { "1/2", 2, 1 }, { "3/4", 4, 3 },
+        { "45 degree", 1, 1 }, { "2", 1, 2 }, { "4", 1, 4 }, { "vertical", 0, 1 } };
+static const uint16_t sLengths[] = { 8, 32, 100, 239 };
+
+static void copyFramebuffer(void) {
+    memcpy(sReferenceFramebuffer, LocalDisplayEmulator_getFramebuffer(), sizeof(sReferenceFramebuffer));
+}
+
+/*
+ * Draws the line with both functions on a cleared display
+ * @param aSpansWriteCycles returns the WR cycles of drawLineSpans()
+ * @return WR cycles of drawLineOverlap()
+ */
+static uint32_t compareLine(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, uint16_t aYEnd, uint32_t *aSpansWriteCycles,
+        uint32_t *aDifferentPixels) {
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    drawLineOverlap(aXStart, aYStart, aXEnd, aYEnd, LINE_OVERLAP_NONE, COLOR16_BLUE);
+    uint32_t tOverlapWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    copyFramebuffer();
+
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    drawLineSpans(aXStart, aYStart, aXEnd, aYEnd, false, COLOR16_BLUE);
+    *aSpansWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    *aDifferentPixels += LocalDisplayEmulator_countDifferentPixels(sReferenceFramebuffer);
+    return tOverlapWriteCycles;
+}
+
+/*
+ * The line starts at the upper left corner and has aLength pixel in its major direction.
+ * It is also drawn in the 3 other directions, mirrored at the display center.
+ */
+static void compareSlopes(void) {
+    uint32_t tDifferentPixels = 0;
+    printf("WR cycles of drawLineOverlap -> drawLineSpans for length");
+    for (unsigned int j = 0; j < sizeof(sLengths) / sizeof(sLengths[0]); ++j) {
+        printf(" %13u", sLengths[j]);
+    }
+    printf("\n");
+    for (unsigned int i = 0; i < sizeof(sSlopes) / sizeof(sSlopes[0]); ++i) {
+        printf("%-10s", sSlopes[i].Name);
+        for (unsigned int j = 0; j < sizeof(sLengths) / sizeof(sLengths[0]); ++j) {
+            uint16_t tMajorDelta = sLengths[j] - 1;
+            uint16_t tXEnd, tYEnd;
+            if (sSlopes[i].DeltaX >= sSlopes[i].DeltaY) {
+                tXEnd = tMajorDelta;
+                tYEnd = (tMajorDelta * sSlopes[i].DeltaY) / sSlopes[i].DeltaX;
+            } else {
+                tYEnd = tMajorDelta;
+                tXEnd = (tMajorDelta * sSlopes[i].DeltaX) / sSlopes[i].DeltaY;
+            }
+            uint32_t tSpansWriteCycles;
+            uint32_t tOverlapWriteCycles = compareLine(0, 0, tXEnd, tYEnd, &tSpansWriteCycles, &tDifferentPixels);
+            printf(" %6lu -> %5lu", (unsigned long) tOverlapWriteCycles, (unsigned long) tSpansWriteCycles);
+            // reverse and mirrored directions
+            uint32_t tUnused;
+            compareLine(tXEnd, tYEnd, 0, 0, &tUnused, &tDifferentPixels);
+            compareLine(LOCAL_DISPLAY_WIDTH - 1, 0, LOCAL_DISPLAY_WIDTH - 1 - tXEnd, tYEnd, &tUnused, &tDifferentPixels);
+            compareLine(0, LOCAL_DISPLAY_HEIGHT - 1, tXEnd, LOCAL_DISPLAY_HEIGHT - 1 - tYEnd, &tUnused, &tDifferentPixels);
+        }
+        printf("\n");
+    }
+    printf("%lu pixel differ\n", (unsigned long) tDifferentPixels);
+    check(tDifferentPixels == 0, "line spans differ from drawLineOverlap()");
+}
+
+/*
+ * Chart trace like the DSO or AccuCapacity chart draw it, one point per column
+ */
+static void compareTrace(void) {
+    static XYPosition sPoints[NUMBER_OF_TRACE_POINTS];
+    int tY = LOCAL_DISPLAY_HEIGHT / 2;
+    for (int i = 0; i < NUMBER_OF_TRACE_POINTS; ++i) {
+        tY += (rand() % 41) - 20;
+        if (tY < 0) {
+            tY = 0;
+        } else if (tY >= LOCAL_DISPLAY_HEIGHT) {
+            tY = LOCAL_DISPLAY_HEIGHT - 1;
+        }
+        sPoints[i].PositionX = 10 + i;
+        sPoints[i].PositionY = tY;
+    }
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    for (int i = 1; i < NUMBER_OF_TRACE_POINTS; ++i) {
+        drawLineOverlap(sPoints[i - 1].PositionX, sPoints[i - 1].PositionY, sPoints[i].PositionX, sPoints[i].PositionY,
+                LINE_OVERLAP_NONE, COLOR16_RED);
+    }
+    uint32_t tOverlapWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    copyFramebuffer();
+
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    drawPolylineSpans(sPoints, NUMBER_OF_TRACE_POINTS, COLOR16_RED);
+    uint32_t tSpansWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    uint32_t tDifferentPixels = LocalDisplayEmulator_countDifferentPixels(sReferenceFramebuffer);
+    printf("%d point chart trace: %lu -> %lu WR cycles, %lu pixel differ\n", NUMBER_OF_TRACE_POINTS,
+            (unsigned long) tOverlapWriteCycles, (unsigned long) tSpansWriteCycles, (unsigned long) tDifferentPixels);
+    check(tDifferentPixels == 0, "polyline spans differ from drawLineOverlap()");
+}
+
+/*
+ * Lines of random colors drawn over each other, ends up to 20 pixel outside the display are clipped
+ */
+static void drawRandomLines(bool aUseSpans) {
+    srand(3);
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    for (int i = 0; i < NUMBER_OF_RANDOM_LINES; ++i) {
+        uint16_t tXStart = rand() % (LOCAL_DISPLAY_WIDTH + 20);
+        uint16_t tYStart = rand() % (LOCAL_DISPLAY_HEIGHT + 20);
+        uint16_t tXEnd = rand() % (LOCAL_DISPLAY_WIDTH + 20);
+        uint16_t tYEnd = rand() % (LOCAL_DISPLAY_HEIGHT + 20);
+        color16_t tColor = rand();
+        if (aUseSpans) {
+            drawLineSpans(tXStart, tYStart, tXEnd, tYEnd, false, tColor);
+        } else {
+            drawLineOverlap(tXStart, tYStart, tXEnd, tYEnd, LINE_OVERLAP_NONE, tColor);
+        }
+    }
+}
+
+static void compareRandomLines(void) {
+    drawRandomLines(false);
+    uint32_t tOverlapWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    copyFramebuffer();
+    drawRandomLines(true);
+    uint32_t tSpansWriteCycles = LocalDisplayEmulator_getStatistics()->WriteCycles;
+    uint32_t tDifferentPixels = LocalDisplayEmulator_countDifferentPixels(sReferenceFramebuffer);
+    printf("%d random lines: %lu -> %lu WR cycles, %lu pixel differ\n", NUMBER_OF_RANDOM_LINES,
+            (unsigned long) tOverlapWriteCycles, (unsigned long) tSpansWriteCycles, (unsigned long) tDifferentPixels);
+    check(tDifferentPixels == 0, "random line spans differ from drawLineOverlap()");
+}
+
+int main(void) {
+    LocalDisplayEmulator_reset();
+    LocalDisplay.init();
+    check(isLocalDisplayAvailable, "SSD1289 device code");
+    srand(1);
+
+    compareSlopes();
+    compareTrace();
+    compareRandomLines();
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,383 @@
+/*
+ * @file LocalDisplayCompositorTest.cpp
+ *
+ * Host test and benchmark of the tile compositor lib/BlueDisplay/LocalDisplay/LocalDisplayCompositor.hpp
+ * on the framebuffer emulator LocalDisplayEmulator.hpp.
+ * Each scene is drawn once directly by the SSD1289 driver and once by the compositor on the same background.
+ * The framebuffers must be identical. For the benchmark scenes the bus statistics of both ways are printed.
+ * Scenes:
+ * - 200 random lists of fillRect, drawLine, drawPolyline and drawText, partially outside the display.
+ *   The long lists overflow the operation list and check the early flushes.
+ * - DSO frame with grid, trace as 319 single lines, trigger line and 2 info texts.
+ * - The same DSO frame with the trace as one polyline.
+ * - UI page with a caption and 12 buttons with border, background and text.
+ * Both full frames cover all tiles completely, so the compositor writes each pixel once with one window per tile
+ * and requires the same bus time for both. The printed RAM size is larger than on the target, since host pointers have 8 byte.
+ *
+ * Build from the repository root:
+ * g++ -O2 -DSTM32F30X -DLOCAL_DISPLAY_EMULATOR -DSUPPORT_LOCAL_DISPLAY -DDISABLE_REMOTE_DISPLAY -DFONT_8X12
+ *     -Iextras/host -Ilib/fat_sd -Ilib/BlueDisplay -Ilib/BlueDisplay/LocalDisplay -Ilib/BlueDisplay/LocalGUI
+ *     -o LocalDisplayCompositorTest extras/LocalDisplayCompositorTest.cpp
+ * Usage: LocalDisplayCompositorTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <math.h>
+#include <stdio.h>  // for sprintf of SSD1289.hpp
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+extern int sLockCount;
+
+#define USE_SSD1289
+#include "LocalDisplay/fonts.hpp"
+#include "LocalDisplay/LocalDisplayInterface.hpp"
+#include "LocalDisplay/LocalDisplayEmulator.hpp"
+#include "LocalDisplay/LocalDisplayCompositor.hpp"
+#include "LocalGUI/ThickLine.hpp"
+#include "GUIHelper.hpp"
+
+/*
+ * Target functions used by the driver, which have no effect on the host
+ */
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+int sLockCount;
+bool isLocalDisplayAvailable;
+
+uint32_t millis(void) {
+    return 0;
+}
+uint32_t micros(void) {
+    return 0;
+}
+void delay(int32_t aTimeMillis) {
+    (void) aTimeMillis;
+}
+void delayNanos(int32_t aTimeNanos) {
+    (void) aTimeNanos;
+}
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+uint32_t getLR14(void) {
+    return 0;
+}
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    printf("%s:%lu %s %d\n", aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+    (void) aLinkRegister;
+}
+void SSD1289_IO_initalize(void) {
+}
+void PWM_BL_initalize(void) {
+}
+void PWM_BL_setOnRatio(uint32_t power) {
+    (void) power;
+}
+bool MICROSD_isCardInserted(void) {
+    return false;
+}
+int RTC_getDateStringForFile(char *aStringBuffer) {
+    aStringBuffer[0] = '\0';
+    return 0;
+}
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        void (*aReadLineFunction)(uint16_t*, uint16_t)) {
+    (void) aFileName;
+    (void) aFormat;
+    (void) aWidth;
+    (void) aHeight;
+    (void) aReadLineFunction;
+    return FR_NOT_READY;
+}
+void LocalTouchButton::playFeedbackTone(bool aPlayErrorTone) {
+    (void) aPlayErrorTone;
+}
+
+#define OPERATION_FILL      0
+#define OPERATION_LINE      1
+#define OPERATION_TEXT      2
+#define OPERATION_POLYLINE  3
+
+#define MAX_OPERATIONS          600
+#define MAX_POLYLINE_POINTS     8
+#define RANDOM_SCENES           200
+#define RANDOM_COORDINATE_X     (LOCAL_DISPLAY_WIDTH + 20) // to check clipping
+#define RANDOM_COORDINATE_Y     (LOCAL_DISPLAY_HEIGHT + 10)
+#define RANDOM_BACKGROUND_COLOR 0x5555
+
+struct OperationStruct {
+    uint8_t Type;
+    uint16_t X0;
+    uint16_t Y0;
+    uint16_t X1;
+    uint16_t Y1;
+    color16_t Color;
+    color16_t BackgroundColor;
+    const char *Text;
+    uint8_t TextSize;
+    const XYPosition *Points;
+    uint16_t NumberOfPoints;
+};
+
+static OperationStruct sOperations[MAX_OPERATIONS];
+static uint16_t sNumberOfOperations;
+static char sRandomText[MAX_OPERATIONS][20];
+static XYPosition sRandomPoints[MAX_OPERATIONS][MAX_POLYLINE_POINTS];
+static XYPosition sTrace[LOCAL_DISPLAY_WIDTH];
+static uint16_t sReferenceFramebuffer[LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT];
+
+static void addOperation(uint8_t aType, uint16_t aX0, uint16_t aY0, uint16_t aX1, uint16_t aY1, color16_t aColor) {
+    OperationStruct *tOperation = &sOperations[sNumberOfOperations++];
+    memset(tOperation, 0, sizeof(OperationStruct));
+    tOperation->Type = aType;
+    tOperation->X0 = aX0;
+    tOperation->Y0 = aY0;
+    tOperation->X1 = aX1;
+    tOperation->Y1 = aY1;
+    tOperation->Color = aColor;
+}
+
+static void addText(uint16_t aX, uint16_t aY, const char *aText, uint8_t aTextSize, color16_t aColor, color16_t aBackgroundColor) {
+    addOperation(OPERATION_TEXT, aX, aY, 0, 0, aColor);
+    sOperations[sNumberOfOperations - 1].Text = aText;
+    sOperations[sNumberOfOperations - 1].TextSize = aTextSize;
+    sOperations[sNumberOfOperations - 1].BackgroundColor = aBackgroundColor;
+}
+
+static void addPolyline(const XYPosition *aPoints, uint16_t aNumberOfPoints, color16_t aColor) {
+    addOperation(OPERATION_POLYLINE, 0, 0, 0, 0, aColor);
+    sOperations[sNumberOfOperations - 1].Points = aPoints;
+    sOperations[sNumberOfOperations - 1].NumberOfPoints = aNumberOfPoints;
+}
+
+static void drawOperations(bool aUseCompositor) {
+    if (aUseCompositor) {
+        LocalDisplayCompositor_begin();
+    }
+    for (unsigned int i = 0; i < sNumberOfOperations; ++i) {
+        OperationStruct *tOperation = &sOperations[i];
+        switch (tOperation->Type) {
+        case OPERATION_FILL:
+            if (aUseCompositor) {
+                LocalDisplayCompositor_fillRect(tOperation->X0, tOperation->Y0, tOperation->X1, tOperation->Y1, tOperation->Color);
+            } else {
+                LocalDisplay.fillRect(tOperation->X0, tOperation->Y0, tOperation->X1, tOperation->Y1, tOperation->Color);
+            }
+            break;
+        case OPERATION_LINE:
+            if (aUseCompositor) {
+                LocalDisplayCompositor_drawLine(tOperation->X0, tOperation->Y0, tOperation->X1, tOperation->Y1, tOperation->Color);
+            } else {
+                LocalDisplay.drawLine(tOperation->X0, tOperation->Y0, tOperation->X1, tOperation->Y1, tOperation->Color);
+            }
+            break;
+        case OPERATION_TEXT:
+            if (aUseCompositor) {
+                LocalDisplayCompositor_drawText(tOperation->X0, tOperation->Y0, tOperation->Text, tOperation->TextSize,
+                        tOperation->Color, tOperation->BackgroundColor);
+            } else {
+                LocalDisplay.drawText(tOperation->X0, tOperation->Y0, tOperation->Text, tOperation->TextSize, tOperation->Color,
+                        tOperation->BackgroundColor);
+            }
+            break;
+        default:
+            if (aUseCompositor) {
+                LocalDisplayCompositor_drawPolyline(tOperation->Points, tOperation->NumberOfPoints, tOperation->Color);
+            } else {
+                LocalDisplay.drawPolyline(tOperation->Points, tOperation->NumberOfPoints, tOperation->Color);
+            }
+            break;
+        }
+    }
+    if (aUseCompositor) {
+        LocalDisplayCompositor_end();
+    }
+}
+
+/*
+ * Draws the operations directly and by the compositor on the same background
+ * @return the number of pixel which differ
+ */
+static uint32_t compareWithDirectDrawing(color16_t aBackgroundColor) {
+    LocalDisplay.clearDisplay(aBackgroundColor);
+    drawOperations(false);
+    memcpy(sReferenceFramebuffer, LocalDisplayEmulator_getFramebuffer(), sizeof(sReferenceFramebuffer));
+    LocalDisplay.clearDisplay(aBackgroundColor);
+    drawOperations(true);
+    return LocalDisplayEmulator_countDifferentPixels(sReferenceFramebuffer);
+}
+
+static void createRandomScene(uint16_t aNumberOfOperations) {
+    sNumberOfOperations = 0;
+    for (unsigned int i = 0; i < aNumberOfOperations; ++i) {
+        uint8_t tType = rand() % 4;
+        uint16_t tX0 = rand() % RANDOM_COORDINATE_X;
+        uint16_t tY0 = rand() % RANDOM_COORDINATE_Y;
+        uint16_t tX1 = rand() % RANDOM_COORDINATE_X;
+        uint16_t tY1 = rand() % RANDOM_COORDINATE_Y;
+        if (rand() % 2) {
+            // small rectangles and short lines like the ones of chart and buttons
+            tX1 = tX0 + (rand() % ((tType == OPERATION_FILL) ? 30 : 9));
+            tY1 = (tType == OPERATION_FILL) ? tY0 + (rand() % 30) : tY0 + (rand() % 9) - 4;
+        }
+        color16_t tColor = rand();
+        if (tType == OPERATION_TEXT) {
+            uint8_t tLength = rand() % (sizeof(sRandomText[0]) - 1);
+            for (unsigned int j = 0; j < tLength; ++j) {
+                sRandomText[i][j] = 1 + (rand() % 130); // includes characters outside of the font
+            }
+            sRandomText[i][tLength] = '\0';
+            uint8_t tScale = 1 + (rand() % 3);
+            addText(tX0, tY0, sRandomText[i], (tScale == 1) ? TEXT_SIZE_11 : tScale * 12, tColor, rand());
+        } else if (tType == OPERATION_POLYLINE) {
+            uint16_t tNumberOfPoints = 1 + (rand() % MAX_POLYLINE_POINTS);
+            for (unsigned int j = 0; j < tNumberOfPoints; ++j) {
+                sRandomPoints[i][j].PositionX = rand() % RANDOM_COORDINATE_X;
+                sRandomPoints[i][j].PositionY = rand() % RANDOM_COORDINATE_Y;
+            }
+            addPolyline(sRandomPoints[i], tNumberOfPoints, tColor);
+        } else {
+            addOperation(tType, tX0, tY0, tX1, tY1, tColor);
+        }
+    }
+}
+
+static void checkRandomScenes(void) {
+    uint32_t tDifferentPixels = 0;
+    srand(7);
+    for (int i = 0; i < RANDOM_SCENES; ++i) {
+        createRandomScene(1 + (rand() % ((i < RANDOM_SCENES / 2) ? 40 : MAX_OPERATIONS)));
+        uint32_t tDifferentPixelsOfScene = compareWithDirectDrawing(RANDOM_BACKGROUND_COLOR);
+        if (tDifferentPixelsOfScene != 0) {
+            printf("Random scene %d with %u operations: %lu pixel differ\n", i, sNumberOfOperations,
+                    (unsigned long) tDifferentPixelsOfScene);
+        }
+        tDifferentPixels += tDifferentPixelsOfScene;
+    }
+    printf("%d random scenes, %lu pixel differ\n", RANDOM_SCENES, (unsigned long) tDifferentPixels);
+    check(tDifferentPixels == 0, "random scenes");
+}
+
+/*
+ * Background, grid and trigger line of the DSO page
+ */
+static void addDSOGrid(void) {
+    addOperation(OPERATION_FILL, 0, 0, LOCAL_DISPLAY_WIDTH - 1, LOCAL_DISPLAY_HEIGHT - 1, COLOR16_WHITE);
+    for (int x = 0; x < LOCAL_DISPLAY_WIDTH; x += 32) {
+        addOperation(OPERATION_LINE, x, 0, x, LOCAL_DISPLAY_HEIGHT - 1, 0x8410);
+    }
+    for (int y = 0; y < LOCAL_DISPLAY_HEIGHT; y += 24) {
+        addOperation(OPERATION_LINE, 0, y, LOCAL_DISPLAY_WIDTH - 1, y, 0x8410);
+    }
+}
+
+static void addDSOTexts(void) {
+    addOperation(OPERATION_LINE, 0, 100, LOCAL_DISPLAY_WIDTH - 1, 100, COLOR16_RED);
+    addText(0, 0, "2.44V  3.1kHz  200us/div  Trig", TEXT_SIZE_11, COLOR16_BLACK, COLOR16_WHITE);
+    addText(0, 228, "Ch1 DC 0.5V/div  Offset 0.00V", TEXT_SIZE_11, COLOR16_BLACK, COLOR16_WHITE);
+}
+
+static void createDSOFrameWithLines(void) {
+    sNumberOfOperations = 0;
+    addDSOGrid();
+    for (int x = 1; x < LOCAL_DISPLAY_WIDTH; x++) {
+        addOperation(OPERATION_LINE, sTrace[x - 1].PositionX, sTrace[x - 1].PositionY, sTrace[x].PositionX, sTrace[x].PositionY,
+                COLOR16_BLUE);
+    }
+    addDSOTexts();
+}
+
+static void createDSOFrameWithPolyline(void) {
+    sNumberOfOperations = 0;
+    addDSOGrid();
+    addPolyline(sTrace, LOCAL_DISPLAY_WIDTH, COLOR16_BLUE);
+    addDSOTexts();
+}
+
+static void createButtonPage(void) {
+    sNumberOfOperations = 0;
+    addOperation(OPERATION_FILL, 0, 0, LOCAL_DISPLAY_WIDTH - 1, LOCAL_DISPLAY_HEIGHT - 1, COLOR16_WHITE);
+    addOperation(OPERATION_FILL, 0, 0, LOCAL_DISPLAY_WIDTH - 1, 30, 0x0010);
+    addText(4, 4, "Settings", TEXT_SIZE_22, COLOR16_WHITE, 0x0010);
+    for (int tRow = 0; tRow < 3; tRow++) {
+        for (int tColumn = 0; tColumn < 4; tColumn++) {
+            uint16_t tX = 8 + tColumn * 78;
+            uint16_t tY = 40 + tRow * 64;
+            addOperation(OPERATION_FILL, tX, tY, tX + 70, tY + 56, COLOR16_GREEN);
+            addOperation(OPERATION_FILL, tX + 2, tY + 2, tX + 68, tY + 54, 0xC618);
+            addText(tX + 6, tY + 22, "Btn", TEXT_SIZE_22, COLOR16_BLACK, 0xC618);
+        }
+    }
+}
+
+/*
+ * Prints the bus statistics of direct drawing and of the compositor and checks the framebuffers
+ * @param aMustBeFaster the compositor must require less bus time than direct drawing
+ */
+static void measureScene(const char *aName, bool aMustBeFaster) {
+    char tBuffer[400];
+    char tName[80];
+    LocalDisplay.clearDisplay(COLOR16_BLACK);
+    LocalDisplayEmulator_resetStatistics();
+    drawOperations(false);
+    uint32_t tDirectNanos = LocalDisplayEmulator_getBusNanos();
+    snprintf(tName, sizeof(tName), "%s direct", aName);
+    LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), tName);
+    fputs(tBuffer, stdout);
+    memcpy(sReferenceFramebuffer, LocalDisplayEmulator_getFramebuffer(), sizeof(sReferenceFramebuffer));
+
+    LocalDisplay.clearDisplay(COLOR16_BLACK);
+    LocalDisplayEmulator_resetStatistics();
+    LocalDisplayCompositor_resetStatistics();
+    drawOperations(true);
+    uint32_t tCompositorNanos = LocalDisplayEmulator_getBusNanos();
+    snprintf(tName, sizeof(tName), "%s compositor", aName);
+    LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), tName);
+    fputs(tBuffer, stdout);
+    LocalDisplayCompositor_printStatistics(tBuffer, sizeof(tBuffer));
+    fputs(tBuffer, stdout);
+    printf("%s with %u operations: %lu us -> %lu us bus time\n\n", aName, sNumberOfOperations,
+            (unsigned long) (tDirectNanos / 1000), (unsigned long) (tCompositorNanos / 1000));
+
+    check(LocalDisplayEmulator_countDifferentPixels(sReferenceFramebuffer) == 0, aName);
+    if (aMustBeFaster) {
+        check(tCompositorNanos < tDirectNanos, aName);
+    }
+}
+
+int main(void) {
+    LocalDisplayEmulator_reset();
+    LocalDisplay.init();
+    printf("Compositor RAM %u byte\n", (unsigned int) LocalDisplayCompositor_getRAMSize());
+
+    checkRandomScenes();
+
+    srand(11);
+    for (int x = 0; x < LOCAL_DISPLAY_WIDTH; x++) {
+        sTrace[x].PositionX = x;
+        sTrace[x].PositionY = 120 + (int) (80 * sin(x / 20.0)) + (rand() % 5);
+    }
+    createDSOFrameWithLines();
+    // the operation list overflows, so no gain is expected
+    measureScene("DSO frame with trace lines", false);
+    createDSOFrameWithPolyline();
+    measureScene("DSO frame with trace polyline", true);
+    createButtonPage();
+    measureScene("Button page", true);
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
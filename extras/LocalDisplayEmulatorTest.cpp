@@ -0,0 +1,248 @@
+/*
+ * @file LocalDisplayEmulatorTest.cpp
+ *
+ * Host golden image test and benchmark of the SSD1289 local display driver on the framebuffer emulator
+ * lib/BlueDisplay/LocalDisplay/LocalDisplayEmulator.hpp.
+ * Each scene is drawn on a cleared display by the unchanged driver. The CRC32 of the framebuffer is compared with
+ * the golden CRC of the scene and the bus statistics are printed. If a CRC differs, the framebuffer is stored
+ * as <scene>.png for inspection. A changed rendering must be checked with the PNG and the golden CRC then updated.
+ * Finally the SPI decoder of the HX8347D emulation is checked with a window fill like HX8347D::fillRect() does it.
+ *
+ * Build from the repository root:
+ * g++ -O2 -DSTM32F30X -DLOCAL_DISPLAY_EMULATOR -DSUPPORT_LOCAL_DISPLAY -DDISABLE_REMOTE_DISPLAY -DFONT_8X12
+ *     -Iextras/host -Ilib/fat_sd -Ilib/BlueDisplay -Ilib/BlueDisplay/LocalDisplay -Ilib/BlueDisplay/LocalGUI
+ *     -o LocalDisplayEmulatorTest extras/LocalDisplayEmulatorTest.cpp
+ * Usage: LocalDisplayEmulatorTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdio.h>  // for sprintf of SSD1289.hpp
+#include <string.h>
+
+#include "host/hostTest.h"
+
+extern int sLockCount;
+
+#define USE_SSD1289
+#include "LocalDisplay/fonts.hpp"
+#include "LocalDisplay/LocalDisplayInterface.hpp"
+#include "LocalDisplay/LocalDisplayEmulator.hpp"
+#include "LocalGUI/ThickLine.hpp"
+#include "GUIHelper.hpp"
+
+/*
+ * Target functions used by the driver, which have no effect on the host
+ */
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+int sLockCount;
+bool isLocalDisplayAvailable;
+
+uint32_t millis(void) {
+    return 0;
+}
+uint32_t micros(void) {
+    return 0;
+}
+void delay(int32_t aTimeMillis) {
+    (void) aTimeMillis;
+}
+void delayNanos(int32_t aTimeNanos) {
+    (void) aTimeNanos;
+}
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+uint32_t getLR14(void) {
+    return 0;
+}
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    printf("%s:%lu %s %d\n", aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+    (void) aLinkRegister;
+}
+void SSD1289_IO_initalize(void) {
+}
+void PWM_BL_initalize(void) {
+}
+void PWM_BL_setOnRatio(uint32_t power) {
+    (void) power;
+}
+bool MICROSD_isCardInserted(void) {
+    return false;
+}
+int RTC_getDateStringForFile(char *aStringBuffer) {
+    aStringBuffer[0] = '\0';
+    return 0;
+}
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        void (*aReadLineFunction)(uint16_t*, uint16_t)) {
+    (void) aFileName;
+    (void) aFormat;
+    (void) aWidth;
+    (void) aHeight;
+    (void) aReadLineFunction;
+    return FR_NOT_READY;
+}
+void LocalTouchButton::playFeedbackTone(bool aPlayErrorTone) {
+    (void) aPlayErrorTone;
+}
+
+/*
+ * Scenes and their golden CRC32 of the framebuffer
+ */
+static void drawFillRect(void) {
+    LocalDisplay.fillRect(10, 10, 29, 19, COLOR16_RED);
+}
+static void drawPixels(void) {
+    for (int i = 0; i < 20; ++i) {
+        LocalDisplay.drawPixel(5 + (i * 15), 5 + (i * 11), COLOR16_BLUE);
+    }
+}
+static void drawLines(void) {
+    LocalDisplay.drawLine(0, 239, 319, 0, COLOR16_GREEN);
+    LocalDisplay.drawLine(0, 0, 319, 239, COLOR16_BLUE);
+    LocalDisplay.drawLine(10, 120, 310, 120, COLOR16_RED);
+    LocalDisplay.drawLine(160, 10, 160, 230, COLOR16_RED);
+}
+static void drawThickLines(void) {
+    drawThickLine(20, 200, 300, 40, 5, LINE_THICKNESS_MIDDLE, COLOR16_BLUE);
+    drawThickLine(20, 40, 300, 200, 3, LINE_THICKNESS_DRAW_CLOCKWISE, COLOR16_RED);
+}
+static void drawCircles(void) {
+    LocalDisplay.drawCircle(160, 120, 100, COLOR16_BLUE);
+    LocalDisplay.fillCircle(160, 120, 40, COLOR16_RED);
+}
+static void drawTexts(void) {
+    LocalDisplay.drawText(40, 100, "Hello Emulator", TEXT_SIZE_11, COLOR16_BLACK, COLOR16_WHITE);
+    LocalDisplay.drawText(10, 140, "0123456789 Volt", TEXT_SIZE_22, COLOR16_RED, COLOR16_YELLOW);
+}
+
+struct SceneStruct {
+    const char *Name;
+    void (*Draw)(void);
+    uint32_t GoldenCRC;
+};
+
+static const SceneStruct sScenes[] = { { "fillRect", &drawFillRect, 0xCD043194 }, { "drawPixel", &drawPixels, 0xF3112FE0 }, {
+        "drawLine", &drawLines, 0xBD816CF3 }, { "drawThickLine", &drawThickLines, 0x29777628 }, { "drawCircle", &drawCircles,
+        0x2051BF3E }, { "drawText", &drawTexts, 0xFC66A24A } };
+
+static void checkScene(const SceneStruct *aScene) {
+    char tBuffer[400];
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    aScene->Draw();
+    LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), aScene->Name);
+    fputs(tBuffer, stdout);
+    uint32_t tCRC = LocalDisplayEmulator_getFramebufferCRC32();
+    if (tCRC != aScene->GoldenCRC) {
+        snprintf(tBuffer, sizeof(tBuffer), "%s.png", aScene->Name);
+        LocalDisplayEmulator_storePNG(tBuffer);
+        printf("CRC 0x%08lX instead of 0x%08lX, framebuffer stored as %s\n", (unsigned long) tCRC,
+                (unsigned long) aScene->GoldenCRC, tBuffer);
+    }
+    check(tCRC == aScene->GoldenCRC, aScene->Name);
+}
+
+/*
+ * Checks the pixel written by fillRect() and the line read back by fillDisplayLineBuffer() for screenshots.
+ * The emulator returns the stored RGB565 value, which fillDisplayLineBuffer() converts by shifting red and green one bit down.
+ */
+static void checkFillRectAndRead(void) {
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_resetStatistics();
+    LocalDisplay.fillRect(10, 10, 29, 19, COLOR16_RED);
+    check(LocalDisplayEmulator_getStatistics()->PixelWrites == 20 * 10, "fillRect of 20 x 10 writes 200 pixel");
+    uint16_t *tFramebuffer = LocalDisplayEmulator_getFramebuffer();
+    uint32_t tRedCount = 0;
+    for (uint32_t i = 0; i < LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT; ++i) {
+        if (tFramebuffer[i] == COLOR16_RED) {
+            tRedCount++;
+        }
+    }
+    check(tRedCount == 20 * 10, "fillRect of 20 x 10");
+    uint16_t tLine[LOCAL_DISPLAY_WIDTH + 1];
+    tLine[LOCAL_DISPLAY_WIDTH] = 0x1234;
+    uint16_t *tLineEnd = LocalDisplay.fillDisplayLineBuffer(tLine, 15);
+    check(tLineEnd == &tLine[LOCAL_DISPLAY_WIDTH] && tLine[LOCAL_DISPLAY_WIDTH] == 0x1234, "fillDisplayLineBuffer length");
+    check(tLine[0] == 0x7FFF && tLine[9] == 0x7FFF && tLine[10] == 0x7C00 && tLine[29] == 0x7C00 && tLine[30] == 0x7FFF
+                    && tLine[LOCAL_DISPLAY_WIDTH - 1] == 0x7FFF, "fillDisplayLineBuffer");
+}
+
+static void writeHX8347DRegister(uint8_t aRegister, uint8_t aValue) {
+    LocalDisplayEmulator_setSPIChipSelect(true);
+    LocalDisplayEmulator_SPITransfer(EMULATOR_SPI_START_INDEX);
+    LocalDisplayEmulator_SPITransfer(aRegister);
+    LocalDisplayEmulator_setSPIChipSelect(false);
+    LocalDisplayEmulator_setSPIChipSelect(true);
+    LocalDisplayEmulator_SPITransfer(EMULATOR_SPI_START_WRITE);
+    LocalDisplayEmulator_SPITransfer(aValue);
+    LocalDisplayEmulator_setSPIChipSelect(false);
+}
+
+/*
+ * Window 300 to 309 x 200 to 204 like HX8347D::setArea() and one data phase of 50 pixel
+ */
+static void checkHX8347DFill(void) {
+    char tBuffer[400];
+    LocalDisplayEmulator_reset();
+    writeHX8347DRegister(0x03, 300 & 0xFF);
+    writeHX8347DRegister(0x02, 300 >> 8);
+    writeHX8347DRegister(0x05, 309 & 0xFF);
+    writeHX8347DRegister(0x04, 309 >> 8);
+    writeHX8347DRegister(0x07, 200);
+    writeHX8347DRegister(0x09, 204);
+    LocalDisplayEmulator_setSPIChipSelect(true);
+    LocalDisplayEmulator_SPITransfer(EMULATOR_SPI_START_INDEX);
+    LocalDisplayEmulator_SPITransfer(EMULATOR_GRAM_REGISTER);
+    LocalDisplayEmulator_setSPIChipSelect(false);
+    LocalDisplayEmulator_setSPIChipSelect(true);
+    LocalDisplayEmulator_SPITransfer(EMULATOR_SPI_START_WRITE);
+    for (int i = 0; i < 50; ++i) {
+        LocalDisplayEmulator_SPITransfer(COLOR16_RED >> 8);
+        LocalDisplayEmulator_SPITransfer(COLOR16_RED & 0xFF);
+    }
+    LocalDisplayEmulator_setSPIChipSelect(false);
+    LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), "HX8347D fill 10 x 5");
+    fputs(tBuffer, stdout);
+
+    uint16_t *tFramebuffer = LocalDisplayEmulator_getFramebuffer();
+    uint32_t tRedCount = 0;
+    for (uint32_t i = 0; i < LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT; ++i) {
+        if (tFramebuffer[i] == COLOR16_RED) {
+            tRedCount++;
+        }
+    }
+    check(tRedCount == 50 && tFramebuffer[200 * LOCAL_DISPLAY_EMULATOR_WIDTH + 300] == COLOR16_RED
+                    && tFramebuffer[204 * LOCAL_DISPLAY_EMULATOR_WIDTH + 309] == COLOR16_RED, "HX8347D window fill");
+}
+
+int main(void) {
+    char tBuffer[400];
+    LocalDisplayEmulator_reset();
+    LocalDisplay.init();
+    check(isLocalDisplayAvailable, "SSD1289 device code");
+    LocalDisplayEmulator_resetStatistics();
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), "clearDisplay");
+    fputs(tBuffer, stdout);
+
+    for (unsigned int i = 0; i < sizeof(sScenes) / sizeof(sScenes[0]); ++i) {
+        checkScene(&sScenes[i]);
+    }
+    checkFillRectAndRead();
+    checkHX8347DFill();
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
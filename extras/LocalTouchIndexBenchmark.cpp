@@ -0,0 +1,238 @@
+/*
+ * @file LocalTouchIndexBenchmark.cpp
+ *
+ * Host benchmark of the grid index lib/BlueDisplay/LocalGUI/LocalTouchIndex.hpp used by LocalTouchButton::find()
+ * and LocalTouchSlider::find(), compared with the former walk through the object lists.
+ * For n = 10 to 200, n active buttons tile the display, n inactive buttons of another page lie at the same positions
+ * and n / 10 + 1 sliders overlap them. Every 4. button is an autorepeat button.
+ * 2 million random touch positions are looked up with both methods.
+ * Candidates are the entries of the cell of the touch position, i.e. the buttons checked by one lookup.
+ *
+ * Checks:
+ * - Each lookup of the index returns the same button and slider as the list walk, also for autorepeat buttons.
+ * - The button and slider indexes are valid for all n, i.e. the default capacities serve 200 buttons
+ *   and find() never falls back to the list walk.
+ *
+ * Build from the repository root:
+ * g++ -O2 -DSTM32F30X -DLOCAL_DISPLAY_EMULATOR -DSUPPORT_LOCAL_DISPLAY -DDISABLE_REMOTE_DISPLAY -DFONT_8X12
+ *     -Iextras/host -Ilib/fat_sd -Ilib/BlueDisplay -Ilib/BlueDisplay/LocalDisplay -Ilib/BlueDisplay/LocalGUI
+ *     -o LocalTouchIndexBenchmark extras/LocalTouchIndexBenchmark.cpp
+ * Usage: LocalTouchIndexBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdio.h>  // for sprintf of SSD1289.hpp
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "host/hostTest.h"
+
+extern int sLockCount;
+void tone(uint16_t aFrequency, uint32_t aDurationMillis);
+
+#define USE_SSD1289
+#include "LocalDisplay/fonts.hpp"
+#include "LocalDisplay/LocalDisplayInterface.hpp"
+#include "LocalDisplay/LocalDisplayEmulator.hpp"
+#include "LocalGUI/ThickLine.hpp"
+#include "GUIHelper.hpp"
+#include "LocalGUI/LocalTouchButton.hpp"
+#include "LocalGUI/LocalTouchSlider.hpp"
+
+/*
+ * Target functions used by the driver, which have no effect on the host
+ */
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+int sLockCount;
+bool isLocalDisplayAvailable;
+
+uint32_t millis(void) {
+    return 0;
+}
+uint32_t micros(void) {
+    return 0;
+}
+void delay(int32_t aTimeMillis) {
+    (void) aTimeMillis;
+}
+void delayNanos(int32_t aTimeNanos) {
+    (void) aTimeNanos;
+}
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+uint32_t getLR14(void) {
+    return 0;
+}
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    printf("%s:%lu %s %d\n", aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+    (void) aLinkRegister;
+}
+void SSD1289_IO_initalize(void) {
+}
+void PWM_BL_initalize(void) {
+}
+void PWM_BL_setOnRatio(uint32_t power) {
+    (void) power;
+}
+bool MICROSD_isCardInserted(void) {
+    return false;
+}
+int RTC_getDateStringForFile(char *aStringBuffer) {
+    aStringBuffer[0] = '\0';
+    return 0;
+}
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        void (*aReadLineFunction)(uint16_t*, uint16_t)) {
+    (void) aFileName;
+    (void) aFormat;
+    (void) aWidth;
+    (void) aHeight;
+    (void) aReadLineFunction;
+    return FR_NOT_READY;
+}
+void tone(uint16_t aFrequency, uint32_t aDurationMillis) {
+    (void) aFrequency;
+    (void) aDurationMillis;
+}
+
+#define NUMBER_OF_LOOKUPS   2000000
+#define CHECK_STEP          7 // every 7. position is compared with the list walk
+
+static uint16_t sTouchX[NUMBER_OF_LOOKUPS];
+static uint16_t sTouchY[NUMBER_OF_LOOKUPS];
+
+/*
+ * The former LocalTouchButton::find() and LocalTouchSlider::find()
+ */
+static LocalTouchButton* findButtonInList(unsigned int aTouchPositionX, unsigned int aTouchPositionY,
+        bool aSearchOnlyAutorepeatButtons) {
+    LocalTouchButton *tButtonPointer = LocalTouchButton::sButtonListStart;
+    while (tButtonPointer != NULL) {
+        if ((tButtonPointer->mFlags & LOCAL_BUTTON_FLAG_IS_ACTIVE)
+                && (!aSearchOnlyAutorepeatButtons || (tButtonPointer->mFlags & FLAG_BUTTON_TYPE_AUTOREPEAT))
+                && tButtonPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
+            return tButtonPointer;
+        }
+        tButtonPointer = tButtonPointer->mNextObject;
+    }
+    return NULL;
+}
+
+static LocalTouchSlider* findSliderInList(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+    LocalTouchSlider *tSliderPointer = LocalTouchSlider::sSliderListStart;
+    while (tSliderPointer != NULL) {
+        if (tSliderPointer->mIsActive && tSliderPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
+            return tSliderPointer;
+        }
+        tSliderPointer = tSliderPointer->mNextObject;
+    }
+    return NULL;
+}
+
+static double getNanos(std::chrono::steady_clock::time_point aStart) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - aStart).count();
+}
+
+static void measure(int aNumberOfButtons) {
+    // buttons tile the display
+    int tColumns = 1;
+    while (tColumns * tColumns * 3 < aNumberOfButtons * 4) {
+        tColumns++;
+    }
+    int tRows = (aNumberOfButtons + tColumns - 1) / tColumns;
+    int tWidth = LOCAL_DISPLAY_WIDTH / tColumns;
+    int tHeight = LOCAL_DISPLAY_HEIGHT / tRows;
+    LocalTouchButton *tButtons = new LocalTouchButton[2 * aNumberOfButtons];
+    for (int i = 0; i < 2 * aNumberOfButtons; ++i) {
+        int tPosition = i % aNumberOfButtons;
+        tButtons[i].init((tPosition % tColumns) * tWidth, (tPosition / tColumns) * tHeight, tWidth - 2, tHeight - 2,
+                COLOR16_BLACK, "", TEXT_SIZE_11, ((i & 3) == 0) ? FLAG_BUTTON_TYPE_AUTOREPEAT : 0, 0, NULL);
+        if (i < aNumberOfButtons) {
+            tButtons[i].activate();
+        } else {
+            tButtons[i].deactivate();
+        }
+    }
+    int tNumberOfSliders = aNumberOfButtons / 10 + 1;
+    LocalTouchSlider *tSliders = new LocalTouchSlider[tNumberOfSliders];
+    for (int i = 0; i < tNumberOfSliders; ++i) {
+        tSliders[i].init((i * 29) % (LOCAL_DISPLAY_WIDTH - 120), (i * 37) % (LOCAL_DISPLAY_HEIGHT - 120), 8, 100 - (i % 5) * 10, 0, 0, COLOR16_BLACK, COLOR16_BLACK,
+                FLAG_SLIDER_SHOW_BORDER | ((i & 1) ? FLAG_SLIDER_IS_HORIZONTAL : 0), NULL);
+        tSliders[i].activate();
+    }
+
+    long tMismatches = 0;
+    double tCandidates = 0;
+    int tChecks = 0;
+    for (int i = 0; i < NUMBER_OF_LOOKUPS; i += CHECK_STEP) {
+        if (LocalTouchButton::find(sTouchX[i], sTouchY[i], i & 1) != findButtonInList(sTouchX[i], sTouchY[i], i & 1)
+                || LocalTouchSlider::find(sTouchX[i], sTouchY[i]) != findSliderInList(sTouchX[i], sTouchY[i])) {
+            tMismatches++;
+        }
+        uint_fast16_t tNumberOfEntries = 2 * aNumberOfButtons;
+        if (sButtonIndex.IsValid) {
+            LocalTouchIndex_getCell(&sButtonIndex, sTouchX[i], sTouchY[i], &tNumberOfEntries);
+        }
+        tCandidates += tNumberOfEntries;
+        tChecks++;
+    }
+
+    volatile uintptr_t tSink = 0;
+    auto tStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUMBER_OF_LOOKUPS; ++i) {
+        tSink += (uintptr_t) findButtonInList(sTouchX[i], sTouchY[i], false) + (uintptr_t) findSliderInList(sTouchX[i], sTouchY[i]);
+    }
+    double tListNanos = getNanos(tStart) / NUMBER_OF_LOOKUPS;
+    tStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUMBER_OF_LOOKUPS; ++i) {
+        tSink += (uintptr_t) LocalTouchButton::find(sTouchX[i], sTouchY[i], false)
+                + (uintptr_t) LocalTouchSlider::find(sTouchX[i], sTouchY[i]);
+    }
+    double tIndexNanos = getNanos(tStart) / NUMBER_OF_LOOKUPS;
+    tStart = std::chrono::steady_clock::now();
+    for (int i = 0; i < 1000; ++i) {
+        tButtons[0].deactivate();
+        tButtons[0].activate();
+        LocalTouchButton::rebuildIndex();
+    }
+    double tRebuildNanos = getNanos(tStart) / 1000;
+
+    printf("%3d buttons: list %5.1f ns, index %5.1f ns%s, rebuild %.2f us, %.1f of %d candidates, %u entries, %ld mismatches\n",
+            aNumberOfButtons, tListNanos, tIndexNanos, sButtonIndex.IsValid ? "" : " (capacity exceeded, list walk)",
+            tRebuildNanos / 1000, tCandidates / tChecks, 2 * aNumberOfButtons,
+            (unsigned int) sButtonIndex.CellStart[LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS], tMismatches);
+    check(tMismatches == 0, "index lookup differs from list walk");
+    check(sButtonIndex.IsValid, "button index is valid");
+    check(sSliderIndex.IsValid, "slider index is valid");
+
+    delete[] tButtons;
+    delete[] tSliders;
+}
+
+int main(void) {
+    static const int sNumberOfButtons[] = { 10, 25, 50, 100, 200 };
+    srand(1);
+    for (int i = 0; i < NUMBER_OF_LOOKUPS; ++i) {
+        sTouchX[i] = rand() % LOCAL_DISPLAY_WIDTH;
+        sTouchY[i] = rand() % LOCAL_DISPLAY_HEIGHT;
+    }
+    for (unsigned int i = 0; i < sizeof(sNumberOfButtons) / sizeof(sNumberOfButtons[0]); ++i) {
+        measure(sNumberOfButtons[i]);
+    }
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
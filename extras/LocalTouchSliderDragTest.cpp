@@ -0,0 +1,237 @@
+/*
+ * @file LocalTouchSliderDragTest.cpp
+ *
+ * Host test of the delta drawing and the coalesced redraws of lib/BlueDisplay/LocalGUI/LocalTouchSlider.hpp
+ * on the SSD1289 emulator of lib/BlueDisplay/LocalDisplay/LocalDisplayEmulator.hpp.
+ * A horizontal, a vertical and a FLAG_SLIDER_VALUE_BY_CALLBACK slider are dragged over their threshold to their end
+ * and back, with one touch move every TOUCH_SAMPLER_PERIOD_MILLIS, like handleTouchPanelEvents() does.
+ *
+ * Checks:
+ * - After each drag, the framebuffer is equal to a complete redraw of all sliders on a cleared display.
+ * - The value of the slider is the one of the last touch position, and the callback handler got it by its last call.
+ * - Redraws are coalesced, i.e. there are fewer redraws than touch moves.
+ *   Build with -DDISABLE_SLIDER_CALLBACK_COALESCING: the callback handler is called at each move, which changes the value.
+ *
+ * Build from the repository root:
+ * g++ -O2 -DSTM32F30X -DLOCAL_DISPLAY_EMULATOR -DSUPPORT_LOCAL_DISPLAY -DDISABLE_REMOTE_DISPLAY -DFONT_8X12
+ *     -Iextras/host -Ilib/fat_sd -Ilib/BlueDisplay -Ilib/BlueDisplay/LocalDisplay -Ilib/BlueDisplay/LocalGUI
+ *     -o LocalTouchSliderDragTest extras/LocalTouchSliderDragTest.cpp
+ * Usage: LocalTouchSliderDragTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>  // for sprintf of SSD1289.hpp
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+extern int sLockCount;
+void tone(uint16_t aFrequency, uint32_t aDurationMillis);
+
+#define USE_SSD1289
+#include "LocalDisplay/fonts.hpp"
+#include "LocalDisplay/LocalDisplayInterface.hpp"
+#include "LocalDisplay/LocalDisplayEmulator.hpp"
+#include "LocalGUI/ThickLine.hpp"
+#include "GUIHelper.hpp"
+#include "LocalGUI/LocalTouchButton.hpp"
+#include "LocalGUI/LocalTouchSlider.hpp"
+
+/*
+ * Target functions used by the driver, which have no effect on the host
+ */
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+int sLockCount;
+bool isLocalDisplayAvailable;
+static uint32_t sMillis; // advanced by each touch move
+
+uint32_t millis(void) {
+    return sMillis;
+}
+uint32_t micros(void) {
+    return sMillis * 1000;
+}
+void delay(int32_t aTimeMillis) {
+    (void) aTimeMillis;
+}
+void delayNanos(int32_t aTimeNanos) {
+    (void) aTimeNanos;
+}
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis) {
+    (void) aGenericCallback;
+    (void) aTimeMillis;
+}
+uint32_t getLR14(void) {
+    return 0;
+}
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    printf("%s:%lu %s %d\n", aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+    (void) aLinkRegister;
+}
+void SSD1289_IO_initalize(void) {
+}
+void PWM_BL_initalize(void) {
+}
+void PWM_BL_setOnRatio(uint32_t power) {
+    (void) power;
+}
+bool MICROSD_isCardInserted(void) {
+    return false;
+}
+int RTC_getDateStringForFile(char *aStringBuffer) {
+    aStringBuffer[0] = '\0';
+    return 0;
+}
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        void (*aReadLineFunction)(uint16_t*, uint16_t)) {
+    (void) aFileName;
+    (void) aFormat;
+    (void) aWidth;
+    (void) aHeight;
+    (void) aReadLineFunction;
+    return FR_NOT_READY;
+}
+void tone(uint16_t aFrequency, uint32_t aDurationMillis) {
+    (void) aFrequency;
+    (void) aDurationMillis;
+}
+
+#define TOUCH_SAMPLER_PERIOD_MILLIS 10 // from ADS7846.hpp
+#define DRAG_STEP                   3 // pixel per touch move
+
+static LocalTouchSlider sHorizontalSlider;
+static LocalTouchSlider sVerticalSlider;
+static LocalTouchSlider sCallbackSlider;
+
+static uint16_t sDragFramebuffer[LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT];
+static int sCallbackCalls;
+static uint16_t sLastCallbackValue;
+
+static void doSlider(LocalTouchSlider *aTheTouchedSlider, uint16_t aValue) {
+    (void) aTheTouchedSlider;
+    (void) aValue;
+}
+
+static void doCallbackSlider(LocalTouchSlider *aTheTouchedSlider, uint16_t aValue) {
+    sCallbackCalls++;
+    sLastCallbackValue = aValue;
+    aTheTouchedSlider->setValueAndDrawBar(aValue);
+}
+
+struct DragStruct {
+    const char *Name;
+    LocalTouchSlider *Slider;
+    uint16_t Start; // touch position along the slider
+    uint16_t Turn;
+    uint16_t End;
+    uint16_t Across; // touch position across the slider
+    uint16_t ExpectedValue;
+};
+
+static void drawAllSliders(void) {
+    LocalDisplay.clearDisplay(COLOR16_WHITE);
+    sHorizontalSlider.drawSlider();
+    sVerticalSlider.drawSlider();
+    sCallbackSlider.drawSlider();
+}
+
+/*
+ * One touch event followed by the drawing of the pending value, like in handleTouchPanelEvents()
+ * @return 1 if the touch value changed
+ */
+static int touch(const DragStruct *aDrag, uint16_t aPosition) {
+    bool tIsHorizontal = aDrag->Slider->mFlags & FLAG_SLIDER_IS_HORIZONTAL;
+    uint16_t tLastTouchValue = aDrag->Slider->mActualTouchValue;
+    sMillis += TOUCH_SAMPLER_PERIOD_MILLIS;
+    LocalTouchSlider::checkAllSliders(tIsHorizontal ? aPosition : aDrag->Across, tIsHorizontal ? aDrag->Across : aPosition);
+    LocalTouchSlider::drawPendingValue(false);
+    return (aDrag->Slider->mActualTouchValue != tLastTouchValue);
+}
+
+/*
+ * Touch down at Start, move to Turn and back to End, touch up at End
+ */
+static void drag(const DragStruct *aDrag) {
+    LocalTouchSlider::resetDrawStatistics();
+    sCallbackCalls = 0;
+    int tMoves = 0;
+    int tValueChanges = 0;
+    int tStep = (aDrag->Turn > aDrag->Start) ? DRAG_STEP : -DRAG_STEP;
+    for (int tPosition = aDrag->Start; (tStep > 0) ? tPosition < aDrag->Turn : tPosition > aDrag->Turn; tPosition += tStep) {
+        tValueChanges += touch(aDrag, tPosition);
+        tMoves++;
+    }
+    for (int tPosition = aDrag->Turn; (tStep > 0) ? tPosition > aDrag->End : tPosition < aDrag->End; tPosition -= tStep) {
+        tValueChanges += touch(aDrag, tPosition);
+        tMoves++;
+    }
+    tValueChanges += touch(aDrag, aDrag->End);
+    tMoves++;
+    LocalTouchSlider::drawPendingValue(true); // touch up
+
+    LocalTouchSliderDrawStatisticsStruct tStatistics = *LocalTouchSlider::getDrawStatistics(); // before the redraw adds to it
+    memcpy(sDragFramebuffer, LocalDisplayEmulator_getFramebuffer(), sizeof(sDragFramebuffer));
+    drawAllSliders();
+    uint32_t tDifferentPixels = LocalDisplayEmulator_countDifferentPixels(sDragFramebuffer);
+    printf("%-10s %3d moves, %3d redraws, %3d coalesced, %3d callbacks, %6u of %6u pixel drawn, %u pixel differ from redraw\n",
+            aDrag->Name, tMoves, tStatistics.Redraws, tStatistics.RedrawsCoalesced, sCallbackCalls,
+            (unsigned int) tStatistics.PixelsDrawn, (unsigned int) tStatistics.PixelsOfCompleteRedraws,
+            (unsigned int) tDifferentPixels);
+
+    check(tDifferentPixels == 0, "framebuffer after drag is equal to complete redraw");
+    check(aDrag->Slider->getValue() == aDrag->ExpectedValue, "slider value is the one of the last touch position");
+    if (aDrag->Slider->mFlags & FLAG_SLIDER_VALUE_BY_CALLBACK) {
+        check(sLastCallbackValue == aDrag->ExpectedValue, "last callback got the last touch value");
+#if defined(DISABLE_SLIDER_CALLBACK_COALESCING)
+        check(sCallbackCalls == tValueChanges, "callback is called at each value change");
+#else
+        check(sCallbackCalls == tStatistics.Redraws, "callback is called by each redraw");
+        check(sCallbackCalls < tValueChanges, "callbacks are coalesced");
+#endif
+    } else {
+        check(tStatistics.Redraws < tValueChanges, "redraws are coalesced");
+        check(tStatistics.PixelsDrawn < tStatistics.PixelsOfCompleteRedraws, "bar is drawn by delta");
+    }
+}
+
+int main(void) {
+    LocalDisplayEmulator_reset();
+    LocalDisplay.init();
+    check(isLocalDisplayAvailable, "SSD1289 device code");
+
+    /*
+     * The value of a horizontal slider with border is x - (x position + 4) + 1,
+     * the one of a vertical slider is (y position + bar length + 8 - 1) - 4 - y + 1
+     */
+    sHorizontalSlider.init(20, 20, 8, 200, 120, 30, COLOR16_BLUE, COLOR16_GREEN,
+            FLAG_SLIDER_SHOW_BORDER | FLAG_SLIDER_SHOW_VALUE | FLAG_SLIDER_IS_HORIZONTAL, &doSlider);
+    sVerticalSlider.init(270, 40, 8, 150, 100, 20, COLOR16_BLUE, COLOR16_GREEN, FLAG_SLIDER_SHOW_BORDER | FLAG_SLIDER_SHOW_VALUE,
+            &doSlider);
+    sCallbackSlider.init(20, 120, 8, 200, 150, 0, COLOR16_BLUE, COLOR16_GREEN,
+            FLAG_SLIDER_SHOW_BORDER | FLAG_SLIDER_SHOW_VALUE | FLAG_SLIDER_IS_HORIZONTAL | FLAG_SLIDER_VALUE_BY_CALLBACK,
+            &doCallbackSlider);
+    drawAllSliders();
+
+    static const DragStruct sDrags[] = {
+    /* */{ "horizontal", &sHorizontalSlider, 40, 232, 130, 32, 107 },
+    /* */{ "vertical", &sVerticalSlider, 180, 40, 120, 282, 74 },
+    /* */{ "callback", &sCallbackSlider, 30, 232, 80, 132, 57 } };
+    for (unsigned int i = 0; i < sizeof(sDrags) / sizeof(sDrags[0]); ++i) {
+        drag(&sDrags[i]);
+    }
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,194 @@
+/*
+ * @file MMCSimBenchmark.c
+ *
+ * Host benchmark of the card operations of the firmware on the SPI level card simulator mmc_sim.c.
+ * ff.c and mmc.c are compiled unchanged, the platform functions are in host/hostPlatform.c.
+ * The operations repeat the FatFs calls of doStoreLoadAcquisitionData(), doStoreLoadChartToFile(), doExportChart()
+ * and storeScreenshot() as they were before the write behind queue and the image writer, with the structure sizes of the STM32 build.
+ * For each operation the sector reads and writes, the single block ratio, the simulated bus time
+ * and the sector bytes per simulated CPU cycle are printed.
+ * Then multiple block transfers are measured in sector bytes per CPU cycle, for the DMA path of mmc.c
+ * or, if built with -DSTM32_SD_USE_PIO, for the byte loop.
+ * Then the fault injection of the simulator is checked against the error handling and the CRC check of mmc.c.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o MMCSimBenchmark extras/MMCSimBenchmark.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c
+ * or "make -C extras", which also builds MMCSimPIOBenchmark with -DSTM32_SD_USE_PIO.
+ * Usage: MMCSimBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "diskio.h"
+#include "main.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define DSO_MEASUREMENT_CONTROL_SIZE    132     // sizeof(MeasurementControl)
+#define DSO_DATA_BUFFER_CONTROL_SIZE    11576   // sizeof(DataBufferControl) with DATABUFFER_SIZE 2880
+#define ACCU_DISPLAY_CONTROL_SIZE       12      // sizeof(AccuCapDisplayControl[0])
+#define ACCU_BATTERY_CONTROL_SIZE       4864    // sizeof(BatteryControl[0]) with 2 x 1200 samples
+#define ACCU_EXPORT_LINES               1200
+#define ACCU_EXPORT_LINE_LENGTH         13      // "%6.3f;%5d\n"
+#define STRING_BUFFER_SIZE              240     // sStringBuffer
+#define DISPLAY_WIDTH                   320
+#define DISPLAY_HEIGHT                  240
+
+static uint8_t sData[16384];
+static uint8_t sReadBack[16384];
+static void fillData(uint8_t aSeed) {
+    for (unsigned int i = 0; i < sizeof(sData); ++i) {
+        sData[i] = (uint8_t) (i * 7 + aSeed);
+    }
+}
+
+/*
+ * Writes 2 structures like the store of DSO and AccuCapacity data and reads them back like the load
+ */
+static void storeAndLoad(const char *aFileName, UINT aFirstSize, UINT aSecondSize) {
+    FIL tFile;
+    UINT tCount;
+    fillData(aFirstSize);
+    check(f_open(&tFile, aFileName, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for store");
+    f_write(&tFile, sData, aFirstSize, &tCount);
+    f_write(&tFile, &sData[aFirstSize], aSecondSize, &tCount);
+    check(f_close(&tFile) == FR_OK, "close of store");
+    snprintf(sStringBuffer, sizeof(sStringBuffer), "store %s", aFileName);
+    HostPlatform_printCardStatistics(sStringBuffer);
+
+    check(f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ) == FR_OK, "open for load");
+    f_read(&tFile, sReadBack, aFirstSize, &tCount);
+    f_read(&tFile, &sReadBack[aFirstSize], aSecondSize, &tCount);
+    f_close(&tFile);
+    check(memcmp(sData, sReadBack, aFirstSize + aSecondSize) == 0, "loaded data differs");
+    snprintf(sStringBuffer, sizeof(sStringBuffer), "load %s", aFileName);
+    HostPlatform_printCardStatistics(sStringBuffer);
+}
+
+/*
+ * Header and lines are collected in a buffer of the size of sStringBuffer and written if it is almost full
+ */
+static void exportChart(void) {
+    FIL tFile;
+    UINT tCount;
+    char tBuffer[STRING_BUFFER_SIZE];
+    check(f_open(&tFile, "export.csv", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for export");
+    int tIndex = snprintf(tBuffer, sizeof(tBuffer), "Probe Nr:1\nSample interval:1:00 min\nDate:19.10.2026 12:00:00\n"
+            "Capacity:1950mAh\nInternal resistance:  150 mOhm\nVolt no load;mOhm\n");
+    f_write(&tFile, tBuffer, tIndex, &tCount);
+    tIndex = 0;
+    for (int i = 0; i < ACCU_EXPORT_LINES; ++i) {
+        tIndex += snprintf(&tBuffer[tIndex], sizeof(tBuffer) - tIndex, "%6.3f;%5d\n", 4.15 - i * 0.0007, 150 + i / 100);
+        if (tIndex > (int) (sizeof(tBuffer) - 15)) {
+            f_write(&tFile, tBuffer, tIndex, &tCount);
+            tIndex = 0;
+        }
+    }
+    if (tIndex > 0) {
+        f_write(&tFile, tBuffer, tIndex, &tCount);
+    }
+    check(f_close(&tFile) == FR_OK, "close of export");
+    check(f_size(&tFile) > ACCU_EXPORT_LINES * ACCU_EXPORT_LINE_LENGTH, "export size");
+    HostPlatform_printCardStatistics("doExportChart 1200 lines");
+}
+
+/*
+ * 54 bytes BMP header, then blocks of 4 display lines
+ */
+static void storeScreenshot(void) {
+    FIL tFile;
+    UINT tCount;
+    static uint8_t tLines[4 * DISPLAY_WIDTH * 2];
+    check(f_open(&tFile, "screen.bmp", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for screenshot");
+    memset(tLines, 0x42, 54);
+    f_write(&tFile, tLines, 14, &tCount);
+    f_write(&tFile, tLines, 40, &tCount);
+    for (int i = 0; i < DISPLAY_HEIGHT / 4; ++i) {
+        memset(tLines, i, sizeof(tLines));
+        f_write(&tFile, tLines, sizeof(tLines), &tCount);
+    }
+    check(f_close(&tFile) == FR_OK, "close of screenshot");
+    check(f_size(&tFile) == 54 + DISPLAY_WIDTH * DISPLAY_HEIGHT * 2, "screenshot size");
+    HostPlatform_printCardStatistics("storeScreenshot BMP");
+}
+
+/*
+ * 32 sectors written and read by one multiple block transfer
+ */
+static void measureSectorTransfers(void) {
+#if defined(STM32_SD_USE_PIO)
+    const char *tPathName = "PIO";
+    double tMinBytesPerCycle = 0.0;
+    double tMaxBytesPerCycle = 1.0 / 32; // the CPU waits for every byte on the bus
+#else
+    const char *tPathName = "DMA";
+    // mainly the CRC16, the DMA transfers the bytes
+    double tMinBytesPerCycle = 1.0 / (HOST_CPU_CYCLES_PER_CRC_BYTE + 1);
+    double tMaxBytesPerCycle = 1.0 / HOST_CPU_CYCLES_PER_CRC_BYTE;
+#endif
+    fillData(32);
+    MMCSim_resetStatistics();
+    check(disk_write(0, sData, 4000, 32) == RES_OK, "multiple block write");
+    check(MMCSim_getStatistics()->CRCErrors == 0, "CRC of commands and written blocks of mmc.c");
+    double tWriteBytesPerCycle = HostPlatform_getSectorBytesPerCPUCycle();
+    HostPlatform_printCardStatistics("disk_write 32 sectors");
+    check(disk_read(0, sReadBack, 4000, 32) == RES_OK && memcmp(sData, sReadBack, 32 * 512) == 0, "multiple block read");
+    check(MMCSim_getStatistics()->CRCErrors == 0, "CRC of commands of mmc.c");
+    double tReadBytesPerCycle = HostPlatform_getSectorBytesPerCPUCycle();
+    HostPlatform_printCardStatistics("disk_read 32 sectors");
+    printf("%s at %lu Hz SPI clock: write %.3f, read %.3f sector bytes per CPU cycle without polling\n", tPathName,
+            (unsigned long) MMCSim_getSPIClockHertz(), tWriteBytesPerCycle, tReadBytesPerCycle);
+    check(tWriteBytesPerCycle > tMinBytesPerCycle && tWriteBytesPerCycle < tMaxBytesPerCycle, "write bytes per CPU cycle");
+    check(tReadBytesPerCycle > tMinBytesPerCycle && tReadBytesPerCycle < tMaxBytesPerCycle, "read bytes per CPU cycle");
+}
+
+static void checkFaults(void) {
+    check(MMCSim_isCRCEnabled(), "mmc.c must enable CRC by CMD59");
+    MMCSim_injectFault(MMC_SIM_FAULT_READ_ERROR_TOKEN, 0);
+    check(disk_read(0, sReadBack, 100, 1) != RES_OK, "read with error token must fail");
+    MMCSim_injectFault(MMC_SIM_FAULT_READ_CRC, 0);
+    check(disk_read(0, sReadBack, 100, 1) != RES_OK, "read with wrong CRC must fail");
+    MMCSim_injectFault(MMC_SIM_FAULT_READ_CRC, 2);
+    check(disk_read(0, sReadBack, 100, 4) != RES_OK, "multiple block read with wrong CRC of third block must fail");
+    check(disk_read(0, sReadBack, 100, 4) == RES_OK, "multiple block read after CRC fault");
+    MMCSim_injectFault(MMC_SIM_FAULT_WRITE_CRC_ERROR, 1);
+    check(disk_write(0, sData, 2000, 4) != RES_OK, "multiple block write with CRC error response must fail");
+    MMCSim_injectFault(MMC_SIM_FAULT_WRITE_ERROR, 0);
+    check(disk_write(0, sData, 3000, 1) != RES_OK, "write with write error response must fail");
+    MMCSim_injectFault(MMC_SIM_FAULT_NONE, 0);
+    check(disk_write(0, sData, 3000, 1) == RES_OK, "write after fault");
+    check(isCardReady() == 0, "card must be busy directly after a write");
+    HostPlatform_spendMicros(5000);
+    check(isCardReady() == 1, "card must be ready after programming time");
+    check(disk_read(0, sReadBack, 3000, 1) == RES_OK && memcmp(sData, sReadBack, 512) == 0, "read back after fault");
+    check(MMCSim_getStatistics()->ProtocolErrors == 0, "protocol errors of mmc.c");
+    MMCSim_resetStatistics();
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+
+    storeAndLoad("DSO-data.bin", DSO_MEASUREMENT_CONTROL_SIZE, DSO_DATA_BUFFER_CONTROL_SIZE);
+    storeAndLoad("channel0_Discharging.bin", ACCU_DISPLAY_CONTROL_SIZE, ACCU_BATTERY_CONTROL_SIZE);
+    exportChart();
+    storeScreenshot();
+    measureSectorTransfers();
+    checkFaults();
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
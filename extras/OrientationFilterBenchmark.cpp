@@ -0,0 +1,348 @@
+/*
+ * @file OrientationFilterBenchmark.cpp
+ *
+ * Host benchmark of the single precision Mahony filter in system/F3-DiscoveryLib/src/orientationFilter.cpp
+ * against the same algorithm in double precision and against the true orientation of a sensor log.
+ *
+ * The sensor log is either synthetic or read from a file.
+ * The synthetic log is a known rotation sampled with the rates of the target: gyroscope 380 Hz, accelerometer 400 Hz, compass 75 Hz.
+ * Sensor errors: gyroscope bias and noise, accelerometer noise and vibration, compass hard iron offset, soft iron scale and noise.
+ * The compass calibration is done with the first 60 seconds, in which the board is rotated in all directions.
+ *
+ * A log file contains one line per gyroscope sample with seconds, gyroscope X Y Z in rad/s,
+ * accelerometer X Y Z in any unit and raw compass X Y Z, separated by blanks. It has no true orientation,
+ * so only the float and double filter are compared.
+ *
+ * Reported are the angle between float and double quaternion, the angle to the true orientation after 30 seconds,
+ * the estimated gyroscope bias and the host time per update. The cycles per update on the target are shown by the accelerometer page.
+ *
+ * Build from the repository root:
+ * g++ -O2 -Isystem/F3-DiscoveryLib/include -o OrientationFilterBenchmark extras/OrientationFilterBenchmark.cpp
+ *     system/F3-DiscoveryLib/src/orientationFilter.cpp
+ * Usage: OrientationFilterBenchmark [LogFile]
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "orientationFilter.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "host/hostTest.h"
+
+#define GYROSCOPE_RATE_HERTZ        380
+#define ACCELEROMETER_RATE_HERTZ    400
+#define COMPASS_RATE_HERTZ          75
+#define LOG_SECONDS                 240
+#define CALIBRATION_SECONDS         60 // with 20 seconds the min / max values miss the extremes and the error is 5 degree
+#define SETTLING_SECONDS            30
+
+/*
+ * Maximum deviations for the checks
+ */
+#define MAX_FLOAT_TO_DOUBLE_DEGREE  0.1
+#define MAX_RMS_ERROR_DEGREE        3.0
+#define MAX_BIAS_ERROR_RAD          0.005
+
+/*
+ * Double precision reference. Same equations as OrientationFilter_update().
+ */
+typedef struct {
+    double Q[4];
+    double GyroscopeBias[3];
+} ReferenceFilterTypeDef;
+
+static void normalize(double *aVector, int aLength) {
+    double tSum = 0;
+    for (int i = 0; i < aLength; ++i) {
+        tSum += aVector[i] * aVector[i];
+    }
+    double tNorm = 1.0 / sqrt(tSum);
+    for (int i = 0; i < aLength; ++i) {
+        aVector[i] *= tNorm;
+    }
+}
+
+static void updateReference(ReferenceFilterTypeDef *aFilter, const double *aGyroscope, const double *aAccelerometer,
+        const double *aCompass, double aDeltaSeconds) {
+    double q0 = aFilter->Q[0], q1 = aFilter->Q[1], q2 = aFilter->Q[2], q3 = aFilter->Q[3];
+    double g[3] = { aGyroscope[0], aGyroscope[1], aGyroscope[2] };
+    double a[3] = { aAccelerometer[0], aAccelerometer[1], aAccelerometer[2] };
+    double m[3] = { aCompass[0], aCompass[1], aCompass[2] };
+    normalize(a, 3);
+    normalize(m, 3);
+
+    double v[3] = { 2 * (q1 * q3 - q0 * q2), 2 * (q0 * q1 + q2 * q3), q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3 };
+    double e[3] = { a[1] * v[2] - a[2] * v[1], a[2] * v[0] - a[0] * v[2], a[0] * v[1] - a[1] * v[0] };
+
+    double hx = 2 * (m[0] * (0.5 - q2 * q2 - q3 * q3) + m[1] * (q1 * q2 - q0 * q3) + m[2] * (q1 * q3 + q0 * q2));
+    double hy = 2 * (m[0] * (q1 * q2 + q0 * q3) + m[1] * (0.5 - q1 * q1 - q3 * q3) + m[2] * (q2 * q3 - q0 * q1));
+    double bx = sqrt(hx * hx + hy * hy);
+    double bz = 2 * (m[0] * (q1 * q3 - q0 * q2) + m[1] * (q2 * q3 + q0 * q1) + m[2] * (0.5 - q1 * q1 - q2 * q2));
+    double w[3] = { 2 * (bx * (0.5 - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2)), 2
+            * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3)), 2 * (bx * (q0 * q2 + q1 * q3) + bz * (0.5 - q1 * q1 - q2 * q2)) };
+    e[0] += m[1] * w[2] - m[2] * w[1];
+    e[1] += m[2] * w[0] - m[0] * w[2];
+    e[2] += m[0] * w[1] - m[1] * w[0];
+
+    for (int i = 0; i < 3; ++i) {
+        aFilter->GyroscopeBias[i] -= ORIENTATION_FILTER_KI_DEFAULT * e[i] * aDeltaSeconds;
+        g[i] = (g[i] + ORIENTATION_FILTER_KP_DEFAULT * e[i] - aFilter->GyroscopeBias[i]) * 0.5 * aDeltaSeconds;
+    }
+    aFilter->Q[0] = q0 + (-q1 * g[0] - q2 * g[1] - q3 * g[2]);
+    aFilter->Q[1] = q1 + (q0 * g[0] + q2 * g[2] - q3 * g[1]);
+    aFilter->Q[2] = q2 + (q0 * g[1] - q1 * g[2] + q3 * g[0]);
+    aFilter->Q[3] = q3 + (q0 * g[2] + q1 * g[1] - q2 * g[0]);
+    normalize(aFilter->Q, 4);
+}
+
+/*
+ * Quaternion helpers for the true orientation
+ */
+static void multiplyQuaternion(const double *aP, const double *aQ, double *aResult) {
+    aResult[0] = aP[0] * aQ[0] - aP[1] * aQ[1] - aP[2] * aQ[2] - aP[3] * aQ[3];
+    aResult[1] = aP[0] * aQ[1] + aP[1] * aQ[0] + aP[2] * aQ[3] - aP[3] * aQ[2];
+    aResult[2] = aP[0] * aQ[2] - aP[1] * aQ[3] + aP[2] * aQ[0] + aP[3] * aQ[1];
+    aResult[3] = aP[0] * aQ[3] + aP[1] * aQ[2] - aP[2] * aQ[1] + aP[3] * aQ[0];
+}
+
+/*
+ * Rotates an earth frame vector into the sensor frame
+ */
+static void earthToSensor(const double *aQ, const double *aEarth, double *aSensor) {
+    double tVector[4] = { 0, aEarth[0], aEarth[1], aEarth[2] };
+    double tConjugate[4] = { aQ[0], -aQ[1], -aQ[2], -aQ[3] };
+    double tTemp[4], tResult[4];
+    multiplyQuaternion(tConjugate, tVector, tTemp);
+    multiplyQuaternion(tTemp, aQ, tResult);
+    for (int i = 0; i < 3; ++i) {
+        aSensor[i] = tResult[i + 1];
+    }
+}
+
+static double getAngleDegree(const double *aP, const double *aQ) {
+    double tDot = fabs(aP[0] * aQ[0] + aP[1] * aQ[1] + aP[2] * aQ[2] + aP[3] * aQ[3]);
+    if (tDot > 1) {
+        tDot = 1;
+    }
+    return 2 * acos(tDot) * 180 / M_PI;
+}
+
+static double gaussian(double aSigma) {
+    double tU1 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double tU2 = (rand() + 1.0) / (RAND_MAX + 2.0);
+    return aSigma * sqrt(-2 * log(tU1)) * cos(2 * M_PI * tU2);
+}
+
+/*
+ * One line of the log
+ */
+typedef struct {
+    double Seconds;
+    double Gyroscope[3];
+    double Accelerometer[3];
+    int16_t CompassRaw[3];
+    double TrueQ[4];
+    bool HasTruth;
+} LogEntryTypeDef;
+
+static const double sTrueGyroscopeBias[3] = { 0.02, -0.015, 0.01 }; // rad/s
+static const double sCompassOffset[3] = { 120, -80, 40 }; // raw hard iron offset
+static const double sCompassScale[3] = { 1.1, 0.9, 1.0 }; // soft iron
+static const double sEarthField[3] = { 200, 0, -430 }; // raw, inclination 65 degree
+static const double sGravity[3] = { 0, 0, 1 }; // accelerometer measures the reaction to gravity
+
+/*
+ * The angular rate is a sum of sines, so all directions are covered during calibration.
+ * After calibration the motion is slower, like holding the board for the mouse.
+ */
+static void getTrueRate(double aSeconds, double *aRate) {
+    double tAmplitude = aSeconds < CALIBRATION_SECONDS ? 2.0 : 0.5;
+    aRate[0] = tAmplitude * sin(2 * M_PI * 0.13 * aSeconds);
+    aRate[1] = tAmplitude * sin(2 * M_PI * 0.21 * aSeconds + 1);
+    aRate[2] = tAmplitude * sin(2 * M_PI * 0.07 * aSeconds + 2);
+}
+
+static LogEntryTypeDef *createSyntheticLog(int *aCount) {
+    int tCount = LOG_SECONDS * GYROSCOPE_RATE_HERTZ;
+    LogEntryTypeDef *tLog = (LogEntryTypeDef *) malloc(tCount * sizeof(LogEntryTypeDef));
+    double tQ[4] = { 1, 0, 0, 0 };
+    double tDelta = 1.0 / GYROSCOPE_RATE_HERTZ;
+    int16_t tCompassRaw[3] = { 0, 0, 0 };
+    double tAccelerometer[3] = { 0, 0, 1 };
+    int tCompassIndex = -1;
+    int tAccelerometerIndex = -1;
+    for (int i = 0; i < tCount; ++i) {
+        double tSeconds = i * tDelta;
+        double tRate[3];
+        getTrueRate(tSeconds, tRate);
+        // integrate with small steps, so the truth is exact compared to the filter
+        for (int j = 0; j < 10; ++j) {
+            double tStep[4] = { 1, tRate[0] * tDelta / 20, tRate[1] * tDelta / 20, tRate[2] * tDelta / 20 };
+            double tNew[4];
+            multiplyQuaternion(tQ, tStep, tNew);
+            normalize(tNew, 4);
+            for (int k = 0; k < 4; ++k) {
+                tQ[k] = tNew[k];
+            }
+        }
+        LogEntryTypeDef *tEntry = &tLog[i];
+        tEntry->Seconds = tSeconds;
+        for (int k = 0; k < 3; ++k) {
+            tEntry->Gyroscope[k] = tRate[k] + sTrueGyroscopeBias[k] + gaussian(0.005);
+        }
+        // accelerometer and compass update with their own rates, the latest value is used
+        if ((int) (tSeconds * ACCELEROMETER_RATE_HERTZ) != tAccelerometerIndex) {
+            tAccelerometerIndex = tSeconds * ACCELEROMETER_RATE_HERTZ;
+            earthToSensor(tQ, sGravity, tAccelerometer);
+            for (int k = 0; k < 3; ++k) {
+                tAccelerometer[k] += gaussian(0.01) + 0.02 * sin(2 * M_PI * 30 * tSeconds + k); // noise and vibration
+            }
+        }
+        if ((int) (tSeconds * COMPASS_RATE_HERTZ) != tCompassIndex) {
+            tCompassIndex = tSeconds * COMPASS_RATE_HERTZ;
+            double tField[3];
+            earthToSensor(tQ, sEarthField, tField);
+            for (int k = 0; k < 3; ++k) {
+                tCompassRaw[k] = lround(tField[k] * sCompassScale[k] + sCompassOffset[k] + gaussian(2));
+            }
+        }
+        for (int k = 0; k < 3; ++k) {
+            tEntry->Accelerometer[k] = tAccelerometer[k];
+            tEntry->CompassRaw[k] = tCompassRaw[k];
+        }
+        for (int k = 0; k < 4; ++k) {
+            tEntry->TrueQ[k] = tQ[k];
+        }
+        tEntry->HasTruth = true;
+    }
+    *aCount = tCount;
+    return tLog;
+}
+
+static LogEntryTypeDef *readLog(const char *aFileName, int *aCount) {
+    FILE *tFile = fopen(aFileName, "r");
+    if (tFile == NULL) {
+        perror(aFileName);
+        exit(1);
+    }
+    int tSize = 1024;
+    int tCount = 0;
+    LogEntryTypeDef *tLog = (LogEntryTypeDef *) malloc(tSize * sizeof(LogEntryTypeDef));
+    LogEntryTypeDef tEntry;
+    int tCompass[3];
+    while (fscanf(tFile, "%lf %lf %lf %lf %lf %lf %lf %d %d %d", &tEntry.Seconds, &tEntry.Gyroscope[0], &tEntry.Gyroscope[1],
+            &tEntry.Gyroscope[2], &tEntry.Accelerometer[0], &tEntry.Accelerometer[1], &tEntry.Accelerometer[2], &tCompass[0],
+            &tCompass[1], &tCompass[2]) == 10) {
+        for (int k = 0; k < 3; ++k) {
+            tEntry.CompassRaw[k] = tCompass[k];
+        }
+        tEntry.HasTruth = false;
+        if (tCount == tSize) {
+            tSize *= 2;
+            tLog = (LogEntryTypeDef *) realloc(tLog, tSize * sizeof(LogEntryTypeDef));
+        }
+        tLog[tCount++] = tEntry;
+    }
+    fclose(tFile);
+    *aCount = tCount;
+    return tLog;
+}
+
+int main(int argc, char *argv[]) {
+    srand(1);
+    int tCount;
+    LogEntryTypeDef *tLog;
+    if (argc > 1) {
+        tLog = readLog(argv[1], &tCount);
+        printf("%d entries read from %s\n", tCount, argv[1]);
+    } else {
+        tLog = createSyntheticLog(&tCount);
+        printf("Synthetic log of %d s with %d gyroscope samples\n", LOG_SECONDS, tCount);
+    }
+    if (tCount < 2) {
+        return 1;
+    }
+
+    // compass calibration with the first seconds of the log
+    CompassCalibrationTypeDef tCalibration;
+    CompassCalibration_init(&tCalibration);
+    CompassCalibration_start(&tCalibration);
+    for (int i = 0; i < tCount && tLog[i].Seconds - tLog[0].Seconds < CALIBRATION_SECONDS; ++i) {
+        CompassCalibration_addSample(&tCalibration, tLog[i].CompassRaw);
+    }
+    check(CompassCalibration_stop(&tCalibration), "compass calibration");
+    printf("Compass offset=%.1f %.1f %.1f scale=%.3f %.3f %.3f\n", tCalibration.Offset[0], tCalibration.Offset[1],
+            tCalibration.Offset[2], tCalibration.Scale[0], tCalibration.Scale[1], tCalibration.Scale[2]);
+
+    OrientationFilterTypeDef tFilter;
+    OrientationFilter_init(&tFilter);
+    ReferenceFilterTypeDef tReference = { { 1, 0, 0, 0 }, { 0, 0, 0 } };
+    double tMaxFloatToDouble = 0;
+    double tSquareErrorSum = 0;
+    double tMaxError = 0;
+    int tErrorCount = 0;
+    struct timespec tStart, tEnd;
+    double tNanosSum = 0;
+
+    for (int i = 1; i < tCount; ++i) {
+        LogEntryTypeDef *tEntry = &tLog[i];
+        float tDelta = tEntry->Seconds - tLog[i - 1].Seconds;
+        float tGyroscope[3], tAccelerometer[3], tCompass[3];
+        double tCompassDouble[3];
+        for (int k = 0; k < 3; ++k) {
+            tGyroscope[k] = tEntry->Gyroscope[k];
+            tAccelerometer[k] = tEntry->Accelerometer[k];
+        }
+        CompassCalibration_apply(&tCalibration, tEntry->CompassRaw, tCompass);
+        for (int k = 0; k < 3; ++k) {
+            tCompassDouble[k] = tCompass[k];
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &tStart);
+        OrientationFilter_update(&tFilter, tGyroscope, tAccelerometer, tCompass, tDelta);
+        clock_gettime(CLOCK_MONOTONIC, &tEnd);
+        tNanosSum += (tEnd.tv_sec - tStart.tv_sec) * 1e9 + (tEnd.tv_nsec - tStart.tv_nsec);
+
+        updateReference(&tReference, tEntry->Gyroscope, tEntry->Accelerometer, tCompassDouble, tEntry->Seconds - tLog[i - 1].Seconds);
+
+        double tFilterQ[4] = { tFilter.Q0, tFilter.Q1, tFilter.Q2, tFilter.Q3 };
+        double tFloatToDouble = getAngleDegree(tFilterQ, tReference.Q);
+        if (tFloatToDouble > tMaxFloatToDouble) {
+            tMaxFloatToDouble = tFloatToDouble;
+        }
+        if (tEntry->HasTruth && tEntry->Seconds > SETTLING_SECONDS) {
+            double tError = getAngleDegree(tFilterQ, tEntry->TrueQ);
+            tSquareErrorSum += tError * tError;
+            if (tError > tMaxError) {
+                tMaxError = tError;
+            }
+            tErrorCount++;
+        }
+    }
+
+    printf("Float to double reference: max %.4f degree\n", tMaxFloatToDouble);
+    check(tMaxFloatToDouble < MAX_FLOAT_TO_DOUBLE_DEGREE, "single precision deviates from double reference");
+    printf("Gyroscope bias: %.4f %.4f %.4f rad/s (reference %.4f %.4f %.4f)\n", tFilter.GyroscopeBias[0], tFilter.GyroscopeBias[1],
+            tFilter.GyroscopeBias[2], tReference.GyroscopeBias[0], tReference.GyroscopeBias[1], tReference.GyroscopeBias[2]);
+    if (tErrorCount > 0) {
+        double tRmsError = sqrt(tSquareErrorSum / tErrorCount);
+        printf("Error to true orientation after %d s: RMS %.2f max %.2f degree\n", SETTLING_SECONDS, tRmsError, tMaxError);
+        check(tRmsError < MAX_RMS_ERROR_DEGREE, "orientation error");
+        for (int k = 0; k < 3; ++k) {
+            check(fabs(tFilter.GyroscopeBias[k] - sTrueGyroscopeBias[k]) < MAX_BIAS_ERROR_RAD, "gyroscope bias not tracked");
+        }
+    }
+    printf("Host time per update: %.0f ns\n", tNanosSum / (tCount - 1));
+    printf("%d failed checks\n", sErrorCount);
+    free(tLog);
+    return sErrorCount;
+}
@@ -0,0 +1,247 @@
+/*
+ * @file ProfilerDecoder.cpp
+ *
+ * Host program, which converts the output of Profiler_dump() to the folded stack format of flamegraph.pl
+ * and prints the ISR statistics.
+ *
+ * Build: g++ -O2 -o ProfilerDecoder ProfilerDecoder.cpp
+ * Usage: ProfilerDecoder [CPU MHz] < dump.txt > profile.folded
+ *        flamegraph.pl --countname=cycles profile.folded > profile.svg
+ *
+ * Each folded line contains the stack of zones and ISRs active during a time interval, starting with "main" for thread mode,
+ * and the sum of cycles of these intervals. Lines of the dump may have a prefix, e.g. a time stamp of a terminal program.
+ * Zones, which are open at the start of the trace, because their begin was overwritten, start at the first record.
+ * Zones, which are open at the end, end at the last record.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#define HISTOGRAM_BUCKETS 16 // PROFILER_HISTOGRAM_BUCKETS
+
+struct TraceRecord {
+    int64_t Cycles; // without wrap around
+    bool IsBegin;
+    unsigned int Id;
+};
+
+struct IsrStatistics {
+    unsigned long Count;
+    unsigned long DurationMax;
+    unsigned long LatencyMax;
+    unsigned long DurationHistogram[HISTOGRAM_BUCKETS];
+    unsigned long LatencyHistogram[HISTOGRAM_BUCKETS];
+    bool HasLatency;
+};
+
+static std::map<unsigned int, std::string> sNames;
+static std::vector<TraceRecord> sRecords;
+static std::map<unsigned int, IsrStatistics> sIsrStatistics;
+static unsigned long sRecordsLost;
+
+static std::string getName(unsigned int aId) {
+    std::map<unsigned int, std::string>::iterator tIterator = sNames.find(aId);
+    if (tIterator == sNames.end()) {
+        return "Id" + std::to_string(aId);
+    }
+    return tIterator->second;
+}
+
+/*
+ * Finds the record type character followed by a blank, skipping any prefix
+ */
+static const char* findRecord(const char *aLine) {
+    for (const char *tPointer = aLine; *tPointer != '\0'; ++tPointer) {
+        if (strchr("NTSDLX", *tPointer) != NULL && tPointer[1] == ' ' && (tPointer == aLine || tPointer[-1] == ' ')) {
+            return tPointer;
+        }
+    }
+    return NULL;
+}
+
+static void readHistogram(const char *aArguments, unsigned long *aHistogram) {
+    char *tEnd;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        aHistogram[i] = strtoul(aArguments, &tEnd, 10);
+        aArguments = tEnd;
+    }
+}
+
+static void readDump(FILE *aFile) {
+    char tLine[256];
+    uint32_t tLastCycles = 0;
+    int64_t tCycles = 0;
+    while (fgets(tLine, sizeof(tLine), aFile) != NULL) {
+        const char *tRecord = findRecord(tLine);
+        if (tRecord == NULL) {
+            continue;
+        }
+        char tType = tRecord[0];
+        const char *tArguments = &tRecord[2];
+        char *tEnd;
+        if (tType == 'N') {
+            unsigned int tId = strtoul(tArguments, &tEnd, 10);
+            char tName[64];
+            if (sscanf(tEnd, "%63s", tName) == 1) {
+                sNames[tId] = tName;
+            }
+        } else if (tType == 'T') {
+            uint32_t tRecordCycles = strtoul(tArguments, &tEnd, 16);
+            char tBeginOrEnd;
+            unsigned int tId;
+            if (sscanf(tEnd, " %c %u", &tBeginOrEnd, &tId) != 2) {
+                continue;
+            }
+            // unwrap the 32 bit counter by the signed difference to the previous record
+            if (sRecords.empty()) {
+                tCycles = tRecordCycles;
+            } else {
+                tCycles += (int32_t) (tRecordCycles - tLastCycles);
+            }
+            tLastCycles = tRecordCycles;
+            sRecords.push_back( { tCycles, tBeginOrEnd == 'B', tId });
+        } else if (tType == 'S') {
+            unsigned int tIsr = strtoul(tArguments, &tEnd, 10);
+            IsrStatistics &tStatistics = sIsrStatistics[tIsr];
+            sscanf(tEnd, "%lu %lu %lu", &tStatistics.Count, &tStatistics.DurationMax, &tStatistics.LatencyMax);
+        } else if (tType == 'D' || tType == 'L') {
+            unsigned int tIsr = strtoul(tArguments, &tEnd, 10);
+            IsrStatistics &tStatistics = sIsrStatistics[tIsr];
+            if (tType == 'D') {
+                readHistogram(tEnd, tStatistics.DurationHistogram);
+            } else {
+                readHistogram(tEnd, tStatistics.LatencyHistogram);
+                tStatistics.HasLatency = true;
+            }
+        } else if (tType == 'X') {
+            sRecordsLost = strtoul(tArguments, NULL, 10);
+        }
+    }
+}
+
+/*
+ * An ISR can interrupt a writer between reserving its record and reading the cycle counter,
+ * so the records are sorted by cycles. Then begin records are added at the start for ends without begin.
+ */
+static void prepareRecords(void) {
+    std::stable_sort(sRecords.begin(), sRecords.end(), [](const TraceRecord &a, const TraceRecord &b) {
+        return a.Cycles < b.Cycles;
+    });
+    std::vector<unsigned int> tStack;
+    std::vector<unsigned int> tUnmatchedEnds; // innermost first
+    for (const TraceRecord &tRecord : sRecords) {
+        if (tRecord.IsBegin) {
+            tStack.push_back(tRecord.Id);
+        } else if (!tStack.empty() && tStack.back() == tRecord.Id) {
+            tStack.pop_back();
+        } else if (std::find(tStack.begin(), tStack.end(), tRecord.Id) != tStack.end()) {
+            // end of inner zones is missing
+            while (tStack.back() != tRecord.Id) {
+                tStack.pop_back();
+            }
+            tStack.pop_back();
+        } else {
+            tUnmatchedEnds.push_back(tRecord.Id);
+        }
+    }
+    if (!sRecords.empty()) {
+        int64_t tStartCycles = sRecords.front().Cycles;
+        for (unsigned int tId : tUnmatchedEnds) {
+            sRecords.insert(sRecords.begin(), { tStartCycles, true, tId });
+        }
+    }
+}
+
+/*
+ * Adds the cycles between 2 records to the current stack
+ */
+static void foldRecords(std::map<std::string, int64_t> &aFoldedStacks) {
+    std::vector<unsigned int> tStack;
+    int64_t tLastCycles = sRecords.empty() ? 0 : sRecords.front().Cycles;
+    for (const TraceRecord &tRecord : sRecords) {
+        int64_t tDelta = tRecord.Cycles - tLastCycles;
+        if (tDelta > 0) {
+            std::string tKey = "main";
+            for (unsigned int tId : tStack) {
+                tKey += ";" + getName(tId);
+            }
+            aFoldedStacks[tKey] += tDelta;
+        }
+        tLastCycles = tRecord.Cycles;
+        if (tRecord.IsBegin) {
+            tStack.push_back(tRecord.Id);
+        } else {
+            std::vector<unsigned int>::iterator tIterator = std::find(tStack.begin(), tStack.end(), tRecord.Id);
+            if (tIterator != tStack.end()) {
+                tStack.erase(tIterator, tStack.end());
+            }
+        }
+    }
+}
+
+static void printHistogram(const char *aTitle, const unsigned long *aHistogram, double aCyclesPerMicro) {
+    fprintf(stderr, "  %s\n", aTitle);
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        if (aHistogram[i] == 0) {
+            continue;
+        }
+        unsigned long tFrom = (i == 0) ? 0 : (1UL << (i + 3));
+        if (i == HISTOGRAM_BUCKETS - 1) {
+            fprintf(stderr, "    >= %7lu cycles %9.2f us: %lu\n", tFrom, tFrom / aCyclesPerMicro, aHistogram[i]);
+        } else {
+            unsigned long tTo = (1UL << (i + 4)) - 1;
+            fprintf(stderr, "    %6lu-%6lu cycles %8.2f-%8.2f us: %lu\n", tFrom, tTo, tFrom / aCyclesPerMicro,
+                    tTo / aCyclesPerMicro, aHistogram[i]);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    double tCyclesPerMicro = 72.0;
+    if (argc > 1) {
+        tCyclesPerMicro = atof(argv[1]);
+        if (tCyclesPerMicro <= 0) {
+            fprintf(stderr, "Usage: %s [CPU MHz] < dump > folded\n", argv[0]);
+            return 1;
+        }
+    }
+    readDump(stdin);
+    prepareRecords();
+
+    std::map<std::string, int64_t> tFoldedStacks;
+    foldRecords(tFoldedStacks);
+    for (const std::pair<const std::string, int64_t> &tEntry : tFoldedStacks) {
+        printf("%s %lld\n", tEntry.first.c_str(), (long long) tEntry.second);
+    }
+
+    int64_t tTraceCycles = sRecords.empty() ? 0 : sRecords.back().Cycles - sRecords.front().Cycles;
+    fprintf(stderr, "%zu records, %lu lost, %lld cycles = %.1f us\n", sRecords.size(), sRecordsLost, (long long) tTraceCycles,
+            tTraceCycles / tCyclesPerMicro);
+    for (const std::pair<const unsigned int, IsrStatistics> &tEntry : sIsrStatistics) {
+        const IsrStatistics &tStatistics = tEntry.second;
+        fprintf(stderr, "%s: count=%lu duration max=%lu cycles %.2f us", getName(tEntry.first).c_str(), tStatistics.Count,
+                tStatistics.DurationMax, tStatistics.DurationMax / tCyclesPerMicro);
+        if (tStatistics.HasLatency) {
+            fprintf(stderr, " latency max=%lu cycles %.2f us", tStatistics.LatencyMax, tStatistics.LatencyMax / tCyclesPerMicro);
+        }
+        fprintf(stderr, "\n");
+        printHistogram("duration", tStatistics.DurationHistogram, tCyclesPerMicro);
+        if (tStatistics.HasLatency) {
+            printHistogram("latency", tStatistics.LatencyHistogram, tCyclesPerMicro);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * @file ProfilerSimulation.cpp
+ *
+ * Host test of the profiler src/Profiler.hpp with a simulated cycle counter, which wraps around during the test.
+ * 100 loops of the DSO zone with drawing, a SysTick with delay callbacks in the drawing zone,
+ * an ADC ISR and a SysTick interrupted by the ADC ISR are recorded. Each loop writes 14 trace records,
+ * so the ring of 1024 records overflows.
+ * Before the loops, one PendSV with 2 zones in one block is recorded, which also checks that
+ * PROFILER_ZONE() can be used twice in one block and nested without shadowing (-Wshadow).
+ *
+ * Checks:
+ * - Count, max duration, max latency and duration histogram of the SysTick, ADC and PendSV ISRs.
+ * - Number of records lost by the ring overflow.
+ * - The dumped records are in the order of the simulated cycles, also across the counter wrap around.
+ *
+ * The dump can be decoded by extras/ProfilerDecoder.cpp. The ring holds 73 complete loops, so the folded stacks must be
+ * 73 times the cycles per loop: main;DSOLoop 2000, main;DSOLoop;ADC 100, main;DSOLoop;DSODraw 2500,
+ * main;DSOLoop;DSODraw;SysTick 300, main;DSOLoop;DSODraw;SysTick;DelayCallbacks 200, main;DSOLoop;SysTick 200
+ * and main;DSOLoop;SysTick;ADC 100. main;DSOLoop gets 1000 cycles more from the partial loop at the start of the ring.
+ *
+ * Build from the repository root:
+ * g++ -O2 -Wshadow -Isrc -Ilib/include -o ProfilerSimulation extras/ProfilerSimulation.cpp
+ * Usage: ProfilerSimulation [dump file]
+ *        ProfilerDecoder < dump file
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+static uint32_t sSimulatedCycles = 0xFFFFF000; // wraps around in the first loop
+#define PROFILER_GET_CYCLES()   (sSimulatedCycles)
+#define PROFILER_TRACE_SIZE     1024
+#include "Profiler.hpp"
+
+#define NUMBER_OF_LOOPS         100
+#define RECORDS_PER_LOOP        14
+#define RECORDS_OF_PENDSV       6
+#define SYSTICK_LATENCY_CYCLES  12
+#define SYSTICK_LATENCY_CYCLES_NESTED 40
+
+static FILE *sDumpFile;
+static uint32_t sLastDumpedCycles;
+static uint32_t sDumpedRecords;
+static uint32_t sRecordsLost;
+static bool sIsDumpOrdered = true;
+static void run(uint32_t aCycles) {
+    sSimulatedCycles += aCycles;
+}
+
+static void simulateSysTick(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_SYSTICK, SYSTICK_LATENCY_CYCLES);
+    run(300);
+    {
+        PROFILER_ZONE(PROFILER_ZONE_DELAY_CALLBACKS);
+        run(200);
+    }
+    PROFILER_ISR_EXIT(PROFILER_ISR_SYSTICK);
+}
+
+static void simulatePendSV(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_PENDSV, PROFILER_LATENCY_UNKNOWN);
+    {
+        PROFILER_ZONE(PROFILER_ZONE_DELAY_CALLBACKS);
+        run(100);
+        PROFILER_ZONE(PROFILER_ZONE_DSO_DRAW);
+        run(50);
+    }
+    PROFILER_ISR_EXIT(PROFILER_ISR_PENDSV);
+}
+
+static void simulateADC(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_ADC, PROFILER_LATENCY_UNKNOWN);
+    run(100);
+    PROFILER_ISR_EXIT(PROFILER_ISR_ADC);
+}
+
+/*
+ * Checks the trace lines and writes all lines to the dump file
+ */
+static void writeDumpLine(const char *aString, uint8_t aLength) {
+    if (sDumpFile != NULL) {
+        fwrite(aString, 1, aLength, sDumpFile);
+    }
+    if (aString[0] == 'T') {
+        uint32_t tCycles = strtoul(&aString[2], NULL, 16);
+        // unsigned difference handles the wrap around
+        if (sDumpedRecords > 0 && tCycles - sLastDumpedCycles > 0x80000000) {
+            sIsDumpOrdered = false;
+        }
+        sLastDumpedCycles = tCycles;
+        sDumpedRecords++;
+    } else if (aString[0] == 'X') {
+        sRecordsLost = strtoul(&aString[2], NULL, 10);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1) {
+        sDumpFile = fopen(argv[1], "w");
+        if (sDumpFile == NULL) {
+            printf("Cannot open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    Profiler_start();
+    simulatePendSV();
+    for (int i = 0; i < NUMBER_OF_LOOPS; ++i) {
+        PROFILER_ZONE(PROFILER_ZONE_DSO_LOOP);
+        run(1000);
+        simulateADC();
+        {
+            PROFILER_ZONE(PROFILER_ZONE_DSO_DRAW);
+            run(2000);
+            simulateSysTick();
+            run(500);
+        }
+        {
+            // ADC interrupts SysTick
+            PROFILER_ISR_ENTER(PROFILER_ISR_SYSTICK, SYSTICK_LATENCY_CYCLES_NESTED);
+            run(100);
+            simulateADC();
+            run(100);
+            PROFILER_ISR_EXIT(PROFILER_ISR_SYSTICK);
+        }
+        run(1000);
+    }
+    Profiler_stop();
+    // not recorded after stop
+    simulateADC();
+    Profiler_dump(&writeDumpLine);
+    if (sDumpFile != NULL) {
+        fclose(sDumpFile);
+    }
+
+    const ProfilerIsrStatisticsStruct *tSysTick = Profiler_getIsrStatistics(PROFILER_ISR_SYSTICK);
+    const ProfilerIsrStatisticsStruct *tADC = Profiler_getIsrStatistics(PROFILER_ISR_ADC);
+    const ProfilerIsrStatisticsStruct *tPendSV = Profiler_getIsrStatistics(PROFILER_ISR_PENDSV);
+    printf("SysTick: %lu calls, max %lu cycles, max latency %lu cycles\n", (unsigned long) tSysTick->Count,
+            (unsigned long) tSysTick->DurationMax, (unsigned long) tSysTick->LatencyMax);
+    printf("ADC: %lu calls, max %lu cycles\n", (unsigned long) tADC->Count, (unsigned long) tADC->DurationMax);
+    printf("%lu records written, %lu dumped, %lu lost\n", (unsigned long) Profiler_getNumberOfTraceRecords(),
+            (unsigned long) sDumpedRecords, (unsigned long) sRecordsLost);
+
+    check(tSysTick->Count == 2 * NUMBER_OF_LOOPS && tSysTick->DurationMax == 500
+            && tSysTick->LatencyMax == SYSTICK_LATENCY_CYCLES_NESTED, "SysTick statistics");
+    // 300 and 500 cycles are both in bucket 5 (256 to 511 cycles), 12 and 40 cycles latency in bucket 0 and 2
+    check(tSysTick->DurationHistogram[5] == 2 * NUMBER_OF_LOOPS && tSysTick->LatencyHistogram[0] == NUMBER_OF_LOOPS
+            && tSysTick->LatencyHistogram[2] == NUMBER_OF_LOOPS, "SysTick histograms");
+    check(tADC->Count == 2 * NUMBER_OF_LOOPS && tADC->DurationMax == 100 && tADC->LatencyMax == 0, "ADC statistics");
+    check(tPendSV->Count == 1 && tPendSV->DurationMax == 150 && tPendSV->DurationHistogram[4] == 1, "PendSV statistics");
+    check(Profiler_getNumberOfTraceRecords() == RECORDS_OF_PENDSV + RECORDS_PER_LOOP * NUMBER_OF_LOOPS, "records written");
+    check(sDumpedRecords == PROFILER_TRACE_SIZE
+            && sRecordsLost == RECORDS_OF_PENDSV + RECORDS_PER_LOOP * NUMBER_OF_LOOPS - PROFILER_TRACE_SIZE,
+            "records lost by ring overflow");
+    check(sIsDumpOrdered, "dumped records not in order of cycles");
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
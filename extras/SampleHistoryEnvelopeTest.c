@@ -0,0 +1,279 @@
+/*
+ * @file SampleHistoryEnvelopeTest.c
+ *
+ * Host test of SampleHistory_readEnvelope() of sampleHistory.c on the SPI level card simulator mmc_sim.c.
+ * A long measurement with short voltage dips and ESR peaks is appended, so that most blocks are spilled to the history file.
+ * Each envelope is compared with the brute force minimum and maximum of the appended samples.
+ *
+ * Checks:
+ * - Envelopes of both channels for even and odd aHalfSamplesPerColumn from 1 sample per column up to more than
+ *   one block per column, starting at index 0, inside a spilled block, at a block start and in the RAM blocks.
+ * - Large compressions take whole blocks from the block envelope.
+ * - Columns starting at a block start and ending 1 sample before, at and 1 sample after the block end.
+ * - After SampleHistory_restore() of a history stored while samples were appended, the envelope of the last block
+ *   contains only the stored samples, also when this block is taken from the block envelope after appending.
+ * - Redrawing only the new columns like drawHistoryChannel() of AccuCapacity gives the same columns as a full redraw.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o SampleHistoryEnvelopeTest extras/SampleHistoryEnvelopeTest.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c
+ *     lib/fat_sd/writeBehind.c lib/fat_sd/sampleHistory.c
+ * Usage: SampleHistoryEnvelopeTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "sampleHistory.h"
+#include "writeBehind.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define SAMPLE_COUNT        20000   // spills most of the blocks
+#define GUI_LOOP_MICROS     1000    // simulated duration of the rest of the page loop
+#define CHART_WIDTH         220     // columns of the AccuCapacity chart
+#define HISTORY_FILE_NAME   "channel0_history.bin"
+
+static SampleHistoryTypeDef sHistory;
+static uint16_t sValues[SAMPLE_HISTORY_NUMBER_OF_CHANNELS][SAMPLE_COUNT];
+static int sCompareCount;
+
+/*
+ * The loop of any page, which calls the main loop callback serviceAccuCapacity()
+ */
+static void runPageLoop(void) {
+    SampleHistory_service(&sHistory);
+    WriteBehind_service();
+    HostPlatform_spendMicros(GUI_LOOP_MICROS);
+}
+
+static bool append(int aIndex, uint16_t aVoltage, uint16_t aESR) {
+    sValues[0][aIndex] = aVoltage;
+    sValues[1][aIndex] = aESR;
+    bool tIsAppended = SampleHistory_append(&sHistory, aVoltage, aESR);
+    runPageLoop();
+    return tIsAppended;
+}
+
+/*
+ * Discharge curve with noise, repeated values, dips of 1 to 3 samples and ESR peaks
+ */
+static void measure(int aCount) {
+    SampleHistory_clear(&sHistory);
+    bool tIsAppended = true;
+    for (int i = 0; i < aCount; ++i) {
+        uint16_t tVoltage = 4150 - (i / 16) + (rand() % 8);
+        uint16_t tESR = 150 + (i / 500) + ((i % 7) == 0);
+        int tRandom = rand() % 300;
+        if (tRandom < 2) {
+            tVoltage -= 200 + rand() % 500;
+        } else if (tRandom < 4) {
+            tESR += 100 + rand() % 2000;
+        } else if (tRandom < 150 && i > 0) {
+            tVoltage = sValues[0][i - 1];
+            tESR = sValues[1][i - 1];
+        }
+        tIsAppended &= append(i, tVoltage, tESR);
+    }
+    check(tIsAppended, "SampleHistory_append");
+    WriteBehind_waitForCompletion(1000);
+}
+
+/*
+ * Column N contains the samples from aStartIndex + (N * aHalfSamplesPerColumn) / 2 up to the start of column N + 1
+ */
+static UINT getBruteForceEnvelope(uint16_t aSampleCount, uint16_t aStartIndex, uint16_t aHalfSamplesPerColumn,
+        UINT aColumns, uint8_t aChannel, uint16_t *aMinValues, uint16_t *aMaxValues) {
+    UINT tColumn;
+    for (tColumn = 0; tColumn < aColumns; ++tColumn) {
+        uint32_t tSampleIndex = aStartIndex + ((tColumn * (uint32_t) aHalfSamplesPerColumn) / 2);
+        uint32_t tColumnEnd = aStartIndex + (((tColumn + 1) * (uint32_t) aHalfSamplesPerColumn) / 2);
+        if (tColumnEnd > aSampleCount) {
+            tColumnEnd = aSampleCount;
+        }
+        if (tSampleIndex >= tColumnEnd) {
+            break;
+        }
+        uint16_t tMin = 0xFFFF;
+        uint16_t tMax = 0;
+        for (; tSampleIndex < tColumnEnd; ++tSampleIndex) {
+            uint16_t tValue = sValues[aChannel][tSampleIndex];
+            if (tValue < tMin) {
+                tMin = tValue;
+            }
+            if (tValue > tMax) {
+                tMax = tValue;
+            }
+        }
+        aMinValues[tColumn] = tMin;
+        aMaxValues[tColumn] = tMax;
+    }
+    return tColumn;
+}
+
+static bool isEnvelopeCorrect(uint16_t aStartIndex, uint16_t aHalfSamplesPerColumn, UINT aColumns) {
+    static uint16_t sMinValues[CHART_WIDTH], sMaxValues[CHART_WIDTH];
+    static uint16_t sExpectedMinValues[CHART_WIDTH], sExpectedMaxValues[CHART_WIDTH];
+    for (uint8_t tChannel = 0; tChannel < SAMPLE_HISTORY_NUMBER_OF_CHANNELS; ++tChannel) {
+        UINT tColumns = SampleHistory_readEnvelope(&sHistory, aStartIndex, aHalfSamplesPerColumn, aColumns, tChannel,
+                sMinValues, sMaxValues);
+        UINT tExpectedColumns = getBruteForceEnvelope(sHistory.SampleCount, aStartIndex, aHalfSamplesPerColumn, aColumns,
+                tChannel, sExpectedMinValues, sExpectedMaxValues);
+        sCompareCount++;
+        if (tColumns != tExpectedColumns || memcmp(sMinValues, sExpectedMinValues, tColumns * sizeof(uint16_t)) != 0
+                || memcmp(sMaxValues, sExpectedMaxValues, tColumns * sizeof(uint16_t)) != 0) {
+            printf("Start %u, half samples per column %u, channel %u: %u columns, expected %u\n", aStartIndex,
+                    aHalfSamplesPerColumn, tChannel, tColumns, tExpectedColumns);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void checkCompressions(void) {
+    static const uint16_t sHalfSamplesPerColumn[] = { 2, 3, 4, 5, 7, 10, 21, 40, 99, 400, 1001, 2000 };
+    uint16_t tRAMStart = sHistory.BlockFirstSample[sHistory.FirstRAMBlock];
+    const uint16_t tStartIndexes[] = { 0, 1, 137, sHistory.BlockFirstSample[3], sHistory.BlockFirstSample[3] + 1,
+            (uint16_t) (tRAMStart - 5), tRAMStart, (uint16_t) (sHistory.SampleCount - 50) };
+    uint32_t tBlocksSkipped = SampleHistory_getStatistics()->BlocksSkipped;
+    uint32_t tBlocksLoaded = SampleHistory_getStatistics()->BlocksLoaded;
+    bool tIsCorrect = true;
+    for (unsigned int i = 0; i < sizeof(sHalfSamplesPerColumn) / sizeof(sHalfSamplesPerColumn[0]); ++i) {
+        for (unsigned int j = 0; j < sizeof(tStartIndexes) / sizeof(tStartIndexes[0]); ++j) {
+            tIsCorrect &= isEnvelopeCorrect(tStartIndexes[j], sHalfSamplesPerColumn[i], CHART_WIDTH);
+        }
+    }
+    check(tIsCorrect, "envelope differs from brute force");
+    tBlocksSkipped = SampleHistory_getStatistics()->BlocksSkipped - tBlocksSkipped;
+    tBlocksLoaded = SampleHistory_getStatistics()->BlocksLoaded - tBlocksLoaded;
+    printf("%d envelopes of %u spilled and %u RAM blocks: %lu blocks skipped, %lu blocks loaded\n", sCompareCount,
+            sHistory.FirstRAMBlock, sHistory.BlockCount - sHistory.FirstRAMBlock, (unsigned long) tBlocksSkipped,
+            (unsigned long) tBlocksLoaded);
+    check(tBlocksSkipped > 0, "no block taken from block envelope");
+    check(tBlocksLoaded > 0, "no block loaded from history file");
+}
+
+/*
+ * The first column covers the block except its last sample, the whole block, or the block and the first sample of the next one
+ */
+static void checkBlockBorders(void) {
+    bool tIsCorrect = true;
+    for (uint16_t tBlockNumber = 1; tBlockNumber + 1 < sHistory.BlockCount; tBlockNumber += 5) {
+        uint16_t tStartIndex = sHistory.BlockFirstSample[tBlockNumber];
+        uint16_t tBlockSamples = sHistory.BlockFirstSample[tBlockNumber + 1] - tStartIndex;
+        for (uint16_t tHalfSamplesPerColumn = 2 * tBlockSamples - 2; tHalfSamplesPerColumn <= 2 * tBlockSamples + 3;
+                ++tHalfSamplesPerColumn) {
+            tIsCorrect &= isEnvelopeCorrect(tStartIndex, tHalfSamplesPerColumn, 3);
+        }
+    }
+    check(tIsCorrect, "envelope at block borders differs from brute force");
+}
+
+/*
+ * The structure is stored by reference while the ISR appends. So the stored structure may contain
+ * the samples up to aSampleCount, but the block data and the envelope of the last block contain later samples too.
+ * A dip and a peak after aSampleCount must not appear in the restored history.
+ */
+static void checkRestore(int aSampleCount, int aLaterSamples) {
+    measure(aSampleCount);
+    uint16_t tLastBlockNumber = sHistory.BlockCount - 1;
+    for (int i = aSampleCount; i < aSampleCount + aLaterSamples; ++i) {
+        append(i, (i == aSampleCount) ? 1000 : sValues[0][i - 1], (i == aSampleCount) ? 9000 : sValues[1][i - 1]);
+    }
+    WriteBehind_waitForCompletion(1000);
+    static SampleHistoryTypeDef sStoredHistory;
+    memcpy(&sStoredHistory, &sHistory, sizeof(sHistory));
+    sStoredHistory.SampleCount = aSampleCount;
+    memcpy(&sHistory, &sStoredHistory, sizeof(sHistory));
+    SampleHistory_restore(&sHistory);
+    SampleHistoryEnvelopeTypeDef *tEnvelope = &sHistory.BlockEnvelopes[tLastBlockNumber];
+    check(sHistory.BlockCount == tLastBlockNumber + 1 && tEnvelope->Min[0] > 1000 && tEnvelope->Max[1] < 9000,
+            "envelope of last block contains samples appended after store");
+
+    // the restored last block is closed by appending and then taken from its envelope
+    uint32_t tBlocksSkipped = SampleHistory_getStatistics()->BlocksSkipped;
+    for (int i = aSampleCount; i < aSampleCount + 300; ++i) {
+        append(i, sValues[0][i - 1] - 1, sValues[1][i - 1]);
+    }
+    WriteBehind_waitForCompletion(1000);
+    check(isEnvelopeCorrect(0, 2000, CHART_WIDTH) && isEnvelopeCorrect(sHistory.BlockFirstSample[tLastBlockNumber], 1001, 10),
+            "envelope after restore differs from brute force");
+    check(SampleHistory_getStatistics()->BlocksSkipped > tBlocksSkipped, "restored last block not taken from block envelope");
+}
+
+/*
+ * Like drawHistoryChannel() of AccuCapacity, after each sample only the last drawn and the new columns are read
+ * and stored at their position of the chart
+ */
+static void checkIncrementalRedraw(uint16_t aHalfSamplesPerColumn, uint16_t aStartIndex) {
+    static uint16_t sChartMinValues[CHART_WIDTH], sChartMaxValues[CHART_WIDTH];
+    static uint16_t sExpectedMinValues[CHART_WIDTH], sExpectedMaxValues[CHART_WIDTH];
+    measure(aStartIndex + 1);
+    UINT tColumnsDrawn = 0;
+    bool tIsCorrect = true;
+    for (int i = aStartIndex + 1; i < aStartIndex + (CHART_WIDTH * aHalfSamplesPerColumn) / 2 + 10; ++i) {
+        append(i, 4000 - (i / 16) + (rand() % 8) - ((rand() % 100) == 0) * 300, 150 + ((rand() % 100) == 0) * 500);
+        UINT tFirstColumn = 0;
+        if (tColumnsDrawn > 1) {
+            tFirstColumn = tColumnsDrawn - 2;
+            if (aHalfSamplesPerColumn & 0x01) {
+                tFirstColumn &= ~0x01;
+            }
+        }
+        if (tFirstColumn >= CHART_WIDTH) {
+            continue;
+        }
+        UINT tColumns = SampleHistory_readEnvelope(&sHistory, aStartIndex + ((tFirstColumn * aHalfSamplesPerColumn) / 2),
+                aHalfSamplesPerColumn, CHART_WIDTH - tFirstColumn, 0, &sChartMinValues[tFirstColumn],
+                &sChartMaxValues[tFirstColumn]);
+        tColumnsDrawn = tFirstColumn + tColumns;
+
+        UINT tExpectedColumns = getBruteForceEnvelope(sHistory.SampleCount, aStartIndex, aHalfSamplesPerColumn, CHART_WIDTH, 0,
+                sExpectedMinValues, sExpectedMaxValues);
+        if (tColumnsDrawn != tExpectedColumns
+                || memcmp(sChartMinValues, sExpectedMinValues, tColumnsDrawn * sizeof(uint16_t)) != 0
+                || memcmp(sChartMaxValues, sExpectedMaxValues, tColumnsDrawn * sizeof(uint16_t)) != 0) {
+            printf("Half samples per column %u: %u columns after sample %d, expected %u\n", aHalfSamplesPerColumn,
+                    tColumnsDrawn, i, tExpectedColumns);
+            tIsCorrect = false;
+            break;
+        }
+    }
+    check(tIsCorrect, "incremental redraw differs from full redraw");
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    SampleHistory_init(&sHistory, HISTORY_FILE_NAME);
+    srand(11);
+
+    measure(SAMPLE_COUNT);
+    check(sHistory.FirstRAMBlock > 0, "no block of history spilled");
+    checkCompressions();
+    checkBlockBorders();
+
+    // stored in the middle of the last block and after a new block was started by the later samples
+    checkRestore(5000, 20);
+    checkRestore(5000, 600);
+
+    checkIncrementalRedraw(2, 0);
+    checkIncrementalRedraw(3, 0);
+    checkIncrementalRedraw(5, 1000);
+    checkIncrementalRedraw(20, 3000);
+    checkIncrementalRedraw(41, 17);
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,176 @@
+/*
+ * @file SampleHistoryStoreTest.c
+ *
+ * Host test of storing and loading a sample history of sampleHistory.c on the SPI level card simulator mmc_sim.c,
+ * like doStoreLoadChartToFile() of AccuCapacity does it.
+ * A history of a long measurement, of which most blocks are spilled to the history file, is stored
+ * by the write behind queue. Then a second measurement overwrites the history file.
+ * The stored file is loaded and all samples must be the ones of the first measurement.
+ * Finally a truncated stored file must be rejected.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o SampleHistoryStoreTest extras/SampleHistoryStoreTest.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c
+ *     lib/fat_sd/writeBehind.c lib/fat_sd/sampleHistory.c
+ * Usage: SampleHistoryStoreTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "sampleHistory.h"
+#include "writeBehind.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define SAMPLE_COUNT        4000    // more than the RAM blocks of the history can hold
+#define GUI_LOOP_MICROS     1000    // simulated duration of the rest of the page loop
+#define HISTORY_FILE_NAME   "channel0_history.bin"
+
+static SampleHistoryTypeDef sHistory;
+static uint16_t sVoltage[SAMPLE_COUNT];
+static uint16_t sESR[SAMPLE_COUNT];
+static int sCallbackCount;
+static FRESULT sCallbackResult;
+static void callbackCompleted(FRESULT aResult, void *aContext) {
+    (void) aContext;
+    sCallbackCount++;
+    sCallbackResult = aResult;
+}
+
+/*
+ * The loop of any page, which calls the main loop callback serviceAccuCapacity()
+ */
+static void runPageLoop(void) {
+    SampleHistory_service(&sHistory);
+    WriteBehind_service();
+    HostPlatform_spendMicros(GUI_LOOP_MICROS);
+}
+
+static void measure(uint16_t aStartVoltage) {
+    SampleHistory_clear(&sHistory);
+    bool tIsAppended = true;
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        sVoltage[i] = aStartVoltage - (i / 4) + (rand() % 40);
+        sESR[i] = 150 + (i / 100) + (rand() % 3);
+        tIsAppended &= SampleHistory_append(&sHistory, sVoltage[i], sESR[i]);
+        runPageLoop();
+    }
+    check(tIsAppended, "SampleHistory_append");
+    WriteBehind_waitForCompletion(1000);
+    check(sHistory.FirstRAMBlock > 0, "no block of history spilled");
+}
+
+static bool isHistoryEqualToSamples(void) {
+    SampleHistoryCursorTypeDef tCursor;
+    if (sHistory.SampleCount != SAMPLE_COUNT || SampleHistory_seek(&tCursor, &sHistory, 0) != FR_OK) {
+        return false;
+    }
+    for (int i = 0; i < SAMPLE_COUNT; ++i) {
+        if (SampleHistory_next(&tCursor) != FR_OK || tCursor.Values[0] != sVoltage[i] || tCursor.Values[1] != sESR[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void store(const char *aFileName) {
+    sCallbackCount = 0;
+    WriteBehind_resetStatistics();
+    uint8_t tFileHandle = WriteBehind_open(aFileName);
+    check(WriteBehind_writeReference(tFileHandle, &sHistory, sizeof(sHistory))
+                    && SampleHistory_writeSpilledBlocks(&sHistory, tFileHandle), "queue store");
+    WriteBehind_close(tFileHandle, &callbackCompleted, NULL);
+    int tLoops = 0;
+    while (WriteBehind_getQueueDepth() > 0) {
+        runPageLoop();
+        tLoops++;
+    }
+    printf("Store of %u spilled and %u RAM blocks: %d loops, loop blocked for max %lu us\n", sHistory.FirstRAMBlock,
+            sHistory.BlockCount - sHistory.FirstRAMBlock, tLoops, (unsigned long) WriteBehind_getStatistics()->ServiceMicrosMax);
+    check(sCallbackCount == 1 && sCallbackResult == FR_OK && SampleHistory_getCopyResult() == FR_OK, "store completed");
+    HostPlatform_printCardStatistics("store");
+}
+
+static FRESULT load(const char *aFileName) {
+    FIL tFile;
+    UINT tCount;
+    FRESULT tResult = f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ);
+    if (tResult == FR_OK) {
+        f_read(&tFile, &sHistory, sizeof(sHistory), &tCount);
+        tResult = SampleHistory_loadSpilledBlocks(&sHistory, HISTORY_FILE_NAME, &tFile);
+        f_close(&tFile);
+        SampleHistory_restore(&sHistory);
+    }
+    HostPlatform_printCardStatistics("load");
+    return tResult;
+}
+
+/*
+ * Copies the first aLength bytes of the stored file
+ */
+static void truncateFile(const char *aFileName, const char *aTruncatedFileName, DWORD aLength) {
+    FIL tFile, tTruncatedFile;
+    UINT tCount;
+    static uint8_t tBuffer[_MAX_SS];
+    f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ);
+    f_open(&tTruncatedFile, aTruncatedFileName, FA_CREATE_ALWAYS | FA_WRITE);
+    while (aLength > 0) {
+        UINT tLength = (aLength > sizeof(tBuffer)) ? sizeof(tBuffer) : aLength;
+        f_read(&tFile, tBuffer, tLength, &tCount);
+        f_write(&tTruncatedFile, tBuffer, tLength, &tCount);
+        aLength -= tLength;
+    }
+    f_close(&tFile);
+    f_close(&tTruncatedFile);
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+    SampleHistory_init(&sHistory, HISTORY_FILE_NAME);
+    srand(7);
+
+    // first measurement
+    measure(4150);
+    HostPlatform_printCardStatistics("first measurement");
+    check(isHistoryEqualToSamples(), "history of first measurement");
+    store("stored.bin");
+    static uint16_t sStoredVoltage[SAMPLE_COUNT];
+    static uint16_t sStoredESR[SAMPLE_COUNT];
+    memcpy(sStoredVoltage, sVoltage, sizeof(sVoltage));
+    memcpy(sStoredESR, sESR, sizeof(sESR));
+    uint16_t tStoredFirstRAMBlock = sHistory.FirstRAMBlock;
+
+    // second measurement overwrites the history file
+    measure(3900);
+    HostPlatform_printCardStatistics("second measurement");
+
+    memcpy(sVoltage, sStoredVoltage, sizeof(sVoltage));
+    memcpy(sESR, sStoredESR, sizeof(sESR));
+    check(load("stored.bin") == FR_OK, "load of stored file");
+    check(strcmp(sHistory.FileName, HISTORY_FILE_NAME) == 0 && sHistory.FirstRAMBlock == tStoredFirstRAMBlock,
+            "history file of loaded history");
+    check(isHistoryEqualToSamples(), "loaded history differs from first measurement");
+
+    // the last spilled block is missing
+    truncateFile("stored.bin", "short.bin", sizeof(sHistory) + (tStoredFirstRAMBlock - 1) * SAMPLE_HISTORY_BLOCK_SIZE);
+    MMCSim_resetStatistics(); // checks and truncation are not part of the test
+    check(load("short.bin") == FR_INT_ERR && sHistory.SampleCount == 0, "truncated file must be rejected");
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,411 @@
+/*
+ * @file SensorAcquisitionMockBusTest.cpp
+ *
+ * Host test of the FIFO burst and sample ring logic of system/F3-DiscoveryLib/src/sensorAcquisition.cpp on a mock bus.
+ * The mock sensors fill their 32 entry FIFOs with the output data rate of the target configuration.
+ * Each sample carries its sequence number, so lost, duplicated or reordered samples and wrong timestamps are detected.
+ * The gyroscope is read over a 9 MHz SPI, accelerometer and compass over a 400 kHz I2C, both with asynchronous completion.
+ *
+ * Phases of 10 seconds each:
+ * 1. Ideal bus. No sample may be lost.
+ * 2. Bus busy for 20% of the reads and 1% bus errors. All lost samples must be explained by FIFO overruns or failed reads.
+ * 3. Main loop consumes only every 200 ms, the worst case of the demo page loop. No sample may be lost.
+ * 4. Main loop consumes only every second. Ring overruns must be counted and explain the lost samples.
+ *
+ * Build from the repository root:
+ * g++ -O2 -Isystem/F3-DiscoveryLib/include -o SensorAcquisitionMockBusTest extras/SensorAcquisitionMockBusTest.cpp
+ *     system/F3-DiscoveryLib/src/sensorAcquisition.cpp
+ * Usage: SensorAcquisitionMockBusTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "sensorAcquisition.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_TEST_MAX_ERRORS    20
+#include "host/hostTest.h"
+
+/*
+ * Values of l3gdc20_lsm303dlhc_utils.h and PageAccelerometerCompassGyroDemo.hpp
+ */
+#define GYROSCOPE_SAMPLE_PERIOD_MICROS      2632
+#define ACCELEROMETER_SAMPLE_PERIOD_MICROS  2500
+#define COMPASS_SAMPLE_PERIOD_MICROS        13333 // 75 Hz
+#define SENSOR_BURST_PERIOD_MICROS          20000
+#define SENSOR_SAMPLES_PER_LOOP_MAX         32
+#define CONSUME_PERIOD_MICROS               20000
+#define CONSUME_PERIOD_WORST_CASE_MICROS    200000 // see SENSOR_SAMPLE_RING_SIZE
+#define CONSUME_PERIOD_TOO_LONG_MICROS      1000000
+
+#define SPI_NANOS_PER_BYTE                  (8 * 1000 / 9) // 9 MHz
+#define I2C_NANOS_PER_BYTE                  (9 * 1000 / 400) // 400 kHz, 9 clocks per byte
+#define I2C_HEADER_BYTES                    4 // address write, register, address read + start conditions
+
+#define MAX_BUS_LATENCY_MICROS              1000 // samples written after the burst start until the FIFO status is read
+#define PHASE_MICROS                        10000000
+#define NEVER                               0xFFFFFFFF
+
+/*
+ * Sample content. Z is a negative constant per sensor to check sign extension.
+ */
+static int16_t getX(uint32_t aSequence) {
+    return aSequence & 0x3FF;
+}
+static int16_t getY(uint32_t aSequence) {
+    return (aSequence >> 10) & 0x3FF;
+}
+static int16_t getZ(uint8_t aSensor) {
+    return -100 - aSensor;
+}
+
+/*
+ * Mock sensors
+ */
+typedef struct {
+    uint32_t Sequence[SENSOR_FIFO_DEPTH];
+    uint32_t SampleMicros[SENSOR_FIFO_DEPTH];
+    uint8_t Count;
+    uint8_t Out;
+    bool Overrun;
+    uint32_t NextSampleMicros;
+    uint32_t PeriodMicros;
+    uint32_t NextSequence;
+    uint32_t Dropped; // by FIFO overrun or failed read
+} MockFifoTypeDef;
+
+static MockFifoTypeDef sFifos[2]; // gyroscope and accelerometer
+static uint32_t sCompassSequence;
+static uint32_t sCompassNextSampleMicros;
+static uint32_t sSampleMicrosOfSequence[NUMBER_OF_SENSORS][4096]; // true sample time, indexed by sequence modulo 4096
+
+static void addFifoSample(uint8_t aSensor) {
+    MockFifoTypeDef *tFifo = &sFifos[aSensor];
+    uint8_t tIn = (tFifo->Out + tFifo->Count) % SENSOR_FIFO_DEPTH;
+    if (tFifo->Count == SENSOR_FIFO_DEPTH) {
+        // stream mode overwrites the oldest sample
+        tFifo->Out = (tFifo->Out + 1) % SENSOR_FIFO_DEPTH;
+        tFifo->Count--;
+        tFifo->Overrun = true;
+        tFifo->Dropped++;
+    }
+    tFifo->Sequence[tIn] = tFifo->NextSequence;
+    tFifo->SampleMicros[tIn] = tFifo->NextSampleMicros;
+    sSampleMicrosOfSequence[aSensor][tFifo->NextSequence % 4096] = tFifo->NextSampleMicros;
+    tFifo->NextSequence++;
+    tFifo->Count++;
+    tFifo->NextSampleMicros += tFifo->PeriodMicros;
+}
+
+static uint8_t getFifoSource(uint8_t aSensor) {
+    MockFifoTypeDef *tFifo = &sFifos[aSensor];
+    if (tFifo->Count == 0) {
+        return SENSOR_FIFO_SRC_EMPTY;
+    }
+    if (tFifo->Count == SENSOR_FIFO_DEPTH || tFifo->Overrun) {
+        return SENSOR_FIFO_SRC_OVERRUN | (tFifo->Count & SENSOR_FIFO_SRC_COUNT_MASK);
+    }
+    return tFifo->Count;
+}
+
+/*
+ * Data registers are read with auto increment, which pops one sample per 6 bytes
+ */
+static void readFifoData(uint8_t aSensor, uint8_t *aBuffer, uint16_t aLength) {
+    MockFifoTypeDef *tFifo = &sFifos[aSensor];
+    tFifo->Overrun = false;
+    for (uint16_t i = 0; i < aLength / SENSOR_BYTES_PER_SAMPLE; ++i) {
+        check(tFifo->Count > 0, "FIFO read beyond content");
+        uint32_t tSequence = tFifo->Sequence[tFifo->Out];
+        int16_t tValues[3] = { getX(tSequence), getY(tSequence), getZ(aSensor) };
+        for (int j = 0; j < 3; ++j) {
+            // accelerometer data is left aligned 12 bit
+            uint16_t tRaw = (aSensor == SENSOR_ACCELEROMETER) ? tValues[j] << 4 : tValues[j];
+            *aBuffer++ = tRaw;
+            *aBuffer++ = tRaw >> 8;
+        }
+        tFifo->Out = (tFifo->Out + 1) % SENSOR_FIFO_DEPTH;
+        tFifo->Count--;
+    }
+}
+
+/*
+ * Mock bus with one transfer per bus. SPI for gyroscope, I2C for accelerometer and compass.
+ */
+typedef struct {
+    uint32_t CompletionMicros; // NEVER if idle
+    uint8_t Sensor;
+    uint8_t Register;
+    uint8_t *Buffer;
+    uint16_t Length;
+} MockTransferTypeDef;
+
+static MockTransferTypeDef sSPITransfer = { NEVER };
+static MockTransferTypeDef sI2CTransfer = { NEVER };
+static uint32_t sNowMicros;
+static int sBusyPercent;
+static int sErrorPerMille;
+
+static bool startRead(uint8_t aSensor, uint8_t aRegister, uint8_t *aBuffer, uint16_t aLength) {
+    check(sSPITransfer.CompletionMicros == NEVER && sI2CTransfer.CompletionMicros == NEVER, "read started while transfer running");
+    if (rand() % 100 < sBusyPercent) {
+        return false;
+    }
+    MockTransferTypeDef *tTransfer = &sI2CTransfer;
+    uint32_t tNanos = (aLength + I2C_HEADER_BYTES) * I2C_NANOS_PER_BYTE;
+    if (aSensor == SENSOR_GYROSCOPE) {
+        tTransfer = &sSPITransfer;
+        tNanos = (aLength + 1) * SPI_NANOS_PER_BYTE;
+    }
+    tTransfer->CompletionMicros = sNowMicros + 1 + tNanos / 1000;
+    tTransfer->Sensor = aSensor;
+    tTransfer->Register = aRegister;
+    tTransfer->Buffer = aBuffer;
+    tTransfer->Length = aLength;
+    return true;
+}
+
+static const SensorBusTypeDef sMockBus = { &startRead };
+
+static void completeTransfer(MockTransferTypeDef *aTransfer) {
+    aTransfer->CompletionMicros = NEVER;
+    bool tSuccess = (rand() % 1000) >= sErrorPerMille;
+    uint8_t tSensor = aTransfer->Sensor;
+    if (tSensor == SENSOR_COMPASS) {
+        check(aTransfer->Register == SENSOR_LSM303_OUT_X_H_M && aTransfer->Length == SENSOR_BYTES_PER_SAMPLE, "compass read");
+        int16_t tValues[3] = { getX(sCompassSequence), getZ(SENSOR_COMPASS), getY(sCompassSequence) }; // order X, Z, Y
+        for (int j = 0; j < 3; ++j) {
+            aTransfer->Buffer[j * 2] = tValues[j] >> 8; // big endian
+            aTransfer->Buffer[j * 2 + 1] = tValues[j];
+        }
+    } else if (aTransfer->Register == SENSOR_L3GD20_FIFO_SRC_REG) { // same address for accelerometer
+        check(aTransfer->Length == 1, "FIFO status read length");
+        aTransfer->Buffer[0] = getFifoSource(tSensor);
+    } else {
+        check(aTransfer->Register == SENSOR_L3GD20_OUT_X_L, "FIFO data register");
+        check(aTransfer->Length % SENSOR_BYTES_PER_SAMPLE == 0, "FIFO data length");
+        uint32_t tCountBefore = sFifos[tSensor].Count;
+        readFifoData(tSensor, aTransfer->Buffer, aTransfer->Length);
+        if (!tSuccess) {
+            // samples are popped from the FIFO, but the data is lost
+            sFifos[tSensor].Dropped += tCountBefore - sFifos[tSensor].Count;
+        }
+    }
+    SensorAcquisition_readCompleted(tSuccess);
+}
+
+/*
+ * Consumer
+ */
+static uint32_t sReceived[NUMBER_OF_SENSORS];
+static uint32_t sPhaseStartSequence[2];
+static int64_t sLastSequence[NUMBER_OF_SENSORS];
+static int32_t sMaxTimestampErrorMicros[NUMBER_OF_SENSORS];
+static int32_t sMinTimestampErrorMicros[NUMBER_OF_SENSORS];
+
+static void consumeSamples(void) {
+    static SensorSampleTypeDef sSamples[SENSOR_SAMPLES_PER_LOOP_MAX];
+    uint16_t tCount;
+    do {
+        tCount = SensorAcquisition_getSamples(sSamples, SENSOR_SAMPLES_PER_LOOP_MAX);
+        for (int i = 0; i < tCount; ++i) {
+            SensorSampleTypeDef *tSample = &sSamples[i];
+            uint8_t tSensor = tSample->Sensor;
+            check(tSensor < NUMBER_OF_SENSORS, "sensor");
+            check(tSample->Values[2] == getZ(tSensor), "Z value or sign extension");
+            // reconstruct sequence from the 20 bit of X and Y
+            uint32_t tLow = (uint16_t) tSample->Values[0] | (uint16_t) tSample->Values[1] << 10;
+            int64_t tSequence = (sLastSequence[tSensor] + 1) & ~0xFFFFFLL;
+            tSequence |= tLow;
+            if (tSequence < sLastSequence[tSensor]) {
+                tSequence += 0x100000;
+            }
+            if (tSensor == SENSOR_COMPASS) {
+                // compass register can be read twice before the next update
+                check(tSequence >= sLastSequence[tSensor], "compass sequence");
+            } else {
+                check(tSequence > sLastSequence[tSensor], "duplicated or reordered sample");
+                int32_t tError = tSample->TimestampMicros - sSampleMicrosOfSequence[tSensor][tSequence % 4096];
+                if (tError > sMaxTimestampErrorMicros[tSensor]) {
+                    sMaxTimestampErrorMicros[tSensor] = tError;
+                }
+                if (tError < sMinTimestampErrorMicros[tSensor]) {
+                    sMinTimestampErrorMicros[tSensor] = tError;
+                }
+            }
+            sLastSequence[tSensor] = tSequence;
+            sReceived[tSensor]++;
+        }
+    } while (tCount == SENSOR_SAMPLES_PER_LOOP_MAX);
+}
+
+static void runUntil(uint32_t aEndMicros, uint32_t aConsumePeriodMicros, bool aGenerateSamples) {
+    static uint32_t sNextBurstMicros = SENSOR_BURST_PERIOD_MICROS;
+    uint32_t tNextConsumeMicros = sNowMicros + aConsumePeriodMicros;
+    while (sNowMicros < aEndMicros) {
+        uint32_t tNext = aEndMicros;
+        if (aGenerateSamples) {
+            for (int i = 0; i < 2; ++i) {
+                if (sFifos[i].NextSampleMicros < tNext) {
+                    tNext = sFifos[i].NextSampleMicros;
+                }
+            }
+            if (sCompassNextSampleMicros < tNext) {
+                tNext = sCompassNextSampleMicros;
+            }
+        }
+        uint32_t tCandidates[4] = { sNextBurstMicros, tNextConsumeMicros, sSPITransfer.CompletionMicros, sI2CTransfer.CompletionMicros };
+        for (int i = 0; i < 4; ++i) {
+            if (tCandidates[i] < tNext) {
+                tNext = tCandidates[i];
+            }
+        }
+        sNowMicros = tNext;
+
+        if (aGenerateSamples) {
+            for (uint8_t i = 0; i < 2; ++i) {
+                if (sFifos[i].NextSampleMicros == sNowMicros) {
+                    addFifoSample(i);
+                }
+            }
+            if (sCompassNextSampleMicros == sNowMicros) {
+                sCompassSequence++;
+                sCompassNextSampleMicros += COMPASS_SAMPLE_PERIOD_MICROS;
+            }
+        }
+        if (sSPITransfer.CompletionMicros == sNowMicros) {
+            completeTransfer(&sSPITransfer);
+        }
+        if (sI2CTransfer.CompletionMicros == sNowMicros) {
+            completeTransfer(&sI2CTransfer);
+        }
+        if (sNextBurstMicros == sNowMicros) {
+            SensorAcquisition_startBurst(sNowMicros);
+            sNextBurstMicros += SENSOR_BURST_PERIOD_MICROS;
+        }
+        if (tNextConsumeMicros == sNowMicros) {
+            consumeSamples();
+            tNextConsumeMicros += aConsumePeriodMicros;
+        }
+    }
+}
+
+static uint32_t getLost(uint8_t aSensor) {
+    return sFifos[aSensor].NextSequence - sPhaseStartSequence[aSensor] - sReceived[aSensor] - sFifos[aSensor].Count;
+}
+
+static void printPhase(const char *aName) {
+    printf("%s\n", aName);
+    const char *tNames[2] = { "Gyroscope", "Accelerometer" };
+    for (uint8_t i = 0; i < 2; ++i) {
+        printf("  %-13s generated=%6u received=%6u lost=%4u FIFO overruns=%3u timestamp error=%d to %d us\n", tNames[i],
+                sFifos[i].NextSequence - sPhaseStartSequence[i], sReceived[i], getLost(i), SensorAcquisitionStatistics.FifoOverruns[i],
+                sMinTimestampErrorMicros[i], sMaxTimestampErrorMicros[i]);
+    }
+    printf("  Compass       received=%6u\n", sReceived[SENSOR_COMPASS]);
+    printf("  Bursts=%u skipped=%u bus busy=%u bus errors=%u ring overruns=%u\n", SensorAcquisitionStatistics.Bursts,
+            SensorAcquisitionStatistics.BurstsSkipped, SensorAcquisitionStatistics.BusBusy, SensorAcquisitionStatistics.BusErrors,
+            SensorAcquisitionStatistics.RingOverruns);
+}
+
+/*
+ * Each lost sample must be dropped by the mock FIFO, by a failed read or by a ring overrun
+ */
+static void checkLostSamples(void) {
+    uint32_t tLostInRing = 0;
+    for (uint8_t i = 0; i < 2; ++i) {
+        check(getLost(i) >= sFifos[i].Dropped, "more samples dropped than lost");
+        tLostInRing += getLost(i) - sFifos[i].Dropped;
+    }
+    // compass samples may be lost by ring overrun too, but are not counted by the mock
+    check(tLostInRing <= SensorAcquisitionStatistics.RingOverruns, "samples lost without reason");
+}
+
+static void resetPhaseStatistics(void) {
+    SensorAcquisition_init(&sMockBus, GYROSCOPE_SAMPLE_PERIOD_MICROS, ACCELEROMETER_SAMPLE_PERIOD_MICROS);
+    for (uint8_t i = 0; i < NUMBER_OF_SENSORS; ++i) {
+        sReceived[i] = 0;
+        sMaxTimestampErrorMicros[i] = -1000000;
+        sMinTimestampErrorMicros[i] = 1000000;
+        if (i < 2) {
+            sFifos[i].Dropped = 0;
+            sPhaseStartSequence[i] = sFifos[i].NextSequence - sFifos[i].Count; // samples in FIFO are counted for this phase
+        }
+    }
+}
+
+/*
+ * Stops sample generation and reads the FIFOs empty
+ */
+static void drain(uint32_t aConsumePeriodMicros) {
+    runUntil(sNowMicros + 3 * SENSOR_BURST_PERIOD_MICROS, aConsumePeriodMicros, false);
+    consumeSamples();
+    for (uint8_t i = 0; i < 2; ++i) {
+        check(sFifos[i].Count == 0, "FIFO not empty after drain");
+    }
+    for (uint8_t i = 0; i < 2; ++i) {
+        sFifos[i].NextSampleMicros = sNowMicros + sFifos[i].PeriodMicros;
+    }
+    sCompassNextSampleMicros = sNowMicros + COMPASS_SAMPLE_PERIOD_MICROS;
+}
+
+int main(void) {
+    srand(1);
+    sFifos[SENSOR_GYROSCOPE].PeriodMicros = GYROSCOPE_SAMPLE_PERIOD_MICROS;
+    sFifos[SENSOR_GYROSCOPE].NextSampleMicros = 777;
+    sFifos[SENSOR_ACCELEROMETER].PeriodMicros = ACCELEROMETER_SAMPLE_PERIOD_MICROS;
+    sFifos[SENSOR_ACCELEROMETER].NextSampleMicros = 1234;
+    sCompassNextSampleMicros = 5000;
+    for (uint8_t i = 0; i < NUMBER_OF_SENSORS; ++i) {
+        sLastSequence[i] = -1;
+    }
+
+    resetPhaseStatistics();
+    runUntil(PHASE_MICROS, CONSUME_PERIOD_MICROS, true);
+    drain(CONSUME_PERIOD_MICROS);
+    printPhase("Phase 1: ideal bus, consume every 20 ms");
+    check(getLost(SENSOR_GYROSCOPE) == 0 && getLost(SENSOR_ACCELEROMETER) == 0, "samples lost on ideal bus");
+    check(SensorAcquisitionStatistics.FifoOverruns[0] == 0 && SensorAcquisitionStatistics.FifoOverruns[1] == 0, "FIFO overrun");
+    // the last burst may still be running
+    check(sReceived[SENSOR_COMPASS] + 1 >= SensorAcquisitionStatistics.Bursts, "one compass sample per burst");
+    for (uint8_t i = 0; i < 2; ++i) {
+        check(sMinTimestampErrorMicros[i] > -MAX_BUS_LATENCY_MICROS && sMaxTimestampErrorMicros[i] < (int32_t) sFifos[i].PeriodMicros,
+                "timestamp must be between sample time and next sample time, plus samples arriving during the status read");
+    }
+
+    resetPhaseStatistics();
+    sBusyPercent = 20;
+    sErrorPerMille = 10;
+    runUntil(sNowMicros + PHASE_MICROS, CONSUME_PERIOD_MICROS, true);
+    sBusyPercent = 0;
+    sErrorPerMille = 0;
+    drain(CONSUME_PERIOD_MICROS);
+    printPhase("Phase 2: 20% bus busy, 1% bus errors, consume every 20 ms");
+    check(SensorAcquisitionStatistics.BusBusy > 0 && SensorAcquisitionStatistics.BusErrors > 0, "bus faults not injected");
+    checkLostSamples();
+
+    resetPhaseStatistics();
+    runUntil(sNowMicros + PHASE_MICROS, CONSUME_PERIOD_WORST_CASE_MICROS, true);
+    drain(CONSUME_PERIOD_WORST_CASE_MICROS);
+    printPhase("Phase 3: ideal bus, consume every 200 ms");
+    check(SensorAcquisitionStatistics.RingOverruns == 0, "ring overrun at worst case consume period");
+    check(getLost(SENSOR_GYROSCOPE) == 0 && getLost(SENSOR_ACCELEROMETER) == 0, "samples lost at worst case consume period");
+
+    resetPhaseStatistics();
+    runUntil(sNowMicros + PHASE_MICROS, CONSUME_PERIOD_TOO_LONG_MICROS, true);
+    drain(CONSUME_PERIOD_TOO_LONG_MICROS);
+    printPhase("Phase 4: ideal bus, consume every second");
+    check(SensorAcquisitionStatistics.RingOverruns > 0, "ring overrun expected");
+    checkLostSamples();
+
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,178 @@
+/*
+ * @file StreamReaderBenchmark.c
+ *
+ * Host benchmark of the replay of a capture file by streamReader.c on the SPI level card simulator mmc_sim.c.
+ * A capture file with frames of the size of the DSO capture frames is recorded by streamLogger.c,
+ * then random frames are read by f_lseek() and f_read() and by the index and read ahead cache of the reader.
+ * For each access pattern the sector reads and the simulated bus time are printed and the frame content is checked.
+ * The last test records to a fragmented file, which is read by the cluster link map of the reader.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o StreamReaderBenchmark extras/StreamReaderBenchmark.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c
+ *     lib/fat_sd/streamLogger.c lib/fat_sd/streamReader.c
+ * Usage: StreamReaderBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "streamLogger.h"
+#include "streamReader.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define FRAME_HEADER_SIZE       20      // sizeof(struct CaptureFrameHeaderStruct)
+#define FRAME_SIZE              (FRAME_HEADER_SIZE + 320 * 2) // CAPTURE_FRAME_SIZE
+#define FRAME_COUNT             3000
+#define FRAME_PERIOD_MICROS     20000   // 50 frames per second
+#define PREALLOCATE_SIZE        (4 * 1000 * 1000L)
+#define READ_RAM_BUDGET         2048    // CAPTURE_READ_RAM_BUDGET
+#define RANDOM_READS            200
+#define FRAGMENTATION_CLUSTERS  3500    // 2 x 7 MByte of the 16 MByte card
+
+static uint8_t sFrame[FRAME_SIZE];
+static uint8_t sExpectedFrame[FRAME_SIZE];
+static uint32_t sRandomFrameNumbers[RANDOM_READS];
+static void fillFrame(uint8_t *aFrame, uint32_t aFrameNumber) {
+    memcpy(aFrame, &aFrameNumber, sizeof(aFrameNumber));
+    for (int i = sizeof(aFrameNumber); i < FRAME_SIZE; ++i) {
+        aFrame[i] = (uint8_t) (aFrameNumber * 31 + i);
+    }
+}
+
+/*
+ * Appends header and samples like recordAcquisitionData() and calls the service like the DSO loop
+ */
+static void recordFrames(const char *aFileName) {
+    check(StreamLogger_open(aFileName, PREALLOCATE_SIZE, PREALLOCATE_SIZE / FRAME_SIZE) == FR_OK, "open of stream logger");
+    const StreamLoggerStatisticsTypeDef *tStatistics = StreamLogger_getStatistics();
+    printf("%s: %u fragments\n", aFileName, tStatistics->Fragments);
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+        fillFrame(sFrame, i);
+        StreamLogger_append(sFrame, FRAME_HEADER_SIZE, &sFrame[FRAME_HEADER_SIZE], FRAME_SIZE - FRAME_HEADER_SIZE);
+        StreamLogger_service();
+        HostPlatform_spendMicros(FRAME_PERIOD_MICROS);
+    }
+    check(StreamLogger_close() == FR_OK, "close of stream logger");
+    check(tStatistics->RecordsAppended == FRAME_COUNT && tStatistics->RecordsLost == 0, "frames lost during recording");
+    check(tStatistics->WriteErrors == 0, "write errors during recording");
+    HostPlatform_printCardStatistics("record 3000 frames");
+}
+
+/*
+ * Reference without index and cache, the record offset is computed from the fixed frame size
+ */
+static void readWithSeek(const char *aFileName) {
+    FIL tFile;
+    UINT tCount;
+    StreamFileHeaderTypeDef tHeader;
+    check(f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ) == FR_OK, "open for seek");
+    f_read(&tFile, &tHeader, sizeof(tHeader), &tCount);
+    check(tHeader.Magic == STREAM_FILE_MAGIC && tHeader.RecordCount == FRAME_COUNT, "stream file header");
+    check(tHeader.IndexedRecordCount == FRAME_COUNT, "indexed record count");
+    HostPlatform_printCardStatistics("open and header");
+    bool tDataIsValid = true;
+    for (int i = 0; i < RANDOM_READS; ++i) {
+        f_lseek(&tFile, STREAM_FILE_DATA_OFFSET(&tHeader) + sRandomFrameNumbers[i] * FRAME_SIZE);
+        f_read(&tFile, sFrame, FRAME_SIZE, &tCount);
+        fillFrame(sExpectedFrame, sRandomFrameNumbers[i]);
+        tDataIsValid &= (memcmp(sFrame, sExpectedFrame, FRAME_SIZE) == 0);
+    }
+    f_close(&tFile);
+    check(tDataIsValid, "frame read by f_lseek() differs");
+    HostPlatform_printCardStatistics("200 random frames by f_lseek()");
+}
+
+static bool readFrame(uint32_t aFrameNumber) {
+    DWORD tOffset;
+    UINT tLength;
+    if (StreamReader_getRecordPosition(aFrameNumber, &tOffset, &tLength) != FR_OK || tLength != FRAME_SIZE
+            || StreamReader_read(tOffset, sFrame, tLength) != FR_OK) {
+        return false;
+    }
+    fillFrame(sExpectedFrame, aFrameNumber);
+    return memcmp(sFrame, sExpectedFrame, FRAME_SIZE) == 0;
+}
+
+static void readWithReader(const char *aFileName) {
+    check(StreamReader_open(aFileName, READ_RAM_BUDGET) == FR_OK, "open of stream reader");
+    HostPlatform_printCardStatistics("StreamReader_open");
+    bool tDataIsValid = true;
+    for (int i = 0; i < RANDOM_READS; ++i) {
+        tDataIsValid &= readFrame(sRandomFrameNumbers[i]);
+    }
+    check(tDataIsValid, "random frame read by stream reader differs");
+    HostPlatform_printCardStatistics("200 random frames by index");
+
+    // single steps of a slow swipe in showCaptureFrame()
+    tDataIsValid = true;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i) {
+        tDataIsValid &= readFrame(i);
+    }
+    check(tDataIsValid, "frame read by single steps differs");
+    HostPlatform_printCardStatistics("3000 frames in single steps");
+
+    const StreamReaderStatisticsTypeDef *tStatistics = StreamReader_getStatistics();
+    printf("Reads=%lu CacheHits=%lu CacheFills=%lu SectorsRead=%lu IndexSectorReads=%lu\n", (unsigned long) tStatistics->Reads,
+            (unsigned long) tStatistics->CacheHits, (unsigned long) tStatistics->CacheFills, (unsigned long) tStatistics->SectorsRead,
+            (unsigned long) tStatistics->IndexSectorReads);
+    check(tStatistics->CacheHits > 0, "no hits of read ahead cache");
+    check(!readFrame(FRAME_COUNT), "read behind last frame must fail");
+    check(StreamReader_close() == FR_OK, "close of stream reader");
+}
+
+/*
+ * 2 files written alternately leave gaps of one cluster after deletion of one of them.
+ * The remaining free space at the end of the card is smaller than the preallocated size of the capture file.
+ */
+static void fragmentCard(void) {
+    FIL tFile1, tFile2;
+    UINT tCount;
+    check(f_open(&tFile1, "gap.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for fragmentation");
+    check(f_open(&tFile2, "keep.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for fragmentation");
+    for (int i = 0; i < FRAGMENTATION_CLUSTERS; ++i) {
+        f_write(&tFile1, sFrame, 2048 - FRAME_SIZE, &tCount);
+        f_write(&tFile1, sFrame, FRAME_SIZE, &tCount);
+        f_write(&tFile2, sFrame, 2048 - FRAME_SIZE, &tCount);
+        f_write(&tFile2, sFrame, FRAME_SIZE, &tCount);
+    }
+    f_close(&tFile1);
+    f_close(&tFile2);
+    f_unlink("gap.bin");
+    HostPlatform_printCardStatistics("fragmentation of free space");
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+    srand(1);
+    for (int i = 0; i < RANDOM_READS; ++i) {
+        sRandomFrameNumbers[i] = rand() % FRAME_COUNT;
+    }
+
+    recordFrames("capture.bin");
+    readWithSeek("capture.bin");
+    readWithReader("capture.bin");
+    f_unlink("capture.bin");
+
+    fragmentCard();
+    recordFrames("capture2.bin");
+    check(!StreamLogger_getStatistics()->IsContiguous, "file must be fragmented");
+    readWithReader("capture2.bin");
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
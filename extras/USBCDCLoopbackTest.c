@@ -0,0 +1,307 @@
+/*
+ * @file USBCDCLoopbackTest.c
+ *
+ * Host test of the send and receive queues of the USB CDC BlueDisplay transport in lib/usb/src/usbd_cdc_interface.c.
+ * The composite class and the host are replaced by a loopback, which returns all data of the IN endpoint on the OUT endpoint.
+ * The host reads up to 19 bulk packets per 1 ms frame, which is the limit of a full speed device.
+ * At each frame the SOF interrupt calls CDC_checkAndStartTransmit() and the host delivers packets to the armed OUT endpoint.
+ * Busy waiting of CDC_sendBuffer() for buffer space lets the frames continue, like the interrupts do on the target.
+ *
+ * The thread sends BlueDisplay commands with the framing of sendUSARTArgs() and sendUSARTArgsAndByteBuffer()
+ * and parses the received byte stream like serialEvent(). Each parsed command must be identical to the sent one.
+ * Slow reading phases check the flow control of the receive buffer, i.e. that no byte is lost if the OUT endpoint is paused.
+ *
+ * Build from the repository root:
+ * gcc -O2 -DUSE_USB_INTERRUPT_DEFAULT -Iextras/host -Ilib/usb/include -Ilib/BlueDisplay -o USBCDCLoopbackTest
+ *     extras/USBCDCLoopbackTest.c lib/usb/src/usbd_cdc_interface.c
+ * Usage: USBCDCLoopbackTest [NumberOfCommands]
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "usbd_composite.h"
+#include "usbd_misc.h"
+#include "timing.h"
+#include "BlueDisplayProtocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HOST_TEST_MAX_ERRORS    10
+#include "host/hostTest.h"
+
+#define FULL_SPEED_BULK_PACKETS_PER_FRAME   19
+#define MAX_NUMBER_OF_ARGS                  12
+#define MAX_DATA_LENGTH                     1200 // e.g. drawChartByteBuffer() of a 1200 sample chart
+
+extern volatile uint32_t UserRxOverrunCount; // from usbd_cdc_interface.c
+
+volatile USBD_InterfaceStatisticsTypeDef USBDInterfaceStatistics[COMPOSITE_NUMBER_OF_FUNCTIONS];
+
+/*
+ * Simulated host and endpoints
+ */
+static uint32_t sMillis;
+static uint32_t sTimeoutMillis;
+static uint8_t *sINTransferPointer;
+static uint32_t sINTransferRemaining; // != 0 if IN endpoint is busy
+static bool sOUTIsArmed;
+static uint8_t sLoopbackBuffer[65536]; // bytes read by the host from the IN endpoint, not yet sent to OUT endpoint
+static uint32_t sLoopbackIn;
+static uint32_t sLoopbackOut;
+static uint32_t sFramesWithoutOUTArmed;
+
+/*
+ * Functions of the composite class used by usbd_cdc_interface.c
+ */
+bool isUsbCdcReady(void) {
+    return true;
+}
+
+bool USBD_Composite_isINEndpointBusy(uint8_t aEndpointAddress) {
+    (void) aEndpointAddress;
+    return sINTransferRemaining != 0;
+}
+
+uint8_t USBD_Composite_transmit(uint8_t aEndpointAddress, uint8_t *aBuffer, uint16_t aLength) {
+    check(aEndpointAddress == COMPOSITE_CDC_IN_EP, "transmit on wrong endpoint");
+    if (sINTransferRemaining != 0) {
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].NAKsIn++;
+        return USBD_BUSY;
+    }
+    sINTransferPointer = aBuffer;
+    sINTransferRemaining = aLength;
+    USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].TransfersIn++;
+    return USBD_OK;
+}
+
+void USBD_Composite_CDC_prepareReceive(void) {
+    check(!sOUTIsArmed, "OUT endpoint armed twice");
+    sOUTIsArmed = true;
+}
+
+/*
+ * One USB frame: the host polls the IN endpoint and sends the looped back data to the OUT endpoint, then the SOF interrupt runs
+ */
+static void simulateFrame(void) {
+    sMillis++;
+    for (int i = 0; i < FULL_SPEED_BULK_PACKETS_PER_FRAME && sINTransferRemaining != 0; ++i) {
+        uint32_t tPacketSize = sINTransferRemaining;
+        if (tPacketSize > COMPOSITE_CDC_DATA_PACKET_SIZE) {
+            tPacketSize = COMPOSITE_CDC_DATA_PACKET_SIZE;
+        }
+        for (uint32_t j = 0; j < tPacketSize; ++j) {
+            sLoopbackBuffer[sLoopbackIn++ % sizeof(sLoopbackBuffer)] = *sINTransferPointer++;
+        }
+        check(sLoopbackIn - sLoopbackOut <= sizeof(sLoopbackBuffer), "loopback buffer overflow");
+        sINTransferRemaining -= tPacketSize;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].BytesIn += tPacketSize;
+    }
+
+    for (int i = 0; i < FULL_SPEED_BULK_PACKETS_PER_FRAME && sLoopbackOut != sLoopbackIn; ++i) {
+        if (!sOUTIsArmed) {
+            sFramesWithoutOUTArmed++;
+            break;
+        }
+        uint8_t tPacket[COMPOSITE_CDC_DATA_PACKET_SIZE];
+        uint32_t tPacketSize = 0;
+        while (tPacketSize < COMPOSITE_CDC_DATA_PACKET_SIZE && sLoopbackOut != sLoopbackIn) {
+            tPacket[tPacketSize++] = sLoopbackBuffer[sLoopbackOut++ % sizeof(sLoopbackBuffer)];
+        }
+        sOUTIsArmed = false;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].PacketsOut++;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].BytesOut += tPacketSize;
+        USBD_CDC_fops.Receive(tPacket, &tPacketSize);
+    }
+
+    CDC_checkAndStartTransmit();
+}
+
+/*
+ * Time functions used by CDC_sendBuffer()
+ */
+uint32_t millis(void) {
+    return sMillis;
+}
+
+void setTimeoutMillis(int32_t aTimeMillis) {
+    sTimeoutMillis = sMillis + aTimeMillis;
+}
+
+/*
+ * Called while waiting for buffer space, so let the interrupts run
+ */
+bool isTimeoutSimple(void) {
+    simulateFrame();
+    return (int32_t) (sMillis - sTimeoutMillis) > 0;
+}
+
+/*
+ * Sending and parsing of BlueDisplay commands
+ */
+typedef struct {
+    uint8_t FunctionTag;
+    uint8_t NumberOfArgs;
+    uint16_t Args[MAX_NUMBER_OF_ARGS];
+    uint16_t DataLength;
+    uint8_t Data[MAX_DATA_LENGTH];
+} BDCommandTypeDef;
+
+#define COMMAND_QUEUE_SIZE 256 // commands sent, but not yet parsed
+static BDCommandTypeDef sSentCommands[COMMAND_QUEUE_SIZE];
+static uint32_t sSentCount;
+static uint32_t sParsedCount;
+
+static void createCommand(BDCommandTypeDef *aCommand) {
+    aCommand->NumberOfArgs = rand() % (MAX_NUMBER_OF_ARGS + 1);
+    for (int i = 0; i < aCommand->NumberOfArgs; ++i) {
+        aCommand->Args[i] = rand();
+    }
+    aCommand->DataLength = 0;
+    if (rand() % 4 == 0) {
+        aCommand->FunctionTag = FUNCTION_DRAW_CHART;
+        aCommand->DataLength = 1 + rand() % MAX_DATA_LENGTH;
+        for (int i = 0; i < aCommand->DataLength; ++i) {
+            aCommand->Data[i] = rand();
+        }
+    } else {
+        aCommand->FunctionTag = (rand() % 2) ? FUNCTION_DRAW_LINE : FUNCTION_FILL_RECT;
+    }
+}
+
+/*
+ * Same layout of the parameter buffer as sendUSARTArgs() and sendUSARTArgsAndByteBuffer()
+ */
+static bool sendCommand(BDCommandTypeDef *aCommand) {
+    uint16_t tParamBuffer[MAX_NUMBER_OF_ARGS + 4];
+    uint16_t *tBufferPointer = &tParamBuffer[0];
+    *tBufferPointer++ = aCommand->FunctionTag << 8 | SYNC_TOKEN;
+    *tBufferPointer++ = aCommand->NumberOfArgs * 2;
+    for (int i = 0; i < aCommand->NumberOfArgs; ++i) {
+        *tBufferPointer++ = aCommand->Args[i];
+    }
+    if (aCommand->DataLength == 0) {
+        return CDC_sendBuffer((uint8_t*) &tParamBuffer[0], aCommand->NumberOfArgs * 2 + 4, NULL, 0);
+    }
+    *tBufferPointer++ = DATAFIELD_TAG_BYTE << 8 | SYNC_TOKEN;
+    *tBufferPointer = aCommand->DataLength;
+    return CDC_sendBuffer((uint8_t*) &tParamBuffer[0], aCommand->NumberOfArgs * 2 + 8, aCommand->Data, aCommand->DataLength);
+}
+
+/*
+ * Parser state, like the state of serialEvent()
+ */
+static uint8_t sReceivedBytes[8 + MAX_NUMBER_OF_ARGS * 2 + MAX_DATA_LENGTH];
+static uint32_t sReceivedIndex;
+
+static uint16_t getReceivedWord(uint32_t aIndex) {
+    return sReceivedBytes[aIndex] | sReceivedBytes[aIndex + 1] << 8;
+}
+
+/*
+ * Reads up to aMaxBytes from the receive buffer and compares each completely received command with the sent one
+ */
+static void readAndParse(uint32_t aMaxBytes) {
+    while (aMaxBytes-- > 0 && CDC_getReceiveBytesAvailable() > 0) {
+        sReceivedBytes[sReceivedIndex++] = CDC_getReceiveBufferByte();
+        if (sReceivedIndex < 4) {
+            continue;
+        }
+        check(sReceivedBytes[0] == SYNC_TOKEN, "missing sync token");
+        uint32_t tArgsLength = getReceivedWord(2);
+        uint32_t tCommandLength = 4 + tArgsLength;
+        check(tCommandLength <= 4 + MAX_NUMBER_OF_ARGS * 2, "parameter length too big");
+        if (sReceivedIndex < tCommandLength) {
+            continue;
+        }
+        BDCommandTypeDef *tSent = &sSentCommands[sParsedCount % COMMAND_QUEUE_SIZE];
+        if (tSent->DataLength > 0) {
+            if (sReceivedIndex < tCommandLength + 4) {
+                continue;
+            }
+            check(sReceivedBytes[tCommandLength] == SYNC_TOKEN && sReceivedBytes[tCommandLength + 1] == DATAFIELD_TAG_BYTE,
+                    "missing data field header");
+            tCommandLength += 4 + getReceivedWord(tCommandLength + 2);
+            check(tCommandLength <= sizeof(sReceivedBytes), "data length too big");
+            if (sReceivedIndex < tCommandLength) {
+                continue;
+            }
+        }
+        check(sParsedCount < sSentCount, "command received which was not sent");
+        check(sReceivedBytes[1] == tSent->FunctionTag, "wrong function tag");
+        check(tArgsLength == tSent->NumberOfArgs * 2U, "wrong number of args");
+        check(memcmp(&sReceivedBytes[4], tSent->Args, tArgsLength) == 0, "wrong args");
+        if (tSent->DataLength > 0) {
+            check(getReceivedWord(4 + tArgsLength + 2) == tSent->DataLength, "wrong data length");
+            check(memcmp(&sReceivedBytes[4 + tArgsLength + 4], tSent->Data, tSent->DataLength) == 0, "wrong data");
+        }
+        sParsedCount++;
+        sReceivedIndex = 0;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t tNumberOfCommands = 100000;
+    if (argc > 1) {
+        tNumberOfCommands = strtoul(argv[1], NULL, 0);
+    }
+    srand(1);
+    USBD_CDC_fops.Init();
+    CDC_checkAndStartTransmit();
+
+    uint32_t tBytesSent = 0;
+    uint32_t tLastParsedCount = 0;
+    uint32_t tLastProgressMillis = 0;
+    while (sSentCount < tNumberOfCommands) {
+        if (sParsedCount != tLastParsedCount) {
+            tLastParsedCount = sParsedCount;
+            tLastProgressMillis = sMillis;
+        } else if (sMillis - tLastProgressMillis > 1000) {
+            check(false, "no command received for 1 second");
+            break;
+        }
+        /*
+         * Phases of 1000 commands. Every 4. phase the reader is slow, so the receive buffer becomes full
+         */
+        bool tSlowReader = (sSentCount / 1000) % 4 == 3;
+        if (sSentCount - sParsedCount < COMMAND_QUEUE_SIZE - 1) {
+            BDCommandTypeDef *tCommand = &sSentCommands[sSentCount % COMMAND_QUEUE_SIZE];
+            createCommand(tCommand);
+            check(sendCommand(tCommand), "send timeout");
+            sSentCount++;
+            tBytesSent += tCommand->NumberOfArgs * 2 + 4 + (tCommand->DataLength > 0 ? tCommand->DataLength + 4 : 0);
+        }
+        if (rand() % 8 == 0) {
+            simulateFrame();
+        }
+        readAndParse(tSlowReader ? 16 : 1 + rand() % 600);
+    }
+    uint32_t tMillisForSending = sMillis;
+
+    // drain
+    for (int i = 0; i < 1000 && sParsedCount < sSentCount; ++i) {
+        simulateFrame();
+        readAndParse(UINT32_MAX);
+    }
+
+    check(sParsedCount == sSentCount, "not all commands received");
+    check(UserRxOverrunCount == 0, "receive buffer overrun");
+    check(USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].BytesIn == tBytesSent, "sent byte count");
+    check(USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].BytesOut == tBytesSent, "received byte count");
+    check(USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].NAKsOut > 0, "slow reader phases did not pause the OUT endpoint");
+
+    printf("%u commands with %u bytes in %u frames = %u kByte/s\n", sParsedCount, tBytesSent, tMillisForSending,
+            tBytesSent / (tMillisForSending ? tMillisForSending : 1));
+    printf("IN transfers=%u NAKsIn=%u, OUT packets=%u NAKsOut=%u, frames with paused OUT endpoint=%u\n",
+            USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].TransfersIn, USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].NAKsIn,
+            USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].PacketsOut, USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].NAKsOut,
+            sFramesWithoutOUTArmed);
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
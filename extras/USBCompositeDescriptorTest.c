@@ -0,0 +1,186 @@
+/*
+ * @file USBCompositeDescriptorTest.c
+ *
+ * Host test of the packet memory allocator and the configuration descriptor builder in lib/usb/src/usbd_composite_desc.c.
+ * The PMA layout must fit in the 512 bytes of the STM32F303, buffers must not overlap the BTABLE or each other
+ * and OUT buffers larger than 62 bytes must be multiples of 32 bytes.
+ * The configuration descriptor is parsed like the host does and must be consistent with the endpoint table.
+ * Builds into too small buffers must fail without writing behind the buffer.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Ilib/usb/include -o USBCompositeDescriptorTest extras/USBCompositeDescriptorTest.c lib/usb/src/usbd_composite_desc.c
+ * Usage: USBCompositeDescriptorTest
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "usbd_composite_desc.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define HID_REPORT_DESCRIPTOR_LENGTH    119 // value is only copied to the HID descriptor
+#define PMA_BYTES_USED                  448 // budget documented in usbd_composite_desc.c
+#define CANARY                          0xA5
+
+static void testPMAAllocation(void) {
+    uint16_t tPMAAddresses[COMPOSITE_NUMBER_OF_ENDPOINTS];
+    uint16_t tBytesUsed = USBD_PMA_allocate(CompositeEndpoints, COMPOSITE_NUMBER_OF_ENDPOINTS, tPMAAddresses, USB_PMA_SIZE);
+    printf("PMA: %u of %u bytes used\n", tBytesUsed, USB_PMA_SIZE);
+    check(tBytesUsed == PMA_BYTES_USED, "PMA budget");
+
+    uint16_t tBTableEnd = (COMPOSITE_HIGHEST_ENDPOINT_NUMBER + 1) * USB_PMA_BTABLE_ENTRY_SIZE;
+    for (int i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        const USBD_EndpointConfigTypeDef *tEndpoint = &CompositeEndpoints[i];
+        uint16_t tSize = tEndpoint->MaxPacketSize;
+        printf("  EP 0x%02X %3u bytes at 0x%03X\n", tEndpoint->Address, tSize, tPMAAddresses[i]);
+        check(tPMAAddresses[i] >= tBTableEnd, "buffer overlaps BTABLE");
+        check(tPMAAddresses[i] % USB_PMA_BUFFER_ALIGNMENT == 0, "buffer alignment");
+        check(tPMAAddresses[i] + tSize <= tBytesUsed, "buffer behind used memory");
+        if ((tEndpoint->Address & 0x80) == 0 && tSize > 62) {
+            check(tSize % 32 == 0, "OUT buffer size is not a multiple of 32");
+        }
+        for (int j = 0; j < i; ++j) {
+            check(tPMAAddresses[i] + tSize <= tPMAAddresses[j] || tPMAAddresses[j] + CompositeEndpoints[j].MaxPacketSize <= tPMAAddresses[i],
+                    "buffers overlap");
+        }
+    }
+    check(USBD_PMA_allocate(CompositeEndpoints, COMPOSITE_NUMBER_OF_ENDPOINTS, tPMAAddresses, PMA_BYTES_USED - 1) == 0,
+            "allocation in too small PMA must fail");
+
+    // OUT endpoint with 64 < size <= 96 requires 96 bytes
+    const USBD_EndpointConfigTypeDef tLargeOUTEndpoint[2] = { { 0x01, ENDPOINT_TYPE_BULK, 66, 0, 0 }, { 0x81, ENDPOINT_TYPE_BULK, 66, 0,
+            0 } };
+    check(USBD_PMA_allocate(tLargeOUTEndpoint, 2, tPMAAddresses, USB_PMA_SIZE) == 16 + 96 + 72, "rounding of large OUT buffer");
+}
+
+/*
+ * Parses the descriptor like the host and checks it against the endpoint table
+ */
+static void checkConfigDescriptor(const uint8_t *aDescriptor, uint16_t aLength) {
+    check(aDescriptor[0] == 9 && aDescriptor[1] == 0x02, "configuration descriptor header");
+    check((aDescriptor[2] | aDescriptor[3] << 8) == aLength, "wTotalLength");
+    uint8_t tNumberOfInterfaces = aDescriptor[4];
+    check(tNumberOfInterfaces == COMPOSITE_NUMBER_OF_INTERFACES, "bNumInterfaces");
+
+    bool tInterfaceSeen[COMPOSITE_NUMBER_OF_INTERFACES] = { false };
+    bool tEndpointSeen[COMPOSITE_NUMBER_OF_ENDPOINTS] = { false };
+    int tEndpointsExpected = 0;
+    int tInterfaceClass = -1;
+    bool tIADSeen = false;
+    uint16_t tIndex = 0;
+    while (tIndex < aLength) {
+        const uint8_t *tDescriptor = &aDescriptor[tIndex];
+        check(tDescriptor[0] >= 2 && tIndex + tDescriptor[0] <= aLength, "descriptor length");
+        if (tDescriptor[0] < 2) {
+            return;
+        }
+        switch (tDescriptor[1]) {
+        case 0x04: // interface
+            check(tEndpointsExpected == 0, "previous interface has less endpoints than bNumEndpoints");
+            check(tDescriptor[2] < COMPOSITE_NUMBER_OF_INTERFACES && !tInterfaceSeen[tDescriptor[2]], "interface number");
+            if (tDescriptor[2] < COMPOSITE_NUMBER_OF_INTERFACES) {
+                tInterfaceSeen[tDescriptor[2]] = true;
+            }
+            tEndpointsExpected = tDescriptor[4];
+            tInterfaceClass = tDescriptor[5];
+            break;
+        case 0x05: { // endpoint
+            check(tEndpointsExpected > 0, "more endpoints than bNumEndpoints");
+            tEndpointsExpected--;
+            const USBD_EndpointConfigTypeDef *tEndpoint = getCompositeEndpointConfig(tDescriptor[2]);
+            check(tEndpoint != NULL, "endpoint not in endpoint table");
+            if (tEndpoint != NULL) {
+                int tTableIndex = tEndpoint - CompositeEndpoints;
+                check(!tEndpointSeen[tTableIndex], "endpoint used twice");
+                tEndpointSeen[tTableIndex] = true;
+                check(tDescriptor[3] == tEndpoint->Type, "endpoint type");
+                check((tDescriptor[4] | tDescriptor[5] << 8) == tEndpoint->MaxPacketSize, "endpoint packet size");
+                if (tEndpoint->Type == ENDPOINT_TYPE_INTERRUPT) {
+                    check(tDescriptor[6] >= 1, "interrupt endpoint interval");
+                }
+                if (tInterfaceClass == 0x0A || tInterfaceClass == 0xFF) {
+                    check(tEndpoint->Type == ENDPOINT_TYPE_BULK, "data interface endpoint must be bulk");
+                }
+            }
+            break;
+        }
+        case 0x0B: // interface association
+            tIADSeen = true;
+            check(tDescriptor[2] == COMPOSITE_CDC_COMMAND_INTERFACE && tDescriptor[3] == 2, "IAD must group the 2 CDC interfaces");
+            check(!tInterfaceSeen[COMPOSITE_CDC_COMMAND_INTERFACE], "IAD must precede the CDC interfaces");
+            break;
+        case 0x21: // HID
+            check(tDescriptor[0] == HID_DESCRIPTOR_LENGTH, "HID descriptor length");
+            check((tDescriptor[7] | tDescriptor[8] << 8) == HID_REPORT_DESCRIPTOR_LENGTH, "HID report descriptor length");
+            break;
+        case 0x24: // CDC functional
+            if (tDescriptor[2] == 0x06) {
+                check(tDescriptor[3] == COMPOSITE_CDC_COMMAND_INTERFACE && tDescriptor[4] == COMPOSITE_CDC_DATA_INTERFACE,
+                        "CDC union descriptor");
+            }
+            break;
+        case 0x02:
+            check(tIndex == 0, "second configuration descriptor");
+            break;
+        default:
+            check(false, "unknown descriptor type");
+            break;
+        }
+        tIndex += tDescriptor[0];
+    }
+    check(tIndex == aLength, "descriptors do not end at wTotalLength");
+    check(tEndpointsExpected == 0, "last interface has less endpoints than bNumEndpoints");
+    check(tIADSeen, "missing interface association descriptor");
+    for (int i = 0; i < COMPOSITE_NUMBER_OF_INTERFACES; ++i) {
+        check(tInterfaceSeen[i], "interface missing");
+    }
+    for (int i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        if ((CompositeEndpoints[i].Address & 0x7F) != 0) {
+            check(tEndpointSeen[i], "endpoint of table missing in descriptor");
+        }
+    }
+}
+
+static void testConfigDescriptor(void) {
+    uint8_t tBuffer[COMPOSITE_CONFIG_DESCRIPTOR_MAX_LENGTH + 1];
+    uint16_t tLength = USBD_Composite_buildConfigDescriptor(tBuffer, COMPOSITE_CONFIG_DESCRIPTOR_MAX_LENGTH,
+    HID_REPORT_DESCRIPTOR_LENGTH);
+    printf("Configuration descriptor: %u of %u bytes\n", tLength, COMPOSITE_CONFIG_DESCRIPTOR_MAX_LENGTH);
+    check(tLength > 0, "build of configuration descriptor");
+    if (tLength == 0) {
+        return;
+    }
+    for (int i = 0; i < tLength; i += 16) {
+        printf(" ");
+        for (int j = i; j < i + 16 && j < tLength; ++j) {
+            printf(" %02X", tBuffer[j]);
+        }
+        printf("\n");
+    }
+    checkConfigDescriptor(tBuffer, tLength);
+
+    for (uint16_t tSize = 0; tSize < tLength; ++tSize) {
+        memset(tBuffer, CANARY, sizeof(tBuffer));
+        check(USBD_Composite_buildConfigDescriptor(tBuffer, tSize, HID_REPORT_DESCRIPTOR_LENGTH) == 0,
+                "build into too small buffer must fail");
+        check(tBuffer[tSize] == CANARY, "build wrote behind buffer");
+    }
+    check(USBD_Composite_buildConfigDescriptor(tBuffer, tLength, HID_REPORT_DESCRIPTOR_LENGTH) == tLength, "build into exact buffer");
+    check(getCompositeEndpointConfig(0x85) == NULL, "unknown endpoint address");
+}
+
+int main(void) {
+    testPMAAllocation();
+    testConfigDescriptor();
+    printf("%d failed checks\n", sErrorCount);
+    return sErrorCount;
+}
@@ -0,0 +1,189 @@
+/*
+ * @file WriteBehindBenchmark.c
+ *
+ * Host benchmark of the write behind queue writeBehind.c on the SPI level card simulator mmc_sim.c.
+ * The store of an AccuCapacity chart and the CSV export are written once synchronous like before the queue
+ * and once by the queue, serviced by a loop which spends 1 ms of simulated GUI time per call.
+ * The longest blocking time of the loop is printed for both and the files must be equal.
+ * Then the copy semantic of WriteBehind_write(), padding, errors of the card and a full queue are checked.
+ *
+ * Build from the repository root:
+ * gcc -O2 -Iextras/host -Ilib/fat_sd -o WriteBehindBenchmark extras/WriteBehindBenchmark.c extras/host/hostPlatform.c
+ *     lib/fat_sd/ff.c lib/fat_sd/options/ccsbcs.c lib/fat_sd/mmc.c lib/fat_sd/mmc_sim.c lib/fat_sd/writeBehind.c
+ * Usage: WriteBehindBenchmark
+ * Returns the number of failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "writeBehind.h"
+#include "timing.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "host/hostTest.h"
+
+#define ACCU_BATTERY_CONTROL_SIZE       4864    // sizeof(BatteryControl[0]) with 2 x 1200 samples
+#define ACCU_EXPORT_LINES               1200
+#define GUI_LOOP_MICROS                 1000    // simulated duration of the rest of loopAccuCapacity()
+#define STRING_BUFFER_SIZE              240     // sStringBuffer, used by doExportChart()
+#define FILE_BUFFER_SIZE                40000
+
+static uint8_t sBatteryControl[ACCU_BATTERY_CONTROL_SIZE];
+static uint8_t sFile1[FILE_BUFFER_SIZE];
+static uint8_t sFile2[FILE_BUFFER_SIZE];
+static int sCallbackCount;
+static FRESULT sCallbackResult;
+static void callbackCompleted(FRESULT aResult, void *aContext) {
+    (void) aContext;
+    sCallbackCount++;
+    sCallbackResult = aResult;
+}
+
+/*
+ * Generates the lines of doExportChart()
+ */
+static UINT generateExportLines(uint8_t *aBuffer, UINT aSize, void *aContext) {
+    int *tLineIndex = (int*) aContext;
+    UINT tLength = 0;
+    while (*tLineIndex < ACCU_EXPORT_LINES && aSize - tLength > 13) {
+        tLength += snprintf((char*) &aBuffer[tLength], aSize - tLength, "%6.3f;%5d\n", 4.15 - *tLineIndex * 0.0007,
+                150 + *tLineIndex / 100);
+        (*tLineIndex)++;
+    }
+    return tLength;
+}
+
+static UINT readFile(const char *aFileName, uint8_t *aBuffer) {
+    FIL tFile;
+    UINT tCount = 0;
+    if (f_open(&tFile, aFileName, FA_OPEN_EXISTING | FA_READ) == FR_OK) {
+        f_read(&tFile, aBuffer, FILE_BUFFER_SIZE, &tCount);
+        f_close(&tFile);
+    }
+    return tCount;
+}
+
+/*
+ * The complete store and export blocks the loop
+ */
+static void writeSynchronous(void) {
+    FIL tFile;
+    UINT tCount;
+    uint32_t tStartMicros = micros();
+    check(f_open(&tFile, "sync.bin", FA_CREATE_ALWAYS | FA_WRITE) == FR_OK, "open for synchronous write");
+    f_write(&tFile, sBatteryControl, sizeof(sBatteryControl), &tCount);
+    char tLines[STRING_BUFFER_SIZE];
+    int tLineIndex = 0;
+    UINT tLength;
+    while ((tLength = generateExportLines((uint8_t*) tLines, sizeof(tLines), &tLineIndex)) > 0) {
+        f_write(&tFile, tLines, tLength, &tCount);
+    }
+    f_write(&tFile, "END\n", 4, &tCount);
+    check(f_close(&tFile) == FR_OK, "close of synchronous write");
+    printf("Synchronous: loop blocked for %lu us\n", (unsigned long) (micros() - tStartMicros));
+    HostPlatform_printCardStatistics("synchronous store and export");
+}
+
+static void writeBehind(void) {
+    WriteBehind_resetStatistics();
+    uint8_t tFileHandle = WriteBehind_open("behind.bin");
+    check(tFileHandle != WRITE_BEHIND_INVALID_HANDLE, "WriteBehind_open");
+    check(WriteBehind_writeReference(tFileHandle, sBatteryControl, sizeof(sBatteryControl)), "WriteBehind_writeReference");
+    static int sLineIndex;
+    check(WriteBehind_writeGenerated(tFileHandle, &generateExportLines, &sLineIndex), "WriteBehind_writeGenerated");
+    check(WriteBehind_write(tFileHandle, "END\n", 4), "WriteBehind_write");
+    check(WriteBehind_sync(tFileHandle, &callbackCompleted, NULL), "WriteBehind_sync");
+    check(WriteBehind_close(tFileHandle, &callbackCompleted, NULL), "WriteBehind_close");
+
+    uint32_t tStartMicros = micros();
+    int tLoops = 0;
+    while (WriteBehind_getQueueDepth() > 0) {
+        WriteBehind_service();
+        HostPlatform_spendMicros(GUI_LOOP_MICROS);
+        tLoops++;
+    }
+    const WriteBehindStatisticsTypeDef *tStatistics = WriteBehind_getStatistics();
+    printf("Write behind: %d loops in %lu us, loop blocked for max %lu us, max interval %lu us, %lu busy deferrals\n", tLoops,
+            (unsigned long) (micros() - tStartMicros), (unsigned long) tStatistics->ServiceMicrosMax,
+            (unsigned long) tStatistics->LoopMicrosMax, (unsigned long) tStatistics->BusyDeferrals);
+    printf("  max queue depth %u, max ring buffer usage %u bytes\n", tStatistics->QueueDepthMax, tStatistics->BufferUsedMax);
+    check(sCallbackCount == 2 && sCallbackResult == FR_OK, "callbacks of sync and close");
+    check(tStatistics->Errors == 0, "errors of write behind");
+    HostPlatform_printCardStatistics("write behind store and export");
+
+    UINT tLength1 = readFile("sync.bin", sFile1);
+    UINT tLength2 = readFile("behind.bin", sFile2);
+    check(tLength1 > sizeof(sBatteryControl) && tLength1 == tLength2 && memcmp(sFile1, sFile2, tLength1) == 0,
+            "files of synchronous write and write behind differ");
+}
+
+/*
+ * Data given to WriteBehind_write() is copied, so later changes are not written.
+ * The binary export writes header and columns padded to sector boundaries.
+ */
+static void checkCopyAndPadding(void) {
+    uint8_t tHeader[68];
+    memset(tHeader, 0xAA, sizeof(tHeader));
+    uint8_t tFileHandle = WriteBehind_open("padded.bin");
+    check(WriteBehind_write(tFileHandle, tHeader, sizeof(tHeader)) && WriteBehind_padToSector(tFileHandle)
+            && WriteBehind_writeReference(tFileHandle, sBatteryControl, 2000) && WriteBehind_padToSector(tFileHandle),
+            "queue header and column");
+    memset(tHeader, 0x55, sizeof(tHeader));
+    WriteBehind_close(tFileHandle, NULL, NULL);
+    check(WriteBehind_waitForCompletion(1000) == FR_OK, "WriteBehind_waitForCompletion");
+
+    UINT tLength = readFile("padded.bin", sFile1);
+    check(tLength == 512 + 2048, "size of padded file");
+    check(sFile1[0] == 0xAA && sFile1[67] == 0xAA, "copied data was changed");
+    check(sFile1[68] == 0 && sFile1[511] == 0 && sFile1[512 + 2047] == 0, "padding is not zero");
+    check(memcmp(&sFile1[512], sBatteryControl, 2000) == 0, "referenced data");
+}
+
+static void checkErrors(void) {
+    sCallbackCount = 0;
+    uint8_t tFileHandle = WriteBehind_open("nodir/bad.bin");
+    WriteBehind_write(tFileHandle, "abc", 3);
+    WriteBehind_close(tFileHandle, &callbackCompleted, NULL);
+    // errors are reported to the callback only
+    check(WriteBehind_waitForCompletion(1000) == FR_OK, "flush of failed file");
+    check(sCallbackCount == 1 && sCallbackResult == FR_NO_PATH, "callback must get error of open in missing directory");
+
+    WriteBehind_resetStatistics();
+    tFileHandle = WriteBehind_open("full.bin");
+    int tQueued = 0;
+    while (WriteBehind_write(tFileHandle, "0123456789", 10)) {
+        tQueued++;
+    }
+    // the close request must still be accepted
+    check(WriteBehind_close(tFileHandle, NULL, NULL), "close of full queue");
+    printf("Full queue: %d writes accepted, %lu rejected\n", tQueued, (unsigned long) WriteBehind_getStatistics()->RequestsRejected);
+    check(WriteBehind_getStatistics()->RequestsRejected > 0, "rejects of full queue");
+    check(WriteBehind_waitForCompletion(1000) == FR_OK && WriteBehind_getQueueDepth() == 0, "flush of full queue");
+    check(readFile("full.bin", sFile1) == (UINT) tQueued * 10, "size of file written by full queue");
+}
+
+int main(void) {
+    if (HostPlatform_mountCard(HOST_CARD_SECTOR_COUNT, 4, NULL) != FR_OK) {
+        printf("Mount of simulated card failed\n");
+        return 1;
+    }
+    HostPlatform_printCardStatistics("disk_initialize and f_mount");
+    for (unsigned int i = 0; i < sizeof(sBatteryControl); ++i) {
+        sBatteryControl[i] = (uint8_t) (i * 7);
+    }
+
+    writeSynchronous();
+    writeBehind();
+    checkCopyAndPadding();
+    checkErrors();
+
+    printf("%d failed checks, %lu error messages\n", sErrorCount, (unsigned long) HostPlatformErrorCount);
+    return sErrorCount;
+}
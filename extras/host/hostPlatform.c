@@ -0,0 +1,242 @@
+/*
+ * @file hostPlatform.c
+ *
+ * SPI1 and MicroSD functions of mmc.c mapped to mmc_sim.c.
+ * A DMA transfer is done completely by SPI1_DMA_startTransfer(), so the wait callback of mmc.c
+ * runs only while the card is busy programming.
+ * A byte exchanged by SPI1_sendReceiveFast() costs the CPU the time of the byte on the bus,
+ * a DMA transfer by MMCSim_exchangeBlock() only its setup and end, independent of its length.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "hostPlatform.h"
+#include "timing.h"
+#include "stm32fx0xPeripherals.h"
+#include "main.h"
+#include "diskio.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+FATFS Fatfs[1];
+char sStringBuffer[SIZEOF_STRINGBUFFER];
+uint32_t HostPlatformErrorCount;
+
+static uint8_t *sCardImage;
+static MMCSimImageTypeDef sImage;
+static uint32_t sTimeoutMillis;
+
+/*
+ * Time
+ */
+uint32_t millis(void) {
+    return (uint32_t) (MMCSim_getMicros() / 1000);
+}
+
+uint32_t micros(void) {
+    return (uint32_t) MMCSim_getMicros();
+}
+
+void HostPlatform_spendMicros(uint32_t aMicros) {
+    MMCSim_advanceMicros(aMicros);
+}
+
+void setTimeoutMillis(int32_t aTimeMillis) {
+    sTimeoutMillis = millis() + aTimeMillis;
+}
+
+bool isTimeoutSimple(void) {
+    return (int32_t) (millis() - sTimeoutMillis) > 0;
+}
+
+/*
+ * Every call is one SysTick, so the debounce loop of the card detect interrupt runs on simulated time
+ */
+bool hasSysticCounted(void) {
+    MMCSim_advanceMicros(1000);
+    return true;
+}
+
+uint32_t getLR14(void) {
+    return 0;
+}
+
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage) {
+    (void) aLinkRegister;
+    HostPlatformErrorCount++;
+    fprintf(stderr, "%s:%lu: %s %d\n", (char*) aFile, (unsigned long) aLine, aMessage, aWrongParameter);
+}
+
+DWORD get_fattime(void) {
+    // 19.10.2026 12:00:00
+    return ((DWORD) (2026 - 1980) << 25) | ((DWORD) 10 << 21) | ((DWORD) 19 << 16) | ((DWORD) 12 << 11);
+}
+
+/*
+ * SPI1 and card
+ */
+uint8_t SPI1_sendReceiveFast(uint8_t aDataByte) {
+    return MMCSim_exchange(aDataByte);
+}
+
+void SPI1_setPrescaler(uint16_t aPrescaler) {
+    (void) aPrescaler;
+}
+
+void SPI1_DMA_startTransfer(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength) {
+    MMCSim_exchangeBlock(aTransmitBuffer, aReceiveBuffer, aLength);
+}
+
+bool SPI1_DMA_isTransferOngoing(void) {
+    return false;
+}
+
+bool SPI1_DMA_waitForTransferEnd(uint32_t aTimeoutMillis) {
+    (void) aTimeoutMillis;
+    return true;
+}
+
+bool MICROSD_isCardInserted(void) {
+    return true;
+}
+
+void MICROSD_CSEnable(void) {
+    MMCSim_setChipSelect(true);
+}
+
+void MICROSD_CSDisable(void) {
+    MMCSim_setChipSelect(false);
+}
+
+void MICROSD_releaseSPI(void) {
+}
+
+void MICROSD_ClearITPendingBit(void) {
+}
+
+static void putWord(uint8_t *aBuffer, uint16_t aValue) {
+    aBuffer[0] = aValue;
+    aBuffer[1] = aValue >> 8;
+}
+
+static void putDoubleWord(uint8_t *aBuffer, uint32_t aValue) {
+    putWord(aBuffer, aValue);
+    putWord(aBuffer + 2, aValue >> 16);
+}
+
+/**
+ * Writes boot sector and empty FATs, 1 reserved sector, 2 FATs, 512 root directory entries
+ * @return false if the cluster count is not valid for FAT16
+ */
+bool HostPlatform_formatFAT16(uint8_t *aImage, uint32_t aSectorCount, uint8_t aSectorsPerCluster) {
+    uint32_t tClusters = aSectorCount / aSectorsPerCluster;
+    uint16_t tFATSectors = ((tClusters + 2) * 2 + 511) / 512;
+    uint32_t tDataClusters = (aSectorCount - 1 - 2 * tFATSectors - 32) / aSectorsPerCluster;
+    if (tDataClusters < 4086 || tDataClusters > 65524) {
+        return false;
+    }
+    memset(aImage, 0, (1 + 2 * tFATSectors + 32) * 512);
+    uint8_t *tBoot = aImage;
+    memcpy(tBoot, "\xEB\x3C\x90" "MSDOS5.0", 11);
+    putWord(&tBoot[11], 512);
+    tBoot[13] = aSectorsPerCluster;
+    putWord(&tBoot[14], 1); // reserved sectors
+    tBoot[16] = 2; // FATs
+    putWord(&tBoot[17], 512); // root entries
+    if (aSectorCount < 0x10000) {
+        putWord(&tBoot[19], aSectorCount);
+    } else {
+        putDoubleWord(&tBoot[32], aSectorCount);
+    }
+    tBoot[21] = 0xF8; // media
+    putWord(&tBoot[22], tFATSectors);
+    putWord(&tBoot[24], 63);
+    putWord(&tBoot[26], 255);
+    tBoot[36] = 0x80;
+    tBoot[38] = 0x29;
+    putDoubleWord(&tBoot[39], 0x19102026);
+    memcpy(&tBoot[43], "SIM        FAT16   ", 19);
+    tBoot[510] = 0x55;
+    tBoot[511] = 0xAA;
+    for (int i = 0; i < 2; ++i) {
+        memcpy(&aImage[(1 + i * tFATSectors) * 512], "\xF8\xFF\xFF\xFF", 4);
+    }
+    return true;
+}
+
+/**
+ * Allocates and formats a card image, initializes the simulator and mounts the card as drive 0.
+ * An image of a previous call is freed.
+ * @param aTiming NULL for the default timing of mmc_sim.c
+ */
+FRESULT HostPlatform_mountCard(uint32_t aSectorCount, uint8_t aSectorsPerCluster, const MMCSimTimingTypeDef *aTiming) {
+    free(sCardImage);
+    sCardImage = calloc(aSectorCount, 512);
+    if (sCardImage == NULL || !HostPlatform_formatFAT16(sCardImage, aSectorCount, aSectorsPerCluster)) {
+        return FR_MKFS_ABORTED;
+    }
+    MMCSim_initMemoryImage(&sImage, sCardImage, aSectorCount);
+    MMCSim_init(&sImage, aTiming);
+    if (disk_initialize(0) != 0) {
+        return FR_NOT_READY;
+    }
+    return f_mount(0, &Fatfs[0]);
+}
+
+static uint32_t getCPUCyclesPerPIOByte(void) {
+    return (8 * (uint64_t) HOST_CPU_HERTZ) / MMCSim_getSPIClockHertz() + HOST_CPU_CYCLES_PER_PIO_BYTE;
+}
+
+/**
+ * @return CPU cycles of the SPI1 functions and the CRC16 of the transferred sectors since the last reset of the card statistics
+ */
+uint64_t HostPlatform_getCPUCycles(void) {
+    const MMCSimStatisticsTypeDef *tStatistics = MMCSim_getStatistics();
+    uint32_t tCyclesPerByte = getCPUCyclesPerPIOByte();
+    uint64_t tCycles = (tStatistics->BytesExchanged - tStatistics->BlockBytesExchanged) * tCyclesPerByte
+            + (uint64_t) tStatistics->BlockExchanges * HOST_CPU_CYCLES_PER_DMA_TRANSFER;
+    if (MMCSim_isCRCEnabled()) {
+        tCycles += (uint64_t) (tStatistics->SectorsRead + tStatistics->SectorsWritten) * 512 * HOST_CPU_CYCLES_PER_CRC_BYTE;
+    }
+    return tCycles;
+}
+
+/**
+ * @return The part of HostPlatform_getCPUCycles(), which is spent polling for the data token or for the end of busy.
+ * Independent of the DMA, it depends on the card and can be used by the wait callback of mmc.c.
+ */
+uint64_t HostPlatform_getPollingCPUCycles(void) {
+    const MMCSimStatisticsTypeDef *tStatistics = MMCSim_getStatistics();
+    return (uint64_t) (tStatistics->ReadAccessBytes + tStatistics->BusyBytes) * getCPUCyclesPerPIOByte();
+}
+
+/**
+ * @return sector bytes per CPU cycle without polling, since the last reset of the card statistics
+ */
+double HostPlatform_getSectorBytesPerCPUCycle(void) {
+    const MMCSimStatisticsTypeDef *tStatistics = MMCSim_getStatistics();
+    uint64_t tCycles = HostPlatform_getCPUCycles() - HostPlatform_getPollingCPUCycles();
+    if (tCycles == 0) {
+        return 0.0;
+    }
+    return (double) (tStatistics->SectorsRead + tStatistics->SectorsWritten) * 512 / tCycles;
+}
+
+/**
+ * Prints the card statistics and the sector bytes per CPU cycle since the last call and resets them
+ */
+void HostPlatform_printCardStatistics(const char *aOperationName) {
+    char tBuffer[400];
+    MMCSim_printStatistics(tBuffer, sizeof(tBuffer), aOperationName);
+    printf("%s", tBuffer);
+    printf("%llu CPU cycles, %llu of them polling, %.3f sector bytes per CPU cycle without polling\n",
+            (unsigned long long) HostPlatform_getCPUCycles(), (unsigned long long) HostPlatform_getPollingCPUCycles(),
+            HostPlatform_getSectorBytesPerCPUCycle());
+    MMCSim_resetStatistics();
+}
@@ -0,0 +1,55 @@
+/*
+ * @file hostPlatform.h
+ *
+ * Platform functions for running ff.c, mmc.c and the card modules of lib/fat_sd on a Linux host.
+ * The card is simulated by mmc_sim.c on a memory image, which is formatted with FAT16.
+ * millis() and micros() return the simulated time, so timeouts and statistics of the modules are in target time.
+ * CPU time of the target is simulated by HostPlatform_spendMicros().
+ * The CPU cycles, which the target spends in the SPI1 functions and in the CRC16 of mmc.c, are counted
+ * with the cycle numbers below, to compare the DMA and the PIO (STM32_SD_USE_PIO) build of mmc.c.
+ *
+ * The headers in this directory replace the target headers timing.h, stm32fx0xPeripherals.h, stm32f3_discovery.h
+ * and main.h, so this directory must be the first include path, followed by lib/fat_sd.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef HOST_PLATFORM_H_
+#define HOST_PLATFORM_H_
+
+#include "ff.h"
+#include "mmc_sim.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HOST_CARD_SECTOR_COUNT  32768 // 16 MByte
+
+#define HOST_CPU_HERTZ                      72000000
+#define HOST_CPU_CYCLES_PER_PIO_BYTE        8   // write DR, poll RXNE and read DR of SPI1_sendReceiveFast(), in addition to the 8 SPI clocks
+#define HOST_CPU_CYCLES_PER_DMA_TRANSFER    150 // setup of 2 DMA channels, transfer complete interrupt and end check
+#define HOST_CPU_CYCLES_PER_CRC_BYTE        7   // table CRC16 loop of mmc.c
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool HostPlatform_formatFAT16(uint8_t *aImage, uint32_t aSectorCount, uint8_t aSectorsPerCluster);
+FRESULT HostPlatform_mountCard(uint32_t aSectorCount, uint8_t aSectorsPerCluster, const MMCSimTimingTypeDef *aTiming);
+void HostPlatform_spendMicros(uint32_t aMicros);
+uint64_t HostPlatform_getCPUCycles(void);
+uint64_t HostPlatform_getPollingCPUCycles(void);
+double HostPlatform_getSectorBytesPerCPUCycle(void);
+void HostPlatform_printCardStatistics(const char *aOperationName);
+
+extern uint32_t HostPlatformErrorCount; // calls of assertFailedParamMessage()
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_PLATFORM_H_ */
@@ -0,0 +1,41 @@
+/*
+ * @file hostTest.h
+ *
+ * Check function of the host tests and benchmarks in extras.
+ * Each program includes this file once, counts the failed checks in sErrorCount and returns it from main(),
+ * which makes "make -C extras test" fail.
+ *
+ * HOST_TEST_MAX_ERRORS can be defined before the include to stop a program after too many failed checks.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef HOST_TEST_H_
+#define HOST_TEST_H_
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if !defined(HOST_TEST_MAX_ERRORS)
+#define HOST_TEST_MAX_ERRORS    0 // 0 -> never stop
+#endif
+
+static int sErrorCount;
+
+static void check(bool aCondition, const char *aMessage) {
+    if (!aCondition) {
+        sErrorCount++;
+        printf("FAILED: %s\n", aMessage);
+        if (HOST_TEST_MAX_ERRORS > 0 && sErrorCount > HOST_TEST_MAX_ERRORS) {
+            printf("Too many errors\n");
+            exit(sErrorCount);
+        }
+    }
+}
+
+#endif /* HOST_TEST_H_ */
@@ -0,0 +1,19 @@
+/*
+ * @file main.h
+ *
+ * Host replacement of src/main.h for mmc.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+#define SIZEOF_STRINGBUFFER 240
+extern char sStringBuffer[SIZEOF_STRINGBUFFER];
+
+#endif /* MAIN_H_ */
@@ -0,0 +1,20 @@
+/*
+ * @file stm32f3_discovery.h
+ *
+ * Host replacement of the board support header for the LED calls of mmc.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STM32F3_DISCOVERY_H_
+#define STM32F3_DISCOVERY_H_
+
+#define LED_RED_2 0
+#define BSP_LED_On(aLed)    ((void) (aLed))
+#define BSP_LED_Off(aLed)   ((void) (aLed))
+
+#endif /* STM32F3_DISCOVERY_H_ */
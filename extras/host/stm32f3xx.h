@@ -0,0 +1,44 @@
+/*
+ * @file stm32f3xx.h
+ *
+ * Host replacement of the CMSIS device header for the exclusive access and interrupt mask intrinsics
+ * used by the local display and BlueDisplay code. The host programs are single threaded.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STM32F3XX_H_
+#define STM32F3XX_H_
+
+#include <stdint.h>
+
+#define __STATIC_INLINE static inline
+
+__STATIC_INLINE uint32_t __LDREXW(volatile uint32_t *aAddress) {
+    return *aAddress;
+}
+
+__STATIC_INLINE uint32_t __STREXW(uint32_t aValue, volatile uint32_t *aAddress) {
+    *aAddress = aValue;
+    return 0; // success
+}
+
+__STATIC_INLINE uint32_t __get_PRIMASK(void) {
+    return 0;
+}
+
+__STATIC_INLINE void __set_PRIMASK(uint32_t aPriMask) {
+    (void) aPriMask;
+}
+
+__STATIC_INLINE void __disable_irq(void) {
+}
+
+__STATIC_INLINE void __enable_irq(void) {
+}
+
+#endif /* STM32F3XX_H_ */
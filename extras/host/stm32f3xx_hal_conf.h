@@ -0,0 +1,16 @@
+/*
+ * @file stm32f3xx_hal_conf.h
+ *
+ * Empty host replacement of the HAL configuration included by BlueSerial.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STM32F3XX_HAL_CONF_H_
+#define STM32F3XX_HAL_CONF_H_
+
+#endif /* STM32F3XX_HAL_CONF_H_ */
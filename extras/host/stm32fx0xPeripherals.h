@@ -0,0 +1,44 @@
+/*
+ * @file stm32fx0xPeripherals.h
+ *
+ * Host replacement of lib/include/stm32fx0xPeripherals.h with the SPI1 and MicroSD functions used by mmc.c.
+ * They are implemented in hostPlatform.c on top of mmc_sim.c.
+ * RTC_getDateStringForFile() is used by SSD1289.hpp and must be defined by the program.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STM32FX0XPERIPHERALS_H_
+#define STM32FX0XPERIPHERALS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPI_BAUDRATEPRESCALER_2     0x00
+#define SPI_BAUDRATEPRESCALER_256   0x38
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint8_t SPI1_sendReceiveFast(uint8_t aDataByte);
+void SPI1_setPrescaler(uint16_t aPrescaler);
+void SPI1_DMA_startTransfer(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength);
+bool SPI1_DMA_isTransferOngoing(void);
+bool SPI1_DMA_waitForTransferEnd(uint32_t aTimeoutMillis);
+
+bool MICROSD_isCardInserted(void);
+void MICROSD_CSEnable(void);
+void MICROSD_CSDisable(void);
+void MICROSD_releaseSPI(void);
+void MICROSD_ClearITPendingBit(void);
+
+int RTC_getDateStringForFile(char *aStringBuffer);
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32FX0XPERIPHERALS_H_ */
@@ -0,0 +1,42 @@
+/*
+ * @file timing.h
+ *
+ * Host replacement of lib/include/timing.h for the programs in extras.
+ * The functions are defined by each program, hostPlatform.c uses the simulated time of mmc_sim.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(int32_t aTimeMillis);
+void delayNanos(int32_t aTimeNanos);
+void registerDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis);
+void changeDelayCallback(void (*aGenericCallback)(void), int32_t aTimeMillis);
+
+void setTimeoutMillis(int32_t aTimeMillis);
+bool isTimeoutSimple(void);
+#define isTimeout(aValue) isTimeoutSimple()
+bool hasSysticCounted(void);
+
+uint32_t getLR14(void);
+void assertFailedParamMessage(uint8_t *aFile, uint32_t aLine, uint32_t aLinkRegister, int aWrongParameter, const char *aMessage);
+#define failParamMessage(wrongParam,message) (assertFailedParamMessage((uint8_t *)__FILE__, __LINE__,getLR14(),(int)wrongParam ,message))
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMING_H_ */
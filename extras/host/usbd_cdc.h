@@ -0,0 +1,42 @@
+/*
+ * usbd_cdc.h
+ *
+ * Host replacement of the CDC class definitions of the USB device library, which are used by usbd_cdc_interface.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef USBD_CDC_H_
+#define USBD_CDC_H_
+
+#include "usbd_def.h"
+
+#define CDC_SEND_ENCAPSULATED_COMMAND   0x00
+#define CDC_GET_ENCAPSULATED_RESPONSE   0x01
+#define CDC_SET_COMM_FEATURE            0x02
+#define CDC_GET_COMM_FEATURE            0x03
+#define CDC_CLEAR_COMM_FEATURE          0x04
+#define CDC_SET_LINE_CODING             0x20
+#define CDC_GET_LINE_CODING             0x21
+#define CDC_SET_CONTROL_LINE_STATE      0x22
+#define CDC_SEND_BREAK                  0x23
+
+typedef struct {
+    uint32_t bitrate;
+    uint8_t format;
+    uint8_t paritytype;
+    uint8_t datatype;
+} USBD_CDC_LineCodingTypeDef;
+
+typedef struct {
+    int8_t (*Init)(void);
+    int8_t (*DeInit)(void);
+    int8_t (*Control)(uint8_t cmd, uint8_t *pbuf, uint16_t length);
+    int8_t (*Receive)(uint8_t *Buf, uint32_t *Len);
+} USBD_CDC_ItfTypeDef;
+
+#endif /* USBD_CDC_H_ */
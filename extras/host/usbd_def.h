@@ -0,0 +1,34 @@
+/*
+ * usbd_def.h
+ *
+ * Host replacement of the USB device library definitions, which are used by the headers in lib/usb/include.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef USBD_DEF_H_
+#define USBD_DEF_H_
+
+#include <stdint.h>
+
+#define USBD_OK     0
+#define USBD_BUSY   1
+#define USBD_FAIL   2
+
+typedef struct {
+    uint8_t dev_state;
+} USBD_HandleTypeDef;
+
+typedef struct {
+    uint8_t (*Init)(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+} USBD_ClassTypeDef;
+
+typedef struct {
+    uint8_t *(*GetDeviceDescriptor)(uint8_t speed, uint16_t *length);
+} USBD_DescriptorsTypeDef;
+
+#endif /* USBD_DEF_H_ */
@@ -268,9 +268,25 @@ void BDSlider::setValueScaleFactor(float aScaleFactorValue) {
 }
 #pragma GCC diagnostic pop
 
+/*
+ * With local display, an unchanged value string is neither drawn nor sent,
+ * since local and remote slider got the same value strings.
+ */
 void BDSlider::printValue(const char *aValueString) {
 #if defined(SUPPORT_LOCAL_DISPLAY)
-    mLocalSliderPointer->printValue(aValueString);
+    bool tIsUnchanged = mLocalSliderPointer->isValueStringDrawn(aValueString);
+    mLocalSliderPointer->printValue(aValueString); // draws only if changed
+    if (USART_isBluetoothPaired()) {
+        uint16_t tMessageSize = (1 * 2) + 8 + strlen(aValueString); // see sendUSARTArgsAndByteBuffer()
+        if (tIsUnchanged) {
+            LocalTouchSlider::getDrawStatistics()->BytesSkipped += tMessageSize;
+        } else {
+            LocalTouchSlider::getDrawStatistics()->BytesSent += tMessageSize;
+        }
+    }
+    if (tIsUnchanged) {
+        return;
+    }
 #endif
     sendUSARTArgsAndByteBuffer(FUNCTION_SLIDER_PRINT_VALUE, 1, mSliderHandle, strlen(aValueString), aValueString);
 }
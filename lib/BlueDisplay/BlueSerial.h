@@ -111,6 +111,17 @@ void sendUSART5Args(uint8_t aFunctionTag, uint16_t aStartX, uint16_t aStartY, ui
 void sendUSARTBufferNoSizeCheck(uint8_t *aParameterBufferPointer, uint8_t aParameterBufferLength, uint8_t *aDataBufferPointer,
         size_t aDataBufferLength);
 
+/*
+ * The transport used for BlueDisplay communication.
+ * On STM32 with BD_SUPPORT_USB_CDC defined, it can be switched at runtime between USART and USB CDC.
+ * USB CDC has no baud rate limit, so it is approximately 10 times faster than the 115200 baud of the USART.
+ */
+//#define BD_SUPPORT_USB_CDC
+#define BD_TRANSPORT_UART       0 // USART connected to a Bluetooth module
+#define BD_TRANSPORT_USB_CDC    1 // USB virtual COM port
+uint8_t getBDTransport(void);
+void setBDTransport(uint8_t aTransport);
+
 /*
  * Functions only valid for standard serial
  */
@@ -149,18 +160,27 @@ void initSimpleSerial(uint32_t aBaudRate, bool aUsePairedPin);
  * Stuff for STM
  */
 #ifdef STM32F303xC
-#define UART_BD                     USART3
+/*
+ * UART4 instead of USART3 on the same pins, since the USART3 DMA channels 1.2 and 1.3 are the only SPI1 DMA channels,
+ * which are required for the MicroSD card sector transfers.
+ */
+#define UART_BD                     UART4
 #define UART_BD_TX_PIN              GPIO_PIN_10
 #define UART_BD_RX_PIN              GPIO_PIN_11
 #define UART_BD_PORT                GPIOC
+#define UART_BD_GPIO_AF             GPIO_AF5_UART4
 #define UART_BD_IO_CLOCK_ENABLE()   __GPIOC_CLK_ENABLE()
-#define UART_BD_CLOCK_ENABLE()      __USART3_CLK_ENABLE()
-#define UART_BD_IRQ                 USART3_IRQn
-#define UART_BD_IRQHANDLER          USART3_IRQHandler
-
-#define UART_BD_DMA_TX_CHANNEL      DMA1_Channel2
-#define UART_BD_DMA_RX_CHANNEL      DMA1_Channel3
-#define UART_BD_DMA_CLOCK_ENABLE()  __DMA1_CLK_ENABLE()
+#define UART_BD_CLOCK_ENABLE()      __UART4_CLK_ENABLE()
+#define UART_BD_IRQ                 UART4_IRQn
+#define UART_BD_IRQHANDLER          UART4_IRQHandler
+
+#define UART_BD_DMA_TX_CHANNEL      DMA2_Channel5
+#define UART_BD_DMA_RX_CHANNEL      DMA2_Channel3
+#define UART_BD_DMA_CLOCK_ENABLE()  __DMA2_CLK_ENABLE()
+#define UART_BD_DMA_TX_IRQHANDLER   DMA2_Channel5_IRQHandler
+#define UART_BD_DMA_TX_FLAG_TC      DMA_FLAG_TC5
+#define UART_BD_DMA_TX_FLAG_TE      DMA_FLAG_TE5
+#define UART_BD_DMA_TX_FLAG_HT      DMA_FLAG_HT5
 
 #define BLUETOOTH_PAIRED_DETECT_PIN     GPIO_PIN_13
 #define BLUETOOTH_PAIRED_DETECT_PORT    GPIOC
@@ -179,6 +199,10 @@ void initSimpleSerial(uint32_t aBaudRate, bool aUsePairedPin);
 #define UART_BD_DMA_TX_CHANNEL      DMA1_Channel4
 #define UART_BD_DMA_RX_CHANNEL      DMA1_Channel5
 #define UART_BD_DMA_CLOCK_ENABLE()  __DMA1_CLK_ENABLE()
+#define UART_BD_DMA_TX_IRQHANDLER   DMA1_Channel4_IRQHandler
+#define UART_BD_DMA_TX_FLAG_TC      DMA_FLAG_TC4
+#define UART_BD_DMA_TX_FLAG_TE      DMA_FLAG_TE4
+#define UART_BD_DMA_TX_FLAG_HT      DMA_FLAG_HT4
 
 #define BLUETOOTH_PAIRED_DETECT_PIN     GPIO_PIN_7
 #define BLUETOOTH_PAIRED_DETECT_PORT    GPIOA
@@ -34,6 +34,12 @@
 #include <cstdarg> // for va_start, va_list etc.
 #endif
 
+#if defined(BD_SUPPORT_USB_CDC)
+extern "C" {
+#include "usbd_misc.h" // for CDC_sendBuffer(), isUsbCdcReady() etc.
+}
+#endif
+
 #if defined(__AVR__)
 #  if defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY)
 #include "LocalDisplay/digitalWriteFast.h"
@@ -81,6 +87,25 @@ static uint8_t sReceivedEventType = EVENT_NO_EVENT; // Buffer for EventType unti
 static uint8_t sReceivedDataSize;
 
 bool usePairedPin = false; // Use pin of BT module to decide if BT is paired, this cannot be done by using software managed mBlueDisplayConnectionEstablished value
+uint8_t sBDTransport = BD_TRANSPORT_UART;
+
+uint8_t getBDTransport(void) {
+    return sBDTransport;
+}
+
+/*
+ * Switching the transport discards a partially received event
+ */
+void setBDTransport(uint8_t aTransport) {
+#if defined(BD_SUPPORT_USB_CDC)
+    sBDTransport = aTransport;
+    sUSBCDCIsBlueDisplayTransport = (aTransport == BD_TRANSPORT_USB_CDC);
+#else
+    (void) aTransport;
+#endif
+    sReceivedEventType = EVENT_NO_EVENT;
+    sReceiveBufferOutOfSync = false;
+}
 void setUsePairedPin(bool aUsePairedPin) {
 #if defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY) && defined(ARDUINO)
     usePairedPin = aUsePairedPin;
@@ -101,6 +126,11 @@ void setUsePairedPin(bool aUsePairedPin) {
  * It is reduced to return true if not defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY)
  */
 bool USART_isBluetoothPaired(void) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        return isUsbCdcReady();
+    }
+#endif
 #if defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY)
 #  if defined(STM32F303xC) || defined(STM32F103xB)
     return ((BLUETOOTH_PAIRED_DETECT_PORT->IDR & BLUETOOTH_PAIRED_DETECT_PIN) != 0);
@@ -549,6 +579,7 @@ ISR(USART1_RX_vect) {
 
 #include "timing.h"
 #include "stm32fx0xPeripherals.h" // For Watchdog_reload()
+#include "Profiler.h"
 
 #include <string.h> // for memcpy
 #include <stdarg.h>  // for varargs
@@ -616,7 +647,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef *aUARTHandle) {
         GPIO_InitStructure.Speed = GPIO_SPEED_HIGH;
         GPIO_InitStructure.Mode = GPIO_MODE_AF_PP;
         GPIO_InitStructure.Pull = GPIO_PULLUP;
-        GPIO_InitStructure.Alternate = GPIO_AF7_USART3;
+        GPIO_InitStructure.Alternate = UART_BD_GPIO_AF;
 #else
         // need 2 calls
         GPIO_InitStructure.Pin = UART_BD_TX_PIN;
@@ -729,7 +760,7 @@ uint32_t getUSART_BD_BaudRate(void) {
  * Used by buffer error/overrun handling
  */
 void UART_BD_DMA_RX_reset(void) {
-// Disable DMA1 channel2 - is really needed here!
+// Disable DMA RX channel - is really needed here!
     UART_BD_Handle.hdmarx->Instance->CCR &= ~DMA_CCR_EN;
 
 // Write to DMA1 CMAR
@@ -801,6 +832,7 @@ void UART_BD_DMA_TX_start(uint32_t aMemoryBaseAddr, uint32_t aBufferSize) {
  * Therefore we must use USART and not the DMA TC interrupt!
  */
 extern "C" void UART_BD_IRQHANDLER(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_USART, PROFILER_LATENCY_UNKNOWN);
     //if (USART_GetITStatus(UART_BD_Handle.Instance, USART_IT_TC) != RESET) {
     if (__HAL_UART_GET_FLAG(&UART_BD_Handle, UART_FLAG_TC) != RESET) {
 
@@ -828,6 +860,7 @@ extern "C" void UART_BD_IRQHANDLER(void) {
             }
         }
     }
+    PROFILER_ISR_EXIT(PROFILER_ISR_USART);
 }
 
 /*
@@ -846,6 +879,11 @@ uint8_t* putSendBuffer(uint8_t *aUSARTSendBufferPointerIn, uint8_t aData) {
 }
 
 int getSendBufferFreeSpace(void) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        return CDC_getSendBufferFreeSpace();
+    }
+#endif
     if (sUSARTSendBufferPointerOut == sUSARTSendBufferPointerIn && !sDMATransferOngoing) {
         // buffer empty
         return UART_SEND_BUFFER_SIZE;
@@ -863,6 +901,13 @@ int getSendBufferFreeSpace(void) {
  */
 void sendUSARTBufferNoSizeCheck(uint8_t *aParameterBufferPointer, uint8_t aParameterBufferLength, uint8_t *aDataBufferPointer,
         size_t aDataBufferLength) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        // CDC_sendBuffer() handles buffers greater than the send buffer by itself
+        CDC_sendBuffer(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+        return;
+    }
+#endif
 #if defined(BD_USE_SIMPLE_SERIAL)
     sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
     return;
@@ -955,6 +1000,13 @@ void sendUSARTBufferNoSizeCheck(uint8_t *aParameterBufferPointer, uint8_t aParam
  */
 void sendUSARTBuffer(uint8_t *aParameterBufferPointer, size_t aParameterBufferLength, uint8_t *aDataBufferPointer,
         size_t aDataBufferLength) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        // CDC_sendBuffer() handles buffers greater than the send buffer by itself
+        CDC_sendBuffer(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
+        return;
+    }
+#endif
 #if defined(BD_USE_SIMPLE_SERIAL)
     sendUSARTBufferSimple(aParameterBufferPointer, aParameterBufferLength, aDataBufferPointer, aDataBufferLength);
     return;
@@ -1050,6 +1102,11 @@ uint16_t getReceiveBufferWord(void) {
  * Get a byte from receive buffer, clear it in buffer and handle buffer wrap around
  */
 uint8_t getReceiveBufferByte(void) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        return CDC_getReceiveBufferByte();
+    }
+#endif
     uint8_t *tUSARTReceiveBufferPointer = sUSARTReceiveBufferPointer;
     uint8_t tResult = *tUSARTReceiveBufferPointer;
     *tUSARTReceiveBufferPointer = 0x00;
@@ -1069,6 +1126,11 @@ uint8_t getReceiveBufferByte(void) {
  * computes received bytes since LastRXDMACount
  */
 size_t getReceiveBytesAvailable(void) {
+#if defined(BD_SUPPORT_USB_CDC)
+    if (sBDTransport == BD_TRANSPORT_USB_CDC) {
+        return CDC_getReceiveBytesAvailable();
+    }
+#endif
     size_t tCount = UART_BD_Handle.hdmarx->Instance->CNDTR;
     if (tCount <= sLastRXDMACount) {
         return sLastRXDMACount - tCount;
@@ -1082,23 +1144,23 @@ size_t getReceiveBytesAvailable(void) {
  * NOT USED YET - maybe useful for Error Interrupt IT_TE2
  */
 // starting a new DMA just after DMA TC interrupt corrupts the last byte of the transfer still ongoing.
-extern "C" void DMA1_Channel2_IRQHandler(void) {
+extern "C" void UART_BD_DMA_TX_IRQHANDLER(void) {
 // Test on DMA Transfer Complete interrupt
-    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_TC2)) {
+    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_TC)) {
         /* Clear DMA  Transfer Complete interrupt pending bit */
-        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_TC2);
+        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_TC);
         //DMA_ClearITPendingBit(DMA1_IT_TC2);
 //sUSARTDmaReady = true;
     }
 // Test on DMA Transfer Error interrupt
-    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_TE2)) {
+    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_TE)) {
         failParamMessage(UART_BD_Handle.hdmatx->Instance->CPAR, "DMA Error");
-        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_TE2);
+        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_TE);
         //DMA_ClearITPendingBit(DMA1_IT_TE2);
     }
 // Test on DMA Transfer Half interrupt
-    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_HT2)) {
-        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, DMA_FLAG_HT2);
+    if (__HAL_DMA_GET_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_HT)) {
+        __HAL_DMA_CLEAR_FLAG(UART_BD_Handle.hdmatx, UART_BD_DMA_TX_FLAG_HT);
         //DMA_ClearITPendingBit(DMA1_IT_HT2);
     }
 }
@@ -117,6 +117,8 @@ public:
     void drawChartDataWithYOffset(uint8_t *aDataPointer, const uint16_t aLengthOfValidData, const uint8_t aMode); // 8 Bit (compressed) data with factor and offset
     void drawChartData(int16_t *aDataPointer, const uint16_t aLengthOfValidData, const uint8_t aMode);       // 16 bit data
     void drawChartDataFloat(float *aDataPointer, const uint16_t aLengthOfValidData, const uint8_t aMode);
+    void drawChartDataMinMax(const uint16_t *aMinValues, const uint16_t *aMaxValues, const uint16_t aLengthOfValidData,
+            const uint16_t aXOffset); // 16 bit minimum and maximum of each column
     void drawGrid(void);
 
     /*
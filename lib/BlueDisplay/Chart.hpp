@@ -1007,6 +1007,71 @@ void Chart::drawChartData(int16_t *aDataPointer, const uint16_t aLengthOfValidDa
 
 }
 
+/**
+ * Draws one vertical line from minimum to maximum value for each column, so no peak is lost by compression.
+ * Each line is extended to the range of the previous column, so that the lines are connected.
+ * Data is not X scaled, compression must be done by the caller.
+ * Since values are only drawn and never cleared, a column which got new values can be drawn again over the old one.
+ * @param aMinValues minimum of each column, same scaling as for drawChartData()
+ * @param aMaxValues maximum of each column
+ * @param aXOffset column of first value. If > 0, the first value is only used to connect the following columns.
+ */
+void Chart::drawChartDataMinMax(const uint16_t *aMinValues, const uint16_t *aMaxValues, const uint16_t aLengthOfValidData,
+        const uint16_t aXOffset) {
+// Factor for Input -> Display value
+    float tYDisplayFactor;
+    int tYDisplayOffset;
+
+    if (mFlags & CHART_Y_LABEL_INT) {
+        tYDisplayFactor = (mYDataFactor * mGridYPixelSpacing) / mYLabelIncrementValue.IntValue;
+        tYDisplayOffset = mYLabelStartValue.IntValue / mYDataFactor;
+    } else {
+        tYDisplayFactor = (mYDataFactor * mGridYPixelSpacing) / mYLabelIncrementValue.FloatValue;
+        tYDisplayOffset = mYLabelStartValue.FloatValue / mYDataFactor;
+    }
+
+    if (aXOffset >= mWidthX) {
+        return;
+    }
+    uint16_t tLength = aLengthOfValidData;
+    if (aXOffset + tLength > mWidthX) {
+        tLength = mWidthX - aXOffset;
+    }
+    int tLastMinValue = 0;
+    int tLastMaxValue = 0;
+    for (uint16_t i = 0; i < tLength; ++i) {
+        int tMinValue = tYDisplayFactor * (aMinValues[i] - tYDisplayOffset);
+        int tMaxValue = tYDisplayFactor * (aMaxValues[i] - tYDisplayOffset);
+        // clip to bottom line and top value
+        if (tMinValue < 0) {
+            tMinValue = 0;
+        }
+        if (tMaxValue > (int) mHeightY - 1) {
+            tMaxValue = mHeightY - 1;
+        }
+        if (tMaxValue < tMinValue) {
+            // both values are clipped at the same side
+            tMaxValue = tMinValue = (tMinValue == 0 ? 0 : mHeightY - 1);
+        }
+        int tBottom = tMinValue;
+        int tTop = tMaxValue;
+        if (i > 0) {
+            // connect to previous column
+            if (tBottom > tLastMaxValue) {
+                tBottom = tLastMaxValue;
+            }
+            if (tTop < tLastMinValue) {
+                tTop = tLastMinValue;
+            }
+        }
+        if (i > 0 || aXOffset == 0) {
+            DisplayForChart.fillRectRel(mPositionX + aXOffset + i, mPositionY - tTop, 1, (tTop - tBottom) + 1, mDataColor);
+        }
+        tLastMinValue = tMinValue;
+        tLastMaxValue = tMaxValue;
+    }
+}
+
 /*
  * Draw 8 bit unsigned (compressed) data with Y offset, i.e. value 0 is on X axis independent of mYLabelStartValue
  * Data is uncompressed on the display with mYDataFactor to get chart value and then with the factor from chart value to chart pixel
@@ -130,6 +130,8 @@ void registerReorientationCallback(void (*aReorientationCallback)(void));
 void registerRedrawCallback(void (*aRedrawCallback)(void));
 void (* getRedrawCallback(void))(void);
 
+void registerMainLoopCallback(void (*aMainLoopCallback)(void));
+
 void registerSensorChangeCallback(uint8_t aSensorType, uint8_t aSensorRate, uint8_t aFilterFlag,
         void (*aSensorChangeCallback)(uint8_t aSensorType, struct SensorCallback *aSensorCallbackInfo));
 
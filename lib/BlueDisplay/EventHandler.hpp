@@ -91,6 +91,7 @@ void (*sConnectCallback)() = NULL;
 void (*sRedrawCallback)() = NULL; // Intended to redraw screen, if size of display changes.
 void (*sReorientationCallback)() = NULL;
 void (*sSensorChangeCallback)(uint8_t aEventType, struct SensorCallback *aSensorCallbackInfo) = NULL;
+void (*sMainLoopCallback)() = NULL;
 
 void copyDisplaySizeAndTimestamp(struct BluetoothEvent *aEvent);
 
@@ -120,6 +121,14 @@ void (* getRedrawCallback())() {
 }
 // @formatter:on
 
+/*
+ * The main loop callback is called by each call of checkAndHandleEvents(), i.e. by the loop of every page.
+ * Intended for background work like writing queued data to the card, which must not run in interrupt context.
+ */
+void registerMainLoopCallback(void (*aMainLoopCallback)()) {
+    sMainLoopCallback = aMainLoopCallback;
+}
+
 /*
  * Reorientation event also calls redraw event
  */
@@ -303,6 +312,11 @@ void checkAndHandleEvents() {
     Watchdog_reload();
 #endif
 
+#if defined(SUPPORT_LOCAL_DISPLAY) && defined(USE_TIMER_FOR_PERIODIC_LOCAL_TOUCH_CHECKS)
+    // handle the events of the touch sampler
+    handleTouchPanelEvents();
+#endif
+
 #if defined(SUPPORT_LOCAL_DISPLAY) && defined(LOCAL_DISPLAY_GENERATES_BD_EVENTS)
     /*
      * Check if a local event happened, i.e. the localTouchEvent was written by an touch device interrupt handler
@@ -332,6 +346,10 @@ void checkAndHandleEvents() {
     }
 #  endif
 #endif
+
+    if (sMainLoopCallback != NULL) {
+        sMainLoopCallback();
+    }
 }
 
 /**
@@ -26,6 +26,9 @@
 
 #include <stdint.h>
 #include "BlueDisplayProtocol.h" // for struct XYPosition
+#if !defined(__AVR__)
+#include "ADS7846Filter.h" // for TOUCH_FILTER_EVENT_*
+#endif
 
 #define CAL_POINT_X1 (20)
 #define CAL_POINT_Y1 (20)
@@ -118,6 +121,7 @@ public:
     void readData(uint8_t aOversampling);
     void doCalibration(bool aCheckRTC);
     void initAndCalibrateOnPress();
+    uint8_t handleNextSamplerEvent(void);
 #endif
 
     uint16_t getRawX(void);
@@ -150,4 +154,10 @@ private:
 };
 extern ADS7846 TouchPanel; // The instance provided by the class itself
 
+#if !defined(__AVR__)
+void ADS7846_initializeSampler(void);
+void ADS7846_startSampling(void);
+void ADS7846_startBurst(void);
+#endif
+
 #endif //_ADS7846_H
@@ -36,12 +36,15 @@
 void ADS7846_IO_initalize(void);
 #else
 #include "STM32TouchScreenDriver.h"
+#include "ADS7846Filter.hpp"
 #endif
 
 ADS7846 TouchPanel; // The instance provided by the class itself
 
 #define TOUCH_DELAY_AFTER_READ_MILLIS 3
-#define TOUCH_DEBOUNCE_DELAY_MILLIS 10 // wait for debouncing in ISR - minimum 8 ms
+#define TOUCH_SAMPLER_FIRST_BURST_DELAY_MILLIS 1 // delay between PENIRQ edge and first burst
+#define TOUCH_SAMPLER_PERIOD_MILLIS 10 // period of bursts while touched
+#define TOUCH_SAMPLER_CONFIRM_PERIOD_MILLIS 3 // period of bursts until touch down is confirmed, minimum 3 ms for PENIRQ line to go high
 
 const char StringPosZ1[] PROGMEM = "Z Pos 1";
 const char StringPosZ2[] PROGMEM = "Z Pos 2";
@@ -136,6 +139,9 @@ void ADS7846::init(void) {
 //    mTouchActualPosition.PositionX = 0;
 //    mTouchActualPosition.PositionY = 0;
     mPressure = 0;
+#if !defined(__AVR__)
+    ADS7846_initializeSampler();
+#endif
 }
 
 bool ADS7846::setCalibration(CAL_POINT *aTargetValues, CAL_POINT *aRawValues) {
@@ -548,6 +554,7 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
          * but results for divider 64 looks as good as for 256
          * results for divider 16 are offsetted and not usable
          */
+        SPI1_acquire(SPI1_USER_TOUCH); // SPI1 is shared with the gyroscope acquisition ISR
         uint16_t tPrescaler = SPI1_getPrescaler();
         SPI1_setPrescaler (SPI_BAUDRATEPRESCALER_64); // 72 MHz / 256 = 280 kHz, /64 = 1,1Mhz
 
@@ -626,6 +633,7 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
         ADS7846_CSDisable();
 //restore SPI settings
         SPI1_setPrescaler(tPrescaler);
+        SPI1_release(SPI1_USER_TOUCH);
 // enable interrupts after some ms in order to wait for the interrupt line to go high  - minimum 3 ms (2ms give errors)
         changeDelayCallback(&ADS7846_clearAndEnableInterrupt, TOUCH_DELAY_AFTER_READ_MILLIS);
         return;
@@ -642,6 +650,7 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
         uint8_t low, high, i;
 
 //SPI speed-down
+        SPI1_acquire(SPI1_USER_TOUCH);
         uint16_t tPrescaler = SPI1_getPrescaler();
         SPI1_setPrescaler (SPI_BAUDRATEPRESCALER_64);
 
@@ -671,9 +680,167 @@ uint16_t ADS7846::readChannel(uint8_t channel, bool use12Bit, bool useDiffMode,
 
 //restore SPI settings
         SPI1_setPrescaler(tPrescaler);
+        SPI1_release(SPI1_USER_TOUCH);
 
         return tRetValue / numberOfReadingsToIntegrate;
     }
+
+    /*
+     * Touch sampler
+     * The PENIRQ ISR only calls ADS7846_startSampling(), which disables the PENIRQ interrupt and schedules
+     * ADS7846_startBurst() by SysTick. ADS7846_startBurst() reads one burst of 12 bit conversions by SPI1 DMA
+     * and schedules itself every TOUCH_SAMPLER_PERIOD_MILLIS, as long as the panel is pressed.
+     * The end of the DMA transfer is handled by handleBurstEnd(), which gives the burst to the filter.
+     * The filter puts the resulting down, move and up events into a queue, which is read by the main loop with handleNextSamplerEvent().
+     * Burst: Z1, Z2, TOUCH_FILTER_SAMPLES_PER_BURST times X and Y, Z1, Z2. Each conversion takes 3 bytes, i.e. 24 clocks.
+     * 42 bytes at 1.1 MHz take 300 us, in which the CPU is free.
+     */
+#define TOUCH_SAMPLER_CONVERSIONS   (2 + (2 * TOUCH_FILTER_SAMPLES_PER_BURST) + 2)
+#define TOUCH_SAMPLER_BUFFER_SIZE   (3 * TOUCH_SAMPLER_CONVERSIONS)
+    static uint8_t sTouchSamplerTransmitBuffer[TOUCH_SAMPLER_BUFFER_SIZE];
+    static uint8_t sTouchSamplerReceiveBuffer[TOUCH_SAMPLER_BUFFER_SIZE];
+    static volatile bool sTouchSamplerBurstOngoing = false;
+    static volatile bool sTouchSamplerContinue = false; // set by handleBurstEnd() if panel is still pressed
+    static uint16_t sTouchSamplerPrescalerOfInterruptedUser;
+    static uint32_t sTouchSamplerStartMicros;
+    static uint32_t sTouchSamplerStartDurationMicros;
+
+    static void setSamplerCommand(uint8_t aConversionIndex, uint8_t aChannel) {
+        sTouchSamplerTransmitBuffer[3 * aConversionIndex] = CMD_START | CMD_12BIT | CMD_DIFF | aChannel;
+        sTouchSamplerTransmitBuffer[(3 * aConversionIndex) + 1] = 0;
+        sTouchSamplerTransmitBuffer[(3 * aConversionIndex) + 2] = 0;
+    }
+
+    void ADS7846_initializeSampler(void) {
+        setSamplerCommand(0, CMD_Z1_POS);
+        setSamplerCommand(1, CMD_Z2_POS);
+        for (uint8_t i = 0; i < TOUCH_FILTER_SAMPLES_PER_BURST; ++i) {
+            setSamplerCommand(2 + (2 * i), CMD_X_POS);
+            setSamplerCommand(3 + (2 * i), CMD_Y_POS);
+        }
+        setSamplerCommand(TOUCH_SAMPLER_CONVERSIONS - 2, CMD_Z1_POS);
+        setSamplerCommand(TOUCH_SAMPLER_CONVERSIONS - 1, CMD_Z2_POS);
+        TouchFilter_reset();
+    }
+
+    /*
+     * @return 12 bit value of conversion
+     */
+    static uint16_t getSamplerValue(uint8_t aConversionIndex) {
+        return ((sTouchSamplerReceiveBuffer[(3 * aConversionIndex) + 1] << 5)
+                | (sTouchSamplerReceiveBuffer[(3 * aConversionIndex) + 2] >> 3));
+    }
+
+    /*
+     * Same scaling as 8 bit readings of readData(). 127 is maximum reading of CMD_Z2_POS.
+     */
+    static uint8_t getSamplerPressure(uint8_t aConversionIndex) {
+        return (getSamplerValue(aConversionIndex) >> 5) + 127 - (getSamplerValue(aConversionIndex + 1) >> 5);
+    }
+
+    /**
+     * Called by DMA1_Channel2_IRQHandler at the end of a burst
+     */
+    static void handleBurstEnd(bool aTransferError) {
+        uint32_t tStartMicros = micros();
+        ADS7846_CSDisable();
+        SPI1_setPrescaler(sTouchSamplerPrescalerOfInterruptedUser);
+        SPI1_release(SPI1_USER_TOUCH_SAMPLER);
+
+        TouchBurstStruct tBurst;
+        tBurst.IsValid = !aTransferError;
+        tBurst.PressureAtStart = getSamplerPressure(0);
+        tBurst.PressureAtEnd = getSamplerPressure(TOUCH_SAMPLER_CONVERSIONS - 2);
+        for (uint8_t i = 0; i < TOUCH_FILTER_SAMPLES_PER_BURST; ++i) {
+            uint16_t tX = getSamplerValue(2 + (2 * i));
+            uint16_t tY = getSamplerValue(3 + (2 * i));
+            // plausi check like readData(), scale down to 11 bit, because calibration does not work with 12 bit values
+            if (tX >= 4000 || tY <= 100) {
+                tBurst.IsValid = false;
+            }
+            tBurst.RawX[i] = (4048 - tX) / 2;
+            tBurst.RawY[i] = tY / 2;
+        }
+        TouchFilter_processBurst(&tBurst, millis());
+        sTouchSamplerContinue = TouchFilter_isTouched() || tBurst.PressureAtStart >= MIN_REASONABLE_PRESSURE;
+        sTouchSamplerBurstOngoing = false;
+
+        TouchFilterStatisticsTypeDef *tStatistics = TouchFilter_getStatistics();
+        uint32_t tISRMicros = sTouchSamplerStartDurationMicros + (micros() - tStartMicros);
+        if (tStatistics->ISRMicrosMax < tISRMicros) {
+            tStatistics->ISRMicrosMax = tISRMicros;
+        }
+    }
+
+    /**
+     * Callback routine for SysTick handler. Starts one burst and schedules the next one.
+     * If the panel was not pressed at the last burst, the PENIRQ interrupt is enabled again instead.
+     */
+    void ADS7846_startBurst(void) {
+        if (sTouchSamplerBurstOngoing) {
+            changeDelayCallback(&ADS7846_startBurst, 1);
+            return;
+        }
+        if (!sTouchSamplerContinue) {
+            ADS7846_clearAndEnableInterrupt();
+            if (ADS7846_getInteruptLineLevel()) {
+                return;
+            }
+            // touched again between last burst and enabling of interrupt
+            ADS7846_disableInterrupt();
+        }
+        sTouchSamplerStartMicros = micros();
+        if (!SPI1_tryAcquire(SPI1_USER_TOUCH_SAMPLER)) {
+            // e.g. MicroSD card transfer is ongoing
+            TouchFilter_getStatistics()->BurstsDeferred++;
+            changeDelayCallback(&ADS7846_startBurst, 1);
+            return;
+        }
+        sTouchSamplerBurstOngoing = true;
+        sTouchSamplerPrescalerOfInterruptedUser = SPI1_getPrescaler();
+        SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_64); // 1.1 MHz, same as readData()
+        ADS7846_CSEnable();
+        SPI1_DMA_startTransferWithCallback(sTouchSamplerTransmitBuffer, sTouchSamplerReceiveBuffer, TOUCH_SAMPLER_BUFFER_SIZE,
+                &handleBurstEnd);
+        sTouchSamplerStartDurationMicros = micros() - sTouchSamplerStartMicros;
+        changeDelayCallback(&ADS7846_startBurst,
+                TouchFilter_isTouched() ? TOUCH_SAMPLER_PERIOD_MILLIS : TOUCH_SAMPLER_CONFIRM_PERIOD_MILLIS);
+    }
+
+    /**
+     * To be called by the PENIRQ ISR. The bouncing of the PENIRQ line is handled by the pressure gating of the filter.
+     */
+    void ADS7846_startSampling(void) {
+        ADS7846_disableInterrupt();
+        sTouchSamplerContinue = true;
+        changeDelayCallback(&ADS7846_startBurst, TOUCH_SAMPLER_FIRST_BURST_DELAY_MILLIS);
+    }
+
+    /**
+     * To be called by main loop. Takes the next event of the sampler from the queue
+     * and updates position, pressure and touch flags.
+     * @return TOUCH_FILTER_EVENT_NONE if queue is empty
+     */
+    uint8_t ADS7846::handleNextSamplerEvent(void) {
+        TouchFilterEventStruct tEvent;
+        if (!TouchFilter_getEvent(&tEvent)) {
+            return TOUCH_FILTER_EVENT_NONE;
+        }
+        if (tEvent.Type == TOUCH_FILTER_EVENT_UP) {
+            mPressure = 0;
+            ADS7846TouchActive = false;
+        } else {
+            mTouchActualPositionRaw.PositionX = tEvent.RawX;
+            mTouchActualPositionRaw.PositionY = tEvent.RawY;
+            calibrate();
+            mPressure = tEvent.Pressure;
+            if (tEvent.Type == TOUCH_FILTER_EVENT_DOWN) {
+                ADS7846TouchStart = true;
+            }
+            ADS7846TouchActive = true;
+        }
+        return tEvent.Type;
+    }
 #endif // defined(__AVR__)
 
 /**
@@ -0,0 +1,101 @@
+/*
+ * @file ADS7846Filter.h
+ *
+ * Noise filter and event queue for the bursts of touch samples read from the ADS7846 by SPI DMA.
+ * One burst contains the pressure at start, TOUCH_FILTER_SAMPLES_PER_BURST X and Y samples and the pressure at end.
+ *
+ * Pipeline for each burst:
+ * 1. Median of the X and Y samples. If the 2. and 4. smallest sample differ by more than TOUCH_FILTER_MAX_SPREAD,
+ *    the burst is rejected as noisy.
+ * 2. A position jumping more than TOUCH_FILTER_MAX_JUMP from the filtered one is rejected once as outlier.
+ *    If the next burst confirms the jump, it is taken.
+ * 3. IIR low pass filter with factor 1/2^TOUCH_FILTER_IIR_SHIFT. Moves greater than TOUCH_FILTER_IIR_BYPASS
+ *    are taken directly, so swipes get no lag.
+ * 4. Pressure gated state: touch down requires TOUCH_FILTER_DOWN_BURSTS consecutive valid bursts with
+ *    stable pressure, touch up requires TOUCH_FILTER_UP_BURSTS consecutive bursts without pressure.
+ *    This replaces the debounce delay of the PENIRQ line.
+ *
+ * Events are timestamped and put into a queue, which is written by the ISR and read by the main loop.
+ * If the newest unread event is a move, a new move event overwrites it, so the queue only overflows
+ * if the main loop does not read it for TOUCH_FILTER_QUEUE_SIZE touch downs and ups.
+ *
+ * Positions are raw 11 bit values like the ones of ADS7846::readData(), i.e. X is (4048 - X12) / 2 and Y is Y12 / 2.
+ * Contains no HAL code and runs on the host.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _ADS7846_FILTER_H
+#define _ADS7846_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TOUCH_FILTER_SAMPLES_PER_BURST  5 // must be odd for the median
+#define TOUCH_FILTER_MAX_SPREAD         48 // raw values, 7 pixel in X, 6 pixel in Y
+#define TOUCH_FILTER_MAX_JUMP           400 // raw values, 60 pixel in X
+#define TOUCH_FILTER_IIR_SHIFT          1 // new = old + (median - old) / 2
+#define TOUCH_FILTER_IIR_BYPASS         64 // raw values
+#define TOUCH_FILTER_DOWN_BURSTS        2
+#define TOUCH_FILTER_UP_BURSTS          2
+#define TOUCH_FILTER_QUEUE_SIZE         8
+
+#define TOUCH_FILTER_MIN_PRESSURE       9   // same as MIN_REASONABLE_PRESSURE
+#define TOUCH_FILTER_MAX_PRESSURE       110 // same as MAX_REASONABLE_PRESSURE, greater means panel not connected
+
+#define TOUCH_FILTER_EVENT_NONE         0
+#define TOUCH_FILTER_EVENT_DOWN         1
+#define TOUCH_FILTER_EVENT_MOVE         2 // is generated for each valid burst while touched, even if position did not change
+#define TOUCH_FILTER_EVENT_UP           3 // position is the last filtered position
+
+typedef struct {
+    uint16_t RawX[TOUCH_FILTER_SAMPLES_PER_BURST];
+    uint16_t RawY[TOUCH_FILTER_SAMPLES_PER_BURST];
+    uint8_t PressureAtStart;
+    uint8_t PressureAtEnd;
+    bool IsValid; // false if any sample was out of range
+} TouchBurstStruct;
+
+typedef struct {
+    uint32_t Millis; // timestamp of the burst
+    uint16_t RawX;
+    uint16_t RawY;
+    uint8_t Pressure;
+    uint8_t Type;
+} TouchFilterEventStruct;
+
+typedef struct {
+    uint32_t Bursts;
+    uint32_t BurstsDeferred; // SPI1 was busy at start of burst, filled by sampler
+    uint32_t NoisyBursts;
+    uint32_t JumpsRejected;
+    uint32_t EventsQueued;
+    uint32_t EventsCoalesced;
+    uint32_t EventsDropped;
+    uint32_t ISRMicrosMax; // longest time spent in the sampler ISRs for one burst, filled by sampler
+    uint8_t QueueDepthMax;
+} TouchFilterStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void TouchFilter_reset(void);
+uint8_t TouchFilter_processBurst(const TouchBurstStruct *aBurst, uint32_t aMillis);
+bool TouchFilter_isTouched(void);
+
+bool TouchFilter_getEvent(TouchFilterEventStruct *aEvent);
+uint8_t TouchFilter_getQueueDepth(void);
+
+TouchFilterStatisticsTypeDef* TouchFilter_getStatistics(void);
+void TouchFilter_resetStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _ADS7846_FILTER_H
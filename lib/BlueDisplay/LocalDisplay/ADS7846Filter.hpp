@@ -0,0 +1,204 @@
+/*
+ * @file ADS7846Filter.hpp
+ *
+ * Implementation of the touch noise filter and event queue, see ADS7846Filter.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _ADS7846_FILTER_HPP
+#define _ADS7846_FILTER_HPP
+
+#include "ADS7846Filter.h"
+#include <string.h> // for memset
+
+static bool sTouchFilterIsTouched;
+static uint8_t sTouchFilterStateCount; // consecutive bursts confirming a state change
+static uint8_t sTouchFilterJumpCount; // consecutive rejected jumps
+static uint16_t sTouchFilterX16; // filtered position with 4 fraction bits
+static uint16_t sTouchFilterY16;
+static uint8_t sTouchFilterPressure;
+
+/*
+ * Single producer (ISR) single consumer (main loop) queue.
+ * Head is only written by the producer, tail only by the consumer.
+ */
+static TouchFilterEventStruct sTouchFilterQueue[TOUCH_FILTER_QUEUE_SIZE];
+static volatile uint8_t sTouchFilterQueueHead;
+static volatile uint8_t sTouchFilterQueueTail;
+
+static TouchFilterStatisticsTypeDef sTouchFilterStatistics;
+
+void TouchFilter_reset(void) {
+    sTouchFilterIsTouched = false;
+    sTouchFilterStateCount = 0;
+    sTouchFilterJumpCount = 0;
+    sTouchFilterQueueTail = sTouchFilterQueueHead;
+}
+
+/*
+ * Sorts the samples and returns the median. aSpread is set to the difference of the 2 samples next to the median.
+ */
+static uint16_t getMedianAndSpread(const uint16_t *aSamples, uint16_t *aSpread) {
+    uint16_t tSorted[TOUCH_FILTER_SAMPLES_PER_BURST];
+    for (uint_fast8_t i = 0; i < TOUCH_FILTER_SAMPLES_PER_BURST; ++i) {
+        uint16_t tValue = aSamples[i];
+        uint_fast8_t j = i;
+        while (j > 0 && tSorted[j - 1] > tValue) {
+            tSorted[j] = tSorted[j - 1];
+            j--;
+        }
+        tSorted[j] = tValue;
+    }
+    *aSpread = tSorted[(TOUCH_FILTER_SAMPLES_PER_BURST / 2) + 1] - tSorted[(TOUCH_FILTER_SAMPLES_PER_BURST / 2) - 1];
+    return tSorted[TOUCH_FILTER_SAMPLES_PER_BURST / 2];
+}
+
+static void putEvent(uint8_t aType, uint32_t aMillis) {
+    uint8_t tHead = sTouchFilterQueueHead;
+    uint8_t tDepth = tHead - sTouchFilterQueueTail;
+    TouchFilterEventStruct *tEvent;
+    /*
+     * Overwrite the newest move with a new move. Only allowed if the consumer does not read it just now,
+     * i.e. if it is not the oldest entry.
+     */
+    if (aType == TOUCH_FILTER_EVENT_MOVE && tDepth >= 2
+            && sTouchFilterQueue[(uint8_t) (tHead - 1) % TOUCH_FILTER_QUEUE_SIZE].Type == TOUCH_FILTER_EVENT_MOVE) {
+        tEvent = &sTouchFilterQueue[(uint8_t) (tHead - 1) % TOUCH_FILTER_QUEUE_SIZE];
+        sTouchFilterStatistics.EventsCoalesced++;
+    } else if (tDepth >= TOUCH_FILTER_QUEUE_SIZE) {
+        sTouchFilterStatistics.EventsDropped++;
+        return;
+    } else {
+        tEvent = &sTouchFilterQueue[tHead % TOUCH_FILTER_QUEUE_SIZE];
+        tHead++;
+        tDepth++;
+        if (tDepth > sTouchFilterStatistics.QueueDepthMax) {
+            sTouchFilterStatistics.QueueDepthMax = tDepth;
+        }
+    }
+    tEvent->Millis = aMillis;
+    tEvent->RawX = sTouchFilterX16 >> 4;
+    tEvent->RawY = sTouchFilterY16 >> 4;
+    tEvent->Pressure = sTouchFilterPressure;
+    tEvent->Type = aType;
+    sTouchFilterStatistics.EventsQueued++;
+    // publish entry after it is written
+    sTouchFilterQueueHead = tHead;
+}
+
+static uint16_t filterIIR(uint16_t aFiltered16, uint16_t aMedian) {
+    int16_t tDelta = (int16_t) (aMedian << 4) - (int16_t) aFiltered16;
+    if (tDelta > (TOUCH_FILTER_IIR_BYPASS << 4) || tDelta < -(TOUCH_FILTER_IIR_BYPASS << 4)) {
+        return aMedian << 4;
+    }
+    return aFiltered16 + (tDelta >> TOUCH_FILTER_IIR_SHIFT);
+}
+
+/**
+ * To be called by the ISR, which received the burst
+ * @return the type of the event put into the queue
+ */
+uint8_t TouchFilter_processBurst(const TouchBurstStruct *aBurst, uint32_t aMillis) {
+    sTouchFilterStatistics.Bursts++;
+
+    bool tIsPressed = aBurst->IsValid && aBurst->PressureAtStart >= TOUCH_FILTER_MIN_PRESSURE
+            && aBurst->PressureAtStart <= TOUCH_FILTER_MAX_PRESSURE
+            // pressure at end must be greater than 7/8 of start pressure, otherwise finger was lifted during burst
+            && aBurst->PressureAtEnd > (aBurst->PressureAtStart - (aBurst->PressureAtStart >> 3));
+
+    if (!tIsPressed) {
+        if (sTouchFilterIsTouched) {
+            if (++sTouchFilterStateCount >= TOUCH_FILTER_UP_BURSTS) {
+                sTouchFilterIsTouched = false;
+                sTouchFilterStateCount = 0;
+                putEvent(TOUCH_FILTER_EVENT_UP, aMillis);
+                return TOUCH_FILTER_EVENT_UP;
+            }
+        } else {
+            sTouchFilterStateCount = 0;
+        }
+        return TOUCH_FILTER_EVENT_NONE;
+    }
+
+    uint16_t tSpreadX, tSpreadY;
+    uint16_t tMedianX = getMedianAndSpread(aBurst->RawX, &tSpreadX);
+    uint16_t tMedianY = getMedianAndSpread(aBurst->RawY, &tSpreadY);
+    if (tSpreadX > TOUCH_FILTER_MAX_SPREAD || tSpreadY > TOUCH_FILTER_MAX_SPREAD) {
+        // neither confirms touch down nor touch up
+        sTouchFilterStatistics.NoisyBursts++;
+        return TOUCH_FILTER_EVENT_NONE;
+    }
+    sTouchFilterPressure = aBurst->PressureAtStart;
+
+    if (!sTouchFilterIsTouched) {
+        if (sTouchFilterStateCount == 0) {
+            sTouchFilterX16 = tMedianX << 4;
+            sTouchFilterY16 = tMedianY << 4;
+        } else {
+            sTouchFilterX16 = filterIIR(sTouchFilterX16, tMedianX);
+            sTouchFilterY16 = filterIIR(sTouchFilterY16, tMedianY);
+        }
+        if (++sTouchFilterStateCount >= TOUCH_FILTER_DOWN_BURSTS) {
+            sTouchFilterIsTouched = true;
+            sTouchFilterStateCount = 0;
+            sTouchFilterJumpCount = 0;
+            putEvent(TOUCH_FILTER_EVENT_DOWN, aMillis);
+            return TOUCH_FILTER_EVENT_DOWN;
+        }
+        return TOUCH_FILTER_EVENT_NONE;
+    }
+
+    // touched, a pressed burst cancels a started touch up
+    sTouchFilterStateCount = 0;
+    int16_t tJumpX = (int16_t) tMedianX - (int16_t) (sTouchFilterX16 >> 4);
+    int16_t tJumpY = (int16_t) tMedianY - (int16_t) (sTouchFilterY16 >> 4);
+    if ((tJumpX > TOUCH_FILTER_MAX_JUMP || tJumpX < -TOUCH_FILTER_MAX_JUMP || tJumpY > TOUCH_FILTER_MAX_JUMP
+            || tJumpY < -TOUCH_FILTER_MAX_JUMP) && sTouchFilterJumpCount == 0) {
+        sTouchFilterJumpCount++;
+        sTouchFilterStatistics.JumpsRejected++;
+        return TOUCH_FILTER_EVENT_NONE;
+    }
+    sTouchFilterJumpCount = 0;
+    sTouchFilterX16 = filterIIR(sTouchFilterX16, tMedianX);
+    sTouchFilterY16 = filterIIR(sTouchFilterY16, tMedianY);
+    putEvent(TOUCH_FILTER_EVENT_MOVE, aMillis);
+    return TOUCH_FILTER_EVENT_MOVE;
+}
+
+bool TouchFilter_isTouched(void) {
+    return sTouchFilterIsTouched;
+}
+
+/**
+ * To be called by the main loop
+ * @return false if queue is empty
+ */
+bool TouchFilter_getEvent(TouchFilterEventStruct *aEvent) {
+    uint8_t tTail = sTouchFilterQueueTail;
+    if (tTail == sTouchFilterQueueHead) {
+        return false;
+    }
+    *aEvent = sTouchFilterQueue[tTail % TOUCH_FILTER_QUEUE_SIZE];
+    // release entry after it is read
+    sTouchFilterQueueTail = tTail + 1;
+    return true;
+}
+
+uint8_t TouchFilter_getQueueDepth(void) {
+    return (uint8_t) (sTouchFilterQueueHead - sTouchFilterQueueTail);
+}
+
+TouchFilterStatisticsTypeDef* TouchFilter_getStatistics(void) {
+    return &sTouchFilterStatistics;
+}
+
+void TouchFilter_resetStatistics(void) {
+    memset(&sTouchFilterStatistics, 0, sizeof(sTouchFilterStatistics));
+}
+
+#endif // _ADS7846_FILTER_HPP
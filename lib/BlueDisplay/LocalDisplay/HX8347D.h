@@ -67,8 +67,12 @@ public:
     void drawLine(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor);
     void drawLineRel(uint16_t aStartX, uint16_t aStartY, int16_t aDeltaX, int16_t aDeltaY, color16_t aColor);
     void drawLineFastOneX(uint16_t aStartX, uint16_t aStartY, uint16_t aEndY, color16_t aColor);
+    void drawSpan(uint16_t aXStart, uint16_t aYStart, uint16_t aLength, bool aIsVertical, color16_t aColor);
     void drawRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint16_t color);
     void fillRectRel(uint16_t aStartX, uint16_t aStartY, uint16_t aWidth, uint16_t aHeight, uint16_t aColor);
+    void drawImage(uint16_t aStartX, uint16_t aStartY, uint16_t aWidth, uint16_t aHeight, const uint16_t *aRGB565Pixels);
+    bool isDrawOngoing();
+    void waitForDrawEnd();
 
     void drawCircle(uint16_t aCenterX, uint16_t aCenterY, uint16_t aRadius, uint16_t aColor);
     void fillCircle(uint16_t aCenterX, uint16_t aCenterY, uint16_t aRadius, uint16_t aColor);
@@ -46,7 +46,7 @@ int sLCDDimDelay; //actual dim delay
 #define LCD_REGISTER    (0x70)
 
 //#define SOFTWARE_SPI
-#ifdef __AVR_ATmega32U4__
+#if defined(__AVR_ATmega32U4__) || defined(LOCAL_DISPLAY_EMULATOR)
 #define SOFTWARE_SPI
 #endif
 
@@ -102,8 +102,14 @@ int sLCDDimDelay; //actual dim delay
 #define RST_ENABLE()    digitalWriteFast(RST_PIN, LOW)
 #endif
 
+#if defined(LOCAL_DISPLAY_EMULATOR)
+#include "LocalDisplayEmulator.h"
+#define HX8347D_CS_DISABLE()    LocalDisplayEmulator_setSPIChipSelect(false)
+#define HX8347D_CS_ENABLE()     LocalDisplayEmulator_setSPIChipSelect(true)
+#else
 #define HX8347D_CS_DISABLE()    digitalWriteFast(HX8347D_CS_PIN, HIGH)
 #define HX8347D_CS_ENABLE()     digitalWriteFast(HX8347D_CS_PIN, LOW)
+#endif
 
 #define MOSI_HIGH()     digitalWriteFast(MOSI_PIN, HIGH)
 #define MOSI_LOW()      digitalWriteFast(MOSI_PIN, LOW)
@@ -356,6 +362,32 @@ void HX8347D::drawPixel(uint16_t aPositionX, uint16_t aPositionY, color16_t aCol
     drawStop();
 }
 
+/**
+ * Draws a horizontal or vertical run of pixels, used by drawLineSpans(). Is clipped to the display.
+ */
+void HX8347D::drawSpan(uint16_t aXStart, uint16_t aYStart, uint16_t aLength, bool aIsVertical, color16_t aColor) {
+    if ((aXStart >= LOCAL_DISPLAY_WIDTH) || (aYStart >= LOCAL_DISPLAY_HEIGHT) || aLength == 0) {
+        return;
+    }
+    if (aIsVertical) {
+        if (aLength > LOCAL_DISPLAY_HEIGHT - aYStart) {
+            aLength = LOCAL_DISPLAY_HEIGHT - aYStart;
+        }
+        setArea(aXStart, aYStart, aXStart, aYStart + aLength - 1);
+    } else {
+        if (aLength > LOCAL_DISPLAY_WIDTH - aXStart) {
+            aLength = LOCAL_DISPLAY_WIDTH - aXStart;
+        }
+        setArea(aXStart, aYStart, aXStart + aLength - 1, aYStart);
+    }
+
+    drawStart();
+    for (; aLength != 0; aLength--) {
+        draw(aColor);
+    }
+    drawStop();
+}
+
 /*
  * needs an TFTDisplay.setArea(0, 0, LOCAL_DISPLAY_WIDTH - 1, DISPLAY_HEIGHT - 1) first.
  */
@@ -569,7 +601,7 @@ void HX8347D::fillRect(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint1
             draw(aColor); //7
             draw(aColor); //8
         }
-        for (i = size - tmp; i != 0; i--) {
+        for (i = size - (tmp * 8); i != 0; i--) {
             draw(aColor);
         }
     } else {
@@ -580,6 +612,44 @@ void HX8347D::fillRect(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint1
     drawStop();
 }
 
+/**
+ * Copies a RGB565 image to the display. Is clipped to the display.
+ * Writes all pixel before returning, since there is no DMA for the SPI.
+ */
+void HX8347D::drawImage(uint16_t aStartX, uint16_t aStartY, uint16_t aWidth, uint16_t aHeight,
+        const uint16_t *aRGB565Pixels) {
+    if ((aStartX >= LOCAL_DISPLAY_WIDTH) || (aStartY >= LOCAL_DISPLAY_HEIGHT) || aWidth == 0 || aHeight == 0) {
+        return;
+    }
+    uint16_t tVisibleWidth = aWidth;
+    if (tVisibleWidth > LOCAL_DISPLAY_WIDTH - aStartX) {
+        tVisibleWidth = LOCAL_DISPLAY_WIDTH - aStartX;
+    }
+    if (aHeight > LOCAL_DISPLAY_HEIGHT - aStartY) {
+        aHeight = LOCAL_DISPLAY_HEIGHT - aStartY;
+    }
+    setArea(aStartX, aStartY, aStartX + tVisibleWidth - 1, aStartY + aHeight - 1);
+
+    drawStart();
+    for (; aHeight != 0; aHeight--) {
+        for (uint16_t i = 0; i < tVisibleWidth; ++i) {
+            draw(aRGB565Pixels[i]);
+        }
+        aRGB565Pixels += aWidth;
+    }
+    drawStop();
+}
+
+/*
+ * All draw functions are synchronous, these are only for the same interface as SSD1289
+ */
+bool HX8347D::isDrawOngoing() {
+    return false;
+}
+
+void HX8347D::waitForDrawEnd() {
+}
+
 void HX8347D::drawCircle(uint16_t aCenterX, uint16_t aCenterY, uint16_t aRadius, color16_t aColor) {
     int16_t err, x, y;
 
@@ -905,7 +975,9 @@ void HX8347D::wr_cmd(uint8_t reg, uint8_t param) {
 //}
 
 void HX8347D::wr_spi(uint8_t data) {
-#if defined(SOFTWARE_SPI)
+#if defined(LOCAL_DISPLAY_EMULATOR)
+    LocalDisplayEmulator_SPITransfer(data);
+#elif defined(SOFTWARE_SPI)
     uint8_t mask;
 
     for (mask = 0x80; mask != 0; mask >>= 1) {
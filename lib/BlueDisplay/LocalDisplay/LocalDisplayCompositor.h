@@ -0,0 +1,112 @@
+/*
+ * @file LocalDisplayCompositor.h
+ *
+ * Optional tile compositor for the local display, which writes each pixel of a frame only once.
+ * Between LocalDisplayCompositor_begin() and LocalDisplayCompositor_end(), fillRect, drawLine and drawText
+ * are only recorded into a display list. LocalDisplayCompositor_end() then computes the final pixels
+ * of each dirty tile of COMPOSITOR_TILE_SIZE x COMPOSITOR_TILE_SIZE pixel by applying all operations
+ * intersecting the tile in the recorded order, and writes the tile to the display with one setArea().
+ * This replaces the repeated writes of overlapping backgrounds, grid, trace and text, e.g. of the DSO page,
+ * by one write per pixel. The result is identical to drawing directly.
+ *
+ * Pixels of a dirty tile not covered by any operation keep the content of the display,
+ * i.e. the tile is written as runs of covered pixel.
+ * If the operation list, the text buffer or the polyline table is full, the operations recorded so far are written
+ * and recording continues, so the result stays correct, only the saving is reduced.
+ * Polylines, e.g. a chart trace, are stored as one operation. The points are not copied
+ * and must not be changed until LocalDisplayCompositor_end().
+ *
+ * RAM footprint (see LocalDisplayCompositor_getRAMSize()) for the defaults:
+ *   Operations         COMPOSITOR_MAX_OPERATIONS * 14 byte  = 3584
+ *   Operation indexes  COMPOSITOR_MAX_OPERATIONS * 2 byte   =  512
+ *   Text               COMPOSITOR_TEXT_BUFFER_SIZE          =  256
+ *   Tile pixel         COMPOSITOR_TILE_SIZE^2 * 2 byte      =  512
+ *   Tile coverage      COMPOSITOR_TILE_SIZE * 2 byte        =   32
+ *   Dirty tile bits    20 * 15 / 8                          =   38
+ *   Polylines          COMPOSITOR_MAX_POLYLINES * 6 byte    =   24
+ *   Total                                                   = 4958 byte
+ *
+ * Contains no HAL code and runs on the host with LocalDisplayEmulator.hpp, which counts the written pixel:
+ *   LocalDisplayEmulator_resetStatistics();
+ *   LocalDisplayCompositor_begin();
+ *   drawMyPageWithCompositorFunctions();
+ *   LocalDisplayCompositor_end();
+ *   LocalDisplayCompositor_printStatistics(tBuffer, sizeof(tBuffer));
+ * and compare the framebuffer CRC with the one of drawing directly.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _LOCAL_DISPLAY_COMPOSITOR_H
+#define _LOCAL_DISPLAY_COMPOSITOR_H
+
+#include "LocalDisplayInterface.h" // for LOCAL_DISPLAY_WIDTH and color16_t
+#include "BlueDisplayProtocol.h" // for struct XYPosition
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if !defined(COMPOSITOR_TILE_SIZE)
+#define COMPOSITOR_TILE_SIZE            16 // must be <= 16, since the coverage of a tile line is stored in an uint16_t
+#endif
+#if !defined(COMPOSITOR_MAX_OPERATIONS)
+#define COMPOSITOR_MAX_OPERATIONS       256
+#endif
+#if !defined(COMPOSITOR_TEXT_BUFFER_SIZE)
+#define COMPOSITOR_TEXT_BUFFER_SIZE     256
+#endif
+#if !defined(COMPOSITOR_MAX_POLYLINES)
+#define COMPOSITOR_MAX_POLYLINES        4
+#endif
+#define COMPOSITOR_NUMBER_OF_TILES_X    ((LOCAL_DISPLAY_WIDTH + COMPOSITOR_TILE_SIZE - 1) / COMPOSITOR_TILE_SIZE)
+#define COMPOSITOR_NUMBER_OF_TILES_Y    ((LOCAL_DISPLAY_HEIGHT + COMPOSITOR_TILE_SIZE - 1) / COMPOSITOR_TILE_SIZE)
+#define COMPOSITOR_NUMBER_OF_TILES      (COMPOSITOR_NUMBER_OF_TILES_X * COMPOSITOR_NUMBER_OF_TILES_Y)
+
+#define COMPOSITOR_OPERATION_FILL       0 // X0, Y0, X1, Y1 is the rectangle
+#define COMPOSITOR_OPERATION_LINE       1 // X0, Y0 to X1, Y1
+#define COMPOSITOR_OPERATION_TEXT       2 // X0, Y0 upper left, X1 index in text buffer, Y1 number of characters
+#define COMPOSITOR_OPERATION_POLYLINE   3 // X0, Y0, X1, Y1 is the bounding box
+
+typedef struct {
+    uint8_t Type;
+    uint8_t Parameter; // font scale factor for text, index in polyline table for polyline
+    uint16_t X0;
+    uint16_t Y0;
+    uint16_t X1;
+    uint16_t Y1;
+    color16_t Color;
+    color16_t BackgroundColor; // text only
+} CompositorOperationStruct;
+
+typedef struct {
+    uint32_t Operations;
+    uint32_t PixelsRequested; // pixel written by the operations, i.e. without compositor
+    uint32_t PixelsWritten; // pixel written to the display
+    uint32_t TilesWritten;
+    uint32_t AreaSettings; // calls of setArea(), each costs 5 register writes
+    uint32_t Flushes;
+    uint32_t OverflowFlushes; // flushes before end(), because operation list, text buffer or polyline table was full
+    uint16_t OperationsMax; // maximum number of operations of one flush
+} LocalDisplayCompositorStatisticsTypeDef;
+
+void LocalDisplayCompositor_begin(void);
+void LocalDisplayCompositor_end(void);
+
+void LocalDisplayCompositor_fillRect(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor);
+void LocalDisplayCompositor_fillRectRel(uint16_t aStartX, uint16_t aStartY, uint16_t aWidth, uint16_t aHeight,
+        color16_t aColor);
+void LocalDisplayCompositor_drawLine(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor);
+void LocalDisplayCompositor_drawPolyline(const struct XYPosition *aPoints, uint16_t aNumberOfPoints, color16_t aColor);
+uint16_t LocalDisplayCompositor_drawText(uint16_t aPositionX, uint16_t aPositionY, const char *aText, uint8_t aFontSize,
+        color16_t aTextColor, color16_t aBackgroundColor);
+
+size_t LocalDisplayCompositor_getRAMSize(void);
+void LocalDisplayCompositor_resetStatistics(void);
+const LocalDisplayCompositorStatisticsTypeDef* LocalDisplayCompositor_getStatistics(void);
+int LocalDisplayCompositor_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer);
+
+#endif // _LOCAL_DISPLAY_COMPOSITOR_H
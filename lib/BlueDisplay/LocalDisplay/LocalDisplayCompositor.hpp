@@ -0,0 +1,541 @@
+/*
+ * @file LocalDisplayCompositor.hpp
+ *
+ * Implementation of the tile compositor for the local display, see LocalDisplayCompositor.h.
+ * Requires fonts.hpp and LocalDisplayInterface.hpp to be included before.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _LOCAL_DISPLAY_COMPOSITOR_HPP
+#define _LOCAL_DISPLAY_COMPOSITOR_HPP
+
+#include "LocalDisplayCompositor.h"
+#include <stdio.h>  // for snprintf
+#include <string.h> // for strnlen
+
+static CompositorOperationStruct sCompositorOperations[COMPOSITOR_MAX_OPERATIONS];
+static uint16_t sCompositorNumberOfOperations;
+static uint16_t sCompositorTileLineOperations[COMPOSITOR_MAX_OPERATIONS]; // indexes of the operations of one line of tiles
+static char sCompositorText[COMPOSITOR_TEXT_BUFFER_SIZE];
+static uint16_t sCompositorTextLength;
+static color16_t sCompositorTilePixel[COMPOSITOR_TILE_SIZE * COMPOSITOR_TILE_SIZE];
+static uint16_t sCompositorTileCoverage[COMPOSITOR_TILE_SIZE]; // bit 0 is the left pixel
+static uint8_t sCompositorDirtyTiles[(COMPOSITOR_NUMBER_OF_TILES + 7) / 8];
+static const XYPosition *sCompositorPolylinePoints[COMPOSITOR_MAX_POLYLINES];
+static uint16_t sCompositorPolylineLength[COMPOSITOR_MAX_POLYLINES];
+static uint8_t sCompositorNumberOfPolylines;
+static LocalDisplayCompositorStatisticsTypeDef sCompositorStatistics;
+
+static void LocalDisplayCompositor_flush(void);
+
+/*
+ * Bounding box of an operation, clipped to the display
+ */
+static void getOperationBoundingBox(const CompositorOperationStruct *aOperation, uint16_t *aXStart, uint16_t *aYStart,
+        uint16_t *aXEnd, uint16_t *aYEnd) {
+    if (aOperation->Type == COMPOSITOR_OPERATION_TEXT) {
+        *aXStart = aOperation->X0;
+        *aYStart = aOperation->Y0;
+        *aXEnd = aOperation->X0 + (aOperation->Y1 * FONT_WIDTH * aOperation->Parameter) - 1;
+        *aYEnd = aOperation->Y0 + (FONT_HEIGHT * aOperation->Parameter) - 1;
+    } else {
+        // rectangles and polylines are stored with X0 <= X1, lines as start and end
+        *aXStart = (aOperation->X0 < aOperation->X1) ? aOperation->X0 : aOperation->X1;
+        *aXEnd = (aOperation->X0 < aOperation->X1) ? aOperation->X1 : aOperation->X0;
+        *aYStart = (aOperation->Y0 < aOperation->Y1) ? aOperation->Y0 : aOperation->Y1;
+        *aYEnd = (aOperation->Y0 < aOperation->Y1) ? aOperation->Y1 : aOperation->Y0;
+    }
+}
+
+static CompositorOperationStruct* addOperation(uint8_t aType, uint32_t aNumberOfPixels) {
+    if (sCompositorNumberOfOperations >= COMPOSITOR_MAX_OPERATIONS) {
+        sCompositorStatistics.OverflowFlushes++;
+        LocalDisplayCompositor_flush();
+    }
+    sCompositorStatistics.Operations++;
+    sCompositorStatistics.PixelsRequested += aNumberOfPixels;
+    CompositorOperationStruct *tOperation = &sCompositorOperations[sCompositorNumberOfOperations++];
+    tOperation->Type = aType;
+    return tOperation;
+}
+
+static void markTilesDirty(const CompositorOperationStruct *aOperation) {
+    uint16_t tXStart, tYStart, tXEnd, tYEnd;
+    getOperationBoundingBox(aOperation, &tXStart, &tYStart, &tXEnd, &tYEnd);
+    for (uint16_t tTileY = tYStart / COMPOSITOR_TILE_SIZE; tTileY <= tYEnd / COMPOSITOR_TILE_SIZE; ++tTileY) {
+        for (uint16_t tTileX = tXStart / COMPOSITOR_TILE_SIZE; tTileX <= tXEnd / COMPOSITOR_TILE_SIZE; ++tTileX) {
+            uint16_t tTileIndex = (tTileY * COMPOSITOR_NUMBER_OF_TILES_X) + tTileX;
+            sCompositorDirtyTiles[tTileIndex / 8] |= (1 << (tTileIndex % 8));
+        }
+    }
+}
+
+void LocalDisplayCompositor_begin(void) {
+    sCompositorNumberOfOperations = 0;
+    sCompositorTextLength = 0;
+    sCompositorNumberOfPolylines = 0;
+    memset(sCompositorDirtyTiles, 0, sizeof(sCompositorDirtyTiles));
+}
+
+/**
+ * Writes all dirty tiles to the display
+ */
+void LocalDisplayCompositor_end(void) {
+    LocalDisplayCompositor_flush();
+}
+
+/**
+ * Same parameters and clipping as LocalDisplay.fillRect()
+ */
+void LocalDisplayCompositor_fillRect(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor) {
+    uint16_t tTemp;
+    if (aStartX > aEndX) {
+        tTemp = aStartX;
+        aStartX = aEndX;
+        aEndX = tTemp;
+    }
+    if (aStartY > aEndY) {
+        tTemp = aStartY;
+        aStartY = aEndY;
+        aEndY = tTemp;
+    }
+    if (aEndX >= LOCAL_DISPLAY_WIDTH) {
+        aEndX = LOCAL_DISPLAY_WIDTH - 1;
+    }
+    if (aEndY >= LOCAL_DISPLAY_HEIGHT) {
+        aEndY = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+    if (aStartX > aEndX || aStartY > aEndY) {
+        return;
+    }
+    CompositorOperationStruct *tOperation = addOperation(COMPOSITOR_OPERATION_FILL,
+            (uint32_t) (aEndX - aStartX + 1) * (aEndY - aStartY + 1));
+    tOperation->X0 = aStartX;
+    tOperation->Y0 = aStartY;
+    tOperation->X1 = aEndX;
+    tOperation->Y1 = aEndY;
+    tOperation->Color = aColor;
+    markTilesDirty(tOperation);
+}
+
+void LocalDisplayCompositor_fillRectRel(uint16_t aStartX, uint16_t aStartY, uint16_t aWidth, uint16_t aHeight,
+        color16_t aColor) {
+    LocalDisplayCompositor_fillRect(aStartX, aStartY, aStartX + aWidth - 1, aStartY + aHeight - 1, aColor);
+}
+
+/**
+ * Same pixel and clipping as LocalDisplay.drawLine()
+ */
+void LocalDisplayCompositor_drawLine(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor) {
+    if (aStartX >= LOCAL_DISPLAY_WIDTH) {
+        aStartX = LOCAL_DISPLAY_WIDTH - 1;
+    }
+    if (aEndX >= LOCAL_DISPLAY_WIDTH) {
+        aEndX = LOCAL_DISPLAY_WIDTH - 1;
+    }
+    if (aStartY >= LOCAL_DISPLAY_HEIGHT) {
+        aStartY = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+    if (aEndY >= LOCAL_DISPLAY_HEIGHT) {
+        aEndY = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+    if (aStartX == aEndX || aStartY == aEndY) {
+        // horizontal and vertical lines are rectangles
+        LocalDisplayCompositor_fillRect(aStartX, aStartY, aEndX, aEndY, aColor);
+        return;
+    }
+    uint16_t tDeltaX = (aStartX < aEndX) ? aEndX - aStartX : aStartX - aEndX;
+    uint16_t tDeltaY = (aStartY < aEndY) ? aEndY - aStartY : aStartY - aEndY;
+    CompositorOperationStruct *tOperation = addOperation(COMPOSITOR_OPERATION_LINE,
+            ((tDeltaX > tDeltaY) ? tDeltaX : tDeltaY) + 1);
+    tOperation->X0 = aStartX;
+    tOperation->Y0 = aStartY;
+    tOperation->X1 = aEndX;
+    tOperation->Y1 = aEndY;
+    tOperation->Color = aColor;
+    markTilesDirty(tOperation);
+}
+
+/**
+ * Same pixel as LocalDisplay.drawPolyline(). The points must not be changed until LocalDisplayCompositor_end().
+ */
+void LocalDisplayCompositor_drawPolyline(const XYPosition *aPoints, uint16_t aNumberOfPoints, color16_t aColor) {
+    if (aNumberOfPoints == 0) {
+        return;
+    }
+    if (sCompositorNumberOfPolylines >= COMPOSITOR_MAX_POLYLINES) {
+        sCompositorStatistics.OverflowFlushes++;
+        LocalDisplayCompositor_flush();
+    }
+    uint16_t tXStart = LOCAL_DISPLAY_WIDTH - 1, tYStart = LOCAL_DISPLAY_HEIGHT - 1, tXEnd = 0, tYEnd = 0;
+    uint32_t tNumberOfPixels = 1;
+    for (uint16_t i = 0; i < aNumberOfPoints; ++i) {
+        // clip like drawLineSpans()
+        uint16_t tX = (aPoints[i].PositionX < LOCAL_DISPLAY_WIDTH) ? aPoints[i].PositionX : LOCAL_DISPLAY_WIDTH - 1;
+        uint16_t tY = (aPoints[i].PositionY < LOCAL_DISPLAY_HEIGHT) ? aPoints[i].PositionY : LOCAL_DISPLAY_HEIGHT - 1;
+        if (tX < tXStart) {
+            tXStart = tX;
+        }
+        if (tX > tXEnd) {
+            tXEnd = tX;
+        }
+        if (tY < tYStart) {
+            tYStart = tY;
+        }
+        if (tY > tYEnd) {
+            tYEnd = tY;
+        }
+        if (i > 0) {
+            int16_t tDeltaX = tX - aPoints[i - 1].PositionX;
+            int16_t tDeltaY = tY - aPoints[i - 1].PositionY;
+            tDeltaX = (tDeltaX < 0) ? -tDeltaX : tDeltaX;
+            tDeltaY = (tDeltaY < 0) ? -tDeltaY : tDeltaY;
+            tNumberOfPixels += (tDeltaX > tDeltaY) ? tDeltaX : tDeltaY; // start pixel is end pixel of preceding line
+        }
+    }
+    CompositorOperationStruct *tOperation = addOperation(COMPOSITOR_OPERATION_POLYLINE, tNumberOfPixels);
+    tOperation->Parameter = sCompositorNumberOfPolylines;
+    sCompositorPolylinePoints[sCompositorNumberOfPolylines] = aPoints;
+    sCompositorPolylineLength[sCompositorNumberOfPolylines++] = aNumberOfPoints;
+    tOperation->X0 = tXStart;
+    tOperation->Y0 = tYStart;
+    tOperation->X1 = tXEnd;
+    tOperation->Y1 = tYEnd;
+    tOperation->Color = aColor;
+    markTilesDirty(tOperation);
+}
+
+/**
+ * Same characters and return value as LocalDisplay.drawText()
+ */
+uint16_t LocalDisplayCompositor_drawText(uint16_t aPositionX, uint16_t aPositionY, const char *aText, uint8_t aFontSize,
+        color16_t aTextColor, color16_t aBackgroundColor) {
+    uint8_t tFontScaleFactor = getFontScaleFactorFromTextSize(aFontSize);
+    if (tFontScaleFactor == 0) {
+        tFontScaleFactor = 1;
+    }
+    size_t tNumberOfCharacters = strnlen(aText, COMPOSITOR_TEXT_BUFFER_SIZE);
+    if (tNumberOfCharacters == 0) {
+        return aPositionX;
+    }
+    if ((aPositionY + (FONT_HEIGHT * tFontScaleFactor)) > LOCAL_DISPLAY_HEIGHT) {
+        return LOCAL_DISPLAY_WIDTH + 1;
+    }
+    uint16_t tCharacterWidth = FONT_WIDTH * tFontScaleFactor;
+    size_t tNumberOfCharactersToDraw = 0;
+    if (aPositionX < LOCAL_DISPLAY_WIDTH) {
+        tNumberOfCharactersToDraw = (LOCAL_DISPLAY_WIDTH - aPositionX) / tCharacterWidth;
+    }
+    uint16_t tReturnValue;
+    if (tNumberOfCharacters > tNumberOfCharactersToDraw) {
+        tReturnValue = aPositionX + ((tNumberOfCharactersToDraw + 1) * tCharacterWidth);
+    } else {
+        tNumberOfCharactersToDraw = tNumberOfCharacters;
+        tReturnValue = aPositionX + (tNumberOfCharactersToDraw * tCharacterWidth);
+    }
+    if (tNumberOfCharactersToDraw == 0) {
+        return tReturnValue;
+    }
+
+    if (sCompositorTextLength + tNumberOfCharactersToDraw > COMPOSITOR_TEXT_BUFFER_SIZE) {
+        sCompositorStatistics.OverflowFlushes++;
+        LocalDisplayCompositor_flush();
+    }
+    CompositorOperationStruct *tOperation = addOperation(COMPOSITOR_OPERATION_TEXT,
+            (uint32_t) tNumberOfCharactersToDraw * tCharacterWidth * FONT_HEIGHT * tFontScaleFactor);
+    tOperation->Parameter = tFontScaleFactor;
+    tOperation->X0 = aPositionX;
+    tOperation->Y0 = aPositionY;
+    tOperation->X1 = sCompositorTextLength;
+    tOperation->Y1 = tNumberOfCharactersToDraw;
+    tOperation->Color = aTextColor;
+    tOperation->BackgroundColor = aBackgroundColor;
+    memcpy(&sCompositorText[sCompositorTextLength], aText, tNumberOfCharactersToDraw);
+    sCompositorTextLength += tNumberOfCharactersToDraw;
+    markTilesDirty(tOperation);
+    return tReturnValue;
+}
+
+/*
+ * Sets a pixel of the tile buffer. aX and aY are relative to the tile
+ */
+static inline void setTilePixel(uint16_t aX, uint16_t aY, color16_t aColor) {
+    sCompositorTilePixel[(aY * COMPOSITOR_TILE_SIZE) + aX] = aColor;
+    sCompositorTileCoverage[aY] |= (1 << aX);
+}
+
+/*
+ * Bresenham with the same pixel as drawLineSpans(). Only pixel inside the rectangle are set.
+ */
+static void renderLine(uint16_t aStartX, uint16_t aStartY, uint16_t aEndX, uint16_t aEndY, color16_t aColor,
+        uint16_t aTileXStart, uint16_t aTileYStart, uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, uint16_t aYEnd) {
+    int16_t tX = aStartX;
+    int16_t tY = aStartY;
+    int16_t tDeltaX = aEndX - tX;
+    int16_t tDeltaY = aEndY - tY;
+    int16_t tStepX = 1, tStepY = 1;
+    if (tDeltaX < 0) {
+        tDeltaX = -tDeltaX;
+        tStepX = -1;
+    }
+    if (tDeltaY < 0) {
+        tDeltaY = -tDeltaY;
+        tStepY = -1;
+    }
+    bool tIsXMajor = tDeltaX > tDeltaY;
+    int16_t tError = tIsXMajor ? (2 * tDeltaY) - tDeltaX : (2 * tDeltaX) - tDeltaY;
+    uint16_t tNumberOfPixels = (tIsXMajor ? tDeltaX : tDeltaY) + 1;
+    while (true) {
+        if (tX >= aXStart && tX <= aXEnd && tY >= aYStart && tY <= aYEnd) {
+            setTilePixel(tX - aTileXStart, tY - aTileYStart, aColor);
+        }
+        if (--tNumberOfPixels == 0) {
+            break;
+        }
+        if (tIsXMajor) {
+            tX += tStepX;
+            if (tError >= 0) {
+                tY += tStepY;
+                tError -= 2 * tDeltaX;
+            }
+            tError += 2 * tDeltaY;
+        } else {
+            tY += tStepY;
+            if (tError >= 0) {
+                tX += tStepX;
+                tError -= 2 * tDeltaY;
+            }
+            tError += 2 * tDeltaX;
+        }
+    }
+}
+
+/*
+ * Applies the operation to the pixel of the tile inside the rectangle
+ */
+static void renderOperation(const CompositorOperationStruct *aOperation, uint16_t aTileXStart, uint16_t aTileYStart,
+        uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, uint16_t aYEnd) {
+    if (aOperation->Type == COMPOSITOR_OPERATION_FILL) {
+        for (uint16_t y = aYStart; y <= aYEnd; ++y) {
+            for (uint16_t x = aXStart; x <= aXEnd; ++x) {
+                setTilePixel(x - aTileXStart, y - aTileYStart, aOperation->Color);
+            }
+        }
+
+    } else if (aOperation->Type == COMPOSITOR_OPERATION_TEXT) {
+        uint16_t tCharacterWidth = FONT_WIDTH * aOperation->Parameter;
+        const char *tText = &sCompositorText[aOperation->X1];
+        for (uint16_t y = aYStart; y <= aYEnd; ++y) {
+            uint8_t tFontLine = (y - aOperation->Y0) / aOperation->Parameter;
+            for (uint16_t x = aXStart; x <= aXEnd; ++x) {
+                uint16_t tOffsetX = x - aOperation->X0;
+                char tChar = tText[tOffsetX / tCharacterWidth];
+                // same mapping as LocalDisplay.drawText()
+                if (tChar < 0x20) {
+                    tChar = 0x20;
+                }
+#ifdef FONT_END7F
+                tChar = tChar & 0x7F;
+#endif
+                uint8_t tFontColumn = (tOffsetX % tCharacterWidth) / aOperation->Parameter;
+                if (font[((tChar - FONT_START) * FONT_HEIGHT) + tFontLine] & (1UL << (FONT_WIDTH - 1 - tFontColumn))) {
+                    setTilePixel(x - aTileXStart, y - aTileYStart, aOperation->Color);
+                } else {
+                    setTilePixel(x - aTileXStart, y - aTileYStart, aOperation->BackgroundColor);
+                }
+            }
+        }
+
+    } else if (aOperation->Type == COMPOSITOR_OPERATION_LINE) {
+        renderLine(aOperation->X0, aOperation->Y0, aOperation->X1, aOperation->Y1, aOperation->Color, aTileXStart,
+                aTileYStart, aXStart, aYStart, aXEnd, aYEnd);
+
+    } else {
+        const XYPosition *tPoints = sCompositorPolylinePoints[aOperation->Parameter];
+        uint16_t tNumberOfPoints = sCompositorPolylineLength[aOperation->Parameter];
+        uint16_t tLastX = (tPoints[0].PositionX < LOCAL_DISPLAY_WIDTH) ? tPoints[0].PositionX : LOCAL_DISPLAY_WIDTH - 1;
+        uint16_t tLastY = (tPoints[0].PositionY < LOCAL_DISPLAY_HEIGHT) ? tPoints[0].PositionY : LOCAL_DISPLAY_HEIGHT - 1;
+        if (tNumberOfPoints == 1) {
+            renderLine(tLastX, tLastY, tLastX, tLastY, aOperation->Color, aTileXStart, aTileYStart, aXStart, aYStart, aXEnd,
+                    aYEnd);
+        }
+        for (uint16_t i = 1; i < tNumberOfPoints; ++i) {
+            uint16_t tX = (tPoints[i].PositionX < LOCAL_DISPLAY_WIDTH) ? tPoints[i].PositionX : LOCAL_DISPLAY_WIDTH - 1;
+            uint16_t tY = (tPoints[i].PositionY < LOCAL_DISPLAY_HEIGHT) ? tPoints[i].PositionY : LOCAL_DISPLAY_HEIGHT - 1;
+            // skip lines outside of the tile
+            if (!((tX < aXStart && tLastX < aXStart) || (tX > aXEnd && tLastX > aXEnd) || (tY < aYStart && tLastY < aYStart)
+                    || (tY > aYEnd && tLastY > aYEnd))) {
+                renderLine(tLastX, tLastY, tX, tY, aOperation->Color, aTileXStart, aTileYStart, aXStart, aYStart, aXEnd, aYEnd);
+            }
+            tLastX = tX;
+            tLastY = tY;
+        }
+    }
+}
+
+/*
+ * Writes the covered pixel of the tile, a completely covered tile with one setArea()
+ */
+static void writeTile(uint16_t aTileXStart, uint16_t aTileYStart, uint16_t aTileWidth, uint16_t aTileHeight) {
+    uint16_t tFullLine = (1 << aTileWidth) - 1;
+    bool tIsCompletelyCovered = true;
+    for (uint16_t y = 0; y < aTileHeight; ++y) {
+        if (sCompositorTileCoverage[y] != tFullLine) {
+            tIsCompletelyCovered = false;
+            break;
+        }
+    }
+
+    sCompositorStatistics.TilesWritten++;
+    if (tIsCompletelyCovered) {
+        sCompositorStatistics.AreaSettings++;
+        sCompositorStatistics.PixelsWritten += aTileWidth * aTileHeight;
+        LocalDisplay.setArea(aTileXStart, aTileYStart, aTileXStart + aTileWidth - 1, aTileYStart + aTileHeight - 1);
+        LocalDisplay.drawStart();
+        for (uint16_t y = 0; y < aTileHeight; ++y) {
+            const color16_t *tPixel = &sCompositorTilePixel[y * COMPOSITOR_TILE_SIZE];
+            for (uint16_t x = 0; x < aTileWidth; ++x) {
+                LocalDisplay.draw(*tPixel++);
+            }
+        }
+        LocalDisplay.drawStop();
+        return;
+    }
+
+    /*
+     * Write runs of covered pixel.
+     * The SSD1289 keeps the window while the cursor is set, so only the cursor must be set for each run (2 instead of 5 register writes).
+     * The HX8347D sets its cursor to the window start by writing index 0x22, so it requires a window for each run.
+     */
+#if defined(USE_SSD1289)
+    sCompositorStatistics.AreaSettings++;
+    LocalDisplay.setArea(aTileXStart, aTileYStart, aTileXStart + aTileWidth - 1, aTileYStart + aTileHeight - 1);
+#endif
+    for (uint16_t y = 0; y < aTileHeight; ++y) {
+        uint16_t tCoverage = sCompositorTileCoverage[y];
+        uint16_t x = 0;
+        while (tCoverage != 0) {
+            while (!(tCoverage & 1)) {
+                tCoverage >>= 1;
+                x++;
+            }
+            uint16_t tRunStart = x;
+            while (tCoverage & 1) {
+                tCoverage >>= 1;
+                x++;
+            }
+            sCompositorStatistics.PixelsWritten += x - tRunStart;
+#if defined(USE_SSD1289)
+            LocalDisplay.setCursor(aTileXStart + tRunStart, aTileYStart + y);
+#else
+            sCompositorStatistics.AreaSettings++;
+            LocalDisplay.setArea(aTileXStart + tRunStart, aTileYStart + y, aTileXStart + x - 1, aTileYStart + y);
+#endif
+            LocalDisplay.drawStart();
+            const color16_t *tPixel = &sCompositorTilePixel[(y * COMPOSITOR_TILE_SIZE) + tRunStart];
+            for (uint16_t i = tRunStart; i < x; ++i) {
+                LocalDisplay.draw(*tPixel++);
+            }
+            LocalDisplay.drawStop();
+        }
+    }
+}
+
+/*
+ * Renders and writes all dirty tiles, line of tiles by line of tiles
+ * and clears the operation list
+ */
+static void LocalDisplayCompositor_flush(void) {
+    sCompositorStatistics.Flushes++;
+    if (sCompositorStatistics.OperationsMax < sCompositorNumberOfOperations) {
+        sCompositorStatistics.OperationsMax = sCompositorNumberOfOperations;
+    }
+
+    for (uint16_t tTileY = 0; tTileY < COMPOSITOR_NUMBER_OF_TILES_Y; ++tTileY) {
+        uint16_t tTileYStart = tTileY * COMPOSITOR_TILE_SIZE;
+        uint16_t tTileYEnd = tTileYStart + COMPOSITOR_TILE_SIZE - 1;
+        if (tTileYEnd >= LOCAL_DISPLAY_HEIGHT) {
+            tTileYEnd = LOCAL_DISPLAY_HEIGHT - 1;
+        }
+
+        // collect the operations of this line of tiles, to test only them for each tile
+        uint16_t tNumberOfLineOperations = 0;
+        uint16_t tXStart, tYStart, tXEnd, tYEnd;
+        for (uint16_t i = 0; i < sCompositorNumberOfOperations; ++i) {
+            getOperationBoundingBox(&sCompositorOperations[i], &tXStart, &tYStart, &tXEnd, &tYEnd);
+            if (tYStart <= tTileYEnd && tYEnd >= tTileYStart) {
+                sCompositorTileLineOperations[tNumberOfLineOperations++] = i;
+            }
+        }
+        if (tNumberOfLineOperations == 0) {
+            continue;
+        }
+
+        for (uint16_t tTileX = 0; tTileX < COMPOSITOR_NUMBER_OF_TILES_X; ++tTileX) {
+            uint16_t tTileIndex = (tTileY * COMPOSITOR_NUMBER_OF_TILES_X) + tTileX;
+            if (!(sCompositorDirtyTiles[tTileIndex / 8] & (1 << (tTileIndex % 8)))) {
+                continue;
+            }
+            uint16_t tTileXStart = tTileX * COMPOSITOR_TILE_SIZE;
+            uint16_t tTileXEnd = tTileXStart + COMPOSITOR_TILE_SIZE - 1;
+            if (tTileXEnd >= LOCAL_DISPLAY_WIDTH) {
+                tTileXEnd = LOCAL_DISPLAY_WIDTH - 1;
+            }
+
+            memset(sCompositorTileCoverage, 0, sizeof(sCompositorTileCoverage));
+            for (uint16_t i = 0; i < tNumberOfLineOperations; ++i) {
+                const CompositorOperationStruct *tOperation = &sCompositorOperations[sCompositorTileLineOperations[i]];
+                getOperationBoundingBox(tOperation, &tXStart, &tYStart, &tXEnd, &tYEnd);
+                if (tXStart > tTileXEnd || tXEnd < tTileXStart) {
+                    continue;
+                }
+                // intersection of operation and tile
+                renderOperation(tOperation, tTileXStart, tTileYStart, (tXStart > tTileXStart) ? tXStart : tTileXStart,
+                        (tYStart > tTileYStart) ? tYStart : tTileYStart, (tXEnd < tTileXEnd) ? tXEnd : tTileXEnd,
+                        (tYEnd < tTileYEnd) ? tYEnd : tTileYEnd);
+            }
+            writeTile(tTileXStart, tTileYStart, tTileXEnd - tTileXStart + 1, tTileYEnd - tTileYStart + 1);
+        }
+    }
+    LocalDisplayCompositor_begin();
+}
+
+size_t LocalDisplayCompositor_getRAMSize(void) {
+    return sizeof(sCompositorOperations) + sizeof(sCompositorTileLineOperations) + sizeof(sCompositorText)
+            + sizeof(sCompositorTilePixel) + sizeof(sCompositorTileCoverage) + sizeof(sCompositorDirtyTiles)
+            + sizeof(sCompositorPolylinePoints) + sizeof(sCompositorPolylineLength);
+}
+
+void LocalDisplayCompositor_resetStatistics(void) {
+    memset(&sCompositorStatistics, 0, sizeof(sCompositorStatistics));
+}
+
+const LocalDisplayCompositorStatisticsTypeDef* LocalDisplayCompositor_getStatistics(void) {
+    return &sCompositorStatistics;
+}
+
+/**
+ * Overdraw is the ratio of the pixel requested by the operations and the pixel written
+ */
+int LocalDisplayCompositor_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer) {
+    uint32_t tOverdrawPercent = 0;
+    if (sCompositorStatistics.PixelsWritten != 0) {
+        tOverdrawPercent = (sCompositorStatistics.PixelsRequested * 100) / sCompositorStatistics.PixelsWritten;
+    }
+    return snprintf(aStringBuffer, aSizeOfStringBuffer,
+            "%lu operations, %lu pixel requested, %lu written, overdraw %lu.%02lu\n"
+                    "%lu tiles, %lu areas, %lu flushes (%lu overflow), max %u operations, %u byte RAM\n",
+            (unsigned long) sCompositorStatistics.Operations, (unsigned long) sCompositorStatistics.PixelsRequested,
+            (unsigned long) sCompositorStatistics.PixelsWritten, (unsigned long) (tOverdrawPercent / 100),
+            (unsigned long) (tOverdrawPercent % 100), (unsigned long) sCompositorStatistics.TilesWritten,
+            (unsigned long) sCompositorStatistics.AreaSettings, (unsigned long) sCompositorStatistics.Flushes,
+            (unsigned long) sCompositorStatistics.OverflowFlushes, sCompositorStatistics.OperationsMax,
+            (unsigned int) LocalDisplayCompositor_getRAMSize());
+}
+
+#endif // _LOCAL_DISPLAY_COMPOSITOR_HPP
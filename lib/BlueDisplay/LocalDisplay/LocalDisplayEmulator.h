@@ -0,0 +1,136 @@
+/*
+ * @file LocalDisplayEmulator.h
+ *
+ * Host framebuffer emulator for the SSD1289 and HX8347D local display drivers.
+ * Allows to run the unchanged drivers and the pages drawing on them on a Linux host,
+ * to benchmark redraws by bus cycle counts and to compare the results with golden images.
+ *
+ * SSD1289: the GPIO ports GPIOB (control lines) and GPIOD (16 bit data bus) are replaced by emulated registers,
+ * so SSD1289.hpp compiles unchanged. The emulator decodes the rising edge of WR (DC low -> index, DC high -> data)
+ * and the falling edge of RD, as the controller does.
+ * HX8347D: HX8347D_CS_ENABLE() / HX8347D_CS_DISABLE() and wr_spi() are mapped to LocalDisplayEmulator_setSPIChipSelect()
+ * and LocalDisplayEmulator_SPITransfer(). The start byte 0x70 selects the index, 0x72 the data phase.
+ *
+ * Emulated: window registers, cursor (SSD1289 0x4E/0x4F, HX8347D set by writing index 0x22),
+ * GRAM auto-increment inside the window (x first, or y first if the AM bit of the SSD1289 entry mode register 0x11 is 0),
+ * GRAM read including the dummy read of the SSD1289 and register 0x00 returning 0x8989 for initalizeDisplay().
+ * Not emulated: orientation and the other entry mode bits, the framebuffer is always 320 x 240,
+ * gamma, power and scroll registers are only stored.
+ *
+ * The bus time is estimated with LOCAL_DISPLAY_EMULATOR_NANOS_PER_GPIO_ACCESS for each GPIO register access
+ * and LOCAL_DISPLAY_EMULATOR_SPI_CLOCK_HERTZ for each SPI byte.
+ *
+ * Usage on the host:
+ * Compile with -DLOCAL_DISPLAY_EMULATOR -DSTM32F30X and host versions of timing.h, stm32fx0xPeripherals.h and main.h,
+ * which provide delay(), delayNanos(), the PWM_BL_* functions and StringBuffer. Include LocalDisplayEmulator.hpp once.
+ *   LocalDisplayEmulator_reset();
+ *   LocalDisplay.init();
+ *   LocalDisplayEmulator_resetStatistics();
+ *   drawMyPage();
+ *   LocalDisplayEmulator_printStatistics(tBuffer, sizeof(tBuffer), "drawMyPage");
+ *   if (LocalDisplayEmulator_getFramebufferCRC32() != MY_PAGE_GOLDEN_CRC) LocalDisplayEmulator_storePNG("myPage.png");
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _LOCAL_DISPLAY_EMULATOR_H
+#define _LOCAL_DISPLAY_EMULATOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define LOCAL_DISPLAY_EMULATOR_WIDTH     320 // the size of the GRAM of both controllers
+#define LOCAL_DISPLAY_EMULATOR_HEIGHT    240
+
+#define LOCAL_DISPLAY_EMULATOR_NANOS_PER_GPIO_ACCESS 28 // 2 clock cycles at 72 MHz for one store to a port register
+#define LOCAL_DISPLAY_EMULATOR_SPI_CLOCK_HERTZ 8000000L // Fcpu/2 of the Arduino Uno
+
+#define LOCAL_DISPLAY_EMULATOR_DEVICE_CODE 0x8989 // content of register 0x00 of the SSD1289
+
+typedef struct {
+    uint32_t GPIOAccesses; // loads and stores of port registers, including the ones without effect on the bus
+    uint32_t WriteCycles; // rising edges of WR while CS is low
+    uint32_t ReadCycles; // falling edges of RD while CS is low
+    uint32_t SPIBytes;
+    uint32_t ChipSelects;
+    uint32_t IndexWrites;
+    uint32_t RegisterWrites; // all data writes except to GRAM
+    uint32_t WindowWrites; // writes to window and cursor registers, subset of RegisterWrites
+    uint32_t PixelWrites;
+    uint32_t PixelReads; // without the dummy reads
+    uint32_t DummyReads;
+} LocalDisplayEmulatorStatisticsTypeDef;
+
+#ifdef __cplusplus
+/*
+ * Emulated GPIO port. Every access of a register member is forwarded to the emulator.
+ * Only the registers used by SSD1289.hpp are available.
+ */
+#define EMULATED_GPIO_MODER 0
+#define EMULATED_GPIO_IDR   1
+#define EMULATED_GPIO_ODR   2
+#define EMULATED_GPIO_BSRR  3
+#define EMULATED_GPIO_BRR   4
+
+class EmulatedGPIORegister {
+public:
+    EmulatedGPIORegister(uint8_t aPortIndex, uint8_t aRegister);
+    EmulatedGPIORegister& operator=(uint32_t aValue);
+    operator uint32_t() const;
+
+    uint8_t PortIndex;
+    uint8_t Register;
+};
+
+struct EmulatedGPIOTypeDef {
+    EmulatedGPIOTypeDef(uint8_t aPortIndex);
+    EmulatedGPIORegister MODER;
+    EmulatedGPIORegister IDR;
+    EmulatedGPIORegister ODR;
+    EmulatedGPIORegister BSRR;
+    EmulatedGPIORegister BRR;
+};
+
+extern EmulatedGPIOTypeDef EmulatedGPIOB;
+extern EmulatedGPIOTypeDef EmulatedGPIOD;
+#define GPIOB (&EmulatedGPIOB)
+#define GPIOD (&EmulatedGPIOD)
+
+#if !defined(GPIO_PIN_0)
+#define GPIO_PIN_0  ((uint16_t)0x0001)
+#define GPIO_PIN_4  ((uint16_t)0x0010)
+#define GPIO_PIN_5  ((uint16_t)0x0020)
+#define GPIO_PIN_10 ((uint16_t)0x0400)
+#endif
+#endif // __cplusplus
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void LocalDisplayEmulator_reset(void);
+
+void LocalDisplayEmulator_setSPIChipSelect(bool aSelected);
+uint8_t LocalDisplayEmulator_SPITransfer(uint8_t aByte);
+
+uint16_t * LocalDisplayEmulator_getFramebuffer(void);
+uint16_t LocalDisplayEmulator_getRegister(uint8_t aRegisterAddress);
+uint32_t LocalDisplayEmulator_getFramebufferCRC32(void);
+uint32_t LocalDisplayEmulator_countDifferentPixels(const uint16_t *aReferenceFramebuffer);
+bool LocalDisplayEmulator_storePNG(const char *aFileName);
+
+void LocalDisplayEmulator_resetStatistics(void);
+const LocalDisplayEmulatorStatisticsTypeDef * LocalDisplayEmulator_getStatistics(void);
+uint32_t LocalDisplayEmulator_getBusNanos(void);
+int LocalDisplayEmulator_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer, const char *aOperationName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LOCAL_DISPLAY_EMULATOR_H */
@@ -0,0 +1,526 @@
+/*
+ * @file LocalDisplayEmulator.hpp
+ *
+ * Host framebuffer emulator for the SSD1289 and HX8347D local display drivers, see LocalDisplayEmulator.h.
+ * Must be included once, like the other *.hpp files of the local display.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "LocalDisplayEmulator.h"
+
+#include <stdio.h>   // for FILE, snprintf
+#include <stdlib.h>  // for malloc
+#include <string.h>  // for memset
+
+#define EMULATED_PORT_B 0
+#define EMULATED_PORT_D 1
+
+/*
+ * Pins of port B, see STM32TouchScreenDriver.h
+ */
+#define EMULATED_CS_PIN           0x0001
+#define EMULATED_DATA_CONTROL_PIN 0x0010 // low -> index, high -> data
+#define EMULATED_WR_PIN           0x0020
+#define EMULATED_RD_PIN           0x0400
+
+#define EMULATOR_GRAM_REGISTER 0x22
+
+/*
+ * SPI protocol of the HX8347D
+ */
+#define EMULATOR_SPI_START_INDEX 0x70
+#define EMULATOR_SPI_START_WRITE 0x72
+#define EMULATOR_SPI_STATE_DESELECTED   0
+#define EMULATOR_SPI_STATE_START_BYTE   1
+#define EMULATOR_SPI_STATE_INDEX        2
+#define EMULATOR_SPI_STATE_DATA         3
+
+EmulatedGPIOTypeDef EmulatedGPIOB(EMULATED_PORT_B);
+EmulatedGPIOTypeDef EmulatedGPIOD(EMULATED_PORT_D);
+
+static uint16_t sFramebuffer[LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT];
+static uint16_t sRegisters[256];
+static LocalDisplayEmulatorStatisticsTypeDef sStatistics;
+
+/*
+ * Controller state
+ */
+static uint8_t sIndex;
+static uint16_t sWindowXStart;
+static uint16_t sWindowXEnd;
+static uint16_t sWindowYStart;
+static uint16_t sWindowYEnd;
+static uint16_t sCursorX;
+static uint16_t sCursorY;
+static uint16_t sReadLatch; // value driven to the data bus by the last read cycle
+static bool sNextReadIsDummy;
+static bool sIsYIncrementFirst; // AM bit of SSD1289 entry mode register is 0
+
+/*
+ * Bus state
+ */
+static uint16_t sPortOutput[2]; // output data register of port B and D
+static bool sDataBusIsInput;
+
+static uint8_t sSPIState;
+static bool sSPIIsHighByte;
+static uint16_t sSPIHighByte;
+
+/*
+ * Increments the cursor inside the window, x first or y first
+ */
+static void incrementCursor(void) {
+    if (sIsYIncrementFirst) {
+        sCursorY++;
+        if (sCursorY > sWindowYEnd) {
+            sCursorY = sWindowYStart;
+            sCursorX++;
+            if (sCursorX > sWindowXEnd) {
+                sCursorX = sWindowXStart;
+            }
+        }
+    } else {
+        sCursorX++;
+        if (sCursorX > sWindowXEnd) {
+            sCursorX = sWindowXStart;
+            sCursorY++;
+            if (sCursorY > sWindowYEnd) {
+                sCursorY = sWindowYStart;
+            }
+        }
+    }
+}
+
+/*
+ * Writes at the cursor and increments it inside the window
+ */
+static void writeGRAM(uint16_t aColor) {
+    if (sCursorX < LOCAL_DISPLAY_EMULATOR_WIDTH && sCursorY < LOCAL_DISPLAY_EMULATOR_HEIGHT) {
+        sFramebuffer[(sCursorY * LOCAL_DISPLAY_EMULATOR_WIDTH) + sCursorX] = aColor;
+    }
+    sStatistics.PixelWrites++;
+    incrementCursor();
+}
+
+static uint16_t readGRAM(void) {
+    uint16_t tValue = 0;
+    if (sCursorX < LOCAL_DISPLAY_EMULATOR_WIDTH && sCursorY < LOCAL_DISPLAY_EMULATOR_HEIGHT) {
+        tValue = sFramebuffer[(sCursorY * LOCAL_DISPLAY_EMULATOR_WIDTH) + sCursorX];
+    }
+    sStatistics.PixelReads++;
+    incrementCursor();
+    return tValue;
+}
+
+static void writeIndex(uint8_t aIndex) {
+    sStatistics.IndexWrites++;
+    sIndex = aIndex;
+    sNextReadIsDummy = true;
+}
+
+/*
+ * SSD1289 register write
+ */
+static void writeSSD1289Data(uint16_t aValue) {
+    if (sIndex == EMULATOR_GRAM_REGISTER) {
+        writeGRAM(aValue);
+        return;
+    }
+    sStatistics.RegisterWrites++;
+    sRegisters[sIndex] = aValue;
+    switch (sIndex) {
+    case 0x11:
+        sIsYIncrementFirst = !(aValue & 0x0008);
+        return;
+    case 0x44:
+        sWindowYStart = aValue & 0xFF;
+        sWindowYEnd = aValue >> 8;
+        break;
+    case 0x45:
+        sWindowXStart = aValue;
+        break;
+    case 0x46:
+        sWindowXEnd = aValue;
+        break;
+    case 0x4E:
+        sCursorY = aValue;
+        break;
+    case 0x4F:
+        sCursorX = aValue;
+        break;
+    default:
+        return;
+    }
+    sStatistics.WindowWrites++;
+}
+
+/*
+ * SSD1289 read cycle. The first GRAM read after setting the index returns the value of the former read cycle.
+ */
+static uint16_t readSSD1289Data(void) {
+    if (sIndex != EMULATOR_GRAM_REGISTER) {
+        if (sIndex == 0x00) {
+            sReadLatch = LOCAL_DISPLAY_EMULATOR_DEVICE_CODE;
+        } else {
+            sReadLatch = sRegisters[sIndex];
+        }
+    } else if (sNextReadIsDummy) {
+        sNextReadIsDummy = false;
+        sStatistics.DummyReads++;
+    } else {
+        sReadLatch = readGRAM();
+    }
+    return sReadLatch;
+}
+
+/*
+ * Detects the edges of the control lines of port B
+ */
+static void setPortBOutput(uint16_t aNewOutput) {
+    uint16_t tOldOutput = sPortOutput[EMULATED_PORT_B];
+    sPortOutput[EMULATED_PORT_B] = aNewOutput;
+    if ((tOldOutput & EMULATED_CS_PIN) && !(aNewOutput & EMULATED_CS_PIN)) {
+        sStatistics.ChipSelects++;
+    }
+    if (aNewOutput & EMULATED_CS_PIN) {
+        return;
+    }
+    if (!(tOldOutput & EMULATED_WR_PIN) && (aNewOutput & EMULATED_WR_PIN)) {
+        sStatistics.WriteCycles++;
+        if (aNewOutput & EMULATED_DATA_CONTROL_PIN) {
+            writeSSD1289Data(sPortOutput[EMULATED_PORT_D]);
+        } else {
+            writeIndex(sPortOutput[EMULATED_PORT_D]);
+        }
+    }
+    if ((tOldOutput & EMULATED_RD_PIN) && !(aNewOutput & EMULATED_RD_PIN)) {
+        sStatistics.ReadCycles++;
+        readSSD1289Data();
+    }
+}
+
+EmulatedGPIORegister::EmulatedGPIORegister(uint8_t aPortIndex, uint8_t aRegister) {
+    PortIndex = aPortIndex;
+    Register = aRegister;
+}
+
+EmulatedGPIORegister& EmulatedGPIORegister::operator=(uint32_t aValue) {
+    sStatistics.GPIOAccesses++;
+    uint16_t tNewOutput = sPortOutput[PortIndex];
+    switch (Register) {
+    case EMULATED_GPIO_MODER:
+        if (PortIndex == EMULATED_PORT_D) {
+            sDataBusIsInput = (aValue == 0);
+        }
+        return *this;
+    case EMULATED_GPIO_ODR:
+        tNewOutput = aValue;
+        break;
+    case EMULATED_GPIO_BSRR:
+        // set has priority over reset
+        tNewOutput = (tNewOutput & ~(aValue >> 16)) | (aValue & 0xFFFF);
+        break;
+    case EMULATED_GPIO_BRR:
+        tNewOutput &= ~aValue;
+        break;
+    default:
+        return *this; // IDR is read only
+    }
+    if (PortIndex == EMULATED_PORT_B) {
+        setPortBOutput(tNewOutput);
+    } else {
+        sPortOutput[PortIndex] = tNewOutput;
+    }
+    return *this;
+}
+
+EmulatedGPIORegister::operator uint32_t() const {
+    sStatistics.GPIOAccesses++;
+    if (Register == EMULATED_GPIO_IDR) {
+        if (PortIndex == EMULATED_PORT_D && sDataBusIsInput) {
+            return sReadLatch;
+        }
+        return sPortOutput[PortIndex];
+    }
+    if (Register == EMULATED_GPIO_MODER) {
+        return (PortIndex == EMULATED_PORT_D && sDataBusIsInput) ? 0x00000000 : 0x55555555;
+    }
+    return sPortOutput[PortIndex];
+}
+
+EmulatedGPIOTypeDef::EmulatedGPIOTypeDef(uint8_t aPortIndex) :
+        MODER(aPortIndex, EMULATED_GPIO_MODER), IDR(aPortIndex, EMULATED_GPIO_IDR), ODR(aPortIndex, EMULATED_GPIO_ODR), BSRR(
+                aPortIndex, EMULATED_GPIO_BSRR), BRR(aPortIndex, EMULATED_GPIO_BRR) {
+}
+
+/*
+ * HX8347D register write. Registers are 8 bit, the window is set by high and low byte registers.
+ */
+static void writeHX8347DData(uint8_t aValue) {
+    if (sIndex == EMULATOR_GRAM_REGISTER) {
+        if (sSPIIsHighByte) {
+            sSPIHighByte = aValue;
+        } else {
+            writeGRAM((sSPIHighByte << 8) | aValue);
+        }
+        sSPIIsHighByte = !sSPIIsHighByte;
+        return;
+    }
+    sStatistics.RegisterWrites++;
+    sRegisters[sIndex] = aValue;
+    if (sIndex >= 0x02 && sIndex <= 0x09) {
+        sWindowXStart = (sRegisters[0x02] << 8) | sRegisters[0x03];
+        sWindowXEnd = (sRegisters[0x04] << 8) | sRegisters[0x05];
+        sWindowYStart = (sRegisters[0x06] << 8) | sRegisters[0x07];
+        sWindowYEnd = (sRegisters[0x08] << 8) | sRegisters[0x09];
+        sStatistics.WindowWrites++;
+    }
+}
+
+extern "C" void LocalDisplayEmulator_setSPIChipSelect(bool aSelected) {
+    if (aSelected) {
+        if (sSPIState == EMULATOR_SPI_STATE_DESELECTED) {
+            sStatistics.ChipSelects++;
+        }
+        sSPIState = EMULATOR_SPI_STATE_START_BYTE;
+    } else {
+        sSPIState = EMULATOR_SPI_STATE_DESELECTED;
+    }
+}
+
+/**
+ * @return the byte received on MISO, which is always 0xFF since the HX8347D driver only writes
+ */
+extern "C" uint8_t LocalDisplayEmulator_SPITransfer(uint8_t aByte) {
+    sStatistics.SPIBytes++;
+    switch (sSPIState) {
+    case EMULATOR_SPI_STATE_START_BYTE:
+        if (aByte == EMULATOR_SPI_START_INDEX) {
+            sSPIState = EMULATOR_SPI_STATE_INDEX;
+        } else if (aByte == EMULATOR_SPI_START_WRITE) {
+            sSPIState = EMULATOR_SPI_STATE_DATA;
+        }
+        break;
+    case EMULATOR_SPI_STATE_INDEX:
+        writeIndex(aByte);
+        if (aByte == EMULATOR_GRAM_REGISTER) {
+            // HX8347D sets the address counter to the window start, if the GRAM register is selected
+            sCursorX = sWindowXStart;
+            sCursorY = sWindowYStart;
+            sSPIIsHighByte = true;
+        }
+        break;
+    case EMULATOR_SPI_STATE_DATA:
+        writeHX8347DData(aByte);
+        break;
+    default:
+        break; // not selected
+    }
+    return 0xFF;
+}
+
+/**
+ * Clears the framebuffer and all registers. The statistics are reset too.
+ */
+extern "C" void LocalDisplayEmulator_reset(void) {
+    memset(sFramebuffer, 0, sizeof(sFramebuffer));
+    memset(sRegisters, 0, sizeof(sRegisters));
+    sIndex = 0;
+    sWindowXStart = 0;
+    sWindowXEnd = LOCAL_DISPLAY_EMULATOR_WIDTH - 1;
+    sWindowYStart = 0;
+    sWindowYEnd = LOCAL_DISPLAY_EMULATOR_HEIGHT - 1;
+    sCursorX = 0;
+    sCursorY = 0;
+    sReadLatch = 0;
+    sNextReadIsDummy = true;
+    sIsYIncrementFirst = false;
+    sPortOutput[EMULATED_PORT_B] = EMULATED_CS_PIN | EMULATED_WR_PIN | EMULATED_RD_PIN;
+    sPortOutput[EMULATED_PORT_D] = 0;
+    sDataBusIsInput = false;
+    sSPIState = EMULATOR_SPI_STATE_DESELECTED;
+    LocalDisplayEmulator_resetStatistics();
+}
+
+/**
+ * @return the 320 x 240 RGB565 framebuffer, line by line
+ */
+extern "C" uint16_t * LocalDisplayEmulator_getFramebuffer(void) {
+    return sFramebuffer;
+}
+
+extern "C" uint16_t LocalDisplayEmulator_getRegister(uint8_t aRegisterAddress) {
+    return sRegisters[aRegisterAddress];
+}
+
+static uint32_t updateCRC32(uint32_t aCRC, const uint8_t *aData, size_t aLength) {
+    aCRC = ~aCRC;
+    while (aLength-- > 0) {
+        aCRC ^= *aData++;
+        for (uint8_t i = 0; i < 8; ++i) {
+            aCRC = (aCRC >> 1) ^ (0xEDB88320 & -(aCRC & 0x01));
+        }
+    }
+    return ~aCRC;
+}
+
+/**
+ * CRC32 of the little endian framebuffer. To be compared with golden values.
+ */
+extern "C" uint32_t LocalDisplayEmulator_getFramebufferCRC32(void) {
+    return updateCRC32(0, (const uint8_t *) sFramebuffer, sizeof(sFramebuffer));
+}
+
+extern "C" uint32_t LocalDisplayEmulator_countDifferentPixels(const uint16_t *aReferenceFramebuffer) {
+    uint32_t tCount = 0;
+    for (uint32_t i = 0; i < LOCAL_DISPLAY_EMULATOR_WIDTH * LOCAL_DISPLAY_EMULATOR_HEIGHT; ++i) {
+        if (sFramebuffer[i] != aReferenceFramebuffer[i]) {
+            tCount++;
+        }
+    }
+    return tCount;
+}
+
+static void storeBigEndian(uint8_t *aBuffer, uint32_t aValue) {
+    aBuffer[0] = aValue >> 24;
+    aBuffer[1] = aValue >> 16;
+    aBuffer[2] = aValue >> 8;
+    aBuffer[3] = aValue;
+}
+
+/*
+ * Writes length, type, data and CRC of one chunk
+ */
+static bool writePNGChunk(FILE *aFile, const char *aType, const uint8_t *aData, uint32_t aLength) {
+    uint8_t tHeader[8];
+    storeBigEndian(tHeader, aLength);
+    memcpy(&tHeader[4], aType, 4);
+    uint32_t tCRC = updateCRC32(0, &tHeader[4], 4);
+    tCRC = updateCRC32(tCRC, aData, aLength);
+    uint8_t tTrailer[4];
+    storeBigEndian(tTrailer, tCRC);
+    return fwrite(tHeader, 1, 8, aFile) == 8 && fwrite(aData, 1, aLength, aFile) == aLength
+            && fwrite(tTrailer, 1, 4, aFile) == 4;
+}
+
+/**
+ * Stores the framebuffer as 8 bit RGB PNG. Uses stored (uncompressed) deflate blocks, so no zlib is required.
+ * @return false if file could not be written
+ */
+extern "C" bool LocalDisplayEmulator_storePNG(const char *aFileName) {
+    const uint32_t tLineSize = 1 + (LOCAL_DISPLAY_EMULATOR_WIDTH * 3); // filter type byte + RGB
+    const uint32_t tRawSize = tLineSize * LOCAL_DISPLAY_EMULATOR_HEIGHT;
+    const uint32_t tBlockCount = (tRawSize + 0xFFFE) / 0xFFFF;
+    const uint32_t tCompressedSize = 2 + (tBlockCount * 5) + tRawSize + 4;
+
+    uint8_t *tRaw = (uint8_t *) malloc(tRawSize);
+    uint8_t *tCompressed = (uint8_t *) malloc(tCompressedSize);
+    if (tRaw == NULL || tCompressed == NULL) {
+        free(tRaw);
+        free(tCompressed);
+        return false;
+    }
+
+    /*
+     * Convert RGB565 to RGB888, filter type 0 for all lines
+     */
+    uint8_t *tRawPtr = tRaw;
+    const uint16_t *tPixelPtr = sFramebuffer;
+    for (uint16_t y = 0; y < LOCAL_DISPLAY_EMULATOR_HEIGHT; ++y) {
+        *tRawPtr++ = 0;
+        for (uint16_t x = 0; x < LOCAL_DISPLAY_EMULATOR_WIDTH; ++x) {
+            uint16_t tPixel = *tPixelPtr++;
+            uint8_t tRed = (tPixel >> 11) & 0x1F;
+            uint8_t tGreen = (tPixel >> 5) & 0x3F;
+            uint8_t tBlue = tPixel & 0x1F;
+            *tRawPtr++ = (tRed << 3) | (tRed >> 2);
+            *tRawPtr++ = (tGreen << 2) | (tGreen >> 4);
+            *tRawPtr++ = (tBlue << 3) | (tBlue >> 2);
+        }
+    }
+
+    /*
+     * zlib stream with stored deflate blocks
+     */
+    uint8_t *tOut = tCompressed;
+    *tOut++ = 0x78; // deflate, 32K window
+    *tOut++ = 0x01; // no dictionary, check bits
+    uint32_t tAdlerA = 1;
+    uint32_t tAdlerB = 0;
+    uint32_t tRemaining = tRawSize;
+    tRawPtr = tRaw;
+    while (tRemaining > 0) {
+        uint16_t tBlockSize = (tRemaining > 0xFFFF) ? 0xFFFF : tRemaining;
+        tRemaining -= tBlockSize;
+        *tOut++ = (tRemaining == 0) ? 0x01 : 0x00; // BFINAL, BTYPE = 00
+        *tOut++ = tBlockSize;
+        *tOut++ = tBlockSize >> 8;
+        *tOut++ = ~tBlockSize;
+        *tOut++ = (~tBlockSize) >> 8;
+        for (uint16_t i = 0; i < tBlockSize; ++i) {
+            tAdlerA = (tAdlerA + *tRawPtr) % 65521;
+            tAdlerB = (tAdlerB + tAdlerA) % 65521;
+            *tOut++ = *tRawPtr++;
+        }
+    }
+    storeBigEndian(tOut, (tAdlerB << 16) | tAdlerA);
+
+    uint8_t tHeader[13];
+    storeBigEndian(&tHeader[0], LOCAL_DISPLAY_EMULATOR_WIDTH);
+    storeBigEndian(&tHeader[4], LOCAL_DISPLAY_EMULATOR_HEIGHT);
+    tHeader[8] = 8; // bit depth
+    tHeader[9] = 2; // color type RGB
+    tHeader[10] = 0; // deflate
+    tHeader[11] = 0; // adaptive filtering
+    tHeader[12] = 0; // no interlace
+
+    static const uint8_t sPNGSignature[8] = { 0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A };
+    bool tSuccess = false;
+    FILE *tFile = fopen(aFileName, "wb");
+    if (tFile != NULL) {
+        tSuccess = fwrite(sPNGSignature, 1, sizeof(sPNGSignature), tFile) == sizeof(sPNGSignature)
+                && writePNGChunk(tFile, "IHDR", tHeader, sizeof(tHeader))
+                && writePNGChunk(tFile, "IDAT", tCompressed, tCompressedSize) && writePNGChunk(tFile, "IEND", NULL, 0);
+        if (fclose(tFile) != 0) {
+            tSuccess = false;
+        }
+    }
+    free(tRaw);
+    free(tCompressed);
+    return tSuccess;
+}
+
+extern "C" void LocalDisplayEmulator_resetStatistics(void) {
+    memset(&sStatistics, 0, sizeof(sStatistics));
+}
+
+extern "C" const LocalDisplayEmulatorStatisticsTypeDef * LocalDisplayEmulator_getStatistics(void) {
+    return &sStatistics;
+}
+
+/**
+ * @return estimated time the CPU spends on the display bus since the last reset of the statistics
+ */
+extern "C" uint32_t LocalDisplayEmulator_getBusNanos(void) {
+    uint64_t tNanos = (uint64_t) sStatistics.GPIOAccesses * LOCAL_DISPLAY_EMULATOR_NANOS_PER_GPIO_ACCESS;
+    tNanos += ((uint64_t) sStatistics.SPIBytes * 8 * 1000000000) / LOCAL_DISPLAY_EMULATOR_SPI_CLOCK_HERTZ;
+    return tNanos;
+}
+
+extern "C" int LocalDisplayEmulator_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer,
+        const char *aOperationName) {
+    return snprintf(aStringBuffer, aSizeOfStringBuffer,
+            "%s: %lu pixel written, %lu read (+%lu dummy), %lu register writes (%lu window), %lu index writes\n"
+                    "%lu WR cycles, %lu RD cycles, %lu GPIO accesses, %lu SPI bytes, %lu chip selects, %lu us bus time\n",
+            aOperationName, (unsigned long) sStatistics.PixelWrites, (unsigned long) sStatistics.PixelReads,
+            (unsigned long) sStatistics.DummyReads, (unsigned long) sStatistics.RegisterWrites,
+            (unsigned long) sStatistics.WindowWrites, (unsigned long) sStatistics.IndexWrites,
+            (unsigned long) sStatistics.WriteCycles, (unsigned long) sStatistics.ReadCycles,
+            (unsigned long) sStatistics.GPIOAccesses, (unsigned long) sStatistics.SPIBytes,
+            (unsigned long) sStatistics.ChipSelects, (unsigned long) (LocalDisplayEmulator_getBusNanos() / 1000));
+}
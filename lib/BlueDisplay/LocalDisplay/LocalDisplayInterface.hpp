@@ -34,6 +34,24 @@
 
 LocalDisplayInterface LocalDisplay; // The instance provided by the class itself
 
+#if !defined(__AVR__)
+/*
+ * One display line of the text drawn by drawText(). Is only used while sDrawLock is held.
+ */
+static color16_t sTextLineBuffer[LOCAL_DISPLAY_WIDTH];
+
+/*
+ * One font line is stored in 1, 2 or 4 little endian bytes, as drawChar() reads it
+ */
+#if FONT_WIDTH <= 8
+typedef uint8_t FontLineTypeDef;
+#elif FONT_WIDTH <= 16
+typedef uint16_t FontLineTypeDef;
+#elif FONT_WIDTH <= 32
+typedef uint32_t FontLineTypeDef;
+#endif
+#endif
+
 LocalDisplayInterface::LocalDisplayInterface() {  // @suppress("Class members should be properly initialized")
 }
 #if !defined(ARDUINO)
@@ -100,13 +118,7 @@ uint16_t LocalDisplayInterface::drawChar(uint16_t aPositionX, uint16_t aPosition
     tFontRawPointer = &font_PGM[(aChar - FONT_START) * (32 * FONT_HEIGHT / 8)];
 #endif
 #else
-#if FONT_WIDTH <= 8
-    tFontRawPointer = &font[(aChar - FONT_START) * (8 * FONT_HEIGHT / 8)];
-#elif FONT_WIDTH <= 16
-    tFontRawPointer = &font[(aChar - FONT_START) * (16 * FONT_HEIGHT / 8)];
-#elif FONT_WIDTH <= 32
-    tFontRawPointer = &font[(aChar - FONT_START) * (32 * FONT_HEIGHT / 8)];
-#endif
+    tFontRawPointer = reinterpret_cast<const FontLineTypeDef*>(font) + ((aChar - FONT_START) * FONT_HEIGHT);
 #endif
     if (aFontScaleFactor <= 1) {
         /*
@@ -214,10 +226,10 @@ uint16_t LocalDisplayInterface::drawChar(uint16_t aPositionX, uint16_t aPosition
 uint16_t LocalDisplayInterface::drawText(uint16_t aPositionX, uint16_t aPositionY, const char *aText, uint8_t aFontSize,
         uint16_t aTextColor, uint16_t aBackgroundColor, uint16_t aNumberOfCharacters) {
 
-    uint16_t tPositionX = aPositionX;
     auto tNumberOfCharacters = strnlen(aText, aNumberOfCharacters);
     uint8_t tFontScaleFactor = getFontScaleFactorFromTextSize(aFontSize);
-
+#if defined(__AVR__)
+    uint16_t tPositionX = aPositionX;
     while (tNumberOfCharacters-- != 0) {
         tPositionX = drawChar(tPositionX, aPositionY, *aText++, tFontScaleFactor, aTextColor, aBackgroundColor);
         if (tPositionX > LOCAL_DISPLAY_WIDTH) {
@@ -225,6 +237,88 @@ uint16_t LocalDisplayInterface::drawText(uint16_t aPositionX, uint16_t aPosition
         }
     }
     return tPositionX;
+#else
+    /*
+     * Draw all characters with one setArea() and one lock instead of one per character.
+     * Each font line of the string is expanded once into sTextLineBuffer and then written aFontScaleFactor times.
+     * Returns the same values and draws the same characters as the drawChar() loop above.
+     */
+    if (tFontScaleFactor == 0) {
+        tFontScaleFactor = 1;
+    }
+    if (tNumberOfCharacters == 0) {
+        return aPositionX;
+    }
+    if ((aPositionY + (FONT_HEIGHT * tFontScaleFactor)) > LOCAL_DISPLAY_HEIGHT) {
+        return LOCAL_DISPLAY_WIDTH + 1;
+    }
+    uint16_t tCharacterWidth = FONT_WIDTH * tFontScaleFactor;
+    // only characters which fit completely are drawn
+    size_t tNumberOfCharactersToDraw = 0;
+    if (aPositionX < LOCAL_DISPLAY_WIDTH) {
+        tNumberOfCharactersToDraw = (LOCAL_DISPLAY_WIDTH - aPositionX) / tCharacterWidth;
+    }
+    uint16_t tReturnValue;
+    if (tNumberOfCharacters > tNumberOfCharactersToDraw) {
+        // position behind the first character, which does not fit
+        tReturnValue = aPositionX + ((tNumberOfCharactersToDraw + 1) * tCharacterWidth);
+    } else {
+        tNumberOfCharactersToDraw = tNumberOfCharacters;
+        tReturnValue = aPositionX + (tNumberOfCharactersToDraw * tCharacterWidth);
+    }
+    if (tNumberOfCharactersToDraw == 0) {
+        return tReturnValue;
+    }
+
+    /*
+     * check if a draw in routine which uses setArea() is already executed
+     */
+    uint32_t tLock;
+    do {
+        tLock = __LDREXW(&sDrawLock);
+        tLock++;
+    } while (__STREXW(tLock, &sDrawLock));
+
+    if (tLock != 1) {
+        // here in ISR, but interrupted process was still drawing
+        sLockCount++;
+        return aPositionX;
+    }
+
+    uint16_t tLineLength = tNumberOfCharactersToDraw * tCharacterWidth;
+    setArea(aPositionX, aPositionY, aPositionX + tLineLength - 1, aPositionY + (FONT_HEIGHT * tFontScaleFactor) - 1);
+    drawStart();
+    for (uint8_t tFontLine = 0; tFontLine < FONT_HEIGHT; tFontLine++) {
+        color16_t *tLinePointer = sTextLineBuffer;
+        for (size_t i = 0; i < tNumberOfCharactersToDraw; i++) {
+            char tChar = aText[i];
+            // characters below 20 are not printable
+            if (tChar < 0x20) {
+                tChar = 0x20;
+            }
+#ifdef FONT_END7F
+            tChar = tChar & 0x7F;  // mask highest bit
+#endif
+            FontLineTypeDef tFontRawData, tBitMask;
+            tFontRawData = reinterpret_cast<const FontLineTypeDef*>(font)[((tChar - FONT_START) * FONT_HEIGHT) + tFontLine];
+            for (tBitMask = (1 << (FONT_WIDTH - 1)); tBitMask != 0; tBitMask >>= 1) {
+                color16_t tColor = (tFontRawData & tBitMask) ? aTextColor : aBackgroundColor;
+                for (uint8_t j = tFontScaleFactor; j != 0; j--) {
+                    *tLinePointer++ = tColor;
+                }
+            }
+        }
+        for (uint8_t j = tFontScaleFactor; j != 0; j--) {
+            for (uint16_t i = 0; i < tLineLength; i++) {
+                draw(sTextLineBuffer[i]);
+            }
+        }
+    }
+    drawStop();
+
+    sDrawLock = 0;
+    return tReturnValue;
+#endif
 }
 
 uint16_t LocalDisplayInterface::drawText(uint16_t aPositionX, uint16_t aPositionY, const __FlashStringHelper *aPGMString,
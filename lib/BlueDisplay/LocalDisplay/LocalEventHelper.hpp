@@ -46,7 +46,9 @@ bool sTouchUpCallbackEnabledOnce; // Required to call only once at a longer touc
  * Reads touch panel data and handles down and up events by calling checkAllButtons and checkAllSliders
  */
 void checkAndHandleTouchPanelEvents() {
-    TouchPanel.readData();
+#if !defined(USE_TIMER_FOR_PERIODIC_LOCAL_TOUCH_CHECKS)
+    TouchPanel.readData(); // otherwise data is read by the sampler started by the ADS7846 interrupt
+#endif
     handleTouchPanelEvents();
 }
 
@@ -90,6 +92,10 @@ void handleTouchPanelEvents() {
         }
 #  endif
 
+        if (sTouchObjectTouched == NO_TOUCH) {
+            LocalTouchSlider::resetDrawStatistics(); // counters are per drag
+        }
+
         /*
          * Check if button or slider is touched.
          * Check button first in order to give priority to buttons which are overlapped by sliders.
@@ -112,146 +118,70 @@ void handleTouchPanelEvents() {
             sTouchObjectTouched = PANEL_TOUCHED;
         }
     }
+    // draw last slider value after coalesced redraws, at the latest at touch up
+    LocalTouchSlider::drawPendingValue(sTouchObjectTouched == NO_TOUCH);
 }
 
 #else //  !defined(USE_TIMER_FOR_PERIODIC_LOCAL_TOUCH_CHECKS)
 
-void checkForMovesAndSwipes(); // local forward declaration
 extern struct BluetoothEvent localTouchEvent; // helps the eclipse indexer :-(
 
+static void handleLocalTouchEvent(uint8_t aEventType) {
+    localTouchEvent.EventData.TouchEventInfo.TouchPosition = TouchPanel.mCurrentTouchPosition;
+    localTouchEvent.EventData.TouchEventInfo.TouchPointerIndex = 0;
+    localTouchEvent.EventType = aEventType;
+    handleEvent(&localTouchEvent);
+}
+
 /*
- * To be called by ADS7846 interrupt on touch down and touch up
- * This in turn starts the periodic timer with changeDelayCallback() to check for moves, long touch down and swipes.
+ * Called by checkAndHandleEvents().
+ * Handles the touch events of the ADS7846 sampler queue in thread context. The sampler is started by the ADS7846 interrupt
+ * and reads the panel periodically while touched, so moves, long touch down and swipes are detected.
+ * Button and slider callbacks are called directly, touches not on a button or slider generate BlueDisplay events.
  */
 void handleTouchPanelEvents(void) {
-    bool tLevel = ADS7846_getInteruptLineLevel();
-    BSP_LED_Toggle (LED_GREEN_2); // GREEN RIGHT
-    if (!tLevel) {
-        /*
-         * touchDown event - line input is low
-         * Fill in the local event structure, which is read by checkAndHandleEvents()
-         */
-        TouchPanel.readData(ADS7846_READ_OVERSAMPLING_DEFAULT); // this disables interrupt for additional TOUCH_DELAY_AFTER_READ_MILLIS
-        TouchPanel.mTouchDownPosition= TouchPanel.mCurrentTouchPosition;
-        TouchPanel.mLastTouchPosition = TouchPanel.mCurrentTouchPosition;
-
-        /*
-         * Check if button or slider is touched
-         * Check button first in order to give priority to buttons which are overlapped by sliders
-         * Remember which is pressed first and "stay" there
-         * !!! We are calling the slider and button callback here in ISR context !!!
-         */
-        LocalTouchButton *tTouchedButton = LocalTouchButton::find(TouchPanel.mCurrentTouchPosition.PositionX,
-                TouchPanel.mCurrentTouchPosition.PositionY, false);
-        if (tTouchedButton != NULL) {
-            if (tTouchedButton->mFlags & FLAG_BUTTON_TYPE_AUTOREPEAT) {
-                // Local autorepeat button callback, which is autorepeatTouchHandler() can not be called by event, so we must call it directly here
-                tTouchedButton->mOnTouchHandler(tTouchedButton, 0);
-            } else {
-                //Red/Green button handling
-                if (tTouchedButton->mFlags & FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN) {
-                    // Toggle value for Red/Green button, because we called findButton() and not checkButton() which would do the handling for us.
-                    tTouchedButton->mValue = !tTouchedButton->mValue;
-                    if (!(tTouchedButton->mFlags & FLAG_BUTTON_TYPE_MANUAL_REFRESH)) {
-#  if defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY)
-                        tTouchedButton->mBDButtonPtr->setValueAndDraw(tTouchedButton->mValue); // Update also the remote button
-                        // local button refresh is done by event handler
-#  endif
-                    }
-                }
-                /*
-                 * Create button event for processing by main loop in order to return from ISR
-                 */
-                localTouchEvent.EventType = EVENT_BUTTON_CALLBACK;
-                localTouchEvent.EventData.GuiCallbackInfo.CallbackFunctionAddress = (void*) tTouchedButton->mOnTouchHandler;
-                localTouchEvent.EventData.GuiCallbackInfo.ValueForGUICallback.uint16Values[0] = tTouchedButton->mValue; // we support only 16 bit values for buttons
-#  if defined(SUPPORT_REMOTE_AND_LOCAL_DISPLAY)
-                localTouchEvent.EventData.GuiCallbackInfo.ObjectIndex = tTouchedButton->mBDButtonPtr->mButtonHandle;
-#  endif
-            }
-            sTouchObjectTouched = BUTTON_TOUCHED;
-
-        } else if (LocalTouchSlider::checkAllSliders(TouchPanel.mCurrentTouchPosition.PositionX,
-                TouchPanel.mCurrentTouchPosition.PositionY)) {
-            sTouchObjectTouched = SLIDER_TOUCHED;
-
-        } else {
-            // no button or slider touched -> plain touch down event
-            sTouchObjectTouched = PANEL_TOUCHED;
-
-            localTouchEvent.EventData.TouchEventInfo.TouchPosition = TouchPanel.mCurrentTouchPosition;
-            localTouchEvent.EventData.TouchEventInfo.TouchPointerIndex = 0;
-            localTouchEvent.EventType = EVENT_TOUCH_ACTION_DOWN;
-        }
-
-        if (TouchPanel.ADS7846TouchActive) {
-            TouchPanel.ADS7846TouchStart = true;
+    uint8_t tEventType;
+    while ((tEventType = TouchPanel.handleNextSamplerEvent()) != TOUCH_FILTER_EVENT_NONE) {
+        resetBacklightTimeout();
+        uint16_t tPositionX = TouchPanel.mCurrentTouchPosition.PositionX;
+        uint16_t tPositionY = TouchPanel.mCurrentTouchPosition.PositionY;
+
+        if (tEventType == TOUCH_FILTER_EVENT_DOWN) {
+            BSP_LED_Toggle (LED_GREEN_2); // GREEN RIGHT
+            TouchPanel.mTouchDownPosition = TouchPanel.mCurrentTouchPosition;
+            TouchPanel.mLastTouchPosition = TouchPanel.mCurrentTouchPosition;
+            LocalTouchSlider::resetDrawStatistics(); // counters are per drag
             /*
-             * Enable move recognition by periodically reading actual position.
+             * Check if button or slider is touched
+             * Check button first in order to give priority to buttons which are overlapped by sliders
+             * Remember which is pressed first and "stay" there
              */
-            changeDelayCallback(&checkForMovesAndSwipes, TOUCH_SWIPE_RESOLUTION_MILLIS);
-
+            if (LocalTouchButton::checkAllButtons(tPositionX, tPositionY, false)) {
+                sTouchObjectTouched = BUTTON_TOUCHED;
+            } else if (LocalTouchSlider::checkAllSliders(tPositionX, tPositionY)) {
+                sTouchObjectTouched = SLIDER_TOUCHED;
+            } else {
+                // no button or slider touched -> plain touch down event
+                sTouchObjectTouched = PANEL_TOUCHED;
+                handleLocalTouchEvent(EVENT_TOUCH_ACTION_DOWN);
+            }
             /*
              * Enable long touch down detection if touch is not on a slider
              */
             if (sTouchObjectTouched != SLIDER_TOUCHED && sLongTouchDownCallback != NULL) {
                 changeDelayCallback(&callbackHandlerForLongTouchDownTimeout, sLongTouchDownTimeoutMillis); // enable timeout
             }
-        } else {
-            // line was active but values could not be read correctly (e.g. because of delay by higher prio interrupts)
-            BSP_LED_Toggle (LED_BLUE); // BLUE Back
-        }
-    } else {
-        /**
-         * Touch released here
-         */
-        changeDelayCallback(&checkForMovesAndSwipes, DISABLE_TIMER_DELAY_VALUE); // disable periodic interrupts which can call handleTouchRelease
-        if (TouchPanel.ADS7846TouchActive) {
-            TouchPanel.ADS7846TouchActive = false;
-            handleLocalTouchUp();
-            sTouchObjectTouched = NO_TOUCH;
-        }
-    }
-    resetBacklightTimeout();
-// Clear the EXTI line pending bit and enable new interrupt on other edge
-    ADS7846_ClearITPendingBit();
-}
 
-/**
- * Callback routine for SysTick handler
- * Enabled at touch down at a rate of TOUCH_SWIPE_RESOLUTION_MILLIS (20ms)
- */
-void checkForMovesAndSwipes(void) {
-    int tLevel = ADS7846_getInteruptLineLevel();
-    if (!tLevel) {
-        // pressed - line input is low, touch still active
-        TouchPanel.readData(ADS7846_READ_OVERSAMPLING_DEFAULT);
-        localTouchEvent.EventData.TouchEventInfo.TouchPosition = TouchPanel.mCurrentTouchPosition;
-        localTouchEvent.EventData.TouchEventInfo.TouchPointerIndex = 0;
-        if (!TouchPanel.ADS7846TouchActive) {
-            // went inactive just while readRawData()
-            if (sTouchObjectTouched == PANEL_TOUCHED) {
-                // Generate touch up event if no button or slider was touched
-                handleLocalTouchUp();
-            }
-        } else {
+        } else if (tEventType == TOUCH_FILTER_EVENT_MOVE) {
             /*
              * Check if autorepeat button or slider is still touched.
-             * Check button first in order to give priority to buttons which are overlapped by sliders.
-             * Remember which is pressed first and "stay" there.
-             * !!! we are calling the autorepeat button and slider callbacks here in ISR context !!!
-             * Calling autorepeat button callback with event is too complicated,
-             * because the event is yet not aware of the class LocalTouchButtonAutorepeat required by
-             * the autorepeatTouchHandler(), which generates the timing, and therefore the callback crashes.
+             * Move events are generated every TOUCH_SAMPLER_PERIOD_MILLIS while touched, which gives the autorepeat timing.
              */
             if (sTouchObjectTouched == BUTTON_TOUCHED) {
-                // Check autorepeat buttons only if slider was not touched before
-                LocalTouchButton::checkAllButtons(TouchPanel.mCurrentTouchPosition.PositionX,
-                        TouchPanel.mCurrentTouchPosition.PositionY, true);
+                LocalTouchButton::checkAllButtons(tPositionX, tPositionY, true);
             } else if (sTouchObjectTouched == SLIDER_TOUCHED) {
-                LocalTouchSlider::checkAllSliders(TouchPanel.mCurrentTouchPosition.PositionX,
-                        TouchPanel.mCurrentTouchPosition.PositionY);
-            } else {
+                LocalTouchSlider::checkAllSliders(tPositionX, tPositionY);
+            } else if (sTouchObjectTouched == PANEL_TOUCHED) {
                 /*
                  * Do not accept pseudo or micro moves as an event.
                  * In the BlueDisplay app the threshold is set to mCurrentViewWidth / 100, which is 3 pixel here.
@@ -259,33 +189,35 @@ void checkForMovesAndSwipes(void) {
                 if (abs(TouchPanel.mLastTouchPosition.PositionX - TouchPanel.mCurrentTouchPosition.PositionX) >= 3
                         || abs(TouchPanel.mLastTouchPosition.PositionY - TouchPanel.mCurrentTouchPosition.PositionY) >= 3) {
                     TouchPanel.mLastTouchPosition = TouchPanel.mCurrentTouchPosition;
-
-                    // Significant move here
-
                     // avoid overwriting other (e.g long touch down) events
                     if (localTouchEvent.EventType == EVENT_NO_EVENT) {
-                        localTouchEvent.EventType = EVENT_TOUCH_ACTION_MOVE;
+                        handleLocalTouchEvent(EVENT_TOUCH_ACTION_MOVE);
                     }
                 }
             }
-            // restart timer
-            changeDelayCallback(&checkForMovesAndSwipes, TOUCH_SWIPE_RESOLUTION_MILLIS);
+
+        } else {
+            /**
+             * Touch released here
+             */
+            if (sTouchObjectTouched != NO_TOUCH) {
+                handleLocalTouchUp();
+                handleEvent(&localTouchEvent);
+                sTouchObjectTouched = NO_TOUCH;
+            }
         }
-    } else {
-        handleLocalTouchUp();
-        sTouchObjectTouched = NO_TOUCH;
     }
+    // draw last slider value after coalesced redraws, at the latest at touch up
+    LocalTouchSlider::drawPendingValue(sTouchObjectTouched == NO_TOUCH);
 }
 
 /**
- * This handler is called on both edge of touch interrupt signal.
- * Actually the ADS7846 IRQ signal bounces on rising edge (going inactive).
- * This can happen up to 8 milliseconds after initial transition.
+ * This handler is called on both edges of touch interrupt signal.
+ * Actually the ADS7846 IRQ signal bounces on rising edge (going inactive) up to 8 milliseconds after initial transition.
+ * We do not wait for debouncing here, the sampler checks the pressure of each burst instead.
  */
 extern "C" void EXTI1_IRQHandler(void) {
-// wait for stable reading
-    delay(TOUCH_DEBOUNCE_DELAY_MILLIS);
-    handleTouchPanelEvents();
+    ADS7846_startSampling();
 }
 
 /*
@@ -38,6 +38,12 @@ extern int sLCDDimDelay; //actual dim delay
 #define BACKLIGHT_DIM_VALUE                   7
 #define BACKLIGHT_DIM_DEFAULT_DELAY_MILLIS 120000 // Two minutes
 
+/*
+ * Entry mode register 0x11. In landscape format the AM bit selects x increment first.
+ */
+#define SSD1289_ENTRY_MODE_X_FIRST  0x6038 // 6=65k Color, 3=horizontal increment, 8=vertical increment
+#define SSD1289_ENTRY_MODE_Y_FIRST  0x6030 // AM=0 -> increment y first, used for vertical spans
+
 #ifdef __cplusplus
 class SSD1289 { // @suppress("Class has a virtual method and non-virtual destructor")
 
@@ -57,7 +63,12 @@ public:
     void drawLine(uint16_t aXStart, uint16_t aYStart, uint16_t aXEnd, uint16_t aYEnd, color16_t aColor);
     void drawLineRel(uint16_t aStartX, uint16_t aStartY, int16_t aDeltaX, int16_t aDeltaY, color16_t aColor);
     void drawLineFastOneX(uint16_t x0, uint16_t y0, uint16_t y1, color16_t color);
+    void drawPolyline(const XYPosition *aPoints, uint16_t aNumberOfPoints, color16_t aColor);
+    void drawSpan(uint16_t aXStart, uint16_t aYStart, uint16_t aLength, bool aIsVertical, color16_t aColor);
     void drawRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, color16_t color);
+    void drawImage(uint16_t aXStart, uint16_t aYStart, uint16_t aWidth, uint16_t aHeight, const uint16_t *aRGB565Pixels);
+    bool isDrawOngoing();
+    void waitForDrawEnd();
 
     /*
      * Basic hardware functions required for the draw functions below
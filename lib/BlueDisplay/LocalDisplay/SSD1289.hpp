@@ -26,7 +26,7 @@
 
 #include "SSD1289.h"
 #include "LocalDisplayInterface.hpp"
-#include "LocalGUI/ThickLine.h" // for drawLineOverlap()
+#include "LocalGUI/ThickLine.h" // for drawLineSpans()
 
 #include "BlueDisplay.h"
 #include "main.h" // for StringBuffer
@@ -37,6 +37,13 @@
 #include <string.h>  // for strcat
 #include <stdlib.h>  // for malloc
 
+extern "C" {
+#include "imageWriter.h"
+}
+
+#if !defined(SCREENSHOT_FORMAT)
+#define SCREENSHOT_FORMAT IMAGE_FORMAT_BMP // IMAGE_FORMAT_TGA_RLE gives files of typically less than 10 percent size
+#endif
 
 /** @addtogroup Graphic_Library
  * @{
@@ -49,6 +56,12 @@
 
 bool isInitializedSSD1289 = false;
 volatile uint32_t sDrawLock = 0;
+/*
+ * Controller state for drawSpan(). Spans only set the cursor, if the area is the full display.
+ * Every setArea() restores the x first entry mode, which is required by all other draw functions.
+ */
+static bool sAreaIsFullDisplay = false;
+static bool sEntryModeIsYFirst = false;
 /*
  * For automatic LCD dimming
  */
@@ -73,6 +86,9 @@ SSD1289::~SSD1289() {
 void SSD1289::init(void) {
 //init pins
     SSD1289_IO_initalize();
+#if defined(SSD1289_USE_DMA)
+    SSD1289_DMA_initialize();
+#endif
 // init PWM for background LED
     PWM_BL_initalize();
     setBrightness(BACKLIGHT_START_BRIGHTNESS_VALUE);
@@ -90,12 +106,18 @@ void SSD1289::setArea(uint16_t aPositionX, uint16_t aPositionY, uint16_t aXEnd,
         assertFailedParamMessage((uint8_t*) __FILE__, __LINE__, aXEnd, aYEnd, "");
     }
 
+    if (sEntryModeIsYFirst) {
+        writeCommand(0x11, SSD1289_ENTRY_MODE_X_FIRST);
+        sEntryModeIsYFirst = false;
+    }
     writeCommand(0x44, aPositionY + (aYEnd << 8)); //set ystart, yend
     writeCommand(0x45, aPositionX); //set xStart
     writeCommand(0x46, aXEnd); //set xEnd
 // also set cursor to right start position
     writeCommand(0x4E, aPositionY);
     writeCommand(0x4F, aPositionX);
+    sAreaIsFullDisplay = (aPositionX == 0 && aPositionY == 0 && aXEnd == LOCAL_DISPLAY_WIDTH - 1
+            && aYEnd == LOCAL_DISPLAY_HEIGHT - 1);
 }
 
 void SSD1289::setCursor(uint16_t aPositionX, uint16_t aPositionY) {
@@ -104,11 +126,13 @@ void SSD1289::setCursor(uint16_t aPositionX, uint16_t aPositionY) {
 }
 
 void SSD1289::clearDisplay(uint16_t aColor) {
-    unsigned int size;
     setArea(0, 0, LOCAL_DISPLAY_WIDTH - 1, LOCAL_DISPLAY_HEIGHT - 1);
 
     drawStart();
-    for (size = (LOCAL_DISPLAY_HEIGHT * LOCAL_DISPLAY_WIDTH); size != 0; size--) {
+#if defined(SSD1289_USE_DMA)
+    SSD1289_DMA_startTransfer(&aColor, LOCAL_DISPLAY_HEIGHT * LOCAL_DISPLAY_WIDTH, false);
+#else
+    for (unsigned int size = (LOCAL_DISPLAY_HEIGHT * LOCAL_DISPLAY_WIDTH); size != 0; size--) {
         HY32D_DATA_GPIO_PORT->ODR = aColor;
         // Latch data write
         HY32D_WR_GPIO_PORT->BSRR = (uint32_t) HY32D_WR_PIN << 16;
@@ -116,6 +140,7 @@ void SSD1289::clearDisplay(uint16_t aColor) {
 
     }
     HY32D_CS_GPIO_PORT->BSRR = HY32D_CS_PIN;
+#endif
 
 }
 
@@ -131,6 +156,9 @@ uint16_t SSD1289::getDisplayHeight(void) {
  * set register address to LCD_GRAM_READ/WRITE_REGISTER
  */
 void SSD1289::drawStart(void) {
+#if defined(SSD1289_USE_DMA)
+    SSD1289_DMA_waitForTransferEnd();
+#endif
 // CS enable (low)
     HY32D_CS_GPIO_PORT->BSRR = (uint32_t) HY32D_CS_PIN << 16;
 // Control enable (low)
@@ -175,7 +203,48 @@ void SSD1289::drawLineRel(uint16_t aStartX, uint16_t aStartY, int16_t aDeltaX, i
 }
 
 void SSD1289::drawLine(uint16_t aPositionX, uint16_t aPositionY, uint16_t aXEnd, uint16_t aYEnd, color16_t aColor) {
-    drawLineOverlap(aPositionX, aPositionY, aXEnd, aYEnd, LINE_OVERLAP_NONE, aColor);
+    drawLineSpans(aPositionX, aPositionY, aXEnd, aYEnd, false, aColor);
+}
+
+void SSD1289::drawPolyline(const XYPosition *aPoints, uint16_t aNumberOfPoints, color16_t aColor) {
+    drawPolylineSpans(aPoints, aNumberOfPoints, aColor);
+}
+
+/**
+ * Draws a horizontal or vertical run of pixels by setting only the cursor and streaming the pixels.
+ * The area is set to the full display once, and kept for all following spans until the next setArea().
+ * Vertical spans switch the entry mode to y first. This costs 2 register writes per span instead of 5 for setArea()
+ * and instead of 2 per pixel for drawPixel().
+ * Is clipped to the display.
+ */
+void SSD1289::drawSpan(uint16_t aXStart, uint16_t aYStart, uint16_t aLength, bool aIsVertical, color16_t aColor) {
+    if ((aXStart >= LOCAL_DISPLAY_WIDTH) || (aYStart >= LOCAL_DISPLAY_HEIGHT) || aLength == 0) {
+        return;
+    }
+    if (aIsVertical) {
+        if (aLength > LOCAL_DISPLAY_HEIGHT - aYStart) {
+            aLength = LOCAL_DISPLAY_HEIGHT - aYStart;
+        }
+    } else if (aLength > LOCAL_DISPLAY_WIDTH - aXStart) {
+        aLength = LOCAL_DISPLAY_WIDTH - aXStart;
+    }
+
+    if (!sAreaIsFullDisplay) {
+        setArea(0, 0, LOCAL_DISPLAY_WIDTH - 1, LOCAL_DISPLAY_HEIGHT - 1);
+    }
+    // entry mode does not matter for a single pixel
+    if (aLength > 1 && aIsVertical != sEntryModeIsYFirst) {
+        writeCommand(0x11, aIsVertical ? SSD1289_ENTRY_MODE_Y_FIRST : SSD1289_ENTRY_MODE_X_FIRST);
+        sEntryModeIsYFirst = aIsVertical;
+    }
+    writeCommand(0x4E, aYStart);
+    writeCommand(0x4F, aXStart);
+
+    drawStart();
+    for (; aLength != 0; aLength--) {
+        draw(aColor);
+    }
+    drawStop();
 }
 
 void SSD1289::fillRect(uint16_t aPositionX, uint16_t aPositionY, uint16_t aXEnd, uint16_t aYEnd, color16_t aColor) {
@@ -204,6 +273,13 @@ void SSD1289::fillRect(uint16_t aPositionX, uint16_t aPositionY, uint16_t aXEnd,
 
     drawStart();
     size = (uint32_t) (1 + (aXEnd - aPositionX)) * (uint32_t) (1 + (aYEnd - aPositionY));
+#if defined(SSD1289_USE_DMA)
+    if (size >= SSD1289_DMA_MIN_PIXELS) {
+        // returns immediately, the next access to the display waits for the end of the fill
+        SSD1289_DMA_startTransfer(&aColor, size, false);
+        return;
+    }
+#endif
     tmp = size / 8;
     if (tmp != 0) {
         for (i = tmp; i != 0; i--) {
@@ -216,7 +292,7 @@ void SSD1289::fillRect(uint16_t aPositionX, uint16_t aPositionY, uint16_t aXEnd,
             draw(aColor); //7
             draw(aColor); //8
         }
-        for (i = size - tmp; i != 0; i--) {
+        for (i = size - (tmp * 8); i != 0; i--) {
             draw(aColor);
         }
     } else {
@@ -310,6 +386,66 @@ uint16_t SSD1289::readPixel(uint16_t aPositionX, uint16_t aPositionY) {
     return tValue;
 }
 
+/**
+ * Copies a RGB565 image to the display. Is clipped to the display.
+ * If DMA is used, the function returns before all pixel are written,
+ * so aRGB565Pixels must not be changed until isDrawOngoing() returns false.
+ */
+void SSD1289::drawImage(uint16_t aXStart, uint16_t aYStart, uint16_t aWidth, uint16_t aHeight,
+        const uint16_t *aRGB565Pixels) {
+    if ((aXStart >= LOCAL_DISPLAY_WIDTH) || (aYStart >= LOCAL_DISPLAY_HEIGHT) || aWidth == 0 || aHeight == 0) {
+        return;
+    }
+    uint16_t tVisibleWidth = aWidth;
+    if (tVisibleWidth > LOCAL_DISPLAY_WIDTH - aXStart) {
+        tVisibleWidth = LOCAL_DISPLAY_WIDTH - aXStart;
+    }
+    if (aHeight > LOCAL_DISPLAY_HEIGHT - aYStart) {
+        aHeight = LOCAL_DISPLAY_HEIGHT - aYStart;
+    }
+    setArea(aXStart, aYStart, aXStart + tVisibleWidth - 1, aYStart + aHeight - 1);
+
+    drawStart();
+    if (tVisibleWidth == aWidth) {
+        uint32_t tNumberOfPixels = (uint32_t) aWidth * aHeight;
+#if defined(SSD1289_USE_DMA)
+        if (tNumberOfPixels >= SSD1289_DMA_MIN_PIXELS) {
+            SSD1289_DMA_startTransfer(aRGB565Pixels, tNumberOfPixels, true);
+            return;
+        }
+#endif
+        for (; tNumberOfPixels != 0; tNumberOfPixels--) {
+            draw(*aRGB565Pixels++);
+        }
+    } else {
+        // skip the clipped right part of each line
+        for (; aHeight != 0; aHeight--) {
+            for (uint16_t i = 0; i < tVisibleWidth; ++i) {
+                draw(aRGB565Pixels[i]);
+            }
+            aRGB565Pixels += aWidth;
+        }
+    }
+    drawStop();
+}
+
+/**
+ * @return true if a DMA fill or image is still written to the display
+ */
+bool SSD1289::isDrawOngoing() {
+#if defined(SSD1289_USE_DMA)
+    return SSD1289_DMA_isTransferOngoing();
+#else
+    return false;
+#endif
+}
+
+void SSD1289::waitForDrawEnd() {
+#if defined(SSD1289_USE_DMA)
+    SSD1289_DMA_waitForTransferEnd();
+#endif
+}
+
 void SSD1289::drawRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, color16_t color) {
     fillRect(x0, y0, x0, y1, color);
     fillRect(x0, y1, x1, y1, color);
@@ -321,10 +457,9 @@ void SSD1289::drawRect(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, color
  * Fast routine for drawing data charts
  * draws a line only from x to x+1
  * first pixel is omitted because it is drawn by preceding line
- * uses setArea instead if drawPixel to speed up drawing
+ * uses vertical spans instead of drawPixel to speed up drawing
  */
 void SSD1289::drawLineFastOneX(uint16_t aPositionX, uint16_t aPositionY, uint16_t aYEnd, color16_t aColor) {
-    uint8_t i;
     bool up = true;
 //calculate direction
     int16_t deltaY = aYEnd - aPositionY;
@@ -342,37 +477,13 @@ void SSD1289::drawLineFastOneX(uint16_t aPositionX, uint16_t aPositionY, uint16_
         uint8_t deltaYHalf = deltaY >> 1;
         if (up) {
             // for odd numbers, first part of line is 1 pixel shorter than second
-            if (deltaY1 > 0) {
-                // first pixel was drawn by preceding line :-)
-                setArea(aPositionX, aPositionY + 1, aPositionX, aPositionY + deltaY1);
-                drawStart();
-                for (i = deltaY1; i != 0; i--) {
-                    draw(aColor);
-                }
-                drawStop();
-            }
-            setArea(aPositionX + 1, aPositionY + deltaY1 + 1, aPositionX + 1, aYEnd);
-            drawStart();
-            for (i = deltaYHalf + 1; i != 0; i--) {
-                draw(aColor);
-            }
-            drawStop();
+            // first pixel was drawn by preceding line :-)
+            drawSpan(aPositionX, aPositionY + 1, deltaY1, true, aColor);
+            drawSpan(aPositionX + 1, aPositionY + deltaY1 + 1, deltaYHalf + 1, true, aColor);
         } else {
             // for odd numbers, second part of line is 1 pixel shorter than first
-            if (deltaYHalf > 0) {
-                setArea(aPositionX, aPositionY - deltaYHalf, aPositionX, aPositionY - 1);
-                drawStart();
-                for (i = deltaYHalf; i != 0; i--) {
-                    draw(aColor);
-                }
-                drawStop();
-            }
-            setArea(aPositionX + 1, aYEnd, aPositionX + 1, (aPositionY - deltaYHalf) - 1);
-            drawStart();
-            for (i = deltaY1 + 1; i != 0; i--) {
-                draw(aColor);
-            }
-            drawStop();
+            drawSpan(aPositionX, aPositionY - deltaYHalf, deltaYHalf, true, aColor);
+            drawSpan(aPositionX + 1, aYEnd, deltaY1 + 1, true, aColor);
         }
     }
 }
@@ -460,6 +571,9 @@ void callbackLCDDimming(void) {
 }
 
 void writeCommand(int aRegisterAddress, int aRegisterValue) {
+#if defined(SSD1289_USE_DMA)
+    SSD1289_DMA_waitForTransferEnd();
+#endif
 // CS enable (low)
     HY32D_CS_GPIO_PORT->BSRR = (uint32_t) HY32D_CS_PIN << 16;
 // Control enable (low)
@@ -532,7 +646,8 @@ bool initalizeDisplay(void) {
     writeCommand(0x0010, 0x0000); // Exit sleep mode
     delay(50);
 
-    writeCommand(0x0011, 0x6038); // 6=65k Color, 38=draw direction -> 3=horizontal increment, 8=vertical increment
+    writeCommand(0x0011, SSD1289_ENTRY_MODE_X_FIRST);
+    sEntryModeIsYFirst = false;
 //	writeCommand(0x0016, 0xEF1C); // 240 pixel
     writeCommand(0x0017, 0x0003);
     writeCommand(0x0007, 0x0133); // 1=the 2-division LCD drive is performed, 8 Color mode, grayscale
@@ -679,49 +794,32 @@ uint16_t* SSD1289::fillDisplayLineBuffer(uint16_t *aBufferPtr, uint16_t yLineNum
     return aBufferPtr;
 }
 
+/*
+ * Line reader for ImageWriter_store()
+ */
+static void readDisplayLine(uint16_t *aLineBuffer, uint16_t aLineNumber) {
+    LocalDisplay.fillDisplayLineBuffer(aLineBuffer, aLineNumber);
+}
+
+/**
+ * Reading the display lines is overlapped with writing to the card, see imageWriter.h.
+ * Phase timing is available by ImageWriter_getStatistics().
+ */
 extern "C" void storeScreenshot(void) {
     bool tIsError = true;
     if (MICROSD_isCardInserted()) {
-
-        FIL tFile;
-        FRESULT tOpenResult;
-        UINT tCount;
-//	int filesize = 54 + 2 * LOCAL_DISPLAY_WIDTH * LOCAL_DISPLAY_HEIGHT;
-
-        unsigned char bmpfileheader[14] = { 'B', 'M', 54, 88, 02, 0, 0, 0, 0, 0, 54, 0, 0, 0 };
-        unsigned char bmpinfoheader[40] = { 40, 0, 0, 0, 64, 1, 0, 0, 240, 0, 0, 0, 1, 0, 16, 0 };
-
-//	bmpfileheader[2] = (unsigned char) (filesize);
-//	bmpfileheader[3] = (unsigned char) (filesize >> 8);
-//	bmpfileheader[4] = (unsigned char) (filesize >> 16);
-//	bmpfileheader[5] = (unsigned char) (filesize >> 24);
-
         RTC_getDateStringForFile(sStringBuffer);
+#if SCREENSHOT_FORMAT == IMAGE_FORMAT_TGA_RLE
+        strcat(sStringBuffer, ".tga");
+#else
         strcat(sStringBuffer, ".bmp");
-        tOpenResult = f_open(&tFile, sStringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
-        uint16_t *tBufferPtr;
-        if (tOpenResult == FR_OK) {
-            uint16_t *tFourDisplayLinesBufferPointer = (uint16_t*) malloc(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH);
-            if (tFourDisplayLinesBufferPointer == NULL) {
-                failParamMessage(sizeof(uint16_t) * 4 * DISPLAY_DEFAULT_WIDTH, "malloc() fails");
-            }
-            f_write(&tFile, bmpfileheader, 14, &tCount);
-            f_write(&tFile, bmpinfoheader, 40, &tCount);
-            // from left to right and from bottom to top
-            for (int i = LOCAL_DISPLAY_HEIGHT - 1; i >= 0;) {
-                tBufferPtr = tFourDisplayLinesBufferPointer;
-                // write 4 lines at a time to speed up I/O
-                tBufferPtr = LocalDisplay.fillDisplayLineBuffer(tBufferPtr, i--);
-                tBufferPtr = LocalDisplay.fillDisplayLineBuffer(tBufferPtr, i--);
-                tBufferPtr = LocalDisplay.fillDisplayLineBuffer(tBufferPtr, i--);
-                LocalDisplay.fillDisplayLineBuffer(tBufferPtr, i--);
-                // write a display line
-                f_write(&tFile, tFourDisplayLinesBufferPointer, LOCAL_DISPLAY_WIDTH * 8, &tCount);
-            }
-            free(tFourDisplayLinesBufferPointer);
-            f_close(&tFile);
-            tIsError = false;
+#endif
+        FRESULT tResult = ImageWriter_store(sStringBuffer, SCREENSHOT_FORMAT, LOCAL_DISPLAY_WIDTH, LOCAL_DISPLAY_HEIGHT,
+                &readDisplayLine);
+        if (tResult == FR_NOT_ENOUGH_CORE) {
+            failParamMessage(tResult, "malloc() fails");
         }
+        tIsError = (tResult != FR_OK);
     }
     LocalTouchButton::playFeedbackTone(tIsError);
 }
@@ -31,6 +31,7 @@
 #ifdef STM32F30X
 #include <stm32f3xx.h>
 #endif
+#include "timing.h" // for startWaitTimeout() and failParamMessage()
 
 TIM_HandleTypeDef TIM4Handle;
 
@@ -58,6 +59,235 @@ void SSD1289_IO_initalize(void) {
     HAL_GPIO_Init(HY32D_DATA_GPIO_PORT, &GPIO_InitStructure);
 }
 
+#if defined(SSD1289_USE_DMA)
+/*
+ * SSD1289 DMA
+ * TIM1 runs with SSD1289_DMA_TIMER_TICKS_PER_PIXEL ticks per pixel and requests 3 DMA transfers for each pixel:
+ * Compare 3 -> channel 6 writes WR low to the BSRR register.
+ * Compare 4 -> channel 4 writes WR high to the BSRR register. This rising edge latches the pixel.
+ * Update    -> channel 5 writes the next pixel to the data port. Only used for images,
+ *              for fill, the color is set once by the CPU and stays on the data port.
+ * The DMA priorities keep this order if a request is delayed by bus contention until the next one is pending:
+ * WR low (very high) before WR high (high) before the next pixel (medium).
+ * The first pixel of each chunk is set by the CPU. The end of a chunk is signaled by channel 4, which writes the last strobe.
+ * Transfers of more than 0xFFFF pixel are split into chunks, the next chunk is started by the interrupt.
+ * CS stays low during the transfer and is released after the last chunk.
+ */
+#define SSD1289_DMA_WR_LOW_TICK         (SSD1289_DMA_TIMER_TICKS_PER_PIXEL / 3)
+#define SSD1289_DMA_WR_HIGH_TICK        ((SSD1289_DMA_TIMER_TICKS_PER_PIXEL * 2) / 3)
+#define SSD1289_DMA_MAX_CHUNK_PIXELS    0xFFFF
+#define SSD1289_DMA_TIMER_REQUESTS      (TIM_DMA_UPDATE | TIM_DMA_CC3 | TIM_DMA_CC4)
+
+static TIM_HandleTypeDef TIM1Handle;
+static DMA_HandleTypeDef DMA14_WRHigh_Handle;
+static DMA_HandleTypeDef DMA15_Data_Handle;
+static DMA_HandleTypeDef DMA16_WRLow_Handle;
+// in RAM, since DMA reads from flash compete with instruction fetch
+static uint32_t sSSD1289DMAWRLow = (uint32_t) HY32D_WR_PIN << 16;
+static uint32_t sSSD1289DMAWRHigh = HY32D_WR_PIN;
+static uint16_t sSSD1289DMAFillColor; // copy of the color, since the caller returns before the transfer ends
+static const uint16_t *sSSD1289DMASource;
+static bool sSSD1289DMAIncrementSource;
+static uint32_t sSSD1289DMARemainingPixels;
+static volatile bool sSSD1289DMATransferOngoing = false;
+static volatile bool sSSD1289DMATransferError = false;
+
+static void SSD1289_DMA_initializeChannel(DMA_HandleTypeDef *aHandle, DMA_Channel_TypeDef *aChannel,
+        volatile uint32_t *aPeripheralRegister, const void *aSource, bool aIsData, uint32_t aPriority) {
+    aHandle->Instance = aChannel;
+    aHandle->Init.Direction = DMA_MEMORY_TO_PERIPH;
+    aHandle->Init.PeriphInc = DMA_PINC_DISABLE;
+    if (aIsData) {
+        aHandle->Init.MemInc = DMA_MINC_ENABLE;
+        aHandle->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+        aHandle->Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD;
+    } else {
+        // single word source without increment, i.e. the same BSRR value for each pixel
+        aHandle->Init.MemInc = DMA_MINC_DISABLE;
+        aHandle->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+        aHandle->Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    }
+    aHandle->Init.Mode = DMA_NORMAL;
+    aHandle->Init.Priority = aPriority;
+    HAL_DMA_Init(aHandle);
+    aChannel->CPAR = (uint32_t) aPeripheralRegister;
+    aChannel->CMAR = (uint32_t) aSource;
+}
+
+void SSD1289_DMA_initialize(void) {
+    __DMA1_CLK_ENABLE()
+    ;
+    SSD1289_DMA_initializeChannel(&DMA14_WRHigh_Handle, DMA1_Channel4, &HY32D_WR_GPIO_PORT->BSRR, &sSSD1289DMAWRHigh,
+            false, DMA_PRIORITY_HIGH);
+    SSD1289_DMA_initializeChannel(&DMA15_Data_Handle, DMA1_Channel5, &HY32D_DATA_GPIO_PORT->ODR, NULL, true,
+            DMA_PRIORITY_MEDIUM);
+    // without explicit priority, channel 4 would be served before channel 6
+    SSD1289_DMA_initializeChannel(&DMA16_WRLow_Handle, DMA1_Channel6, &HY32D_WR_GPIO_PORT->BSRR, &sSSD1289DMAWRLow,
+            false, DMA_PRIORITY_VERY_HIGH);
+
+    TIM1Handle.Instance = TIM1;
+    __TIM1_CLK_ENABLE()
+    ;
+    TIM1Handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    TIM1Handle.Init.Prescaler = 0; // 72 MHz
+    TIM1Handle.Init.Period = SSD1289_DMA_TIMER_TICKS_PER_PIXEL - 1;
+    TIM1Handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    TIM1Handle.Init.RepetitionCounter = 0;
+    HAL_TIM_Base_Init(&TIM1Handle);
+
+    // compare channels without output, only for the DMA requests
+    TIM_OC_InitTypeDef tOCInitStructure;
+    tOCInitStructure.OCMode = TIM_OCMODE_TIMING;
+    tOCInitStructure.OCFastMode = TIM_OCFAST_DISABLE;
+    tOCInitStructure.OCPolarity = TIM_OCPOLARITY_HIGH;
+    tOCInitStructure.OCIdleState = TIM_OCIDLESTATE_RESET;
+    tOCInitStructure.OCNPolarity = TIM_OCNPOLARITY_HIGH;
+    tOCInitStructure.OCNIdleState = TIM_OCNIDLESTATE_RESET;
+    tOCInitStructure.Pulse = SSD1289_DMA_WR_LOW_TICK;
+    HAL_TIM_OC_ConfigChannel(&TIM1Handle, &tOCInitStructure, TIM_CHANNEL_3);
+    tOCInitStructure.Pulse = SSD1289_DMA_WR_HIGH_TICK;
+    HAL_TIM_OC_ConfigChannel(&TIM1Handle, &tOCInitStructure, TIM_CHANNEL_4);
+
+    NVIC_SetPriority((IRQn_Type) (DMA1_Channel4_IRQn), 11);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (DMA1_Channel4_IRQn));
+}
+
+static void SSD1289_DMA_stopChunk(void) {
+    CLEAR_BIT(TIM1->CR1, TIM_CR1_CEN);
+    // a pending timer request would start a transfer as soon as the channel is enabled again
+    __HAL_TIM_DISABLE_DMA(&TIM1Handle, SSD1289_DMA_TIMER_REQUESTS);
+    CLEAR_BIT(DMA14_WRHigh_Handle.Instance->CCR, DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_TEIE);
+    CLEAR_BIT(DMA15_Data_Handle.Instance->CCR, DMA_CCR_EN);
+    CLEAR_BIT(DMA16_WRLow_Handle.Instance->CCR, DMA_CCR_EN);
+    __HAL_DMA_CLEAR_FLAG(&DMA14_WRHigh_Handle, DMA_FLAG_GL4);
+    __HAL_DMA_CLEAR_FLAG(&DMA15_Data_Handle, DMA_FLAG_GL5);
+    __HAL_DMA_CLEAR_FLAG(&DMA16_WRLow_Handle, DMA_FLAG_GL6);
+    // never leave WR low, e.g. after a transfer error or timeout
+    HY32D_WR_GPIO_PORT->BSRR = HY32D_WR_PIN;
+}
+
+static void SSD1289_DMA_startChunk(void) {
+    uint32_t tNumberOfPixels = sSSD1289DMARemainingPixels;
+    if (tNumberOfPixels > SSD1289_DMA_MAX_CHUNK_PIXELS) {
+        tNumberOfPixels = SSD1289_DMA_MAX_CHUNK_PIXELS;
+    }
+    sSSD1289DMARemainingPixels -= tNumberOfPixels;
+
+    // first pixel is set by CPU, the update event after each WR strobe sets the next one
+    HY32D_DATA_GPIO_PORT->ODR = *sSSD1289DMASource;
+    uint32_t tTimerRequests = TIM_DMA_CC3 | TIM_DMA_CC4;
+    if (sSSD1289DMAIncrementSource) {
+        if (tNumberOfPixels > 1) {
+            DMA15_Data_Handle.Instance->CMAR = (uint32_t) (sSSD1289DMASource + 1);
+            DMA15_Data_Handle.Instance->CNDTR = tNumberOfPixels - 1;
+            SET_BIT(DMA15_Data_Handle.Instance->CCR, DMA_CCR_EN);
+            tTimerRequests |= TIM_DMA_UPDATE;
+        }
+        sSSD1289DMASource += tNumberOfPixels;
+    }
+    DMA16_WRLow_Handle.Instance->CNDTR = tNumberOfPixels;
+    SET_BIT(DMA16_WRLow_Handle.Instance->CCR, DMA_CCR_EN);
+    DMA14_WRHigh_Handle.Instance->CNDTR = tNumberOfPixels;
+    SET_BIT(DMA14_WRHigh_Handle.Instance->CCR, DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_TEIE);
+
+    TIM1->CNT = 0;
+    __HAL_TIM_ENABLE_DMA(&TIM1Handle, tTimerRequests);
+    SET_BIT(TIM1->CR1, TIM_CR1_CEN);
+}
+
+/**
+ * Writes the pixels to the GRAM and returns immediately. SSD1289::drawStart() must be called before.
+ * The next call of SSD1289_DMA_waitForTransferEnd() waits for the end and releases CS.
+ * @param aPixels if aIncrementSource is false, only the first pixel is used, e.g. for fill.
+ *                Otherwise the buffer must not be changed until the end of the transfer.
+ */
+void SSD1289_DMA_startTransfer(const uint16_t *aPixels, uint32_t aNumberOfPixels, bool aIncrementSource) {
+    assert_param(aNumberOfPixels != 0);
+    SSD1289_DMA_waitForTransferEnd();
+
+    sSSD1289DMAIncrementSource = aIncrementSource;
+    if (aIncrementSource) {
+        sSSD1289DMASource = aPixels;
+    } else {
+        sSSD1289DMAFillColor = *aPixels;
+        sSSD1289DMASource = &sSSD1289DMAFillColor;
+    }
+    sSSD1289DMARemainingPixels = aNumberOfPixels;
+    sSSD1289DMATransferError = false;
+    sSSD1289DMATransferOngoing = true;
+    SSD1289_DMA_startChunk();
+}
+
+bool SSD1289_DMA_isTransferOngoing(void) {
+    return sSSD1289DMATransferOngoing;
+}
+
+/*
+ * Is called by the interrupt or by SSD1289_DMA_waitForTransferEnd() if the interrupt is blocked
+ */
+static void SSD1289_DMA_handleChunkEnd(void) {
+    if (!__HAL_DMA_GET_FLAG(&DMA14_WRHigh_Handle, DMA_FLAG_TC4 | DMA_FLAG_TE4)) {
+        return; // already handled
+    }
+    if (__HAL_DMA_GET_FLAG(&DMA16_WRLow_Handle, DMA_FLAG_TE6)) {
+        sSSD1289DMATransferError = true;
+        sSSD1289DMARemainingPixels = 0;
+    }
+    if (__HAL_DMA_GET_FLAG(&DMA14_WRHigh_Handle, DMA_FLAG_TE4)) {
+        sSSD1289DMATransferError = true;
+        sSSD1289DMARemainingPixels = 0;
+    }
+    SSD1289_DMA_stopChunk();
+    if (sSSD1289DMARemainingPixels != 0) {
+        SSD1289_DMA_startChunk();
+    } else {
+        HY32D_CS_GPIO_PORT->BSRR = HY32D_CS_PIN;
+        sSSD1289DMATransferOngoing = false;
+    }
+}
+
+/**
+ * Called before each access to the display. Can also be called by an ISR with higher priority than the DMA interrupt,
+ * e.g. a touch or button handler, since it handles the end of a chunk itself.
+ */
+void SSD1289_DMA_waitForTransferEnd(void) {
+    if (!sSSD1289DMATransferOngoing) {
+        return;
+    }
+    uint32_t tLR14 = getLR14();
+    WaitTimeoutTypeDef tTimeout;
+    startWaitTimeout(&tTimeout, SSD1289_DMA_TIMEOUT_MILLIS);
+    while (sSSD1289DMATransferOngoing) {
+        if (__HAL_DMA_GET_FLAG(&DMA14_WRHigh_Handle, DMA_FLAG_TC4 | DMA_FLAG_TE4)) {
+            uint32_t tPrimask = __get_PRIMASK();
+            __disable_irq();
+            if (sSSD1289DMATransferOngoing) {
+                SSD1289_DMA_handleChunkEnd();
+            }
+            __set_PRIMASK(tPrimask);
+        }
+        if (isWaitTimeout(&tTimeout)) {
+            SSD1289_DMA_stopChunk();
+            HY32D_CS_GPIO_PORT->BSRR = HY32D_CS_PIN;
+            sSSD1289DMATransferOngoing = false;
+            failParamMessage(tLR14, "Timeout in SSD1289_DMA_waitForTransferEnd()");
+            return;
+        }
+    }
+    if (sSSD1289DMATransferError) {
+        sSSD1289DMATransferError = false;
+        failParamMessage(tLR14, "SSD1289 DMA transfer error");
+    }
+}
+
+/**
+ * End of SSD1289 DMA chunk
+ */
+extern "C" void DMA1_Channel4_IRQHandler(void) {
+    SSD1289_DMA_handleChunkEnd();
+}
+#endif // SSD1289_USE_DMA
+
 /**
  * Pins for touch panel CS, PENINT
  */
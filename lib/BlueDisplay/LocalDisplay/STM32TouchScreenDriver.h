@@ -39,6 +39,7 @@
  *
  * Timer    |Function
  * ---------|--------
+ * 1        | Pixel clock for SSD1289 DMA transfers, generates the WR strobes (STM32F30X and SSD1289_USE_DMA only)
  * 4        | PWM backlight led -> Pin F6
 
  *
@@ -49,6 +50,14 @@
  * Prio | ISR Nr| Name                  | Usage
  * -----|-------------------------------|-------------
  * 3 0  | 0x17 | EXTI1_IRQn             | Touch
+ * 11   | 0x1E | DMA1_Channel4_IRQn     | End of SSD1289 DMA transfer (SSD1289_USE_DMA only)
+ *
+ * DMA usage
+ * ----------
+ * DMA | Channel | Peripheral
+ *   1 |       4 | TIM1_CH4 SSD1289 WR high
+ *   1 |       5 | TIM1_UP  SSD1289 data port
+ *   1 |       6 | TIM1_CH3 SSD1289 WR low
  *
  */
 #ifndef _STM32TOUCHSCREENDRIVER_H
@@ -57,6 +66,11 @@
 #if defined(STM32F10X) || defined(STM32F30X)
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#if defined(LOCAL_DISPLAY_EMULATOR)
+#include "LocalDisplayEmulator.h" // provides emulated GPIOB and GPIOD on the host
+#endif
 
 #define HY32D_CS_PIN                          GPIO_PIN_0
 #define HY32D_CS_GPIO_PORT                    GPIOB
@@ -83,6 +97,25 @@ typedef enum {
 
 void SSD1289_IO_initalize(void);
 
+/*
+ * Bulk pixel writes to the SSD1289 by DMA, paced by TIM1. The CPU only sets up the transfer
+ * and is free while the pixels are written. Only for STM32F30X and not available for the emulator.
+ * Not yet verified on hardware, so it must be enabled explicitly, e.g. by -DSSD1289_USE_DMA.
+ */
+//#define SSD1289_USE_DMA
+#if defined(SSD1289_USE_DMA) && (!defined(STM32F30X) || defined(LOCAL_DISPLAY_EMULATOR))
+#undef SSD1289_USE_DMA
+#endif
+#define SSD1289_DMA_MIN_PIXELS  256 // for less pixel, the CPU loop is faster than the DMA setup
+#define SSD1289_DMA_TIMER_TICKS_PER_PIXEL 12 // 167 ns at 72 MHz. SSD1289 requires >= 100 ns write cycle and >= 50 ns WR low
+#define SSD1289_DMA_TIMEOUT_MILLIS 100 // a full screen takes 13 ms
+#if defined(SSD1289_USE_DMA)
+void SSD1289_DMA_initialize(void);
+void SSD1289_DMA_startTransfer(const uint16_t *aPixels, uint32_t aNumberOfPixels, bool aIncrementSource);
+bool SSD1289_DMA_isTransferOngoing(void);
+void SSD1289_DMA_waitForTransferEnd(void);
+#endif
+
 void ADS7846_IO_initalize(void);
 void ADS7846_clearAndEnableInterrupt(void);
 void ADS7846_disableInterrupt(void);
@@ -129,6 +129,7 @@ public:
             false);
     static bool checkAllButtons(unsigned int aTouchPositionX, unsigned int aTouchPositionY,
             bool aCheckOnlyAutorepeatButtons = false);
+    static void rebuildIndex(); // Only if USE_LOCAL_TOUCH_INDEX. Is called by find() after a button was added, removed, moved, activated or deactivated
 
     // Position
     int8_t setPosition(uint16_t aPositionX, uint16_t aPositionY);
@@ -43,6 +43,7 @@
 #if !defined(DISABLE_REMOTE_DISPLAY)
 #include "LocalGUI/LocalTouchButtonAutorepeat.h"
 #endif
+#include "LocalGUI/LocalTouchIndex.hpp"
 /** @addtogroup Gui_Library
  * @{
  */
@@ -56,12 +57,28 @@
 LocalTouchButton *LocalTouchButton::sButtonListStart = NULL; // Start of list of touch buttons, required for the *AllButtons functions
 color16_t LocalTouchButton::sDefaultTextColor = TOUCHBUTTON_DEFAULT_TEXT_COLOR;
 
+#if defined(USE_LOCAL_TOUCH_INDEX)
+/*
+ * Grid index of all active buttons. It is rebuilt by the next find(),
+ * after a button was added, removed, moved, activated or deactivated.
+ */
+static uint8_t sButtonIndexEntries[LOCAL_TOUCH_INDEX_BUTTON_ENTRIES];
+static void *sButtonIndexObjects[LOCAL_TOUCH_INDEX_BUTTON_OBJECTS];
+static LocalTouchIndexStruct sButtonIndex = { { 0 }, sButtonIndexEntries, sButtonIndexObjects, LOCAL_TOUCH_INDEX_BUTTON_ENTRIES,
+        LOCAL_TOUCH_INDEX_BUTTON_OBJECTS, 0, false };
+static bool sButtonIndexIsDirty = true;
+#define invalidateButtonIndex() sButtonIndexIsDirty = true
+#else
+#define invalidateButtonIndex() void()
+#endif
+
 /**
  * Constructor - insert in list
  */
 LocalTouchButton::LocalTouchButton() { // @suppress("Class members should be properly initialized")
     mTextForTrue = NULL; // moving this into init() costs 100 bytes
     mNextObject = NULL;
+    invalidateButtonIndex();
     if (sButtonListStart == NULL) {
         // first button
         sButtonListStart = this;
@@ -93,6 +110,7 @@ LocalTouchButton::LocalTouchButton(BDButton *aBDButtonPtr) { // @suppress("Class
     mTextForTrue = NULL;
     mBDButtonPtr = aBDButtonPtr;
     mNextObject = NULL;
+    invalidateButtonIndex();
     if (sButtonListStart == NULL) {
         // first button
         sButtonListStart = this;
@@ -117,7 +135,7 @@ LocalTouchButton::~LocalTouchButton() {
     LocalTouchButton *tButtonPointer = sButtonListStart;
     if (tButtonPointer == this) {
         // remove first element of list
-        sButtonListStart = NULL;
+        sButtonListStart = mNextObject;
     } else {
         // walk through list to find previous element
         while (tButtonPointer != NULL) {
@@ -128,6 +146,7 @@ LocalTouchButton::~LocalTouchButton() {
             tButtonPointer = tButtonPointer->mNextObject;
         }
     }
+    invalidateButtonIndex();
 }
 #endif
 
@@ -232,6 +251,7 @@ int8_t LocalTouchButton::setPosition(uint16_t aPositionX, uint16_t aPositionY) {
     int8_t tRetValue = 0;
     mPositionX = aPositionX;
     mPositionY = aPositionY;
+    invalidateButtonIndex();
 
     // check values
     if (aPositionX + mWidthX > LOCAL_DISPLAY_WIDTH) {
@@ -272,7 +292,7 @@ void LocalTouchButton::drawButton() {
  * Deactivates the button and redraws its screen space with @a aBackgroundColor
  */
 void LocalTouchButton::removeButton(color16_t aBackgroundColor) {
-    mFlags &= ~LOCAL_BUTTON_FLAG_IS_ACTIVE;
+    deactivate();
     // Draw rect
     LocalDisplay.fillRectRel(mPositionX, mPositionY, mWidthX, mHeightY, aBackgroundColor);
 
@@ -286,7 +306,7 @@ void LocalTouchButton::drawCaption() {
     drawText();
 }
 void LocalTouchButton::drawText() {
-    mFlags |= LOCAL_BUTTON_FLAG_IS_ACTIVE;
+    activate();
 
     auto tText = mText;
     if (mFlags & FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN) {
@@ -475,6 +495,24 @@ bool LocalTouchButton::isTouched(uint16_t aTouchPositionX, uint16_t aTouchPositi
  */
 LocalTouchButton* LocalTouchButton::find(unsigned int aTouchPositionX, unsigned int aTouchPositionY,
 bool aSearchOnlyAutorepeatButtons) {
+#if defined(USE_LOCAL_TOUCH_INDEX)
+    if (sButtonIndexIsDirty) {
+        rebuildIndex();
+    }
+    if (sButtonIndex.IsValid) {
+        // check only the active buttons overlapping the cell of the touch position, they are in list order
+        uint_fast16_t tNumberOfEntries;
+        const uint8_t *tEntries = LocalTouchIndex_getCell(&sButtonIndex, aTouchPositionX, aTouchPositionY, &tNumberOfEntries);
+        for (uint_fast16_t i = 0; i < tNumberOfEntries; ++i) {
+            LocalTouchButton *tButtonPointer = static_cast<LocalTouchButton*>(sButtonIndex.Objects[tEntries[i]]);
+            if ((!aSearchOnlyAutorepeatButtons || (tButtonPointer->mFlags & FLAG_BUTTON_TYPE_AUTOREPEAT))
+                    && tButtonPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
+                return tButtonPointer;
+            }
+        }
+        return NULL;
+    }
+#endif
     LocalTouchButton *tButtonPointer = sButtonListStart;
 // walk through list
     while (tButtonPointer != NULL) {
@@ -490,6 +528,39 @@ bool aSearchOnlyAutorepeatButtons) {
     return NULL;
 }
 
+#if defined(USE_LOCAL_TOUCH_INDEX)
+/**
+ * Puts all active buttons into the grid index.
+ * If the index capacity is exceeded, find() walks through the list of buttons.
+ */
+void LocalTouchButton::rebuildIndex() {
+    sButtonIndexIsDirty = false;
+    LocalTouchIndex_beginBuild(&sButtonIndex);
+    LocalTouchButton *tButtonPointer = sButtonListStart;
+    while (tButtonPointer != NULL) {
+        if (tButtonPointer->mFlags & LOCAL_BUTTON_FLAG_IS_ACTIVE) {
+            // same area as isTouched()
+            LocalTouchIndex_count(&sButtonIndex, tButtonPointer->mPositionX, tButtonPointer->mPositionY,
+                    tButtonPointer->mPositionX + tButtonPointer->mWidthX, tButtonPointer->mPositionY + tButtonPointer->mHeightY);
+        }
+        tButtonPointer = tButtonPointer->mNextObject;
+    }
+    if (!LocalTouchIndex_beginFill(&sButtonIndex)) {
+        return;
+    }
+    tButtonPointer = sButtonListStart;
+    while (tButtonPointer != NULL) {
+        if (tButtonPointer->mFlags & LOCAL_BUTTON_FLAG_IS_ACTIVE) {
+            LocalTouchIndex_add(&sButtonIndex, tButtonPointer->mPositionX, tButtonPointer->mPositionY,
+                    tButtonPointer->mPositionX + tButtonPointer->mWidthX, tButtonPointer->mPositionY + tButtonPointer->mHeightY,
+                    tButtonPointer);
+        }
+        tButtonPointer = tButtonPointer->mNextObject;
+    }
+    LocalTouchIndex_endBuild(&sButtonIndex);
+}
+#endif
+
 /**
  * @return NULL if no button found at this position
  */
@@ -697,6 +768,9 @@ uint16_t LocalTouchButton::getPositionYBottom() const {
  * activate for touch checking
  */
 void LocalTouchButton::activate() {
+    if (!(mFlags & LOCAL_BUTTON_FLAG_IS_ACTIVE)) {
+        invalidateButtonIndex();
+    }
     mFlags |= LOCAL_BUTTON_FLAG_IS_ACTIVE;
 }
 
@@ -704,6 +778,9 @@ void LocalTouchButton::activate() {
  * deactivate for touch checking
  */
 void LocalTouchButton::deactivate() {
+    if (mFlags & LOCAL_BUTTON_FLAG_IS_ACTIVE) {
+        invalidateButtonIndex();
+    }
     mFlags &= ~LOCAL_BUTTON_FLAG_IS_ACTIVE;
 }
 
@@ -0,0 +1,93 @@
+/*
+ * @file LocalTouchIndex.h
+ *
+ * Grid index for hit testing of local touch buttons and sliders.
+ * The display is divided into cells of 2^LOCAL_TOUCH_INDEX_CELL_SHIFT pixel. Each cell holds the list of objects,
+ * whose touch area overlaps the cell, so a hit test only checks the objects of one cell instead of walking the whole list.
+ *
+ * The index is built in 3 steps:
+ * 1. LocalTouchIndex_beginBuild() and LocalTouchIndex_count() for each object.
+ * 2. LocalTouchIndex_beginFill() and LocalTouchIndex_add() for each object in the same order as for counting.
+ * 3. LocalTouchIndex_endBuild().
+ * The entries of a cell keep the order in which they were added, so the first match of a cell
+ * is the same as the first match of a walk through the list.
+ * If there are more entries than the capacity, the index is invalid and the caller has to walk its list.
+ *
+ * Layout is compressed sparse rows: CellStart[i] is the index of the first entry of cell i in Entries,
+ * CellStart[i + 1] the index after the last one.
+ * An entry is the 8 bit number of the object, Objects[number] is the pointer to the object.
+ * Objects are numbered in the order they are added.
+ *
+ * RAM on 32 bit ARM with 320 x 240 display and 32 pixel cells: 162 bytes + 1 byte per entry + 4 bytes per object.
+ * With the default capacities: 1602 bytes for buttons and 482 bytes for sliders.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _LOCAL_TOUCH_INDEX_H
+#define _LOCAL_TOUCH_INDEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * AVR has not enough RAM, it keeps the walk through the list
+ */
+#if !defined(__AVR__) && !defined(DISABLE_LOCAL_TOUCH_INDEX)
+#define USE_LOCAL_TOUCH_INDEX
+#endif
+
+#if !defined(LOCAL_TOUCH_INDEX_CELL_SHIFT)
+#define LOCAL_TOUCH_INDEX_CELL_SHIFT        5 // 32 pixel, 10 x 8 cells for 320 x 240
+#endif
+#define LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_X (((LOCAL_DISPLAY_WIDTH - 1) >> LOCAL_TOUCH_INDEX_CELL_SHIFT) + 1)
+#define LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_Y (((LOCAL_DISPLAY_HEIGHT - 1) >> LOCAL_TOUCH_INDEX_CELL_SHIFT) + 1)
+#define LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS   (LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_X * LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_Y)
+
+/*
+ * Capacities in objects and entries. A 64 x 48 button at an arbitrary position occupies 4 to 9 entries,
+ * 200 buttons of 18 x 20 pixel tiling the display occupy 440 entries, 21 sliders of up to 100 pixel 162 entries.
+ * If a capacity is exceeded, find() walks the list as before.
+ */
+#if !defined(LOCAL_TOUCH_INDEX_BUTTON_OBJECTS)
+#define LOCAL_TOUCH_INDEX_BUTTON_OBJECTS    200
+#endif
+#if !defined(LOCAL_TOUCH_INDEX_BUTTON_ENTRIES)
+#define LOCAL_TOUCH_INDEX_BUTTON_ENTRIES    640
+#endif
+#if !defined(LOCAL_TOUCH_INDEX_SLIDER_OBJECTS)
+#define LOCAL_TOUCH_INDEX_SLIDER_OBJECTS    32
+#endif
+#if !defined(LOCAL_TOUCH_INDEX_SLIDER_ENTRIES)
+#define LOCAL_TOUCH_INDEX_SLIDER_ENTRIES    192
+#endif
+#if LOCAL_TOUCH_INDEX_BUTTON_OBJECTS > 256 || LOCAL_TOUCH_INDEX_SLIDER_OBJECTS > 256
+#error Object numbers of the local touch index are 8 bit, so at most 256 objects can be indexed
+#endif
+
+typedef struct {
+    uint16_t CellStart[LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS + 1];
+    uint8_t *Entries; // object numbers
+    void **Objects; // object pointers by object number
+    uint16_t EntriesCapacity;
+    uint16_t ObjectsCapacity;
+    uint16_t NumberOfObjects; // counted, then added objects
+    bool IsValid; // false if a capacity was exceeded at last build
+} LocalTouchIndexStruct;
+
+void LocalTouchIndex_beginBuild(LocalTouchIndexStruct *aIndex);
+void LocalTouchIndex_count(LocalTouchIndexStruct *aIndex, unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd,
+        unsigned int aYEnd);
+bool LocalTouchIndex_beginFill(LocalTouchIndexStruct *aIndex);
+void LocalTouchIndex_add(LocalTouchIndexStruct *aIndex, unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd,
+        unsigned int aYEnd, void *aObject);
+void LocalTouchIndex_endBuild(LocalTouchIndexStruct *aIndex);
+
+const uint8_t* LocalTouchIndex_getCell(const LocalTouchIndexStruct *aIndex, unsigned int aPositionX, unsigned int aPositionY,
+        uint_fast16_t *aNumberOfEntries);
+
+#endif // _LOCAL_TOUCH_INDEX_H
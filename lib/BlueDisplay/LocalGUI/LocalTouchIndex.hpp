@@ -0,0 +1,131 @@
+/*
+ * @file LocalTouchIndex.hpp
+ *
+ * Implementation of the grid index for hit testing, see LocalTouchIndex.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _LOCAL_TOUCH_INDEX_HPP
+#define _LOCAL_TOUCH_INDEX_HPP
+
+#include "LocalGUI/LocalTouchIndex.h"
+
+#if defined(USE_LOCAL_TOUCH_INDEX)
+/*
+ * Clips the inclusive rectangle to the display and converts it to cells
+ */
+static void getLocalTouchIndexCellRange(unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd, unsigned int aYEnd,
+        uint_fast8_t *aCellXStart, uint_fast8_t *aCellYStart, uint_fast8_t *aCellXEnd, uint_fast8_t *aCellYEnd) {
+    if (aXEnd >= LOCAL_DISPLAY_WIDTH) {
+        aXEnd = LOCAL_DISPLAY_WIDTH - 1;
+    }
+    if (aYEnd >= LOCAL_DISPLAY_HEIGHT) {
+        aYEnd = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+    *aCellXStart = aXStart >> LOCAL_TOUCH_INDEX_CELL_SHIFT;
+    *aCellYStart = aYStart >> LOCAL_TOUCH_INDEX_CELL_SHIFT;
+    *aCellXEnd = aXEnd >> LOCAL_TOUCH_INDEX_CELL_SHIFT;
+    *aCellYEnd = aYEnd >> LOCAL_TOUCH_INDEX_CELL_SHIFT;
+}
+
+void LocalTouchIndex_beginBuild(LocalTouchIndexStruct *aIndex) {
+    for (uint_fast16_t i = 0; i <= LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS; ++i) {
+        aIndex->CellStart[i] = 0;
+    }
+    aIndex->NumberOfObjects = 0;
+    aIndex->IsValid = false;
+}
+
+/**
+ * Counts the entries of the object with the touch area from aXStart,aYStart to aXEnd,aYEnd inclusive.
+ * Counts of cell i are accumulated in CellStart[i + 1].
+ */
+void LocalTouchIndex_count(LocalTouchIndexStruct *aIndex, unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd,
+        unsigned int aYEnd) {
+    if (aXStart > aXEnd || aYStart > aYEnd || aXStart >= LOCAL_DISPLAY_WIDTH || aYStart >= LOCAL_DISPLAY_HEIGHT) {
+        return;
+    }
+    uint_fast8_t tCellXStart, tCellYStart, tCellXEnd, tCellYEnd;
+    getLocalTouchIndexCellRange(aXStart, aYStart, aXEnd, aYEnd, &tCellXStart, &tCellYStart, &tCellXEnd, &tCellYEnd);
+    aIndex->NumberOfObjects++;
+    for (uint_fast8_t tCellY = tCellYStart; tCellY <= tCellYEnd; ++tCellY) {
+        uint16_t *tCountPointer = &aIndex->CellStart[(tCellY * LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_X) + tCellXStart + 1];
+        for (uint_fast8_t tCellX = tCellXStart; tCellX <= tCellXEnd; ++tCellX) {
+            (*tCountPointer++)++;
+        }
+    }
+}
+
+/**
+ * Converts the counts to start indexes
+ * @return false if a capacity is exceeded, then LocalTouchIndex_add() and LocalTouchIndex_endBuild() must not be called
+ */
+bool LocalTouchIndex_beginFill(LocalTouchIndexStruct *aIndex) {
+    uint_fast16_t tSum = 0;
+    for (uint_fast16_t i = 1; i <= LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS; ++i) {
+        tSum += aIndex->CellStart[i];
+        aIndex->CellStart[i] = tSum;
+    }
+    bool tFits = (tSum <= aIndex->EntriesCapacity && aIndex->NumberOfObjects <= aIndex->ObjectsCapacity);
+    aIndex->NumberOfObjects = 0;
+    return tFits;
+}
+
+/**
+ * Must be called with the same rectangles and in the same order as LocalTouchIndex_count().
+ * CellStart[i] is used as write position for cell i and ends up at the start of cell i + 1.
+ */
+void LocalTouchIndex_add(LocalTouchIndexStruct *aIndex, unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd,
+        unsigned int aYEnd, void *aObject) {
+    if (aXStart > aXEnd || aYStart > aYEnd || aXStart >= LOCAL_DISPLAY_WIDTH || aYStart >= LOCAL_DISPLAY_HEIGHT) {
+        return;
+    }
+    uint_fast8_t tCellXStart, tCellYStart, tCellXEnd, tCellYEnd;
+    getLocalTouchIndexCellRange(aXStart, aYStart, aXEnd, aYEnd, &tCellXStart, &tCellYStart, &tCellXEnd, &tCellYEnd);
+    uint8_t tObjectNumber = aIndex->NumberOfObjects++;
+    aIndex->Objects[tObjectNumber] = aObject;
+    for (uint_fast8_t tCellY = tCellYStart; tCellY <= tCellYEnd; ++tCellY) {
+        uint16_t *tWritePositionPointer = &aIndex->CellStart[(tCellY * LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_X) + tCellXStart];
+        for (uint_fast8_t tCellX = tCellXStart; tCellX <= tCellXEnd; ++tCellX) {
+            aIndex->Entries[(*tWritePositionPointer)++] = tObjectNumber;
+            tWritePositionPointer++;
+        }
+    }
+}
+
+/**
+ * Shifts the write positions back to the start indexes
+ */
+void LocalTouchIndex_endBuild(LocalTouchIndexStruct *aIndex) {
+    for (uint_fast16_t i = LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS; i > 0; --i) {
+        aIndex->CellStart[i] = aIndex->CellStart[i - 1];
+    }
+    aIndex->CellStart[0] = 0;
+    aIndex->IsValid = true;
+}
+
+/**
+ * Positions outside the display are taken from the border cells, which contain all objects reaching over the border.
+ * @return the object numbers of the cell containing the position in the order they were added, Objects[number] is the object
+ */
+const uint8_t* LocalTouchIndex_getCell(const LocalTouchIndexStruct *aIndex, unsigned int aPositionX, unsigned int aPositionY,
+        uint_fast16_t *aNumberOfEntries) {
+    if (aPositionX >= LOCAL_DISPLAY_WIDTH) {
+        aPositionX = LOCAL_DISPLAY_WIDTH - 1;
+    }
+    if (aPositionY >= LOCAL_DISPLAY_HEIGHT) {
+        aPositionY = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+    uint_fast16_t tCell = ((aPositionY >> LOCAL_TOUCH_INDEX_CELL_SHIFT) * LOCAL_TOUCH_INDEX_NUMBER_OF_CELLS_X)
+            + (aPositionX >> LOCAL_TOUCH_INDEX_CELL_SHIFT);
+    uint_fast16_t tStart = aIndex->CellStart[tCell];
+    *aNumberOfEntries = aIndex->CellStart[tCell + 1] - tStart;
+    return &aIndex->Entries[tStart];
+}
+#endif // defined(USE_LOCAL_TOUCH_INDEX)
+#endif // _LOCAL_TOUCH_INDEX_HPP
@@ -57,6 +57,7 @@ typedef uint16_t BDSliderHandle_t;
 //static const int FLAG_SLIDER_IS_HORIZONTAL = 0x04;
 //static const int FLAG_SLIDER_IS_INVERSE = 0x08;         // is equivalent to negative slider length at init
 //static const int FLAG_SLIDER_VALUE_BY_CALLBACK = 0x10;  // If set, bar (+ ASCII) value will be set by callback handler, not by touch
+                                                          // Local sliders call the handler at most every SLIDER_REDRAW_PERIOD_MILLIS with the last touch value
 //static const int FLAG_SLIDER_IS_ONLY_OUTPUT = 0x20;     // is equivalent to slider aOnChangeHandler NULL at init
 //#define LOCAL_SLIDER_FLAG_USE_BDSLIDER_FOR_CALLBACK 0x80 // Use pointer to index in slider list instead of pointer to this in callback
 /** @} */
@@ -72,6 +73,14 @@ typedef uint16_t BDSliderHandle_t;
 #define SLIDER_DEFAULT_THRESHOLD_VALUE      100
 
 #define SLIDER_MAX_DISPLAY_VALUE            LOCAL_DISPLAY_WIDTH //! maximum value which can be displayed
+
+#if !defined(SLIDER_REDRAW_PERIOD_MILLIS)
+#define SLIDER_REDRAW_PERIOD_MILLIS         20 // Redraws and callbacks of FLAG_SLIDER_VALUE_BY_CALLBACK sliders by touch moves are coalesced to this period
+#endif
+//#define DISABLE_SLIDER_CALLBACK_COALESCING // Call the handler of FLAG_SLIDER_VALUE_BY_CALLBACK sliders at each touch move, which changes the value
+#define SLIDER_VALUE_STRING_CACHE_SIZE      8 // Value strings up to 7 characters are only redrawn if changed
+#define SLIDER_BAR_NOT_DRAWN                0xFFFF // for mDrawnBarValue, next bar drawing is a complete one
+#define SLIDER_SET_VALUE_MESSAGE_SIZE       ((3 * 2) + 4) // bytes sent to the remote slider by BDSlider::setValueAndDrawBar()
 /**
  * @name SliderErrorCodes
  * @{
@@ -79,6 +88,19 @@ typedef uint16_t BDSliderHandle_t;
 #define SLIDER_ERROR     -1
 /** @} */
 
+/*
+ * Counters for the drawing of bar and value. Reset at each touch down, so they show the effort of the last drag.
+ */
+struct LocalTouchSliderDrawStatisticsStruct {
+    uint32_t PixelsDrawn;
+    uint32_t PixelsOfCompleteRedraws; // pixel, which would have been drawn with complete redraw of bar and value
+    uint32_t BytesSent; // to the remote slider
+    uint32_t BytesSkipped; // for unchanged value strings not sent to the remote slider
+    uint16_t Redraws;
+    uint16_t RedrawsCoalesced;
+    uint16_t ValueStringsSkipped;
+};
+
 // Typedef in order to save program space on AVR, but allow bigger values on other platforms
 #ifdef AVR
 typedef uint8_t uintForPgmSpaceSaving;
@@ -134,6 +156,8 @@ public:
     static LocalTouchSlider* find(unsigned int aTouchPositionX, unsigned int aTouchPositionY);
     static LocalTouchSlider* findAndAction(unsigned int aTouchPositionX, unsigned int aTouchPositionY);
     static bool checkAllSliders(unsigned int aTouchPositionX, unsigned int aTouchPositionY);
+    static void rebuildIndex(); // Only if USE_LOCAL_TOUCH_INDEX. Is called by find() after a slider was added, removed, moved, activated or deactivated
+    void addToIndex(bool aDoAdd);
 
     // Position
     void setPosition(int16_t aPositionX, int16_t aPositionY);
@@ -143,7 +167,8 @@ public:
     // Draw
     void drawSlider();
     void drawBorder();
-    void drawBar(); // Used internally
+    void drawBar(); // Used internally, draws the complete bar
+    void drawBarDelta(); // Used internally, draws only the part of the bar which changed since last drawing
 
     // Color
     void setSliderColor(uint16_t sliderColor);
@@ -176,6 +201,14 @@ public:
             color16_t aPrintValueColor, color16_t aPrintValueBackgroundColor); // Uses setValueStringColors() and sets only aPrintValueColor and aPrintValueBackgroundColor
     int16_t getValue() const;
     int printValue(); // Used internally
+    bool isValueStringDrawn(const char *aValueString) const;
+
+    // Drawing of touch moves
+    void scheduleRedraw(); // Used internally
+    void callOnChangeHandler(); // Used internally
+    static void drawPendingValue(bool aDoForce); // Is called after each touch event
+    static void resetDrawStatistics();
+    static LocalTouchSliderDrawStatisticsStruct* getDrawStatistics();
 
     // Deprecated
     void setBarThresholdDefaultColor(color16_t aBarThresholdDefaultColor)
@@ -236,10 +269,22 @@ public:
 
     bool mIsActive;
 
+    /*
+     * What is currently on the display, to draw only the changes
+     */
+    uint16_t mDrawnBarValue; // SLIDER_BAR_NOT_DRAWN if unknown
+    char mDrawnValueString[SLIDER_VALUE_STRING_CACHE_SIZE]; // empty if unknown
+
+    static LocalTouchSlider *sSliderWithPendingRedraw;
+    static uint32_t sMillisOfLastRedraw;
+    static LocalTouchSliderDrawStatisticsStruct sDrawStatistics;
+
     // misc
     void (*mOnChangeHandler)(LocalTouchSlider*, uint16_t);
 
     int8_t checkParameterValues();
+    void invalidateDrawnValues();
+    uint16_t drawValueString(uint16_t aPositionX, uint16_t aPositionY, const char *aValueString);
 
 };
 /** @} */
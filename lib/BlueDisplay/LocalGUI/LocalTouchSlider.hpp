@@ -36,6 +36,7 @@
 
 #include "LocalGUI/LocalTouchSlider.h"
 #include "BDSlider.h"
+#include "LocalGUI/LocalTouchIndex.hpp"
 
 #if defined(__AVR__)
 #define failParamMessage(wrongParam,message) void()
@@ -59,11 +60,31 @@ uint16_t LocalTouchSlider::sDefaultValueCaptionBackgroundColor = SLIDER_DEFAULT_
 
 uint8_t LocalTouchSlider::sDefaultTouchBorder = SLIDER_DEFAULT_TOUCH_BORDER;
 
+LocalTouchSlider *LocalTouchSlider::sSliderWithPendingRedraw = NULL; // Slider moved by touch, which is not yet redrawn
+uint32_t LocalTouchSlider::sMillisOfLastRedraw;
+LocalTouchSliderDrawStatisticsStruct LocalTouchSlider::sDrawStatistics;
+
+#if defined(USE_LOCAL_TOUCH_INDEX)
+/*
+ * Grid index of all active sliders. It is rebuilt by the next find(),
+ * after a slider was added, removed, initialized, moved, activated or deactivated.
+ */
+static uint8_t sSliderIndexEntries[LOCAL_TOUCH_INDEX_SLIDER_ENTRIES];
+static void *sSliderIndexObjects[LOCAL_TOUCH_INDEX_SLIDER_OBJECTS];
+static LocalTouchIndexStruct sSliderIndex = { { 0 }, sSliderIndexEntries, sSliderIndexObjects, LOCAL_TOUCH_INDEX_SLIDER_ENTRIES,
+        LOCAL_TOUCH_INDEX_SLIDER_OBJECTS, 0, false };
+static bool sSliderIndexIsDirty = true;
+#define invalidateSliderIndex() sSliderIndexIsDirty = true
+#else
+#define invalidateSliderIndex() void()
+#endif
+
 /*
  * Constructor - insert in list
  */
 LocalTouchSlider::LocalTouchSlider() { // @suppress("Class members should be properly initialized")
     mNextObject = NULL;
+    invalidateSliderIndex();
     if (sSliderListStart == NULL) {
         // first slider
         sSliderListStart = this;
@@ -88,7 +109,7 @@ LocalTouchSlider::~LocalTouchSlider() {
     LocalTouchSlider *tSliderPointer = sSliderListStart;
     if (tSliderPointer == this) {
         // remove first element of list
-        sSliderListStart = NULL;
+        sSliderListStart = mNextObject;
     } else {
         // walk through list to find "this"
         while (tSliderPointer != NULL) {
@@ -99,6 +120,10 @@ LocalTouchSlider::~LocalTouchSlider() {
             tSliderPointer = tSliderPointer->mNextObject;
         }
     }
+    invalidateSliderIndex();
+    if (sSliderWithPendingRedraw == this) {
+        sSliderWithPendingRedraw = NULL;
+    }
 }
 #endif
 
@@ -109,6 +134,7 @@ LocalTouchSlider::~LocalTouchSlider() {
 LocalTouchSlider::LocalTouchSlider(BDSlider *aBDSliderPtr) { // @suppress("Class members should be properly initialized")
     mBDSliderPtr = aBDSliderPtr;
     mNextObject = NULL;
+    invalidateSliderIndex();
     if (sSliderListStart == NULL) {
         // first slider
         sSliderListStart = this;
@@ -202,6 +228,8 @@ void LocalTouchSlider::init(uint16_t aPositionX, uint16_t aPositionY, uint8_t aB
     mIsActive = false;
     mCaption = NULL;
     mXOffsetValue = 0;
+    invalidateSliderIndex(); // for the new touch area
+    invalidateDrawnValues();
 
     /*
      * Set defaults
@@ -303,10 +331,12 @@ void LocalTouchSlider::setDefaultBarThresholdColor(uint16_t aDefaultBarThreshold
 
 void LocalTouchSlider::setValueAndCaptionBackgroundColor(uint16_t aValueCaptionBackgroundColor) {
     mValueCaptionBackgroundColor = aValueCaptionBackgroundColor;
+    invalidateDrawnValues();
 }
 
 void LocalTouchSlider::setValueColor(uint16_t aValueColor) {
     mValueColor = aValueColor;
+    invalidateDrawnValues();
 }
 
 /**
@@ -335,7 +365,8 @@ void LocalTouchSlider::deactivateAll() {
 }
 
 void LocalTouchSlider::drawSlider() {
-    mIsActive = true;
+    activate();
+    invalidateDrawnValues();
 
     if ((mFlags & FLAG_SLIDER_SHOW_BORDER)) {
         drawBorder();
@@ -383,6 +414,9 @@ void LocalTouchSlider::drawBar() {
     if (tValue > mBarLength) {
         tValue = mBarLength;
     }
+    mDrawnBarValue = tValue;
+    sDrawStatistics.PixelsDrawn += (uint32_t) mBarLength * mBarWidth;
+    sDrawStatistics.PixelsOfCompleteRedraws += (uint32_t) mBarLength * mBarWidth;
 
     uintForPgmSpaceSaving mShortBorderWidth = 0;
     uintForPgmSpaceSaving tLongBorderWidth = 0;
@@ -419,13 +453,79 @@ void LocalTouchSlider::drawBar() {
     }
 }
 
+/*
+ * Draws only the part between the drawn and the actual value, i.e. fills it with bar or with background color.
+ * Draws the complete bar if the drawn value is unknown or the bar color changes because the threshold is crossed.
+ */
+void LocalTouchSlider::drawBarDelta() {
+    uint16_t tValue = mValue;
+    if (tValue > mBarLength) {
+        tValue = mBarLength;
+    }
+    uint16_t tDrawnValue = mDrawnBarValue;
+    if (tDrawnValue == SLIDER_BAR_NOT_DRAWN || ((tValue > mThresholdValue) != (tDrawnValue > mThresholdValue))) {
+        drawBar();
+        return;
+    }
+    sDrawStatistics.PixelsOfCompleteRedraws += (uint32_t) mBarLength * mBarWidth;
+    if (tValue == tDrawnValue) {
+        return;
+    }
+    mDrawnBarValue = tValue;
+
+    uintForPgmSpaceSaving mShortBorderWidth = 0;
+    uintForPgmSpaceSaving tLongBorderWidth = 0;
+    if ((mFlags & FLAG_SLIDER_SHOW_BORDER)) {
+        mShortBorderWidth = mBarWidth / 2;
+        tLongBorderWidth = mBarWidth;
+    }
+
+    uint16_t tStartValue; // the lower value
+    uint16_t tLength;
+    uint16_t tColor;
+    if (tValue > tDrawnValue) {
+        // bar grows
+        tStartValue = tDrawnValue;
+        tLength = tValue - tDrawnValue;
+        tColor = mBarColor;
+        if (tValue > mThresholdValue) {
+            tColor = mBarThresholdColor;
+        }
+    } else {
+        // bar shrinks
+        tStartValue = tValue;
+        tLength = tDrawnValue - tValue;
+        tColor = mBarBackgroundColor;
+    }
+    sDrawStatistics.PixelsDrawn += (uint32_t) tLength * mBarWidth;
+
+    if (mFlags & FLAG_SLIDER_IS_HORIZONTAL) {
+        LocalDisplay.fillRectRel(mPositionX + mShortBorderWidth + tStartValue, mPositionY + tLongBorderWidth, tLength, mBarWidth,
+                tColor);
+    } else {
+        // value 0 is at the bottom
+        LocalDisplay.fillRectRel(mPositionX + tLongBorderWidth, mPositionYBottom - mShortBorderWidth - tStartValue - tLength + 1,
+                mBarWidth, tLength, tColor);
+    }
+}
+
+/*
+ * Forces the next drawBarDelta() and printValue() to draw completely
+ */
+void LocalTouchSlider::invalidateDrawnValues() {
+    mDrawnBarValue = SLIDER_BAR_NOT_DRAWN;
+    mDrawnValueString[0] = '\0';
+}
+
 void LocalTouchSlider::setCaption(const char *aCaption) {
     mCaption = aCaption;
+    invalidateDrawnValues(); // value position depends on caption
 }
 
 void LocalTouchSlider::setCaptionColors(uint16_t aCaptionColor, uint16_t aValueCaptionBackgroundColor) {
     mCaptionColor = aCaptionColor;
     mValueCaptionBackgroundColor = aValueCaptionBackgroundColor;
+    invalidateDrawnValues();
 }
 
 /**
@@ -440,6 +540,7 @@ void LocalTouchSlider::setCaptionProperties(uint8_t aCaptionSize __attribute__((
 void LocalTouchSlider::setValueStringColors(uint16_t aValueStringColor, uint16_t aValueStringCaptionBackgroundColor) {
     mValueColor = aValueStringColor;
     mValueCaptionBackgroundColor = aValueStringCaptionBackgroundColor;
+    invalidateDrawnValues();
 }
 
 /**
@@ -521,8 +622,7 @@ int LocalTouchSlider::printValue() {
     // Convert to string
     char tValueAsString[4];
     sprintf(tValueAsString, "%03d", mValue);
-    return LocalDisplay.drawText(mPositionX + mXOffsetValue, tValuePositionY - TEXT_SIZE_11_ASCEND, tValueAsString, 1, mValueColor,
-            mValueCaptionBackgroundColor);
+    return drawValueString(mPositionX + mXOffsetValue, tValuePositionY - TEXT_SIZE_11_ASCEND, tValueAsString);
 }
 
 /**
@@ -540,8 +640,35 @@ int LocalTouchSlider::printValue(const char *aValueString) {
         // fallback
         tValuePositionY = LOCAL_DISPLAY_HEIGHT - TEXT_SIZE_11_DECEND;
     }
-    return LocalDisplay.drawText(mPositionX + mXOffsetValue, tValuePositionY - TEXT_SIZE_11_ASCEND, aValueString, 1, mValueColor,
-            mValueCaptionBackgroundColor);
+    return drawValueString(mPositionX + mXOffsetValue, tValuePositionY - TEXT_SIZE_11_ASCEND, aValueString);
+}
+
+/**
+ * Draws the string only if it differs from the drawn one
+ * @return aPositionX for next character
+ */
+uint16_t LocalTouchSlider::drawValueString(uint16_t aPositionX, uint16_t aPositionY, const char *aValueString) {
+    size_t tLength = strlen(aValueString);
+    uint32_t tPixels = (uint32_t) tLength * (TEXT_SIZE_11_WIDTH * TEXT_SIZE_11_HEIGHT);
+    sDrawStatistics.PixelsOfCompleteRedraws += tPixels;
+    if (isValueStringDrawn(aValueString)) {
+        sDrawStatistics.ValueStringsSkipped++;
+        return aPositionX + (tLength * TEXT_SIZE_11_WIDTH);
+    }
+    if (tLength < SLIDER_VALUE_STRING_CACHE_SIZE) {
+        strcpy(mDrawnValueString, aValueString);
+    } else {
+        mDrawnValueString[0] = '\0';
+    }
+    sDrawStatistics.PixelsDrawn += tPixels;
+    return LocalDisplay.drawText(aPositionX, aPositionY, aValueString, 1, mValueColor, mValueCaptionBackgroundColor);
+}
+
+/**
+ * @return true if aValueString is already displayed as value
+ */
+bool LocalTouchSlider::isValueStringDrawn(const char *aValueString) const {
+    return (mDrawnValueString[0] != '\0' && strcmp(mDrawnValueString, aValueString) == 0);
 }
 
 /**
@@ -568,6 +695,9 @@ bool LocalTouchSlider::isTouched(uint16_t aTouchPositionX, uint16_t aTouchPositi
  *   - Call callback handler
  *   - Draw bar
  *   - Print value
+ * With FLAG_SLIDER_VALUE_BY_CALLBACK, the callback handler draws the value, so it is called by the coalesced redraw,
+ * i.e. at most every SLIDER_REDRAW_PERIOD_MILLIS and only with the last touch value.
+ * Define DISABLE_SLIDER_CALLBACK_COALESCING for handlers which must get every value immediately.
  */
 void LocalTouchSlider::performTouchAction(uint16_t aTouchPositionX, uint16_t aTouchPositionY) {
     /*
@@ -606,57 +736,107 @@ void LocalTouchSlider::performTouchAction(uint16_t aTouchPositionX, uint16_t aTo
          */
         mActualTouchValue = tActualTouchValue;
         if (mOnChangeHandler != NULL) {
-            // call change handler
-#if !defined(DISABLE_REMOTE_DISPLAY)
-            mOnChangeHandler((LocalTouchSlider*) this->mBDSliderPtr, tActualTouchValue);
-            if (!(mFlags & FLAG_SLIDER_VALUE_BY_CALLBACK)) {
-                // Synchronize remote slider
-                this->mBDSliderPtr->setValueAndDrawBar(tActualTouchValue);
-            }
+            if (mFlags & FLAG_SLIDER_VALUE_BY_CALLBACK) {
+#if defined(DISABLE_SLIDER_CALLBACK_COALESCING)
+                callOnChangeHandler();
 #else
-            mOnChangeHandler(this, tActualTouchValue);
+                // callback handler is called with the last touch value at next redraw period
+                scheduleRedraw();
 #endif
+                return;
+            }
+            callOnChangeHandler();
 
-            if (!(mFlags & FLAG_SLIDER_VALUE_BY_CALLBACK)) {
-                if (mValue == tActualTouchValue) {
-                    // value returned is equal displayed value - do nothing
-                    return;
-                }
-                // display value changed - check, store and redraw
-                if (tActualTouchValue > mBarLength) {
-                    tActualTouchValue = mBarLength;
-                }
-                mValue = tActualTouchValue;
-                drawBar();
-                printValue();
+            if (mValue == tActualTouchValue) {
+                // value returned is equal displayed value - do nothing
+                return;
+            }
+            // display value changed - check, store and redraw and synchronize remote slider at next redraw period
+            if (tActualTouchValue > mBarLength) {
+                tActualTouchValue = mBarLength;
             }
+            mValue = tActualTouchValue;
+            scheduleRedraw();
         }
     }
 }
 
+#if defined(USE_LOCAL_TOUCH_INDEX)
 /**
- * Static convenience method - checks all sliders in for event position.
+ * Puts all active sliders into the grid index.
+ * If the index capacity is exceeded, find() walks through the list of sliders.
  */
-LocalTouchSlider* LocalTouchSlider::find(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+void LocalTouchSlider::rebuildIndex() {
+    sSliderIndexIsDirty = false;
+    LocalTouchIndex_beginBuild(&sSliderIndex);
     LocalTouchSlider *tSliderPointer = sSliderListStart;
-
-// walk through list of active elements
     while (tSliderPointer != NULL) {
-        if (tSliderPointer->mIsActive && tSliderPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
-            return tSliderPointer;
+        if (tSliderPointer->mIsActive) {
+            tSliderPointer->addToIndex(false);
         }
         tSliderPointer = tSliderPointer->mNextObject;
     }
-    return NULL;
+    if (!LocalTouchIndex_beginFill(&sSliderIndex)) {
+        return;
+    }
+    tSliderPointer = sSliderListStart;
+    while (tSliderPointer != NULL) {
+        if (tSliderPointer->mIsActive) {
+            tSliderPointer->addToIndex(true);
+        }
+        tSliderPointer = tSliderPointer->mNextObject;
+    }
+    LocalTouchIndex_endBuild(&sSliderIndex);
 }
 
-LocalTouchSlider* LocalTouchSlider::findAndAction(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+/*
+ * Counts or adds the same area as isTouched()
+ */
+void LocalTouchSlider::addToIndex(bool aDoAdd) {
+    unsigned int tPositionBorderX = 0;
+    if (mTouchBorder <= mPositionX) {
+        tPositionBorderX = mPositionX - mTouchBorder;
+    }
+    unsigned int tPositionBorderY = 0;
+    if (mTouchBorder <= mPositionY) {
+        tPositionBorderY = mPositionY - mTouchBorder;
+    }
+    if (aDoAdd) {
+        LocalTouchIndex_add(&sSliderIndex, tPositionBorderX, tPositionBorderY, mPositionXRight + mTouchBorder,
+                mPositionYBottom + mTouchBorder, this);
+    } else {
+        LocalTouchIndex_count(&sSliderIndex, tPositionBorderX, tPositionBorderY, mPositionXRight + mTouchBorder,
+                mPositionYBottom + mTouchBorder);
+    }
+}
+#endif
+
+/**
+ * Static convenience method - checks all sliders in for event position.
+ */
+LocalTouchSlider* LocalTouchSlider::find(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+#if defined(USE_LOCAL_TOUCH_INDEX)
+    if (sSliderIndexIsDirty) {
+        rebuildIndex();
+    }
+    if (sSliderIndex.IsValid) {
+        // check only the active sliders overlapping the cell of the touch position, they are in list order
+        uint_fast16_t tNumberOfEntries;
+        const uint8_t *tEntries = LocalTouchIndex_getCell(&sSliderIndex, aTouchPositionX, aTouchPositionY, &tNumberOfEntries);
+        for (uint_fast16_t i = 0; i < tNumberOfEntries; ++i) {
+            LocalTouchSlider *tSliderPointer = static_cast<LocalTouchSlider*>(sSliderIndex.Objects[tEntries[i]]);
+            if (tSliderPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
+                return tSliderPointer;
+            }
+        }
+        return NULL;
+    }
+#endif
     LocalTouchSlider *tSliderPointer = sSliderListStart;
 
 // walk through list of active elements
     while (tSliderPointer != NULL) {
         if (tSliderPointer->mIsActive && tSliderPointer->isTouched(aTouchPositionX, aTouchPositionY)) {
-            tSliderPointer->performTouchAction(aTouchPositionX, aTouchPositionY);
             return tSliderPointer;
         }
         tSliderPointer = tSliderPointer->mNextObject;
@@ -664,6 +844,14 @@ LocalTouchSlider* LocalTouchSlider::findAndAction(unsigned int aTouchPositionX,
     return NULL;
 }
 
+LocalTouchSlider* LocalTouchSlider::findAndAction(unsigned int aTouchPositionX, unsigned int aTouchPositionY) {
+    LocalTouchSlider *tSliderPointer = find(aTouchPositionX, aTouchPositionY);
+    if (tSliderPointer != NULL) {
+        tSliderPointer->performTouchAction(aTouchPositionX, aTouchPositionY);
+    }
+    return tSliderPointer;
+}
+
 /**
  * Static convenience method - checks all sliders in for event position.
  */
@@ -687,17 +875,79 @@ void LocalTouchSlider::setValueAndDraw(int16_t aValue) {
     setValueAndDrawBar(aValue);
 }
 
+/*
+ * Draws only the changed part of the bar and only a changed value string
+ */
 void LocalTouchSlider::setValueAndDrawBar(int16_t aValue) {
     mValue = aValue;
-    drawBar();
+    drawBarDelta();
     printValue(); // this checks for flag TOUCHFLAG_SLIDER_SHOW_VALUE itself
 }
 
+void LocalTouchSlider::callOnChangeHandler() {
+#if !defined(DISABLE_REMOTE_DISPLAY)
+    mOnChangeHandler((LocalTouchSlider*) this->mBDSliderPtr, mActualTouchValue);
+#else
+    mOnChangeHandler(this, mActualTouchValue);
+#endif
+}
+
+/*
+ * Touch moves come every TOUCH_SAMPLER_PERIOD_MILLIS, the redraw is done at most every SLIDER_REDRAW_PERIOD_MILLIS.
+ * The value of a redraw skipped here is drawn by the next touch event or by drawPendingValue().
+ */
+void LocalTouchSlider::scheduleRedraw() {
+    if (sSliderWithPendingRedraw == this) {
+        sDrawStatistics.RedrawsCoalesced++;
+    } else if (sSliderWithPendingRedraw != NULL) {
+        drawPendingValue(true);
+    }
+    sSliderWithPendingRedraw = this;
+    drawPendingValue(false);
+}
+
+/**
+ * Draws the value of the last slider moved by touch, if not yet done
+ * @param aDoForce if false, draw only if SLIDER_REDRAW_PERIOD_MILLIS have passed since last redraw
+ */
+void LocalTouchSlider::drawPendingValue(bool aDoForce) {
+    LocalTouchSlider *tSliderPointer = sSliderWithPendingRedraw;
+    if (tSliderPointer == NULL || (!aDoForce && millis() - sMillisOfLastRedraw < SLIDER_REDRAW_PERIOD_MILLIS)) {
+        return;
+    }
+    sSliderWithPendingRedraw = NULL;
+    sMillisOfLastRedraw = millis();
+    sDrawStatistics.Redraws++;
+    if (tSliderPointer->mFlags & FLAG_SLIDER_VALUE_BY_CALLBACK) {
+        // the callback handler sets and draws the value, e.g. by setValueAndDrawBar()
+        tSliderPointer->callOnChangeHandler();
+        return;
+    }
+#if !defined(DISABLE_REMOTE_DISPLAY)
+    // Synchronize remote slider, this draws the local slider too
+    tSliderPointer->mBDSliderPtr->setValueAndDrawBar(tSliderPointer->mValue);
+    if (USART_isBluetoothPaired()) {
+        sDrawStatistics.BytesSent += SLIDER_SET_VALUE_MESSAGE_SIZE;
+    }
+#else
+    tSliderPointer->setValueAndDrawBar(tSliderPointer->mValue);
+#endif
+}
+
+void LocalTouchSlider::resetDrawStatistics() {
+    memset(&sDrawStatistics, 0, sizeof(sDrawStatistics));
+}
+
+LocalTouchSliderDrawStatisticsStruct* LocalTouchSlider::getDrawStatistics() {
+    return &sDrawStatistics;
+}
+
 /*
  * Set offset for printValue
  */
 void LocalTouchSlider::setXOffsetValue(int16_t aXOffsetValue) {
     mXOffsetValue = aXOffsetValue;
+    invalidateDrawnValues();
 }
 
 /**
@@ -707,6 +957,8 @@ void LocalTouchSlider::setXOffsetValue(int16_t aXOffsetValue) {
 void LocalTouchSlider::setPosition(int16_t aPositionX, int16_t aPositionY) {
     mPositionX = aPositionX;
     mPositionY = aPositionY;
+    invalidateSliderIndex();
+    invalidateDrawnValues();
 }
 
 uint16_t LocalTouchSlider::getPositionXRight() const {
@@ -718,10 +970,20 @@ uint16_t LocalTouchSlider::getPositionYBottom() const {
 }
 
 void LocalTouchSlider::activate() {
+    if (!mIsActive) {
+        invalidateSliderIndex();
+    }
     mIsActive = true;
 }
 void LocalTouchSlider::deactivate() {
+    if (mIsActive) {
+        invalidateSliderIndex();
+    }
     mIsActive = false;
+    if (sSliderWithPendingRedraw == this) {
+        // do not draw over the next page
+        sSliderWithPendingRedraw = NULL;
+    }
 }
 
 int8_t LocalTouchSlider::checkParameterValues() {
@@ -748,11 +1010,13 @@ int8_t LocalTouchSlider::checkParameterValues() {
 
 void LocalTouchSlider::setBarThresholdColor(uint16_t aBarThresholdColor) {
     mBarThresholdColor = aBarThresholdColor;
+    invalidateDrawnValues();
 }
 
 // Deprecated
 void LocalTouchSlider::setBarThresholdDefaultColor(uint16_t aBarThresholdDefaultColor) {
     mBarThresholdColor = aBarThresholdDefaultColor;
+    invalidateDrawnValues();
 }
 
 void LocalTouchSlider::setSliderColor(uint16_t sliderColor) {
@@ -761,10 +1025,12 @@ void LocalTouchSlider::setSliderColor(uint16_t sliderColor) {
 
 void LocalTouchSlider::setBarColor(uint16_t aBarColor) {
     mBarColor = aBarColor;
+    invalidateDrawnValues();
 }
 
 void LocalTouchSlider::setBarBackgroundColor(uint16_t aBarBackgroundColor) {
     mBarBackgroundColor = aBarBackgroundColor;
+    invalidateDrawnValues();
 }
 
 /** @} */
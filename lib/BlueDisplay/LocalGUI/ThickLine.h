@@ -12,6 +12,7 @@
 #define _THICKLINE_H
 
 #include <stdint.h>
+#include <stdbool.h>
 
 /*
  * Overlap means drawing additional pixel when changing minor direction
@@ -36,6 +37,13 @@ void drawThickLine(unsigned int aXStart, unsigned int aYStart, unsigned int aXEn
 void drawThickLineSimple(unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd, unsigned int aYEnd, unsigned int aThickness, uint8_t aThicknessMode,
         uint16_t aColor);
 
+/*
+ * Only for the local display
+ */
+struct XYPosition;
+void drawLineSpans(unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd, unsigned int aYEnd, bool aSkipStartPixel, uint16_t aColor);
+void drawPolylineSpans(const struct XYPosition *aPoints, unsigned int aNumberOfPoints, uint16_t aColor);
+
 #ifdef __cplusplus
 }
 #endif
@@ -429,6 +429,130 @@ void drawThickLineSimple(unsigned int aXStart, unsigned int aYStart, unsigned in
     }
 }
 
+#if defined(SUPPORT_LOCAL_DISPLAY)
+/*
+ * Draws aLength pixel starting at aStart in direction aStep
+ */
+static void drawRun(unsigned int aStart, unsigned int aOtherPosition, uint16_t aLength, int16_t aStep, bool aIsVertical,
+        uint16_t aColor) {
+    if (aLength == 0) {
+        return;
+    }
+    if (aStep < 0) {
+        aStart -= aLength - 1;
+    }
+    if (aIsVertical) {
+        LocalDisplay.drawSpan(aOtherPosition, aStart, aLength, true, aColor);
+    } else {
+        LocalDisplay.drawSpan(aStart, aOtherPosition, aLength, false, aColor);
+    }
+}
+
+/**
+ * Bresenham for the local display, which draws all pixel of the line with the same minor coordinate as one span,
+ * i.e. one cursor setting followed by a burst of pixel writes, instead of one cursor setting per pixel.
+ * Draws the same pixel as drawLineOverlap(..., LINE_OVERLAP_NONE, aColor).
+ * @param aSkipStartPixel if true, the start pixel is not drawn, because it is the end pixel of the preceding line of a polyline
+ */
+void drawLineSpans(unsigned int aXStart, unsigned int aYStart, unsigned int aXEnd, unsigned int aYEnd, bool aSkipStartPixel,
+        uint16_t aColor) {
+    int16_t tDeltaX, tDeltaY, tDeltaXTimes2, tDeltaYTimes2, tError, tStepX, tStepY;
+
+    /*
+     * Clip to display size
+     */
+    if (aXStart >= LOCAL_DISPLAY_WIDTH) {
+        aXStart = LOCAL_DISPLAY_WIDTH - 1;
+    }
+
+    if (aXEnd >= LOCAL_DISPLAY_WIDTH) {
+        aXEnd = LOCAL_DISPLAY_WIDTH - 1;
+    }
+
+    if (aYStart >= LOCAL_DISPLAY_HEIGHT) {
+        aYStart = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+
+    if (aYEnd >= LOCAL_DISPLAY_HEIGHT) {
+        aYEnd = LOCAL_DISPLAY_HEIGHT - 1;
+    }
+
+    // calculate direction
+    tDeltaX = aXEnd - aXStart;
+    tDeltaY = aYEnd - aYStart;
+    if (tDeltaX < 0) {
+        tDeltaX = -tDeltaX;
+        tStepX = -1;
+    } else {
+        tStepX = +1;
+    }
+    if (tDeltaY < 0) {
+        tDeltaY = -tDeltaY;
+        tStepY = -1;
+    } else {
+        tStepY = +1;
+    }
+    tDeltaXTimes2 = tDeltaX << 1;
+    tDeltaYTimes2 = tDeltaY << 1;
+
+    uint16_t tRunLength = 1;
+    if (aSkipStartPixel) {
+        tRunLength = 0;
+    }
+    if (tDeltaX > tDeltaY) {
+        // horizontal spans, start value represents a half step in Y direction
+        unsigned int tRunStart = aXStart + tStepX * (1 - tRunLength);
+        tError = tDeltaYTimes2 - tDeltaX;
+        while (aXStart != aXEnd) {
+            // step in main direction
+            aXStart += tStepX;
+            if (tError >= 0) {
+                // change Y -> draw current span
+                drawRun(tRunStart, aYStart, tRunLength, tStepX, false, aColor);
+                aYStart += tStepY;
+                tError -= tDeltaXTimes2;
+                tRunStart = aXStart;
+                tRunLength = 0;
+            }
+            tError += tDeltaYTimes2;
+            tRunLength++;
+        }
+        drawRun(tRunStart, aYStart, tRunLength, tStepX, false, aColor);
+    } else {
+        // vertical spans
+        unsigned int tRunStart = aYStart + tStepY * (1 - tRunLength);
+        tError = tDeltaXTimes2 - tDeltaY;
+        while (aYStart != aYEnd) {
+            aYStart += tStepY;
+            if (tError >= 0) {
+                drawRun(tRunStart, aXStart, tRunLength, tStepY, true, aColor);
+                aXStart += tStepX;
+                tError -= tDeltaYTimes2;
+                tRunStart = aYStart;
+                tRunLength = 0;
+            }
+            tError += tDeltaXTimes2;
+            tRunLength++;
+        }
+        drawRun(tRunStart, aXStart, tRunLength, tStepY, true, aColor);
+    }
+}
+
+/**
+ * Draws connected lines through all points, e.g. a chart trace. The inner points are drawn only once.
+ * Consecutive spans share the area and entry mode settings of the local display, see SSD1289::drawSpan().
+ */
+void drawPolylineSpans(const struct XYPosition *aPoints, unsigned int aNumberOfPoints, uint16_t aColor) {
+    if (aNumberOfPoints == 1) {
+        drawLineSpans(aPoints[0].PositionX, aPoints[0].PositionY, aPoints[0].PositionX, aPoints[0].PositionY, false, aColor);
+    }
+    for (unsigned int i = 1; i < aNumberOfPoints; ++i) {
+        drawLineSpans(aPoints[i - 1].PositionX, aPoints[i - 1].PositionY, aPoints[i].PositionX, aPoints[i].PositionY, (i > 1),
+                aColor);
+    }
+}
+#endif
+
 // Includes for implementation of drawPixel(), drawLine() and fillRect()
 #if !defined(DISABLE_REMOTE_DISPLAY)
 #include "BlueDisplay.h"
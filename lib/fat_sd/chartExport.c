@@ -0,0 +1,165 @@
+/*
+ * @file chartExport.c
+ *
+ * CSV and binary export of a sample history, generated while the write behind queue writes it.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "chartExport.h"
+#include "writeBehind.h"
+
+#include <string.h> // for memset, memcpy
+
+#define NO_CHANNEL 0xFF
+
+/*
+ * State of the export, which is read by the generators called by WriteBehind_service()
+ */
+static struct {
+    SampleHistoryTypeDef *History;
+    uint16_t SampleCount; // SampleCount at start of export
+    uint8_t Channel; // column of binary export just written
+    SampleHistoryCursorTypeDef Cursor;
+    FRESULT ReadResult; // first error of reading history
+} sExport;
+
+/**
+ * Integer replacement for e.g. snprintf("%6.3f") of a millivolt value without float and printf code.
+ * Writes exactly aWidth characters right aligned with leading spaces and without terminating null.
+ * Leading digits which do not fit into aWidth are discarded.
+ * @param aDecimals number of digits after the decimal point, 0 -> no decimal point
+ * @return pointer to the character after the written ones, to accumulate output without strlen()
+ */
+char* ChartExport_formatFixedPoint(char *aDestPointer, uint32_t aValue, uint8_t aWidth, uint8_t aDecimals) {
+    char *tEndPointer = aDestPointer + aWidth;
+    char *tPointer = tEndPointer;
+    uint8_t tDigitCount = 0;
+    do {
+        if (tDigitCount == aDecimals && aDecimals != 0) {
+            *--tPointer = '.';
+            if (tPointer == aDestPointer) {
+                break;
+            }
+        }
+        *--tPointer = '0' + (aValue % 10);
+        aValue /= 10;
+        tDigitCount++;
+    } while ((aValue != 0 || tDigitCount <= aDecimals) && tPointer > aDestPointer);
+    while (tPointer > aDestPointer) {
+        *--tPointer = ' ';
+    }
+    return tEndPointer;
+}
+
+static void startExport(SampleHistoryTypeDef *aHistory, uint16_t aSampleCount) {
+    sExport.History = aHistory;
+    sExport.SampleCount = aSampleCount;
+    sExport.Channel = NO_CHANNEL;
+    sExport.ReadResult = SampleHistory_seek(&sExport.Cursor, aHistory, 0);
+}
+
+/*
+ * @return false if export is complete or history could not be read
+ */
+static bool readNextSample(void) {
+    if (sExport.ReadResult != FR_OK || sExport.Cursor.SampleIndex >= sExport.SampleCount) {
+        return false;
+    }
+    FRESULT tResult = SampleHistory_next(&sExport.Cursor);
+    if (tResult != FR_OK) {
+        sExport.ReadResult = tResult;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Generates the CSV data lines for WriteBehind_service()
+ */
+static UINT generateLines(uint8_t *aBuffer, UINT aSize, void *aContext) {
+    char *tBufferPointer = (char*) aBuffer;
+    char *tBufferEnd = tBufferPointer + aSize - CHART_EXPORT_CSV_LINE_LENGTH;
+    while (tBufferPointer <= tBufferEnd && readNextSample()) {
+        tBufferPointer = ChartExport_formatFixedPoint(tBufferPointer, sExport.Cursor.Values[0], CHART_EXPORT_VOLT_WIDTH, 3);
+        *tBufferPointer++ = ';';
+        tBufferPointer = ChartExport_formatFixedPoint(tBufferPointer, sExport.Cursor.Values[1], CHART_EXPORT_MILLIOHM_WIDTH, 0);
+        *tBufferPointer++ = '\n';
+    }
+    return tBufferPointer - (char*) aBuffer;
+}
+
+/*
+ * Generates one uint16_t column for WriteBehind_service(). aContext is the history channel.
+ */
+static UINT generateColumn(uint8_t *aBuffer, UINT aSize, void *aContext) {
+    uint8_t tChannel = (uintptr_t) aContext;
+    if (sExport.Channel != tChannel) {
+        // start of column
+        sExport.Channel = tChannel;
+        if (sExport.ReadResult == FR_OK) {
+            sExport.ReadResult = SampleHistory_seek(&sExport.Cursor, sExport.History, 0);
+        }
+    }
+    uint8_t *tBufferPointer = aBuffer;
+    while (tBufferPointer <= aBuffer + aSize - sizeof(uint16_t) && readNextSample()) {
+        uint16_t tValue = sExport.Cursor.Values[tChannel];
+        *tBufferPointer++ = tValue;
+        *tBufferPointer++ = tValue >> 8;
+    }
+    return tBufferPointer - aBuffer;
+}
+
+static void initColumn(ChartExportBinaryColumnTypeDef *aColumn, const char *aName, const char *aUnit, uint32_t aOffset) {
+    memset(aColumn, 0, sizeof(ChartExportBinaryColumnTypeDef));
+    // fields are padded with null, but not terminated if completely used
+    memcpy(aColumn->Name, aName, strnlen(aName, sizeof(aColumn->Name)));
+    memcpy(aColumn->Unit, aUnit, strnlen(aUnit, sizeof(aColumn->Unit)));
+    aColumn->Type = CHART_EXPORT_BINARY_TYPE_UINT16;
+    aColumn->Offset = aOffset;
+}
+
+/**
+ * Queues the header and the generator for the lines. The header is copied to the write behind buffer.
+ * @param aSampleCount number of samples to export, must not change until the file is closed
+ * @return false if not all requests could be queued
+ */
+bool ChartExport_queueCSV(uint8_t aFileHandle, SampleHistoryTypeDef *aHistory, uint16_t aSampleCount, const char *aHeader,
+        UINT aHeaderLength) {
+    startExport(aHistory, aSampleCount);
+    return (WriteBehind_write(aFileHandle, aHeader, aHeaderLength)
+            && WriteBehind_writeGenerated(aFileHandle, &generateLines, NULL));
+}
+
+/**
+ * Completes the header with format, sample count and columns and queues it and the generators for the columns.
+ * The header is copied to the write behind buffer.
+ * @param aHeader ProbeNumber, Mode, SamplePeriodSeconds, SampleCount and the battery values must be set by the caller
+ * @return false if not all requests could be queued
+ */
+bool ChartExport_queueBinary(uint8_t aFileHandle, SampleHistoryTypeDef *aHistory, ChartExportBinaryHeaderTypeDef *aHeader) {
+    startExport(aHistory, aHeader->SampleCount);
+    aHeader->Magic = CHART_EXPORT_BINARY_MAGIC;
+    aHeader->Version = CHART_EXPORT_BINARY_VERSION;
+    aHeader->HeaderSize = sizeof(ChartExportBinaryHeaderTypeDef);
+    aHeader->NumberOfColumns = CHART_EXPORT_BINARY_NUMBER_OF_COLUMNS;
+    aHeader->Reserved = 0;
+    UINT tColumnSectors = ((aHeader->SampleCount * sizeof(uint16_t)) + _MAX_SS - 1) / _MAX_SS;
+    initColumn(&aHeader->Columns[0], "VoltNoLoad", "mV", _MAX_SS);
+    initColumn(&aHeader->Columns[1], "ESR", "mOhm", (1 + tColumnSectors) * _MAX_SS);
+
+    return (WriteBehind_write(aFileHandle, aHeader, sizeof(ChartExportBinaryHeaderTypeDef)) && WriteBehind_padToSector(aFileHandle)
+            && WriteBehind_writeGenerated(aFileHandle, &generateColumn, (void*) 0) && WriteBehind_padToSector(aFileHandle)
+            && WriteBehind_writeGenerated(aFileHandle, &generateColumn, (void*) 1));
+}
+
+/**
+ * @return first error of reading the history during the last export, to be checked by the close callback
+ */
+FRESULT ChartExport_getReadResult(void) {
+    return sExport.ReadResult;
+}
@@ -0,0 +1,79 @@
+/*
+ * @file chartExport.h
+ *
+ * Export of the voltage and ESR sample history of AccuCapacity as CSV or binary file by the write behind queue.
+ * Only the header is formatted by the caller, the data is generated from the history while WriteBehind_service() writes it,
+ * so no buffer for the whole file is required.
+ *
+ * CSV: the header given by the caller, then one line per sample. Channel 0 is formatted as fixed point value
+ * with 3 decimals (millivolt as Volt), channel 1 (milliohm) as integer, e.g. " 4.150;  152\n".
+ *
+ * Binary: one header sector with ChartExportBinaryHeaderTypeDef, followed by one sector aligned uint16_t
+ * little endian array for each channel. All values are integers, so no float conversion is required for reading.
+ *
+ * Only one export can be active at a time.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef CHART_EXPORT_H_
+#define CHART_EXPORT_H_
+
+#include "ff.h"
+#include "sampleHistory.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CHART_EXPORT_CSV_LINE_LENGTH 13 // " 1.234;  567\n"
+#define CHART_EXPORT_VOLT_WIDTH 6 // like "%6.3f" for Volt
+#define CHART_EXPORT_MILLIOHM_WIDTH 5 // like "%5d"
+
+#define CHART_EXPORT_BINARY_MAGIC 0x42434341 // "ACCB"
+#define CHART_EXPORT_BINARY_VERSION 1
+#define CHART_EXPORT_BINARY_NUMBER_OF_COLUMNS SAMPLE_HISTORY_NUMBER_OF_CHANNELS
+#define CHART_EXPORT_BINARY_TYPE_UINT16 1
+
+typedef struct {
+    char Name[12];
+    char Unit[4];
+    uint8_t Type; // CHART_EXPORT_BINARY_TYPE_UINT16
+    uint8_t Reserved[3];
+    uint32_t Offset; // from start of file, multiple of sector size
+} ChartExportBinaryColumnTypeDef;
+
+typedef struct {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t HeaderSize; // sizeof(ChartExportBinaryHeaderTypeDef)
+    uint16_t ProbeNumber;
+    uint8_t Mode; // MODE_DISCHARGING, MODE_CHARGING or MODE_EXTERNAL_VOLTAGE of AccuCapacity
+    uint8_t NumberOfColumns;
+    uint16_t SamplePeriodSeconds;
+    uint16_t SampleCount;
+    uint16_t CapacityMilliampereHour;
+    uint16_t ESRMilliohm;
+    uint16_t LoadResistorMilliohm;
+    uint16_t Reserved;
+    ChartExportBinaryColumnTypeDef Columns[CHART_EXPORT_BINARY_NUMBER_OF_COLUMNS];
+} ChartExportBinaryHeaderTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+char* ChartExport_formatFixedPoint(char *aDestPointer, uint32_t aValue, uint8_t aWidth, uint8_t aDecimals);
+
+bool ChartExport_queueCSV(uint8_t aFileHandle, SampleHistoryTypeDef *aHistory, uint16_t aSampleCount, const char *aHeader,
+        UINT aHeaderLength);
+bool ChartExport_queueBinary(uint8_t aFileHandle, SampleHistoryTypeDef *aHistory, ChartExportBinaryHeaderTypeDef *aHeader);
+FRESULT ChartExport_getReadResult(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CHART_EXPORT_H_ */
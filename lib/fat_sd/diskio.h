@@ -14,6 +14,7 @@ extern "C" {
 
 #include "integer.h"
 #include <stddef.h>
+#include <stdbool.h>
 
 /* Status of Disk Functions */
 typedef BYTE	DSTATUS;
@@ -41,6 +42,8 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 int getFSInfo(char aStringBuffer[], size_t sizeofStringBuffer);
 int getCardInfo(char aStringBuffer[], size_t sizeofStringBuffer);
 void testAttachMMC(void);
+int isCardReady(void);
+void disk_setWaitCallback(bool (*aWaitCallback)(void));
 
 /* Disk Status Bits (DSTATUS) */
 #define STA_NOINIT		0x01	/* Drive not initialized */
@@ -0,0 +1,253 @@
+/*
+ * @file imageWriter.c
+ *
+ * Pipelined image file writer with BMP and run length encoded TGA output.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "imageWriter.h"
+#include "diskio.h"
+#include "sdPlatform.h" // for micros()
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memset
+
+/*
+ * Prefetch of the next block by the wait callback of mmc.c
+ */
+static ImageWriterReadLine sReadLine;
+static uint16_t *sPrefetchBuffer;
+static uint16_t sPrefetchStartLine; // first line to read, lines are read downwards
+static uint16_t sPrefetchLineCount;
+static uint16_t sPrefetchLinesRead;
+static uint16_t sWidth;
+
+static ImageWriterStatisticsTypeDef sStatistics;
+
+static void storeWord(uint8_t *aBuffer, uint16_t aValue) {
+    aBuffer[0] = aValue;
+    aBuffer[1] = aValue >> 8;
+}
+
+static void storeDoubleWord(uint8_t *aBuffer, uint32_t aValue) {
+    storeWord(aBuffer, aValue);
+    storeWord(aBuffer + 2, aValue >> 16);
+}
+
+/**
+ * @return length of header. For BMP the header is padded with zeros to IMAGE_BMP_DATA_OFFSET.
+ */
+UINT ImageWriter_encodeHeader(uint8_t *aBuffer, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight) {
+    if (aFormat == IMAGE_FORMAT_TGA_RLE) {
+        memset(aBuffer, 0, IMAGE_TGA_HEADER_SIZE);
+        aBuffer[2] = 10; // run length encoded true color
+        storeWord(&aBuffer[12], aWidth);
+        storeWord(&aBuffer[14], aHeight);
+        aBuffer[16] = 16; // bits per pixel
+        aBuffer[17] = 0; // no alpha bits, origin lower left
+        return IMAGE_TGA_HEADER_SIZE;
+    }
+    uint32_t tImageSize = (uint32_t) aWidth * aHeight * sizeof(uint16_t);
+    memset(aBuffer, 0, IMAGE_BMP_DATA_OFFSET);
+    // file header
+    aBuffer[0] = 'B';
+    aBuffer[1] = 'M';
+    storeDoubleWord(&aBuffer[2], IMAGE_BMP_DATA_OFFSET + tImageSize);
+    storeDoubleWord(&aBuffer[10], IMAGE_BMP_DATA_OFFSET);
+    // info header
+    aBuffer[14] = 40;
+    storeDoubleWord(&aBuffer[18], aWidth);
+    storeDoubleWord(&aBuffer[22], aHeight); // positive -> bottom up
+    aBuffer[26] = 1; // planes
+    aBuffer[28] = 16; // bits per pixel, 5-5-5 for BI_RGB
+    storeDoubleWord(&aBuffer[34], tImageSize);
+    return IMAGE_BMP_DATA_OFFSET;
+}
+
+/**
+ * TGA run length encoding of one line. Packets do not cross lines.
+ * A run packet is used for 2 and more equal pixel.
+ * aOutput may be below aPixels in the same buffer, if the gap is at least 3 + (aWidth / IMAGE_TGA_MAX_PACKET_PIXELS) bytes.
+ * The output is at most this number of bytes longer than the input, and each pixel is read before its position is written.
+ * @return number of bytes written to aOutput
+ */
+UINT ImageWriter_encodeLineRLE(uint8_t *aOutput, const uint16_t *aPixels, uint16_t aWidth) {
+    uint8_t *tOutput = aOutput;
+    uint16_t i = 0;
+    while (i < aWidth) {
+        uint16_t tPixel = aPixels[i];
+        uint16_t tRunLength = 1;
+        while (i + tRunLength < aWidth && tRunLength < IMAGE_TGA_MAX_PACKET_PIXELS && aPixels[i + tRunLength] == tPixel) {
+            tRunLength++;
+        }
+        if (tRunLength >= 2) {
+            *tOutput++ = 0x80 | (tRunLength - 1);
+            storeWord(tOutput, tPixel);
+            tOutput += 2;
+            i += tRunLength;
+        } else {
+            // raw packet up to the start of the next run
+            uint8_t *tPacketHeader = tOutput++;
+            uint16_t tCount = 0;
+            while (i < aWidth && tCount < IMAGE_TGA_MAX_PACKET_PIXELS) {
+                tPixel = aPixels[i];
+                if (i + 1 < aWidth && aPixels[i + 1] == tPixel) {
+                    break;
+                }
+                storeWord(tOutput, tPixel);
+                tOutput += 2;
+                i++;
+                tCount++;
+            }
+            *tPacketHeader = tCount - 1;
+        }
+    }
+    return tOutput - aOutput;
+}
+
+/*
+ * Is called by mmc.c while f_write() waits for the card
+ */
+static bool readLineWhileWriting(void) {
+    if (sPrefetchLinesRead >= sPrefetchLineCount) {
+        return false;
+    }
+    sReadLine(sPrefetchBuffer + (sPrefetchLinesRead * sWidth), sPrefetchStartLine - sPrefetchLinesRead);
+    sPrefetchLinesRead++;
+    sStatistics.LinesReadWhileWriting++;
+    return true;
+}
+
+static void readRemainingLines(void) {
+    uint32_t tStartMicros = micros();
+    while (sPrefetchLinesRead < sPrefetchLineCount) {
+        sReadLine(sPrefetchBuffer + (sPrefetchLinesRead * sWidth), sPrefetchStartLine - sPrefetchLinesRead);
+        sPrefetchLinesRead++;
+    }
+    sStatistics.ReadMicros += micros() - tStartMicros;
+}
+
+static void setPrefetch(uint16_t *aBuffer, uint16_t aStartLine, uint16_t aLineCount) {
+    sPrefetchBuffer = aBuffer;
+    sPrefetchStartLine = aStartLine;
+    sPrefetchLineCount = aLineCount;
+    sPrefetchLinesRead = 0;
+}
+
+/**
+ * Reads the image from bottom to top and writes it to a new file. Existing file is overwritten.
+ * @param aWidth must be even for BMP, since BMP lines are padded to 4 bytes
+ */
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        ImageWriterReadLine aReadLine) {
+    if (aHeight == 0 || (aFormat == IMAGE_FORMAT_BMP && (aWidth & 0x01))) {
+        return FR_INVALID_PARAMETER;
+    }
+    uint32_t tStartMicros = micros();
+    memset(&sStatistics, 0, sizeof(sStatistics));
+    sReadLine = aReadLine;
+    sWidth = aWidth;
+
+    /*
+     * The run length encoding is done in place. The encoded lines start at the beginning of the block buffer
+     * and the pixel data after a gap, which is large enough for the worst case overhead of all lines of the block.
+     */
+    UINT tGap = 0;
+    if (aFormat == IMAGE_FORMAT_TGA_RLE) {
+        tGap = (IMAGE_WRITER_LINES_PER_BLOCK * (3 + (aWidth / IMAGE_TGA_MAX_PACKET_PIXELS)) + 3) & ~0x03;
+    }
+    UINT tBlockBufferSize = tGap + (IMAGE_WRITER_LINES_PER_BLOCK * aWidth * sizeof(uint16_t));
+    if (tBlockBufferSize < IMAGE_BMP_DATA_OFFSET) {
+        tBlockBufferSize = IMAGE_BMP_DATA_OFFSET; // for header
+    }
+    uint8_t *tBlockBuffer[2];
+    tBlockBuffer[0] = (uint8_t *) malloc(2 * tBlockBufferSize);
+    sStatistics.IsPipelined = true;
+    if (tBlockBuffer[0] == NULL) {
+        sStatistics.IsPipelined = false;
+        tBlockBuffer[0] = (uint8_t *) malloc(tBlockBufferSize);
+        if (tBlockBuffer[0] == NULL) {
+            return FR_NOT_ENOUGH_CORE;
+        }
+        tBlockBuffer[1] = tBlockBuffer[0];
+    } else {
+        tBlockBuffer[1] = tBlockBuffer[0] + tBlockBufferSize;
+    }
+
+    FIL tFile;
+    FRESULT tResult = f_open(&tFile, aFileName, FA_CREATE_ALWAYS | FA_WRITE);
+    if (tResult == FR_OK) {
+        UINT tCount;
+        UINT tLength = ImageWriter_encodeHeader(tBlockBuffer[0], aFormat, aWidth, aHeight);
+        tResult = f_write(&tFile, tBlockBuffer[0], tLength, &tCount);
+
+        uint8_t tIndex = 0;
+        uint16_t tLinesRemaining = aHeight;
+        uint16_t tBlockLineCount = IMAGE_WRITER_LINES_PER_BLOCK;
+        if (tBlockLineCount > tLinesRemaining) {
+            tBlockLineCount = tLinesRemaining;
+        }
+        setPrefetch((uint16_t *) (tBlockBuffer[0] + tGap), aHeight - 1, tBlockLineCount);
+        readRemainingLines();
+
+        while (tResult == FR_OK && tLinesRemaining > 0) {
+            uint8_t *tBlock = tBlockBuffer[tIndex];
+            /*
+             * Encode
+             */
+            uint32_t tPhaseStartMicros = micros();
+            tLength = tBlockLineCount * aWidth * sizeof(uint16_t);
+            if (aFormat == IMAGE_FORMAT_TGA_RLE) {
+                tLength = 0;
+                for (uint16_t i = 0; i < tBlockLineCount; ++i) {
+                    tLength += ImageWriter_encodeLineRLE(tBlock + tLength, (uint16_t *) (tBlock + tGap) + (i * aWidth), aWidth);
+                }
+            } else {
+                tBlock += tGap;
+            }
+            sStatistics.EncodeMicros += micros() - tPhaseStartMicros;
+
+            /*
+             * Write this block and read the next one meanwhile
+             */
+            tLinesRemaining -= tBlockLineCount;
+            uint16_t tNextBlockLineCount = IMAGE_WRITER_LINES_PER_BLOCK;
+            if (tNextBlockLineCount > tLinesRemaining) {
+                tNextBlockLineCount = tLinesRemaining;
+            }
+            tIndex ^= 1;
+            setPrefetch((uint16_t *) (tBlockBuffer[tIndex] + tGap), tLinesRemaining - 1, tNextBlockLineCount);
+            tPhaseStartMicros = micros();
+            if (sStatistics.IsPipelined) {
+                disk_setWaitCallback(&readLineWhileWriting);
+            }
+            tResult = f_write(&tFile, tBlock, tLength, &tCount);
+            disk_setWaitCallback(NULL);
+            if (tResult == FR_OK && tCount != tLength) {
+                tResult = FR_DENIED; // disk full
+            }
+            sStatistics.WriteMicros += micros() - tPhaseStartMicros;
+            readRemainingLines();
+            tBlockLineCount = tNextBlockLineCount;
+        }
+        uint32_t tPhaseStartMicros = micros();
+        sStatistics.FileSize = f_size(&tFile);
+        FRESULT tCloseResult = f_close(&tFile);
+        if (tResult == FR_OK) {
+            tResult = tCloseResult;
+        }
+        sStatistics.WriteMicros += micros() - tPhaseStartMicros;
+    }
+    free(tBlockBuffer[0]);
+    sStatistics.TotalMicros = micros() - tStartMicros;
+    return tResult;
+}
+
+const ImageWriterStatisticsTypeDef * ImageWriter_getStatistics(void) {
+    return &sStatistics;
+}
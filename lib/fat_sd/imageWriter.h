@@ -0,0 +1,71 @@
+/*
+ * @file imageWriter.h
+ *
+ * Writes an image, which is read line by line e.g. from the display controller, to a file.
+ * Reading of lines and writing to the card are pipelined with 2 block buffers.
+ * While block N is written by f_write(), the lines of block N+1 are read by the wait callback of mmc.c,
+ * i.e. during the SPI DMA transfer of a sector and while the card is programming.
+ * If only one block buffer can be allocated, reading and writing alternate.
+ *
+ * Formats:
+ * IMAGE_FORMAT_BMP 16 bit uncompressed BMP. The pixel data starts at sector 1, so 4 lines of 320 pixel
+ * are 5 complete sectors, which are written by one multiple block write without the sector buffer of FatFs.
+ * IMAGE_FORMAT_TGA_RLE 16 bit run length encoded TGA (image type 10). BMP defines run length encoding only for
+ * palette images, TGA supports it for 16 bit pixel. Typical GUI screens are reduced to less than 10 percent.
+ * Both formats store the lines from bottom to top.
+ *
+ * The encoder functions contain no HAL code and can be tested on the host with mmc_sim.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef IMAGE_WRITER_H_
+#define IMAGE_WRITER_H_
+
+#include "ff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IMAGE_FORMAT_BMP 0
+#define IMAGE_FORMAT_TGA_RLE 1
+
+#define IMAGE_WRITER_LINES_PER_BLOCK 4 // 4 lines of 320 pixel are 5 sectors
+#define IMAGE_BMP_DATA_OFFSET _MAX_SS
+#define IMAGE_TGA_HEADER_SIZE 18
+#define IMAGE_TGA_MAX_PACKET_PIXELS 128
+
+/*
+ * Must fill aLineBuffer with the pixel of line aLineNumber in 5-5-5 format, bit 15 is ignored.
+ */
+typedef void (*ImageWriterReadLine)(uint16_t *aLineBuffer, uint16_t aLineNumber);
+
+typedef struct {
+    uint32_t TotalMicros;
+    uint32_t ReadMicros; // reading of lines, which was not done while waiting for the card
+    uint32_t EncodeMicros;
+    uint32_t WriteMicros; // f_write() and f_close(), including the lines read while waiting
+    uint16_t LinesReadWhileWriting;
+    bool IsPipelined; // false if only one block buffer could be allocated
+    uint32_t FileSize;
+} ImageWriterStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FRESULT ImageWriter_store(const TCHAR *aFileName, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight,
+        ImageWriterReadLine aReadLine);
+const ImageWriterStatisticsTypeDef * ImageWriter_getStatistics(void);
+
+UINT ImageWriter_encodeHeader(uint8_t *aBuffer, uint8_t aFormat, uint16_t aWidth, uint16_t aHeight);
+UINT ImageWriter_encodeLineRLE(uint8_t *aOutput, const uint16_t *aPixels, uint16_t aWidth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IMAGE_WRITER_H_ */
@@ -43,6 +43,7 @@ extern FATFS Fatfs[1];
 #define CMD38  (38)			/* ERASE */
 #define CMD55	(55)		/* APP_CMD */
 #define CMD58	(58)		/* READ_OCR */
+#define CMD59	(59)		/* CRC_ON_OFF */
 
 /* Card-Select Controls  (Platform dependent) */
 #define CS_LOW()        MICROSD_CSEnable()    /* MMC CS = L */
@@ -53,10 +54,22 @@ extern FATFS Fatfs[1];
 #define	FCLK_FAST()	SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_2)	/* Set fastest clock (F_CPU / 2) */
 #define TIMEOUT_WAIT_READY 1000
 
+#if !defined(STM32_SD_USE_PIO)
+#define STM32_SD_USE_DMA /* Sector data is transferred by SPI1 DMA. BlueDisplay uses UART4, so the SPI1 DMA channels are free. */
+#endif
+#if !defined(STM32_SD_DISABLE_CRC)
+#define STM32_SD_USE_CRC /* CRC of commands and data blocks is checked by card and host, enabled by CMD59 after initialization */
+#endif
+#define TIMEOUT_DMA_TRANSFER 100 /* 512 bytes require 15 ms at FCLK_SLOW */
+
 static volatile DSTATUS Stat = STA_NOINIT; /* Disk status */
 
 static BYTE CardType; /* Card type flags */
 
+static volatile BOOL CardIsBusy = FALSE; /* Card may still be programming the last written block */
+static BOOL CrcIsEnabled = FALSE; /* Card accepted CMD59, data blocks carry a valid CRC16 */
+static bool (*sWaitCallback)(void) = NULL; /* Called while waiting for DMA end or card ready, see disk_setWaitCallback() */
+
 static
 int power_status(void) /* Socket power state: 0=off, 1=on */
 {
@@ -101,6 +114,116 @@ static BYTE rcvr_spi(void) {
     return stm32_spi_rw(0xff);
 }
 
+/*-----------------------------------------------------------------------*/
+/* CRC7 of command packets and CRC16 of data blocks                      */
+/*-----------------------------------------------------------------------*/
+
+static
+BYTE crc7( /* CRC7 of the command (x^7 + x^3 + 1) */
+const BYTE *buff, /* Command index and argument */
+UINT n /* Byte count */
+) {
+    BYTE crc = 0, d, i;
+
+    while (n--) {
+        d = *buff++;
+        for (i = 0; i < 8; i++) {
+            crc <<= 1;
+            if ((d ^ crc) & 0x80) {
+                crc ^= 0x09;
+            }
+            d <<= 1;
+        }
+    }
+    return crc & 0x7F;
+}
+
+#ifdef STM32_SD_USE_CRC
+/* CRC16 CCITT (x^16 + x^12 + x^5 + 1), one table lookup per byte instead of 8 shift and xor */
+static const WORD Crc16Table[256] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+        0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+        0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+        0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+        0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+        0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+        0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+        0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+        0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+        0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+        0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+        0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+        0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+        0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+        0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+        0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+        0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+        0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+        0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+        0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+        0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+        0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+        0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+        0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+        0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+        0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+        0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+        0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+        0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+        0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+        0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+static
+WORD crc16( /* CRC16 of the data block */
+const BYTE *buff, /* Data block */
+UINT n /* Byte count */
+) {
+    WORD crc = 0;
+
+    while (n--) {
+        crc = (crc << 8) ^ Crc16Table[(BYTE) (crc >> 8) ^ *buff++];
+    }
+    return crc;
+}
+#endif /* STM32_SD_USE_CRC */
+
+#ifdef STM32_SD_USE_DMA
+/*-----------------------------------------------------------------------*/
+/* Transfer a data block by SPI1 DMA  (Platform dependent)               */
+/* For receive 0xFF is sent, for transmit the received bytes are discarded */
+/*-----------------------------------------------------------------------*/
+
+static
+int stm32_dma_transfer( /* 1:OK, 0:Timeout or DMA error */
+BOOL receive, /* FALSE for buff->SPI, TRUE for SPI->buff */
+const BYTE *buff, /* receive FALSE : Data block to be transmitted
+ receive TRUE  : Data buffer to store received data */
+UINT btr, /* Byte count */
+WORD *crc /* receive FALSE and not NULL : CRC16 of the data block is computed while the DMA is transmitting */
+) {
+    if (receive) {
+        SPI1_DMA_startTransfer(NULL, (BYTE *) buff, btr);
+    } else {
+        SPI1_DMA_startTransfer(buff, NULL, btr);
+#ifdef STM32_SD_USE_CRC
+        if (crc != NULL) {
+            *crc = crc16(buff, btr);
+        }
+#else
+        (void) crc;
+#endif
+    }
+    if (sWaitCallback != NULL) {
+        while (SPI1_DMA_isTransferOngoing() && sWaitCallback()) {
+            ;
+        }
+    }
+    return SPI1_DMA_waitForTransferEnd(TIMEOUT_DMA_TRANSFER) ? 1 : 0;
+}
+#endif /* STM32_SD_USE_DMA */
+
 /*-----------------------------------------------------------------------*/
 /* Wait for card ready                                                   */
 /*-----------------------------------------------------------------------*/
@@ -113,12 +236,19 @@ UINT wt /* Timeout [ms] */
     // setTimeoutMillis(wt);  does not work because setTimeoutMillis() is not reentrant and used by calling routine too
     uint32_t tTimestamp = millis() + wt;
     while (rcvr_spi() != 0xFF) {
+        if (sWaitCallback != NULL) {
+            sWaitCallback();
+        }
         if (millis() > tTimestamp) {
             failParamMessage(tLR14, "Timeout in wait_ready()");
             break;
         }
     }
-    return (rcvr_spi() == 0xFF) ? 1 : 0;
+    if (rcvr_spi() == 0xFF) {
+        CardIsBusy = FALSE;
+        return 1;
+    }
+    return 0;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -130,6 +260,7 @@ void deselect(void) {
     CS_HIGH();
     xchg_spi(0xFF);
     /* Dummy clock (force DO hi-z for multiple slave SPI) */
+    MICROSD_releaseSPI();
 }
 
 /*-----------------------------------------------------------------------*/
@@ -161,6 +292,7 @@ UINT btr /* Byte count (must be multiple of 4) */
     uint32_t tLR14 = getLR14();
 
     BYTE token;
+    WORD crc;
 
     setTimeoutMillis(200);
 
@@ -173,19 +305,30 @@ UINT btr /* Byte count (must be multiple of 4) */
 
 //	rcvr_spi_multi(buff, btr); /* Receive the data block into buffer */
 #ifdef STM32_SD_USE_DMA
-    stm32_dma_transfer( TRUE, buff, btr );
+    if (!stm32_dma_transfer(TRUE, buff, btr, NULL)) {
+        return 0;
+    }
 #else
+    BYTE *ptr = buff;
+    UINT cnt = btr;
     do { /* Receive the data block into buffer */
-        *(buff++) = stm32_spi_rw(0xff);
-        *(buff++) = stm32_spi_rw(0xff);
-        *(buff++) = stm32_spi_rw(0xff);
-        *(buff++) = stm32_spi_rw(0xff);
-    } while (btr -= 4);
+        *(ptr++) = stm32_spi_rw(0xff);
+        *(ptr++) = stm32_spi_rw(0xff);
+        *(ptr++) = stm32_spi_rw(0xff);
+        *(ptr++) = stm32_spi_rw(0xff);
+    } while (cnt -= 4);
 #endif /* STM32_SD_USE_DMA */
 
-    xchg_spi(0xFF);
-    /* Discard CRC */
-    xchg_spi(0xFF);
+    crc = xchg_spi(0xFF) << 8;
+    /* Receive CRC */
+    crc |= xchg_spi(0xFF);
+#ifdef STM32_SD_USE_CRC
+    if (CrcIsEnabled && crc != crc16(buff, btr)) {
+        return 0; /* If data is corrupted, return with error */
+    }
+#else
+    (void) crc;
+#endif
 
     return 1; /* Return with success */
 }
@@ -200,6 +343,7 @@ int xmit_datablock(const BYTE *buff, /* 512 byte data block to be transmitted */
 BYTE token /* Data/Stop token */
 ) {
     BYTE resp;
+    WORD crc = 0xFFFF; /* Dummy if CRC is disabled */
 
     if (!wait_ready(TIMEOUT_WAIT_READY)) {
         return 0;
@@ -210,22 +354,34 @@ BYTE token /* Data/Stop token */
     if (token != 0xFD) { /* Is data token */
 //		xmit_spi_multi(buff, 512); /* Xmit the data block to the MMC */
 #ifdef STM32_SD_USE_DMA
-        stm32_dma_transfer( FALSE, buff, 512 );
+        if (!stm32_dma_transfer(FALSE, buff, 512, CrcIsEnabled ? &crc : NULL)) {
+            return 0;
+        }
 #else
+#ifdef STM32_SD_USE_CRC
+        if (CrcIsEnabled) {
+            crc = crc16(buff, 512);
+        }
+#endif
         BYTE wc = 0;
         do { /* transmit the 512 byte data block to MMC */
             stm32_spi_rw(*buff++);
             stm32_spi_rw(*buff++);
         } while (--wc);
 #endif /* STM32_SD_USE_DMA */
-        xchg_spi(0xFF);
-        /* CRC (Dummy) */
-        xchg_spi(0xFF);
+        xchg_spi((BYTE ) (crc >> 8));
+        /* CRC */
+        xchg_spi((BYTE ) crc);
         resp = xchg_spi(0xFF); /* Reveive data response */
         if ((resp & 0x1F) != 0x05) { /* If not accepted, return with error */
             return 0;
         }
     }
+    /*
+     * Card is busy now with programming the block. We do not wait here,
+     * the next command or block waits in select() or at the start of this function.
+     */
+    CardIsBusy = TRUE;
 
     return 1;
 }
@@ -239,7 +395,7 @@ static BYTE send_cmd( /* Returns R1 resp (bit7==1:Send failed) */
 BYTE cmd, /* Command index */
 DWORD arg /* Argument */
 ) {
-    BYTE n, res;
+    BYTE n, res, buf[5];
 
     if (cmd & 0x80) { /* ACMD<n> is the command sequence of CMD55-CMD<n> */
         cmd &= 0x7F;
@@ -256,24 +412,15 @@ DWORD arg /* Argument */
     }
 
     /* Send command packet */
-    xchg_spi(0x40 | cmd);
-    /* Start + Command index */
-    xchg_spi((BYTE ) (arg >> 24));
-    /* Argument[31..24] */
-    xchg_spi((BYTE ) (arg >> 16));
-    /* Argument[23..16] */
-    xchg_spi((BYTE ) (arg >> 8));
-    /* Argument[15..8] */
-    xchg_spi((BYTE ) arg);
-    /* Argument[7..0] */
-    n = 0x01; /* Dummy CRC + Stop */
-    if (cmd == CMD0) {
-        n = 0x95; /* Valid CRC for CMD0(0) + Stop */
-    }
-    if (cmd == CMD8) {
-        n = 0x87; /* Valid CRC for CMD8(0x1AA) Stop */
-    }
-    xchg_spi(n);
+    buf[0] = 0x40 | cmd; /* Start + Command index */
+    buf[1] = (BYTE) (arg >> 24); /* Argument[31..24] */
+    buf[2] = (BYTE) (arg >> 16); /* Argument[23..16] */
+    buf[3] = (BYTE) (arg >> 8); /* Argument[15..8] */
+    buf[4] = (BYTE) arg; /* Argument[7..0] */
+    for (n = 0; n < 5; n++) {
+        xchg_spi(buf[n]);
+    }
+    xchg_spi((crc7(buf, 5) << 1) | 0x01); /* Valid CRC for all commands + Stop */
 
     /* Receive command response */
     if (cmd == CMD12) {
@@ -350,6 +497,12 @@ DSTATUS disk_initialize(BYTE pdrv /* Physical drive number (0) */
             }
         }
     }
+    CrcIsEnabled = FALSE;
+#ifdef STM32_SD_USE_CRC
+    if (ty) {
+        CrcIsEnabled = (send_cmd(CMD59, 1) == 0); /* Without CRC_ON_OFF a card does not check the CRC of written blocks */
+    }
+#endif
     CardType = ty;
     deselect();
 
@@ -527,13 +680,11 @@ void *buff /* Buffer to send/receive control data */
 
         case GET_BLOCK_SIZE: /* Get erase block size in unit of sector (DWORD) */
             if (CardType & CT_SD2) { /* SDv2? */
+                BYTE sdstat[64];
                 if (send_cmd(ACMD13, 0) == 0) { /* Read SD status */
                     xchg_spi(0xFF);
-                    if (rcvr_datablock(csd, 16)) { /* Read partial block */
-                        for (n = 64 - 16; n; n--)
-                            xchg_spi(0xFF);
-                        /* Purge trailing data */
-                        *(DWORD*) buff = 16UL << (csd[10] >> 4);
+                    if (rcvr_datablock(sdstat, 64)) { /* Read complete block, the CRC covers all 64 bytes */
+                        *(DWORD*) buff = 16UL << (sdstat[10] >> 4);
                         res = RES_OK;
                     }
                 }
@@ -682,6 +833,35 @@ void testAttachMMC(void) {
     EXTI4_IRQHandler();
 }
 
+/**
+ * Registers a function, which is called repeatedly while disk_read() and disk_write() wait for the end
+ * of a sector DMA transfer or for the card to finish programming.
+ * The function must not access the SPI1 bus and should return after some microseconds.
+ * It returns false if it has no more work to do, the DMA end is then awaited without calling it again.
+ * @param aWaitCallback NULL disables the callback
+ */
+void disk_setWaitCallback(bool (*aWaitCallback)(void)) {
+    sWaitCallback = aWaitCallback;
+}
+
+/**
+ * Does not wait for the card to finish programming the last written block.
+ * Enables the caller to do other work instead of waiting in select() of the next disk access.
+ * @return 1 if card is ready for the next command
+ */
+int isCardReady(void) {
+    if (!CardIsBusy) {
+        return 1;
+    }
+    CS_LOW();
+    xchg_spi(0xFF);
+    if (rcvr_spi() == 0xFF) {
+        CardIsBusy = FALSE;
+    }
+    deselect();
+    return CardIsBusy ? 0 : 1;
+}
+
 char StringNoCardInserted[] = "No card inserted";
 /**
  * returns 4 lines with card information
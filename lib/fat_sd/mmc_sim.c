@@ -0,0 +1,711 @@
+/*
+ * @file mmc_sim.c
+ *
+ * The card output is a queue of bytes, which is preceded by a number of 0xFF bytes for the response or read access time.
+ * Busy time is measured in SPI clocks, so polling the card for ready consumes simulated time like on the real bus.
+ * The card is a SDHC card, so the sector number is the block address.
+ * CRC is only checked for CMD0 and CMD8 or if enabled by CMD59, as specified for SPI mode.
+ * Not used by the firmware, it is excluded from the target build.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "mmc_sim.h"
+#include <stdio.h> // for snprintf
+#include <string.h> // for memset
+
+#define INPUT_COMMAND_WAIT  0 // waiting for start bit of command
+#define INPUT_COMMAND       1 // receiving the 6 command bytes
+#define INPUT_WRITE_TOKEN   2 // waiting for start block or stop tran token
+#define INPUT_WRITE_DATA    3 // receiving data block and CRC
+
+#define R1_IDLE_STATE       0x01
+#define R1_ILLEGAL_COMMAND  0x04
+#define R1_COM_CRC_ERROR    0x08
+#define R1_PARAMETER_ERROR  0x40
+
+#define TOKEN_START_BLOCK           0xFE
+#define TOKEN_START_BLOCK_MULTIPLE  0xFC
+#define TOKEN_STOP_TRAN             0xFD
+#define TOKEN_READ_ERROR            0x01 // "error" bit of the data error token
+
+#define DATA_RESPONSE_ACCEPTED      0x05
+#define DATA_RESPONSE_CRC_ERROR     0x0B
+#define DATA_RESPONSE_WRITE_ERROR   0x0D
+
+#define OUTPUT_BUFFER_SIZE  (1 + MMC_SIM_SECTOR_SIZE + 2) // token, data, CRC
+
+static const MMCSimTimingTypeDef sDefaultTiming = { 18000000, 200, 1500, 700, 300, 500, 50000, 10 };
+
+static const MMCSimImageTypeDef *sImage;
+static MMCSimTimingTypeDef sTiming;
+static MMCSimStatisticsTypeDef sStatistics;
+
+static uint64_t sClocks; // SPI clocks since init, the simulated time
+static uint64_t sClocksAtStatisticsReset;
+static uint64_t sBusyUntilClocks;
+static bool sIsSelected;
+static bool sIsIdle; // in idle state until initialization by ACMD41 finished
+static bool sAppCommandPending; // CMD55 received
+static bool sCRCEnabled;
+static uint8_t sInitializationPollsLeft;
+
+static uint8_t sInputState;
+static uint8_t sCommand[6];
+static uint8_t sCommandIndex;
+static uint16_t sWriteIndex;
+static uint8_t sWriteBuffer[MMC_SIM_SECTOR_SIZE + 2];
+
+static uint8_t sOutputBuffer[OUTPUT_BUFFER_SIZE];
+static uint16_t sOutputLength;
+static uint16_t sOutputIndex;
+static uint32_t sOutputDelayBytes; // 0xFF bytes before output
+static bool sOutputIsReadAccess; // delay is read access time
+static bool sOutputIsSector; // output is a sector data block
+
+/*
+ * What follows the current output
+ */
+static bool sReadBlockPending; // data block follows the response
+static bool sReadMultiple; // CMD18 active
+static uint32_t sReadSector;
+static uint8_t sReadSpecialBlock; // 0 for sector data, otherwise command index of CSD, CID or SD status
+static bool sWriteMultiple; // CMD25 active
+static uint32_t sWriteSector;
+static uint32_t sPreErasedBlocks; // set by ACMD23
+static uint32_t sBusyAfterOutputMicros;
+static uint32_t sEraseStartSector;
+static uint32_t sEraseEndSector;
+
+static uint8_t sFault = MMC_SIM_FAULT_NONE;
+static uint32_t sFaultCountdown;
+
+/*
+ * Memory image
+ */
+static uint8_t *sMemoryImage;
+
+static bool readMemorySector(uint32_t aSector, uint8_t *aBuffer) {
+    memcpy(aBuffer, &sMemoryImage[aSector * MMC_SIM_SECTOR_SIZE], MMC_SIM_SECTOR_SIZE);
+    return true;
+}
+
+static bool writeMemorySector(uint32_t aSector, const uint8_t *aBuffer) {
+    memcpy(&sMemoryImage[aSector * MMC_SIM_SECTOR_SIZE], aBuffer, MMC_SIM_SECTOR_SIZE);
+    return true;
+}
+
+/**
+ * @param aMemory must have aSectorCount * 512 bytes
+ */
+void MMCSim_initMemoryImage(MMCSimImageTypeDef *aImage, uint8_t *aMemory, uint32_t aSectorCount) {
+    sMemoryImage = aMemory;
+    aImage->SectorCount = aSectorCount;
+    aImage->readSector = &readMemorySector;
+    aImage->writeSector = &writeMemorySector;
+}
+
+/**
+ * Inserts the card. Resets card state, simulated time and statistics.
+ * @param aTiming if NULL, typical values are used
+ */
+void MMCSim_init(const MMCSimImageTypeDef *aImage, const MMCSimTimingTypeDef *aTiming) {
+    sImage = aImage;
+    if (aTiming == NULL) {
+        aTiming = &sDefaultTiming;
+    }
+    sTiming = *aTiming;
+    sClocks = 0;
+    sBusyUntilClocks = 0;
+    sIsSelected = false;
+    sIsIdle = true;
+    sAppCommandPending = false;
+    sCRCEnabled = false;
+    sInitializationPollsLeft = sTiming.InitializationPolls;
+    sInputState = INPUT_COMMAND_WAIT;
+    sOutputLength = 0;
+    sOutputIndex = 0;
+    sOutputDelayBytes = 0;
+    sReadBlockPending = false;
+    sReadMultiple = false;
+    sWriteMultiple = false;
+    sPreErasedBlocks = 0;
+    sBusyAfterOutputMicros = 0;
+    sFault = MMC_SIM_FAULT_NONE;
+    MMCSim_resetStatistics();
+}
+
+static uint64_t microsToClocks(uint32_t aMicros) {
+    return ((uint64_t) aMicros * sTiming.SPIClockHertz) / 1000000;
+}
+
+uint64_t MMCSim_getMicros(void) {
+    return (sClocks * 1000000) / sTiming.SPIClockHertz;
+}
+
+/**
+ * Lets time pass without bus activity, e.g. the CPU time of the code under test between card accesses.
+ * A busy card continues programming meanwhile.
+ */
+void MMCSim_advanceMicros(uint32_t aMicros) {
+    sClocks += microsToClocks(aMicros);
+}
+
+uint32_t MMCSim_getSPIClockHertz(void) {
+    return sTiming.SPIClockHertz;
+}
+
+/**
+ * @return true if CRC of commands and written data blocks is checked, i.e. CMD59 with argument 1 was received
+ */
+bool MMCSim_isCRCEnabled(void) {
+    return sCRCEnabled;
+}
+
+/**
+ * @param aFault MMC_SIM_FAULT_NONE clears pending faults and ends a stuck busy
+ * @param aCountdown number of sector transfers (or commands for MMC_SIM_FAULT_NO_RESPONSE) before the fault occurs
+ */
+void MMCSim_injectFault(uint8_t aFault, uint32_t aCountdown) {
+    sFault = aFault;
+    sFaultCountdown = aCountdown;
+    if (aFault == MMC_SIM_FAULT_NONE) {
+        sBusyUntilClocks = 0;
+    }
+}
+
+/**
+ * @return true if aFault is injected now
+ */
+static bool checkFault(uint8_t aFault) {
+    if (sFault != aFault) {
+        return false;
+    }
+    if (sFaultCountdown > 0) {
+        sFaultCountdown--;
+        return false;
+    }
+    sFault = MMC_SIM_FAULT_NONE;
+    sStatistics.FaultsInjected++;
+    return true;
+}
+
+/*
+ * A sector transfer counts down the countdown of all sector faults
+ */
+static uint8_t checkSectorFault(void) {
+    uint8_t tFault = sFault;
+    if (tFault != MMC_SIM_FAULT_NONE && tFault != MMC_SIM_FAULT_NO_RESPONSE && checkFault(tFault)) {
+        return tFault;
+    }
+    return MMC_SIM_FAULT_NONE;
+}
+
+/*
+ * CRC16 CCITT of data blocks, polynomial x^16 + x^12 + x^5 + 1
+ */
+uint16_t MMCSim_computeCRC16(const uint8_t *aData, uint16_t aLength) {
+    uint16_t tCRC = 0;
+    for (uint_fast16_t i = 0; i < aLength; ++i) {
+        tCRC ^= (uint16_t) aData[i] << 8;
+        for (uint_fast8_t j = 0; j < 8; ++j) {
+            if (tCRC & 0x8000) {
+                tCRC = (tCRC << 1) ^ 0x1021;
+            } else {
+                tCRC <<= 1;
+            }
+        }
+    }
+    return tCRC;
+}
+
+/*
+ * CRC7 of commands and registers, polynomial x^7 + x^3 + 1
+ */
+static uint8_t computeCRC7(const uint8_t *aData, uint8_t aLength) {
+    uint8_t tCRC = 0;
+    for (uint_fast8_t i = 0; i < aLength; ++i) {
+        uint8_t tByte = aData[i];
+        for (uint_fast8_t j = 0; j < 8; ++j) {
+            tCRC <<= 1;
+            if ((tByte ^ tCRC) & 0x80) {
+                tCRC ^= 0x09;
+            }
+            tByte <<= 1;
+        }
+    }
+    return tCRC & 0x7F;
+}
+
+/*
+ * Output queue
+ */
+static void startOutput(uint32_t aDelayBytes, uint16_t aLength, bool aIsReadAccess) {
+    sOutputDelayBytes = aDelayBytes;
+    sOutputLength = aLength;
+    sOutputIndex = 0;
+    sOutputIsReadAccess = aIsReadAccess;
+    sOutputIsSector = false;
+}
+
+static void clearOutput(void) {
+    sOutputLength = 0;
+    sOutputIndex = 0;
+    sOutputDelayBytes = 0;
+    sReadBlockPending = false;
+    sBusyAfterOutputMicros = 0;
+}
+
+static void fillRegisterBlock(uint8_t *aBlock) {
+    memset(aBlock, 0, 16);
+    if (sReadSpecialBlock == 9) {
+        // CSD version 2.0
+        uint32_t tCSize = 0;
+        if (sImage->SectorCount >= 1024) {
+            tCSize = (sImage->SectorCount / 1024) - 1;
+        }
+        aBlock[0] = 0x40; // CSD_STRUCTURE
+        aBlock[1] = 0x0E; // TAAC
+        aBlock[3] = 0x32; // TRAN_SPEED 25 MHz
+        aBlock[4] = 0x5B; // CCC
+        aBlock[5] = 0x59; // CCC, READ_BL_LEN 512
+        aBlock[7] = (tCSize >> 16) & 0x3F;
+        aBlock[8] = tCSize >> 8;
+        aBlock[9] = tCSize;
+        aBlock[10] = 0x7F; // ERASE_BLK_EN, SECTOR_SIZE
+        aBlock[11] = 0x80;
+        aBlock[12] = 0x0A; // R2W_FACTOR, WRITE_BL_LEN
+        aBlock[13] = 0x40;
+    } else {
+        // CID
+        memcpy(&aBlock[1], "BDSIMSD", 7); // OID and PNM
+        aBlock[8] = 0x10; // PRV 1.0
+        aBlock[12] = 0x01; // MDT 2026
+        aBlock[13] = 0xAA;
+    }
+    aBlock[15] = (computeCRC7(aBlock, 15) << 1) | 0x01;
+}
+
+/*
+ * Queues token, data and CRC of the current read sector or register
+ */
+static void startReadBlock(void) {
+    uint16_t tLength = MMC_SIM_SECTOR_SIZE;
+    uint8_t *tData = &sOutputBuffer[1];
+    bool tSuccess = true;
+    uint8_t tFault = MMC_SIM_FAULT_NONE;
+    if (sReadSpecialBlock == 0) {
+        if (sReadSector >= sImage->SectorCount) {
+            tSuccess = false;
+            sStatistics.ProtocolErrors++;
+        } else {
+            tFault = checkSectorFault();
+            tSuccess = sImage->readSector(sReadSector, tData) && tFault != MMC_SIM_FAULT_READ_ERROR_TOKEN;
+        }
+    } else if (sReadSpecialBlock == 13) {
+        // SD status
+        tLength = 64;
+        memset(tData, 0, tLength);
+        tData[10] = 0x90; // AU_SIZE 4 MB
+    } else {
+        tLength = 16;
+        fillRegisterBlock(tData);
+    }
+
+    if (!tSuccess) {
+        sOutputBuffer[0] = TOKEN_READ_ERROR;
+        startOutput(microsToClocks(sTiming.ReadAccessMicros) / 8, 1, true);
+        sReadMultiple = false;
+        return;
+    }
+    sOutputBuffer[0] = TOKEN_START_BLOCK;
+    uint16_t tCRC = MMCSim_computeCRC16(tData, tLength);
+    if (tFault == MMC_SIM_FAULT_READ_CRC) {
+        tCRC ^= 0x0001;
+    }
+    tData[tLength] = tCRC >> 8;
+    tData[tLength + 1] = tCRC;
+    startOutput(microsToClocks(sTiming.ReadAccessMicros) / 8, 1 + tLength + 2, true);
+    sOutputIsSector = (sReadSpecialBlock == 0);
+}
+
+/*
+ * Called after the last byte of the output queue was sent
+ */
+static void outputCompleted(void) {
+    sOutputLength = 0;
+    if (sOutputIsSector) {
+        // sector is only counted if completely read, not if the prefetch of a multiple block read was stopped
+        sStatistics.SectorsRead++;
+    }
+    if (sBusyAfterOutputMicros > 0) {
+        sBusyUntilClocks = sClocks + microsToClocks(sBusyAfterOutputMicros);
+        sBusyAfterOutputMicros = 0;
+    }
+    if (sReadBlockPending) {
+        sReadBlockPending = false;
+        startReadBlock();
+    } else if (sReadMultiple) {
+        if (sReadSector + 1 < sImage->SectorCount) {
+            sReadSector++;
+            startReadBlock();
+        } else {
+            sReadMultiple = false;
+        }
+    }
+}
+
+static uint8_t getOutputByte(void) {
+    if (sOutputDelayBytes > 0) {
+        sOutputDelayBytes--;
+        if (sOutputIsReadAccess) {
+            sStatistics.ReadAccessBytes++;
+        }
+        return 0xFF;
+    }
+    if (sOutputIndex < sOutputLength) {
+        uint8_t tByte = sOutputBuffer[sOutputIndex++];
+        if (sOutputIndex == sOutputLength) {
+            outputCompleted();
+        }
+        return tByte;
+    }
+    return 0xFF;
+}
+
+/*
+ * Queues R1 and aNumberOfTrailingBytes of sOutputBuffer[1..], response time is one byte
+ */
+static void startResponse(uint8_t aR1, uint8_t aNumberOfTrailingBytes) {
+    sOutputBuffer[0] = aR1;
+    startOutput(1, 1 + aNumberOfTrailingBytes, false);
+}
+
+static void executeCommand(void) {
+    uint8_t tCommandIndex = sCommand[0] & 0x3F;
+    uint32_t tArgument = ((uint32_t) sCommand[1] << 24) | ((uint32_t) sCommand[2] << 16) | ((uint32_t) sCommand[3] << 8) | sCommand[4];
+    bool tIsAppCommand = sAppCommandPending;
+    sAppCommandPending = false;
+    sStatistics.Commands++;
+
+    clearOutput();
+    // a new command ends a multiple block read, only CMD12 is valid then
+    if (sReadMultiple && tCommandIndex != 12) {
+        sStatistics.ProtocolErrors++;
+    }
+    sReadMultiple = false;
+    sReadSpecialBlock = 0;
+
+    if (checkFault(MMC_SIM_FAULT_NO_RESPONSE)) {
+        return;
+    }
+
+    uint8_t tR1 = sIsIdle ? R1_IDLE_STATE : 0;
+    if ((tCommandIndex == 0 || tCommandIndex == 8 || sCRCEnabled) && computeCRC7(sCommand, 5) != (sCommand[5] >> 1)) {
+        sStatistics.CRCErrors++;
+        startResponse(tR1 | R1_COM_CRC_ERROR, 0);
+        return;
+    }
+
+    if (sIsIdle && !(tCommandIndex == 0 || tCommandIndex == 1 || tCommandIndex == 8 || tCommandIndex == 55 || tCommandIndex == 58
+            || tCommandIndex == 59 || (tIsAppCommand && tCommandIndex == 41))) {
+        sStatistics.ProtocolErrors++;
+        startResponse(tR1 | R1_ILLEGAL_COMMAND, 0);
+        return;
+    }
+
+    uint8_t tNumberOfTrailingBytes = 0;
+    switch (tCommandIndex) {
+    case 0: // GO_IDLE_STATE
+        sIsIdle = true;
+        sInitializationPollsLeft = sTiming.InitializationPolls;
+        tR1 = R1_IDLE_STATE;
+        break;
+    case 1: // SEND_OP_COND (MMC)
+    case 41: // SD_SEND_OP_COND (SDC)
+        if (tCommandIndex == 41 && !tIsAppCommand) {
+            tR1 |= R1_ILLEGAL_COMMAND;
+            sStatistics.ProtocolErrors++;
+        } else if (sInitializationPollsLeft > 0) {
+            sInitializationPollsLeft--;
+        } else {
+            sIsIdle = false;
+            tR1 = 0;
+        }
+        break;
+    case 8: // SEND_IF_COND, R7 echoes voltage and check pattern
+        sOutputBuffer[1] = 0x00;
+        sOutputBuffer[2] = 0x00;
+        sOutputBuffer[3] = (tArgument >> 8) & 0x0F;
+        sOutputBuffer[4] = tArgument;
+        tNumberOfTrailingBytes = 4;
+        break;
+    case 9: // SEND_CSD
+    case 10: // SEND_CID
+        sReadSpecialBlock = tCommandIndex;
+        sReadBlockPending = true;
+        break;
+    case 12: // STOP_TRANSMISSION
+        break;
+    case 13: // SEND_STATUS or SD_STATUS
+        sOutputBuffer[1] = 0x00;
+        tNumberOfTrailingBytes = 1;
+        if (tIsAppCommand) {
+            sReadSpecialBlock = 13;
+            sReadBlockPending = true;
+        }
+        break;
+    case 16: // SET_BLOCKLEN
+        if (tArgument != MMC_SIM_SECTOR_SIZE) {
+            tR1 |= R1_PARAMETER_ERROR;
+        }
+        break;
+    case 17: // READ_SINGLE_BLOCK
+    case 18: // READ_MULTIPLE_BLOCK
+        if (tArgument >= sImage->SectorCount) {
+            tR1 |= R1_PARAMETER_ERROR;
+            sStatistics.ProtocolErrors++;
+            break;
+        }
+        sReadSector = tArgument;
+        sReadBlockPending = true;
+        if (tCommandIndex == 17) {
+            sStatistics.SingleBlockReads++;
+        } else {
+            sReadMultiple = true;
+            sStatistics.MultipleBlockReads++;
+        }
+        break;
+    case 23: // SET_WR_BLK_ERASE_COUNT
+        if (tIsAppCommand) {
+            sPreErasedBlocks = tArgument & 0x7FFFFF;
+            sStatistics.PreEraseCommands++;
+        } else {
+            tR1 |= R1_ILLEGAL_COMMAND;
+        }
+        break;
+    case 24: // WRITE_BLOCK
+    case 25: // WRITE_MULTIPLE_BLOCK
+        if (tArgument >= sImage->SectorCount) {
+            tR1 |= R1_PARAMETER_ERROR;
+            sStatistics.ProtocolErrors++;
+            break;
+        }
+        sWriteSector = tArgument;
+        sWriteMultiple = (tCommandIndex == 25);
+        if (sWriteMultiple) {
+            sStatistics.MultipleBlockWrites++;
+        } else {
+            sStatistics.SingleBlockWrites++;
+        }
+        sInputState = INPUT_WRITE_TOKEN;
+        break;
+    case 32: // ERASE_WR_BLK_START
+        sEraseStartSector = tArgument;
+        break;
+    case 33: // ERASE_WR_BLK_END
+        sEraseEndSector = tArgument;
+        break;
+    case 38: // ERASE, content of erased sectors is not changed
+        if (sEraseEndSector < sEraseStartSector || sEraseEndSector >= sImage->SectorCount) {
+            tR1 |= R1_PARAMETER_ERROR;
+        } else {
+            sBusyAfterOutputMicros = sTiming.EraseBusyMicros;
+        }
+        break;
+    case 55: // APP_CMD
+        sAppCommandPending = true;
+        break;
+    case 58: // READ_OCR, power up finished and card capacity status (block addressing)
+        sOutputBuffer[1] = sIsIdle ? 0x40 : 0xC0;
+        sOutputBuffer[2] = 0xFF;
+        sOutputBuffer[3] = 0x80;
+        sOutputBuffer[4] = 0x00;
+        tNumberOfTrailingBytes = 4;
+        break;
+    case 59: // CRC_ON_OFF
+        sCRCEnabled = tArgument & 0x01;
+        break;
+    default:
+        tR1 |= R1_ILLEGAL_COMMAND;
+        sStatistics.ProtocolErrors++;
+        break;
+    }
+    if (tR1 & (R1_ILLEGAL_COMMAND | R1_PARAMETER_ERROR)) {
+        sReadBlockPending = false;
+        sReadMultiple = false;
+        sInputState = INPUT_COMMAND_WAIT;
+    }
+    startResponse(tR1, tNumberOfTrailingBytes);
+}
+
+/*
+ * Data block and CRC received, send data response and start busy
+ */
+static void finishWriteBlock(void) {
+    uint8_t tResponse = DATA_RESPONSE_ACCEPTED;
+    uint16_t tCRC = (sWriteBuffer[MMC_SIM_SECTOR_SIZE] << 8) | sWriteBuffer[MMC_SIM_SECTOR_SIZE + 1];
+    uint8_t tFault = checkSectorFault();
+    if ((sCRCEnabled && MMCSim_computeCRC16(sWriteBuffer, MMC_SIM_SECTOR_SIZE) != tCRC) || tFault == MMC_SIM_FAULT_WRITE_CRC_ERROR) {
+        sStatistics.CRCErrors++;
+        tResponse = DATA_RESPONSE_CRC_ERROR;
+    } else if (sWriteSector >= sImage->SectorCount || tFault == MMC_SIM_FAULT_WRITE_ERROR
+            || !sImage->writeSector(sWriteSector, sWriteBuffer)) {
+        tResponse = DATA_RESPONSE_WRITE_ERROR;
+    } else {
+        sStatistics.SectorsWritten++;
+    }
+
+    uint32_t tBusyMicros = sTiming.WriteBusyMicros;
+    if (sWriteMultiple) {
+        if (sPreErasedBlocks > 0) {
+            sPreErasedBlocks--;
+            tBusyMicros = sTiming.MultiWritePreErasedBusyMicros;
+        } else {
+            tBusyMicros = sTiming.MultiWriteBusyMicros;
+        }
+        sWriteSector++;
+        sInputState = INPUT_WRITE_TOKEN;
+    } else {
+        sInputState = INPUT_COMMAND_WAIT;
+    }
+    if (tFault == MMC_SIM_FAULT_STUCK_BUSY) {
+        tBusyMicros = UINT32_MAX; // more than an hour
+    }
+    sOutputBuffer[0] = tResponse | 0xE0;
+    startOutput(0, 1, false);
+    sBusyAfterOutputMicros = tBusyMicros;
+}
+
+static void processInputByte(uint8_t aByte) {
+    switch (sInputState) {
+    case INPUT_WRITE_TOKEN:
+        if ((aByte == TOKEN_START_BLOCK && !sWriteMultiple) || (aByte == TOKEN_START_BLOCK_MULTIPLE && sWriteMultiple)) {
+            sWriteIndex = 0;
+            sInputState = INPUT_WRITE_DATA;
+            break;
+        }
+        if (aByte == TOKEN_STOP_TRAN && sWriteMultiple) {
+            sWriteMultiple = false;
+            sPreErasedBlocks = 0;
+            sInputState = INPUT_COMMAND_WAIT;
+            sBusyUntilClocks = sClocks + microsToClocks(sTiming.StopTransmissionBusyMicros);
+            break;
+        }
+        if (aByte == 0xFF) {
+            break;
+        }
+        if ((aByte & 0xC0) != 0x40) {
+            sStatistics.ProtocolErrors++;
+            break;
+        }
+        // command instead of token aborts the write
+        sWriteMultiple = false;
+        sInputState = INPUT_COMMAND_WAIT;
+        /* fall through */
+    case INPUT_COMMAND_WAIT:
+        if ((aByte & 0xC0) == 0x40) {
+            sCommand[0] = aByte;
+            sCommandIndex = 1;
+            sInputState = INPUT_COMMAND;
+        }
+        break;
+    case INPUT_COMMAND:
+        sCommand[sCommandIndex++] = aByte;
+        if (sCommandIndex == sizeof(sCommand)) {
+            sInputState = INPUT_COMMAND_WAIT;
+            executeCommand();
+        }
+        break;
+    case INPUT_WRITE_DATA:
+        sWriteBuffer[sWriteIndex++] = aByte;
+        if (sWriteIndex == sizeof(sWriteBuffer)) {
+            finishWriteBlock();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * The card keeps its state while it is deselected, e.g. busy or a multiple block transfer.
+ */
+void MMCSim_setChipSelect(bool aSelected) {
+    sIsSelected = aSelected;
+    if (aSelected && sInputState == INPUT_COMMAND) {
+        // incomplete command is discarded
+        sInputState = INPUT_COMMAND_WAIT;
+    }
+}
+
+/**
+ * Simulates one full duplex SPI byte transfer
+ * @return byte sent by the card
+ */
+uint8_t MMCSim_exchange(uint8_t aByte) {
+    sClocks += 8;
+    sStatistics.BytesExchanged++;
+    if (!sIsSelected) {
+        return 0xFF;
+    }
+    if (sClocks < sBusyUntilClocks) {
+        sStatistics.BusyBytes++;
+        return 0x00;
+    }
+    uint8_t tOutput = getOutputByte();
+    processInputByte(aByte);
+    return tOutput;
+}
+
+/**
+ * Simulates a DMA transfer of aLength bytes
+ * @param aTransmitBuffer NULL sends 0xFF
+ * @param aReceiveBuffer NULL discards the received bytes
+ */
+void MMCSim_exchangeBlock(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength) {
+    sStatistics.BlockExchanges++;
+    sStatistics.BlockBytesExchanged += aLength;
+    for (uint16_t i = 0; i < aLength; ++i) {
+        uint8_t tByte = MMCSim_exchange((aTransmitBuffer == NULL) ? 0xFF : aTransmitBuffer[i]);
+        if (aReceiveBuffer != NULL) {
+            aReceiveBuffer[i] = tByte;
+        }
+    }
+}
+
+void MMCSim_resetStatistics(void) {
+    memset(&sStatistics, 0, sizeof(sStatistics));
+    sClocksAtStatisticsReset = sClocks;
+}
+
+const MMCSimStatisticsTypeDef * MMCSim_getStatistics(void) {
+    return &sStatistics;
+}
+
+/**
+ * Prints sector counts, single block ratio and simulated bus time since the last reset of the statistics
+ * @param aOperationName e.g. "storeScreenshot"
+ * @return number of chars written
+ */
+int MMCSim_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer, const char *aOperationName) {
+    uint32_t tSingleBlockSectors = sStatistics.SingleBlockReads + sStatistics.SingleBlockWrites;
+    uint32_t tSectors = sStatistics.SectorsRead + sStatistics.SectorsWritten;
+    uint32_t tSinglePercent = 0;
+    if (tSectors > 0) {
+        tSinglePercent = (tSingleBlockSectors * 100) / tSectors;
+    }
+    uint32_t tMicros = ((sClocks - sClocksAtStatisticsReset) * 1000000) / sTiming.SPIClockHertz;
+    return snprintf(aStringBuffer, aSizeOfStringBuffer,
+            "%s: read %lu sectors by %lu CMD17 + %lu CMD18, written %lu sectors by %lu CMD24 + %lu CMD25 (%lu ACMD23)\n"
+                    "%lu%% single block, %lu commands, %lu busy bytes, %lu read access bytes, %lu us\n", aOperationName,
+            (unsigned long) sStatistics.SectorsRead, (unsigned long) sStatistics.SingleBlockReads,
+            (unsigned long) sStatistics.MultipleBlockReads, (unsigned long) sStatistics.SectorsWritten,
+            (unsigned long) sStatistics.SingleBlockWrites, (unsigned long) sStatistics.MultipleBlockWrites,
+            (unsigned long) sStatistics.PreEraseCommands, (unsigned long) tSinglePercent, (unsigned long) sStatistics.Commands,
+            (unsigned long) sStatistics.BusyBytes, (unsigned long) sStatistics.ReadAccessBytes, (unsigned long) tMicros);
+}
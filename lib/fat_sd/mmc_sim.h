@@ -0,0 +1,117 @@
+/*
+ * @file mmc_sim.h
+ *
+ * SPI level simulation of a SDv2 block addressed card (SDHC) for running ff.c and mmc.c on a host.
+ * Simulates the SPI mode command set used by mmc.c, single and multiple block transfers,
+ * read access time and programming busy time, and injection of faults.
+ * The card content is provided by a disk image back end.
+ * Contains no HAL code.
+ *
+ * Connecting mmc.c to the simulator requires only host versions of the platform functions it calls:
+ * SPI1_sendReceiveFast() -> MMCSim_exchange()
+ * SPI1_DMA_startTransfer() -> MMCSim_exchangeBlock()
+ * MICROSD_CSEnable() / MICROSD_CSDisable() -> MMCSim_setChipSelect(true / false)
+ * millis() -> MMCSim_getMicros() / 1000, so all timeouts of mmc.c run on simulated time.
+ * The simulated time is the time of the SPI clock, it does not contain the CPU time of the host.
+ * CPU time of the simulated target can be added by MMCSim_advanceMicros().
+ * These platform functions are in extras/host/hostPlatform.c, see extras/MMCSimBenchmark.c for a host build.
+ *
+ * Benchmark of a file operation: MMCSim_resetStatistics(), run the operation, then MMCSim_printStatistics().
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef MMC_SIM_H_
+#define MMC_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define MMC_SIM_SECTOR_SIZE 512
+
+/*
+ * Disk image back end
+ */
+typedef struct {
+    uint32_t SectorCount; // the card reports a multiple of 1024 sectors, the C_SIZE granularity of CSD version 2
+    bool (*readSector)(uint32_t aSector, uint8_t *aBuffer);
+    bool (*writeSector)(uint32_t aSector, const uint8_t *aBuffer);
+} MMCSimImageTypeDef;
+
+/*
+ * Timing model. Typical values of a class 4 card are used if NULL is given to MMCSim_init().
+ */
+typedef struct {
+    uint32_t SPIClockHertz;
+    uint32_t ReadAccessMicros; // from command or end of previous block to data token
+    uint32_t WriteBusyMicros; // programming time after a single block write
+    uint32_t MultiWriteBusyMicros; // programming time of a block of a multiple block write
+    uint32_t MultiWritePreErasedBusyMicros; // the same, if the blocks were pre-erased by ACMD23
+    uint32_t StopTransmissionBusyMicros; // busy time after stop tran token of a multiple block write
+    uint32_t EraseBusyMicros;
+    uint8_t InitializationPolls; // number of ACMD41 answered with idle state
+} MMCSimTimingTypeDef;
+
+/*
+ * Faults. The sector faults occur once at the transfer of the sector specified by the countdown of MMCSim_injectFault().
+ */
+#define MMC_SIM_FAULT_NONE              0
+#define MMC_SIM_FAULT_READ_ERROR_TOKEN  1 // data error token instead of start block token
+#define MMC_SIM_FAULT_READ_CRC          2 // wrong CRC appended to the read data block
+#define MMC_SIM_FAULT_WRITE_CRC_ERROR   3 // data response "rejected due to CRC error"
+#define MMC_SIM_FAULT_WRITE_ERROR       4 // data response "rejected due to write error"
+#define MMC_SIM_FAULT_STUCK_BUSY        5 // busy never ends after writing the sector, until fault is cleared
+#define MMC_SIM_FAULT_NO_RESPONSE       6 // command is not answered, countdown is counted in commands
+
+typedef struct {
+    uint32_t Commands;
+    uint32_t SingleBlockReads; // CMD17
+    uint32_t MultipleBlockReads; // CMD18
+    uint32_t SectorsRead; // by CMD17 and CMD18
+    uint32_t SingleBlockWrites; // CMD24
+    uint32_t MultipleBlockWrites; // CMD25
+    uint32_t SectorsWritten; // by CMD24 and CMD25
+    uint32_t PreEraseCommands; // ACMD23
+    uint32_t ReadAccessBytes; // 0xFF bytes clocked while waiting for data token
+    uint32_t BusyBytes; // bytes clocked while card was busy
+    uint32_t CRCErrors; // wrong CRC of received commands or data blocks (if CRC is enabled by CMD59)
+    uint32_t ProtocolErrors; // illegal commands or parameters
+    uint32_t FaultsInjected;
+    uint64_t BytesExchanged;
+    uint32_t BlockExchanges; // DMA transfers by MMCSim_exchangeBlock()
+    uint64_t BlockBytesExchanged; // part of BytesExchanged
+} MMCSimStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void MMCSim_init(const MMCSimImageTypeDef *aImage, const MMCSimTimingTypeDef *aTiming);
+void MMCSim_initMemoryImage(MMCSimImageTypeDef *aImage, uint8_t *aMemory, uint32_t aSectorCount);
+
+void MMCSim_setChipSelect(bool aSelected);
+uint8_t MMCSim_exchange(uint8_t aByte);
+void MMCSim_exchangeBlock(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength);
+uint64_t MMCSim_getMicros(void);
+void MMCSim_advanceMicros(uint32_t aMicros);
+uint32_t MMCSim_getSPIClockHertz(void);
+bool MMCSim_isCRCEnabled(void);
+
+void MMCSim_injectFault(uint8_t aFault, uint32_t aCountdown);
+
+void MMCSim_resetStatistics(void);
+const MMCSimStatisticsTypeDef * MMCSim_getStatistics(void);
+int MMCSim_printStatistics(char *aStringBuffer, size_t aSizeOfStringBuffer, const char *aOperationName);
+
+uint16_t MMCSim_computeCRC16(const uint8_t *aData, uint16_t aLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MMC_SIM_H_ */
@@ -0,0 +1,596 @@
+/*
+ * @file sampleHistory.c
+ *
+ * Delta / varint compressed 2 channel sample history with spill of full blocks to the card.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "sampleHistory.h"
+#include "writeBehind.h"
+#include "diskio.h"
+
+#include <string.h> // for memcpy
+
+#define CODE_ESCAPE 0x80
+#define CODE_REPEAT_MAX 0xFF
+#define NO_CODE 0xFFFF
+#define BLOCK_DATA_SIZE (SAMPLE_HISTORY_BLOCK_SIZE - SAMPLE_HISTORY_BLOCK_HEADER_SIZE)
+#define RAM_BLOCK_MASK (SAMPLE_HISTORY_RAM_BLOCKS - 1)
+
+/*
+ * Cache for one block read from a history file
+ */
+static SampleHistoryBlockTypeDef sCacheBlock;
+static SampleHistoryTypeDef *sCacheHistory; // NULL -> cache is empty
+static uint16_t sCacheBlockNumber;
+
+static SampleHistoryStatisticsTypeDef sStatistics;
+
+/*
+ * State of copying the spilled blocks to a stored history file, which is done by WriteBehind_service()
+ */
+static struct {
+    SampleHistoryTypeDef *History;
+    uint16_t BlockNumber;
+    uint16_t ByteIndex; // in block
+    FRESULT Result; // first error of reading history file
+} sCopy;
+
+static uint8_t encodeVarint(uint8_t *aBuffer, int32_t aDelta) {
+    uint32_t tValue = ((uint32_t) aDelta << 1) ^ (uint32_t) (aDelta >> 31); // zigzag
+    uint8_t tLength = 0;
+    while (tValue >= 0x80) {
+        aBuffer[tLength++] = tValue | 0x80;
+        tValue >>= 7;
+    }
+    aBuffer[tLength++] = tValue;
+    return tLength;
+}
+
+static int32_t decodeVarint(const uint8_t *aBuffer, uint16_t *aIndex) {
+    uint32_t tValue = 0;
+    uint8_t tShift = 0;
+    uint8_t tByte;
+    do {
+        tByte = aBuffer[(*aIndex)++];
+        tValue |= (uint32_t) (tByte & 0x7F) << tShift;
+        tShift += 7;
+    } while ((tByte & 0x80) && tShift < 21);
+    return (int32_t) (tValue >> 1) ^ -(int32_t) (tValue & 0x01);
+}
+
+/*
+ * Sets the file name and clears the history
+ */
+void SampleHistory_init(SampleHistoryTypeDef *aHistory, const TCHAR *aFileName) {
+    memset(aHistory, 0, sizeof(SampleHistoryTypeDef));
+    strncpy(aHistory->FileName, aFileName, SAMPLE_HISTORY_FILE_NAME_SIZE - 1);
+    SampleHistory_clear(aHistory);
+}
+
+/**
+ * Discards all samples. A spill in progress is completed, but its result is ignored.
+ * The history file is overwritten by the next spill.
+ */
+void SampleHistory_clear(SampleHistoryTypeDef *aHistory) {
+    aHistory->IsSpillCanceled = aHistory->IsSpilling;
+    aHistory->SampleCount = 0;
+    aHistory->BlockCount = 0;
+    aHistory->FirstRAMBlock = 0;
+    aHistory->SpillResult = FR_OK;
+    aHistory->LastCodeIndex = NO_CODE;
+    if (sCacheHistory == aHistory) {
+        sCacheHistory = NULL;
+    }
+}
+
+static void updateEnvelope(SampleHistoryEnvelopeTypeDef *aEnvelope, uint16_t aValue0, uint16_t aValue1) {
+    if (aValue0 < aEnvelope->Min[0]) {
+        aEnvelope->Min[0] = aValue0;
+    } else if (aValue0 > aEnvelope->Max[0]) {
+        aEnvelope->Max[0] = aValue0;
+    }
+    if (aValue1 < aEnvelope->Min[1]) {
+        aEnvelope->Min[1] = aValue1;
+    } else if (aValue1 > aEnvelope->Max[1]) {
+        aEnvelope->Max[1] = aValue1;
+    }
+}
+
+/**
+ * Must be called after the structure was read from a file.
+ * The structure may have been stored while samples were appended, so the last block is closed
+ * and the next appended sample starts a new block.
+ * Blocks which were spilled are read from the history file, if it still exists.
+ */
+void SampleHistory_restore(SampleHistoryTypeDef *aHistory) {
+    aHistory->IsSpilling = false;
+    aHistory->IsSpillCanceled = false;
+    aHistory->SpillResult = FR_OK;
+    aHistory->LastCodeIndex = NO_CODE;
+    if (sCacheHistory == aHistory) {
+        sCacheHistory = NULL;
+    }
+    if (aHistory->SampleCount == 0) {
+        SampleHistory_clear(aHistory);
+        return;
+    }
+    while (aHistory->BlockCount > 1 && aHistory->BlockFirstSample[aHistory->BlockCount - 1] >= aHistory->SampleCount) {
+        aHistory->BlockCount--;
+    }
+    aHistory->Blocks[(aHistory->BlockCount - 1) & RAM_BLOCK_MASK].UsedBytes = BLOCK_DATA_SIZE;
+    /*
+     * The envelope of the last block may contain samples appended after SampleCount was stored, so compute it again
+     */
+    SampleHistoryCursorTypeDef tCursor;
+    uint16_t tBlockNumber = aHistory->BlockCount - 1;
+    SampleHistoryEnvelopeTypeDef *tEnvelope = &aHistory->BlockEnvelopes[tBlockNumber];
+    if (SampleHistory_seek(&tCursor, aHistory, aHistory->BlockFirstSample[tBlockNumber]) == FR_OK
+            && SampleHistory_next(&tCursor) == FR_OK) {
+        tEnvelope->Min[0] = tCursor.Values[0];
+        tEnvelope->Max[0] = tCursor.Values[0];
+        tEnvelope->Min[1] = tCursor.Values[1];
+        tEnvelope->Max[1] = tCursor.Values[1];
+        while (SampleHistory_next(&tCursor) == FR_OK) {
+            updateEnvelope(tEnvelope, tCursor.Values[0], tCursor.Values[1]);
+        }
+    }
+}
+
+/*
+ * @return false if the block index is full or all RAM blocks are used
+ */
+static bool startBlock(SampleHistoryTypeDef *aHistory, uint16_t aValue0, uint16_t aValue1) {
+    if (aHistory->BlockCount >= SAMPLE_HISTORY_MAX_BLOCKS
+            || aHistory->BlockCount - aHistory->FirstRAMBlock >= SAMPLE_HISTORY_RAM_BLOCKS) {
+        return false;
+    }
+    SampleHistoryBlockTypeDef *tBlock = &aHistory->Blocks[aHistory->BlockCount & RAM_BLOCK_MASK];
+    tBlock->FirstSampleIndex = aHistory->SampleCount;
+    tBlock->SampleCount = 1;
+    tBlock->UsedBytes = 0;
+    tBlock->FirstValues[0] = aValue0;
+    tBlock->FirstValues[1] = aValue1;
+    SampleHistoryEnvelopeTypeDef *tEnvelope = &aHistory->BlockEnvelopes[aHistory->BlockCount];
+    tEnvelope->Min[0] = aValue0;
+    tEnvelope->Max[0] = aValue0;
+    tEnvelope->Min[1] = aValue1;
+    tEnvelope->Max[1] = aValue1;
+    aHistory->BlockFirstSample[aHistory->BlockCount] = aHistory->SampleCount;
+    aHistory->LastCodeIndex = NO_CODE;
+    // block is valid now
+    aHistory->BlockCount++;
+    return true;
+}
+
+/**
+ * Appends one sample. May be called by an interrupt.
+ * The sample is completely stored before SampleCount is incremented, so readers only see complete samples.
+ * @return false if history is full. Then the RAM blocks could not be spilled fast enough or there is no card.
+ */
+bool SampleHistory_append(SampleHistoryTypeDef *aHistory, uint16_t aValue0, uint16_t aValue1) {
+    if (aHistory->SampleCount >= SAMPLE_HISTORY_MAX_SAMPLES) {
+        return false;
+    }
+    if (aHistory->BlockCount == 0) {
+        if (!startBlock(aHistory, aValue0, aValue1)) {
+            return false;
+        }
+    } else {
+        SampleHistoryBlockTypeDef *tBlock = &aHistory->Blocks[(aHistory->BlockCount - 1) & RAM_BLOCK_MASK];
+        int32_t tDelta0 = (int32_t) aValue0 - aHistory->LastValues[0];
+        int32_t tDelta1 = (int32_t) aValue1 - aHistory->LastValues[1];
+        uint8_t tCode[7];
+        uint8_t tLength = 1;
+        if (tDelta0 == 0 && tDelta1 == 0) {
+            if (aHistory->LastCodeIndex != NO_CODE && tBlock->Data[aHistory->LastCodeIndex] > CODE_ESCAPE
+                    && tBlock->Data[aHistory->LastCodeIndex] < CODE_REPEAT_MAX) {
+                // extend repeat code
+                tBlock->Data[aHistory->LastCodeIndex]++;
+                tLength = 0;
+            } else {
+                tCode[0] = CODE_ESCAPE + 1;
+            }
+        } else if (tDelta0 >= -8 && tDelta0 <= 7 && tDelta1 >= -4 && tDelta1 <= 3) {
+            tCode[0] = ((tDelta0 + 8) << 3) | (tDelta1 + 4);
+        } else {
+            tCode[0] = CODE_ESCAPE;
+            tLength += encodeVarint(&tCode[tLength], tDelta0);
+            tLength += encodeVarint(&tCode[tLength], tDelta1);
+        }
+
+        if (tBlock->UsedBytes + tLength > BLOCK_DATA_SIZE) {
+            if (!startBlock(aHistory, aValue0, aValue1)) {
+                return false;
+            }
+        } else {
+            if (tLength > 0) {
+                memcpy(&tBlock->Data[tBlock->UsedBytes], tCode, tLength);
+                aHistory->LastCodeIndex = tBlock->UsedBytes;
+                tBlock->UsedBytes += tLength;
+            }
+            tBlock->SampleCount++;
+            updateEnvelope(&aHistory->BlockEnvelopes[aHistory->BlockCount - 1], aValue0, aValue1);
+        }
+    }
+    aHistory->LastValues[0] = aValue0;
+    aHistory->LastValues[1] = aValue1;
+    aHistory->SampleCount++;
+    return true;
+}
+
+/*
+ * Is called by WriteBehind_service() after the history file is closed
+ */
+static void spillCompleted(FRESULT aResult, void *aContext) {
+    SampleHistoryTypeDef *tHistory = (SampleHistoryTypeDef *) aContext;
+    tHistory->IsSpilling = false;
+    if (tHistory->IsSpillCanceled) {
+        tHistory->IsSpillCanceled = false;
+        return;
+    }
+    tHistory->SpillResult = aResult;
+    if (aResult == FR_OK) {
+        // blocks can be reused now
+        tHistory->FirstRAMBlock += tHistory->SpillBlockCount;
+        sStatistics.BlocksSpilled += tHistory->SpillBlockCount;
+    } else {
+        tHistory->SpillErrorBlockCount = tHistory->BlockCount;
+        sStatistics.SpillErrors++;
+        sStatistics.LastError = aResult;
+    }
+}
+
+/**
+ * Queues the oldest full blocks for writing to the history file, if less than SAMPLE_HISTORY_SPILL_FREE_BLOCKS RAM blocks are free.
+ * The blocks are written by reference and freed by the close callback.
+ * Must be called from the main loop, which also calls WriteBehind_service().
+ */
+void SampleHistory_service(SampleHistoryTypeDef *aHistory) {
+    if (aHistory->IsSpilling
+            || aHistory->BlockCount - aHistory->FirstRAMBlock <= SAMPLE_HISTORY_RAM_BLOCKS - SAMPLE_HISTORY_SPILL_FREE_BLOCKS
+            || (aHistory->SpillResult != FR_OK && aHistory->SpillErrorBlockCount == aHistory->BlockCount)
+            || (disk_status(0) & STA_NOINIT)) {
+        return;
+    }
+    // the last block is still filled
+    uint16_t tBlocks = aHistory->BlockCount - 1 - aHistory->FirstRAMBlock;
+    if (tBlocks > SAMPLE_HISTORY_MAX_SPILL_BLOCKS) {
+        tBlocks = SAMPLE_HISTORY_MAX_SPILL_BLOCKS;
+    }
+    uint8_t tFileHandle = WriteBehind_openAt(aHistory->FileName, (DWORD) aHistory->FirstRAMBlock * SAMPLE_HISTORY_BLOCK_SIZE);
+    if (tFileHandle == WRITE_BEHIND_INVALID_HANDLE) {
+        return;
+    }
+    uint16_t i;
+    for (i = 0; i < tBlocks; ++i) {
+        if (!WriteBehind_writeReference(tFileHandle, &aHistory->Blocks[(aHistory->FirstRAMBlock + i) & RAM_BLOCK_MASK],
+        SAMPLE_HISTORY_BLOCK_SIZE)) {
+            break;
+        }
+    }
+    aHistory->SpillBlockCount = i;
+    aHistory->IsSpilling = true;
+    aHistory->IsSpillCanceled = false;
+    WriteBehind_close(tFileHandle, &spillCompleted, aHistory);
+}
+
+/*
+ * @return RAM block or block read from history file into the cache. NULL if file could not be read.
+ */
+static const SampleHistoryBlockTypeDef * getBlock(SampleHistoryTypeDef *aHistory, uint16_t aBlockNumber, FRESULT *aResult) {
+    if (aBlockNumber >= aHistory->FirstRAMBlock) {
+        return &aHistory->Blocks[aBlockNumber & RAM_BLOCK_MASK];
+    }
+    if (sCacheHistory == aHistory && sCacheBlockNumber == aBlockNumber) {
+        return &sCacheBlock;
+    }
+    sCacheHistory = NULL;
+    FIL tFile;
+    UINT tCount;
+    FRESULT tResult = f_open(&tFile, aHistory->FileName, FA_OPEN_EXISTING | FA_READ);
+    if (tResult == FR_OK) {
+        tResult = f_lseek(&tFile, (DWORD) aBlockNumber * SAMPLE_HISTORY_BLOCK_SIZE);
+        if (tResult == FR_OK) {
+            tResult = f_read(&tFile, &sCacheBlock, SAMPLE_HISTORY_BLOCK_SIZE, &tCount);
+            if (tResult == FR_OK && tCount != SAMPLE_HISTORY_BLOCK_SIZE) {
+                tResult = FR_INT_ERR; // file is too short
+            }
+        }
+        f_close(&tFile);
+    }
+    if (tResult != FR_OK) {
+        sStatistics.LastError = tResult;
+        *aResult = tResult;
+        return NULL;
+    }
+    sStatistics.BlocksLoaded++;
+    sCacheHistory = aHistory;
+    sCacheBlockNumber = aBlockNumber;
+    return &sCacheBlock;
+}
+
+/**
+ * Decodes the next sample into aCursor->Values.
+ * @return FR_INVALID_PARAMETER if all samples are read
+ */
+FRESULT SampleHistory_next(SampleHistoryCursorTypeDef *aCursor) {
+    SampleHistoryTypeDef *tHistory = aCursor->History;
+    if (aCursor->SampleIndex >= tHistory->SampleCount) {
+        return FR_INVALID_PARAMETER;
+    }
+    if (aCursor->BlockNumber + 1 < tHistory->BlockCount
+            && aCursor->SampleIndex >= tHistory->BlockFirstSample[aCursor->BlockNumber + 1]) {
+        aCursor->BlockNumber++;
+        aCursor->SampleInBlock = 0;
+        aCursor->ByteIndex = 0;
+        aCursor->RepeatsDone = 0;
+    }
+    FRESULT tResult = FR_OK;
+    const SampleHistoryBlockTypeDef *tBlock = getBlock(tHistory, aCursor->BlockNumber, &tResult);
+    if (tBlock == NULL) {
+        return tResult;
+    }
+
+    if (aCursor->SampleInBlock == 0) {
+        aCursor->Values[0] = tBlock->FirstValues[0];
+        aCursor->Values[1] = tBlock->FirstValues[1];
+    } else {
+        uint8_t tCode = tBlock->Data[aCursor->ByteIndex];
+        /*
+         * A repeat code is skipped not before the next sample is read, since it may be extended by append in the meantime
+         */
+        if (tCode > CODE_ESCAPE && aCursor->RepeatsDone >= (tCode & 0x7F)) {
+            aCursor->ByteIndex++;
+            aCursor->RepeatsDone = 0;
+            tCode = tBlock->Data[aCursor->ByteIndex];
+        }
+        if (tCode > CODE_ESCAPE) {
+            aCursor->RepeatsDone++;
+        } else if (tCode < CODE_ESCAPE) {
+            aCursor->Values[0] += (tCode >> 3) - 8;
+            aCursor->Values[1] += (tCode & 0x07) - 4;
+            aCursor->ByteIndex++;
+        } else {
+            aCursor->ByteIndex++;
+            aCursor->Values[0] += decodeVarint(tBlock->Data, &aCursor->ByteIndex);
+            aCursor->Values[1] += decodeVarint(tBlock->Data, &aCursor->ByteIndex);
+        }
+    }
+    aCursor->SampleIndex++;
+    aCursor->SampleInBlock++;
+    return FR_OK;
+}
+
+/*
+ * Binary search in the block index
+ * @return number of block containing sample aSampleIndex
+ */
+static uint16_t findBlock(SampleHistoryTypeDef *aHistory, uint16_t aSampleIndex) {
+    uint16_t tLow = 0;
+    uint16_t tHigh = aHistory->BlockCount - 1;
+    while (tLow < tHigh) {
+        uint16_t tMiddle = (tLow + tHigh + 1) / 2;
+        if (aHistory->BlockFirstSample[tMiddle] <= aSampleIndex) {
+            tLow = tMiddle;
+        } else {
+            tHigh = tMiddle - 1;
+        }
+    }
+    return tLow;
+}
+
+/**
+ * Positions the cursor, so that the next call of SampleHistory_next() returns sample aSampleIndex.
+ * The block is found by binary search in the block index, then the block is decoded up to the sample.
+ */
+FRESULT SampleHistory_seek(SampleHistoryCursorTypeDef *aCursor, SampleHistoryTypeDef *aHistory, uint16_t aSampleIndex) {
+    aCursor->History = aHistory;
+    if (aSampleIndex >= aHistory->SampleCount) {
+        aCursor->SampleIndex = aHistory->SampleCount;
+        return FR_INVALID_PARAMETER;
+    }
+    uint16_t tBlockNumber = findBlock(aHistory, aSampleIndex);
+    aCursor->BlockNumber = tBlockNumber;
+    aCursor->SampleIndex = aHistory->BlockFirstSample[tBlockNumber];
+    aCursor->SampleInBlock = 0;
+    aCursor->ByteIndex = 0;
+    aCursor->RepeatsDone = 0;
+    while (aCursor->SampleIndex < aSampleIndex) {
+        FRESULT tResult = SampleHistory_next(aCursor);
+        if (tResult != FR_OK) {
+            return tResult;
+        }
+    }
+    return FR_OK;
+}
+
+/**
+ * Decodes up to aCount values of one channel, e.g. the visible part of a chart.
+ * @return number of values stored in aBuffer
+ */
+UINT SampleHistory_readChannel(SampleHistoryTypeDef *aHistory, uint16_t aStartIndex, UINT aCount, uint8_t aChannel,
+        uint16_t *aBuffer) {
+    SampleHistoryCursorTypeDef tCursor;
+    UINT i = 0;
+    if (SampleHistory_seek(&tCursor, aHistory, aStartIndex) == FR_OK) {
+        while (i < aCount && SampleHistory_next(&tCursor) == FR_OK) {
+            aBuffer[i++] = tCursor.Values[aChannel];
+        }
+    }
+    return i;
+}
+
+/**
+ * Computes minimum and maximum of one channel for each chart column.
+ * Column N contains the samples from aStartIndex + (N * aHalfSamplesPerColumn) / 2 up to the start of column N + 1,
+ * so aHalfSamplesPerColumn = 3 gives the alternating 1 and 2 samples of a compression by 1.5.
+ * A closed block, which lies completely in one column, is taken from the block envelope without decoding.
+ * @param aHalfSamplesPerColumn 2 * samples per column
+ * @return number of columns stored, i.e. columns containing at least one sample
+ */
+UINT SampleHistory_readEnvelope(SampleHistoryTypeDef *aHistory, uint16_t aStartIndex, uint16_t aHalfSamplesPerColumn,
+        UINT aColumns, uint8_t aChannel, uint16_t *aMinValues, uint16_t *aMaxValues) {
+    // samples appended by an interrupt in the meantime are not read
+    uint16_t tSampleCount = aHistory->SampleCount;
+    uint16_t tBlockCount = aHistory->BlockCount;
+    if (aStartIndex >= tSampleCount) {
+        return 0;
+    }
+    SampleHistoryCursorTypeDef tCursor;
+    bool tCursorIsPositioned = false;
+    uint16_t tBlockNumber = findBlock(aHistory, aStartIndex);
+    uint32_t tSampleIndex = aStartIndex;
+    UINT tColumn;
+    for (tColumn = 0; tColumn < aColumns; ++tColumn) {
+        uint32_t tColumnEnd = aStartIndex + (((tColumn + 1) * (uint32_t) aHalfSamplesPerColumn) / 2);
+        if (tColumnEnd > tSampleCount) {
+            tColumnEnd = tSampleCount;
+        }
+        if (tSampleIndex >= tColumnEnd) {
+            break;
+        }
+        uint16_t tMin = 0xFFFF;
+        uint16_t tMax = 0;
+        while (tSampleIndex < tColumnEnd) {
+            bool tIsClosedBlock = (tBlockNumber + 1 < tBlockCount);
+            if (tIsClosedBlock && tSampleIndex == aHistory->BlockFirstSample[tBlockNumber]
+                    && aHistory->BlockFirstSample[tBlockNumber + 1] <= tColumnEnd) {
+                /*
+                 * Take the whole block from envelope
+                 */
+                SampleHistoryEnvelopeTypeDef *tEnvelope = &aHistory->BlockEnvelopes[tBlockNumber];
+                if (tEnvelope->Min[aChannel] < tMin) {
+                    tMin = tEnvelope->Min[aChannel];
+                }
+                if (tEnvelope->Max[aChannel] > tMax) {
+                    tMax = tEnvelope->Max[aChannel];
+                }
+                tBlockNumber++;
+                tSampleIndex = aHistory->BlockFirstSample[tBlockNumber];
+                tCursorIsPositioned = false;
+                sStatistics.BlocksSkipped++;
+                continue;
+            }
+            if (!tCursorIsPositioned) {
+                if (SampleHistory_seek(&tCursor, aHistory, tSampleIndex) != FR_OK) {
+                    // card removed
+                    return tColumn;
+                }
+                tCursorIsPositioned = true;
+            }
+            if (SampleHistory_next(&tCursor) != FR_OK) {
+                return tColumn;
+            }
+            uint16_t tValue = tCursor.Values[aChannel];
+            if (tValue < tMin) {
+                tMin = tValue;
+            }
+            if (tValue > tMax) {
+                tMax = tValue;
+            }
+            tSampleIndex++;
+            if (tIsClosedBlock && tSampleIndex >= aHistory->BlockFirstSample[tBlockNumber + 1]) {
+                tBlockNumber++;
+            }
+        }
+        aMinValues[tColumn] = tMin;
+        aMaxValues[tColumn] = tMax;
+    }
+    return tColumn;
+}
+
+/*
+ * Generates the blocks below FirstRAMBlock for WriteBehind_service()
+ */
+static UINT generateSpilledBlocks(uint8_t *aBuffer, UINT aSize, void *aContext) {
+    if (sCopy.Result != FR_OK || sCopy.BlockNumber >= sCopy.History->FirstRAMBlock) {
+        return 0;
+    }
+    const SampleHistoryBlockTypeDef *tBlock = getBlock(sCopy.History, sCopy.BlockNumber, &sCopy.Result);
+    if (tBlock == NULL) {
+        return 0;
+    }
+    UINT tLength = SAMPLE_HISTORY_BLOCK_SIZE - sCopy.ByteIndex;
+    if (tLength > aSize) {
+        tLength = aSize;
+    }
+    memcpy(aBuffer, (const uint8_t *) tBlock + sCopy.ByteIndex, tLength);
+    sCopy.ByteIndex += tLength;
+    if (sCopy.ByteIndex >= SAMPLE_HISTORY_BLOCK_SIZE) {
+        sCopy.ByteIndex = 0;
+        sCopy.BlockNumber++;
+    }
+    return tLength;
+}
+
+/**
+ * Queues the blocks already written to the history file for writing to aFileHandle.
+ * Together with the SampleHistoryTypeDef written before, which contains the RAM blocks, the stored file does not depend
+ * on the history file, which is overwritten by the next measurement.
+ * The history must not be cleared or appended until the file is closed. Only one copy can be queued at a time.
+ * Errors of reading the history file are returned by SampleHistory_getCopyResult().
+ */
+bool SampleHistory_writeSpilledBlocks(SampleHistoryTypeDef *aHistory, uint8_t aFileHandle) {
+    sCopy.History = aHistory;
+    sCopy.BlockNumber = 0;
+    sCopy.ByteIndex = 0;
+    sCopy.Result = FR_OK;
+    return WriteBehind_writeGenerated(aFileHandle, &generateSpilledBlocks, NULL);
+}
+
+/**
+ * @return first error of reading the history file during the last copy, to be checked by the close callback
+ */
+FRESULT SampleHistory_getCopyResult(void) {
+    return sCopy.Result;
+}
+
+/**
+ * Copies the blocks written by SampleHistory_writeSpilledBlocks() from aFile to the history file aFileName.
+ * To be called after the SampleHistoryTypeDef was read from aFile and before SampleHistory_restore().
+ * @param aFileName history file of the probe loading the file, the name read from aFile is the one of the storing probe
+ * @return error of reading aFile or writing the history file. Then the history is cleared.
+ */
+FRESULT SampleHistory_loadSpilledBlocks(SampleHistoryTypeDef *aHistory, const TCHAR *aFileName, FIL *aFile) {
+    memset(aHistory->FileName, 0, SAMPLE_HISTORY_FILE_NAME_SIZE);
+    strncpy(aHistory->FileName, aFileName, SAMPLE_HISTORY_FILE_NAME_SIZE - 1);
+    aHistory->IsSpilling = false; // the spill of the storing probe is not related to this history
+    // the cache block is used as copy buffer
+    sCacheHistory = NULL;
+    FRESULT tResult = FR_OK;
+    if (aHistory->FirstRAMBlock > 0) {
+        FIL tHistoryFile;
+        UINT tCount;
+        tResult = f_open(&tHistoryFile, aHistory->FileName, FA_CREATE_ALWAYS | FA_WRITE);
+        if (tResult == FR_OK) {
+            for (uint16_t i = 0; i < aHistory->FirstRAMBlock && tResult == FR_OK; ++i) {
+                tResult = f_read(aFile, &sCacheBlock, SAMPLE_HISTORY_BLOCK_SIZE, &tCount);
+                if (tResult == FR_OK && tCount != SAMPLE_HISTORY_BLOCK_SIZE) {
+                    tResult = FR_INT_ERR; // file is too short
+                }
+                if (tResult == FR_OK) {
+                    tResult = f_write(&tHistoryFile, &sCacheBlock, SAMPLE_HISTORY_BLOCK_SIZE, &tCount);
+                }
+            }
+            FRESULT tCloseResult = f_close(&tHistoryFile);
+            if (tResult == FR_OK) {
+                tResult = tCloseResult;
+            }
+        }
+    }
+    if (tResult != FR_OK) {
+        sStatistics.LastError = tResult;
+        SampleHistory_clear(aHistory);
+    }
+    return tResult;
+}
+
+const SampleHistoryStatisticsTypeDef * SampleHistory_getStatistics(void) {
+    return &sStatistics;
+}
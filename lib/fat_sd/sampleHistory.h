@@ -0,0 +1,129 @@
+/*
+ * @file sampleHistory.h
+ *
+ * Compressed history of 2 channel 16 bit samples, e.g. voltage and ESR of a battery measurement.
+ * Samples are stored in blocks of SAMPLE_HISTORY_BLOCK_SIZE bytes. Each block starts with the absolute values of its first sample.
+ * The following samples are delta coded:
+ *  0x00 to 0x7F  0vvvveee  voltage delta -8 to 7 in bit 6 to 3, ESR delta -4 to 3 in bit 2 to 0
+ *  0x80          followed by the 2 deltas as zigzag varints (7 bit per byte, bit 7 set -> more bytes follow)
+ *  0x81 to 0xFF  previous sample repeated 1 to 127 times
+ * A slowly changing battery voltage needs around 1 byte per sample instead of 4 bytes for 2 uint16_t arrays.
+ *
+ * The RAM blocks are used as ring. If less than SAMPLE_HISTORY_SPILL_FREE_BLOCKS blocks are free,
+ * SampleHistory_service() writes the oldest full blocks by WriteBehind_openAt() to the history file and frees them afterwards.
+ * Block N is located at offset N * SAMPLE_HISTORY_BLOCK_SIZE of this file.
+ * If no card is inserted, SampleHistory_append() fails when all RAM blocks are full.
+ * To store a history, the SampleHistoryTypeDef is written followed by the blocks of the history file
+ * by SampleHistory_writeSpilledBlocks(). SampleHistory_loadSpilledBlocks() copies them back to the history file.
+ *
+ * Samples are read with a cursor, which decodes only from the start of the block containing the first requested sample.
+ * Blocks already written to the file are read into a single block cache.
+ *
+ * For each block the minimum and maximum of both channels is kept in RAM and updated by SampleHistory_append().
+ * SampleHistory_readEnvelope() computes the exact minimum and maximum of each chart column.
+ * Blocks completely covered by a column are taken from this envelope and are neither read from the card nor decoded,
+ * so a chart of a long measurement decodes only the blocks at the column borders.
+ *
+ * SampleHistory_append() may be called by an interrupt, all other functions must be called from the main loop,
+ * since they may access the card.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef SAMPLE_HISTORY_H_
+#define SAMPLE_HISTORY_H_
+
+#include "ff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLE_HISTORY_NUMBER_OF_CHANNELS 2
+#define SAMPLE_HISTORY_BLOCK_SIZE 256
+#define SAMPLE_HISTORY_BLOCK_HEADER_SIZE 12
+#define SAMPLE_HISTORY_RAM_BLOCKS 16 // must be a power of 2
+#define SAMPLE_HISTORY_MAX_BLOCKS 256 // size of block index
+#define SAMPLE_HISTORY_MAX_SAMPLES 0xFFFF
+#define SAMPLE_HISTORY_SPILL_FREE_BLOCKS 4 // spill if less blocks are free
+#define SAMPLE_HISTORY_MAX_SPILL_BLOCKS 4 // blocks written by one open / close sequence
+#define SAMPLE_HISTORY_FILE_NAME_SIZE 24
+
+typedef struct {
+    uint32_t FirstSampleIndex;
+    uint16_t SampleCount;
+    uint16_t UsedBytes; // of Data
+    uint16_t FirstValues[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
+    uint8_t Data[SAMPLE_HISTORY_BLOCK_SIZE - SAMPLE_HISTORY_BLOCK_HEADER_SIZE];
+} SampleHistoryBlockTypeDef;
+
+typedef struct {
+    uint16_t Min[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
+    uint16_t Max[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
+} SampleHistoryEnvelopeTypeDef;
+
+typedef struct {
+    uint16_t SampleCount;
+    uint16_t BlockCount; // including the block just filled
+    uint16_t FirstRAMBlock; // all blocks below are stored in the history file
+    uint16_t SpillBlockCount; // number of blocks of the spill just queued
+    bool IsSpilling; // from WriteBehind_openAt() until close callback
+    bool IsSpillCanceled; // by SampleHistory_clear()
+    uint16_t LastCodeIndex; // in Data of last block, for extension of repeat codes
+    uint16_t LastValues[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
+    FRESULT SpillResult; // of last spill
+    uint16_t SpillErrorBlockCount; // BlockCount at last spill error, spill is retried after the next block is started
+    TCHAR FileName[SAMPLE_HISTORY_FILE_NAME_SIZE];
+    uint16_t BlockFirstSample[SAMPLE_HISTORY_MAX_BLOCKS]; // index of first sample of each block
+    SampleHistoryEnvelopeTypeDef BlockEnvelopes[SAMPLE_HISTORY_MAX_BLOCKS]; // minimum and maximum of each block
+    SampleHistoryBlockTypeDef Blocks[SAMPLE_HISTORY_RAM_BLOCKS];
+} SampleHistoryTypeDef;
+
+typedef struct {
+    SampleHistoryTypeDef *History;
+    uint16_t SampleIndex; // of next sample
+    uint16_t BlockNumber;
+    uint16_t SampleInBlock;
+    uint16_t ByteIndex; // of next code in Data
+    uint8_t RepeatsDone; // of repeat code at ByteIndex
+    uint16_t Values[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
+} SampleHistoryCursorTypeDef;
+
+typedef struct {
+    uint32_t BlocksSpilled;
+    uint32_t SpillErrors;
+    uint32_t BlocksLoaded; // blocks read from history file
+    uint32_t BlocksSkipped; // blocks taken from envelope by SampleHistory_readEnvelope()
+    FRESULT LastError;
+} SampleHistoryStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void SampleHistory_init(SampleHistoryTypeDef *aHistory, const TCHAR *aFileName);
+void SampleHistory_clear(SampleHistoryTypeDef *aHistory);
+void SampleHistory_restore(SampleHistoryTypeDef *aHistory);
+bool SampleHistory_append(SampleHistoryTypeDef *aHistory, uint16_t aValue0, uint16_t aValue1);
+void SampleHistory_service(SampleHistoryTypeDef *aHistory);
+
+FRESULT SampleHistory_seek(SampleHistoryCursorTypeDef *aCursor, SampleHistoryTypeDef *aHistory, uint16_t aSampleIndex);
+FRESULT SampleHistory_next(SampleHistoryCursorTypeDef *aCursor);
+UINT SampleHistory_readChannel(SampleHistoryTypeDef *aHistory, uint16_t aStartIndex, UINT aCount, uint8_t aChannel,
+        uint16_t *aBuffer);
+UINT SampleHistory_readEnvelope(SampleHistoryTypeDef *aHistory, uint16_t aStartIndex, uint16_t aHalfSamplesPerColumn,
+        UINT aColumns, uint8_t aChannel, uint16_t *aMinValues, uint16_t *aMaxValues);
+
+bool SampleHistory_writeSpilledBlocks(SampleHistoryTypeDef *aHistory, uint8_t aFileHandle);
+FRESULT SampleHistory_getCopyResult(void);
+FRESULT SampleHistory_loadSpilledBlocks(SampleHistoryTypeDef *aHistory, const TCHAR *aFileName, FIL *aFile);
+
+const SampleHistoryStatisticsTypeDef * SampleHistory_getStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_HISTORY_H_ */
@@ -0,0 +1,32 @@
+/*
+ * @file sdPlatform.h
+ *
+ * Platform functions used by the buffered card writers of this directory.
+ * They are implemented by src/timing.cpp on the target and by extras/host/hostPlatform.c on the host.
+ * Using this header instead of timing.h keeps the CMSIS and HAL headers out of these modules, so they compile on the host.
+ * isCardReady() is declared in diskio.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef SD_PLATFORM_H_
+#define SD_PLATFORM_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t millis(void);
+uint32_t micros(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SD_PLATFORM_H_ */
@@ -0,0 +1,354 @@
+/*
+ * @file streamLogger.c
+ *
+ * Preallocation and double buffered sector staging for continuous recording to the MicroSD card.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "streamLogger.h"
+#include "diskio.h"
+#include "sdPlatform.h" // for millis() and micros()
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy
+
+#define NO_PENDING_BUFFER (-1)
+#define LINK_MAP_INITIAL_SIZE 10 // enough for 4 fragments
+
+static FIL sFile;
+static bool sIsOpen = false;
+static uint8_t *sBuffer[2];
+static uint8_t sFillIndex; // buffer which is filled by StreamLogger_append()
+static UINT sFillLength;
+static int8_t sPendingIndex; // full buffer which waits to be written or NO_PENDING_BUFFER
+static DWORD sStartSector; // first sector of a contiguous file
+static DWORD sDataStartSector; // relative to start of file
+static DWORD sSectorsWritten; // data sectors
+static DWORD sBytesQueued; // appended bytes including the bytes already written
+
+static uint32_t *sIndexBuffer; // one sector of index entries
+static uint16_t sIndexSectorCount;
+static uint16_t sPendingIndexSector; // 0 -> no index sector pending
+
+static StreamLoggerStatisticsTypeDef sStatistics;
+
+/**
+ * Enables fast seek for the file. f_lseek() and crossing of cluster boundaries then need no FAT access.
+ * Starts with a small table and retries with the size reported by FatFs if the file is fragmented.
+ */
+FRESULT createClusterLinkMap(FIL *aFile) {
+    DWORD *tTable = (DWORD *) malloc(LINK_MAP_INITIAL_SIZE * sizeof(DWORD));
+    if (tTable == NULL) {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    tTable[0] = LINK_MAP_INITIAL_SIZE;
+    aFile->cltbl = tTable;
+    FRESULT tResult = f_lseek(aFile, CREATE_LINKMAP);
+    if (tResult == FR_NOT_ENOUGH_CORE) {
+        // first entry contains now the required size
+        DWORD tRequiredSize = tTable[0];
+        free(tTable);
+        tTable = (DWORD *) malloc(tRequiredSize * sizeof(DWORD));
+        aFile->cltbl = tTable;
+        if (tTable != NULL) {
+            tTable[0] = tRequiredSize;
+            tResult = f_lseek(aFile, CREATE_LINKMAP);
+        }
+    }
+    if (tResult != FR_OK) {
+        freeClusterLinkMap(aFile);
+    }
+    return tResult;
+}
+
+void freeClusterLinkMap(FIL *aFile) {
+    free(aFile->cltbl);
+    aFile->cltbl = NULL;
+}
+
+/**
+ * @param aSector relative to start of file
+ */
+static bool writeSectors(DWORD aSector, const uint8_t *aBuffer, UINT aCount) {
+    if (sStatistics.IsContiguous) {
+        return (disk_write(sFile.fs->drv, aBuffer, sStartSector + aSector, aCount) == RES_OK);
+    }
+    // fast seek, so no FAT access
+    UINT tCount;
+    return (f_lseek(&sFile, aSector * _MAX_SS) == FR_OK && f_write(&sFile, aBuffer, aCount * _MAX_SS, &tCount) == FR_OK
+            && tCount == aCount * _MAX_SS);
+}
+
+static bool writeHeader(void) {
+    StreamFileHeaderTypeDef *tHeader = (StreamFileHeaderTypeDef *) sBuffer[0];
+    memset(tHeader, 0, _MAX_SS);
+    tHeader->Magic = STREAM_FILE_MAGIC;
+    tHeader->Version = STREAM_FILE_VERSION;
+    tHeader->IndexSectorCount = sIndexSectorCount;
+    tHeader->RecordCount = sStatistics.RecordsAppended;
+    tHeader->IndexedRecordCount = sStatistics.RecordsAppended;
+    if (tHeader->IndexedRecordCount > (uint32_t) sIndexSectorCount * STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) {
+        tHeader->IndexedRecordCount = (uint32_t) sIndexSectorCount * STREAM_FILE_INDEX_ENTRIES_PER_SECTOR;
+    }
+    tHeader->DataLength = sStatistics.BytesAppended;
+    if (sStatistics.RecordsAppended > 0) {
+        tHeader->DurationMillis = millis() - sStatistics.StartMillis;
+    }
+    return writeSectors(0, sBuffer[0], 1);
+}
+
+/**
+ * Creates the file and allocates its clusters. Existing file is overwritten.
+ * @param aPreallocateSize size of data area, is rounded down to a multiple of STREAM_LOGGER_BUFFER_SIZE.
+ *        If the card is full, the file gets the size of the remaining free space.
+ * @param aNumberOfIndexEntries is rounded up to a multiple of STREAM_FILE_INDEX_ENTRIES_PER_SECTOR.
+ *        Use preallocated size / record size for fixed size records.
+ */
+FRESULT StreamLogger_open(const TCHAR *aFileName, DWORD aPreallocateSize, uint32_t aNumberOfIndexEntries) {
+    if (sIsOpen) {
+        return FR_DENIED;
+    }
+    memset(&sStatistics, 0, sizeof(sStatistics));
+    sBuffer[0] = (uint8_t *) malloc((2 * STREAM_LOGGER_BUFFER_SIZE) + _MAX_SS);
+    if (sBuffer[0] == NULL) {
+        return FR_NOT_ENOUGH_CORE;
+    }
+    sBuffer[1] = sBuffer[0] + STREAM_LOGGER_BUFFER_SIZE;
+    sIndexBuffer = (uint32_t *) (sBuffer[1] + STREAM_LOGGER_BUFFER_SIZE);
+
+    uint32_t tIndexSectorCount = (aNumberOfIndexEntries + STREAM_FILE_INDEX_ENTRIES_PER_SECTOR - 1)
+            / STREAM_FILE_INDEX_ENTRIES_PER_SECTOR;
+    if (tIndexSectorCount > UINT16_MAX) {
+        tIndexSectorCount = UINT16_MAX;
+    }
+    sIndexSectorCount = tIndexSectorCount;
+    sDataStartSector = tIndexSectorCount + 1;
+
+    aPreallocateSize &= ~(STREAM_LOGGER_BUFFER_SIZE - 1);
+    if (aPreallocateSize == 0) {
+        aPreallocateSize = STREAM_LOGGER_BUFFER_SIZE;
+    }
+    FRESULT tResult = f_open(&sFile, aFileName, FA_CREATE_ALWAYS | FA_WRITE);
+    if (tResult != FR_OK) {
+        free(sBuffer[0]);
+        return tResult;
+    }
+    // seek beyond end of file in write mode allocates the cluster chain
+    tResult = f_lseek(&sFile, (sDataStartSector * _MAX_SS) + aPreallocateSize);
+    if (tResult == FR_OK) {
+        // write FAT and directory entry now and not at the end of recording
+        tResult = f_sync(&sFile);
+    }
+    if (tResult == FR_OK) {
+        if (sFile.fsize <= sDataStartSector * _MAX_SS) {
+            tResult = FR_DENIED;
+        } else {
+            sStatistics.FileSize = (sFile.fsize - (sDataStartSector * _MAX_SS)) & ~(STREAM_LOGGER_BUFFER_SIZE - 1);
+            tResult = createClusterLinkMap(&sFile);
+        }
+    }
+    if (tResult == FR_OK) {
+        sStatistics.Fragments = (sFile.cltbl[0] - 2) / 2;
+        sStatistics.IsContiguous = (sStatistics.Fragments == 1);
+        if (sStatistics.IsContiguous) {
+            sStartSector = sFile.fs->database + (sFile.sclust - 2) * sFile.fs->csize;
+        }
+        if (!writeHeader()) {
+            tResult = FR_DISK_ERR;
+        }
+    }
+    if (tResult != FR_OK) {
+        freeClusterLinkMap(&sFile);
+        f_close(&sFile);
+        f_unlink(aFileName);
+        free(sBuffer[0]);
+        return tResult;
+    }
+
+    sFillIndex = 0;
+    sFillLength = 0;
+    sPendingIndex = NO_PENDING_BUFFER;
+    sPendingIndexSector = 0;
+    sSectorsWritten = 0;
+    sBytesQueued = 0;
+    sStatistics.StartMillis = millis();
+    sIsOpen = true;
+    return FR_OK;
+}
+
+bool StreamLogger_isOpen(void) {
+    return sIsOpen;
+}
+
+/**
+ * @param aLength multiple of sector size
+ * @param aPaddingLength number of bytes at end of buffer, which do not belong to a record
+ */
+static void writeBuffer(uint8_t aIndex, UINT aLength, UINT aPaddingLength) {
+    uint32_t tStartMicros = micros();
+    bool tSuccess = writeSectors(sDataStartSector + sSectorsWritten, sBuffer[aIndex], aLength / _MAX_SS);
+    // keep file layout even on error
+    sSectorsWritten += aLength / _MAX_SS;
+
+    uint32_t tWriteMicros = micros() - tStartMicros;
+    sStatistics.BufferWrites++;
+    sStatistics.WriteMicrosSum += tWriteMicros;
+    if (tWriteMicros > sStatistics.WriteMicrosMax) {
+        sStatistics.WriteMicrosMax = tWriteMicros;
+    }
+    if (tSuccess) {
+        sStatistics.BytesWritten += aLength - aPaddingLength;
+    } else {
+        sStatistics.WriteErrors++;
+    }
+}
+
+static void writeIndexSector(uint16_t aIndexSector) {
+    if (!writeSectors(aIndexSector, (uint8_t *) sIndexBuffer, 1)) {
+        sStatistics.WriteErrors++;
+    }
+    sStatistics.IndexWrites++;
+    sPendingIndexSector = 0;
+}
+
+/*
+ * Records are allowed to span the 2 buffers
+ */
+static void copyToBuffer(const uint8_t *aSource, UINT aLength) {
+    while (aLength > 0) {
+        UINT tCount = STREAM_LOGGER_BUFFER_SIZE - sFillLength;
+        if (tCount > aLength) {
+            tCount = aLength;
+        }
+        memcpy(sBuffer[sFillIndex] + sFillLength, aSource, tCount);
+        sFillLength += tCount;
+        aSource += tCount;
+        aLength -= tCount;
+        if (sFillLength == STREAM_LOGGER_BUFFER_SIZE) {
+            sPendingIndex = sFillIndex;
+            sFillIndex ^= 1;
+            sFillLength = 0;
+        }
+    }
+}
+
+/**
+ * Copies header and data as one record to the staging buffer and stores its offset in the index.
+ * Does not access the card, except if the previous index sector could not be written up to now.
+ * @return false if record was dropped
+ */
+bool StreamLogger_append(const void *aHeader, UINT aHeaderLength, const void *aData, UINT aDataLength) {
+    if (!sIsOpen) {
+        return false;
+    }
+    UINT tLength = aHeaderLength + aDataLength;
+    if (tLength > STREAM_LOGGER_BUFFER_SIZE || sBytesQueued + tLength > sStatistics.FileSize
+            || (sFillLength + tLength >= STREAM_LOGGER_BUFFER_SIZE && sPendingIndex != NO_PENDING_BUFFER)) {
+        sStatistics.RecordsLost++;
+        return false;
+    }
+
+    uint32_t tRecordNumber = sStatistics.RecordsAppended;
+    if (tRecordNumber < (uint32_t) sIndexSectorCount * STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) {
+        uint16_t tIndexSlot = tRecordNumber % STREAM_FILE_INDEX_ENTRIES_PER_SECTOR;
+        if (tIndexSlot == 0 && sPendingIndexSector != 0) {
+            writeIndexSector(sPendingIndexSector);
+        }
+        sIndexBuffer[tIndexSlot] = sBytesQueued;
+        if (tIndexSlot == STREAM_FILE_INDEX_ENTRIES_PER_SECTOR - 1) {
+            sPendingIndexSector = (tRecordNumber / STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) + 1;
+        }
+    }
+
+    copyToBuffer((const uint8_t *) aHeader, aHeaderLength);
+    copyToBuffer((const uint8_t *) aData, aDataLength);
+    sBytesQueued += tLength;
+    sStatistics.RecordsAppended++;
+    sStatistics.BytesAppended += tLength;
+    return true;
+}
+
+/**
+ * Writes a full buffer or index sector if the card has finished programming the previous one.
+ * To be called from the main loop, best after starting the next acquisition.
+ */
+void StreamLogger_service(void) {
+    if (!sIsOpen || (sPendingIndex == NO_PENDING_BUFFER && sPendingIndexSector == 0)) {
+        return;
+    }
+    if (!isCardReady()) {
+        sStatistics.BusyDeferrals++;
+        return;
+    }
+    if (sPendingIndex != NO_PENDING_BUFFER) {
+        writeBuffer(sPendingIndex, STREAM_LOGGER_BUFFER_SIZE, 0);
+        sPendingIndex = NO_PENDING_BUFFER;
+    } else {
+        writeIndexSector(sPendingIndexSector);
+    }
+}
+
+/**
+ * Writes the remaining data, the last index sector and the header and truncates the file to the written sectors.
+ */
+FRESULT StreamLogger_close(void) {
+    if (!sIsOpen) {
+        return FR_INVALID_OBJECT;
+    }
+    if (sPendingIndex != NO_PENDING_BUFFER) {
+        writeBuffer(sPendingIndex, STREAM_LOGGER_BUFFER_SIZE, 0);
+    }
+    if (sFillLength > 0) {
+        UINT tLength = (sFillLength + _MAX_SS - 1) & ~(_MAX_SS - 1);
+        memset(sBuffer[sFillIndex] + sFillLength, 0, tLength - sFillLength);
+        writeBuffer(sFillIndex, tLength, tLength - sFillLength);
+    }
+    uint32_t tIndexedRecordCount = sStatistics.RecordsAppended;
+    if (tIndexedRecordCount > (uint32_t) sIndexSectorCount * STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) {
+        tIndexedRecordCount = (uint32_t) sIndexSectorCount * STREAM_FILE_INDEX_ENTRIES_PER_SECTOR;
+    }
+    if (sPendingIndexSector != 0) {
+        writeIndexSector(sPendingIndexSector);
+    } else if (tIndexedRecordCount % STREAM_FILE_INDEX_ENTRIES_PER_SECTOR != 0) {
+        // last index sector is only partially filled
+        writeIndexSector((tIndexedRecordCount / STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) + 1);
+    }
+    FRESULT tResult = FR_OK;
+    if (!writeHeader()) {
+        tResult = FR_DISK_ERR;
+    }
+    if (tResult == FR_OK) {
+        tResult = f_lseek(&sFile, (sDataStartSector + sSectorsWritten) * _MAX_SS);
+    }
+    if (tResult == FR_OK) {
+        tResult = f_truncate(&sFile);
+    }
+    freeClusterLinkMap(&sFile);
+    FRESULT tCloseResult = f_close(&sFile);
+    if (tResult == FR_OK) {
+        tResult = tCloseResult;
+    }
+    free(sBuffer[0]);
+    sIsOpen = false;
+    return tResult;
+}
+
+const StreamLoggerStatisticsTypeDef * StreamLogger_getStatistics(void) {
+    return &sStatistics;
+}
+
+/**
+ * @return average write rate since StreamLogger_open()
+ */
+uint32_t StreamLogger_getBytesPerSecond(void) {
+    uint32_t tMillis = millis() - sStatistics.StartMillis;
+    if (tMillis == 0) {
+        return 0;
+    }
+    return ((uint64_t) sStatistics.BytesWritten * 1000) / tMillis;
+}
@@ -0,0 +1,95 @@
+/*
+ * @file streamLogger.h
+ *
+ * Continuous recording of records to a preallocated file on the MicroSD card.
+ * FatFs R0.09b has no f_expand(), so the file is preallocated by f_lseek() beyond its end in write mode.
+ * If the resulting cluster chain is contiguous, the sectors are written directly by disk_write(),
+ * without any FAT or directory access during recording. This gives multiple block writes (CMD25)
+ * with pre-erase (ACMD23) for each buffer. Otherwise the preallocated file is written by f_write().
+ *
+ * Records are staged in 2 buffers of STREAM_LOGGER_SECTORS_PER_BUFFER sectors.
+ * One buffer is filled by StreamLogger_append() while the other waits for the card or is written.
+ * StreamLogger_service() does not wait for the card to finish programming the previous buffer.
+ * If both buffers are full, the record is dropped and counted as lost.
+ *
+ * File layout:
+ * Sector 0 contains the StreamFileHeaderTypeDef, it is written at open and at close.
+ * Sectors 1 to IndexSectorCount contain the index, the byte offset of each record relative to start of data.
+ * The index is written sector by sector during recording. Records after the last index entry are not indexed.
+ * Data starts at the next sector, records are not aligned. The last sector is padded with zeros.
+ * Seeking to record N requires one index sector and one or two data sectors, see streamReader.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STREAM_LOGGER_H_
+#define STREAM_LOGGER_H_
+
+#include "ff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STREAM_LOGGER_SECTORS_PER_BUFFER 4
+#define STREAM_LOGGER_BUFFER_SIZE (STREAM_LOGGER_SECTORS_PER_BUFFER * _MAX_SS) // 2 buffers are allocated by StreamLogger_open()
+
+#define STREAM_FILE_MAGIC 0x474F4C53 // "SLOG"
+#define STREAM_FILE_VERSION 1
+#define STREAM_FILE_INDEX_ENTRIES_PER_SECTOR (_MAX_SS / sizeof(uint32_t))
+
+typedef struct {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t IndexSectorCount;
+    uint32_t RecordCount; // 0 if file was not closed
+    uint32_t IndexedRecordCount;
+    uint32_t DataLength; // without padding
+    uint32_t DurationMillis; // from open to close
+} StreamFileHeaderTypeDef;
+
+#define STREAM_FILE_DATA_OFFSET(aHeaderPtr) (((DWORD) (aHeaderPtr)->IndexSectorCount + 1) * _MAX_SS)
+
+typedef struct {
+    uint32_t StartMillis; // time of StreamLogger_open()
+    uint32_t RecordsAppended;
+    uint32_t RecordsLost; // both buffers were full or file was full
+    uint32_t BytesAppended;
+    uint32_t BytesWritten; // padding of last sector is not counted
+    uint32_t BufferWrites;
+    uint32_t IndexWrites;
+    uint32_t BusyDeferrals; // StreamLogger_service() calls, which found the card still programming
+    uint32_t WriteMicrosMax; // duration of one buffer write
+    uint32_t WriteMicrosSum;
+    uint32_t WriteErrors;
+    uint32_t FileSize; // preallocated size
+    uint16_t Fragments; // number of contiguous cluster runs of the file
+    bool IsContiguous; // sectors are written by disk_write()
+} StreamLoggerStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FRESULT StreamLogger_open(const TCHAR *aFileName, DWORD aPreallocateSize, uint32_t aNumberOfIndexEntries);
+bool StreamLogger_isOpen(void);
+bool StreamLogger_append(const void *aHeader, UINT aHeaderLength, const void *aData, UINT aDataLength);
+void StreamLogger_service(void);
+FRESULT StreamLogger_close(void);
+
+const StreamLoggerStatisticsTypeDef * StreamLogger_getStatistics(void);
+uint32_t StreamLogger_getBytesPerSecond(void);
+
+/*
+ * Cluster link map table for FatFs fast seek, allocated by malloc
+ */
+FRESULT createClusterLinkMap(FIL *aFile);
+void freeClusterLinkMap(FIL *aFile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_LOGGER_H_ */
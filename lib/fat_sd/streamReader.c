@@ -0,0 +1,216 @@
+/*
+ * @file streamReader.c
+ *
+ * Fast seek and read ahead cache for files written by streamLogger.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "streamReader.h"
+
+#include <stdlib.h> // for malloc
+#include <string.h> // for memcpy
+
+static FIL sFile;
+static bool sIsOpen = false;
+static StreamFileHeaderTypeDef sHeader;
+
+static uint8_t *sCache; // read ahead cache for data sectors
+static UINT sCacheSectorCount;
+static DWORD sCacheStartSector; // relative to start of data
+static UINT sCacheValidSectors; // 0 -> cache is empty
+
+static uint32_t *sIndexCache; // one sector of index entries
+static DWORD sIndexCacheSector; // 0 -> cache is empty, since sector 0 is the header
+
+static StreamReaderStatisticsTypeDef sStatistics;
+
+/**
+ * @param aRAMBudget bytes available for index and read ahead cache. Rounded down to sectors.
+ *        The cluster link map table needs additionally 8 bytes per fragment of the file.
+ */
+FRESULT StreamReader_open(const TCHAR *aFileName, UINT aRAMBudget) {
+    if (sIsOpen) {
+        return FR_DENIED;
+    }
+    memset(&sStatistics, 0, sizeof(sStatistics));
+    FRESULT tResult = f_open(&sFile, aFileName, FA_OPEN_EXISTING | FA_READ);
+    if (tResult != FR_OK) {
+        return tResult;
+    }
+    UINT tCount;
+    tResult = f_read(&sFile, &sHeader, sizeof(sHeader), &tCount);
+    if (tResult == FR_OK
+            && (tCount != sizeof(sHeader) || sHeader.Magic != STREAM_FILE_MAGIC || sHeader.Version != STREAM_FILE_VERSION)) {
+        tResult = FR_INVALID_OBJECT;
+    }
+    if (tResult == FR_OK) {
+        tResult = createClusterLinkMap(&sFile);
+    }
+    if (tResult == FR_OK) {
+        sCacheSectorCount = 1;
+        if (aRAMBudget > 2 * _MAX_SS) {
+            sCacheSectorCount = (aRAMBudget / _MAX_SS) - 1;
+        }
+        if (sCacheSectorCount > STREAM_READER_MAX_CACHE_SECTORS) {
+            sCacheSectorCount = STREAM_READER_MAX_CACHE_SECTORS;
+        }
+        sCache = (uint8_t *) malloc((sCacheSectorCount + 1) * _MAX_SS);
+        if (sCache == NULL) {
+            freeClusterLinkMap(&sFile);
+            tResult = FR_NOT_ENOUGH_CORE;
+        }
+    }
+    if (tResult != FR_OK) {
+        f_close(&sFile);
+        return tResult;
+    }
+    sIndexCache = (uint32_t *) (sCache + (sCacheSectorCount * _MAX_SS));
+    sCacheValidSectors = 0;
+    sIndexCacheSector = 0;
+    sIsOpen = true;
+    return FR_OK;
+}
+
+bool StreamReader_isOpen(void) {
+    return sIsOpen;
+}
+
+const StreamFileHeaderTypeDef * StreamReader_getHeader(void) {
+    return &sHeader;
+}
+
+/*
+ * Reads ahead as many sectors as fit into the cache, if access is sequential.
+ * Otherwise only the sectors required for the current request are read.
+ */
+static FRESULT fillCache(DWORD aSector, DWORD aLastRequiredSector) {
+    UINT tSectorCount = sCacheSectorCount;
+    if (aSector != sCacheStartSector + sCacheValidSectors && aLastRequiredSector - aSector < sCacheSectorCount) {
+        tSectorCount = aLastRequiredSector - aSector + 1;
+    }
+    sCacheValidSectors = 0;
+    FRESULT tResult = f_lseek(&sFile, STREAM_FILE_DATA_OFFSET(&sHeader) + (aSector * _MAX_SS));
+    if (tResult != FR_OK) {
+        return tResult;
+    }
+    UINT tCount;
+    tResult = f_read(&sFile, sCache, tSectorCount * _MAX_SS, &tCount);
+    sStatistics.CacheFills++;
+    if (tResult == FR_OK && tCount < _MAX_SS) {
+        tResult = FR_INVALID_PARAMETER;
+    }
+    if (tResult == FR_OK) {
+        sCacheStartSector = aSector;
+        sCacheValidSectors = tCount / _MAX_SS;
+        sStatistics.SectorsRead += sCacheValidSectors;
+    }
+    return tResult;
+}
+
+/**
+ * @param aOffset relative to start of data area
+ */
+FRESULT StreamReader_read(DWORD aOffset, void *aBuffer, UINT aLength) {
+    if (!sIsOpen) {
+        return FR_INVALID_OBJECT;
+    }
+    if (aOffset + aLength > sHeader.DataLength) {
+        return FR_INVALID_PARAMETER;
+    }
+    sStatistics.Reads++;
+    bool tIsHit = true;
+    uint8_t *tDestination = (uint8_t *) aBuffer;
+    while (aLength > 0) {
+        DWORD tSector = aOffset / _MAX_SS;
+        if (tSector < sCacheStartSector || tSector >= sCacheStartSector + sCacheValidSectors) {
+            tIsHit = false;
+            FRESULT tResult = fillCache(tSector, (aOffset + aLength - 1) / _MAX_SS);
+            if (tResult != FR_OK) {
+                return tResult;
+            }
+        }
+        UINT tCacheOffset = aOffset - (sCacheStartSector * _MAX_SS);
+        UINT tCount = (sCacheValidSectors * _MAX_SS) - tCacheOffset;
+        if (tCount > aLength) {
+            tCount = aLength;
+        }
+        memcpy(tDestination, sCache + tCacheOffset, tCount);
+        tDestination += tCount;
+        aOffset += tCount;
+        aLength -= tCount;
+    }
+    if (tIsHit) {
+        sStatistics.CacheHits++;
+    }
+    return FR_OK;
+}
+
+static FRESULT getIndexEntry(uint32_t aRecordNumber, DWORD *aOffset) {
+    DWORD tSector = (aRecordNumber / STREAM_FILE_INDEX_ENTRIES_PER_SECTOR) + 1;
+    if (tSector != sIndexCacheSector) {
+        sIndexCacheSector = 0;
+        UINT tCount;
+        FRESULT tResult = f_lseek(&sFile, tSector * _MAX_SS);
+        if (tResult == FR_OK) {
+            tResult = f_read(&sFile, sIndexCache, _MAX_SS, &tCount);
+        }
+        sStatistics.IndexSectorReads++;
+        if (tResult != FR_OK) {
+            return tResult;
+        }
+        sIndexCacheSector = tSector;
+    }
+    *aOffset = sIndexCache[aRecordNumber % STREAM_FILE_INDEX_ENTRIES_PER_SECTOR];
+    return FR_OK;
+}
+
+/**
+ * Gets offset and length of a record from the index
+ * @return FR_INVALID_PARAMETER if record is not indexed
+ */
+FRESULT StreamReader_getRecordPosition(uint32_t aRecordNumber, DWORD *aOffset, UINT *aLength) {
+    if (!sIsOpen) {
+        return FR_INVALID_OBJECT;
+    }
+    if (aRecordNumber >= sHeader.IndexedRecordCount) {
+        return FR_INVALID_PARAMETER;
+    }
+    FRESULT tResult = getIndexEntry(aRecordNumber, aOffset);
+    if (tResult != FR_OK) {
+        return tResult;
+    }
+    DWORD tNextOffset;
+    if (aRecordNumber + 1 < sHeader.IndexedRecordCount) {
+        DWORD tOffset = *aOffset;
+        tResult = getIndexEntry(aRecordNumber + 1, &tNextOffset);
+        *aOffset = tOffset;
+    } else if (aRecordNumber + 1 == sHeader.RecordCount) {
+        tNextOffset = sHeader.DataLength;
+    } else {
+        // last indexed record, but not last record -> length is unknown
+        tResult = FR_INVALID_PARAMETER;
+    }
+    if (tResult == FR_OK) {
+        *aLength = tNextOffset - *aOffset;
+    }
+    return tResult;
+}
+
+FRESULT StreamReader_close(void) {
+    if (!sIsOpen) {
+        return FR_INVALID_OBJECT;
+    }
+    free(sCache);
+    freeClusterLinkMap(&sFile);
+    sIsOpen = false;
+    return f_close(&sFile);
+}
+
+const StreamReaderStatisticsTypeDef * StreamReader_getStatistics(void) {
+    return &sStatistics;
+}
@@ -0,0 +1,50 @@
+/*
+ * @file streamReader.h
+ *
+ * Random access to files written by streamLogger.c.
+ * The file is opened with a cluster link map table (fast seek), so a seek costs no FAT access
+ * independent of the file size. Without it, FatFs follows the cluster chain from the start of the file for each backward seek.
+ * Data is read through a read ahead cache, so sequential access of small records results in multiple block reads (CMD18).
+ * Random access reads only the sectors of the requested data.
+ * One index sector is cached, so seeking to record N requires one index sector read and one or two data sectors reads.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef STREAM_READER_H_
+#define STREAM_READER_H_
+
+#include "streamLogger.h"
+
+#define STREAM_READER_MAX_CACHE_SECTORS 32
+
+typedef struct {
+    uint32_t Reads; // calls of StreamReader_read()
+    uint32_t CacheHits;
+    uint32_t CacheFills; // f_read() calls for data sectors
+    uint32_t SectorsRead; // data sectors
+    uint32_t IndexSectorReads;
+} StreamReaderStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+FRESULT StreamReader_open(const TCHAR *aFileName, UINT aRAMBudget);
+bool StreamReader_isOpen(void);
+const StreamFileHeaderTypeDef * StreamReader_getHeader(void);
+FRESULT StreamReader_read(DWORD aOffset, void *aBuffer, UINT aLength);
+FRESULT StreamReader_getRecordPosition(uint32_t aRecordNumber, DWORD *aOffset, UINT *aLength);
+FRESULT StreamReader_close(void);
+
+const StreamReaderStatisticsTypeDef * StreamReader_getStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_READER_H_ */
@@ -0,0 +1,499 @@
+/*
+ * @file writeBehind.c
+ *
+ * Bounded FIFO queue of FatFs requests, executed incrementally by WriteBehind_service().
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "writeBehind.h"
+#include "diskio.h"
+#include "sdPlatform.h" // for millis() and micros()
+
+#include <string.h> // for memcpy
+
+#define REQUEST_OPEN        0 // data is file name in ring buffer
+#define REQUEST_WRITE       1 // data in ring buffer
+#define REQUEST_REFERENCE   2 // data at DataPtr
+#define REQUEST_GENERATED   3
+#define REQUEST_SYNC        4
+#define REQUEST_CLOSE       5
+#define REQUEST_PAD         6 // zeros up to the next sector boundary
+
+typedef struct {
+    uint8_t Request;
+    uint8_t FileHandle;
+    UINT Length; // of data
+    UINT Done; // bytes of data already written
+    union {
+        const uint8_t *DataPtr; // for REQUEST_REFERENCE
+        uint16_t BufferIndex; // start in ring buffer for REQUEST_OPEN and REQUEST_WRITE
+        WriteBehindGenerator Generator;
+        WriteBehindCallback Callback;
+    };
+    void *Context; // for callback and generator
+    DWORD FileOffset; // for REQUEST_OPEN, 0 -> create new file
+} WriteBehindRequestTypeDef;
+
+typedef struct {
+    FIL File;
+    bool IsUsed; // from WriteBehind_open() until close request is executed
+    bool IsCloseQueued;
+    FRESULT Result; // first error
+} WriteBehindFileTypeDef;
+
+static WriteBehindRequestTypeDef sQueue[WRITE_BEHIND_QUEUE_SIZE];
+static uint8_t sQueueOut; // next request to execute
+static uint8_t sQueueCount;
+static uint8_t sReservedCount; // one queue entry is reserved for the close request of each open file
+
+static uint8_t sBuffer[WRITE_BEHIND_BUFFER_SIZE];
+static uint16_t sBufferIn;
+static uint16_t sBufferOut;
+static uint16_t sBufferUsed;
+
+static WriteBehindFileTypeDef sFiles[WRITE_BEHIND_MAX_FILES];
+
+static uint32_t sLastServiceMicros; // 0 -> queue was empty at last call
+static WriteBehindStatisticsTypeDef sStatistics;
+
+/*
+ * Returns the next free queue entry or NULL.
+ * Requests other than close must leave the entries reserved for close requests free.
+ */
+static WriteBehindRequestTypeDef * allocateRequest(uint8_t aRequest, uint8_t aFileHandle, uint8_t aAdditionalReserved) {
+    if (sQueueCount + sReservedCount + aAdditionalReserved >= WRITE_BEHIND_QUEUE_SIZE) {
+        sStatistics.RequestsRejected++;
+        return NULL;
+    }
+    WriteBehindRequestTypeDef *tRequest = &sQueue[(sQueueOut + sQueueCount) % WRITE_BEHIND_QUEUE_SIZE];
+    tRequest->Request = aRequest;
+    tRequest->FileHandle = aFileHandle;
+    tRequest->Length = 0;
+    tRequest->Done = 0;
+    tRequest->Context = NULL;
+    return tRequest;
+}
+
+static void commitRequest(void) {
+    sQueueCount++;
+    sStatistics.RequestsQueued++;
+    if (sQueueCount > sStatistics.QueueDepthMax) {
+        sStatistics.QueueDepthMax = sQueueCount;
+    }
+}
+
+/*
+ * Copies data into ring buffer. Data may wrap around the end of the buffer.
+ * @return start index or -1 if not enough space
+ */
+static int32_t copyToBuffer(const void *aData, UINT aLength) {
+    if (aLength > (UINT) (WRITE_BEHIND_BUFFER_SIZE - sBufferUsed)) {
+        sStatistics.RequestsRejected++;
+        return -1;
+    }
+    uint16_t tStartIndex = sBufferIn;
+    UINT tFirstLength = WRITE_BEHIND_BUFFER_SIZE - sBufferIn;
+    if (tFirstLength > aLength) {
+        tFirstLength = aLength;
+    }
+    memcpy(&sBuffer[sBufferIn], aData, tFirstLength);
+    memcpy(&sBuffer[0], (const uint8_t *) aData + tFirstLength, aLength - tFirstLength);
+    sBufferIn = (sBufferIn + aLength) % WRITE_BEHIND_BUFFER_SIZE;
+    sBufferUsed += aLength;
+    if (sBufferUsed > sStatistics.BufferUsedMax) {
+        sStatistics.BufferUsedMax = sBufferUsed;
+    }
+    return tStartIndex;
+}
+
+static void releaseBuffer(UINT aLength) {
+    sBufferOut = (sBufferOut + aLength) % WRITE_BEHIND_BUFFER_SIZE;
+    sBufferUsed -= aLength;
+}
+
+static bool isValidHandle(uint8_t aFileHandle) {
+    return (aFileHandle < WRITE_BEHIND_MAX_FILES && sFiles[aFileHandle].IsUsed && !sFiles[aFileHandle].IsCloseQueued);
+}
+
+/**
+ * Queues creation of the file. Existing file is overwritten.
+ * The result of f_open() is reported to the callbacks of WriteBehind_sync() and WriteBehind_close().
+ * @return file handle or WRITE_BEHIND_INVALID_HANDLE if no file handle, queue entry or buffer space is available
+ */
+uint8_t WriteBehind_open(const TCHAR *aFileName) {
+    return WriteBehind_openAt(aFileName, 0);
+}
+
+/**
+ * Like WriteBehind_open(), but writing starts at aFileOffset of an existing file. Data behind the written range is kept.
+ * A file which is shorter than aFileOffset is created and expanded. aFileOffset 0 overwrites the file.
+ */
+uint8_t WriteBehind_openAt(const TCHAR *aFileName, DWORD aFileOffset) {
+    uint8_t tFileHandle;
+    for (tFileHandle = 0; tFileHandle < WRITE_BEHIND_MAX_FILES; ++tFileHandle) {
+        if (!sFiles[tFileHandle].IsUsed) {
+            break;
+        }
+    }
+    UINT tLength = (strlen(aFileName) + 1) * sizeof(TCHAR);
+    if (tFileHandle == WRITE_BEHIND_MAX_FILES || tLength > (_MAX_LFN + 1) * sizeof(TCHAR)) {
+        sStatistics.RequestsRejected++;
+        return WRITE_BEHIND_INVALID_HANDLE;
+    }
+    // reserve additionally the entry for the close request
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_OPEN, tFileHandle, 1);
+    if (tRequest == NULL) {
+        return WRITE_BEHIND_INVALID_HANDLE;
+    }
+    int32_t tBufferIndex = copyToBuffer(aFileName, tLength);
+    if (tBufferIndex < 0) {
+        return WRITE_BEHIND_INVALID_HANDLE;
+    }
+    tRequest->BufferIndex = tBufferIndex;
+    tRequest->Length = tLength;
+    tRequest->FileOffset = aFileOffset;
+    sFiles[tFileHandle].IsUsed = true;
+    sFiles[tFileHandle].IsCloseQueued = false;
+    sFiles[tFileHandle].Result = FR_OK;
+    sReservedCount++;
+    commitRequest();
+    return tFileHandle;
+}
+
+/**
+ * Copies the data to the ring buffer.
+ * @return false if queue or ring buffer is full. Nothing is queued then.
+ */
+bool WriteBehind_write(uint8_t aFileHandle, const void *aData, UINT aLength) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_WRITE, aFileHandle, 0);
+    if (tRequest == NULL) {
+        return false;
+    }
+    int32_t tBufferIndex = copyToBuffer(aData, aLength);
+    if (tBufferIndex < 0) {
+        return false;
+    }
+    tRequest->BufferIndex = tBufferIndex;
+    tRequest->Length = aLength;
+    commitRequest();
+    return true;
+}
+
+/**
+ * Queues the pointer only. The data must be valid and unchanged until the close callback is called.
+ */
+bool WriteBehind_writeReference(uint8_t aFileHandle, const void *aData, UINT aLength) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_REFERENCE, aFileHandle, 0);
+    if (tRequest == NULL) {
+        return false;
+    }
+    tRequest->DataPtr = (const uint8_t *) aData;
+    tRequest->Length = aLength;
+    commitRequest();
+    return true;
+}
+
+/**
+ * The generator is called by WriteBehind_service() until it returns 0.
+ * Suited for formatted output, which would not fit into the ring buffer.
+ */
+bool WriteBehind_writeGenerated(uint8_t aFileHandle, WriteBehindGenerator aGenerator, void *aContext) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_GENERATED, aFileHandle, 0);
+    if (tRequest == NULL) {
+        return false;
+    }
+    tRequest->Generator = aGenerator;
+    tRequest->Context = aContext;
+    commitRequest();
+    return true;
+}
+
+/**
+ * Writes zeros up to the next sector boundary, so that the following data is written without the sector buffer of FatFs.
+ */
+bool WriteBehind_padToSector(uint8_t aFileHandle) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    if (allocateRequest(REQUEST_PAD, aFileHandle, 0) == NULL) {
+        return false;
+    }
+    commitRequest();
+    return true;
+}
+
+/**
+ * Queues f_sync(). The callback is called after all data queued before for this file is written and synced.
+ * @param aCallback may be NULL
+ */
+bool WriteBehind_sync(uint8_t aFileHandle, WriteBehindCallback aCallback, void *aContext) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_SYNC, aFileHandle, 0);
+    if (tRequest == NULL) {
+        return false;
+    }
+    tRequest->Callback = aCallback;
+    tRequest->Context = aContext;
+    commitRequest();
+    return true;
+}
+
+/**
+ * Queues f_close(). Uses the queue entry reserved by WriteBehind_open(), so it fails only for an invalid handle.
+ * The file handle is invalid after this call and is released after execution of f_close().
+ * @param aCallback may be NULL
+ */
+bool WriteBehind_close(uint8_t aFileHandle, WriteBehindCallback aCallback, void *aContext) {
+    if (!isValidHandle(aFileHandle)) {
+        return false;
+    }
+    sReservedCount--;
+    WriteBehindRequestTypeDef *tRequest = allocateRequest(REQUEST_CLOSE, aFileHandle, 0);
+    tRequest->Callback = aCallback;
+    tRequest->Context = aContext;
+    sFiles[aFileHandle].IsCloseQueued = true;
+    commitRequest();
+    return true;
+}
+
+static void setError(WriteBehindFileTypeDef *aFile, FRESULT aResult) {
+    if (aResult != FR_OK) {
+        sStatistics.Errors++;
+        sStatistics.LastError = aResult;
+        if (aFile->Result == FR_OK) {
+            aFile->Result = aResult;
+        }
+    }
+}
+
+static FRESULT writeChunk(FIL *aFile, const void *aData, UINT aLength) {
+    UINT tCount;
+    FRESULT tResult = f_write(aFile, aData, aLength, &tCount);
+    if (tResult == FR_OK && tCount != aLength) {
+        tResult = FR_DENIED; // disk full
+    }
+    sStatistics.BytesWritten += tCount;
+    return tResult;
+}
+
+/*
+ * Writes the dirty sector buffer of the file like f_sync() does.
+ * This splits the card busy time of sync and close into 2 service calls.
+ * @return true if a sector was written
+ */
+static bool flushFileBuffer(WriteBehindFileTypeDef *aFile) {
+#if !_FS_TINY
+    if (aFile->Result == FR_OK && aFile->File.fs != NULL && (aFile->File.flag & FA__DIRTY)) {
+        if (disk_write(aFile->File.fs->drv, aFile->File.buf, aFile->File.dsect, 1) != RES_OK) {
+            setError(aFile, FR_DISK_ERR);
+        } else {
+            aFile->File.flag &= ~FA__DIRTY;
+        }
+        return true;
+    }
+#endif
+    return false;
+}
+
+/*
+ * Executes one step of the request.
+ * @return true if request is completed
+ */
+static bool executeRequest(WriteBehindRequestTypeDef *aRequest) {
+    WriteBehindFileTypeDef *tFile = &sFiles[aRequest->FileHandle];
+    UINT tLength;
+    FRESULT tResult = FR_OK;
+
+    switch (aRequest->Request) {
+    case REQUEST_OPEN: {
+        BYTE tMode = FA_CREATE_ALWAYS | FA_WRITE;
+        if (aRequest->FileOffset != 0) {
+            tMode = FA_OPEN_ALWAYS | FA_WRITE;
+        }
+        if (aRequest->BufferIndex + aRequest->Length > WRITE_BEHIND_BUFFER_SIZE) {
+            // file name wraps around, move it to the start of the ring buffer
+            TCHAR tFileName[_MAX_LFN + 1];
+            tLength = WRITE_BEHIND_BUFFER_SIZE - aRequest->BufferIndex;
+            memcpy(tFileName, &sBuffer[aRequest->BufferIndex], tLength);
+            memcpy((uint8_t *) tFileName + tLength, &sBuffer[0], aRequest->Length - tLength);
+            tResult = f_open(&tFile->File, tFileName, tMode);
+        } else {
+            tResult = f_open(&tFile->File, (const TCHAR *) &sBuffer[aRequest->BufferIndex], tMode);
+        }
+        if (tResult == FR_OK && aRequest->FileOffset != 0) {
+            tResult = f_lseek(&tFile->File, aRequest->FileOffset);
+        }
+        releaseBuffer(aRequest->Length);
+        setError(tFile, tResult);
+        return true;
+    }
+
+    case REQUEST_WRITE:
+        // write up to the end of the ring buffer, the remainder is written by the next call
+        tLength = aRequest->Length - aRequest->Done;
+        if (tLength > WRITE_BEHIND_BYTES_PER_SERVICE) {
+            tLength = WRITE_BEHIND_BYTES_PER_SERVICE;
+        }
+        if (tLength > (UINT) (WRITE_BEHIND_BUFFER_SIZE - sBufferOut)) {
+            tLength = WRITE_BEHIND_BUFFER_SIZE - sBufferOut;
+        }
+        if (tFile->Result == FR_OK) {
+            setError(tFile, writeChunk(&tFile->File, &sBuffer[sBufferOut], tLength));
+        }
+        releaseBuffer(tLength);
+        aRequest->Done += tLength;
+        return (aRequest->Done == aRequest->Length);
+
+    case REQUEST_REFERENCE:
+        tLength = aRequest->Length - aRequest->Done;
+        if (tLength > WRITE_BEHIND_BYTES_PER_SERVICE) {
+            tLength = WRITE_BEHIND_BYTES_PER_SERVICE;
+        }
+        if (tFile->Result != FR_OK) {
+            return true;
+        }
+        setError(tFile, writeChunk(&tFile->File, aRequest->DataPtr + aRequest->Done, tLength));
+        aRequest->Done += tLength;
+        return (aRequest->Done == aRequest->Length);
+
+    case REQUEST_GENERATED: {
+        if (tFile->Result != FR_OK) {
+            return true;
+        }
+        uint8_t tChunk[WRITE_BEHIND_GENERATOR_CHUNK_SIZE];
+        UINT tWrittenInThisCall = 0;
+        while (tWrittenInThisCall < WRITE_BEHIND_BYTES_PER_SERVICE) {
+            tLength = aRequest->Generator(tChunk, sizeof(tChunk), aRequest->Context);
+            if (tLength == 0) {
+                return true;
+            }
+            tResult = writeChunk(&tFile->File, tChunk, tLength);
+            if (tResult != FR_OK) {
+                setError(tFile, tResult);
+                return true;
+            }
+            tWrittenInThisCall += tLength;
+        }
+        return false;
+    }
+
+    case REQUEST_PAD: {
+        uint8_t tZeros[WRITE_BEHIND_GENERATOR_CHUNK_SIZE];
+        memset(tZeros, 0, sizeof(tZeros));
+        tLength = (_MAX_SS - (f_tell(&tFile->File) % _MAX_SS)) % _MAX_SS;
+        while (tFile->Result == FR_OK && tLength > 0) {
+            UINT tChunkLength = tLength;
+            if (tChunkLength > sizeof(tZeros)) {
+                tChunkLength = sizeof(tZeros);
+            }
+            setError(tFile, writeChunk(&tFile->File, tZeros, tChunkLength));
+            tLength -= tChunkLength;
+        }
+        return true;
+    }
+
+    case REQUEST_SYNC:
+        if (flushFileBuffer(tFile)) {
+            return false;
+        }
+        if (tFile->Result == FR_OK) {
+            setError(tFile, f_sync(&tFile->File));
+        }
+        if (aRequest->Callback != NULL) {
+            aRequest->Callback(tFile->Result, aRequest->Context);
+        }
+        return true;
+
+    case REQUEST_CLOSE:
+        if (flushFileBuffer(tFile)) {
+            return false;
+        }
+        if (tFile->File.fs != NULL) {
+            // file was opened successfully
+            setError(tFile, f_close(&tFile->File));
+        }
+        tFile->IsUsed = false;
+        if (aRequest->Callback != NULL) {
+            aRequest->Callback(tFile->Result, aRequest->Context);
+        }
+        return true;
+
+    default:
+        return true;
+    }
+}
+
+/**
+ * Executes the next step of the oldest request. Writes at most WRITE_BEHIND_BYTES_PER_SERVICE bytes.
+ * Returns immediately if the queue is empty or if the card is still programming.
+ * Callbacks are called from here.
+ */
+void WriteBehind_service(void) {
+    if (sQueueCount == 0) {
+        sLastServiceMicros = 0;
+        return;
+    }
+    uint32_t tStartMicros = micros();
+    if (sLastServiceMicros != 0 && tStartMicros - sLastServiceMicros > sStatistics.LoopMicrosMax) {
+        sStatistics.LoopMicrosMax = tStartMicros - sLastServiceMicros;
+    }
+    sLastServiceMicros = tStartMicros | 1; // avoid 0
+    sStatistics.ServiceCalls++;
+
+    if (!isCardReady()) {
+        sStatistics.BusyDeferrals++;
+        return;
+    }
+    if (executeRequest(&sQueue[sQueueOut])) {
+        sQueueOut = (sQueueOut + 1) % WRITE_BEHIND_QUEUE_SIZE;
+        sQueueCount--;
+    }
+    uint32_t tDuration = micros() - tStartMicros;
+    if (tDuration > sStatistics.ServiceMicrosMax) {
+        sStatistics.ServiceMicrosMax = tDuration;
+    }
+}
+
+/**
+ * Executes the queue until it is empty. For use before reading a file just written or before leaving a page.
+ * @return FR_TIMEOUT if queue is not empty after timeout. Errors are reported to the callbacks.
+ */
+FRESULT WriteBehind_waitForCompletion(uint32_t aTimeoutMillis) {
+    uint32_t tStartMillis = millis();
+    while (sQueueCount != 0) {
+        if (millis() - tStartMillis > aTimeoutMillis) {
+            return FR_TIMEOUT;
+        }
+        WriteBehind_service();
+    }
+    sLastServiceMicros = 0;
+    return FR_OK;
+}
+
+uint8_t WriteBehind_getQueueDepth(void) {
+    return sQueueCount;
+}
+
+const WriteBehindStatisticsTypeDef * WriteBehind_getStatistics(void) {
+    return &sStatistics;
+}
+
+void WriteBehind_resetStatistics(void) {
+    memset(&sStatistics, 0, sizeof(sStatistics));
+}
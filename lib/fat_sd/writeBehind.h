@@ -0,0 +1,93 @@
+/*
+ * @file writeBehind.h
+ *
+ * Write behind queue for FatFs, so that GUI callbacks never wait for the MicroSD card.
+ * Open, write, sync and close requests are appended to a bounded FIFO queue and return immediately.
+ * WriteBehind_service() executes the queue in small steps, at most one sector per call,
+ * and only if the card has finished programming the previous sector.
+ *
+ * Data can be queued in 3 ways:
+ * WriteBehind_write() copies the data into the internal ring buffer of WRITE_BEHIND_BUFFER_SIZE bytes.
+ * WriteBehind_writeReference() queues only the pointer. The data must not be changed until the close callback is called.
+ * WriteBehind_writeGenerated() calls a generator function from WriteBehind_service() which produces the data chunk by chunk.
+ *
+ * Ordering: all requests are executed in the order they were queued, so a sync or close callback
+ * is called after all data of this file queued before has been written.
+ * Errors: the first error of a file is stored, all following writes to this file are skipped
+ * and the error is reported to all sync and close callbacks of this file. The file is closed anyway.
+ *
+ * WriteBehind_service() must be called from the main loop. It may be called by a low priority interrupt instead,
+ * if the main loop does not use FatFs, since FatFs is compiled without reentrancy (_FS_REENTRANT = 0).
+ * Contains no HAL code and runs on the host with mmc_sim.c.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef WRITE_BEHIND_H_
+#define WRITE_BEHIND_H_
+
+#include "ff.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+#define WRITE_BEHIND_QUEUE_SIZE 16
+#define WRITE_BEHIND_BUFFER_SIZE 1024 // ring buffer for copied data and file names
+#define WRITE_BEHIND_MAX_FILES 2
+#define WRITE_BEHIND_BYTES_PER_SERVICE _MAX_SS // bytes written by one call of WriteBehind_service()
+#define WRITE_BEHIND_GENERATOR_CHUNK_SIZE 64 // size of buffer on stack, given to the generator function
+
+#define WRITE_BEHIND_INVALID_HANDLE 0xFF
+
+/*
+ * Is called by WriteBehind_service() after a sync or close request is completed.
+ * aResult is the first error of this file or FR_OK.
+ */
+typedef void (*WriteBehindCallback)(FRESULT aResult, void *aContext);
+/*
+ * Writes up to aSize bytes to aBuffer and returns the number of bytes written. Return 0 if all data is generated.
+ */
+typedef UINT (*WriteBehindGenerator)(uint8_t *aBuffer, UINT aSize, void *aContext);
+
+typedef struct {
+    uint32_t RequestsQueued;
+    uint32_t RequestsRejected; // queue, ring buffer or file handles full
+    uint32_t BytesWritten;
+    uint32_t ServiceCalls;
+    uint32_t BusyDeferrals; // WriteBehind_service() calls, which found the card still programming
+    uint32_t ServiceMicrosMax; // longest duration of one call of WriteBehind_service() - the time the loop is blocked
+    uint32_t LoopMicrosMax; // longest interval between 2 calls of WriteBehind_service() while queue was not empty
+    uint32_t Errors;
+    FRESULT LastError;
+    uint8_t QueueDepthMax;
+    uint16_t BufferUsedMax;
+} WriteBehindStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint8_t WriteBehind_open(const TCHAR *aFileName);
+uint8_t WriteBehind_openAt(const TCHAR *aFileName, DWORD aFileOffset);
+bool WriteBehind_write(uint8_t aFileHandle, const void *aData, UINT aLength);
+bool WriteBehind_writeReference(uint8_t aFileHandle, const void *aData, UINT aLength);
+bool WriteBehind_writeGenerated(uint8_t aFileHandle, WriteBehindGenerator aGenerator, void *aContext);
+bool WriteBehind_padToSector(uint8_t aFileHandle);
+bool WriteBehind_sync(uint8_t aFileHandle, WriteBehindCallback aCallback, void *aContext);
+bool WriteBehind_close(uint8_t aFileHandle, WriteBehindCallback aCallback, void *aContext);
+
+void WriteBehind_service(void);
+FRESULT WriteBehind_waitForCompletion(uint32_t aTimeoutMillis);
+
+uint8_t WriteBehind_getQueueDepth(void);
+const WriteBehindStatisticsTypeDef * WriteBehind_getStatistics(void);
+void WriteBehind_resetStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* WRITE_BEHIND_H_ */
@@ -0,0 +1,136 @@
+/*
+ * @file Profiler.h
+ *
+ * Profiler based on the DWT cycle counter CYCCNT, which counts CPU clocks and wraps every 59.6 s at 72 MHz.
+ *
+ * - Zones: PROFILER_ZONE(aId) at the start of a block records begin and end of the block in the trace.
+ *   Zones can be nested and a block can contain more than one zone, each ends at the end of the block.
+ * - ISRs: PROFILER_ISR_ENTER(aIsr, aLatencyCycles) at the start and PROFILER_ISR_EXIT(aIsr) before each return
+ *   of an ISR record begin and end in the trace and fill a duration histogram.
+ *   If the ISR can compute the cycles between interrupt request and entry, e.g. from the counter of its timer,
+ *   a latency histogram is filled too. Otherwise PROFILER_LATENCY_UNKNOWN is given.
+ * - Histogram bucket n counts values from 2^(n+3) to 2^(n+4) - 1 cycles, bucket 0 values below 16 cycles
+ *   and the last bucket all values from 2^18 cycles (3.6 ms at 72 MHz).
+ * - Trace: ring of the last PROFILER_TRACE_SIZE records. Writers reserve a record by an atomic increment
+ *   (LDREX / STREX on Cortex-M4), so ISRs can write without disabling interrupts.
+ *   A record is valid if its sequence matches its index, so a reader can skip records written just now.
+ *
+ * Profiler_dump() writes the names, the trace and the statistics as text lines,
+ * which are decoded to flame graph input by extras/ProfilerDecoder.cpp.
+ *
+ * Recording is off after boot and costs one test per call. Define DISABLE_PROFILER to remove all code.
+ * Contains no HAL code. On the host, define PROFILER_GET_CYCLES() to read a simulated cycle counter.
+ *
+ * RAM: 8 bytes per trace record + 76 bytes per ISR, 1556 bytes for the defaults.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if !defined(DISABLE_PROFILER)
+#define USE_PROFILER
+#endif
+
+#if !defined(PROFILER_TRACE_SIZE)
+#define PROFILER_TRACE_SIZE         128 // must be a power of 2
+#endif
+#define PROFILER_HISTOGRAM_BUCKETS  16
+
+/*
+ * ISR ids are also used as index of the statistics
+ */
+#define PROFILER_ISR_ADC_DMA        0 // DMA1_Channel1 DSO fast modes
+#define PROFILER_ISR_SPI_DMA        1 // DMA1_Channel2 MicroSD and touch
+#define PROFILER_ISR_ADC            2 // ADC1_2 DSO
+#define PROFILER_ISR_SYSTICK        3
+#define PROFILER_ISR_TIM15          4 // IR receive and send
+#define PROFILER_ISR_USART          5 // BlueDisplay USART TX
+#define PROFILER_ISR_PENDSV         6 // delay callbacks with DELAY_CALLBACKS_IN_PENDSV
+#define PROFILER_NUMBER_OF_ISRS     7
+
+#define PROFILER_ZONE_DELAY_CALLBACKS   7
+#define PROFILER_ZONE_DSO_LOOP          8
+#define PROFILER_ZONE_DSO_DRAW          9
+#define PROFILER_NUMBER_OF_IDS          10
+
+#define PROFILER_LATENCY_UNKNOWN    0xFFFFFFFF
+
+#define PROFILER_TRACE_BEGIN        0
+#define PROFILER_TRACE_END          1
+
+typedef struct {
+    uint32_t Cycles;
+    uint16_t Sequence; // lower 15 bits of index | 0x8000, 0 while writing
+    uint8_t Id;
+    uint8_t Type;
+} ProfilerTraceRecordStruct;
+
+typedef struct {
+    uint32_t Count;
+    uint32_t DurationMax;
+    uint32_t LatencyMax;
+    uint16_t DurationHistogram[PROFILER_HISTOGRAM_BUCKETS]; // saturating
+    uint16_t LatencyHistogram[PROFILER_HISTOGRAM_BUCKETS];
+} ProfilerIsrStatisticsStruct;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void Profiler_start(void);
+void Profiler_stop(void);
+bool Profiler_isRunning(void);
+
+uint32_t Profiler_isrEnter(uint8_t aIsr, uint32_t aLatencyCycles);
+void Profiler_isrExit(uint8_t aIsr, uint32_t aStartCycles);
+void Profiler_zoneBegin(uint8_t aId);
+void Profiler_zoneEnd(uint8_t aId);
+
+const char* Profiler_getName(uint8_t aId);
+const ProfilerIsrStatisticsStruct* Profiler_getIsrStatistics(uint8_t aIsr);
+uint32_t Profiler_getNumberOfTraceRecords(void);
+void Profiler_dump(void (*aWriteFunction)(const char *aString, uint8_t aLength));
+
+#ifdef __cplusplus
+}
+
+class ProfilerZone {
+public:
+    ProfilerZone(uint8_t aId) :
+            mId(aId) {
+        Profiler_zoneBegin(aId);
+    }
+    ~ProfilerZone() {
+        Profiler_zoneEnd(mId);
+    }
+private:
+    uint8_t mId;
+};
+#endif
+
+/*
+ * The zone variable gets the line number appended, so nested zones do not shadow each other
+ */
+#define PROFILER_CONCAT_(aName, aLine)  aName##aLine
+#define PROFILER_CONCAT(aName, aLine)   PROFILER_CONCAT_(aName, aLine)
+
+#if defined(USE_PROFILER)
+#define PROFILER_ISR_ENTER(aIsr, aLatencyCycles) uint32_t tProfilerStartCycles = Profiler_isrEnter(aIsr, aLatencyCycles)
+#define PROFILER_ISR_EXIT(aIsr)     Profiler_isrExit(aIsr, tProfilerStartCycles)
+#define PROFILER_ZONE(aId)          ProfilerZone PROFILER_CONCAT(tProfilerZone, __LINE__)(aId)
+#else
+#define PROFILER_ISR_ENTER(aIsr, aLatencyCycles) void()
+#define PROFILER_ISR_EXIT(aIsr)     void()
+#define PROFILER_ZONE(aId)          void()
+#endif
+
+#endif // _PROFILER_H
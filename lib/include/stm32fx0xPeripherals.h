@@ -49,8 +49,8 @@
  * C    |5  |SD CARD    |CS
  * C    |6  |TIM3       |Tone signal output
  * C    |7,8,9|DSO      |Attenuator control
- * C    |10 |USART3+4   |TX HC-05 Bluetooth
- * C    |11 |USART3+4   |RX HC-05 Bluetooth
+ * C    |10 |UART4      |TX HC-05 Bluetooth
+ * C    |11 |UART4      |RX HC-05 Bluetooth
  * C    |12 |DSO        |AC mode of preamplifier
  * C    |13 |Bluetooth  |HC-05 Bluetooth paired in
  * C    |14 |Intern     |Clock
@@ -89,7 +89,7 @@
  *
  * Timer    |Function
  * ---------|--------
- * 1        |
+ * 1        | SSD1289 DMA pixel clock
  * 2        | Frequency synthesizer
  * 3        | PWM tone generation -> Pin C6
  * 4        | PWM backlight led -> Pin F6
@@ -97,7 +97,7 @@
  * 7        | DAC Timebase
  * 8        |
  * 15       | IR handler Interrupt
- * 16       |
+ * 16       | Sensor acquisition burst Interrupt
  * 17       | PWM IR generation -> Pin B9
  *
  *
@@ -108,24 +108,39 @@
  * Prio | ISR Nr| Name                 | Usage
  * -----|------------------------------|-------------
  * 1    | 0x22 | ADC1_2_IRQ            | ADC EOC - need fixed timing
- * 3    | 0x27 | USART3_IRQ            | Usart3 TX - short ISR to empty TX/print buffer
+ * 2    | 0x0C | DMA1_Channel2_IRQ     | SPI1 RX DMA end of MicroSD sector transfer - higher than the screenshot button ISR, which writes to the card
+ *      |      |                       | and end of touch burst, which calls the touch filter (< 10 us)
+ * 3    | 0x34 | UART4_IRQ             | Uart4 TX - short ISR to empty TX/print buffer
  * 4    | 0x10 | WWDG_IRQ              | Watchdog - we have 0.9 ms to reload before reset
+ * 5    | 0x29 | TIM1_UP_TIM16_IRQ     | Sensor acquisition burst start - all sensor ISR same priority, higher than systic (touch uses SPI1)
+ * 5    | 0x33 | SPI1_IRQ              | Sensor acquisition L3GD20 transfer
+ * 5    | 0x2F | I2C1_EV_IRQ           | Sensor acquisition LSM303DLHC transfer
+ * 5    | 0x30 | I2C1_ER_IRQ           | Sensor acquisition LSM303DLHC transfer
+ * 5    | 0x21 | DMA1_Channel7_IRQ     | Sensor acquisition LSM303DLHC transfer
  * 6    | 0x16 | EXTI0_IRQ             | User button - for screenshots
  * 7    | 0x1A | TIM1_BRK_TIM15_IRQ    | IR - higher than systic
  * 8    | 0x0F | SysTick               | SysTick - 1 ms to catch - ISR may need longer because of callbacks e.g. local slider handling
  * 9    | 0x2A | USBWakeUp_IRQ         | USB Wakeup
  * 10   | 0x24 | USB_LP_CAN1_RX0_IRQ   | USB Transfer
- * 12   | 0x17 | EXTI1_IRQ             | Touch
+ * 11   | 0x1E | DMA1_Channel4_IRQ     | SSD1289 DMA end of fill or image
+ * 12   | 0x17 | EXTI1_IRQ             | Touch PENIRQ - only starts the sampling by SysTick and SPI1 DMA
  * 13   | 0x1B | DMA1_Channel1_IRQ     | ADC DMA - low because ISR takes almost complete CPU
  * 15   | 0x46 | TIM6_DAC_IRQ          | ADC Timer - not used yet
  * 15   | 0x1A | EXTI4_IRQ             | MMC card detect
+ * 15   | 0x0E | PendSV                | Delay callbacks expired in SysTick - only if DELAY_CALLBACKS_IN_PENDSV is defined
  *
  * DMA usage
  * ----------
  * DMA | Channel | Prio | Peripheral
  *   1 |       1 | high | ADC1
- *   1 |       2 |  low | USART3_TX
- *   1 |       3 |  low | USART3_RX
+ *   1 |       2 | high | SPI1_RX MicroSD and ADS7846 touch
+ *   1 |       3 | high | SPI1_TX MicroSD and ADS7846 touch
+ *   1 |       4 | high | TIM1_CH4 SSD1289 WR high
+ *   1 |       5 | high | TIM1_UP SSD1289 data port
+ *   1 |       6 | high | TIM1_CH3 SSD1289 WR low
+ *   1 |       7 |  low | I2C1_RX LSM303DLHC
+ *   2 |       3 |  low | UART4_RX
+ *   2 |       5 |  low | UART4_TX
  *
  * Backup register
  * DR0  | Unused |  because not existent on F103
@@ -220,6 +235,7 @@ extern ADC_HandleTypeDef ADC2Handle;
 extern DMA_HandleTypeDef DMA11_ADC1_Handle;
 extern TIM_HandleTypeDef TIM_DSOHandle;
 extern TIM_HandleTypeDef TIM15Handle;
+extern TIM_HandleTypeDef TIM16Handle;
 extern RTC_HandleTypeDef RTCHandle;
 //extern SPI_HandleTypeDef SPI1Handle;
 
@@ -460,6 +476,9 @@ int ADC1_getTemperatureMilligrades(void);
 float ADC_getTemperature(void);
 
 unsigned int AccuCapacity_ADCRead(uint8_t aProbeNumber);
+void AccuCapacity_ADCSelectProbe(uint8_t aProbeNumber);
+void AccuCapacity_ADCStartConversion(void);
+int AccuCapacity_ADCGetConversion(void);
 
 extern float sVDDA;
 extern float sADCToVoltFactor;  // Factor for ADC Reading -> Volt
@@ -540,6 +559,11 @@ void IR_Timer_initialize(uint16_t aAutoreload);
 void IR_Timer_Start(void);
 void IR_Timer_Stop(void);
 
+#define SENSOR_ACQUISITION_INTERRUPT_PRIORITY 5
+void Sensor_Timer_initialize(uint32_t aPeriodMicros);
+void Sensor_Timer_Start(void);
+void Sensor_Timer_Stop(void);
+
 void Synth_Timer_initialize(uint32_t aAutoreload);
 void Synth_Timer32_SetReloadValue(uint32_t aReloadValue);
 void Synth_Timer16_SetReloadValue(uint32_t aReloadValue, uint32_t aPrescalerValue);
@@ -563,9 +587,34 @@ extern SPI_HandleTypeDef * SPI1HandlePtr;
 uint8_t SPI1_sendReceiveFast(uint8_t byte);
 void SPI1_setPrescaler(uint16_t aPrescaler);
 
+/*
+ * SPI1 is shared by devices used in thread context, the touch sampler started by SysTick
+ * and the L3GD20 gyroscope read by the sensor acquisition ISR
+ */
+#define SPI1_USER_MICROSD   0
+#define SPI1_USER_TOUCH     1
+#define SPI1_USER_TOUCH_SAMPLER 2 // ADS7846 burst by DMA, is released by the DMA ISR
+#define SPI1_NUMBER_OF_THREAD_USERS 3
+void SPI1_acquire(uint8_t aUser);
+bool SPI1_tryAcquire(uint8_t aUser);
+void SPI1_release(uint8_t aUser);
+bool SPI1_tryAcquireFromISR(void);
+void SPI1_releaseFromISR(void);
+
+/*
+ * Full duplex SPI1 DMA for MicroSD sector transfers and touch sampling
+ */
+void SPI1_DMA_initialize(void);
+void SPI1_DMA_startTransfer(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength);
+void SPI1_DMA_startTransferWithCallback(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength,
+        void (*aTransferEndCallback)(bool aTransferError));
+bool SPI1_DMA_isTransferOngoing(void);
+bool SPI1_DMA_waitForTransferEnd(uint32_t aTimeoutMillis);
+
 bool MICROSD_isCardInserted(void);
 void MICROSD_CSEnable(void);
 void MICROSD_CSDisable(void);
+void MICROSD_releaseSPI(void);
 void MICROSD_ClearITPendingBit(void);
 
 #ifdef __cplusplus
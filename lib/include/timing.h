@@ -36,6 +36,17 @@ __STATIC_INLINE bool hasSysticCounted(void) {
     return (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk);
 }
 
+/*
+ * DWT cycle counter for measuring execution time of code sections
+ */
+__STATIC_INLINE void enableCycleCounter(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+__STATIC_INLINE uint32_t getCycleCounter(void) {
+    return DWT->CYCCNT;
+}
+
 // some milliseconds values for timing
 #define ONE_SECOND_MILLIS 1000
 #define TWO_SECONDS_MILLIS 2000
@@ -55,6 +66,18 @@ __STATIC_INLINE bool hasSysticCounted(void) {
 #define DISABLE_TIMER_DELAY_VALUE (0)
 
 #define SYS_TICK_INTERRUPT_PRIO 0x08
+/*
+ * Highest priority (lowest value) of the ISRs calling registerDelayCallback() or changeDelayCallback().
+ * The user button ISR calls tone() by the feedback tone of storeScreenshot().
+ * Delay callback list operations mask only the interrupts up to this priority, so e.g. the DSO ADC and SPI1 DMA ISRs are not delayed.
+ */
+#define DELAY_CALLBACK_CALLER_MAX_PRIO 0x06
+/*
+ * If defined, delay callbacks expired in SysTick are called by PendSV with lowest prio, so the SysTick ISR stays short.
+ * Callbacks are then interrupted by all other ISRs and must not rely on running before them.
+ */
+//#define DELAY_CALLBACKS_IN_PENDSV
+#define DELAY_CALLBACKS_PENDSV_PRIO 0x0F
 #define NUMBER_OF_PREEMPTIVE_PRIOS (1 << __NVIC_PRIO_BITS)
 
 extern volatile uint32_t TimeoutCounterForThread;
@@ -76,6 +99,7 @@ void testTimingsLoop(int aCount);
 extern "C" {
 #endif
 uint32_t millis(void);
+uint32_t micros(void);
 void delay(int32_t aTimeMillis);
 
 void setTimeoutMillis(int32_t aTimeMillis);
@@ -84,6 +108,18 @@ bool isTimeoutVerbose(uint8_t* file, uint32_t line, uint32_t aValue, int32_t aMe
 // for use in syscalls.c
 bool isTimeoutSimple(void);
 
+/*
+ * Wrap around safe timeout for busy waits, which are also called by ISRs with priority >= SysTick, where millis() stands still.
+ * In these ISRs the DWT cycle counter is used, so the timeout is limited to 59 seconds there.
+ */
+typedef struct {
+    uint32_t Start; // millis or cycles
+    uint32_t Duration; // millis or cycles
+    bool UseCycles;
+} WaitTimeoutTypeDef;
+void startWaitTimeout(WaitTimeoutTypeDef *aTimeout, uint32_t aTimeoutMillis);
+bool isWaitTimeout(const WaitTimeoutTypeDef *aTimeout);
+
 uint32_t LSM303DLHC_TIMEOUT_UserCallback(void);
 uint32_t L3GD20_TIMEOUT_UserCallback(void);
 #ifdef __cplusplus
@@ -0,0 +1,62 @@
+/*
+ * usbd_composite.h
+ *
+ * Composite USB device class with HID mouse + keyboard, CDC ACM virtual COM port and a vendor specific bulk interface.
+ * All three functions are available at the same time, so no re-enumeration is required to switch between them.
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef USBD_COMPOSITE_H_
+#define USBD_COMPOSITE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "usbd_def.h"
+#include "usbd_cdc.h" // for USBD_CDC_ItfTypeDef
+#include "usbd_composite_desc.h"
+#include <stdbool.h>
+
+#define HID_MOUSE_REPORT_ID         1
+#define HID_KEYBOARD_REPORT_ID      2
+
+/*
+ * Per function transfer statistics.
+ * The STM32 USB peripheral does not report NAKs sent to the host, so the NAK counters count the events causing them.
+ */
+typedef struct {
+    uint32_t BytesIn; // device to host, counted at transfer completion
+    uint32_t BytesOut; // host to device
+    uint32_t TransfersIn;
+    uint32_t PacketsOut;
+    uint32_t NAKsIn; // transmit requests rejected, because IN endpoint was still busy with the previous transfer
+    uint32_t NAKsOut; // received packets after which the OUT endpoint was left NAKing, because the application buffer was full
+} USBD_InterfaceStatisticsTypeDef;
+
+extern volatile USBD_InterfaceStatisticsTypeDef USBDInterfaceStatistics[COMPOSITE_NUMBER_OF_FUNCTIONS];
+
+extern USBD_ClassTypeDef USBD_COMPOSITE;
+extern USBD_CDC_ItfTypeDef USBD_CDC_fops; // from usbd_cdc_interface.c
+
+void USBD_Composite_registerCDCInterface(USBD_CDC_ItfTypeDef *aCDCInterface);
+void USBD_Composite_registerVendorReceiveCallback(void (*aVendorReceiveCallback)(uint8_t *aBuffer, uint32_t aLength));
+
+bool USBD_Composite_isINEndpointBusy(uint8_t aEndpointAddress);
+uint8_t USBD_Composite_transmit(uint8_t aEndpointAddress, uint8_t *aBuffer, uint16_t aLength);
+void USBD_Composite_CDC_prepareReceive(void);
+
+uint8_t USBD_Composite_HID_sendMouseReport(uint8_t aButtons, int8_t aDeltaX, int8_t aDeltaY, int8_t aWheel);
+uint8_t USBD_Composite_HID_sendKeyboardReport(uint8_t aModifiers, uint8_t aKeyCode);
+uint8_t USBD_Composite_Vendor_transmit(uint8_t *aBuffer, uint16_t aLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBD_COMPOSITE_H_ */
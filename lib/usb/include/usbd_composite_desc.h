@@ -0,0 +1,92 @@
+/*
+ * usbd_composite_desc.h
+ *
+ * Endpoint table, packet memory (PMA) allocator and configuration descriptor builder
+ * for the HID + CDC + vendor bulk composite device.
+ * Has no HAL or USB library dependencies, so it can be compiled and checked on a host.
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef USBD_COMPOSITE_DESC_H_
+#define USBD_COMPOSITE_DESC_H_
+
+#include <stdint.h>
+
+/*
+ * Interface numbers. CDC uses 2 interfaces, which are grouped by an interface association descriptor.
+ */
+#define COMPOSITE_HID_INTERFACE             0
+#define COMPOSITE_CDC_COMMAND_INTERFACE     1
+#define COMPOSITE_CDC_DATA_INTERFACE        2
+#define COMPOSITE_VENDOR_INTERFACE          3
+#define COMPOSITE_NUMBER_OF_INTERFACES      4
+
+/*
+ * Functions, used as index for the statistics
+ */
+#define COMPOSITE_FUNCTION_HID              0
+#define COMPOSITE_FUNCTION_CDC              1
+#define COMPOSITE_FUNCTION_VENDOR           2
+#define COMPOSITE_NUMBER_OF_FUNCTIONS       3
+
+/*
+ * Endpoint addresses. Bit 7 is set for IN (device to host) endpoints.
+ */
+#define COMPOSITE_HID_IN_EP                 0x81
+#define COMPOSITE_CDC_CMD_EP                0x82
+#define COMPOSITE_CDC_OUT_EP                0x03
+#define COMPOSITE_CDC_IN_EP                 0x83
+#define COMPOSITE_VENDOR_OUT_EP             0x04
+#define COMPOSITE_VENDOR_IN_EP              0x84
+#define COMPOSITE_HIGHEST_ENDPOINT_NUMBER   4
+
+#define COMPOSITE_EP0_PACKET_SIZE           64
+#define COMPOSITE_HID_PACKET_SIZE           16 // keyboard report including report ID requires 9 bytes
+#define COMPOSITE_CDC_CMD_PACKET_SIZE       8
+#define COMPOSITE_CDC_DATA_PACKET_SIZE      64
+#define COMPOSITE_VENDOR_PACKET_SIZE        64
+
+#define COMPOSITE_HID_INTERVAL_MILLIS       1 // host polls every frame, so reports are not delayed
+#define COMPOSITE_CDC_CMD_INTERVAL_MILLIS   16
+
+/*
+ * Same values as the USB specification and USBD_EP_TYPE_*
+ */
+#define ENDPOINT_TYPE_CONTROL               0
+#define ENDPOINT_TYPE_BULK                  2
+#define ENDPOINT_TYPE_INTERRUPT             3
+
+/*
+ * The STM32F303xB/C has 512 bytes dedicated packet memory.
+ * It starts with the buffer descriptor table (BTABLE), which has 8 bytes for each endpoint number in use.
+ */
+#define USB_PMA_SIZE                        512
+#define USB_PMA_BTABLE_ENTRY_SIZE           8
+#define USB_PMA_BUFFER_ALIGNMENT            8
+
+typedef struct {
+    uint8_t Address; // bit 7 set for IN endpoints
+    uint8_t Type; // ENDPOINT_TYPE_*
+    uint16_t MaxPacketSize;
+    uint8_t IntervalMillis; // only used for interrupt endpoints
+    uint8_t Function; // COMPOSITE_FUNCTION_* for statistics, 0xFF for EP0
+} USBD_EndpointConfigTypeDef;
+
+#define COMPOSITE_NUMBER_OF_ENDPOINTS       8 // including both directions of EP0
+extern const USBD_EndpointConfigTypeDef CompositeEndpoints[COMPOSITE_NUMBER_OF_ENDPOINTS];
+
+#define HID_DESCRIPTOR_LENGTH               9
+#define COMPOSITE_CONFIG_DESCRIPTOR_MAX_LENGTH 128
+
+const USBD_EndpointConfigTypeDef * getCompositeEndpointConfig(uint8_t aEndpointAddress);
+uint16_t USBD_PMA_allocate(const USBD_EndpointConfigTypeDef *aEndpoints, uint8_t aNumberOfEndpoints, uint16_t *aPMAAddresses,
+        uint16_t aPMASize);
+void USBD_Composite_buildHIDDescriptor(uint8_t *aBuffer, uint16_t aHIDReportDescriptorLength);
+uint16_t USBD_Composite_buildConfigDescriptor(uint8_t *aBuffer, uint16_t aBufferSize, uint16_t aHIDReportDescriptorLength);
+
+#endif /* USBD_COMPOSITE_DESC_H_ */
@@ -38,7 +38,7 @@
 /* Exported types ------------------------------------------------------------*/
 /* Exported constants --------------------------------------------------------*/
 /* Common Config */
-#define USBD_MAX_NUM_INTERFACES               1
+#define USBD_MAX_NUM_INTERFACES               4 /* HID, CDC command, CDC data, vendor bulk */
 #define USBD_MAX_NUM_CONFIGURATION            1
 #define USBD_MAX_STR_DESC_SIZ                 0x100
 #define USBD_SUPPORT_USER_STRING              0
@@ -60,13 +60,14 @@
 /* Exported macro ------------------------------------------------------------*/
 /* Memory management macros */
 
-/* For footprint reasons and since only one allocation is handled in the HID class
- driver, the malloc/free is changed into a static allocation method */
+/* For footprint reasons and since only one allocation is handled in the HID and CDC class
+ driver, the malloc/free is changed into a static allocation method.
+ The composite class (usbd_composite.c) uses only static variables and does not allocate */
 
 void *USBD_static_malloc(uint32_t size);
 void USBD_static_free(void *p);
 
-#define MAX_STATIC_ALLOC_SIZE     4 /*HID Class Driver Structure size*/
+#define MAX_STATIC_ALLOC_SIZE     140 /*CDC Class Driver Structure size, HID requires only 4*/
 
 #define USBD_malloc               (uint32_t *)USBD_static_malloc
 #define USBD_free                 USBD_static_free
@@ -0,0 +1,48 @@
+/*
+ * usbd_hid_cursor.h
+ *
+ * Cursor movement over the HID mouse function, decoupled from the display loop.
+ * The application sets a velocity, the SOF interrupt integrates it every millisecond
+ * and sends a report whenever at least one pixel is pending and the HID IN endpoint is free.
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef USBD_HID_CURSOR_H_
+#define USBD_HID_CURSOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define HID_CURSOR_FRACTION_BITS    8 // velocity and remainder are in 1/256 pixel
+#define HID_CURSOR_DEAD_ZONE        20 // tilt in 1/10 degree, which gives no movement
+
+typedef struct {
+    uint32_t Reports; // sent reports
+    uint32_t DeferredReports; // milliseconds a report was due, but the endpoint was still busy. Movement is sent with next report.
+    uint32_t ClippedPixels; // movement lost, because more than 127 pixel were pending
+    uint32_t LatencyMicrosSum; // time from first pending pixel to start of transmit
+    uint32_t LatencyMicrosMaximum;
+} HIDCursorStatisticsTypeDef;
+
+extern volatile HIDCursorStatisticsTypeDef HIDCursorStatistics;
+
+void HID_Cursor_start(void);
+void HID_Cursor_stop(void);
+void HID_Cursor_setVelocity(int32_t aVelocityX, int32_t aVelocityY);
+void HID_Cursor_setTilt(int16_t aTiltXTenthDegree, int16_t aTiltYTenthDegree, uint16_t aScale);
+void HID_Cursor_checkAndSendReport(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBD_HID_CURSOR_H_ */
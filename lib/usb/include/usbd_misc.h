@@ -33,7 +33,18 @@ bool isUSBReady(void);
 
 void CDC_TestSend(void);
 uint8_t * CDC_Loopback(void);
-void USB_ChangeToCDC(void);
-void USB_ChangeToJoystick(void);
+
+extern uint16_t USBPMABytesUsed; // set by USBD_LL_Init()
+
+/*
+ * Buffered CDC functions from usbd_cdc_interface.c, used for BlueDisplay transport and printf()
+ */
+extern volatile bool sUSBCDCIsBlueDisplayTransport;
+void CDC_checkAndStartTransmit(void);
+size_t CDC_getSendBufferFreeSpace(void);
+bool CDC_sendBuffer(uint8_t *aParameterBufferPointer, size_t aParameterBufferLength, uint8_t *aDataBufferPointer,
+        size_t aDataBufferLength);
+size_t CDC_getReceiveBytesAvailable(void);
+uint8_t CDC_getReceiveBufferByte(void);
 
 #endif /* USB_H_ */
@@ -27,6 +27,11 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_cdc.h"
+#include "usbd_composite.h"
+#include "usbd_misc.h"
+#include "timing.h" // for setTimeoutMillis() and isTimeoutSimple()
+
+#include <string.h> // for memcpy
 
 /** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
  * @{
@@ -37,12 +42,20 @@
  * @{
  */
 
+/*
+ * Sending is done by writing data into a circular send buffer.
+ * The content is transferred to the IN endpoint by CDC_checkAndStartTransmit(), which is called by the 1 ms SOF interrupt.
+ * Thus a lot of small BlueDisplay commands are collected and sent in one USB transfer.
+ * Receiving copies each packet of the OUT endpoint into a circular receive buffer
+ * which is read by CDC_getReceiveBufferByte() e.g. from serialEvent().
+ * If the receive buffer has no room for another packet, the OUT endpoint is not re-armed,
+ * so the host gets NAK until CDC_getReceiveBufferByte() has freed enough space. Thus no data is lost.
+ */
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
-//#define APP_RX_DATA_SIZE  2048
-//#define APP_TX_DATA_SIZE  2048
 #define APP_RX_DATA_SIZE  512
-#define APP_TX_DATA_SIZE  512
+#define APP_TX_DATA_SIZE  2048
+#define CDC_SEND_TIMEOUT_MILLIS 100 // the host application may not read any data
 
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
@@ -52,26 +65,25 @@ USBD_CDC_LineCodingTypeDef LineCoding = { 115200, /* baud rate*/
 0x08 /* nb. of bits 8*/
 };
 
-uint8_t UserRxBuffer[APP_RX_DATA_SIZE];/* Received Data over USB are stored in this buffer */
-uint8_t UserTxBuffer[APP_TX_DATA_SIZE];/* Received Data over UART (CDC interface) are stored in this buffer */
-uint32_t BuffLength;
-uint32_t UserTxBufPtrIn = 0;/* Increment this pointer or roll it back to
- start address when data are received over USART */
-uint32_t UserTxBufPtrOut = 0; /* Increment this pointer or roll it back to
- start address when data are sent over USB */
-
-/* UART handler declaration */
-UART_HandleTypeDef UartHandle;
-/* TIM handler declaration */
-TIM_HandleTypeDef TimHandle;
-/* USB handler declaration */
-extern USBD_HandleTypeDef hUSBDDevice;
+uint8_t UserRxBuffer[APP_RX_DATA_SIZE]; /* Received Data over USB are stored in this circular buffer */
+volatile uint32_t UserRxBufPtrIn = 0; /* only set by ISR */
+uint32_t UserRxBufPtrOut = 0; /* only set by thread */
+volatile uint32_t UserRxOverrunCount = 0;
+volatile bool UserRxIsPaused = false; /* true if OUT endpoint was not re-armed because of full buffer */
+
+uint8_t UserTxBuffer[APP_TX_DATA_SIZE] __attribute__ ((aligned(4))); /* Data to send over USB are stored in this circular buffer */
+volatile uint32_t UserTxBufPtrIn = 0; /* only set by thread - index of first free byte */
+volatile uint32_t UserTxBufPtrOut = 0; /* only set by ISR - index of first byte not yet transferred */
+volatile uint32_t UserTxTransferSize = 0; /* Size of ongoing IN transfer, 0 if no transfer is ongoing */
+
+volatile bool sUSBCDCIsBlueDisplayTransport = false; // if true, printf() output must not be sent over CDC
 
 /* Private function prototypes -----------------------------------------------*/
 static int8_t CDC_Itf_Init(void);
 static int8_t CDC_Itf_DeInit(void);
 static int8_t CDC_Itf_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length);
 static int8_t CDC_Itf_Receive(uint8_t* pbuf, uint32_t *Len);
+static size_t CDC_getReceiveBufferFreeSpace(void);
 
 USBD_CDC_ItfTypeDef USBD_CDC_fops = { CDC_Itf_Init, CDC_Itf_DeInit, CDC_Itf_Control, CDC_Itf_Receive };
 
@@ -85,8 +97,13 @@ USBD_CDC_ItfTypeDef USBD_CDC_fops = { CDC_Itf_Init, CDC_Itf_DeInit, CDC_Itf_Cont
  */
 static int8_t CDC_Itf_Init(void) {
     /*##-5- Set Application Buffers ############################################*/
-    USBD_CDC_SetTxBuffer(&hUSBDDevice, UserTxBuffer, 0);
-    USBD_CDC_SetRxBuffer(&hUSBDDevice, UserRxBuffer);
+    UserTxBufPtrIn = 0;
+    UserTxBufPtrOut = 0;
+    UserTxTransferSize = 0;
+    UserRxBufPtrIn = 0;
+    UserRxBufPtrOut = 0;
+    UserRxIsPaused = false;
+    USBD_Composite_CDC_prepareReceive();
 
     return (USBD_OK);
 }
@@ -98,6 +115,7 @@ static int8_t CDC_Itf_Init(void) {
  * @retval Result of the opeartion: USBD_OK if all operations are OK else USBD_FAIL
  */
 static int8_t CDC_Itf_DeInit(void) {
+    UserTxTransferSize = 0;
     return (USBD_OK);
 }
 
@@ -132,14 +150,12 @@ static int8_t CDC_Itf_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length) {
         break;
 
     case CDC_SET_LINE_CODING:
+        // Baud rate is meaningless for USB, just store it for CDC_GET_LINE_CODING
         LineCoding.bitrate = (uint32_t) (pbuf[0] | (pbuf[1] << 8) |\
  (pbuf[2] << 16) | (pbuf[3] << 24));
         LineCoding.format = pbuf[4];
         LineCoding.paritytype = pbuf[5];
         LineCoding.datatype = pbuf[6];
-
-        /* Set the new configuration */
-        ComPort_Config();
         break;
 
     case CDC_GET_LINE_CODING:
@@ -170,55 +186,178 @@ static int8_t CDC_Itf_Control(uint8_t cmd, uint8_t* pbuf, uint16_t length) {
 }
 
 /**
- * @brief  TIM period elapsed callback
- * @param  htim: TIM handle
- * @retval None
+ * Is called every millisecond by the SOF interrupt.
+ * Frees the buffer space of a completed transfer and starts a new transfer for the next contiguous chunk of the send buffer.
  */
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
-    uint32_t buffptr;
-    uint32_t buffsize;
-
-    if (UserTxBufPtrOut != UserTxBufPtrIn) {
-        if (UserTxBufPtrOut > UserTxBufPtrIn) /* rollback */
-        {
-            buffsize = APP_RX_DATA_SIZE - UserTxBufPtrOut;
+void CDC_checkAndStartTransmit(void) {
+    if (!isUsbCdcReady()) {
+        return;
+    }
+    if (UserTxTransferSize != 0) {
+        if (USBD_Composite_isINEndpointBusy(COMPOSITE_CDC_IN_EP)) {
+            return; // transfer still ongoing
+        }
+        // last transfer finished
+        uint32_t tBufPtrOut = UserTxBufPtrOut + UserTxTransferSize;
+        if (tBufPtrOut >= APP_TX_DATA_SIZE) {
+            tBufPtrOut = 0;
+        }
+        UserTxBufPtrOut = tBufPtrOut;
+        UserTxTransferSize = 0;
+    }
+
+    uint32_t tBufPtrIn = UserTxBufPtrIn;
+    if (UserTxBufPtrOut != tBufPtrIn) {
+        uint32_t tSize;
+        if (UserTxBufPtrOut > tBufPtrIn) {
+            // buffer wrap around - send tail of buffer first
+            tSize = APP_TX_DATA_SIZE - UserTxBufPtrOut;
         } else {
-            buffsize = UserTxBufPtrIn - UserTxBufPtrOut;
+            tSize = tBufPtrIn - UserTxBufPtrOut;
         }
+        // a terminating zero length packet is sent by the composite class if required
+        if (USBD_Composite_transmit(COMPOSITE_CDC_IN_EP, &UserTxBuffer[UserTxBufPtrOut], tSize) == USBD_OK) {
+            UserTxTransferSize = tSize;
+        }
+    }
+}
 
-        buffptr = UserTxBufPtrOut;
+/**
+ * @return number of bytes which can be written to the send buffer without waiting
+ */
+size_t CDC_getSendBufferFreeSpace(void) {
+    uint32_t tBufPtrOut = UserTxBufPtrOut;
+    if (tBufPtrOut > UserTxBufPtrIn) {
+        return tBufPtrOut - UserTxBufPtrIn - 1;
+    }
+    // one byte is always left free to distinguish between full and empty buffer
+    return APP_TX_DATA_SIZE - (UserTxBufPtrIn - tBufPtrOut) - 1;
+}
 
-        USBD_CDC_SetTxBuffer(&hUSBDDevice, (uint8_t*) &UserTxBuffer[buffptr], buffsize);
+/**
+ * Copy the bytes to send buffer and handle buffer wrap around
+ */
+static void CDC_putSendBuffer(uint8_t *aBufferPointer, size_t aLength) {
+    uint32_t tBufPtrIn = UserTxBufPtrIn;
+    size_t tSizeToEndOfBuffer = APP_TX_DATA_SIZE - tBufPtrIn;
+    if (aLength >= tSizeToEndOfBuffer) {
+        memcpy(&UserTxBuffer[tBufPtrIn], aBufferPointer, tSizeToEndOfBuffer);
+        aBufferPointer += tSizeToEndOfBuffer;
+        aLength -= tSizeToEndOfBuffer;
+        tBufPtrIn = 0;
+    }
+    memcpy(&UserTxBuffer[tBufPtrIn], aBufferPointer, aLength);
+    // the only statement which writes the variable UserTxBufPtrIn
+    UserTxBufPtrIn = tBufPtrIn + aLength;
+}
 
-        if (USBD_CDC_TransmitPacket(&hUSBDDevice) == USBD_OK) {
-            UserTxBufPtrOut += buffsize;
-            if (UserTxBufPtrOut == APP_RX_DATA_SIZE) {
-                UserTxBufPtrOut = 0;
+/**
+ * Copy content of both buffers to the send buffer. Transfer is started by next SOF interrupt.
+ * Data which does not fit in the send buffer is copied in chunks, waiting for free space.
+ * @return false if USB is not ready or host did not read the data in time. The remaining data is skipped then.
+ */
+bool CDC_sendBuffer(uint8_t *aParameterBufferPointer, size_t aParameterBufferLength, uint8_t *aDataBufferPointer,
+        size_t aDataBufferLength) {
+    if (!isUsbCdcReady()) {
+        return false;
+    }
+    setTimeoutMillis(CDC_SEND_TIMEOUT_MILLIS);
+    while (aParameterBufferLength + aDataBufferLength > 0) {
+        size_t tFreeSpace = CDC_getSendBufferFreeSpace();
+        if (tFreeSpace == 0) {
+            // blocking wait for SOF interrupt to free buffer
+            if (isTimeoutSimple()) {
+                return false;
+            }
+            continue;
+        }
+        if (aParameterBufferLength > 0) {
+            size_t tSize = aParameterBufferLength;
+            if (tSize > tFreeSpace) {
+                tSize = tFreeSpace;
+            }
+            CDC_putSendBuffer(aParameterBufferPointer, tSize);
+            aParameterBufferPointer += tSize;
+            aParameterBufferLength -= tSize;
+        } else {
+            size_t tSize = aDataBufferLength;
+            if (tSize > tFreeSpace) {
+                tSize = tFreeSpace;
             }
+            CDC_putSendBuffer(aDataBufferPointer, tSize);
+            aDataBufferPointer += tSize;
+            aDataBufferLength -= tSize;
         }
     }
+    return true;
 }
 
 /**
  * @brief  CDC_Itf_DataRx
- *         Data received over USB OUT endpoint are sent over CDC interface
+ *         Data received over USB OUT endpoint are copied to the circular receive buffer
  *         through this function.
  * @param  Buf: Buffer of data to be transmitted
  * @param  Len: Number of data received (in bytes)
  * @retval Result of the opeartion: USBD_OK if all operations are OK else USBD_FAIL
  */
 static int8_t CDC_Itf_Receive(uint8_t* Buf, uint32_t *Len) {
+    uint32_t tBufPtrIn = UserRxBufPtrIn;
+    uint32_t i;
+    for (i = 0; i < *Len; ++i) {
+        uint32_t tNextBufPtrIn = tBufPtrIn + 1;
+        if (tNextBufPtrIn >= APP_RX_DATA_SIZE) {
+            tNextBufPtrIn = 0;
+        }
+        if (tNextBufPtrIn == UserRxBufPtrOut) {
+            // buffer full, skip remaining bytes. BlueDisplay serialEvent() detects the missing sync token.
+            UserRxOverrunCount++;
+            break;
+        }
+        UserRxBuffer[tBufPtrIn] = *Buf++;
+        tBufPtrIn = tNextBufPtrIn;
+    }
+    UserRxBufPtrIn = tBufPtrIn;
+    // Packet is copied, so we can receive the next one, if there is room for it
+    if (CDC_getReceiveBufferFreeSpace() >= COMPOSITE_CDC_DATA_PACKET_SIZE) {
+        USBD_Composite_CDC_prepareReceive();
+    } else {
+        UserRxIsPaused = true;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].NAKsOut++;
+    }
     return (USBD_OK);
 }
 
+size_t CDC_getReceiveBytesAvailable(void) {
+    uint32_t tBufPtrIn = UserRxBufPtrIn;
+    if (tBufPtrIn >= UserRxBufPtrOut) {
+        return tBufPtrIn - UserRxBufPtrOut;
+    }
+    // buffer wrap around
+    return APP_RX_DATA_SIZE - (UserRxBufPtrOut - tBufPtrIn);
+}
+
+static size_t CDC_getReceiveBufferFreeSpace(void) {
+    // one byte is always left free to distinguish between full and empty buffer
+    return APP_RX_DATA_SIZE - 1 - CDC_getReceiveBytesAvailable();
+}
+
 /**
- * @brief  Tx Transfer completed callback
- * @param  huart: UART handle
- * @retval None
+ * Get a byte from receive buffer and handle buffer wrap around.
+ * Check CDC_getReceiveBytesAvailable() before calling!
  */
-void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart) {
-    /* Initiate next USB packet transfer once UART completes transfer (transmitting data over Tx line) */
-    //USBD_CDC_ReceivePacket(&hUSBDDevice);
+uint8_t CDC_getReceiveBufferByte(void) {
+    uint8_t tResult = UserRxBuffer[UserRxBufPtrOut];
+    uint32_t tBufPtrOut = UserRxBufPtrOut + 1;
+    if (tBufPtrOut >= APP_RX_DATA_SIZE) {
+        tBufPtrOut = 0;
+    }
+    UserRxBufPtrOut = tBufPtrOut;
+    if (UserRxIsPaused && CDC_getReceiveBufferFreeSpace() >= COMPOSITE_CDC_DATA_PACKET_SIZE) {
+        // Endpoint is not armed, so no receive interrupt can interfere here
+        UserRxIsPaused = false;
+        USBD_Composite_CDC_prepareReceive();
+    }
+    return tResult;
 }
 
 /**
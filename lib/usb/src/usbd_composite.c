@@ -0,0 +1,477 @@
+/**
+ * usbd_composite.c
+ *
+ * Composite USB device class with HID mouse + keyboard, CDC ACM virtual COM port and a vendor specific bulk interface.
+ *
+ * The single class drivers of the USB library can not be combined, since they all use pdev->pClassData
+ * and fixed endpoint addresses (e.g. 0x81 for HID IN as well as for CDC data IN).
+ * So the class requests of all three functions are handled here, using the endpoints of CompositeEndpoints[].
+ * The CDC application interface (usbd_cdc_interface.c) is kept and registered with USBD_Composite_registerCDCInterface().
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ *      Source based on STM code samples
+ * @version 1.0.0
+ */
+
+#include "usbd_composite.h"
+#include "usbd_ioreq.h"
+#include "usbd_hid.h" // for HID_REQ_*
+#include "usbd_misc.h" // for USBDDeviceHandle
+
+/*
+ * Mouse with 3 buttons and wheel (report ID 1) and keyboard (report ID 2)
+ */
+__ALIGN_BEGIN static const uint8_t HIDReportDescriptor[] __ALIGN_END = {
+/* Mouse */
+0x05, 0x01, /* Usage Page (Generic Desktop) */
+0x09, 0x02, /* Usage (Mouse) */
+0xA1, 0x01, /* Collection (Application) */
+0x85, HID_MOUSE_REPORT_ID, /* Report ID */
+0x09, 0x01, /*   Usage (Pointer) */
+0xA1, 0x00, /*   Collection (Physical) */
+0x05, 0x09, /*     Usage Page (Buttons) */
+0x19, 0x01, /*     Usage Minimum (1) */
+0x29, 0x03, /*     Usage Maximum (3) */
+0x15, 0x00, /*     Logical Minimum (0) */
+0x25, 0x01, /*     Logical Maximum (1) */
+0x95, 0x03, /*     Report Count (3) */
+0x75, 0x01, /*     Report Size (1) */
+0x81, 0x02, /*     Input (Data, Variable, Absolute) */
+0x95, 0x01, /*     Report Count (1) */
+0x75, 0x05, /*     Report Size (5) */
+0x81, 0x01, /*     Input (Constant) padding */
+0x05, 0x01, /*     Usage Page (Generic Desktop) */
+0x09, 0x30, /*     Usage (X) */
+0x09, 0x31, /*     Usage (Y) */
+0x09, 0x38, /*     Usage (Wheel) */
+0x15, 0x81, /*     Logical Minimum (-127) */
+0x25, 0x7F, /*     Logical Maximum (127) */
+0x75, 0x08, /*     Report Size (8) */
+0x95, 0x03, /*     Report Count (3) */
+0x81, 0x06, /*     Input (Data, Variable, Relative) */
+0xC0, /*   End Collection */
+0xC0, /* End Collection */
+/* Keyboard */
+0x05, 0x01, /* Usage Page (Generic Desktop) */
+0x09, 0x06, /* Usage (Keyboard) */
+0xA1, 0x01, /* Collection (Application) */
+0x85, HID_KEYBOARD_REPORT_ID, /* Report ID */
+0x05, 0x07, /*   Usage Page (Key Codes) */
+0x19, 0xE0, /*   Usage Minimum (224) */
+0x29, 0xE7, /*   Usage Maximum (231) */
+0x15, 0x00, /*   Logical Minimum (0) */
+0x25, 0x01, /*   Logical Maximum (1) */
+0x75, 0x01, /*   Report Size (1) */
+0x95, 0x08, /*   Report Count (8) */
+0x81, 0x02, /*   Input (Data, Variable, Absolute) modifier byte */
+0x95, 0x01, /*   Report Count (1) */
+0x75, 0x08, /*   Report Size (8) */
+0x81, 0x01, /*   Input (Constant) reserved byte */
+0x95, 0x06, /*   Report Count (6) */
+0x75, 0x08, /*   Report Size (8) */
+0x15, 0x00, /*   Logical Minimum (0) */
+0x25, 0x65, /*   Logical Maximum (101) */
+0x19, 0x00, /*   Usage Minimum (0) */
+0x29, 0x65, /*   Usage Maximum (101) */
+0x81, 0x00, /*   Input (Data, Array) key codes */
+0xC0 /* End Collection */
+};
+
+/* USB Standard Device Qualifier Descriptor */
+__ALIGN_BEGIN static const uint8_t USBD_Composite_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIER_DESC] __ALIGN_END = {
+USB_LEN_DEV_QUALIFIER_DESC, USB_DESC_TYPE_DEVICE_QUALIFIER, 0x00, 0x02, 0x00, 0x00, 0x00, 0x40, 0x01, 0x00, };
+
+__ALIGN_BEGIN static uint8_t sConfigDescriptor[COMPOSITE_CONFIG_DESCRIPTOR_MAX_LENGTH] __ALIGN_END;
+static uint16_t sConfigDescriptorLength = 0; // 0 -> not yet built
+__ALIGN_BEGIN static uint8_t sHIDDescriptor[HID_DESCRIPTOR_LENGTH] __ALIGN_END;
+
+volatile USBD_InterfaceStatisticsTypeDef USBDInterfaceStatistics[COMPOSITE_NUMBER_OF_FUNCTIONS];
+
+/*
+ * IN endpoint state, index is endpoint number. One byte per endpoint, since they are set by different interrupts and the thread.
+ * Set only by claimINEndpoint(), since transfers are started by the thread and by the SOF interrupt.
+ */
+static volatile uint8_t sINEndpointBusy[COMPOSITE_HIGHEST_ENDPOINT_NUMBER + 1];
+static uint16_t sINTransferLength[COMPOSITE_HIGHEST_ENDPOINT_NUMBER + 1]; // to detect the need of a zero length packet
+
+/*
+ * HID
+ */
+static uint32_t sHIDProtocol = 0;
+static uint32_t sHIDIdleState = 0;
+static uint32_t sAlternateSetting = 0; // only alternate setting 0 exists for all interfaces
+__ALIGN_BEGIN static uint8_t sHIDMouseReport[5] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t sHIDKeyboardReport[9] __ALIGN_END;
+
+/*
+ * CDC
+ */
+static USBD_CDC_ItfTypeDef *sCDCInterface = NULL;
+__ALIGN_BEGIN static uint8_t sCDCReceivePacketBuffer[COMPOSITE_CDC_DATA_PACKET_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t sCDCRequestData[CDC_DATA_FS_MAX_PACKET_SIZE] __ALIGN_END;
+#define CDC_NO_PENDING_REQUEST 0xFF
+static uint8_t sCDCPendingRequest = CDC_NO_PENDING_REQUEST; // request waiting for data stage on EP0
+static uint8_t sCDCPendingRequestLength;
+
+/*
+ * Vendor bulk
+ */
+__ALIGN_BEGIN static uint8_t sVendorReceivePacketBuffer[COMPOSITE_VENDOR_PACKET_SIZE] __ALIGN_END;
+static void (*sVendorReceiveCallback)(uint8_t *aBuffer, uint32_t aLength) = NULL;
+
+static uint8_t USBD_Composite_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_Composite_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_Composite_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_Composite_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_Composite_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_Composite_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t *USBD_Composite_GetConfigDescriptor(uint16_t *length);
+static uint8_t *USBD_Composite_GetDeviceQualifierDescriptor(uint16_t *length);
+
+USBD_ClassTypeDef USBD_COMPOSITE = { USBD_Composite_Init, USBD_Composite_DeInit, USBD_Composite_Setup, NULL, /*EP0_TxSent*/
+USBD_Composite_EP0_RxReady, USBD_Composite_DataIn, USBD_Composite_DataOut, NULL, /*SOF*/
+NULL, /*IsoINIncomplete*/
+NULL, /*IsoOUTIncomplete*/
+USBD_Composite_GetConfigDescriptor, USBD_Composite_GetConfigDescriptor, USBD_Composite_GetConfigDescriptor,
+        USBD_Composite_GetDeviceQualifierDescriptor, };
+
+void USBD_Composite_registerCDCInterface(USBD_CDC_ItfTypeDef *aCDCInterface) {
+    sCDCInterface = aCDCInterface;
+}
+
+/**
+ * The callback is called in USB interrupt context for each received packet and must copy the data.
+ * The OUT endpoint is re-armed after return of the callback.
+ */
+void USBD_Composite_registerVendorReceiveCallback(void (*aVendorReceiveCallback)(uint8_t *aBuffer, uint32_t aLength)) {
+    sVendorReceiveCallback = aVendorReceiveCallback;
+}
+
+static uint8_t USBD_Composite_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx) {
+    for (uint_fast8_t i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        const USBD_EndpointConfigTypeDef *tEndpoint = &CompositeEndpoints[i];
+        if ((tEndpoint->Address & 0x7F) != 0) {
+            USBD_LL_OpenEP(pdev, tEndpoint->Address, tEndpoint->Type, tEndpoint->MaxPacketSize);
+        }
+    }
+    for (uint_fast8_t i = 0; i <= COMPOSITE_HIGHEST_ENDPOINT_NUMBER; ++i) {
+        sINEndpointBusy[i] = 0;
+        sINTransferLength[i] = 0;
+    }
+    sCDCPendingRequest = CDC_NO_PENDING_REQUEST;
+
+    if (sCDCInterface != NULL) {
+        // The interface calls USBD_Composite_CDC_prepareReceive() if it is ready to receive
+        sCDCInterface->Init();
+    }
+    USBD_LL_PrepareReceive(pdev, COMPOSITE_VENDOR_OUT_EP, sVendorReceivePacketBuffer, COMPOSITE_VENDOR_PACKET_SIZE);
+    return USBD_OK;
+}
+
+static uint8_t USBD_Composite_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx) {
+    for (uint_fast8_t i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        if ((CompositeEndpoints[i].Address & 0x7F) != 0) {
+            USBD_LL_CloseEP(pdev, CompositeEndpoints[i].Address);
+        }
+    }
+    if (sCDCInterface != NULL) {
+        sCDCInterface->DeInit();
+    }
+    return USBD_OK;
+}
+
+/*
+ * Sends the smaller of the available and the requested length
+ */
+static void sendControlData(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req, const uint8_t *aData, uint16_t aLength) {
+    if (aLength > req->wLength) {
+        aLength = req->wLength;
+    }
+    USBD_CtlSendData(pdev, (uint8_t *) aData, aLength);
+}
+
+static uint8_t HID_ClassSetup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req) {
+    switch (req->bRequest) {
+    case HID_REQ_SET_PROTOCOL:
+        sHIDProtocol = (uint8_t) (req->wValue);
+        break;
+    case HID_REQ_GET_PROTOCOL:
+        USBD_CtlSendData(pdev, (uint8_t *) &sHIDProtocol, 1);
+        break;
+    case HID_REQ_SET_IDLE:
+        sHIDIdleState = (uint8_t) (req->wValue >> 8);
+        break;
+    case HID_REQ_GET_IDLE:
+        USBD_CtlSendData(pdev, (uint8_t *) &sHIDIdleState, 1);
+        break;
+    default:
+        USBD_CtlError(pdev, req);
+        return USBD_FAIL;
+    }
+    return USBD_OK;
+}
+
+static uint8_t CDC_ClassSetup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req) {
+    if (sCDCInterface == NULL) {
+        USBD_CtlError(pdev, req);
+        return USBD_FAIL;
+    }
+    uint16_t tLength = req->wLength;
+    if (tLength > sizeof(sCDCRequestData)) {
+        tLength = sizeof(sCDCRequestData);
+    }
+    if (tLength == 0) {
+        sCDCInterface->Control(req->bRequest, (uint8_t *) req, 0);
+    } else if (req->bmRequest & 0x80) {
+        // device to host
+        sCDCInterface->Control(req->bRequest, sCDCRequestData, tLength);
+        USBD_CtlSendData(pdev, sCDCRequestData, tLength);
+    } else {
+        // host to device, Control() is called by USBD_Composite_EP0_RxReady() after data stage
+        sCDCPendingRequest = req->bRequest;
+        sCDCPendingRequestLength = tLength;
+        USBD_CtlPrepareRx(pdev, sCDCRequestData, tLength);
+    }
+    return USBD_OK;
+}
+
+static uint8_t USBD_Composite_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req) {
+    uint8_t tInterface = LOBYTE(req->wIndex);
+
+    switch (req->bmRequest & USB_REQ_TYPE_MASK) {
+    case USB_REQ_TYPE_CLASS:
+        if (tInterface == COMPOSITE_HID_INTERFACE) {
+            return HID_ClassSetup(pdev, req);
+        }
+        if (tInterface == COMPOSITE_CDC_COMMAND_INTERFACE || tInterface == COMPOSITE_CDC_DATA_INTERFACE) {
+            return CDC_ClassSetup(pdev, req);
+        }
+        // vendor interface has no class requests
+        break;
+
+    case USB_REQ_TYPE_STANDARD:
+        switch (req->bRequest) {
+        case USB_REQ_GET_DESCRIPTOR:
+            if (tInterface == COMPOSITE_HID_INTERFACE) {
+                if ((req->wValue >> 8) == HID_REPORT_DESC) {
+                    sendControlData(pdev, req, HIDReportDescriptor, sizeof(HIDReportDescriptor));
+                    return USBD_OK;
+                } else if ((req->wValue >> 8) == HID_DESCRIPTOR_TYPE) {
+                    USBD_Composite_buildHIDDescriptor(sHIDDescriptor, sizeof(HIDReportDescriptor));
+                    sendControlData(pdev, req, sHIDDescriptor, HID_DESCRIPTOR_LENGTH);
+                    return USBD_OK;
+                }
+            }
+            break;
+        case USB_REQ_GET_INTERFACE:
+            USBD_CtlSendData(pdev, (uint8_t *) &sAlternateSetting, 1);
+            return USBD_OK;
+        case USB_REQ_SET_INTERFACE:
+            if (LOBYTE(req->wValue) == 0) {
+                return USBD_OK;
+            }
+            break;
+        default:
+            break;
+        }
+        break;
+
+    default:
+        break;
+    }
+    USBD_CtlError(pdev, req);
+    return USBD_FAIL;
+}
+
+static uint8_t USBD_Composite_EP0_RxReady(USBD_HandleTypeDef *pdev) {
+    if (sCDCInterface != NULL && sCDCPendingRequest != CDC_NO_PENDING_REQUEST) {
+        sCDCInterface->Control(sCDCPendingRequest, sCDCRequestData, sCDCPendingRequestLength);
+        sCDCPendingRequest = CDC_NO_PENDING_REQUEST;
+    }
+    return USBD_OK;
+}
+
+/*
+ * Transfer on IN endpoint completed
+ */
+static uint8_t USBD_Composite_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum) {
+    epnum &= 0x7F;
+    const USBD_EndpointConfigTypeDef *tEndpoint = getCompositeEndpointConfig(epnum | 0x80);
+    if (tEndpoint == NULL || epnum > COMPOSITE_HIGHEST_ENDPOINT_NUMBER) {
+        return USBD_FAIL;
+    }
+    uint16_t tLength = sINTransferLength[epnum];
+    sINTransferLength[epnum] = 0;
+    USBDInterfaceStatistics[tEndpoint->Function].BytesIn += tLength;
+    USBDInterfaceStatistics[tEndpoint->Function].TransfersIn++;
+
+    if (tEndpoint->Type == ENDPOINT_TYPE_BULK && tLength > 0 && (tLength % tEndpoint->MaxPacketSize) == 0) {
+        // Transfer ended with a full packet, so host needs a zero length packet to detect the end of transfer. Endpoint stays busy.
+        USBD_LL_Transmit(pdev, tEndpoint->Address, NULL, 0);
+        return USBD_OK;
+    }
+    sINEndpointBusy[epnum] = 0;
+    return USBD_OK;
+}
+
+/*
+ * Packet on OUT endpoint received
+ */
+static uint8_t USBD_Composite_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum) {
+    uint32_t tLength = USBD_LL_GetRxDataSize(pdev, epnum);
+    if (epnum == COMPOSITE_CDC_OUT_EP) {
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].BytesOut += tLength;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_CDC].PacketsOut++;
+        if (sCDCInterface != NULL) {
+            // The interface calls USBD_Composite_CDC_prepareReceive() if it has room for the next packet
+            sCDCInterface->Receive(sCDCReceivePacketBuffer, &tLength);
+        }
+    } else if (epnum == COMPOSITE_VENDOR_OUT_EP) {
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_VENDOR].BytesOut += tLength;
+        USBDInterfaceStatistics[COMPOSITE_FUNCTION_VENDOR].PacketsOut++;
+        if (sVendorReceiveCallback != NULL) {
+            sVendorReceiveCallback(sVendorReceivePacketBuffer, tLength);
+        }
+        USBD_LL_PrepareReceive(pdev, COMPOSITE_VENDOR_OUT_EP, sVendorReceivePacketBuffer, COMPOSITE_VENDOR_PACKET_SIZE);
+    } else {
+        return USBD_FAIL;
+    }
+    return USBD_OK;
+}
+
+static uint8_t *USBD_Composite_GetConfigDescriptor(uint16_t *length) {
+    if (sConfigDescriptorLength == 0) {
+        sConfigDescriptorLength = USBD_Composite_buildConfigDescriptor(sConfigDescriptor, sizeof(sConfigDescriptor),
+                sizeof(HIDReportDescriptor));
+        assert_param(sConfigDescriptorLength != 0);
+    }
+    *length = sConfigDescriptorLength;
+    return sConfigDescriptor;
+}
+
+static uint8_t *USBD_Composite_GetDeviceQualifierDescriptor(uint16_t *length) {
+    *length = sizeof(USBD_Composite_DeviceQualifierDesc);
+    return (uint8_t *) USBD_Composite_DeviceQualifierDesc;
+}
+
+/*******************************************************************************
+ API for the application
+ *******************************************************************************/
+
+bool USBD_Composite_isINEndpointBusy(uint8_t aEndpointAddress) {
+    return sINEndpointBusy[aEndpointAddress & 0x7F] != 0;
+}
+
+/*
+ * Test and set of the busy flag by LDREXB / STREXB, so a transmit of an ISR between test and set
+ * of the thread lets the STREXB fail and the thread sees the endpoint busy.
+ * @return true if the endpoint was free and is now reserved for the caller
+ */
+static bool claimINEndpoint(const USBD_EndpointConfigTypeDef *aEndpoint) {
+    volatile uint8_t *tBusyPointer = &sINEndpointBusy[aEndpoint->Address & 0x7F];
+    do {
+        if (__LDREXB(tBusyPointer) != 0) {
+            __CLREX();
+            USBDInterfaceStatistics[aEndpoint->Function].NAKsIn++;
+            return false;
+        }
+    } while (__STREXB(1, tBusyPointer));
+    return true;
+}
+
+/*
+ * Endpoint must be claimed by claimINEndpoint()
+ */
+static void startINTransfer(const USBD_EndpointConfigTypeDef *aEndpoint, uint8_t *aBuffer, uint16_t aLength) {
+    sINTransferLength[aEndpoint->Address & 0x7F] = aLength;
+    USBD_LL_Transmit(&USBDDeviceHandle, aEndpoint->Address, aBuffer, aLength);
+}
+
+/*
+ * @param aEndpointPointer is set to the config of the claimed endpoint
+ * @return USBD_OK if the endpoint is claimed, USBD_BUSY if it is busy, USBD_FAIL if the device is not configured
+ */
+static uint8_t getAndClaimINEndpoint(uint8_t aEndpointAddress, const USBD_EndpointConfigTypeDef **aEndpointPointer) {
+    const USBD_EndpointConfigTypeDef *tEndpoint = getCompositeEndpointConfig(aEndpointAddress);
+    if (tEndpoint == NULL || USBDDeviceHandle.dev_state != USBD_STATE_CONFIGURED) {
+        return USBD_FAIL;
+    }
+    if (!claimINEndpoint(tEndpoint)) {
+        return USBD_BUSY;
+    }
+    *aEndpointPointer = tEndpoint;
+    return USBD_OK;
+}
+
+/**
+ * Starts an IN transfer. Transfers larger than the packet size are split by the PCD driver.
+ * The buffer content must not be changed until USBD_Composite_isINEndpointBusy() returns false.
+ * @return USBD_BUSY if the previous transfer on this endpoint is not yet finished. The NAKsIn counter is incremented then.
+ */
+uint8_t USBD_Composite_transmit(uint8_t aEndpointAddress, uint8_t *aBuffer, uint16_t aLength) {
+    const USBD_EndpointConfigTypeDef *tEndpoint;
+    uint8_t tStatus = getAndClaimINEndpoint(aEndpointAddress, &tEndpoint);
+    if (tStatus == USBD_OK) {
+        startINTransfer(tEndpoint, aBuffer, aLength);
+    }
+    return tStatus;
+}
+
+/**
+ * Arms the CDC OUT endpoint for the next packet. Until then, the host gets NAK for its OUT packets.
+ */
+void USBD_Composite_CDC_prepareReceive(void) {
+    USBD_LL_PrepareReceive(&USBDDeviceHandle, COMPOSITE_CDC_OUT_EP, sCDCReceivePacketBuffer, COMPOSITE_CDC_DATA_PACKET_SIZE);
+}
+
+/**
+ * @param aButtons bit 0 left, bit 1 right, bit 2 middle button
+ * @return USBD_BUSY if previous report was not yet fetched by host
+ */
+uint8_t USBD_Composite_HID_sendMouseReport(uint8_t aButtons, int8_t aDeltaX, int8_t aDeltaY, int8_t aWheel) {
+    // claim before writing the report, since it may still be in transfer
+    const USBD_EndpointConfigTypeDef *tEndpoint;
+    uint8_t tStatus = getAndClaimINEndpoint(COMPOSITE_HID_IN_EP, &tEndpoint);
+    if (tStatus != USBD_OK) {
+        return tStatus;
+    }
+    sHIDMouseReport[0] = HID_MOUSE_REPORT_ID;
+    sHIDMouseReport[1] = aButtons;
+    sHIDMouseReport[2] = aDeltaX;
+    sHIDMouseReport[3] = aDeltaY;
+    sHIDMouseReport[4] = aWheel;
+    startINTransfer(tEndpoint, sHIDMouseReport, sizeof(sHIDMouseReport));
+    return USBD_OK;
+}
+
+/**
+ * Sends one key code. A key release must be sent with aKeyCode = 0.
+ * @param aModifiers bit 0 left ctrl, bit 1 left shift, bit 2 left alt, bit 3 left GUI, bit 4 to 7 for the right ones
+ * @return USBD_BUSY if previous report was not yet fetched by host
+ */
+uint8_t USBD_Composite_HID_sendKeyboardReport(uint8_t aModifiers, uint8_t aKeyCode) {
+    const USBD_EndpointConfigTypeDef *tEndpoint;
+    uint8_t tStatus = getAndClaimINEndpoint(COMPOSITE_HID_IN_EP, &tEndpoint);
+    if (tStatus != USBD_OK) {
+        return tStatus;
+    }
+    sHIDKeyboardReport[0] = HID_KEYBOARD_REPORT_ID;
+    sHIDKeyboardReport[1] = aModifiers;
+    sHIDKeyboardReport[2] = 0;
+    sHIDKeyboardReport[3] = aKeyCode;
+    for (uint_fast8_t i = 4; i < sizeof(sHIDKeyboardReport); ++i) {
+        sHIDKeyboardReport[i] = 0;
+    }
+    startINTransfer(tEndpoint, sHIDKeyboardReport, sizeof(sHIDKeyboardReport));
+    return USBD_OK;
+}
+
+/**
+ * Buffer content must not be changed until USBD_Composite_isINEndpointBusy(COMPOSITE_VENDOR_IN_EP) returns false.
+ */
+uint8_t USBD_Composite_Vendor_transmit(uint8_t *aBuffer, uint16_t aLength) {
+    return USBD_Composite_transmit(COMPOSITE_VENDOR_IN_EP, aBuffer, aLength);
+}
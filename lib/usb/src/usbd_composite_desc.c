@@ -0,0 +1,199 @@
+/**
+ * usbd_composite_desc.c
+ *
+ * Endpoint table, packet memory (PMA) allocator and configuration descriptor builder
+ * for the HID + CDC + vendor bulk composite device.
+ *
+ * The endpoint table is the only place where endpoint addresses, sizes and types are specified.
+ * The packet memory layout in USBD_LL_Init() and the endpoint descriptors are derived from it,
+ * so they can not get out of sync.
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "usbd_composite_desc.h"
+#include <stddef.h> // for NULL
+
+/*
+ * Packet memory budget for the 512 bytes of PMA:
+ * BTABLE 5 * 8 = 40, EP0 64 + 64, HID IN 16, CDC command 8, CDC data 64 + 64, vendor bulk 64 + 64 -> 448 bytes used.
+ * There is not enough memory left for double buffering the bulk endpoints.
+ */
+const USBD_EndpointConfigTypeDef CompositeEndpoints[COMPOSITE_NUMBER_OF_ENDPOINTS] = {
+/* Address, Type, MaxPacketSize, IntervalMillis, Function */
+{ 0x00, ENDPOINT_TYPE_CONTROL, COMPOSITE_EP0_PACKET_SIZE, 0, 0xFF },
+{ 0x80, ENDPOINT_TYPE_CONTROL, COMPOSITE_EP0_PACKET_SIZE, 0, 0xFF },
+{ COMPOSITE_HID_IN_EP, ENDPOINT_TYPE_INTERRUPT, COMPOSITE_HID_PACKET_SIZE, COMPOSITE_HID_INTERVAL_MILLIS, COMPOSITE_FUNCTION_HID },
+{ COMPOSITE_CDC_CMD_EP, ENDPOINT_TYPE_INTERRUPT, COMPOSITE_CDC_CMD_PACKET_SIZE, COMPOSITE_CDC_CMD_INTERVAL_MILLIS,
+COMPOSITE_FUNCTION_CDC },
+{ COMPOSITE_CDC_OUT_EP, ENDPOINT_TYPE_BULK, COMPOSITE_CDC_DATA_PACKET_SIZE, 0, COMPOSITE_FUNCTION_CDC },
+{ COMPOSITE_CDC_IN_EP, ENDPOINT_TYPE_BULK, COMPOSITE_CDC_DATA_PACKET_SIZE, 0, COMPOSITE_FUNCTION_CDC },
+{ COMPOSITE_VENDOR_OUT_EP, ENDPOINT_TYPE_BULK, COMPOSITE_VENDOR_PACKET_SIZE, 0, COMPOSITE_FUNCTION_VENDOR },
+{ COMPOSITE_VENDOR_IN_EP, ENDPOINT_TYPE_BULK, COMPOSITE_VENDOR_PACKET_SIZE, 0, COMPOSITE_FUNCTION_VENDOR } };
+
+/**
+ * @return NULL if endpoint address is not in table
+ */
+const USBD_EndpointConfigTypeDef * getCompositeEndpointConfig(uint8_t aEndpointAddress) {
+    for (uint_fast8_t i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        if (CompositeEndpoints[i].Address == aEndpointAddress) {
+            return &CompositeEndpoints[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Assigns a packet memory address to each endpoint buffer, starting directly after the BTABLE.
+ * OUT buffers larger than 62 bytes are allocated in blocks of 32 bytes, as required by the COUNTn_RX register format.
+ * @param aPMAAddresses receives the buffer address for each endpoint of aEndpoints
+ * @return number of bytes of packet memory used including BTABLE, or 0 if aPMASize is exceeded
+ */
+uint16_t USBD_PMA_allocate(const USBD_EndpointConfigTypeDef *aEndpoints, uint8_t aNumberOfEndpoints, uint16_t *aPMAAddresses,
+        uint16_t aPMASize) {
+    uint8_t tHighestEndpointNumber = 0;
+    for (uint_fast8_t i = 0; i < aNumberOfEndpoints; ++i) {
+        uint8_t tEndpointNumber = aEndpoints[i].Address & 0x7F;
+        if (tEndpointNumber > tHighestEndpointNumber) {
+            tHighestEndpointNumber = tEndpointNumber;
+        }
+    }
+
+    uint16_t tNextFreeAddress = (tHighestEndpointNumber + 1) * USB_PMA_BTABLE_ENTRY_SIZE;
+    for (uint_fast8_t i = 0; i < aNumberOfEndpoints; ++i) {
+        uint16_t tBufferSize = aEndpoints[i].MaxPacketSize;
+        if ((aEndpoints[i].Address & 0x80) == 0 && tBufferSize > 62) {
+            tBufferSize = (tBufferSize + 31) & ~31;
+        }
+        tBufferSize = (tBufferSize + (USB_PMA_BUFFER_ALIGNMENT - 1)) & ~(USB_PMA_BUFFER_ALIGNMENT - 1);
+        if (tNextFreeAddress + tBufferSize > aPMASize) {
+            return 0;
+        }
+        aPMAAddresses[i] = tNextFreeAddress;
+        tNextFreeAddress += tBufferSize;
+    }
+    return tNextFreeAddress;
+}
+
+/*
+ * Descriptor writer with overflow detection.
+ */
+typedef struct {
+    uint8_t *Buffer;
+    uint16_t Size;
+    uint16_t Length;
+    uint8_t Overflow;
+} DescriptorWriterTypeDef;
+
+static void addBytes(DescriptorWriterTypeDef *aWriter, const uint8_t *aBytes, uint8_t aLength) {
+    if (aWriter->Length + aLength > aWriter->Size) {
+        aWriter->Overflow = 1;
+        return;
+    }
+    for (uint_fast8_t i = 0; i < aLength; ++i) {
+        aWriter->Buffer[aWriter->Length++] = aBytes[i];
+    }
+}
+
+static void addInterface(DescriptorWriterTypeDef *aWriter, uint8_t aInterfaceNumber, uint8_t aNumberOfEndpoints, uint8_t aClass,
+        uint8_t aSubClass, uint8_t aProtocol) {
+    const uint8_t tDescriptor[9] = { 9, 0x04 /*INTERFACE*/, aInterfaceNumber, 0 /*bAlternateSetting*/, aNumberOfEndpoints, aClass,
+            aSubClass, aProtocol, 0 /*iInterface*/};
+    addBytes(aWriter, tDescriptor, sizeof(tDescriptor));
+}
+
+/*
+ * Endpoint descriptor content is taken from the endpoint table
+ */
+static void addEndpoint(DescriptorWriterTypeDef *aWriter, uint8_t aEndpointAddress) {
+    const USBD_EndpointConfigTypeDef *tEndpoint = getCompositeEndpointConfig(aEndpointAddress);
+    if (tEndpoint == NULL) {
+        aWriter->Overflow = 1;
+        return;
+    }
+    const uint8_t tDescriptor[7] = { 7, 0x05 /*ENDPOINT*/, tEndpoint->Address, tEndpoint->Type, (uint8_t) tEndpoint->MaxPacketSize,
+            (uint8_t) (tEndpoint->MaxPacketSize >> 8), tEndpoint->IntervalMillis };
+    addBytes(aWriter, tDescriptor, sizeof(tDescriptor));
+}
+
+/**
+ * The HID descriptor is also requested separately by the host with GET_DESCRIPTOR(HID)
+ * @param aBuffer must have room for HID_DESCRIPTOR_LENGTH bytes
+ */
+void USBD_Composite_buildHIDDescriptor(uint8_t *aBuffer, uint16_t aHIDReportDescriptorLength) {
+    aBuffer[0] = HID_DESCRIPTOR_LENGTH;
+    aBuffer[1] = 0x21; // HID
+    aBuffer[2] = 0x11; // bcdHID 1.11
+    aBuffer[3] = 0x01;
+    aBuffer[4] = 0x00; // bCountryCode
+    aBuffer[5] = 0x01; // bNumDescriptors
+    aBuffer[6] = 0x22; // REPORT
+    aBuffer[7] = (uint8_t) aHIDReportDescriptorLength;
+    aBuffer[8] = (uint8_t) (aHIDReportDescriptorLength >> 8);
+}
+
+/**
+ * Builds the complete configuration descriptor with:
+ * Interface 0 HID mouse and keyboard with one interrupt IN endpoint.
+ * Interface 1 + 2 CDC ACM virtual COM port, grouped by an interface association descriptor.
+ * Interface 3 vendor specific with one bulk endpoint pair, e.g. for fast streaming of sample data with libusb.
+ * @return length of descriptor or 0 if aBufferSize is too small
+ */
+uint16_t USBD_Composite_buildConfigDescriptor(uint8_t *aBuffer, uint16_t aBufferSize, uint16_t aHIDReportDescriptorLength) {
+    DescriptorWriterTypeDef tWriter = { aBuffer, aBufferSize, 0, 0 };
+
+    // wTotalLength is patched at the end
+    const uint8_t tConfigurationDescriptor[9] = { 9, 0x02 /*CONFIGURATION*/, 0, 0, COMPOSITE_NUMBER_OF_INTERFACES, 1 /*bConfigurationValue*/,
+            0 /*iConfiguration*/, 0xC0 /*self powered*/, 0x32 /*100 mA*/};
+    addBytes(&tWriter, tConfigurationDescriptor, sizeof(tConfigurationDescriptor));
+
+    /*
+     * HID
+     */
+    addInterface(&tWriter, COMPOSITE_HID_INTERFACE, 1, 0x03 /*HID*/, 0x00 /*no boot*/, 0x00);
+    uint8_t tHIDDescriptor[HID_DESCRIPTOR_LENGTH];
+    USBD_Composite_buildHIDDescriptor(tHIDDescriptor, aHIDReportDescriptorLength);
+    addBytes(&tWriter, tHIDDescriptor, sizeof(tHIDDescriptor));
+    addEndpoint(&tWriter, COMPOSITE_HID_IN_EP);
+
+    /*
+     * CDC ACM
+     */
+    const uint8_t tInterfaceAssociationDescriptor[8] = { 8, 0x0B /*INTERFACE_ASSOCIATION*/, COMPOSITE_CDC_COMMAND_INTERFACE, 2,
+            0x02 /*CDC*/, 0x02 /*ACM*/, 0x01 /*AT commands*/, 0 /*iFunction*/};
+    addBytes(&tWriter, tInterfaceAssociationDescriptor, sizeof(tInterfaceAssociationDescriptor));
+    addInterface(&tWriter, COMPOSITE_CDC_COMMAND_INTERFACE, 1, 0x02 /*CDC*/, 0x02 /*ACM*/, 0x01 /*AT commands*/);
+    const uint8_t tCDCFunctionalDescriptors[19] = {
+    /* Header: bcdCDC 1.10 */
+    5, 0x24 /*CS_INTERFACE*/, 0x00, 0x10, 0x01,
+    /* Call management: no call management, data interface */
+    5, 0x24, 0x01, 0x00, COMPOSITE_CDC_DATA_INTERFACE,
+    /* ACM: supports line coding and serial state */
+    4, 0x24, 0x02, 0x02,
+    /* Union: master and slave interface */
+    5, 0x24, 0x06, COMPOSITE_CDC_COMMAND_INTERFACE, COMPOSITE_CDC_DATA_INTERFACE };
+    addBytes(&tWriter, tCDCFunctionalDescriptors, sizeof(tCDCFunctionalDescriptors));
+    addEndpoint(&tWriter, COMPOSITE_CDC_CMD_EP);
+
+    addInterface(&tWriter, COMPOSITE_CDC_DATA_INTERFACE, 2, 0x0A /*CDC data*/, 0x00, 0x00);
+    addEndpoint(&tWriter, COMPOSITE_CDC_OUT_EP);
+    addEndpoint(&tWriter, COMPOSITE_CDC_IN_EP);
+
+    /*
+     * Vendor bulk
+     */
+    addInterface(&tWriter, COMPOSITE_VENDOR_INTERFACE, 2, 0xFF /*vendor specific*/, 0x00, 0x00);
+    addEndpoint(&tWriter, COMPOSITE_VENDOR_OUT_EP);
+    addEndpoint(&tWriter, COMPOSITE_VENDOR_IN_EP);
+
+    if (tWriter.Overflow) {
+        return 0;
+    }
+    aBuffer[2] = (uint8_t) tWriter.Length;
+    aBuffer[3] = (uint8_t) (tWriter.Length >> 8);
+    return tWriter.Length;
+}
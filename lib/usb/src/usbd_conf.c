@@ -27,7 +27,9 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "usbd_desc.h"
-#include "usbd_hid.h"
+#include "usbd_composite_desc.h" // for CompositeEndpoints[] and USBD_PMA_allocate()
+#include "usbd_misc.h" // for CDC_checkAndStartTransmit()
+#include "usbd_hid_cursor.h" // for HID_Cursor_checkAndSendReport()
 #include "LocalGUI/LocalTinyPrint.h"
 
 /* Private typedef -----------------------------------------------------------*/
@@ -35,6 +37,7 @@
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
 PCD_HandleTypeDef PCDHandle; // Peripheral Controller Driver
+uint16_t USBPMABytesUsed; // packet memory used by BTABLE and endpoint buffers
 
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
@@ -156,6 +159,10 @@ void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum) {
  */
 void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd) {
     USBD_LL_SOF(hpcd->pData);
+    // Send content of CDC send buffer every millisecond
+    CDC_checkAndStartTransmit();
+    // Send pending cursor movement at the HID polling interval
+    HID_Cursor_checkAndSendReport();
 }
 
 /**
@@ -242,15 +249,23 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev) {
     PCDHandle.Init.ep0_mps = PCD_EP0MPS_64;
     PCDHandle.Init.phy_itface = PCD_PHY_EMBEDDED;
     PCDHandle.Init.speed = PCD_SPEED_FULL;
+    PCDHandle.Init.Sof_enable = 1; // SOF is used for CDC transmit
     /* Link The driver to the stack */
     PCDHandle.pData = pdev;
     pdev->pData = &PCDHandle;
     /* Initialize LL Driver */
     HAL_PCD_Init(pdev->pData);
 
-    HAL_PCDEx_PMAConfig(pdev->pData, 0x00, PCD_SNG_BUF, 0x18);
-    HAL_PCDEx_PMAConfig(pdev->pData, 0x80, PCD_SNG_BUF, 0x58);
-    HAL_PCDEx_PMAConfig(pdev->pData, 0x81, PCD_SNG_BUF, 0x100);
+    /*
+     * Packet memory for all endpoints of the composite device.
+     * The layout is computed from the endpoint table, see budget in usbd_composite_desc.c.
+     */
+    uint16_t tPMAAddresses[COMPOSITE_NUMBER_OF_ENDPOINTS];
+    USBPMABytesUsed = USBD_PMA_allocate(CompositeEndpoints, COMPOSITE_NUMBER_OF_ENDPOINTS, tPMAAddresses, USB_PMA_SIZE);
+    assert_param(USBPMABytesUsed != 0);
+    for (uint_fast8_t i = 0; i < COMPOSITE_NUMBER_OF_ENDPOINTS; ++i) {
+        HAL_PCDEx_PMAConfig(pdev->pData, CompositeEndpoints[i].Address, PCD_SNG_BUF, tPMAAddresses[i]);
+    }
 
     return USBD_OK;
 }
@@ -36,9 +36,9 @@
 #define USBD_PID                      0x5710
 #define USBD_LANGID_STRING            0x409
 #define USBD_MANUFACTURER_STRING      "STMicroelectronics"
-#define USBD_PRODUCT_FS_STRING        "HID Joystick in FS Mode"
-#define USBD_CONFIGURATION_FS_STRING  "HID Config"
-#define USBD_INTERFACE_FS_STRING      "HID Interface"
+#define USBD_PRODUCT_FS_STRING        "HID CDC Bulk Composite in FS Mode"
+#define USBD_CONFIGURATION_FS_STRING  "Composite Config"
+#define USBD_INTERFACE_FS_STRING      "Composite Interface"
 
 /* Private macro -------------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
@@ -70,16 +70,16 @@ const uint8_t USBD_DeviceDesc[USB_LEN_DEV_DESC]= {
   USB_DESC_TYPE_DEVICE,       /* bDescriptorType */
   0x00,                       /* bcdUSB */
   0x02,
-  0x00,                       /* bDeviceClass */
-  0x00,                       /* bDeviceSubClass */
-  0x00,                       /* bDeviceProtocol */
+  0xEF,                       /* bDeviceClass Miscellaneous, required for interface association descriptor */
+  0x02,                       /* bDeviceSubClass Common Class */
+  0x01,                       /* bDeviceProtocol Interface Association */
   USB_MAX_EP0_SIZE,           /* bMaxPacketSize */
   LOBYTE(USBD_VID),           /* idVendor */
   HIBYTE(USBD_VID),           /* idVendor */
   LOBYTE(USBD_PID),           /* idVendor */
   HIBYTE(USBD_PID),           /* idVendor */
-  0x00,                       /* bcdDevice rel. 2.00 */
-  0x02,
+  0x00,                       /* bcdDevice rel. 3.00, changed for composite device to invalidate cached host drivers */
+  0x03,
   USBD_IDX_MFC_STR,           /* Index of manufacturer string */
   USBD_IDX_PRODUCT_STR,       /* Index of product string */
   USBD_IDX_SERIAL_STR,        /* Index of serial number string */
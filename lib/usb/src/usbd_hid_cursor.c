@@ -0,0 +1,154 @@
+/*
+ * usbd_hid_cursor.c
+ *
+ * The movement is integrated with fractional carry, so slow velocities below one pixel per millisecond
+ * result in a report every few milliseconds instead of being truncated to zero.
+ *
+ * @date 19.10.2026
+ * @author Armin Joachimsmeyer
+ *      Email:   armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "usbd_hid_cursor.h"
+#include "usbd_composite.h"
+#include "timing.h" // for micros()
+
+#include <string.h> // for memset
+
+#define HID_CURSOR_MAX_DELTA 127
+#define HID_CURSOR_ONE_PIXEL (1 << HID_CURSOR_FRACTION_BITS)
+
+static volatile bool sHIDCursorIsActive = false;
+static volatile int32_t sVelocity[2]; // 1/256 pixel per millisecond, written by application
+static int32_t sRemainder[2]; // 1/256 pixel, only used by SOF interrupt
+static uint32_t sFirstPendingMicros;
+static bool sMovementIsPending = false;
+
+volatile HIDCursorStatisticsTypeDef HIDCursorStatistics;
+
+void HID_Cursor_start(void) {
+    sVelocity[0] = 0;
+    sVelocity[1] = 0;
+    sRemainder[0] = 0;
+    sRemainder[1] = 0;
+    sMovementIsPending = false;
+    memset((void *) &HIDCursorStatistics, 0, sizeof(HIDCursorStatistics));
+    sHIDCursorIsActive = true;
+}
+
+void HID_Cursor_stop(void) {
+    sHIDCursorIsActive = false;
+}
+
+/**
+ * @param aVelocityX 1/256 pixel per millisecond. Positive is right.
+ * @param aVelocityY 1/256 pixel per millisecond. Positive is down.
+ */
+void HID_Cursor_setVelocity(int32_t aVelocityX, int32_t aVelocityY) {
+    sVelocity[0] = aVelocityX;
+    sVelocity[1] = aVelocityY;
+}
+
+/*
+ * Acceleration curve. No movement in dead zone, above it velocity grows quadratically,
+ * which gives precise positioning at small tilts and fast movement at large tilts.
+ * With aScale = 90, 45 degree gives around 1 pixel per millisecond.
+ */
+static int32_t getVelocityForTilt(int16_t aTiltTenthDegree, uint16_t aScale) {
+    int32_t tTilt = aTiltTenthDegree;
+    bool tIsNegative = false;
+    if (tTilt < 0) {
+        tTilt = -tTilt;
+        tIsNegative = true;
+    }
+    if (tTilt <= HID_CURSOR_DEAD_ZONE) {
+        return 0;
+    }
+    tTilt -= HID_CURSOR_DEAD_ZONE;
+    int32_t tVelocity = (tTilt * tTilt) / (aScale * 8);
+    if (tIsNegative) {
+        return -tVelocity;
+    }
+    return tVelocity;
+}
+
+/**
+ * @param aScale higher values give slower movement
+ */
+void HID_Cursor_setTilt(int16_t aTiltXTenthDegree, int16_t aTiltYTenthDegree, uint16_t aScale) {
+    if (aScale == 0) {
+        aScale = 1;
+    }
+    HID_Cursor_setVelocity(getVelocityForTilt(aTiltXTenthDegree, aScale), getVelocityForTilt(aTiltYTenthDegree, aScale));
+}
+
+/*
+ * Whole pixels of remainder, rounded towards zero, so the fraction keeps the sign of the movement
+ */
+static int32_t takeWholePixels(uint8_t aAxis) {
+    int32_t tPixels = sRemainder[aAxis] / HID_CURSOR_ONE_PIXEL;
+    if (tPixels > HID_CURSOR_MAX_DELTA) {
+        tPixels = HID_CURSOR_MAX_DELTA;
+    } else if (tPixels < -HID_CURSOR_MAX_DELTA) {
+        tPixels = -HID_CURSOR_MAX_DELTA;
+    }
+    return tPixels;
+}
+
+/*
+ * Limits remainder to what can be sent with one report
+ */
+static void clipRemainder(uint8_t aAxis) {
+    const int32_t tLimit = HID_CURSOR_MAX_DELTA * HID_CURSOR_ONE_PIXEL;
+    if (sRemainder[aAxis] > tLimit) {
+        HIDCursorStatistics.ClippedPixels += (sRemainder[aAxis] - tLimit) / HID_CURSOR_ONE_PIXEL;
+        sRemainder[aAxis] = tLimit;
+    } else if (sRemainder[aAxis] < -tLimit) {
+        HIDCursorStatistics.ClippedPixels += (-tLimit - sRemainder[aAxis]) / HID_CURSOR_ONE_PIXEL;
+        sRemainder[aAxis] = -tLimit;
+    }
+}
+
+/**
+ * Is called every millisecond by the SOF interrupt.
+ */
+void HID_Cursor_checkAndSendReport(void) {
+    if (!sHIDCursorIsActive) {
+        return;
+    }
+    for (uint_fast8_t i = 0; i < 2; ++i) {
+        sRemainder[i] += sVelocity[i];
+        clipRemainder(i);
+    }
+    int32_t tDeltaX = takeWholePixels(0);
+    int32_t tDeltaY = takeWholePixels(1);
+    if (tDeltaX == 0 && tDeltaY == 0) {
+        return;
+    }
+
+    uint32_t tMicros = micros();
+    if (!sMovementIsPending) {
+        sMovementIsPending = true;
+        sFirstPendingMicros = tMicros;
+    }
+    if (USBD_Composite_isINEndpointBusy(COMPOSITE_HID_IN_EP)) {
+        HIDCursorStatistics.DeferredReports++;
+        return;
+    }
+    if (USBD_Composite_HID_sendMouseReport(0, tDeltaX, tDeltaY, 0) != USBD_OK) {
+        HIDCursorStatistics.DeferredReports++;
+        return;
+    }
+    sRemainder[0] -= tDeltaX * HID_CURSOR_ONE_PIXEL;
+    sRemainder[1] -= tDeltaY * HID_CURSOR_ONE_PIXEL;
+    sMovementIsPending = false;
+
+    uint32_t tLatency = tMicros - sFirstPendingMicros;
+    HIDCursorStatistics.Reports++;
+    HIDCursorStatistics.LatencyMicrosSum += tLatency;
+    if (tLatency > HIDCursorStatistics.LatencyMicrosMaximum) {
+        HIDCursorStatistics.LatencyMicrosMaximum = tLatency;
+    }
+}
@@ -14,8 +14,7 @@
 #include "LocalGUI/LocalTinyPrint.h"
 
 #include "timing.h"
-#include "usbd_hid.h"
-#include "usbd_cdc.h"
+#include "usbd_composite.h"
 
 #include <stdio.h> /* for sprintf */
 USBD_HandleTypeDef USBDDeviceHandle;
@@ -56,44 +55,57 @@ bool isUSBReady(void) {
 }
 
 bool isUsbCdcReady(void) {
-    if (USBDDeviceHandle.dev_state == USBD_STATE_CONFIGURED && USBDDeviceHandle.pClass == &USBD_CDC) {
+    if (USBDDeviceHandle.dev_state == USBD_STATE_CONFIGURED && USBDDeviceHandle.pClass == &USBD_COMPOSITE) {
         return true;
     }
     return false;
 }
 
 bool isUSBTypeCDC(void) {
-    if (USBDDeviceHandle.pClass == &USBD_CDC) {
+    if (USBDDeviceHandle.pClass == &USBD_COMPOSITE) {
         return true;
     }
     return false;
 }
 
+/*
+ * Values of last call of getUSB_StaticInfos() for throughput computation
+ */
+static uint32_t sLastStatisticsMillis;
+static uint32_t sLastStatisticsBytes[COMPOSITE_NUMBER_OF_FUNCTIONS];
+
+/**
+ * Prints device type, packet memory usage and for each function the total bytes, the throughput since last call and the NAK counters
+ */
 int getUSB_StaticInfos(char *aStringBuffer, size_t sizeofStringBuffer) {
+    const char * const tFunctionNames[COMPOSITE_NUMBER_OF_FUNCTIONS] = { "HID", "CDC", "Bulk" };
     const char * tUSBTypeString;
     const char * tUSBSpeedString;
-    int tPacketSize;
-    if (USBDDeviceHandle.pClass == &USBD_HID) {
-        tUSBTypeString = "Joystick";
-    } else if (USBDDeviceHandle.pClass == &USBD_CDC) {
-        tUSBTypeString = "Serial";
+    if (USBDDeviceHandle.pClass == &USBD_COMPOSITE) {
+        tUSBTypeString = "HID+CDC+Bulk";
     } else {
         tUSBTypeString = "Unknown";
     }
     if (USBDDeviceHandle.dev_speed == USBD_SPEED_HIGH) {
         tUSBSpeedString = "HighSpeed";
-        tPacketSize = CDC_DATA_HS_OUT_PACKET_SIZE;
     } else {
         tUSBSpeedString = "FullSpeed";
-        tPacketSize = CDC_DATA_FS_OUT_PACKET_SIZE;
     }
-    int tIndex = snprintf(aStringBuffer, sizeofStringBuffer, "USB-Type:%s %s\n", tUSBTypeString, tUSBSpeedString);
-    if (USBDDeviceHandle.pClass == &USBD_CDC) {
-        // print additional CDC info
-        tIndex += snprintf(&aStringBuffer[tIndex], sizeofStringBuffer - tIndex, "Buffer:%3d Byte\n", tPacketSize);
-//        tIndex += snprintf(&aStringBuffer[tIndex], sizeofStringBuffer - tIndex, "%6ld Baud  %d Bit  %d Stop", LineCoding.bitrate,
-//                LineCoding.datatype, LineCoding.format + 1);
+    int tIndex = snprintf(aStringBuffer, sizeofStringBuffer, "USB-Type:%s %s\nPMA:%3d of %d Byte\n", tUSBTypeString,
+            tUSBSpeedString, USBPMABytesUsed, USB_PMA_SIZE);
 
+    uint32_t tMillis = millis();
+    uint32_t tDeltaMillis = tMillis - sLastStatisticsMillis;
+    sLastStatisticsMillis = tMillis;
+    for (uint_fast8_t i = 0; i < COMPOSITE_NUMBER_OF_FUNCTIONS; ++i) {
+        uint32_t tBytes = USBDInterfaceStatistics[i].BytesIn + USBDInterfaceStatistics[i].BytesOut;
+        uint32_t tBytesPerSecond = 0;
+        if (tDeltaMillis != 0) {
+            tBytesPerSecond = ((uint64_t) (tBytes - sLastStatisticsBytes[i]) * 1000) / tDeltaMillis;
+        }
+        sLastStatisticsBytes[i] = tBytes;
+        tIndex += snprintf(&aStringBuffer[tIndex], sizeofStringBuffer - tIndex, "%-4s%8lu B %6lu B/s NAK %lu/%lu\n",
+                tFunctionNames[i], tBytes, tBytesPerSecond, USBDInterfaceStatistics[i].NAKsIn, USBDInterfaceStatistics[i].NAKsOut);
     }
     return tIndex;
 }
@@ -150,8 +162,5 @@ uint8_t * CDC_Loopback(void) {
 
 void CDC_TestSend(void) {
     int tCount = snprintf(sStringBuffer, sizeof sStringBuffer, "Test %p", &sStringBuffer[0]);
-    USBD_CDC_SetTxBuffer(&USBDDeviceHandle, (uint8_t*) &sStringBuffer[0], tCount);
-    while (USBD_CDC_TransmitPacket(&USBDDeviceHandle) == USBD_BUSY) {
-        delay(100);
-    }
+    CDC_sendBuffer((uint8_t*) &sStringBuffer[0], tCount, NULL, 0);
 }
@@ -28,6 +28,7 @@
 void initAccuCapacity(void);
 void startAccuCapacity(void);
 void loopAccuCapacity(void);
+void serviceAccuCapacity(void);
 void stopAccuCapacity(void);
 
 #endif
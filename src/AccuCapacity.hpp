@@ -27,6 +27,14 @@
 #define _ACCU_CAPACITY_HPP
 
 #include <string.h> // for strlen
+#include <stdlib.h> // for malloc
+#include <stddef.h> // for offsetof
+
+extern "C" {
+#include "writeBehind.h"
+#include "sampleHistory.h"
+#include "chartExport.h"
+}
 
 char StringDischarging[] = "discharging";
 
@@ -40,10 +48,13 @@ const char *const chartStringsExtern[] = { "Max", "Min", "Both" };
 #define CHARGE_VOLTAGE_MILLIVOLT_DEFAULT 2490
 #define SAMPLE_PERIOD_START 30 // in seconds
 #define SAMPLE_PERIOD_HIGH_RESOLUTION 10 // in seconds
+#define WRITE_BEHIND_FLUSH_TIMEOUT_MILLIS 3000 // for flushing queued file writes before load and at page stop
 // Flag to signal end of measurement from ISR to main loop
 volatile bool doEndTone = false;
 // Flag to signal refresh from Timer Callback (ISR context) to main loop
 volatile bool doDisplayRefresh = false;
+// Flag to signal new sample of displayed probe from Timer Callback to main loop, which may read the history from card
+volatile bool doDrawData = false;
 
 /**
  * Color scheme
@@ -112,6 +123,8 @@ BDButton TouchButtonSetLoadResistor;
 BDButton TouchButtonSetStopValue;
 BDButton TouchButtonSetChargeVoltage;
 BDButton TouchButtonSetExternalAttenuatorFactor;
+BDButton TouchButtonSetExportBinary;
+bool sExportIsBinary; // false -> export as CSV
 
 char StringProbeNumber[] = "Probe number:    "; // with space for the number
 #define STRING_PROBE_NUMBER_NUMBER_INDEX 14
@@ -182,10 +195,13 @@ DataloggerDisplayControlStruct AccuCapDisplayControl[NUMBER_OF_PROBES];
 #define MODE_EXTERNAL_VOLTAGE 0x02 // For measurement of external voltage and current
 /*
  * Structure defining a capacity measurement
+ * The samples are stored compressed in History. 4 kByte RAM hold around 3500 samples, older blocks are spilled to the card.
+ * 1000 samples -> 16,6 hours for 1 sample per minute
  */
-#define RAM_DATABUFFER_MAX_LENGTH 1200 // 12 byte per entry. 1000 -> 16,6 hours for 1 sample per minute
+#define HISTORY_CHANNEL_VOLTAGE 0 // if mode == external maximum values are stored here
+#define HISTORY_CHANNEL_ESR 1
 /*
- * Current battery values set by getBatteryValues()
+ * Current battery values set by the measurement scheduler
  */
 struct BatteryInfoStruct {
     uint16_t VoltageNoLoadMillivolt;
@@ -222,8 +238,7 @@ struct DataloggerMeasurementControlStruct {
     uint16_t LoadResistorMilliohm;
     float ExternalAttenuatorFactor; // to compensate external attenuator: ADC Value * factor = Volt
 
-    uint16_t VoltageNoLoadDatabuffer[RAM_DATABUFFER_MAX_LENGTH]; // if mode == external maximum values are stored here
-    uint16_t ESRMilliohmDatabuffer[RAM_DATABUFFER_MAX_LENGTH];
+    SampleHistoryTypeDef History; // VoltageNoLoadMillivolt and ESRMilliohm
 };
 DataloggerMeasurementControlStruct BatteryControl[NUMBER_OF_PROBES];
 
@@ -234,8 +249,8 @@ DataloggerMeasurementControlStruct BatteryControl[NUMBER_OF_PROBES];
 
 // Global declarations
 
-uint16_t getBatteryVoltageMillivolt(DataloggerMeasurementControlStruct *aProbe);
-void getBatteryValues(DataloggerMeasurementControlStruct *aProbe);
+void startMeasurementScheduler(void);
+void stopMeasurementScheduler(void);
 void startStopMeasurement(DataloggerMeasurementControlStruct *aProbe, bool aDoStart);
 void setYAutorange(int16_t aProbeIndex, uint16_t aADCReadingToAutorange);
 
@@ -243,6 +258,7 @@ void initGUIAccuCapacity(void);
 void printBatteryValues(void);
 void clearBasicInfo(void);
 void drawData(bool doClearBefore);
+void drawNewData(void);
 void activateOrShowChartGui(void);
 void adjustXAxisToSamplePeriod(unsigned int aProbeIndex, int aSamplePeriodSeconds);
 bool CheckStopCondition(DataloggerMeasurementControlStruct *aProbe);
@@ -260,21 +276,20 @@ void changeYOffset(int aValue);
 void changeYScaleFactor(int aValue);
 
 void storeBatteryValues(DataloggerMeasurementControlStruct *aProbe);
-void callbackTimerSampleChannel0(void);
-void callbackTimerSampleChannel1(void);
+void setSinkSource(unsigned int aProbeIndex, bool aDoActivate);
 void callbackDisplayRefreshDelay(void);
 
 /*
  * LOOP timing
  */
-static void (*SampleDelayCallbackFunctions[NUMBER_OF_PROBES])(void) = {&callbackTimerSampleChannel0, &callbackTimerSampleChannel1};
-
 // last sample of millis() in loop as reference for loop duration
 unsigned long MillisLastLoopCapacity = 0;
 
 // update display at least all SAMPLE_PERIOD_MILLIS millis
 #define SAMPLE_PERIOD_MILLIS ONE_SECOND_MILLIS
 
+#include "AccuCapacityScheduler.hpp"
+
 /****************************************************************************************
  * THE CODE STARTS HERE
  ****************************************************************************************/
@@ -308,22 +323,12 @@ void callbackDisplayRefreshDelay(void) {
     doDisplayRefresh = true;
 }
 
-void callbackTimerSampleChannel0(void) {
-    storeBatteryValues(&BatteryControl[0]);
-}
-void callbackTimerSampleChannel1(void) {
-    storeBatteryValues(&BatteryControl[1]);
-}
-
 /**
  *
  * @param aProbeIndex
  * @return true if measurement has to be stopped
  */
 bool CheckStopCondition(DataloggerMeasurementControlStruct *aProbe) {
-    if (aProbe->SampleCount >= RAM_DATABUFFER_MAX_LENGTH - 1) {
-        return true;
-    }
     if (aProbe->Mode == MODE_DISCHARGING) {
         return (aProbe->BatteryInfo.VoltageNoLoadMillivolt < aProbe->SwitchOffVoltageMillivolt);
     } else if (aProbe->Mode == MODE_CHARGING && aProbe->StopMilliampereHour != 0) {
@@ -449,6 +454,9 @@ void initAccuCapacity(void) {
         BatteryControl[i].StopMilliampereHour = 0;
         BatteryControl[i].ProbeNumber = i;
         BatteryControl[i].SampleCount = 0;
+        char tFileName[SAMPLE_HISTORY_FILE_NAME_SIZE];
+        snprintf(tFileName, sizeof tFileName, "channel%d_history.bin", i);
+        SampleHistory_init(&BatteryControl[i].History, tFileName);
 
         AccuCapDisplayControl[i].ChartShowMode = SHOW_MODE_GUI;
         AccuCapDisplayControl[i].ActualDataChart = CHART_DATA_BOTH;
@@ -459,6 +467,7 @@ void initAccuCapacity(void) {
             BatteryControl[i].ChargeVoltageMillivolt = CHARGE_VOLTAGE_MILLIVOLT_DEFAULT;
         }
     }
+    registerMainLoopCallback(&serviceAccuCapacity);
 }
 
 void startAccuCapacity(void) {
@@ -469,8 +478,9 @@ void startAccuCapacity(void) {
     drawAccuCapacityMainPage();
     registerRedrawCallback(&redrawAccuCapacityPages);
 
-    // start display refresh
+    // start display refresh and measurement
     registerDelayCallback(&callbackDisplayRefreshDelay, SAMPLE_PERIOD_MILLIS);
+    startMeasurementScheduler();
 
     registerLongTouchDownCallback(&longTouchHandlerAccuCapacity, TOUCH_STANDARD_LONG_TOUCH_TIMEOUT_MILLIS);
     // use touch up for buttons in order not to interfere with long touch
@@ -481,6 +491,8 @@ void startAccuCapacity(void) {
 void stopAccuCapacity(void) {
     // Stop display refresh
     changeDelayCallback(&callbackDisplayRefreshDelay, DISABLE_TIMER_DELAY_VALUE);
+    // running measurements continue in background
+    stopMeasurementScheduler();
 #if defined(SUPPORT_LOCAL_DISPLAY)
 // free buttons
     for (unsigned int i = 0; i < sizeof(ButtonsChart) / sizeof(ButtonsChart[0]); ++i) {
@@ -495,6 +507,7 @@ void stopAccuCapacity(void) {
     TouchButtonSetStopValue.deinit();
     TouchButtonSetChargeVoltage.deinit();
     TouchButtonSetExternalAttenuatorFactor.deinit();
+    TouchButtonSetExportBinary.deinit();
     TouchButtonBack.deinit();
 
     TouchButtonAutorepeatSamplePeriodPlus.deinit();
@@ -505,13 +518,15 @@ void stopAccuCapacity(void) {
     registerSwipeEndCallback(NULL);
     registerTouchUpCallback(NULL);
     // restore old touch down handler
+
+    // write pending store and export data to card
+    WriteBehind_waitForCompletion(WRITE_BEHIND_FLUSH_TIMEOUT_MILLIS);
 }
 
 void loopAccuCapacity(void) {
 // check Flags from ISR
     if (doDisplayRefresh == true) {
         for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
-            getBatteryValues(&BatteryControl[i]);
             if (BatteryControl[i].Mode == MODE_DISCHARGING && BatteryControl[i].BatteryInfo.VoltageNoLoadMillivolt < 100) {
                 // stop running measurement
                 if (BatteryControl[i].IsStarted) {
@@ -526,9 +541,28 @@ void loopAccuCapacity(void) {
         doEndTone = false;
         playEndTone();
     }
+    if (doDrawData == true) {
+        doDrawData = false;
+        if (ActualPage == PAGE_CHART) {
+            drawNewData();
+        }
+    }
+    // calls serviceAccuCapacity()
     checkAndHandleEvents();
 }
 
+/*
+ * Is called by checkAndHandleEvents() in the loop of every page, since measurements continue if page is left
+ */
+void serviceAccuCapacity(void) {
+    // queue full history blocks for writing to card
+    for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+        SampleHistory_service(&BatteryControl[i].History);
+    }
+    // write at most one sector of queued store, export or history data
+    WriteBehind_service();
+}
+
 /************************************************************************
  * GUI handler section
  ************************************************************************/
@@ -679,6 +713,13 @@ void doSetReadingChargeVoltage(BDButton *aTheTouchedButton, int16_t aValue) {
     drawAccuCapacitySettingsPage();
 }
 
+/**
+ * Selects the format of the next export, the default is CSV
+ */
+void doSetExportBinary(BDButton *aTheTouchedButton, int16_t aValue) {
+    sExportIsBinary = aValue;
+}
+
 void doSetSamplePeriod(BDButton *aTheTouchedButton, int16_t aValue) {
     bool tIsError = false;
     int tSeconds = BatteryControl[IndexOfDisplayedProbe].SamplePeriodSeconds;
@@ -766,20 +807,14 @@ void startStopMeasurement(DataloggerMeasurementControlStruct *aProbe, bool aDoSt
         /*
          * START
          */
-        delay(LOAD_SWITCH_SETTLE_TIME_MILLIS);
-        getBatteryValues(aProbe);
-        // Autorange if first value
+        sMeasurementScheduler[aProbe->ProbeIndex].MeasurementsUntilStore = getMeasurementsPerStore(aProbe);
+        // Autorange if first value. Use the no load voltage measured by the scheduler while stopped.
         if (aProbe->SampleCount == 0) {
             // let measurement value start at middle of y axis
             setYAutorange(aProbe->ProbeIndex, aProbe->BatteryInfo.VoltageNoLoadMillivolt);
         }
         printBatteryValues();
-        changeDelayCallback(SampleDelayCallbackFunctions[aProbe->ProbeIndex], aProbe->SamplePeriodSeconds * ONE_SECOND_MILLIS);
-    } else {
-        /*
-         * STOP
-         */
-        changeDelayCallback(SampleDelayCallbackFunctions[aProbe->ProbeIndex], DISABLE_TIMER_DELAY_VALUE);
+        startMeasurementScheduler();
     }
 }
 
@@ -812,10 +847,7 @@ void doClearDataBuffer(BDButton *aTheTouchedButton, int16_t aProbeIndex) {
     BatteryControl[aProbeIndex].BatteryInfo.ESRMilliohm = 0;
     BatteryControl[aProbeIndex].SampleCount = 0;
 // Clear data buffer
-    memset(&BatteryControl[aProbeIndex].VoltageNoLoadDatabuffer[0], 0, RAM_DATABUFFER_MAX_LENGTH);
-    memset(&BatteryControl[aProbeIndex].ESRMilliohmDatabuffer[0], 0,
-    RAM_DATABUFFER_MAX_LENGTH);
-    getBatteryVoltageMillivolt(&BatteryControl[aProbeIndex]);
+    SampleHistory_clear(&BatteryControl[aProbeIndex].History);
 // set button text to load
     TouchButtonLoadStore.setText("Load");
     drawData(true);
@@ -833,6 +865,32 @@ const char* getModeString(int aProbeIndex) {
     return tModeString;
 }
 
+/*
+ * Called by WriteBehind_service() after file is closed. Success was already signaled when writes were queued.
+ */
+static void playWriteBehindErrorTone(FRESULT aResult, void *aContext) {
+    if (aResult != FR_OK) {
+#if defined(SUPPORT_LOCAL_DISPLAY) && defined(DISABLE_REMOTE_DISPLAY)
+        LocalTouchButton::playFeedbackTone(true);
+#else
+        BDButton::playFeedbackTone(true);
+#endif
+    }
+}
+
+bool sStoreIsActive; // only one store at a time, since the copy of the spilled history blocks is done by one generator
+
+static void storeChartCompleted(FRESULT aResult, void *aContext) {
+    sStoreIsActive = false;
+    if (aResult == FR_OK) {
+        aResult = SampleHistory_getCopyResult();
+    }
+    if (aResult != FR_OK) {
+        failParamMessage(aResult, "Store");
+    }
+    playWriteBehindErrorTone(aResult, aContext);
+}
+
 static void doStoreLoadChartToFile(BDButton *aTheTouchedButton, int16_t aProbeIndex) {
     bool tIsError = true;
     if (MICROSD_isCardInserted()) {
@@ -847,35 +905,60 @@ static void doStoreLoadChartToFile(BDButton *aTheTouchedButton, int16_t aProbeIn
                 doStartStopAccuCap(&TouchButtonStartStopCapacityMeasurement, aProbeIndex);
             }
             /*
-             * Load data from file
+             * Load data from file. A store of this file may still be queued.
              */
+            WriteBehind_waitForCompletion(WRITE_BEHIND_FLUSH_TIMEOUT_MILLIS);
             tOpenResult = f_open(&tFile, sStringBuffer, FA_OPEN_EXISTING | FA_READ);
             if (tOpenResult == FR_OK) {
+                char tHistoryFileName[SAMPLE_HISTORY_FILE_NAME_SIZE];
+                memcpy(tHistoryFileName, BatteryControl[aProbeIndex].History.FileName, sizeof(tHistoryFileName));
                 // read AccuCapDisplayControl structure to reproduce the layout
                 f_read(&tFile, &AccuCapDisplayControl[aProbeIndex], sizeof(AccuCapDisplayControl[aProbeIndex]), &tCount);
-                // read DataloggerMeasurementControl structure - including data buffers
+                // read DataloggerMeasurementControl structure - including RAM blocks of history
                 f_read(&tFile, &BatteryControl[aProbeIndex], sizeof(BatteryControl[aProbeIndex]), &tCount);
+                // the blocks which were already spilled follow and are copied to the history file of this probe
+                tIsError = (SampleHistory_loadSpilledBlocks(&BatteryControl[aProbeIndex].History, tHistoryFileName, &tFile)
+                        != FR_OK);
                 f_close(&tFile);
                 // set state to stop
                 BatteryControl[aProbeIndex].IsStarted = false;
-                setYAutorange(aProbeIndex, BatteryControl[aProbeIndex].VoltageNoLoadDatabuffer[0]);
+                SampleHistory_restore(&BatteryControl[aProbeIndex].History);
+                BatteryControl[aProbeIndex].SampleCount = BatteryControl[aProbeIndex].History.SampleCount;
+                uint16_t tFirstVoltage = 0;
+                SampleHistory_readChannel(&BatteryControl[aProbeIndex].History, 0, 1, HISTORY_CHANNEL_VOLTAGE, &tFirstVoltage);
+                setYAutorange(aProbeIndex, tFirstVoltage);
                 AccuCapDisplayControl[aProbeIndex].ActualDataChart = CHART_DATA_BOTH;
                 // redraw display corresponding to new values
                 redrawAccuCapacityChartPage();
-                tIsError = false;
             }
-        } else {
+        } else if (!BatteryControl[aProbeIndex].IsStarted && !sStoreIsActive) {
             /*
-             * Store data to file
+             * Store data to file by WriteBehind_service() in serviceAccuCapacity().
+             * Only a stopped measurement can be stored, since the history is written by reference.
+             * The measurement scheduler still updates BatteryInfo of a stopped probe,
+             * so the values before the history are copied to the queue with interrupts disabled.
+             * The blocks already spilled to the history file are appended, so the file is complete.
              */
-            tOpenResult = f_open(&tFile, sStringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
-            if (tOpenResult == FR_OK) {
+            uint8_t tFileHandle = WriteBehind_open(sStringBuffer);
+            if (tFileHandle != WRITE_BEHIND_INVALID_HANDLE) {
                 // write display control to reproduce the layout
-                f_write(&tFile, &AccuCapDisplayControl[aProbeIndex], sizeof(AccuCapDisplayControl[aProbeIndex]), &tCount);
-                // write control structure including the data buffers
-                f_write(&tFile, &BatteryControl[aProbeIndex], sizeof(BatteryControl[aProbeIndex]), &tCount);
-                f_close(&tFile);
-                tIsError = false;
+                tIsError = !WriteBehind_writeReference(tFileHandle, &AccuCapDisplayControl[aProbeIndex],
+                        sizeof(AccuCapDisplayControl[aProbeIndex]));
+                if (!tIsError) {
+                    uint32_t tPrimask = __get_PRIMASK();
+                    __disable_irq();
+                    tIsError = !WriteBehind_write(tFileHandle, &BatteryControl[aProbeIndex],
+                            offsetof(DataloggerMeasurementControlStruct, History));
+                    __set_PRIMASK(tPrimask);
+                }
+                // write the history including its RAM blocks
+                if (!tIsError) {
+                    tIsError = !(WriteBehind_writeReference(tFileHandle, &BatteryControl[aProbeIndex].History,
+                            sizeof(BatteryControl[aProbeIndex]) - offsetof(DataloggerMeasurementControlStruct, History))
+                            && SampleHistory_writeSpilledBlocks(&BatteryControl[aProbeIndex].History, tFileHandle));
+                }
+                sStoreIsActive = true;
+                WriteBehind_close(tFileHandle, &storeChartCompleted, NULL);
             }
         }
     }
@@ -886,58 +969,63 @@ static void doStoreLoadChartToFile(BDButton *aTheTouchedButton, int16_t aProbeIn
 #endif
 }
 
+/*
+ * State of the export, the data is written by WriteBehind_service()
+ */
+bool sExportIsActive;
+
+static void exportChartCompleted(FRESULT aResult, void *aContext) {
+    sExportIsActive = false;
+    if (aResult == FR_OK) {
+        aResult = ChartExport_getReadResult();
+    }
+    if (aResult != FR_OK) {
+        failParamMessage(aResult, "Export");
+    }
+    playWriteBehindErrorTone(aResult, aContext);
+}
+
 /**
- * Export Data Buffer to CSV file
+ * Export Data Buffer to CSV or binary file.
+ * Only the header is formatted here, the data is written by serviceAccuCapacity().
  * @param aTheTouchedButton
  * @param aProbeIndex
  */
 static void doExportChart(BDButton *aTheTouchedButton, int16_t aProbeIndex) {
     bool tIsError = true;
-    if (MICROSD_isCardInserted()) {
-        FIL tFile;
-        FRESULT tOpenResult;
-        UINT tCount;
+    if (MICROSD_isCardInserted() && !sExportIsActive) {
         unsigned int tIndex = RTC_getDateStringForFile(sStringBuffer);
-        snprintf(&sStringBuffer[tIndex], sizeof sStringBuffer - tIndex, " probe%d_%s.csv", BatteryControl[aProbeIndex].ProbeNumber,
-                getModeString(aProbeIndex));
+        snprintf(&sStringBuffer[tIndex], sizeof sStringBuffer - tIndex, (sExportIsBinary ? " probe%d_%s.acb" : " probe%d_%s.csv"),
+                BatteryControl[aProbeIndex].ProbeNumber, getModeString(aProbeIndex));
         if (BatteryControl[aProbeIndex].SampleCount != 0) {
-            tOpenResult = f_open(&tFile, sStringBuffer, FA_CREATE_ALWAYS | FA_WRITE);
-            if (tOpenResult != FR_OK) {
-                failParamMessage(tOpenResult, "f_open");
-            } else {
-                unsigned int tSeconds = BatteryControl[IndexOfDisplayedProbe].SamplePeriodSeconds;
-                unsigned int tMinutes = tSeconds / 60;
-                tSeconds %= 60;
-                tIndex = snprintf(sStringBuffer, sizeof sStringBuffer, "Probe Nr:%d\nSample interval:%u:%02u min\nDate:",
-                        BatteryControl[aProbeIndex].ProbeNumber, tMinutes, tSeconds);
-                tIndex += RTC_getTimeString(&sStringBuffer[tIndex]);
-                snprintf(&sStringBuffer[tIndex], (sizeof sStringBuffer) - tIndex,
-                        "\nCapacity:%4umAh\nInternal resistance:%5u mOhm\nVolt no load;mOhm\n",
-                        BatteryControl[aProbeIndex].BatteryInfo.CapacityMilliampereHour,
-                        BatteryControl[aProbeIndex].BatteryInfo.ESRMilliohm);
-                f_write(&tFile, sStringBuffer, strlen(sStringBuffer), &tCount);
-
-                /**
-                 * data
-                 */
-                tIndex = 0;
-                uint16_t *tVoltageNoLoadDataPtr = &BatteryControl[aProbeIndex].VoltageNoLoadDatabuffer[0];
-                uint16_t *tMilliOhmDataPtr = &BatteryControl[aProbeIndex].ESRMilliohmDatabuffer[0];
-                for (int i = 0; i < BatteryControl[aProbeIndex].SampleCount; ++i) {
-                    tIndex += snprintf(&sStringBuffer[tIndex], (sizeof sStringBuffer) - tIndex, "%6.3f;%5d\n",
-                            sADCToVoltFactor * (*tVoltageNoLoadDataPtr++), (*tMilliOhmDataPtr++));
-                    // accumulate strings in buffer and write if buffer almost full
-                    if (tIndex > (sizeof sStringBuffer - 15)) {
-                        tIndex = 0;
-                        f_write(&tFile, sStringBuffer, strlen(sStringBuffer), &tCount);
-                    }
-                }
-                // write last chunk
-                if (tIndex > 0) {
-                    f_write(&tFile, sStringBuffer, strlen(sStringBuffer), &tCount);
+            uint8_t tFileHandle = WriteBehind_open(sStringBuffer);
+            if (tFileHandle != WRITE_BEHIND_INVALID_HANDLE) {
+                DataloggerMeasurementControlStruct *tProbe = &BatteryControl[aProbeIndex];
+                if (sExportIsBinary) {
+                    ChartExportBinaryHeaderTypeDef tHeader;
+                    memset(&tHeader, 0, sizeof(tHeader));
+                    tHeader.ProbeNumber = tProbe->ProbeNumber;
+                    tHeader.Mode = tProbe->Mode;
+                    tHeader.SamplePeriodSeconds = tProbe->SamplePeriodSeconds;
+                    tHeader.SampleCount = tProbe->SampleCount;
+                    tHeader.CapacityMilliampereHour = tProbe->BatteryInfo.CapacityMilliampereHour;
+                    tHeader.ESRMilliohm = tProbe->BatteryInfo.ESRMilliohm;
+                    tHeader.LoadResistorMilliohm = tProbe->LoadResistorMilliohm;
+                    tIsError = !ChartExport_queueBinary(tFileHandle, &tProbe->History, &tHeader);
+                } else {
+                    unsigned int tSeconds = tProbe->SamplePeriodSeconds;
+                    unsigned int tMinutes = tSeconds / 60;
+                    tSeconds %= 60;
+                    tIndex = snprintf(sStringBuffer, sizeof sStringBuffer, "Probe Nr:%d\nSample interval:%u:%02u min\nDate:",
+                            tProbe->ProbeNumber, tMinutes, tSeconds);
+                    tIndex += RTC_getTimeString(&sStringBuffer[tIndex]);
+                    tIndex += snprintf(&sStringBuffer[tIndex], (sizeof sStringBuffer) - tIndex,
+                            "\nCapacity:%4umAh\nInternal resistance:%5u mOhm\nVolt no load;mOhm\n",
+                            tProbe->BatteryInfo.CapacityMilliampereHour, tProbe->BatteryInfo.ESRMilliohm);
+                    tIsError = !ChartExport_queueCSV(tFileHandle, &tProbe->History, tProbe->SampleCount, sStringBuffer, tIndex);
                 }
-                f_close(&tFile);
-                tIsError = false;
+                sExportIsActive = true;
+                WriteBehind_close(tFileHandle, &exportChartCompleted, NULL);
             }
         }
     }
@@ -1036,6 +1124,9 @@ void initGUIAccuCapacity(void) {
     COLOR_GUI_VALUES, StringExternalAttenuatorFactor, TEXT_SIZE_11, FLAG_BUTTON_DO_BEEP_ON_TOUCH, 0,
             &doSetExternalAttenuatorFactor);
 
+    TouchButtonSetExportBinary.init(BUTTON_WIDTH_2_POS_2, tPosY, BUTTON_WIDTH_2, BUTTON_HEIGHT_4, 0, "Binary export", TEXT_SIZE_11,
+            FLAG_BUTTON_DO_BEEP_ON_TOUCH | FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN, sExportIsBinary, &doSetExportBinary);
+
 // 4. row
     tPosY += BUTTON_HEIGHT_4_LINE_2;
     TouchButtonSetStopValue.init(0, tPosY, BUTTON_WIDTH_2, BUTTON_HEIGHT_4, COLOR_GUI_VALUES, StringStopVoltage, TEXT_SIZE_11,
@@ -1095,6 +1186,10 @@ void printSamplePeriod(void) {
 }
 
 void doStartStopAccuCap(BDButton *aTheTouchedButton, int16_t aProbeIndex) {
+    if (!BatteryControl[aProbeIndex].IsStarted) {
+        // a queued store of this probe references the history, which is changed by the measurement
+        WriteBehind_waitForCompletion(WRITE_BEHIND_FLUSH_TIMEOUT_MILLIS);
+    }
     BatteryControl[aProbeIndex].IsStarted = !BatteryControl[aProbeIndex].IsStarted;
     startStopMeasurement(&BatteryControl[aProbeIndex], BatteryControl[aProbeIndex].IsStarted);
     if (BatteryControl[aProbeIndex].IsStarted) {
@@ -1109,105 +1204,24 @@ void doStartStopAccuCap(BDButton *aTheTouchedButton, int16_t aProbeIndex) {
     }
 }
 
-/*
- * read accumulator and calculate voltage and current
- */
-uint16_t getBatteryVoltageMillivolt(DataloggerMeasurementControlStruct *aProbe) {
-
-    uint16_t tRawVoltageReadout = AccuCapacity_ADCRead(aProbe->ProbeIndex);
-// compensate for external attenuator
-    uint16_t tVoltageMillivolt = tRawVoltageReadout * (aProbe->ExternalAttenuatorFactor * sADCToVoltFactor * 1000);
-    return tVoltageMillivolt;
-}
-
-/*
- * Gets Load and NoLoad voltages
- * Computes resistance
- */
-void getBatteryValues(DataloggerMeasurementControlStruct *aProbe) {
-    /*
-     * get load value, if started. Otherwise it is the no load value :-(
-     */
-    uint16_t tVoltageLoadMillivolt = getBatteryVoltageMillivolt(aProbe);
-
-    if (!aProbe->IsStarted) {
-        aProbe->BatteryInfo.VoltageNoLoadMillivolt = tVoltageLoadMillivolt;
-    } else {
-        aProbe->BatteryInfo.VoltageLoadMillivolt = tVoltageLoadMillivolt;
-        /*
-         * Compute current using source / load resistor value
-         */
-        int tEffectiveVoltageMillivolt = tVoltageLoadMillivolt;
-        if (aProbe->Mode != MODE_DISCHARGING) {
-            // assume charging for extern
-            tEffectiveVoltageMillivolt = aProbe->ChargeVoltageMillivolt - tVoltageLoadMillivolt;
-        }
-        uint16_t tMilliampere = (tEffectiveVoltageMillivolt * 1000) / aProbe->LoadResistorMilliohm;
-        aProbe->BatteryInfo.Milliampere = tMilliampere;
-
-        if (tMilliampere > 1) {
-            // capacity computation
-            aProbe->BatteryInfo.CapacityAccumulator += tMilliampere;
-            aProbe->BatteryInfo.CapacityMilliampereHour = aProbe->BatteryInfo.CapacityAccumulator
-                    / ((3600L * ONE_SECOND_MILLIS) / SAMPLE_PERIOD_MILLIS); // = / 3600 for 1 s sample period
-        }
-
-        /*
-         * Compute ESR = internal Equivalent Series Resistance
-         */
-
-        if (aProbe->Mode != MODE_EXTERNAL_VOLTAGE) {
-
-            // disconnect from sink/source and wait
-            setSinkSource(aProbe->ProbeIndex, false);
-            delay(LOAD_SWITCH_SETTLE_TIME_MILLIS);
-
-            /*
-             * Get NoLoad value
-             */
-            uint16_t tVoltageNoLoadMillivolt = getBatteryVoltageMillivolt(aProbe);
-            aProbe->BatteryInfo.VoltageNoLoadMillivolt = tVoltageNoLoadMillivolt;
-
-            //reconnect to sink/source
-            setSinkSource(aProbe->ProbeIndex, true);
-
-            /*
-             * Compute resistance
-             */
-            int16_t tESRTestDeltaMillivolt = tVoltageNoLoadMillivolt - tVoltageLoadMillivolt;
-            if (aProbe->Mode == MODE_CHARGING) {
-                tESRTestDeltaMillivolt = -tESRTestDeltaMillivolt;
-            }
-            if (tESRTestDeltaMillivolt <= 0 || tVoltageLoadMillivolt < 100) {
-                // plausibility fails
-                aProbe->BatteryInfo.ESRMilliohm = 0;
-            } else {
-                aProbe->BatteryInfo.sESRTestDeltaMillivolt = tESRTestDeltaMillivolt;
-                aProbe->BatteryInfo.ESRMilliohm = (tESRTestDeltaMillivolt * 1000L) / aProbe->BatteryInfo.Milliampere;
-            }
-        }
-    }
-}
-
 /*
  * Store the current value in array
  * Check for stop condition
  * Redraw chart
  */
 void storeBatteryValues(DataloggerMeasurementControlStruct *aProbe) {
-    registerDelayCallback(SampleDelayCallbackFunctions[aProbe->ProbeIndex], aProbe->SamplePeriodSeconds * ONE_SECOND_MILLIS);
-
-    /*
-     * Store
-     */
-    aProbe->VoltageNoLoadDatabuffer[aProbe->SampleCount] = aProbe->BatteryInfo.VoltageNoLoadMillivolt;
-    aProbe->ESRMilliohmDatabuffer[aProbe->SampleCount] = aProbe->BatteryInfo.ESRMilliohm;
-    aProbe->SampleCount++;
-
     /*
-     * Stop detection
+     * Store. Stop if history is full, i.e. no card for spilling history blocks
      */
-    bool tStop = CheckStopCondition(aProbe);
+    bool tStop = !SampleHistory_append(&aProbe->History, aProbe->BatteryInfo.VoltageNoLoadMillivolt,
+            aProbe->BatteryInfo.ESRMilliohm);
+    if (!tStop) {
+        aProbe->SampleCount++;
+        /*
+         * Stop detection
+         */
+        tStop = CheckStopCondition(aProbe);
+    }
 
     if (tStop) {
         // Stop Measurement
@@ -1219,8 +1233,8 @@ void storeBatteryValues(DataloggerMeasurementControlStruct *aProbe) {
 
     if (ActualPage == PAGE_CHART) {
         if (IndexOfDisplayedProbe == aProbe->ProbeIndex) {
-            // Redraw chart
-            drawData(false);
+            // Redraw chart by main loop
+            doDrawData = true;
         }
         if ((aProbe->ProbeIndex == IndexOfDisplayedProbe) && (aProbe->SampleCount == 1)
                 && (AccuCapDisplayControl[aProbe->ProbeIndex].ChartShowMode == SHOW_MODE_GUI)) {
@@ -1428,6 +1442,7 @@ void drawAccuCapacitySettingsPage(void) {
     snprintf(&StringExternalAttenuatorFactor[STRING_EXTERNAL_ATTENUATOR_FACTOR_NUMBER_INDEX], 6, "%5.2f",
             BatteryControl[IndexOfDisplayedProbe].ExternalAttenuatorFactor);
     TouchButtonSetExternalAttenuatorFactor.setText(StringExternalAttenuatorFactor, true);
+    TouchButtonSetExportBinary.drawButton();
 
     if (BatteryControl[IndexOfDisplayedProbe].Mode != MODE_EXTERNAL_VOLTAGE) {
         if (BatteryControl[IndexOfDisplayedProbe].Mode == MODE_CHARGING) {
@@ -1528,33 +1543,86 @@ void redrawAccuCapacityChartPage(void) {
     drawData(false);
 }
 
-/**
- * draws the actual data chart(s)
- * @param doClearBefore do a clear and refresh cleared gui etc. before
+/*
+ * Number of columns drawn for each channel of the displayed chart. Used to draw only the columns of new samples.
  */
-void drawData(bool doClearBefore) {
-    if (doClearBefore) {
-        VoltageCharts[IndexOfDisplayedProbe]->clear();
-        VoltageCharts[IndexOfDisplayedProbe]->drawGrid();
+static uint16_t sHistoryColumnsDrawn[SAMPLE_HISTORY_NUMBER_OF_CHANNELS];
 
-        // show eventually gui and values which was cleared before
-        activateOrShowChartGui();
-        printBatteryValues();
+/*
+ * Decodes only the samples visible in the chart from history and draws them.
+ * If the chart is compressed, each column shows minimum and maximum of its samples,
+ * so short ESR peaks and voltage dips are still visible.
+ * @param aOnlyNewColumns draw only the last column drawn before and the columns of the samples appended since then
+ */
+static void drawHistoryChannel(Chart *aChart, uint8_t aChannel, bool aOnlyNewColumns) {
+    uint16_t tStartIndex = AccuCapDisplayControl[IndexOfDisplayedProbe].XStartIndex
+            * VoltageCharts[IndexOfDisplayedProbe]->getGridXPixelSpacing();
+    int8_t tXDataScaleFactor = aChart->getXDataScaleFactor();
+    if (tXDataScaleFactor > CHART_X_AXIS_SCALE_FACTOR_1) {
+        /*
+         * Expansion - at most chart width samples are visible, so always draw all
+         */
+        UINT tCount = aChart->getWidthX();
+        uint16_t *tDataBufferPtr = (uint16_t*) malloc(sizeof(uint16_t) * tCount);
+        if (tDataBufferPtr == NULL) {
+            failParamMessage(sizeof(uint16_t) * tCount, "malloc() fails");
+            return;
+        }
+        tCount = SampleHistory_readChannel(&BatteryControl[IndexOfDisplayedProbe].History, tStartIndex, tCount, aChannel,
+                tDataBufferPtr);
+        aChart->drawChartData((int16_t*) tDataBufferPtr, tCount, CHART_MODE_LINE);
+        free(tDataBufferPtr);
+        sHistoryColumnsDrawn[aChannel] = 0;
+        return;
+    }
 
-        VoltageCharts[IndexOfDisplayedProbe]->drawXAxisTitle();
+    /*
+     * Compression - draw envelope
+     */
+    uint16_t tHalfSamplesPerColumn = 2;
+    if (tXDataScaleFactor == CHART_X_AXIS_SCALE_FACTOR_COMPRESSION_1_5) {
+        tHalfSamplesPerColumn = 3;
+    } else if (tXDataScaleFactor < CHART_X_AXIS_SCALE_FACTOR_COMPRESSION_1_5) {
+        tHalfSamplesPerColumn = -2 * tXDataScaleFactor;
     }
+    UINT tFirstColumn = 0;
+    if (aOnlyNewColumns && sHistoryColumnsDrawn[aChannel] > 1) {
+        // the last column drawn may have got new samples and the column before is required for connecting
+        tFirstColumn = sHistoryColumnsDrawn[aChannel] - 2;
+        if (tHalfSamplesPerColumn & 0x01) {
+            // start at a column with an integer sample index
+            tFirstColumn &= ~0x01;
+        }
+    }
+    if (tFirstColumn >= aChart->getWidthX()) {
+        return;
+    }
+    UINT tColumns = aChart->getWidthX() - tFirstColumn;
+    uint16_t *tMinValues = (uint16_t*) malloc(2 * sizeof(uint16_t) * tColumns);
+    if (tMinValues == NULL) {
+        failParamMessage(2 * sizeof(uint16_t) * tColumns, "malloc() fails");
+        return;
+    }
+    uint16_t *tMaxValues = tMinValues + tColumns;
+    tColumns = SampleHistory_readEnvelope(&BatteryControl[IndexOfDisplayedProbe].History,
+            tStartIndex + ((tFirstColumn * tHalfSamplesPerColumn) / 2), tHalfSamplesPerColumn, tColumns, aChannel, tMinValues,
+            tMaxValues);
+    aChart->drawChartDataMinMax(tMinValues, tMaxValues, tColumns, tFirstColumn);
+    free(tMinValues);
+    sHistoryColumnsDrawn[aChannel] = tFirstColumn + tColumns;
+}
 
+/*
+ * Draws the data chart(s) selected by ActualDataChart
+ */
+static void drawHistoryCharts(bool doClearBefore, bool aOnlyNewColumns) {
     if (AccuCapDisplayControl[IndexOfDisplayedProbe].ActualDataChart == CHART_DATA_BOTH
             || AccuCapDisplayControl[IndexOfDisplayedProbe].ActualDataChart == CHART_DATA_VOLTAGE) {
         if (doClearBefore) {
             VoltageCharts[IndexOfDisplayedProbe]->drawYAxisTitle(CHART_Y_LABEL_OFFSET_VOLTAGE);
         }
-        // Voltage buffer
-        VoltageCharts[IndexOfDisplayedProbe]->drawChartData(
-                (int16_t*) (&BatteryControl[IndexOfDisplayedProbe].VoltageNoLoadDatabuffer[0]
-                        + AccuCapDisplayControl[IndexOfDisplayedProbe].XStartIndex
-                                * VoltageCharts[IndexOfDisplayedProbe]->getGridXPixelSpacing()),
-                BatteryControl[IndexOfDisplayedProbe].SampleCount, CHART_MODE_LINE);
+        // Voltage
+        drawHistoryChannel(VoltageCharts[IndexOfDisplayedProbe], HISTORY_CHANNEL_VOLTAGE, aOnlyNewColumns);
 
     }
     if (AccuCapDisplayControl[IndexOfDisplayedProbe].ActualDataChart == CHART_DATA_BOTH
@@ -1564,16 +1632,39 @@ void drawData(bool doClearBefore) {
             if (doClearBefore) {
                 ResistanceCharts[IndexOfDisplayedProbe]->drawYAxisTitle(CHART_Y_LABEL_OFFSET_RESISTANCE);
             }
-            // Milli-OHM buffer
-            ResistanceCharts[IndexOfDisplayedProbe]->drawChartData(
-                    (int16_t*) (&BatteryControl[IndexOfDisplayedProbe].ESRMilliohmDatabuffer[0]
-                            + AccuCapDisplayControl[IndexOfDisplayedProbe].XStartIndex
-                                    * VoltageCharts[IndexOfDisplayedProbe]->getGridXPixelSpacing()),
-                    BatteryControl[IndexOfDisplayedProbe].SampleCount, CHART_MODE_LINE);
+            // Milli-OHM
+            drawHistoryChannel(ResistanceCharts[IndexOfDisplayedProbe], HISTORY_CHANNEL_ESR, aOnlyNewColumns);
         }
     }
 }
 
+/**
+ * Draws only the columns of the samples stored since the last drawing, instead of the whole chart.
+ * Called by loop after storeBatteryValues().
+ */
+void drawNewData(void) {
+    drawHistoryCharts(false, true);
+}
+
+/**
+ * draws the actual data chart(s)
+ * Must not be called by ISR, since history may be read from card
+ * @param doClearBefore do a clear and refresh cleared gui etc. before
+ */
+void drawData(bool doClearBefore) {
+    if (doClearBefore) {
+        VoltageCharts[IndexOfDisplayedProbe]->clear();
+        VoltageCharts[IndexOfDisplayedProbe]->drawGrid();
+
+        // show eventually gui and values which was cleared before
+        activateOrShowChartGui();
+        printBatteryValues();
+
+        VoltageCharts[IndexOfDisplayedProbe]->drawXAxisTitle();
+    }
+    drawHistoryCharts(doClearBefore, false);
+}
+
 /**
  * 	draws buttons if mode == SHOW_MODE_GUI
  * 	else only activate them
@@ -0,0 +1,263 @@
+/*
+ * AccuCapacityScheduler.hpp
+ *
+ * Non blocking measurement scheduler of AccuCapacity.hpp.
+ * Separated to be included by the host simulation extras/AccuCapacitySchedulerSimulation.cpp.
+ * Requires the definitions of DataloggerMeasurementControlStruct, BatteryControl[], setSinkSource() and storeBatteryValues().
+ *
+ *  Copyright (C) 2012-2023  Armin Joachimsmeyer
+ *  armin.joachimsmeyer@gmail.com
+ *
+ *  This file is part of STMF3-Discovery-Demos https://github.com/ArminJo/STMF3-Discovery-Demos.
+ *
+ *  STMF3-Discovery-Demos is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program. If not, see <http://www.gnu.org/licenses/gpl.html>.
+ */
+
+#ifndef _ACCU_CAPACITY_SCHEDULER_HPP
+#define _ACCU_CAPACITY_SCHEDULER_HPP
+
+/*
+ * Non blocking measurement of all probes
+ * Each probe is measured every SAMPLE_PERIOD_MILLIS by a state machine, which is run by callbackMeasurementScheduler().
+ * While a probe is measured, the callback is called every millisecond. It starts one ADC conversion per call
+ * and reads it at the next call, so it never waits for the ADC or for the voltage to settle.
+ * The probes are staggered by SAMPLE_PERIOD_MILLIS / NUMBER_OF_PROBES. If they still overlap,
+ * a probe waits until the other has finished its conversions.
+ */
+#define MEASUREMENT_STATE_IDLE              0
+#define MEASUREMENT_STATE_SAMPLE_LOAD       1 // voltage with load, or voltage without load if not started
+#define MEASUREMENT_STATE_SETTLE            2 // load disconnected, wait for voltage to settle
+#define MEASUREMENT_STATE_SAMPLE_NO_LOAD    3
+#define MEASUREMENT_OVERSAMPLING            8 // conversions per voltage, one per millisecond
+#define MEASUREMENT_NO_PROBE                0xFF
+
+struct MeasurementSchedulerStruct {
+    uint8_t State;
+    uint8_t ConversionCount; // conversions started in actual sample state
+    uint16_t ConversionSum;
+    uint32_t NextMillis; // of next step
+    uint32_t PeriodStartMillis;
+    uint32_t LoadOffMillis; // millis() when load was disconnected for ESR measurement
+    uint16_t MeasurementsUntilStore; // countdown for storeBatteryValues()
+} sMeasurementScheduler[NUMBER_OF_PROBES];
+uint8_t sADCProbeIndex = MEASUREMENT_NO_PROBE; // probe which uses the ADC at the moment
+bool sMeasurementSchedulerIsRunning = false;
+
+uint16_t getMeasurementsPerStore(DataloggerMeasurementControlStruct *aProbe) {
+    return (aProbe->SamplePeriodSeconds * ONE_SECOND_MILLIS) / SAMPLE_PERIOD_MILLIS;
+}
+
+/*
+ * Convert sum of MEASUREMENT_OVERSAMPLING readings and compensate for external attenuator
+ */
+uint16_t getBatteryVoltageMillivolt(DataloggerMeasurementControlStruct *aProbe, uint16_t aReadingSum) {
+    return aReadingSum * (aProbe->ExternalAttenuatorFactor * sADCToVoltFactor * (1000.0f / MEASUREMENT_OVERSAMPLING));
+}
+
+static void startSampleState(MeasurementSchedulerStruct *aScheduler, uint8_t aState) {
+    aScheduler->State = aState;
+    aScheduler->ConversionCount = 0;
+    aScheduler->ConversionSum = 0;
+}
+
+/*
+ * Reads the conversion started at the last call and starts the next one
+ * @return true if all MEASUREMENT_OVERSAMPLING conversions are done
+ */
+static bool doConversionStep(DataloggerMeasurementControlStruct *aProbe, MeasurementSchedulerStruct *aScheduler) {
+    if (aScheduler->ConversionCount == 0) {
+        if (sADCProbeIndex != MEASUREMENT_NO_PROBE && sADCProbeIndex != aProbe->ProbeIndex) {
+            // ADC is used by other probe
+            return false;
+        }
+        sADCProbeIndex = aProbe->ProbeIndex;
+        AccuCapacity_ADCSelectProbe(aProbe->ProbeIndex);
+    } else {
+        int tReading = AccuCapacity_ADCGetConversion();
+        if (tReading < 0) {
+            return false;
+        }
+        aScheduler->ConversionSum += tReading;
+        if (aScheduler->ConversionCount == MEASUREMENT_OVERSAMPLING) {
+            sADCProbeIndex = MEASUREMENT_NO_PROBE;
+            return true;
+        }
+    }
+    AccuCapacity_ADCStartConversion();
+    aScheduler->ConversionCount++;
+    return false;
+}
+
+/*
+ * Compute current using source / load resistor value
+ */
+static void setLoadValues(DataloggerMeasurementControlStruct *aProbe, uint16_t aVoltageLoadMillivolt) {
+    aProbe->BatteryInfo.VoltageLoadMillivolt = aVoltageLoadMillivolt;
+    int tEffectiveVoltageMillivolt = aVoltageLoadMillivolt;
+    if (aProbe->Mode != MODE_DISCHARGING) {
+        // assume charging for extern
+        tEffectiveVoltageMillivolt = aProbe->ChargeVoltageMillivolt - aVoltageLoadMillivolt;
+    }
+    aProbe->BatteryInfo.Milliampere = ((tEffectiveVoltageMillivolt * 1000) + (aProbe->LoadResistorMilliohm / 2))
+            / aProbe->LoadResistorMilliohm;
+}
+
+/*
+ * Compute ESR = internal Equivalent Series Resistance
+ */
+static void setESRValues(DataloggerMeasurementControlStruct *aProbe, uint16_t aVoltageNoLoadMillivolt) {
+    aProbe->BatteryInfo.VoltageNoLoadMillivolt = aVoltageNoLoadMillivolt;
+    uint16_t tVoltageLoadMillivolt = aProbe->BatteryInfo.VoltageLoadMillivolt;
+    int16_t tESRTestDeltaMillivolt = aVoltageNoLoadMillivolt - tVoltageLoadMillivolt;
+    if (aProbe->Mode == MODE_CHARGING) {
+        tESRTestDeltaMillivolt = -tESRTestDeltaMillivolt;
+    }
+    if (tESRTestDeltaMillivolt <= 0 || tVoltageLoadMillivolt < 100 || aProbe->BatteryInfo.Milliampere <= 0) {
+        // plausibility fails
+        aProbe->BatteryInfo.ESRMilliohm = 0;
+    } else {
+        aProbe->BatteryInfo.sESRTestDeltaMillivolt = tESRTestDeltaMillivolt;
+        aProbe->BatteryInfo.ESRMilliohm = (tESRTestDeltaMillivolt * 1000L) / aProbe->BatteryInfo.Milliampere;
+    }
+}
+
+/*
+ * Capacity computation and store of values at end of measurement
+ * @param aLoadOffMillis time without load, which is subtracted from the period for capacity computation
+ */
+static void finishMeasurement(DataloggerMeasurementControlStruct *aProbe, MeasurementSchedulerStruct *aScheduler,
+        uint32_t aMillis, uint32_t aLoadOffMillis) {
+    aScheduler->State = MEASUREMENT_STATE_IDLE;
+    aScheduler->NextMillis = aScheduler->PeriodStartMillis + SAMPLE_PERIOD_MILLIS;
+    if ((int32_t) (aMillis - aScheduler->NextMillis) >= 0) {
+        // we are late, e.g. because of a long blocking interrupt
+        aScheduler->NextMillis = aMillis + 1;
+    }
+    if (aProbe->IsStarted) {
+        int16_t tMilliampere = aProbe->BatteryInfo.Milliampere;
+        if (tMilliampere > 1) {
+            // rounded, since truncation of each sample sums up to a relevant error
+            aProbe->BatteryInfo.CapacityAccumulator += ((tMilliampere * (SAMPLE_PERIOD_MILLIS - aLoadOffMillis))
+                    + (SAMPLE_PERIOD_MILLIS / 2)) / SAMPLE_PERIOD_MILLIS;
+            aProbe->BatteryInfo.CapacityMilliampereHour = aProbe->BatteryInfo.CapacityAccumulator
+                    / ((3600L * ONE_SECOND_MILLIS) / SAMPLE_PERIOD_MILLIS); // = / 3600 for 1 s sample period
+        }
+        aScheduler->MeasurementsUntilStore--;
+        if (aScheduler->MeasurementsUntilStore == 0) {
+            aScheduler->MeasurementsUntilStore = getMeasurementsPerStore(aProbe);
+            storeBatteryValues(aProbe);
+        }
+    }
+}
+
+/*
+ * One step of the measurement state machine of a probe
+ * Gets Load and NoLoad voltages and computes current, capacity and resistance
+ */
+static void doMeasurementStep(DataloggerMeasurementControlStruct *aProbe, MeasurementSchedulerStruct *aScheduler,
+        uint32_t aMillis) {
+    uint16_t tVoltageMillivolt;
+    switch (aScheduler->State) {
+    case MEASUREMENT_STATE_IDLE:
+        aScheduler->PeriodStartMillis = aScheduler->NextMillis;
+        startSampleState(aScheduler, MEASUREMENT_STATE_SAMPLE_LOAD);
+        // no break
+    case MEASUREMENT_STATE_SAMPLE_LOAD:
+        if (!doConversionStep(aProbe, aScheduler)) {
+            aScheduler->NextMillis = aMillis + 1;
+            return;
+        }
+        tVoltageMillivolt = getBatteryVoltageMillivolt(aProbe, aScheduler->ConversionSum);
+        if (!aProbe->IsStarted || aProbe->Mode == MODE_EXTERNAL_VOLTAGE) {
+            // no load connected
+            aProbe->BatteryInfo.VoltageNoLoadMillivolt = tVoltageMillivolt;
+            if (aProbe->IsStarted) {
+                setLoadValues(aProbe, tVoltageMillivolt);
+            }
+            finishMeasurement(aProbe, aScheduler, aMillis, 0);
+            return;
+        }
+        setLoadValues(aProbe, tVoltageMillivolt);
+        // disconnect from sink/source and wait
+        setSinkSource(aProbe->ProbeIndex, false);
+        aScheduler->LoadOffMillis = aMillis;
+        aScheduler->State = MEASUREMENT_STATE_SETTLE;
+        aScheduler->NextMillis = aMillis + LOAD_SWITCH_SETTLE_TIME_MILLIS;
+        return;
+
+    case MEASUREMENT_STATE_SETTLE:
+        startSampleState(aScheduler, MEASUREMENT_STATE_SAMPLE_NO_LOAD);
+        // no break
+    case MEASUREMENT_STATE_SAMPLE_NO_LOAD:
+        if (!doConversionStep(aProbe, aScheduler)) {
+            aScheduler->NextMillis = aMillis + 1;
+            return;
+        }
+        //reconnect to sink/source, if not stopped in the meantime
+        setSinkSource(aProbe->ProbeIndex, aProbe->IsStarted);
+        setESRValues(aProbe, getBatteryVoltageMillivolt(aProbe, aScheduler->ConversionSum));
+        finishMeasurement(aProbe, aScheduler, aMillis, aMillis - aScheduler->LoadOffMillis);
+        return;
+    }
+}
+
+/**
+ * Callback for Timer. Runs the measurement state machines and registers itself for the next step of any probe.
+ */
+void callbackMeasurementScheduler(void) {
+    uint32_t tMillis = millis();
+    int32_t tDelayMillis = SAMPLE_PERIOD_MILLIS;
+    for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+        MeasurementSchedulerStruct *tScheduler = &sMeasurementScheduler[i];
+        if ((int32_t) (tMillis - tScheduler->NextMillis) >= 0) {
+            doMeasurementStep(&BatteryControl[i], tScheduler, tMillis);
+        }
+        int32_t tProbeDelayMillis = tScheduler->NextMillis - tMillis;
+        if (tProbeDelayMillis < tDelayMillis) {
+            tDelayMillis = tProbeDelayMillis;
+        }
+    }
+    if (tDelayMillis < 1) {
+        tDelayMillis = 1;
+    }
+    changeDelayCallback(&callbackMeasurementScheduler, tDelayMillis);
+}
+
+/*
+ * Starts the measurement of all probes. Measurement continues if page is left while a probe is started.
+ */
+void startMeasurementScheduler(void) {
+    if (!sMeasurementSchedulerIsRunning) {
+        uint32_t tMillis = millis();
+        for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+            sMeasurementScheduler[i].State = MEASUREMENT_STATE_IDLE;
+            sMeasurementScheduler[i].NextMillis = tMillis + 1 + (i * (SAMPLE_PERIOD_MILLIS / NUMBER_OF_PROBES));
+        }
+        sADCProbeIndex = MEASUREMENT_NO_PROBE;
+        sMeasurementSchedulerIsRunning = true;
+        changeDelayCallback(&callbackMeasurementScheduler, 1);
+    }
+}
+
+void stopMeasurementScheduler(void) {
+    for (int i = 0; i < NUMBER_OF_PROBES; ++i) {
+        if (BatteryControl[i].IsStarted) {
+            return;
+        }
+    }
+    changeDelayCallback(&callbackMeasurementScheduler, DISABLE_TIMER_DELAY_VALUE);
+    sMeasurementSchedulerIsRunning = false;
+}
+
+#endif // _ACCU_CAPACITY_SCHEDULER_HPP
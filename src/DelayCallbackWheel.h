@@ -0,0 +1,95 @@
+/*
+ * @file DelayCallbackWheel.h
+ *
+ * Hierarchical timing wheel for the delay callbacks of the SysTick handler.
+ * For up to DELAY_CALLBACK_TABLE_ENTRIES_MAX entries, the callbacks are still kept in a table, which is scanned
+ * and decremented completely every millisecond, because this is faster than the wheel for a few callbacks.
+ *
+ * Level 0 has 2^DELAY_CALLBACK_WHEEL_BITS slots of 1 ms, level n slots of 2^(n * DELAY_CALLBACK_WHEEL_BITS) ms.
+ * An entry is put into the lowest level, which covers its delay. Every 2^(n * DELAY_CALLBACK_WHEEL_BITS) ms
+ * one slot of level n is cascaded, i.e. its entries are put again into the lower levels.
+ * So each tick costs O(1) plus the number of entries expiring or cascaded in this tick,
+ * and an entry is cascaded at most DELAY_CALLBACK_WHEEL_LEVELS - 1 times.
+ * Insertion and removal are O(1), the entry of a callback is found by a small hash table.
+ *
+ * Expired entries are moved to the expired list by DelayCallbackWheel_tick(),
+ * DelayCallbackWheel_runExpired() frees them and calls their callbacks.
+ * This allows to run the callbacks in another context than the tick.
+ *
+ * All list operations are done with DELAY_CALLBACK_WHEEL_LOCK(), since callbacks are changed by ISRs
+ * with higher priority than SysTick. The longest lock is one tick with DELAY_CALLBACK_ENTRIES_SIZE entries to cascade.
+ * Contains no HAL code and runs on the host.
+ *
+ * RAM on 32 bit ARM: wheel 16 bytes per entry + 2 bytes per list + 32 bytes hash,
+ * table 8 bytes per entry, 92 bytes for the default of 11 entries.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _DELAY_CALLBACK_WHEEL_H
+#define _DELAY_CALLBACK_WHEEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 4 + 1 callbacks for accuCapacity
+// 3 callbacks for Touch
+// 1 callback for LCD dimming
+// 1 callback for tone duration
+// 1 one time callback for delayed MMC initialization
+#if !defined(DELAY_CALLBACK_ENTRIES_SIZE)
+#define DELAY_CALLBACK_ENTRIES_SIZE     11
+#endif
+/*
+ * For a few callbacks, the wheel costs more per tick than the table, see extras/DelayCallbackWheelSimulation.cpp
+ */
+#if !defined(DELAY_CALLBACK_TABLE_ENTRIES_MAX)
+#define DELAY_CALLBACK_TABLE_ENTRIES_MAX    16
+#endif
+
+#if !defined(DELAY_CALLBACK_WHEEL_BITS)
+#define DELAY_CALLBACK_WHEEL_BITS       6 // 64 slots per level
+#endif
+#if !defined(DELAY_CALLBACK_WHEEL_LEVELS)
+#define DELAY_CALLBACK_WHEEL_LEVELS     5 // 2^30 ms = 12 days. Longer delays are cascaded again.
+#endif
+#define DELAY_CALLBACK_WHEEL_SLOTS      (1 << DELAY_CALLBACK_WHEEL_BITS)
+#define DELAY_CALLBACK_WHEEL_MASK       (DELAY_CALLBACK_WHEEL_SLOTS - 1)
+#define DELAY_CALLBACK_WHEEL_MAX_DELAY  ((1UL << (DELAY_CALLBACK_WHEEL_BITS * DELAY_CALLBACK_WHEEL_LEVELS)) - 1)
+
+#if !defined(DELAY_CALLBACK_HASH_SIZE)
+#define DELAY_CALLBACK_HASH_SIZE        32 // must be a power of 2
+#endif
+
+typedef struct {
+    uint32_t Ticks;
+    uint32_t CallbacksCalled;
+    uint32_t EntriesCascaded;
+    uint16_t ExpiredPerTickMax;
+    uint16_t EntriesUsed;
+    uint16_t EntriesUsedMax;
+} DelayCallbackWheelStatisticsTypeDef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+bool DelayCallbackWheel_add(void (*aCallback)(void), int32_t aTimeMillis);
+bool DelayCallbackWheel_change(void (*aCallback)(void), int32_t aTimeMillis);
+
+uint_fast16_t DelayCallbackWheel_tick(void);
+bool DelayCallbackWheel_hasExpired(void);
+void DelayCallbackWheel_runExpired(void);
+
+DelayCallbackWheelStatisticsTypeDef* DelayCallbackWheel_getStatistics(void);
+void DelayCallbackWheel_resetStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DELAY_CALLBACK_WHEEL_H
@@ -0,0 +1,426 @@
+/*
+ * @file DelayCallbackWheel.hpp
+ *
+ * Implementation of the timing wheel and the table for delay callbacks, see DelayCallbackWheel.h.
+ * The includer must define DELAY_CALLBACK_WHEEL_LOCK() and DELAY_CALLBACK_WHEEL_UNLOCK()
+ * to mask and restore the interrupts calling the functions. Without them, the wheel must only be used from one context.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _DELAY_CALLBACK_WHEEL_HPP
+#define _DELAY_CALLBACK_WHEEL_HPP
+
+#include "DelayCallbackWheel.h"
+#include <string.h> // for memset
+
+#if !defined(DELAY_CALLBACK_WHEEL_LOCK)
+#define DELAY_CALLBACK_WHEEL_LOCK()     void()
+#define DELAY_CALLBACK_WHEEL_UNLOCK()   void()
+#endif
+
+static DelayCallbackWheelStatisticsTypeDef sDelayCallbackWheelStatistics;
+
+#if DELAY_CALLBACK_ENTRIES_SIZE > DELAY_CALLBACK_TABLE_ENTRIES_MAX
+/*
+ * Entry indexes are stored 1 based, so 0 is the end of a list and all statics can be zero initialized
+ */
+#if DELAY_CALLBACK_ENTRIES_SIZE < 255
+typedef uint8_t DelayCallbackIndex_t;
+#else
+typedef uint16_t DelayCallbackIndex_t;
+#endif
+#define DELAY_CALLBACK_NO_ENTRY         0
+
+#define DELAY_CALLBACK_LIST_EXPIRED     (DELAY_CALLBACK_WHEEL_LEVELS * DELAY_CALLBACK_WHEEL_SLOTS)
+#define DELAY_CALLBACK_NUMBER_OF_LISTS  (DELAY_CALLBACK_LIST_EXPIRED + 1)
+#define DELAY_CALLBACK_LIST_FREE        0xFFFF
+
+typedef struct {
+    void (*Callback)(void);
+    uint32_t ExpiryMillis;
+    uint16_t List; // index of wheel slot or DELAY_CALLBACK_LIST_EXPIRED or DELAY_CALLBACK_LIST_FREE
+    DelayCallbackIndex_t Next; // in list, for free entries in free list
+    DelayCallbackIndex_t Previous;
+    DelayCallbackIndex_t NextInHash;
+} DelayCallbackEntryStruct;
+
+static DelayCallbackEntryStruct sDelayCallbackEntries[DELAY_CALLBACK_ENTRIES_SIZE];
+static DelayCallbackIndex_t sDelayCallbackListHeads[DELAY_CALLBACK_NUMBER_OF_LISTS];
+static DelayCallbackIndex_t sDelayCallbackHashHeads[DELAY_CALLBACK_HASH_SIZE];
+static DelayCallbackIndex_t sDelayCallbackFreeListHead;
+static DelayCallbackIndex_t sDelayCallbackNeverUsedIndex; // entries above were never used and are not in free list
+static uint32_t sDelayCallbackWheelMillis; // time of the last tick
+
+#define DELAY_CALLBACK_ENTRY(aIndex)    (&sDelayCallbackEntries[(aIndex) - 1])
+
+static uint_fast8_t getDelayCallbackHash(void (*aCallback)(void)) {
+    uintptr_t tValue = (uintptr_t) aCallback;
+    // ARM function pointers are odd (thumb bit) and 2 byte aligned
+    return ((tValue >> 1) ^ (tValue >> 6)) & (DELAY_CALLBACK_HASH_SIZE - 1);
+}
+
+static void pushToList(uint16_t aList, DelayCallbackIndex_t aIndex) {
+    DelayCallbackEntryStruct *tEntry = DELAY_CALLBACK_ENTRY(aIndex);
+    DelayCallbackIndex_t tHead = sDelayCallbackListHeads[aList];
+    tEntry->List = aList;
+    tEntry->Previous = DELAY_CALLBACK_NO_ENTRY;
+    tEntry->Next = tHead;
+    if (tHead != DELAY_CALLBACK_NO_ENTRY) {
+        DELAY_CALLBACK_ENTRY(tHead)->Previous = aIndex;
+    }
+    sDelayCallbackListHeads[aList] = aIndex;
+}
+
+static void removeFromList(DelayCallbackIndex_t aIndex) {
+    DelayCallbackEntryStruct *tEntry = DELAY_CALLBACK_ENTRY(aIndex);
+    if (tEntry->Previous == DELAY_CALLBACK_NO_ENTRY) {
+        sDelayCallbackListHeads[tEntry->List] = tEntry->Next;
+    } else {
+        DELAY_CALLBACK_ENTRY(tEntry->Previous)->Next = tEntry->Next;
+    }
+    if (tEntry->Next != DELAY_CALLBACK_NO_ENTRY) {
+        DELAY_CALLBACK_ENTRY(tEntry->Next)->Previous = tEntry->Previous;
+    }
+}
+
+/*
+ * Puts the entry into the lowest level covering its delay.
+ * The slot of level n is taken from the bits of the expiry time, so it is cascaded when the time
+ * reaches the start of the slot and all higher bits are equal.
+ */
+static void insertIntoWheel(DelayCallbackIndex_t aIndex) {
+    uint32_t tExpiryMillis = DELAY_CALLBACK_ENTRY(aIndex)->ExpiryMillis;
+    uint32_t tDelta = tExpiryMillis - sDelayCallbackWheelMillis;
+    if (tDelta > DELAY_CALLBACK_WHEEL_MAX_DELAY) {
+        // put it into the last slot of the highest level, it is inserted again when this slot is cascaded
+        tExpiryMillis = sDelayCallbackWheelMillis + DELAY_CALLBACK_WHEEL_MAX_DELAY;
+        tDelta = DELAY_CALLBACK_WHEEL_MAX_DELAY;
+    }
+    uint_fast8_t tLevel = 0;
+    while (tDelta >= DELAY_CALLBACK_WHEEL_SLOTS) {
+        tDelta >>= DELAY_CALLBACK_WHEEL_BITS;
+        tLevel++;
+    }
+    uint_fast8_t tSlot = (tExpiryMillis >> (tLevel * DELAY_CALLBACK_WHEEL_BITS)) & DELAY_CALLBACK_WHEEL_MASK;
+    pushToList((tLevel * DELAY_CALLBACK_WHEEL_SLOTS) + tSlot, aIndex);
+}
+
+static DelayCallbackIndex_t findEntry(void (*aCallback)(void)) {
+    DelayCallbackIndex_t tIndex = sDelayCallbackHashHeads[getDelayCallbackHash(aCallback)];
+    while (tIndex != DELAY_CALLBACK_NO_ENTRY && DELAY_CALLBACK_ENTRY(tIndex)->Callback != aCallback) {
+        tIndex = DELAY_CALLBACK_ENTRY(tIndex)->NextInHash;
+    }
+    return tIndex;
+}
+
+/*
+ * @return DELAY_CALLBACK_NO_ENTRY if all entries are used
+ */
+static DelayCallbackIndex_t allocateEntry(void (*aCallback)(void)) {
+    DelayCallbackIndex_t tIndex = sDelayCallbackFreeListHead;
+    if (tIndex != DELAY_CALLBACK_NO_ENTRY) {
+        sDelayCallbackFreeListHead = DELAY_CALLBACK_ENTRY(tIndex)->Next;
+    } else if (sDelayCallbackNeverUsedIndex < DELAY_CALLBACK_ENTRIES_SIZE) {
+        tIndex = ++sDelayCallbackNeverUsedIndex;
+    } else {
+        return DELAY_CALLBACK_NO_ENTRY;
+    }
+    DelayCallbackEntryStruct *tEntry = DELAY_CALLBACK_ENTRY(tIndex);
+    tEntry->Callback = aCallback;
+    uint_fast8_t tHash = getDelayCallbackHash(aCallback);
+    tEntry->NextInHash = sDelayCallbackHashHeads[tHash];
+    sDelayCallbackHashHeads[tHash] = tIndex;
+
+    if (++sDelayCallbackWheelStatistics.EntriesUsed > sDelayCallbackWheelStatistics.EntriesUsedMax) {
+        sDelayCallbackWheelStatistics.EntriesUsedMax = sDelayCallbackWheelStatistics.EntriesUsed;
+    }
+    return tIndex;
+}
+
+/*
+ * Entry must already be removed from its list
+ */
+static void freeEntry(DelayCallbackIndex_t aIndex) {
+    DelayCallbackEntryStruct *tEntry = DELAY_CALLBACK_ENTRY(aIndex);
+    DelayCallbackIndex_t *tLinkPointer = &sDelayCallbackHashHeads[getDelayCallbackHash(tEntry->Callback)];
+    while (*tLinkPointer != aIndex) {
+        tLinkPointer = &DELAY_CALLBACK_ENTRY(*tLinkPointer)->NextInHash;
+    }
+    *tLinkPointer = tEntry->NextInHash;
+
+    tEntry->List = DELAY_CALLBACK_LIST_FREE;
+    tEntry->Next = sDelayCallbackFreeListHead;
+    sDelayCallbackFreeListHead = aIndex;
+    sDelayCallbackWheelStatistics.EntriesUsed--;
+}
+
+/**
+ * Adds a new entry, even if the callback is already registered.
+ * @param aTimeMillis values <= 0 are ignored like before, the callback is never called
+ * @return false if all entries are used
+ */
+bool DelayCallbackWheel_add(void (*aCallback)(void), int32_t aTimeMillis) {
+    if (aTimeMillis <= 0) {
+        return true;
+    }
+    bool tReturnValue = false;
+    DELAY_CALLBACK_WHEEL_LOCK();
+    DelayCallbackIndex_t tIndex = allocateEntry(aCallback);
+    if (tIndex != DELAY_CALLBACK_NO_ENTRY) {
+        DELAY_CALLBACK_ENTRY(tIndex)->ExpiryMillis = sDelayCallbackWheelMillis + aTimeMillis;
+        insertIntoWheel(tIndex);
+        tReturnValue = true;
+    }
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tReturnValue;
+}
+
+/**
+ * Changes the delay of the last registered entry of the callback or adds one.
+ * If the callback has expired, but is not yet called, the call is dropped.
+ * @param aTimeMillis values <= 0 remove the entry
+ * @return false if all entries are used
+ */
+bool DelayCallbackWheel_change(void (*aCallback)(void), int32_t aTimeMillis) {
+    bool tReturnValue = true;
+    DELAY_CALLBACK_WHEEL_LOCK();
+    DelayCallbackIndex_t tIndex = findEntry(aCallback);
+    if (tIndex != DELAY_CALLBACK_NO_ENTRY) {
+        removeFromList(tIndex);
+        if (aTimeMillis <= 0) {
+            freeEntry(tIndex);
+        } else {
+            DELAY_CALLBACK_ENTRY(tIndex)->ExpiryMillis = sDelayCallbackWheelMillis + aTimeMillis;
+            insertIntoWheel(tIndex);
+        }
+    } else if (aTimeMillis > 0) {
+        tIndex = allocateEntry(aCallback);
+        if (tIndex != DELAY_CALLBACK_NO_ENTRY) {
+            DELAY_CALLBACK_ENTRY(tIndex)->ExpiryMillis = sDelayCallbackWheelMillis + aTimeMillis;
+            insertIntoWheel(tIndex);
+        } else {
+            tReturnValue = false;
+        }
+    }
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tReturnValue;
+}
+
+/**
+ * Advances the wheel by 1 ms and moves the expired entries to the expired list.
+ * Does not call any callback, so it can be nested e.g. by a busy delay in a callback.
+ * @return number of entries expired in this tick
+ */
+uint_fast16_t DelayCallbackWheel_tick(void) {
+    uint_fast16_t tNumberOfExpired = 0;
+    DELAY_CALLBACK_WHEEL_LOCK();
+    uint32_t tMillis = ++sDelayCallbackWheelMillis;
+    sDelayCallbackWheelStatistics.Ticks++;
+
+    /*
+     * Cascade the current slot of the next level, if the lower bits are 0
+     */
+    for (uint_fast8_t tLevel = 1; tLevel < DELAY_CALLBACK_WHEEL_LEVELS; ++tLevel) {
+        uint_fast8_t tShift = (tLevel - 1) * DELAY_CALLBACK_WHEEL_BITS;
+        if (((tMillis >> tShift) & DELAY_CALLBACK_WHEEL_MASK) != 0) {
+            break;
+        }
+        uint16_t tList = (tLevel * DELAY_CALLBACK_WHEEL_SLOTS)
+                + ((tMillis >> (tShift + DELAY_CALLBACK_WHEEL_BITS)) & DELAY_CALLBACK_WHEEL_MASK);
+        /*
+         * All entries of this slot go to a lower level, except the ones with delays longer than DELAY_CALLBACK_WHEEL_MAX_DELAY,
+         * which go to another slot of the highest level. So this loop ends.
+         */
+        DelayCallbackIndex_t tIndex;
+        while ((tIndex = sDelayCallbackListHeads[tList]) != DELAY_CALLBACK_NO_ENTRY) {
+            removeFromList(tIndex);
+            insertIntoWheel(tIndex);
+            sDelayCallbackWheelStatistics.EntriesCascaded++;
+        }
+    }
+
+    /*
+     * All entries of the current level 0 slot expire now
+     */
+    uint16_t tList = tMillis & DELAY_CALLBACK_WHEEL_MASK;
+    DelayCallbackIndex_t tIndex;
+    while ((tIndex = sDelayCallbackListHeads[tList]) != DELAY_CALLBACK_NO_ENTRY) {
+        removeFromList(tIndex);
+        pushToList(DELAY_CALLBACK_LIST_EXPIRED, tIndex);
+        tNumberOfExpired++;
+    }
+    if (tNumberOfExpired > sDelayCallbackWheelStatistics.ExpiredPerTickMax) {
+        sDelayCallbackWheelStatistics.ExpiredPerTickMax = tNumberOfExpired;
+    }
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tNumberOfExpired;
+}
+
+bool DelayCallbackWheel_hasExpired(void) {
+    return sDelayCallbackListHeads[DELAY_CALLBACK_LIST_EXPIRED] != DELAY_CALLBACK_NO_ENTRY;
+}
+
+/**
+ * Frees the expired entries and calls their callbacks with interrupts enabled.
+ * Entries are taken one by one, so a callback can register itself again and the function can be nested.
+ */
+void DelayCallbackWheel_runExpired(void) {
+    while (true) {
+        DELAY_CALLBACK_WHEEL_LOCK();
+        DelayCallbackIndex_t tIndex = sDelayCallbackListHeads[DELAY_CALLBACK_LIST_EXPIRED];
+        if (tIndex == DELAY_CALLBACK_NO_ENTRY) {
+            DELAY_CALLBACK_WHEEL_UNLOCK();
+            return;
+        }
+        removeFromList(tIndex);
+        void (*tCallback)(void) = DELAY_CALLBACK_ENTRY(tIndex)->Callback;
+        freeEntry(tIndex);
+        sDelayCallbackWheelStatistics.CallbacksCalled++;
+        DELAY_CALLBACK_WHEEL_UNLOCK();
+        tCallback();
+    }
+}
+
+#else // DELAY_CALLBACK_ENTRIES_SIZE > DELAY_CALLBACK_TABLE_ENTRIES_MAX
+#if DELAY_CALLBACK_TABLE_ENTRIES_MAX > 32
+#error "DELAY_CALLBACK_TABLE_ENTRIES_MAX must not exceed the 32 bits of sDelayCallbackExpiredMask"
+#endif
+/*
+ * Table like the former one of timing.cpp. A free entry has a delay of 0 and no bit in sDelayCallbackExpiredMask.
+ */
+static void (*sDelayCallbackTablePointer[DELAY_CALLBACK_ENTRIES_SIZE])(void);
+static int32_t sDelayCallbackTableMillis[DELAY_CALLBACK_ENTRIES_SIZE]; // remaining delay
+static uint32_t sDelayCallbackExpiredMask; // bit n is set if entry n has expired and its callback is not yet called
+
+static bool isFreeTableEntry(uint_fast8_t aIndex) {
+    return sDelayCallbackTableMillis[aIndex] == 0 && (sDelayCallbackExpiredMask & (1UL << aIndex)) == 0;
+}
+
+/*
+ * Takes the first free entry. EntriesUsedMax is the number of entries taken, not only the maximum used at the same time.
+ * EntriesUsed is counted by DelayCallbackWheel_getStatistics(), so calls and re-arming have no statistics overhead.
+ * @return false if all entries are used
+ */
+static bool startFreeTableEntry(void (*aCallback)(void), int32_t aTimeMillis) {
+    uint_fast8_t tIndex = 0;
+    while (!isFreeTableEntry(tIndex)) {
+        if (++tIndex == DELAY_CALLBACK_ENTRIES_SIZE) {
+            return false;
+        }
+    }
+    sDelayCallbackTablePointer[tIndex] = aCallback;
+    sDelayCallbackTableMillis[tIndex] = aTimeMillis;
+    if (tIndex >= sDelayCallbackWheelStatistics.EntriesUsedMax) {
+        sDelayCallbackWheelStatistics.EntriesUsedMax = tIndex + 1;
+    }
+    return true;
+}
+
+bool DelayCallbackWheel_add(void (*aCallback)(void), int32_t aTimeMillis) {
+    if (aTimeMillis <= 0) {
+        return true;
+    }
+    DELAY_CALLBACK_WHEEL_LOCK();
+    bool tReturnValue = startFreeTableEntry(aCallback, aTimeMillis);
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tReturnValue;
+}
+
+/*
+ * Changes the first entry of the callback like the former table, even if this entry is free.
+ * So a callback re-arming itself finds its entry at once.
+ */
+bool DelayCallbackWheel_change(void (*aCallback)(void), int32_t aTimeMillis) {
+    bool tReturnValue = true;
+    DELAY_CALLBACK_WHEEL_LOCK();
+    uint_fast8_t tIndex = 0;
+    while (tIndex < DELAY_CALLBACK_ENTRIES_SIZE && sDelayCallbackTablePointer[tIndex] != aCallback) {
+        tIndex++;
+    }
+    if (tIndex == DELAY_CALLBACK_ENTRIES_SIZE) {
+        if (aTimeMillis > 0) {
+            tReturnValue = startFreeTableEntry(aCallback, aTimeMillis);
+        }
+    } else {
+        // drops a pending call
+        sDelayCallbackExpiredMask &= ~(1UL << tIndex);
+        sDelayCallbackTableMillis[tIndex] = (aTimeMillis > 0) ? aTimeMillis : 0;
+    }
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tReturnValue;
+}
+
+uint_fast16_t DelayCallbackWheel_tick(void) {
+    uint_fast16_t tNumberOfExpired = 0;
+    DELAY_CALLBACK_WHEEL_LOCK();
+    sDelayCallbackWheelStatistics.Ticks++;
+    for (uint_fast8_t i = 0; i < DELAY_CALLBACK_ENTRIES_SIZE; ++i) {
+        if (sDelayCallbackTableMillis[i] > 0) {
+            sDelayCallbackTableMillis[i]--;
+            if (sDelayCallbackTableMillis[i] == 0) {
+                sDelayCallbackExpiredMask |= 1UL << i;
+                tNumberOfExpired++;
+            }
+        }
+    }
+    if (tNumberOfExpired > sDelayCallbackWheelStatistics.ExpiredPerTickMax) {
+        sDelayCallbackWheelStatistics.ExpiredPerTickMax = tNumberOfExpired;
+    }
+    DELAY_CALLBACK_WHEEL_UNLOCK();
+    return tNumberOfExpired;
+}
+
+bool DelayCallbackWheel_hasExpired(void) {
+    return sDelayCallbackExpiredMask != 0;
+}
+
+void DelayCallbackWheel_runExpired(void) {
+    while (true) {
+        DELAY_CALLBACK_WHEEL_LOCK();
+        if (sDelayCallbackExpiredMask == 0) {
+            DELAY_CALLBACK_WHEEL_UNLOCK();
+            return;
+        }
+        uint_fast8_t tIndex = __builtin_ctz(sDelayCallbackExpiredMask); // lowest expired entry first, like the former table
+        sDelayCallbackExpiredMask &= ~(1UL << tIndex);
+        sDelayCallbackWheelStatistics.CallbacksCalled++;
+        void (*tCallback)(void) = sDelayCallbackTablePointer[tIndex];
+        DELAY_CALLBACK_WHEEL_UNLOCK();
+        tCallback();
+    }
+}
+#endif // DELAY_CALLBACK_ENTRIES_SIZE > DELAY_CALLBACK_TABLE_ENTRIES_MAX
+
+DelayCallbackWheelStatisticsTypeDef* DelayCallbackWheel_getStatistics(void) {
+#if DELAY_CALLBACK_ENTRIES_SIZE <= DELAY_CALLBACK_TABLE_ENTRIES_MAX
+    uint16_t tEntriesUsed = 0;
+    for (uint_fast8_t i = 0; i < DELAY_CALLBACK_ENTRIES_SIZE; ++i) {
+        if (!isFreeTableEntry(i)) {
+            tEntriesUsed++;
+        }
+    }
+    sDelayCallbackWheelStatistics.EntriesUsed = tEntriesUsed;
+#endif
+    return &sDelayCallbackWheelStatistics;
+}
+
+/**
+ * Keeps the number of used entries
+ */
+void DelayCallbackWheel_resetStatistics(void) {
+    uint16_t tEntriesUsed = sDelayCallbackWheelStatistics.EntriesUsed;
+    uint16_t tEntriesUsedMax = tEntriesUsed;
+#if DELAY_CALLBACK_ENTRIES_SIZE <= DELAY_CALLBACK_TABLE_ENTRIES_MAX
+    tEntriesUsedMax = sDelayCallbackWheelStatistics.EntriesUsedMax; // entries taken
+#endif
+    memset(&sDelayCallbackWheelStatistics, 0, sizeof(sDelayCallbackWheelStatistics));
+    sDelayCallbackWheelStatistics.EntriesUsed = tEntriesUsed;
+    sDelayCallbackWheelStatistics.EntriesUsedMax = tEntriesUsedMax;
+}
+
+#endif // _DELAY_CALLBACK_WHEEL_HPP
@@ -25,8 +25,8 @@
 #define _PAGE_ACCELEROMETER_COMPASS_DEMO_HPP
 
 #include "l3gdc20_lsm303dlhc_utils.h"
-#include "stm32f3DiscoPeripherals.h" // for readCompassRaw
-#include "usbd_hid.h" // for USBD_HID_SendReport
+#include "orientationFilter.h"
+#include "usbd_hid_cursor.h"
 #include "lsm303dlhc.h" // for MAG_I2C_ADDRESS
 
 #define COLOR_ACC_GYRO_BACKGROUND COLOR16_CYAN
@@ -55,10 +55,30 @@ BDButton TouchButtonAutorepeatAccScaleMinus;
 
 BDButton TouchButtonClearScreen;
 BDButton TouchButtonSetZero;
+BDButton TouchButtonCompassCalibration;
 
 static BDSlider TouchSliderRoll; // Horizontal
 static BDSlider TouchSliderPitch; // Vertical
 
+#define SENSOR_SAMPLES_PER_LOOP_MAX 32
+static SensorSampleTypeDef sSensorSamples[SENSOR_SAMPLES_PER_LOOP_MAX];
+static int16_t sCompassData[3];
+static uint32_t sSensorSamplesCount[NUMBER_OF_SENSORS]; // for rate display
+static uint32_t sMillisOfLastRateOutput;
+
+/*
+ * Orientation fusion, fed with every gyroscope sample
+ */
+static OrientationFilterTypeDef sOrientationFilter;
+static CompassCalibrationTypeDef sCompassCalibration;
+EulerAnglesTypeDef OrientationAngles; // for display and HID
+static float sLatestAccelerometerData[3]; // raw, since zero compensation removes gravity
+static int16_t sLatestCompassRaw[3];
+static uint32_t sLastGyroscopeTimestampMicros;
+static uint32_t sOrientationFilterCycles; // sum of cycles for average display
+static uint16_t sOrientationFilterUpdates;
+#define MILLIDEGREE_TO_RADIANS (PI / 180000.0f)
+
 void doChangeAccScale(BDButton *aTheTouchedButton, int16_t aValue);
 
 void doSensorChange(uint8_t aSensorType, struct SensorCallback *aSensorCallbackInfo);
@@ -67,6 +87,22 @@ void doSetZero(BDButton *aTheTouchedButton, int16_t aValue) {
     // wait for end of touch vibration
     delay(300);
     setZeroAccelerometerGyroValue();
+    OrientationFilter_init(&sOrientationFilter);
+}
+
+/*
+ * First press starts collecting min and max values, while board should be rotated in all directions, second press ends it
+ */
+void doCompassCalibration(BDButton *aTheTouchedButton, int16_t aValue) {
+    bool tIsError = false;
+    if (sCompassCalibration.IsCalibrating) {
+        tIsError = !CompassCalibration_stop(&sCompassCalibration);
+        aTheTouchedButton->setText("Calib", true);
+    } else {
+        CompassCalibration_start(&sCompassCalibration);
+        aTheTouchedButton->setText("Stop", true);
+    }
+    BDButton::playFeedbackTone(tIsError);
 }
 
 void drawAccDemoGui(void) {
@@ -79,6 +115,7 @@ void drawAccDemoGui(void) {
     BlueDisplay1.drawCircle(COMPASS_MID_X, COMPASS_MID_Y, COMPASS_RADIUS, COLOR16_BLACK, 1);
 
     TouchButtonSetZero.drawButton();
+    TouchButtonCompassCalibration.drawButton();
 
     /*
      * Vertical slider
@@ -141,9 +178,6 @@ void doClearAccelerometerCompassScreen(BDButton *aTheTouchedButton, int16_t aVal
 
 void startAccelerometerCompassPage(void) {
 
-    // TODO implement switching from CDC to HID
-    //USB_ChangeToJoystick();
-
     // 4. row
     TouchButtonAutorepeatAccScalePlus.init(BUTTON_WIDTH_6_POS_2, BUTTON_HEIGHT_4_LINE_4, BUTTON_WIDTH_6, BUTTON_HEIGHT_4,
             COLOR16_RED, "+", TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH | FLAG_BUTTON_TYPE_AUTOREPEAT, 1, &doChangeAccScale);
@@ -156,6 +190,9 @@ void startAccelerometerCompassPage(void) {
     TouchButtonSetZero.init(BUTTON_WIDTH_3_POS_2, BUTTON_HEIGHT_4_LINE_4, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR16_RED, "Zero",
             TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH, 0, &doSetZero);
 
+    TouchButtonCompassCalibration.init(BUTTON_WIDTH_3_POS_2, BUTTON_HEIGHT_4_LINE_3, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR16_RED,
+            "Calib", TEXT_SIZE_22, 0, 0, &doCompassCalibration);
+
     // Clear button - lower left corner
     TouchButtonClearScreen.init(BUTTON_WIDTH_3_POS_3, BUTTON_HEIGHT_4_LINE_4, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR16_RED, "Clear",
             TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH, BACKGROUND_COLOR, &doClearAccelerometerCompassScreen);
@@ -167,46 +204,152 @@ void startAccelerometerCompassPage(void) {
     sMillisSinceLastInfoOutput = 0;
 
     SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_8);
+    OrientationFilter_init(&sOrientationFilter);
+    CompassCalibration_init(&sCompassCalibration);
+    enableCycleCounter();
+    sLastGyroscopeTimestampMicros = 0;
+    startSensorAcquisition();
+    sMillisOfLastRateOutput = millis();
+    HID_Cursor_start();
 
 //    registerSensorChangeCallback(TYPE_ACCELEROMETER, SENSOR_DELAY_NORMAL, &doSensorChange);
 //    BlueDisplay1.setScreenOrientationLock(true);
 }
 
+/*
+ * Cursor speed depends on the tilt of the board.
+ * Only the velocity is set here, the reports are sent by the 1 ms USB SOF interrupt.
+ */
 void sendCursorMovementOverUSB() {
-    uint8_t HID_Buffer[4] = { 0 };
-    if (isUSBReady()) {
-        HID_Buffer[1] = 0;
-        HID_Buffer[2] = 0;
-        /* RIGHT + LEFT (negative values) Direction */
-        if ((AccelerometerCompassRawDataBuffer[0] / (2 * sAccelerationScale)) != 0) {
-            HID_Buffer[1] = AccelerometerCompassRawDataBuffer[0] / (2 * sAccelerationScale);
-        }
-        /* UP + DOWN (negative values) Direction */
-        if ((AccelerometerCompassRawDataBuffer[1] / (2 * sAccelerationScale)) != 0) {
-            HID_Buffer[2] = AccelerometerCompassRawDataBuffer[1] / (2 * sAccelerationScale);
+    /* RIGHT + LEFT (negative values) Direction is Pitch, UP + DOWN (negative values) Direction is Roll */
+    HID_Cursor_setTilt(OrientationAngles.Pitch * 10, OrientationAngles.Roll * 10, sAccelerationScale);
+}
+
+void printHIDCursorStatistics(void) {
+    uint32_t tAverageLatency = 0;
+    if (HIDCursorStatistics.Reports > 0) {
+        tAverageLatency = HIDCursorStatistics.LatencyMicrosSum / HIDCursorStatistics.Reports;
+    }
+    snprintf(sStringBuffer, sizeof sStringBuffer, "HID n=%lu def=%lu clip=%lu lat=%lu/%lu us",
+            HIDCursorStatistics.Reports, HIDCursorStatistics.DeferredReports, HIDCursorStatistics.ClippedPixels, tAverageLatency,
+            HIDCursorStatistics.LatencyMicrosMaximum);
+    BlueDisplay1.drawText(TEXT_START_X, 5 * TEXT_SIZE_11_HEIGHT + TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK,
+            COLOR16_GREEN);
+}
+
+/*
+ * Gyroscope and accelerometer axes of the board have the same orientation
+ */
+void updateOrientation(uint32_t aGyroscopeTimestampMicros, float *aGyroscopeMillidegreePerSecond) {
+    float tDeltaSeconds = GYROSCOPE_SAMPLE_PERIOD_MICROS / 1000000.0f;
+    if (sLastGyroscopeTimestampMicros != 0) {
+        tDeltaSeconds = (aGyroscopeTimestampMicros - sLastGyroscopeTimestampMicros) / 1000000.0f;
+    }
+    sLastGyroscopeTimestampMicros = aGyroscopeTimestampMicros;
+
+    float tGyroscopeRadiansPerSecond[3];
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        tGyroscopeRadiansPerSecond[i] = aGyroscopeMillidegreePerSecond[i] * MILLIDEGREE_TO_RADIANS;
+    }
+    float tCompassCalibrated[3];
+    CompassCalibration_apply(&sCompassCalibration, sLatestCompassRaw, tCompassCalibrated);
+
+    uint32_t tStartCycles = getCycleCounter();
+    OrientationFilter_update(&sOrientationFilter, tGyroscopeRadiansPerSecond, sLatestAccelerometerData, tCompassCalibrated,
+            tDeltaSeconds);
+    sOrientationFilterCycles += getCycleCounter() - tStartCycles;
+    sOrientationFilterUpdates++;
+}
+
+/**
+ * Consumes all samples acquired since last call.
+ * Accelerometer and gyroscope values are averaged, compass value is the latest one.
+ * @return true if new values available
+ */
+bool consumeSensorSamples(void) {
+    int32_t tAccelerometerSum[3] = { 0, 0, 0 };
+    float tGyroscopeSum[3] = { 0, 0, 0 };
+    uint16_t tAccelerometerCount = 0;
+    uint16_t tGyroscopeCount = 0;
+    int16_t tAccelerometerData[3];
+    float tGyroscopeData[3];
+
+    uint16_t tCount;
+    do {
+        tCount = SensorAcquisition_getSamples(sSensorSamples, SENSOR_SAMPLES_PER_LOOP_MAX);
+        for (uint_fast16_t i = 0; i < tCount; ++i) {
+            SensorSampleTypeDef *tSample = &sSensorSamples[i];
+            sSensorSamplesCount[tSample->Sensor]++;
+            if (tSample->Sensor == SENSOR_ACCELEROMETER) {
+                convertAccelerometerSampleZeroCompensated(tSample, tAccelerometerData);
+                for (uint_fast8_t j = 0; j < 3; ++j) {
+                    tAccelerometerSum[j] += tAccelerometerData[j];
+                }
+                tAccelerometerCount++;
+                for (uint_fast8_t j = 0; j < 3; ++j) {
+                    sLatestAccelerometerData[j] = tSample->Values[j];
+                }
+            } else if (tSample->Sensor == SENSOR_GYROSCOPE) {
+                convertGyroscopeSampleZeroCompensated(tSample, tGyroscopeData);
+                for (uint_fast8_t j = 0; j < 3; ++j) {
+                    tGyroscopeSum[j] += tGyroscopeData[j];
+                }
+                tGyroscopeCount++;
+                updateOrientation(tSample->TimestampMicros, tGyroscopeData);
+            } else {
+                convertCompassSample(tSample, sCompassData);
+                for (uint_fast8_t j = 0; j < 3; ++j) {
+                    sLatestCompassRaw[j] = tSample->Values[j];
+                }
+                CompassCalibration_addSample(&sCompassCalibration, sLatestCompassRaw);
+            }
         }
+    } while (tCount == SENSOR_SAMPLES_PER_LOOP_MAX);
 
-        /* Update the cursor position */
-        if ((HID_Buffer[1] != 0) || (HID_Buffer[2] != 0)) {
-            USBD_HID_SendReport(&USBDDeviceHandle, HID_Buffer, 4);
-            delay(50);
+    if (tAccelerometerCount == 0 || tGyroscopeCount == 0) {
+        return false;
+    }
+    for (uint_fast8_t j = 0; j < 3; ++j) {
+        AccelerometerCompassRawDataBuffer[j] = tAccelerometerSum[j] / tAccelerometerCount;
+        GyroscopeRawDataBuffer[j] = tGyroscopeSum[j] / tGyroscopeCount;
+    }
+    return true;
+}
+
+/*
+ * Show sample rates once per second
+ */
+void printSensorSampleRates(void) {
+    uint32_t tMillis = millis();
+    uint32_t tDeltaMillis = tMillis - sMillisOfLastRateOutput;
+    if (tDeltaMillis >= 1000) {
+        sMillisOfLastRateOutput = tMillis;
+        snprintf(sStringBuffer, sizeof sStringBuffer, "Samples/s G=%3lu A=%3lu C=%2lu lost=%lu",
+                (sSensorSamplesCount[SENSOR_GYROSCOPE] * 1000) / tDeltaMillis,
+                (sSensorSamplesCount[SENSOR_ACCELEROMETER] * 1000) / tDeltaMillis,
+                (sSensorSamplesCount[SENSOR_COMPASS] * 1000) / tDeltaMillis,
+                SensorAcquisitionStatistics.RingOverruns + SensorAcquisitionStatistics.FifoOverruns[SENSOR_GYROSCOPE]
+                        + SensorAcquisitionStatistics.FifoOverruns[SENSOR_ACCELEROMETER]);
+        BlueDisplay1.drawText(TEXT_START_X, 4 * TEXT_SIZE_11_HEIGHT + TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK,
+                COLOR16_GREEN);
+        for (uint_fast8_t i = 0; i < NUMBER_OF_SENSORS; ++i) {
+            sSensorSamplesCount[i] = 0;
         }
+        printHIDCursorStatistics();
     }
 }
 
 void loopAccelerometerGyroCompassPage(void) {
 
-    /* Wait 50 ms for data ready */
     uint32_t tMillis = millis();
     sMillisSinceLastInfoOutput += tMillis - sMillisOfLastLoop;
     sMillisOfLastLoop = tMillis;
-    if (sMillisSinceLastInfoOutput > 50) {
+    if (sMillisSinceLastInfoOutput > 50 && consumeSensorSamples()) {
         sMillisSinceLastInfoOutput = 0;
+        OrientationFilter_getEulerAngles(&sOrientationFilter, &OrientationAngles);
         /**
          * Accelerometer data
          */
-
-        readAccelerometerZeroCompensated(&AccelerometerCompassRawDataBuffer[0]);
         snprintf(sStringBuffer, sizeof sStringBuffer, "Accelerometer X=%5d Y=%5d Z=%5d", AccelerometerCompassRawDataBuffer[0],
                 AccelerometerCompassRawDataBuffer[1], AccelerometerCompassRawDataBuffer[2]);
         BlueDisplay1.drawText(TEXT_START_X, TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK, COLOR16_GREEN);
@@ -221,45 +364,58 @@ void loopAccelerometerGyroCompassPage(void) {
         /**
          * Compass data
          */
-        readCompassRaw(&AccelerometerCompassRawDataBuffer[0]);
-        snprintf(sStringBuffer, sizeof sStringBuffer, "Compass X=%5d Y=%5d Z=%5d", AccelerometerCompassRawDataBuffer[0],
-                AccelerometerCompassRawDataBuffer[1], AccelerometerCompassRawDataBuffer[2]);
+        snprintf(sStringBuffer, sizeof sStringBuffer, "Compass X=%5d Y=%5d Z=%5d", sCompassData[0], sCompassData[1],
+                sCompassData[2]);
         BlueDisplay1.drawText(TEXT_START_X, TEXT_SIZE_11_HEIGHT + TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK,
                 COLOR16_GREEN);
         // values can reach 800
-        BlueDisplay1.refreshVector(&CompassLine, (AccelerometerCompassRawDataBuffer[0] >> 5),
-                -(AccelerometerCompassRawDataBuffer[2] >> 5));
+        BlueDisplay1.refreshVector(&CompassLine, (sCompassData[0] >> 5), -(sCompassData[1] >> 5));
         BlueDisplay1.drawPixel(CompassLine.StartX, CompassLine.StartY, COLOR16_RED);
 
         /**
          * Gyroscope data
          */
-        readGyroscopeZeroCompensated(&GyroscopeRawDataBuffer[0]);
         snprintf(sStringBuffer, sizeof sStringBuffer, "Gyroscope R=%7.1f P=%7.1f Y=%7.1f", GyroscopeRawDataBuffer[0],
                 GyroscopeRawDataBuffer[1], GyroscopeRawDataBuffer[2]);
         BlueDisplay1.drawText(TEXT_START_X, 2 * TEXT_SIZE_11_HEIGHT + TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK,
                 COLOR16_GREEN);
 
-        TouchSliderRoll.setValueAndDrawBar(
-                ((int16_t) (GyroscopeRawDataBuffer[0] / (sAccelerationScale / 4))) + HORIZONTAL_SLIDER_NULL_VALUE);
-        TouchSliderPitch.setValueAndDrawBar(
-                ((int16_t) (GyroscopeRawDataBuffer[1] / (sAccelerationScale / 4))) + VERTICAL_SLIDER_NULL_VALUE);
+        /**
+         * Fused orientation
+         */
+        uint32_t tAverageCycles = 0;
+        if (sOrientationFilterUpdates > 0) {
+            tAverageCycles = sOrientationFilterCycles / sOrientationFilterUpdates;
+        }
+        sOrientationFilterCycles = 0;
+        sOrientationFilterUpdates = 0;
+        snprintf(sStringBuffer, sizeof sStringBuffer, "Roll=%6.1f Pitch=%6.1f Yaw=%6.1f %4lu cycles%c", OrientationAngles.Roll,
+                OrientationAngles.Pitch, OrientationAngles.Yaw, tAverageCycles, (sCompassCalibration.IsValid ? ' ' : '*'));
+        BlueDisplay1.drawText(TEXT_START_X, 3 * TEXT_SIZE_11_HEIGHT + TEXT_START_Y, sStringBuffer, TEXT_SIZE_11, COLOR16_BLACK,
+                COLOR16_GREEN);
+
+        TouchSliderRoll.setValueAndDrawBar(((int16_t) OrientationAngles.Roll) + HORIZONTAL_SLIDER_NULL_VALUE);
+        TouchSliderPitch.setValueAndDrawBar(((int16_t) OrientationAngles.Pitch) + VERTICAL_SLIDER_NULL_VALUE);
 
-        BlueDisplay1.refreshVector(&GyroYawLine, -(int16_t) (GyroscopeRawDataBuffer[2] / (2 * sAccelerationScale)),
-                -(2 * COMPASS_RADIUS));
+        float tYawRadians = OrientationAngles.Yaw * (PI / 180.0f);
+        BlueDisplay1.refreshVector(&GyroYawLine, (int16_t) (sinf(tYawRadians) * (2 * COMPASS_RADIUS)),
+                -(int16_t) (cosf(tYawRadians) * (2 * COMPASS_RADIUS)));
         BlueDisplay1.drawPixel(GyroYawLine.StartX, GyroYawLine.StartY, COLOR16_RED);
+
+        printSensorSampleRates();
     }
     checkAndHandleEvents();
 }
 
 void stopAccelerometerCompassPage(void) {
+    HID_Cursor_stop();
+    stopSensorAcquisition();
 //    registerSensorChangeCallback(TYPE_ACCELEROMETER, SENSOR_DELAY_NORMAL, NULL);
 //    BlueDisplay1.setScreenOrientationLock(false);
 
-    USBD_Stop (&USBDDeviceHandle);
-
 #if defined(SUPPORT_LOCAL_DISPLAY)
     TouchButtonSetZero.deinit();
+    TouchButtonCompassCalibration.deinit();
     TouchButtonClearScreen.deinit();
     TouchButtonAutorepeatAccScalePlus.deinit();
     TouchButtonAutorepeatAccScaleMinus.deinit();
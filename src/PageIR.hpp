@@ -32,6 +32,7 @@
 extern "C" {
 #include "irmp.h"
 #include "irsnd.h"
+#include "Profiler.h"
 #include "stm32f3_discovery.h"  /* For LEDx */
 }
 
@@ -182,6 +183,8 @@ void doVelocitySlider(BDSlider *aTheTouchedSlider, uint16_t aValue) {
  *---------------------------------------------------------------------------------------------------------------------------------------------------
  */
 extern "C" void TIM1_BRK_TIM15_IRQHandler(void) {
+    // TIM15 runs with HCLK and without prescaler and requests the interrupt at counter value 0
+    PROFILER_ISR_ENTER(PROFILER_ISR_TIM15, TIM15Handle.Instance->CNT);
 // if irsnd_ISR not busy call irmp ISR
     if (!irsnd_ISR()) {
         irmp_ISR();
@@ -189,6 +192,7 @@ extern "C" void TIM1_BRK_TIM15_IRQHandler(void) {
 
     BSP_LED_Toggle(LED_GREEN_2); // GREEN RIGHT
     __HAL_TIM_CLEAR_FLAG(&TIM15Handle, TIM_IT_UPDATE);
+    PROFILER_ISR_EXIT(PROFILER_ISR_TIM15);
 }
 
 void drawIRPage(void) {
@@ -28,9 +28,12 @@
 #define _PAGE_INFO_HPP
 
 #include <locale.h> // for localeconv
+#include "DelayCallbackWheel.h"
+#include "Profiler.h"
 
 extern "C" {
 #include "diskio.h"
+#include "imageWriter.h"
 #include "usbd_misc.h"
 }
 
@@ -112,7 +115,7 @@ void printSystemInfo() {
 
     // Priorities
 #ifdef STM32F30X
-    printf("Prios: ADC=%ld UART3=%ld WWDG=%ld User=%ld\n", NVIC_GetPriority(ADC1_2_IRQn), NVIC_GetPriority(USART3_IRQn),
+    printf("Prios: ADC=%ld UART4=%ld WWDG=%ld User=%ld\n", NVIC_GetPriority(ADC1_2_IRQn), NVIC_GetPriority(UART4_IRQn),
             NVIC_GetPriority(WWDG_IRQn), NVIC_GetPriority(EXTI0_IRQn));
     printf("SysTic=%ld USB=%ld Touch=%ld DMA1=%ld\n", NVIC_GetPriority(SysTick_IRQn), NVIC_GetPriority(USB_LP_CAN_RX0_IRQn),
             NVIC_GetPriority(EXTI1_IRQn), NVIC_GetPriority(DMA1_Channel1_IRQn));
@@ -123,6 +126,17 @@ void printSystemInfo() {
             NVIC_GetPriority(DMA1_Channel1_IRQn));
 #endif
 
+    // SysTick duration is recorded by the profiler while it runs, see Profiler button
+    DelayCallbackWheelStatisticsTypeDef *tDelayCallbackStatistics = DelayCallbackWheel_getStatistics();
+#if defined(USE_PROFILER)
+    const ProfilerIsrStatisticsStruct *tSysticStatistics = Profiler_getIsrStatistics(PROFILER_ISR_SYSTICK);
+    printf("SysTic count=%lu max=%lu cycles callbacks=%u/%u\n", (unsigned long) tSysticStatistics->Count,
+            (unsigned long) tSysticStatistics->DurationMax, tDelayCallbackStatistics->EntriesUsed,
+            tDelayCallbackStatistics->EntriesUsedMax);
+#else
+    printf("SysTic callbacks=%u/%u\n", tDelayCallbackStatistics->EntriesUsed, tDelayCallbackStatistics->EntriesUsedMax);
+#endif
+
     // Compile time
     printf("Compiled at: %s %s\n", __DATE__, __TIME__);
 
@@ -222,16 +236,26 @@ void pickColorPeriodicCallbackHandler(struct TouchEvent *const aActualPositionPt
 BDButton TouchButtonInfoMMC;
 BDButton TouchButtonInfoUSB;
 BDButton TouchButtonSystemInfo; // another button for showing systemInfoPage
+BDButton TouchButtonInfoProfiler;
 
-#define INFO_BUTTONS_NUMBER_TO_DISPLAY 6 // Number of buttons on main info page, without back button
+#define INFO_BUTTONS_NUMBER_TO_DISPLAY 7 // Number of buttons on main info page, without back button
 BDButton *const TouchButtonsInfoPage[] = { &TouchButtonInfoFont1, &TouchButtonInfoFont2, &TouchButtonInfoColors,
-        &TouchButtonInfoMMC, &TouchButtonSystemInfo, &TouchButtonInfoUSB, &TouchButtonBack, &TouchButtonSettingsGamma1,
-        &TouchButtonSettingsGamma2 };
+        &TouchButtonInfoMMC, &TouchButtonSystemInfo, &TouchButtonInfoUSB, &TouchButtonInfoProfiler, &TouchButtonBack,
+        &TouchButtonSettingsGamma1, &TouchButtonSettingsGamma2 };
 
 /* Private function prototypes -----------------------------------------------*/
 
 void drawInfoPage(void);
 
+#if defined(USE_PROFILER)
+/*
+ * Sends only to the remote display, since the local display would scroll for each line
+ */
+static void writeProfilerDumpLine(const char *aString, uint8_t aLength) {
+    sendUSARTArgsAndByteBuffer(FUNCTION_WRITE_STRING, 0, aLength, (uint8_t*) aString);
+}
+#endif
+
 void doInfoButtons(BDButton *aTheTouchedButton, int16_t aValue) {
     BlueDisplay1.clearDisplay(BACKGROUND_COLOR);
     BDButton::deactivateAll();
@@ -306,6 +330,16 @@ void doInfoButtons(BDButton *aTheTouchedButton, int16_t aValue) {
                         BACKGROUND_COLOR);
             }
         }
+        /*
+         * Phase timing of last screenshot
+         */
+        const ImageWriterStatisticsTypeDef *tScreenshotStatistics = ImageWriter_getStatistics();
+        if (tScreenshotStatistics->TotalMicros != 0) {
+            snprintf(sStringBuffer, sizeof sStringBuffer, "Screenshot %lukB %lums read %lums write %lums",
+                    tScreenshotStatistics->FileSize / 1024, tScreenshotStatistics->TotalMicros / 1000,
+                    tScreenshotStatistics->ReadMicros / 1000, tScreenshotStatistics->WriteMicros / 1000);
+            BlueDisplay1.drawText(0, 30 + 9 * TEXT_SIZE_11_HEIGHT, sStringBuffer, TEXT_SIZE_11, COLOR16_BLUE, BACKGROUND_COLOR);
+        }
         // was overwritten by MLText
         TouchButtonBack.drawButton();
 
@@ -340,6 +374,32 @@ void doInfoButtons(BDButton *aTheTouchedButton, int16_t aValue) {
             loopSystemInfoPage();
         } while (!sBackButtonPressed);
         stopSystemInfoPage();
+
+    } else if (aTheTouchedButton->mButtonHandle == TouchButtonInfoProfiler.mButtonHandle) {
+        /*
+         * First touch starts the profiler. Next touch stops it, shows the ISR statistics
+         * and dumps trace and statistics to the remote display for extras/ProfilerDecoder.cpp
+         */
+#if defined(USE_PROFILER)
+        uint16_t tYPos = BUTTON_HEIGHT_4_LINE_2 + TEXT_SIZE_11_ASCEND;
+        if (!Profiler_isRunning()) {
+            Profiler_start();
+            BlueDisplay1.drawText(10, tYPos, "Profiler started, touch again to stop", TEXT_SIZE_11, COLOR16_RED,
+                    BACKGROUND_COLOR);
+        } else {
+            Profiler_stop();
+            BlueDisplay1.drawText(10, tYPos, "ISR count max cycles max latency", TEXT_SIZE_11, COLOR16_RED, BACKGROUND_COLOR);
+            for (uint_fast8_t i = 0; i < PROFILER_NUMBER_OF_ISRS; ++i) {
+                tYPos += TEXT_SIZE_11_HEIGHT;
+                const ProfilerIsrStatisticsStruct *tStatistics = Profiler_getIsrStatistics(i);
+                snprintf(sStringBuffer, sizeof sStringBuffer, "%-7s %6lu %6lu %6lu", Profiler_getName(i),
+                        (unsigned long) tStatistics->Count, (unsigned long) tStatistics->DurationMax,
+                        (unsigned long) tStatistics->LatencyMax);
+                BlueDisplay1.drawText(10, tYPos, sStringBuffer, TEXT_SIZE_11, COLOR16_BLUE, BACKGROUND_COLOR);
+            }
+            Profiler_dump(&writeProfilerDumpLine);
+        }
+#endif
     }
 }
 
@@ -423,6 +483,9 @@ void startInfoPage(void) {
     TouchButtonInfoUSB.init(0, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR16_GREEN, "USB\nInfos", TEXT_SIZE_22,
             FLAG_BUTTON_DO_BEEP_ON_TOUCH, 0, &doInfoButtons);
 
+    TouchButtonInfoProfiler.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR16_GREEN, "Profiler",
+            TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH, 0, &doInfoButtons);
+
 // 4. row
     tPosY += BUTTON_HEIGHT_4_LINE_2;
 
@@ -69,11 +69,17 @@ void doTPCalibration(BDButton *aTheTouchedButton, int16_t aValue);
 BDButton TouchButtonTogglePrintMode;
 BDButton TouchButtonToggleTouchXYDisplay;
 BDButton TouchButtonSetDate;
+#if defined(BD_SUPPORT_USB_CDC)
+BDButton TouchButtonToggleBDTransport;
+#endif
 
 // for misc testing purposes
 
 void doTogglePrintEnable(BDButton *aTheTouchedButton, int16_t aValue);
 void doToggleTouchXYDisplay(BDButton *aTheTouchedButton, int16_t aValue);
+#if defined(BD_SUPPORT_USB_CDC)
+void doToggleBDTransport(BDButton *aTheTouchedButton, int16_t aValue);
+#endif
 
 BDButton TouchButtonAutorepeatDate_Plus;
 BDButton TouchButtonAutorepeatDate_Minus;
@@ -105,6 +111,9 @@ void drawSettingsPage(void) {
 #endif
     TouchButtonTogglePrintMode.drawButton();
     TouchButtonToggleTouchXYDisplay.drawButton();
+#if defined(BD_SUPPORT_USB_CDC)
+    TouchButtonToggleBDTransport.drawButton();
+#endif
     TouchButtonMainHome.drawButton();
 }
 
@@ -120,6 +129,11 @@ void startSettingsPage(void) {
     TouchButtonToggleTouchXYDisplay.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, 0, "Touch\nX Y",
             TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH | FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN, isDisplayXYValuesEnabled(),
             &doToggleTouchXYDisplay);
+#endif
+#if defined(BD_SUPPORT_USB_CDC)
+    TouchButtonToggleBDTransport.init(BUTTON_WIDTH_3_POS_3, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, 0, "BD over\nUSB",
+            TEXT_SIZE_22, FLAG_BUTTON_DO_BEEP_ON_TOUCH | FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN,
+            getBDTransport() == BD_TRANSPORT_USB_CDC, &doToggleBDTransport);
 #endif
     //2. row
     tPosY += BUTTON_HEIGHT_4_LINE_2;
@@ -149,6 +163,9 @@ void stopSettingsPage(void) {
     TouchButtonTPCalibration.deinit();
     TouchButtonTogglePrintMode.deinit();
     TouchButtonToggleTouchXYDisplay.deinit();
+#  if defined(BD_SUPPORT_USB_CDC)
+    TouchButtonToggleBDTransport.deinit();
+#  endif
     deinitClockSettingElements();
 #endif
 }
@@ -162,6 +179,22 @@ void doToggleTouchXYDisplay(BDButton *aTheTouchedButton, int16_t aValue) {
     setDisplayXYValuesFlag(aValue);
 }
 
+#if defined(BD_SUPPORT_USB_CDC)
+/**
+ * Switch BlueDisplay communication between Bluetooth USART and USB CDC.
+ * The remote BlueDisplay app must then (re)connect using the new transport.
+ * The CDC interface of the composite USB device is always present, so no re-enumeration is required.
+ * @param aValue assume as boolean here
+ */
+void doToggleBDTransport(BDButton *aTheTouchedButton, int16_t aValue) {
+    if (aValue) {
+        setBDTransport(BD_TRANSPORT_USB_CDC);
+    } else {
+        setBDTransport(BD_TRANSPORT_UART);
+    }
+}
+#endif
+
 /*************************************************************
  * RTC and clock setting stuff
  *************************************************************/
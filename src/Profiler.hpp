@@ -0,0 +1,224 @@
+/*
+ * @file Profiler.hpp
+ *
+ * Implementation of the cycle counter profiler, see Profiler.h.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef _PROFILER_HPP
+#define _PROFILER_HPP
+
+#include "Profiler.h"
+#include <stdio.h>  // for snprintf
+#include <string.h> // for memset
+
+#if defined(USE_PROFILER)
+#if !defined(PROFILER_GET_CYCLES)
+#include "timing.h" // for getCycleCounter()
+#define PROFILER_GET_CYCLES()   getCycleCounter()
+#endif
+
+static volatile bool sProfilerIsRunning;
+static ProfilerTraceRecordStruct sProfilerTrace[PROFILER_TRACE_SIZE];
+static uint32_t sProfilerTraceIndex; // index of next record to write, not wrapped around
+static ProfilerIsrStatisticsStruct sProfilerIsrStatistics[PROFILER_NUMBER_OF_ISRS];
+
+static const char *const sProfilerNames[PROFILER_NUMBER_OF_IDS] = { "ADC_DMA", "SPI_DMA", "ADC", "SysTick", "TIM15", "USART",
+        "PendSV", "DelayCallbacks", "DSOLoop", "DSODraw" };
+
+#define PROFILER_SEQUENCE(aIndex)   ((uint16_t) (((aIndex) & 0x7FFF) | 0x8000))
+
+/*
+ * Cycles are taken after the record is reserved, so records of an ISR, which interrupts this function,
+ * have higher indexes, but may have lower cycles. The decoder sorts by cycles.
+ * @return cycles of the record
+ */
+static uint32_t putProfilerTraceRecord(uint8_t aId, uint8_t aType) {
+    uint32_t tIndex = __atomic_fetch_add(&sProfilerTraceIndex, 1, __ATOMIC_RELAXED);
+    ProfilerTraceRecordStruct *tRecord = &sProfilerTrace[tIndex & (PROFILER_TRACE_SIZE - 1)];
+    __atomic_store_n(&tRecord->Sequence, 0, __ATOMIC_RELAXED);
+    uint32_t tCycles = PROFILER_GET_CYCLES();
+    tRecord->Cycles = tCycles;
+    tRecord->Id = aId;
+    tRecord->Type = aType;
+    __atomic_store_n(&tRecord->Sequence, PROFILER_SEQUENCE(tIndex), __ATOMIC_RELEASE);
+    return tCycles;
+}
+
+static uint_fast8_t getProfilerHistogramBucket(uint32_t aCycles) {
+    if (aCycles < 16) {
+        return 0;
+    }
+    // 16 to 31 cycles give 27 leading zeros and bucket 1
+    uint_fast8_t tBucket = 28 - __builtin_clz(aCycles);
+    if (tBucket >= PROFILER_HISTOGRAM_BUCKETS) {
+        tBucket = PROFILER_HISTOGRAM_BUCKETS - 1;
+    }
+    return tBucket;
+}
+
+static void addToProfilerHistogram(uint16_t *aHistogram, uint32_t aCycles) {
+    uint16_t *tCountPointer = &aHistogram[getProfilerHistogramBucket(aCycles)];
+    if (*tCountPointer != 0xFFFF) {
+        (*tCountPointer)++;
+    }
+}
+
+/**
+ * Clears trace and statistics and starts recording
+ */
+void Profiler_start(void) {
+    sProfilerIsRunning = false;
+    memset(sProfilerTrace, 0, sizeof(sProfilerTrace));
+    memset(sProfilerIsrStatistics, 0, sizeof(sProfilerIsrStatistics));
+    sProfilerTraceIndex = 0;
+    sProfilerIsRunning = true;
+}
+
+/**
+ * Stops recording, trace and statistics are kept for dump
+ */
+void Profiler_stop(void) {
+    sProfilerIsRunning = false;
+}
+
+bool Profiler_isRunning(void) {
+    return sProfilerIsRunning;
+}
+
+/**
+ * @param aLatencyCycles cycles from interrupt request to this call or PROFILER_LATENCY_UNKNOWN
+ * @return start cycles for Profiler_isrExit(), 0 if not running
+ */
+uint32_t Profiler_isrEnter(uint8_t aIsr, uint32_t aLatencyCycles) {
+    if (!sProfilerIsRunning) {
+        return 0;
+    }
+    if (aLatencyCycles != PROFILER_LATENCY_UNKNOWN) {
+        ProfilerIsrStatisticsStruct *tStatistics = &sProfilerIsrStatistics[aIsr];
+        addToProfilerHistogram(tStatistics->LatencyHistogram, aLatencyCycles);
+        if (aLatencyCycles > tStatistics->LatencyMax) {
+            tStatistics->LatencyMax = aLatencyCycles;
+        }
+    }
+    uint32_t tStartCycles = putProfilerTraceRecord(aIsr, PROFILER_TRACE_BEGIN);
+    // 0 is reserved for "not running"
+    return (tStartCycles == 0) ? 1 : tStartCycles;
+}
+
+/**
+ * An ISR can only be interrupted by other ISRs, so the statistics of one ISR are written by one context only
+ */
+void Profiler_isrExit(uint8_t aIsr, uint32_t aStartCycles) {
+    if (!sProfilerIsRunning || aStartCycles == 0) {
+        return;
+    }
+    uint32_t tDuration = putProfilerTraceRecord(aIsr, PROFILER_TRACE_END) - aStartCycles;
+    ProfilerIsrStatisticsStruct *tStatistics = &sProfilerIsrStatistics[aIsr];
+    tStatistics->Count++;
+    addToProfilerHistogram(tStatistics->DurationHistogram, tDuration);
+    if (tDuration > tStatistics->DurationMax) {
+        tStatistics->DurationMax = tDuration;
+    }
+}
+
+void Profiler_zoneBegin(uint8_t aId) {
+    if (sProfilerIsRunning) {
+        putProfilerTraceRecord(aId, PROFILER_TRACE_BEGIN);
+    }
+}
+
+void Profiler_zoneEnd(uint8_t aId) {
+    if (sProfilerIsRunning) {
+        putProfilerTraceRecord(aId, PROFILER_TRACE_END);
+    }
+}
+
+const char* Profiler_getName(uint8_t aId) {
+    if (aId >= PROFILER_NUMBER_OF_IDS) {
+        return "?";
+    }
+    return sProfilerNames[aId];
+}
+
+const ProfilerIsrStatisticsStruct* Profiler_getIsrStatistics(uint8_t aIsr) {
+    return &sProfilerIsrStatistics[aIsr];
+}
+
+/**
+ * @return number of records written since start, including the ones overwritten
+ */
+uint32_t Profiler_getNumberOfTraceRecords(void) {
+    return sProfilerTraceIndex;
+}
+
+static void writeProfilerHistogram(void (*aWriteFunction)(const char *aString, uint8_t aLength), char aType, uint8_t aIsr,
+        const uint16_t *aHistogram) {
+    char tLine[PROFILER_HISTOGRAM_BUCKETS * 6 + 8];
+    int tLength = snprintf(tLine, sizeof(tLine), "%c %u", aType, aIsr);
+    for (uint_fast8_t i = 0; i < PROFILER_HISTOGRAM_BUCKETS; ++i) {
+        tLength += snprintf(&tLine[tLength], sizeof(tLine) - tLength, " %u", aHistogram[i]);
+    }
+    tLine[tLength++] = '\n';
+    aWriteFunction(tLine, tLength);
+}
+
+/**
+ * Writes one line for each name, valid trace record and ISR statistics. Should be called after Profiler_stop().
+ * Format:
+ * "N <id> <name>"
+ * "T <cycles hex> <B or E> <id>" in the order of writing
+ * "S <isr> <count> <max duration> <max latency>" max latency is 0 if unknown
+ * "D <isr> <16 counts of duration histogram>"
+ * "L <isr> <16 counts of latency histogram>"
+ * "X <records lost>" last line
+ */
+void Profiler_dump(void (*aWriteFunction)(const char *aString, uint8_t aLength)) {
+    char tLine[40];
+    int tLength;
+    for (uint_fast8_t i = 0; i < PROFILER_NUMBER_OF_IDS; ++i) {
+        tLength = snprintf(tLine, sizeof(tLine), "N %u %s\n", i, sProfilerNames[i]);
+        aWriteFunction(tLine, tLength);
+    }
+
+    uint32_t tEndIndex = sProfilerTraceIndex;
+    uint32_t tStartIndex = 0;
+    if (tEndIndex > PROFILER_TRACE_SIZE) {
+        tStartIndex = tEndIndex - PROFILER_TRACE_SIZE;
+    }
+    uint32_t tRecordsLost = tStartIndex;
+    for (uint32_t tIndex = tStartIndex; tIndex != tEndIndex; ++tIndex) {
+        ProfilerTraceRecordStruct tRecord = sProfilerTrace[tIndex & (PROFILER_TRACE_SIZE - 1)];
+        if (tRecord.Sequence != PROFILER_SEQUENCE(tIndex)) {
+            // overwritten or written just now
+            tRecordsLost++;
+            continue;
+        }
+        tLength = snprintf(tLine, sizeof(tLine), "T %08lX %c %u\n", (unsigned long) tRecord.Cycles,
+                (tRecord.Type == PROFILER_TRACE_BEGIN) ? 'B' : 'E', tRecord.Id);
+        aWriteFunction(tLine, tLength);
+    }
+
+    for (uint_fast8_t i = 0; i < PROFILER_NUMBER_OF_ISRS; ++i) {
+        ProfilerIsrStatisticsStruct *tStatistics = &sProfilerIsrStatistics[i];
+        if (tStatistics->Count == 0) {
+            continue;
+        }
+        tLength = snprintf(tLine, sizeof(tLine), "S %u %lu %lu %lu\n", i, (unsigned long) tStatistics->Count,
+                (unsigned long) tStatistics->DurationMax, (unsigned long) tStatistics->LatencyMax);
+        aWriteFunction(tLine, tLength);
+        writeProfilerHistogram(aWriteFunction, 'D', i, tStatistics->DurationHistogram);
+        if (tStatistics->LatencyMax != 0) {
+            writeProfilerHistogram(aWriteFunction, 'L', i, tStatistics->LatencyHistogram);
+        }
+    }
+    tLength = snprintf(tLine, sizeof(tLine), "X %lu\n", (unsigned long) tRecordsLost);
+    aWriteFunction(tLine, tLength);
+}
+#endif // defined(USE_PROFILER)
+#endif // _PROFILER_HPP
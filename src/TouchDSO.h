@@ -276,6 +276,26 @@ struct DataBufferStruct {
 extern struct DataBufferStruct DataBufferControl;
 extern void * TempBufferForPreTriggerAdjustAndFFT;
 
+/*
+ * Recording of acquisitions to the capture file on MicroSD card.
+ * Each frame consists of this header followed by SampleCount raw values of the display window.
+ * Frames are not aligned, the file ends with zero padding.
+ */
+#define CAPTURE_FRAME_MAGIC 0xCAF1
+struct CaptureFrameHeaderStruct {
+    uint16_t Magic;
+    uint16_t SampleCount;
+    uint32_t FrameNumber; // counts all acquisitions since start of recording, so gaps indicate lost frames
+    uint32_t TimestampMicros; // end of acquisition
+    float RawToVoltFactor; // actualDSORawToVoltFactor
+    uint16_t RawDSOReadingACZero; // 0 for DC mode, otherwise to be subtracted before conversion
+    int8_t TimebaseIndex; // TimebaseEffectiveIndex
+    uint8_t ADMUXChannel;
+}; // 20 bytes
+#ifdef LOCAL_FILESYSTEM_EXISTS
+bool showCaptureFrame(int aTouchDeltaY);
+#endif
+
 /*
  * Display control
  * while running switch between upper info line on/off
@@ -58,6 +58,7 @@
 #define _TOUCH_DSO_AQUISITION_HPP
 
 #include "arm_common_tables.h" // For FFT
+#include "Profiler.h"
 
 /*****************************
  * Timebase stuff
@@ -616,6 +617,7 @@ extern "C" void DMAProcessMinMax(bool processFirstHalfOfBuffer) {
 }
 
 extern "C" void DMA1_Channel1_IRQHandler(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_ADC_DMA, PROFILER_LATENCY_UNKNOWN);
 
     // Test on DMA Transfer Complete interrupt
     if (__HAL_DMA_GET_FLAG(ADC1Handle.DMA_Handle, DMA_FLAG_TC1)) {
@@ -651,6 +653,7 @@ extern "C" void DMA1_Channel1_IRQHandler(void) {
             DMACheckForTriggerCondition();
         }
     }
+    PROFILER_ISR_EXIT(PROFILER_ISR_ADC_DMA);
 }
 
 /**
@@ -661,6 +664,7 @@ extern "C" void DMA1_Channel1_IRQHandler(void) {
  */
 
 extern "C" void ADC1_2_IRQHandler(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_ADC, PROFILER_LATENCY_UNKNOWN);
 
     uint16_t tValue;
     uint16_t tValueMin;
@@ -756,6 +760,7 @@ extern "C" void ADC1_2_IRQHandler(void) {
             if (MeasurementControl.isSingleShotMode) {
                 // No timeout in single shot mode - store (max) value for display
                 MeasurementControl.RawValueBeforeTrigger = tValue;
+                PROFILER_ISR_EXIT(PROFILER_ISR_ADC);
                 return;
             }
             /*
@@ -765,6 +770,7 @@ extern "C" void ADC1_2_IRQHandler(void) {
                 /*
                  * Trigger condition not met and timeout not reached
                  */
+                PROFILER_ISR_EXIT(PROFILER_ISR_ADC);
                 return;
             }
         }
@@ -815,6 +821,7 @@ extern "C" void ADC1_2_IRQHandler(void) {
     }
     // prepare for next
     DataBufferControl.DataBufferNextInPointer = tDataBufferPointer;
+    PROFILER_ISR_EXIT(PROFILER_ISR_ADC);
 }
 /**
  * set attenuator to infinite and AC Pin active, read n samples and store it in MeasurementControl.DSOReadingACZero
@@ -29,6 +29,7 @@
 #include "TouchDSOGui.hpp" // include sources
 #include "TouchDSODisplay.hpp" // include sources
 #include "TouchDSOAcquisition.hpp" // include sources
+#include "Profiler.h" // for PROFILER_ZONE
 #if !defined(SUPPORT_LOCAL_DISPLAY)
 #include "EventHandler.h"
 #include "utils.h" // for showRTCTimeEverySecond()
@@ -37,6 +38,8 @@
 #ifdef LOCAL_FILESYSTEM_EXISTS
 extern "C" {
 #include "ff.h"
+#include "streamLogger.h"
+#include "streamReader.h"
 }
 #endif
 
@@ -48,6 +51,8 @@ BDButton TouchButtonShowSystemInfo;
 #ifdef LOCAL_FILESYSTEM_EXISTS
 BDButton TouchButtonLoad;
 BDButton TouchButtonStore;
+BDButton TouchButtonRecord;
+BDButton TouchButtonReplay;
 #define MODE_LOAD 0
 #define MODE_STORE 1
 #endif
@@ -58,7 +63,7 @@ BDButton *const TouchButtonsDSO[] = { &TouchButtonBack, &TouchButtonStartStopDSO
         &TouchButtonSettingsPage, &TouchButtonDSOMoreSettings, &TouchButtonSingleshot, &TouchButtonSlope,
         &TouchButtonADS7846TestOnOff, &TouchButtonMinMaxMode, &TouchButtonChartHistoryOnOff,
 #ifdef LOCAL_FILESYSTEM_EXISTS
-    &TouchButtonLoad, &TouchButtonStore,
+    &TouchButtonLoad, &TouchButtonStore, &TouchButtonRecord, &TouchButtonReplay,
 #endif
         &TouchButtonFFT, &TouchButtonCalibrateVoltage, &TouchButtonAcDc, &TouchButtonShowPretriggerValuesOnOff };
 #endif
@@ -78,6 +83,12 @@ unsigned int sMillisSinceLastInfoOutput;
 
 #ifdef LOCAL_FILESYSTEM_EXISTS
 static void doStoreLoadAcquisitionData(BDButton * aTheTouchedButton, int16_t aMode);
+static void doRecordAcquisitionData(BDButton * aTheTouchedButton, int16_t aValue);
+static void recordAcquisitionData(void);
+static void stopRecording(void);
+static void printRecordingInfo(void);
+static void doReplayCaptureFile(BDButton * aTheTouchedButton, int16_t aValue);
+static void stopReplay(void);
 #endif
 void initDSOGUI(void);
 
@@ -137,6 +148,10 @@ void startDSOPage(void) {
 
 void stopDSOPage(void) {
     DSO_setAttenuator(ACTIVE_ATTENUATOR_INFINITE_VALUE);
+#ifdef LOCAL_FILESYSTEM_EXISTS
+    stopRecording();
+    stopReplay();
+#endif
     free(TempBufferForPreTriggerAdjustAndFFT);
 
 // only here
@@ -185,6 +200,7 @@ void stopDSOPage(void) {
  * main loop - 32 microseconds
  ************************************************************************/
 void loopDSOPage(void) {
+    PROFILER_ZONE(PROFILER_ZONE_DSO_LOOP);
     uint32_t tMillis, tMillisOfLoop;
     static bool sDoInfoOutput = true;
 
@@ -225,6 +241,9 @@ void loopDSOPage(void) {
                     if (DisplayControl.showInfoMode != INFO_MODE_NO_INFO) {
                         computePeriodFrequency(); // compute values only once
                         printInfo();
+#ifdef LOCAL_FILESYSTEM_EXISTS
+                        printRecordingInfo();
+#endif
                     }
                 } else if (DisplayControl.DisplayPage == DSO_PAGE_SETTINGS) {
                     // refresh buttons
@@ -256,6 +275,9 @@ void loopDSOPage(void) {
                     MeasurementControl.StopRequested = false;
                     MeasurementControl.isRunning = false;
                     MeasurementControl.isSingleShotMode = false;
+#ifdef LOCAL_FILESYSTEM_EXISTS
+                    stopRecording();
+#endif
 
                     // delayed tone for stop
 #if defined(SUPPORT_LOCAL_DISPLAY)
@@ -294,7 +316,14 @@ void loopDSOPage(void) {
                             DisplayControl.EraseColor, DRAW_MODE_REGULAR, MeasurementControl.isEffectiveMinMaxMode);
                     draw128FFTValuesFast(COLOR_FFT_DATA);
                 }
+#ifdef LOCAL_FILESYSTEM_EXISTS
+                recordAcquisitionData(); // must be done before startAcquisition() overwrites data buffer
+#endif
                 startAcquisition();
+#ifdef LOCAL_FILESYSTEM_EXISTS
+                // write to card while next acquisition is running
+                StreamLogger_service();
+#endif
             }
         }
         if (DataBufferControl.DrawWhileAcquire) {
@@ -438,6 +467,9 @@ void prepareForStart(void) {
         DisplayControl.XScale = 0;
     }
 
+#ifdef LOCAL_FILESYSTEM_EXISTS
+    stopReplay(); // restores parameters of held acquisition
+#endif
     startAcquisition();
 // must be after startAcquisition()
     MeasurementControl.isRunning = true;
@@ -579,6 +611,7 @@ void doVoltageCalibration(BDButton *aTheTouchedButton, int16_t aValue) {
 const char sDSODataFileName[] = "DSO-data.bin";
 void doStoreLoadAcquisitionData(BDButton * aTheTouchedButton, int16_t aMode) {
     int tFeedbackType = FEEDBACK_TONE_LONG_ERROR;
+    stopReplay(); // store and load use the parameters of the held acquisition
     if (!MeasurementControl.isRunning && MICROSD_isCardInserted()) {
         FIL tFile;
         FRESULT tOpenResult;
@@ -610,6 +643,207 @@ void doStoreLoadAcquisitionData(BDButton * aTheTouchedButton, int16_t aMode) {
     }
     FeedbackTone(tFeedbackType);
 }
+
+/***********************************************************************
+ * Recording of acquisitions to MicroSD card
+ ***********************************************************************/
+#define CAPTURE_FILE_PREALLOCATE_SIZE (64 * 1024 * 1024L) // around 20 minutes at 50 frames per second
+const char sDSOCaptureFileName[] = "DSO-capture.bin";
+#define CAPTURE_FRAME_SIZE (sizeof(struct CaptureFrameHeaderStruct) + (REMOTE_DISPLAY_WIDTH * sizeof(uint16_t)))
+uint32_t sCaptureFrameNumber;
+
+/*
+ * Toggle button on start page. Recording stops with the measurement.
+ */
+void doRecordAcquisitionData(BDButton * aTheTouchedButton, int16_t aValue) {
+    bool tIsError = false;
+    if (aValue) {
+        stopReplay();
+        if (MICROSD_isCardInserted() && StreamLogger_open(sDSOCaptureFileName, CAPTURE_FILE_PREALLOCATE_SIZE,
+                CAPTURE_FILE_PREALLOCATE_SIZE / CAPTURE_FRAME_SIZE) == FR_OK) {
+            sCaptureFrameNumber = 0;
+        } else {
+            tIsError = true;
+            aTheTouchedButton->setValueAndDraw(false);
+        }
+    } else {
+        tIsError = (StreamLogger_close() != FR_OK);
+    }
+#if defined(SUPPORT_LOCAL_DISPLAY) && defined(DISABLE_REMOTE_DISPLAY)
+    LocalTouchButton::playFeedbackTone(tIsError);
+#else
+    BDButton::playFeedbackTone(tIsError);
+#endif
+}
+
+/*
+ * Copies the display window of the current acquisition to the staging buffer of the stream logger.
+ * The card is written later by StreamLogger_service().
+ */
+void recordAcquisitionData(void) {
+    if (!StreamLogger_isOpen()) {
+        return;
+    }
+    struct CaptureFrameHeaderStruct tHeader;
+    tHeader.Magic = CAPTURE_FRAME_MAGIC;
+    tHeader.SampleCount = REMOTE_DISPLAY_WIDTH;
+    tHeader.FrameNumber = sCaptureFrameNumber++;
+    tHeader.TimestampMicros = micros();
+    tHeader.RawToVoltFactor = MeasurementControl.actualDSORawToVoltFactor;
+    tHeader.RawDSOReadingACZero = 0;
+    if (MeasurementControl.ChannelIsACMode) {
+        tHeader.RawDSOReadingACZero = MeasurementControl.RawDSOReadingACZero;
+    }
+    tHeader.TimebaseIndex = MeasurementControl.TimebaseEffectiveIndex;
+    tHeader.ADMUXChannel = MeasurementControl.ADMUXChannel;
+    StreamLogger_append(&tHeader, sizeof(tHeader), &DataBufferControl.DataBuffer[DATABUFFER_DISPLAY_START],
+            REMOTE_DISPLAY_WIDTH * sizeof(uint16_t));
+}
+
+void stopRecording(void) {
+    if (StreamLogger_isOpen()) {
+        StreamLogger_close();
+        TouchButtonRecord.setValue(false);
+    }
+}
+
+/*
+ * Replay of the capture file in analyze mode, switched by the toggle button on the more settings page.
+ * While replay is active, a vertical swipe on the chart page steps through the frames,
+ * a swipe over the full display height moves over the whole capture file.
+ * The index of the capture file gives direct access to each frame and the read ahead cache makes small steps cheap.
+ * Frames are read to the temporary buffer, so the held acquisition is not touched.
+ * The acquisition parameters of each frame are set for drawing and restored at the end of replay.
+ */
+#define CAPTURE_READ_RAM_BUDGET 2048
+uint32_t sPlaybackFrameNumber;
+uint32_t sPlaybackStartMicros;
+struct CaptureFrameHeaderStruct sHeldAcquisitionParameters; // of the held acquisition, restored by stopReplay()
+bool sHeldChannelIsACMode;
+int sHeldXScale;
+
+static void setAcquisitionParameters(const struct CaptureFrameHeaderStruct *aHeader, bool aChannelIsACMode) {
+    MeasurementControl.actualDSORawToVoltFactor = aHeader->RawToVoltFactor;
+    MeasurementControl.ChannelIsACMode = aChannelIsACMode;
+    MeasurementControl.RawDSOReadingACZero = aHeader->RawDSOReadingACZero;
+    MeasurementControl.TimebaseEffectiveIndex = aHeader->TimebaseIndex;
+    MeasurementControl.ADMUXChannel = aHeader->ADMUXChannel;
+}
+
+void doReplayCaptureFile(BDButton * aTheTouchedButton, int16_t aValue) {
+    bool tIsError = false;
+    if (aValue) {
+        if (MeasurementControl.isRunning || StreamLogger_isOpen() || !MICROSD_isCardInserted()
+                || StreamReader_open(sDSOCaptureFileName, CAPTURE_READ_RAM_BUDGET) != FR_OK) {
+            tIsError = true;
+            aTheTouchedButton->setValueAndDraw(false);
+        } else {
+            sHeldAcquisitionParameters.RawToVoltFactor = MeasurementControl.actualDSORawToVoltFactor;
+            sHeldAcquisitionParameters.RawDSOReadingACZero = MeasurementControl.RawDSOReadingACZero;
+            sHeldAcquisitionParameters.TimebaseIndex = MeasurementControl.TimebaseEffectiveIndex;
+            sHeldAcquisitionParameters.ADMUXChannel = MeasurementControl.ADMUXChannel;
+            sHeldChannelIsACMode = MeasurementControl.ChannelIsACMode;
+            sHeldXScale = DisplayControl.XScale;
+
+            DisplayControl.DisplayPage = DSO_PAGE_CHART;
+            redrawDisplay();
+            sPlaybackFrameNumber = 0;
+            tIsError = showCaptureFrame(0);
+        }
+    } else {
+        stopReplay();
+    }
+#if defined(SUPPORT_LOCAL_DISPLAY) && defined(DISABLE_REMOTE_DISPLAY)
+    LocalTouchButton::playFeedbackTone(tIsError);
+#else
+    BDButton::playFeedbackTone(tIsError);
+#endif
+}
+
+/*
+ * Closes the capture file and restores parameters and display of the held acquisition.
+ * Called before all actions, which use the held acquisition or start a new one.
+ */
+void stopReplay(void) {
+    if (!StreamReader_isOpen()) {
+        return;
+    }
+    StreamReader_close();
+    TouchButtonReplay.setValue(false);
+    setAcquisitionParameters(&sHeldAcquisitionParameters, sHeldChannelIsACMode);
+    DisplayControl.XScale = sHeldXScale;
+    if (DisplayControl.DisplayPage == DSO_PAGE_CHART) {
+        redrawDisplay();
+    }
+}
+
+/*
+ * @param aTouchDeltaY vertical swipe distance, 0 shows frame sPlaybackFrameNumber
+ * @return true if error
+ */
+bool showCaptureFrame(int aTouchDeltaY) {
+    if (!StreamReader_isOpen() || StreamReader_getHeader()->IndexedRecordCount == 0) {
+        return true;
+    }
+    int32_t tFrameNumber = sPlaybackFrameNumber;
+    if (aTouchDeltaY != 0) {
+        int32_t tFrameDelta = (aTouchDeltaY * (int32_t) StreamReader_getHeader()->IndexedRecordCount) / REMOTE_DISPLAY_HEIGHT;
+        if (tFrameDelta == 0) {
+            tFrameDelta = (aTouchDeltaY > 0) ? 1 : -1;
+        }
+        tFrameNumber += tFrameDelta;
+        if (tFrameNumber < 0) {
+            tFrameNumber = 0;
+        }
+    }
+    if ((uint32_t) tFrameNumber >= StreamReader_getHeader()->IndexedRecordCount) {
+        tFrameNumber = StreamReader_getHeader()->IndexedRecordCount - 1;
+    }
+
+    DWORD tOffset;
+    UINT tLength;
+    struct CaptureFrameHeaderStruct tHeader;
+    uint16_t *tFrameBuffer = (uint16_t*) TempBufferForPreTriggerAdjustAndFFT; // sizeof(float32_t) * 2 * FFT_SIZE bytes
+    if (StreamReader_getRecordPosition(tFrameNumber, &tOffset, &tLength) != FR_OK || tLength != CAPTURE_FRAME_SIZE
+            || StreamReader_read(tOffset, &tHeader, sizeof(tHeader)) != FR_OK || tHeader.Magic != CAPTURE_FRAME_MAGIC
+            || StreamReader_read(tOffset + sizeof(tHeader), tFrameBuffer, REMOTE_DISPLAY_WIDTH * sizeof(uint16_t)) != FR_OK) {
+        return true;
+    }
+    if (tFrameNumber == 0) {
+        sPlaybackStartMicros = tHeader.TimestampMicros;
+    }
+    sPlaybackFrameNumber = tFrameNumber;
+
+    // RawDSOReadingACZero is 0 for frames recorded in DC mode
+    setAcquisitionParameters(&tHeader, (tHeader.RawDSOReadingACZero != 0));
+    DisplayControl.XScale = CHART_X_AXIS_SCALE_FACTOR_1;
+    drawDataBuffer(tFrameBuffer, REMOTE_DISPLAY_WIDTH, COLOR_DATA_HOLD, DisplayControl.EraseColor, DRAW_MODE_REGULAR, false);
+
+    snprintf(sStringBuffer, sizeof sStringBuffer, "Frame %5lu/%lu %8.3fs", tHeader.FrameNumber,
+            StreamReader_getHeader()->RecordCount, (tHeader.TimestampMicros - sPlaybackStartMicros) / 1000000.0);
+    BlueDisplay1.drawText(0, FONT_SIZE_INFO_LONG_ASC, sStringBuffer, FONT_SIZE_INFO_LONG, COLOR16_RED, COLOR_INFO_BACKGROUND);
+    return false;
+}
+
+/*
+ * Sustained write rate and frame loss below the info lines
+ */
+void printRecordingInfo(void) {
+    if (!StreamLogger_isOpen()) {
+        return;
+    }
+    const StreamLoggerStatisticsTypeDef *tStatistics = StreamLogger_getStatistics();
+    // trailing F -> file is fragmented and written by f_write()
+    snprintf(sStringBuffer, sizeof sStringBuffer, "Rec %5lu lost %3lu %4lukB/s max %3lums %c", tStatistics->RecordsAppended,
+            sCaptureFrameNumber - tStatistics->RecordsAppended, StreamLogger_getBytesPerSecond() / 1024,
+            tStatistics->WriteMicrosMax / 1000, tStatistics->IsContiguous ? ' ' : 'F');
+    uint16_t tPosY = FONT_SIZE_INFO_SHORT;
+    if (DisplayControl.showInfoMode == INFO_MODE_LONG_INFO) {
+        tPosY = 3 * FONT_SIZE_INFO_LONG;
+    }
+    BlueDisplay1.drawText(0, tPosY + FONT_SIZE_INFO_LONG_ASC, sStringBuffer, FONT_SIZE_INFO_LONG, COLOR16_RED,
+            COLOR_INFO_BACKGROUND);
+}
 #endif
 
 /*
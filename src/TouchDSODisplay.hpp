@@ -25,6 +25,8 @@
 #ifndef _TOUCH_DSO_DISPLAY_HPP
 #define _TOUCH_DSO_DISPLAY_HPP
 
+#include "Profiler.h" // for PROFILER_ZONE
+
 /*****************************
  * Display stuff
  *****************************/
@@ -72,6 +74,7 @@ Chart ChartFFT;
  */
 void drawDataBuffer(uint16_t *aDataBufferPointer, int aLength, color16_t aColor, color16_t aClearBeforeColor, int aDrawMode,
         bool aDrawAlsoMin) {
+    PROFILER_ZONE(PROFILER_ZONE_DSO_DRAW);
     int i;
     int tValue;
 #if defined(SUPPORT_LOCAL_DISPLAY)
@@ -580,6 +580,10 @@ void initDSOGUI(void) {
 
     TouchButtonLoad.init(BUTTON_WIDTH_5_POS_2, tPosY, BUTTON_WIDTH_5, START_PAGE_BUTTON_HEIGHT,
             COLOR_GUI_SOURCE_TIMEBASE, "Load", TEXT_SIZE_11, BUTTON_FLAG_NO_BEEP_ON_TOUCH, MODE_LOAD, &doStoreLoadAcquisitionData);
+
+    // recording continues until measurement is stopped
+    TouchButtonRecord.init(BUTTON_WIDTH_5_POS_3, tPosY, BUTTON_WIDTH_5, START_PAGE_BUTTON_HEIGHT, 0, "Record", TEXT_SIZE_11,
+            FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN, false, &doRecordAcquisitionData);
 #endif
 
 // big start stop button
@@ -738,6 +742,11 @@ void initDSOGUI(void) {
 // Button for voltage calibration
     TouchButtonCalibrateVoltage.init(0, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, COLOR_GUI_SOURCE_TIMEBASE, "Calibrate U",
             TEXT_SIZE_11, FLAG_BUTTON_DO_BEEP_ON_TOUCH, 0, &doVoltageCalibration);
+#if defined(LOCAL_FILESYSTEM_EXISTS)
+// Button for replay of capture file, active until switched off or measurement is started
+    TouchButtonReplay.init(BUTTON_WIDTH_3_POS_2, tPosY, BUTTON_WIDTH_3, BUTTON_HEIGHT_4, 0, "Replay\ncapture", TEXT_SIZE_11,
+            FLAG_BUTTON_TYPE_TOGGLE_RED_GREEN, false, &doReplayCaptureFile);
+#endif
 // 2. row
     tPosY += SETTINGS_PAGE_ROW_INCREMENT;
 // Button for system info
@@ -858,6 +867,7 @@ void drawStartPage(void) {
 #if defined(LOCAL_FILESYSTEM_EXISTS)
     TouchButtonStore.drawButton();
     TouchButtonLoad.drawButton();
+    TouchButtonRecord.drawButton();
 #endif
     TouchButtonStartStopDSOMeasurement.drawButton();
 // 4. Row
@@ -963,6 +973,9 @@ void drawDSOMoreSettingsPage(void) {
     BDSlider::deactivateAll();
 //1. Row
     TouchButtonCalibrateVoltage.drawButton();
+#if defined(LOCAL_FILESYSTEM_EXISTS)
+    TouchButtonReplay.drawButton();
+#endif
     TouchButtonBack.drawButton();
 
 #if defined(SUPPORT_LOCAL_DISPLAY)
@@ -1385,6 +1398,12 @@ void doSwipeEndDSO(struct Swipe *const aSwipeInfo) {
             /*
              * Analyze Mode -> scroll or scale
              */
+#if defined(LOCAL_FILESYSTEM_EXISTS)
+            if (StreamReader_isOpen() && !aSwipeInfo->SwipeMainDirectionIsX) {
+                // replay is active -> step through frames of capture file
+                tIsError = showCaptureFrame(aSwipeInfo->TouchDeltaY);
+            } else
+#endif
 #if !defined(__AVR__)
             if (aSwipeInfo->TouchStartY < LOCAL_DISPLAY_HEIGHT / 2) {
                 tIsError = changeXScale(aSwipeInfo->TouchDeltaX / 64);
@@ -1586,6 +1605,8 @@ void doStartSingleshot(BDButton *aTheTouchedButton, int16_t aValue) {
 
 /*
  * Slider is only activated if trigger mode == TRIGGER_MODE_MANUAL_TIMEOUT or TRIGGER_MODE_MANUAL
+ * The local slider calls it at most every SLIDER_REDRAW_PERIOD_MILLIS with the last touch value.
+ * Skipped values do no harm, since the old line is cleared at the stored value.
  */
 void doTriggerLevel(BDSlider *aTheTouchedSlider, uint16_t aValue) {
 // to get display value take DISPLAY_VALUE_FOR_ZERO - aValue and vice versa
@@ -1612,6 +1633,7 @@ void doTriggerLevel(BDSlider *aTheTouchedSlider, uint16_t aValue) {
 
 /*
  * The value printed has a resolution of 0,00488 * scale factor
+ * Like doTriggerLevel(), it is called at most every SLIDER_REDRAW_PERIOD_MILLIS and clears the line at sLastPickerValue.
  */
 void doVoltagePicker(BDSlider *aTheTouchedSlider, uint16_t aValue) {
     if (sLastPickerValue == aValue) {
@@ -33,6 +33,7 @@
 //#define DO_NOT_NEED_BASIC_TOUCH_EVENTS // Disables basic touch events like down, move and up. Saves 620 bytes program memory and 36 bytes RAM
 //#define USE_SIMPLE_SERIAL // Do not use the Serial object. Saves up to 1250 bytes program memory and 185 bytes RAM, if Serial is not used otherwise
 //#define DISABLE_REMOTE_DISPLAY    // Suppress drawing to Bluetooth connected display. Allow only drawing on the locally attached display
+#define BD_SUPPORT_USB_CDC          // Allows to switch BlueDisplay communication from Bluetooth USART to USB CDC at runtime
 #define USE_TIMER_FOR_PERIODIC_LOCAL_TOUCH_CHECKS // Use registerDelayCallback() and changeDelayCallback() for periodic touch checks
 #define SUPPORT_LOCAL_LONG_TOUCH_DOWN_DETECTION
 #define LOCAL_DISPLAY_GENERATES_BD_EVENTS
@@ -42,6 +43,7 @@
 #define DISPLAY_HEIGHT LOCAL_DISPLAY_HEIGHT // Use local size for remote too
 #define DISPLAY_WIDTH  LOCAL_DISPLAY_WIDTH
 #include "BlueDisplay.hpp"          // Is used to access the local display too
+#include "Profiler.hpp"             // Zones and ISR statistics, see Profiler.h
 
 #include "PageMainMenu.hpp"
 
@@ -56,7 +58,7 @@ extern "C" {
 #include "ff.h"
 #include "diskio.h"
 #include "usbd_misc.h" // for USBDDeviceHandle
-#include "usbd_hid.h"
+#include "usbd_composite.h"
 #include "stm32f3_discovery_accelerometer.h"
 #include "stm32f3_discovery_gyroscope.h"
 }
@@ -104,6 +106,10 @@ int main(void) {
 
     // sets systic prio to 8
     NVIC_SetPriority(SysTick_IRQn, SYS_TICK_INTERRUPT_PRIO);
+#if defined(DELAY_CALLBACKS_IN_PENDSV)
+    NVIC_SetPriority(PendSV_IRQn, DELAY_CALLBACKS_PENDSV_PRIO);
+#endif
+    enableCycleCounter(); // for the profiler
 
     initializeLEDs();
     BSP_LED_On(LED_RED);
@@ -181,7 +187,9 @@ int main(void) {
     /* Init USB Device Library */
     USBD_Init(&USBDDeviceHandle, &HID_Desc, 0);
     // needed only once for each handle!
-    USBD_RegisterClass(&USBDDeviceHandle, &USBD_HID);
+    // HID mouse + keyboard, CDC virtual COM port and vendor bulk interface are all available at the same time
+    USBD_RegisterClass(&USBDDeviceHandle, &USBD_COMPOSITE);
+    USBD_Composite_registerCDCInterface(&USBD_CDC_fops);
 
     // sets the 1.5 K pullup if implemented
     USBD_Start(&USBDDeviceHandle);
@@ -12,6 +12,7 @@
 #include "BlueDisplay.h" // for WWDG_IRQHandler
 
 #include "timing.h"
+#include "Profiler.h"
 #include "pitches.h" // for playEndTone
 
 #include <stdio.h>
@@ -59,6 +60,7 @@ static bool isADCInitializedForTimerEvents;
 ADC_HandleTypeDef ADC2Handle;
 DMA_HandleTypeDef DMA11_ADC1_Handle;
 TIM_HandleTypeDef TIM15Handle;
+TIM_HandleTypeDef TIM16Handle;
 TIM_HandleTypeDef TIMSynthHandle;
 TIM_HandleTypeDef TIMToneHandle;
 TIM_HandleTypeDef TIM_DSOHandle;
@@ -795,7 +797,7 @@ bool DSO_getACMode(void) {
 // GPIO_ReadOutputDataBit(ADC1_ATTENUATOR_PORT, ADC1_AC_RANGE_PIN);
 }
 
-unsigned int AccuCapacity_ADCRead(uint8_t aProbeNumber) {
+void AccuCapacity_ADCSelectProbe(uint8_t aProbeNumber) {
     ADCChannelConfigDefault.SamplingTime = ADC_SAMPLETIME_SENSOR;
     if (aProbeNumber == 0) {
         ADCChannelConfigDefault.Channel = ADC_CHANNEL_6;
@@ -803,12 +805,31 @@ unsigned int AccuCapacity_ADCRead(uint8_t aProbeNumber) {
         ADCChannelConfigDefault.Channel = ADC_CHANNEL_7;
     }
     HAL_ADC_ConfigChannel(&ADC2Handle, &ADCChannelConfigDefault);
+}
 
+void AccuCapacity_ADCStartConversion(void) {
 #ifdef STM32F30X
     SET_BIT(ADC2Handle.Instance->CR, ADC_CR_ADSTART);
 #else
     SET_BIT(ADC2Handle.Instance->CR2, ADC_CR2_ADON);
-#endif    /* Test EOC flag */
+#endif
+}
+
+/**
+ * Non blocking read of the conversion started by AccuCapacity_ADCStartConversion()
+ * @return -1 if conversion is not yet finished
+ */
+int AccuCapacity_ADCGetConversion(void) {
+    if (__HAL_ADC_GET_FLAG(&ADC2Handle, ADC_FLAG_EOC) == RESET) {
+        return -1;
+    }
+    return HAL_ADC_GetValue(&ADC2Handle);
+}
+
+unsigned int AccuCapacity_ADCRead(uint8_t aProbeNumber) {
+    AccuCapacity_ADCSelectProbe(aProbeNumber);
+    AccuCapacity_ADCStartConversion();
+    /* Test EOC flag */
     setTimeoutMillis(ADC_DEFAULT_TIMEOUT);
     while (__HAL_ADC_GET_FLAG(&ADC2Handle, ADC_FLAG_EOC) == RESET) {
 #ifdef STM32F30X
@@ -1362,6 +1383,8 @@ void MICROSD_IO_initalize(void) {
 // set High
     HAL_GPIO_WritePin(MICROSD_CS_PORT, MICROSD_CS_PIN, GPIO_PIN_SET);
 
+    SPI1_DMA_initialize();
+
 // CardDetect pin
     GPIO_InitStructure.Pin = MICROSD_CARD_DETECT_PIN;
     GPIO_InitStructure.Mode = GPIO_MODE_IT_RISING_FALLING;
@@ -1522,6 +1545,37 @@ void IR_Timer_Start(void) {
 void IR_Timer_Stop(void) {
     __HAL_TIM_DISABLE(&TIM15Handle);
 }
+
+/*
+ * Timer 16 for starting the sensor acquisition bursts
+ */
+void Sensor_Timer_initialize(uint32_t aPeriodMicros) {
+    TIM16Handle.Instance = TIM16;
+    __TIM16_CLK_ENABLE()
+    ;
+
+    TIM16Handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    TIM16Handle.Init.Prescaler = (HAL_RCC_GetPCLK2Freq() / 1000000) - 1; // 1 MHz
+    TIM16Handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    TIM16Handle.Init.Period = aPeriodMicros - 1;
+    TIM16Handle.Init.RepetitionCounter = 0;
+    HAL_TIM_Base_Init(&TIM16Handle);
+
+    // same priority as the transfer ISR, since the burst state machine is not reentrant
+    // higher than systic, since touch handling in systic callbacks must be able to wait for the end of a gyroscope transfer
+    NVIC_SetPriority((IRQn_Type) (TIM1_UP_TIM16_IRQn), SENSOR_ACQUISITION_INTERRUPT_PRIORITY);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (TIM1_UP_TIM16_IRQn));
+    __HAL_TIM_CLEAR_IT(&TIM16Handle, TIM_IT_UPDATE);
+    __HAL_TIM_ENABLE_IT(&TIM16Handle, TIM_IT_UPDATE);
+}
+
+void Sensor_Timer_Start(void) {
+    __HAL_TIM_ENABLE(&TIM16Handle);
+}
+
+void Sensor_Timer_Stop(void) {
+    __HAL_TIM_DISABLE(&TIM16Handle);
+}
 #endif
 
 /* TIM2 configuration for frequency synthesizer */
@@ -1690,6 +1744,216 @@ extern "C" void SPI1_setPrescaler(uint16_t aPrescaler) {
     SPI1HandlePtr->Init.BaudRatePrescaler = aPrescaler;
 }
 
+/*
+ * Each thread user has its own flag, so no read-modify-write is needed
+ */
+static volatile bool sSPI1IsUsedByThread[SPI1_NUMBER_OF_THREAD_USERS];
+static volatile bool sSPI1IsUsedByISR = false;
+
+/**
+ * Waits for a running ISR transfer or touch burst and blocks new ISR transfers and touch bursts until SPI1_release()
+ */
+extern "C" void SPI1_acquire(uint8_t aUser) {
+    sSPI1IsUsedByThread[aUser] = true;
+    while (sSPI1IsUsedByISR || sSPI1IsUsedByThread[SPI1_USER_TOUCH_SAMPLER]) {
+        ;
+    }
+}
+
+/**
+ * For users, which must not wait, like the touch sampler called by SysTick.
+ * The flag is set before checking the others, so an interrupting sensor ISR sees it and does not start.
+ * @return false if SPI1 is used by another user
+ */
+extern "C" bool SPI1_tryAcquire(uint8_t aUser) {
+    sSPI1IsUsedByThread[aUser] = true;
+    bool tIsFree = !sSPI1IsUsedByISR;
+    for (uint_fast8_t i = 0; i < SPI1_NUMBER_OF_THREAD_USERS; ++i) {
+        if (i != aUser && sSPI1IsUsedByThread[i]) {
+            tIsFree = false;
+        }
+    }
+    if (!tIsFree) {
+        sSPI1IsUsedByThread[aUser] = false;
+    }
+    return tIsFree;
+}
+
+extern "C" void SPI1_release(uint8_t aUser) {
+    sSPI1IsUsedByThread[aUser] = false;
+}
+
+/**
+ * @return false if SPI1 is used by a thread user, e.g. between select and deselect of the MicroSD card
+ */
+extern "C" bool SPI1_tryAcquireFromISR(void) {
+    for (uint_fast8_t i = 0; i < SPI1_NUMBER_OF_THREAD_USERS; ++i) {
+        if (sSPI1IsUsedByThread[i]) {
+            return false;
+        }
+    }
+    sSPI1IsUsedByISR = true;
+    return true;
+}
+
+extern "C" void SPI1_releaseFromISR(void) {
+    sSPI1IsUsedByISR = false;
+}
+
+/*
+ * SPI1 DMA
+ * Channel 2 is SPI1_RX and channel 3 is SPI1_TX. The end of a transfer is signaled by the RX channel,
+ * since the last byte is received after it was transmitted.
+ */
+static DMA_HandleTypeDef DMA12_SPI1RX_Handle;
+static DMA_HandleTypeDef DMA13_SPI1TX_Handle;
+static volatile bool sSPI1DMATransferOngoing = false;
+static volatile bool sSPI1DMATransferError = false;
+static const uint8_t sSPI1DMAFillByte = 0xFF; // sent if there is no transmit buffer
+static uint8_t sSPI1DMADiscardByte; // receives data if there is no receive buffer
+static void (*sSPI1DMATransferEndCallback)(bool aTransferError) = NULL;
+
+extern "C" void SPI1_DMA_initialize(void) {
+    __DMA1_CLK_ENABLE()
+    ;
+    DMA12_SPI1RX_Handle.Instance = DMA1_Channel2;
+    DMA12_SPI1RX_Handle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    DMA12_SPI1RX_Handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    DMA12_SPI1RX_Handle.Init.MemInc = DMA_MINC_ENABLE;
+    DMA12_SPI1RX_Handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    DMA12_SPI1RX_Handle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    DMA12_SPI1RX_Handle.Init.Mode = DMA_NORMAL;
+    // RX must have higher priority than TX, otherwise RX FIFO may overflow at fast SPI clock
+    DMA12_SPI1RX_Handle.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+    HAL_DMA_Init(&DMA12_SPI1RX_Handle);
+    DMA12_SPI1RX_Handle.Instance->CPAR = (uint32_t) &SPI1->DR;
+
+    DMA13_SPI1TX_Handle.Instance = DMA1_Channel3;
+    DMA13_SPI1TX_Handle.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    DMA13_SPI1TX_Handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    DMA13_SPI1TX_Handle.Init.MemInc = DMA_MINC_ENABLE;
+    DMA13_SPI1TX_Handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    DMA13_SPI1TX_Handle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    DMA13_SPI1TX_Handle.Init.Mode = DMA_NORMAL;
+    DMA13_SPI1TX_Handle.Init.Priority = DMA_PRIORITY_HIGH;
+    HAL_DMA_Init(&DMA13_SPI1TX_Handle);
+    DMA13_SPI1TX_Handle.Instance->CPAR = (uint32_t) &SPI1->DR;
+
+    // higher than EXTI0, since screenshots are written to MicroSD card by the user button ISR
+    NVIC_SetPriority((IRQn_Type) (DMA1_Channel2_IRQn), 2);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (DMA1_Channel2_IRQn));
+}
+
+static void SPI1_DMA_stopTransfer(void) {
+    CLEAR_BIT(DMA12_SPI1RX_Handle.Instance->CCR, DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_TEIE);
+    CLEAR_BIT(DMA13_SPI1TX_Handle.Instance->CCR, DMA_CCR_EN);
+    CLEAR_BIT(SPI1->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+    sSPI1DMATransferOngoing = false;
+}
+
+/**
+ * Starts a full duplex transfer and returns immediately. SPI1 must be acquired by the caller.
+ * @param aTransmitBuffer if NULL, 0xFF is sent, e.g. for reading a MicroSD card sector
+ * @param aReceiveBuffer if NULL, the received data is discarded
+ */
+extern "C" void SPI1_DMA_startTransfer(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength) {
+    SPI1_DMA_startTransferWithCallback(aTransmitBuffer, aReceiveBuffer, aLength, NULL);
+}
+
+/**
+ * @param aTransferEndCallback is called by the DMA ISR with priority 2 after the transfer was stopped. Can be NULL.
+ */
+extern "C" void SPI1_DMA_startTransferWithCallback(const uint8_t *aTransmitBuffer, uint8_t *aReceiveBuffer, uint16_t aLength,
+        void (*aTransferEndCallback)(bool aTransferError)) {
+    assert_param(aLength != 0);
+    // to suppress unused warnings
+    uint8_t dummy __attribute__((unused));
+
+// wait for ongoing transfer to end and discard RX FIFO content
+    while (HAL_IS_BIT_SET(SPI1->SR, SPI_FLAG_BSY)) {
+        ;
+    }
+    while (HAL_IS_BIT_SET(SPI1->SR, SPI_FLAG_RXNE)) {
+        dummy = *(__IO uint8_t*) &SPI1->DR;
+    }
+
+    DMA_Channel_TypeDef *tReceiveChannel = DMA12_SPI1RX_Handle.Instance;
+    if (aReceiveBuffer == NULL) {
+        tReceiveChannel->CMAR = (uint32_t) &sSPI1DMADiscardByte;
+        CLEAR_BIT(tReceiveChannel->CCR, DMA_CCR_MINC);
+    } else {
+        tReceiveChannel->CMAR = (uint32_t) aReceiveBuffer;
+        SET_BIT(tReceiveChannel->CCR, DMA_CCR_MINC);
+    }
+    tReceiveChannel->CNDTR = aLength;
+
+    DMA_Channel_TypeDef *tTransmitChannel = DMA13_SPI1TX_Handle.Instance;
+    if (aTransmitBuffer == NULL) {
+        tTransmitChannel->CMAR = (uint32_t) &sSPI1DMAFillByte;
+        CLEAR_BIT(tTransmitChannel->CCR, DMA_CCR_MINC);
+    } else {
+        tTransmitChannel->CMAR = (uint32_t) aTransmitBuffer;
+        SET_BIT(tTransmitChannel->CCR, DMA_CCR_MINC);
+    }
+    tTransmitChannel->CNDTR = aLength;
+
+    __HAL_DMA_CLEAR_FLAG(&DMA12_SPI1RX_Handle, DMA_FLAG_GL2);
+    __HAL_DMA_CLEAR_FLAG(&DMA13_SPI1TX_Handle, DMA_FLAG_GL3);
+    sSPI1DMATransferError = false;
+    sSPI1DMATransferEndCallback = aTransferEndCallback;
+    sSPI1DMATransferOngoing = true;
+
+    // sequence from reference manual: enable RX DMA request, enable channels, then enable TX DMA request
+    SET_BIT(SPI1->CR2, SPI_CR2_RXDMAEN);
+    SET_BIT(tReceiveChannel->CCR, DMA_CCR_EN | DMA_CCR_TCIE | DMA_CCR_TEIE);
+    SET_BIT(tTransmitChannel->CCR, DMA_CCR_EN);
+    SET_BIT(SPI1->CR2, SPI_CR2_TXDMAEN);
+}
+
+extern "C" bool SPI1_DMA_isTransferOngoing(void) {
+    return sSPI1DMATransferOngoing;
+}
+
+/**
+ * The CPU is only used by interrupts while waiting.
+ * Can be called by ISRs with higher priority than SysTick, e.g. the screenshot by the user button EXTI0.
+ * @return false if timeout or transfer error
+ */
+extern "C" bool SPI1_DMA_waitForTransferEnd(uint32_t aTimeoutMillis) {
+    uint32_t tLR14 = getLR14();
+    // setTimeoutMillis() is not reentrant and is used by calling routine
+    WaitTimeoutTypeDef tTimeout;
+    startWaitTimeout(&tTimeout, aTimeoutMillis);
+    while (sSPI1DMATransferOngoing) {
+        if (isWaitTimeout(&tTimeout)) {
+            SPI1_DMA_stopTransfer();
+            failParamMessage(tLR14, "Timeout in SPI1_DMA_waitForTransferEnd()");
+            return false;
+        }
+    }
+    if (sSPI1DMATransferError || __HAL_DMA_GET_FLAG(&DMA13_SPI1TX_Handle, DMA_FLAG_TE3)) {
+        failParamMessage(tLR14, "SPI1 DMA transfer error");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * End of SPI1 DMA transfer
+ */
+extern "C" void DMA1_Channel2_IRQHandler(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_SPI_DMA, PROFILER_LATENCY_UNKNOWN);
+    if (__HAL_DMA_GET_FLAG(&DMA12_SPI1RX_Handle, DMA_FLAG_TE2)) {
+        sSPI1DMATransferError = true;
+    }
+    __HAL_DMA_CLEAR_FLAG(&DMA12_SPI1RX_Handle, DMA_FLAG_GL2);
+    SPI1_DMA_stopTransfer();
+    if (sSPI1DMATransferEndCallback != NULL) {
+        sSPI1DMATransferEndCallback(sSPI1DMATransferError);
+    }
+    PROFILER_ISR_EXIT(PROFILER_ISR_SPI_DMA);
+}
+
 /**
  * year since 1980
  * @return time since 1980 in 10 seconds resolution
@@ -1715,6 +1979,7 @@ extern "C" bool MICROSD_isCardInserted(void) {
 }
 
 extern "C" void MICROSD_CSEnable(void) {
+    SPI1_acquire(SPI1_USER_MICROSD);
 // set to LOW
     Reset_GpioPin(MICROSD_CARD_DETECT_PORT, MICROSD_CS_PIN);
 }
@@ -1724,6 +1989,13 @@ extern "C" void MICROSD_CSDisable(void) {
     Set_GpioPin(MICROSD_CARD_DETECT_PORT, MICROSD_CS_PIN);
 }
 
+/*
+ * Called after the dummy clock following MICROSD_CSDisable()
+ */
+extern "C" void MICROSD_releaseSPI(void) {
+    SPI1_release(SPI1_USER_MICROSD);
+}
+
 extern "C" void MICROSD_ClearITPendingBit(void) {
     __HAL_GPIO_EXTI_CLEAR_IT(GPIO_PIN_4);
 }
@@ -93,19 +93,10 @@ int _read(int file, char *ptr, int len) {
 
 int _write(int file, char *ptr, int len) {
 
-    if (isUsbCdcReady()) {
+    if (isUsbCdcReady() && !sUSBCDCIsBlueDisplayTransport) {
         // try to send over USB
-        USBD_CDC_SetTxBuffer(&USBDDeviceHandle, (uint8_t*) ptr, len);
-        setTimeoutMillis(2);
-        bool isTimeout = false;
-        while (USBD_CDC_TransmitPacket(&USBDDeviceHandle) == USBD_BUSY) {
-            if (isTimeoutSimple()) {
-                isTimeout = true;
-                break;
-            }
-        }
-        // Fallback
-        if (isTimeout) {
+        if (!CDC_sendBuffer((uint8_t*) ptr, len, NULL, 0)) {
+            // Fallback
             myPrint(ptr, len);
         }
     } else {
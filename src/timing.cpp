@@ -14,6 +14,7 @@
 #include "main.h" // for StringBuffer
 #include "BlueDisplay.h"
 #include "stm32fx0xPeripherals.h"
+#include "Profiler.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -23,6 +24,11 @@
 #include <time.h>
 #include <core_cmInstr.h>
 
+// interrupts calling changeDelayCallback() are masked during list operations, since they have higher priority than SysTick
+#define DELAY_CALLBACK_WHEEL_LOCK()     uint32_t tBasepri = __get_BASEPRI(); __set_BASEPRI_MAX(DELAY_CALLBACK_CALLER_MAX_PRIO << (8 - __NVIC_PRIO_BITS))
+#define DELAY_CALLBACK_WHEEL_UNLOCK()   __set_BASEPRI(tBasepri)
+#include "DelayCallbackWheel.hpp"
+
 void doOneSystic(void);
 
 //! for timeouts
@@ -34,16 +40,6 @@ volatile uint32_t TimingDelayForISR[NUMBER_OF_PREEMPTIVE_PRIOS] = { 0, 0, 0, 0 }
 
 volatile uint32_t MillisSinceBoot = 0;
 
-// 4 + 1 callbacks for accuCapacity
-// 3 callbacks for Touch
-// 1 callback for LCD dimming
-// 1 callback for tone duration
-// 1 one time callback for delayed MMC initialization
-#define CALLBACK_ENTRIES_SIZE 11
-// array of pointer to timer-delay callback function
-void (*DelayCallbackPointer[CALLBACK_ENTRIES_SIZE])(void);
-volatile int32_t DelayCallbackMillis[CALLBACK_ENTRIES_SIZE] = { 0, 0, 0, 0, 0 };
-
 /**
  * loop delay of nanoseconds.
  * 0-249 ns gives 18 ticks for loading parameter and return without a loop
@@ -110,31 +106,19 @@ static void delayBusy(int32_t aTimeMillis) {
  * if check is needed use changeDelayCallback()
  */
 void registerDelayCallback(void (*aDelayCallback)(void), int32_t aTimeMillis) {
-    int i;
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackMillis[i] == 0) {
-            DelayCallbackPointer[i] = aDelayCallback;
-            DelayCallbackMillis[i] = aTimeMillis;
-            return;
-        }
+    if (!DelayCallbackWheel_add(aDelayCallback, aTimeMillis)) {
+        failParamMessage(aDelayCallback, "No more free callback entries");
     }
-    failParamMessage(aDelayCallback, "No more free callback entries");
 }
 
 /**
  * change a delay for a already registered callback or insert one if not existent
+ * @param aTimeMillis 0 cancels the callback
  */
 void changeDelayCallback(void (*aDelayCallback)(void), int32_t aTimeMillis) {
-    int i;
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackPointer[i] == aDelayCallback) {
-            DelayCallbackMillis[i] = aTimeMillis;
-            // entry found, job done
-            return;
-        }
+    if (!DelayCallbackWheel_change(aDelayCallback, aTimeMillis)) {
+        failParamMessage(aDelayCallback, "No more free callback entries");
     }
-    // no entry found -> insert one
-    registerDelayCallback(aDelayCallback, aTimeMillis);
 }
 
 /**
@@ -157,13 +141,14 @@ void doOneSystic(void) {
     /**
      * delays with callback
      */
-    for (i = 0; i < CALLBACK_ENTRIES_SIZE; ++i) {
-        if (DelayCallbackMillis[i] > 0) {
-            DelayCallbackMillis[i]--;
-            if (DelayCallbackMillis[i] == 0) {
-                DelayCallbackPointer[i]();
-            }
-        }
+    DelayCallbackWheel_tick();
+    if (DelayCallbackWheel_hasExpired()) {
+#if defined(DELAY_CALLBACKS_IN_PENDSV)
+        SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+#else
+        PROFILER_ZONE(PROFILER_ZONE_DELAY_CALLBACKS);
+        DelayCallbackWheel_runExpired();
+#endif
     }
 
     /**
@@ -329,13 +314,33 @@ void testTimingsLoop(int aCount) {
     }
 }
 
+/**
+ * Duration is measured by the profiler, which requires the DWT cycle counter enabled by enableCycleCounter()
+ */
 extern "C" void SysTick_Handler(void) {
+    // SysTick counts down with HCLK and requests the interrupt at reload
+    PROFILER_ISR_ENTER(PROFILER_ISR_SYSTICK, getSysticReloadValue() - getSysticValue());
     HAL_IncTick();
 //  Toggle_DebugPin(); // to measure crystal by external counter
     MillisSinceBoot++;
     doOneSystic();
+    PROFILER_ISR_EXIT(PROFILER_ISR_SYSTICK);
 }
 
+#if defined(DELAY_CALLBACKS_IN_PENDSV)
+/**
+ * Runs the delay callbacks expired in SysTick with DELAY_CALLBACKS_PENDSV_PRIO, which must be set at startup
+ */
+extern "C" void PendSV_Handler(void) {
+    PROFILER_ISR_ENTER(PROFILER_ISR_PENDSV, PROFILER_LATENCY_UNKNOWN);
+    {
+        PROFILER_ZONE(PROFILER_ZONE_DELAY_CALLBACKS);
+        DelayCallbackWheel_runExpired();
+    }
+    PROFILER_ISR_EXIT(PROFILER_ISR_PENDSV);
+}
+#endif
+
 /**
  * @retval millis since start of program
  */
@@ -343,6 +348,26 @@ extern "C" uint32_t millis() {
     return MillisSinceBoot;
 }
 
+/**
+ * Interpolates the systic counter. Can also be called from ISRs with higher priority than systic.
+ * @retval micros since start of program
+ */
+extern "C" uint32_t micros() {
+    uint32_t tMillis;
+    uint32_t tSysticValue;
+    do {
+        tMillis = MillisSinceBoot;
+        tSysticValue = getSysticValue();
+    } while (tMillis != MillisSinceBoot); // systic interrupt in between
+    if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+        // counter wrapped, but systic interrupt is blocked by current ISR
+        tSysticValue = getSysticValue();
+        tMillis++;
+    }
+    uint32_t tReload = getSysticReloadValue() + 1;
+    return (tMillis * 1000) + (((tReload - tSysticValue) * 1000) / tReload);
+}
+
 /**
  * wait for aTimeMillis milliseconds.
  * @param  aTimeMillis: specifies the delay time length, in 1 ms.
@@ -350,8 +375,9 @@ extern "C" uint32_t millis() {
 extern "C" void delay(int32_t aTimeMillis) {
     // get interrupt level
     uint32_t tIPSR = (__get_IPSR() & 0xFF);
-    // in high priority system interrupt like bus_fault, systic etc.
-    if (tIPSR > 0 && tIPSR < OFFSET_INTERRUPT_TYPE_TO_ISR_INT_NUMBER) {
+    // in high priority system interrupt like bus_fault, systic etc. PendSV has lowest prio and waits like an ISR
+    if (tIPSR > 0 && tIPSR < OFFSET_INTERRUPT_TYPE_TO_ISR_INT_NUMBER
+            && tIPSR != (PendSV_IRQn + OFFSET_INTERRUPT_TYPE_TO_ISR_INT_NUMBER)) {
         // no other delay possible
         delayBusy(aTimeMillis);
     } else if (tIPSR == 0) {
@@ -465,6 +491,36 @@ extern "C" bool isTimeoutSimple(void) {
 #endif
     return tRetval;
 }
+/**
+ * Unlike setTimeoutMillis(), it is reentrant and needs no SysTick, since the state is kept by the caller.
+ */
+extern "C" void startWaitTimeout(WaitTimeoutTypeDef *aTimeout, uint32_t aTimeoutMillis) {
+    uint32_t tIPSR = (__get_IPSR() & 0xFF);
+    // IPSR 2 and 3 are NMI and hard fault with fixed priority
+    aTimeout->UseCycles = (tIPSR != 0
+            && (tIPSR < 4
+                    || NVIC_GetPriority((IRQn_Type) ((int) tIPSR - OFFSET_INTERRUPT_TYPE_TO_ISR_INT_NUMBER))
+                            <= SYS_TICK_INTERRUPT_PRIO));
+    if (aTimeout->UseCycles) {
+        uint32_t tCyclesPerMilli = SystemCoreClock / 1000;
+        if (aTimeoutMillis > UINT32_MAX / tCyclesPerMilli) {
+            aTimeoutMillis = UINT32_MAX / tCyclesPerMilli;
+        }
+        aTimeout->Start = getCycleCounter();
+        aTimeout->Duration = aTimeoutMillis * tCyclesPerMilli;
+    } else {
+        aTimeout->Start = millis();
+        aTimeout->Duration = aTimeoutMillis;
+    }
+}
+
+extern "C" bool isWaitTimeout(const WaitTimeoutTypeDef *aTimeout) {
+    if (aTimeout->UseCycles) {
+        return (getCycleCounter() - aTimeout->Start) >= aTimeout->Duration;
+    }
+    return (millis() - aTimeout->Start) >= aTimeout->Duration;
+}
+
 /**
  * Sets timeout LED.
  * @retval 0
@@ -12,6 +12,7 @@
 #define L3GDC20_LSM303DLHC_UTILS_H_
 
 #include <stdint.h>
+#include "sensorAcquisition.h"
 
 #ifndef PI
 #define PI                         (float)     3.14159265f
@@ -26,6 +27,20 @@ void setZeroAccelerometerGyroValue(void);
 
 float readLSM303TempFloat(void);
 
+/*
+ * Output data rates used for acquisition
+ */
+#define GYROSCOPE_SAMPLE_PERIOD_MICROS      2632 // 380 Hz
+#define ACCELEROMETER_SAMPLE_PERIOD_MICROS  2500 // 400 Hz
+#define SENSOR_BURST_PERIOD_MICROS          20000 // 50 Hz. FIFOs are full after 84 ms.
+
+void startSensorAcquisition(void);
+void stopSensorAcquisition(void);
+bool isSensorAcquisitionRunning(void);
+void convertAccelerometerSampleZeroCompensated(SensorSampleTypeDef *aSample, int16_t *aAccelerometerData);
+void convertGyroscopeSampleZeroCompensated(SensorSampleTypeDef *aSample, float *aGyroscopeData);
+void convertCompassSample(SensorSampleTypeDef *aSample, int16_t *aCompassData);
+
 // Demo functions
 void Demo_CompassReadAcc(float* pfData);
 
@@ -0,0 +1,62 @@
+/*
+ * @file orientationFilter.h
+ *
+ * Mahony quaternion filter fusing gyroscope, accelerometer and compass to roll, pitch and yaw.
+ * Uses the FPU of the STM32F3. The integral feedback term tracks the gyroscope bias.
+ * Compass values are corrected by a hard and soft iron calibration obtained by rotating the board in all directions.
+ * Contains no HAL code.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef ORIENTATION_FILTER_H_
+#define ORIENTATION_FILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ORIENTATION_FILTER_KP_DEFAULT   1.0f // proportional gain, higher values trust accelerometer and compass more
+#define ORIENTATION_FILTER_KI_DEFAULT   0.02f // integral gain for gyroscope bias tracking
+
+typedef struct {
+    float Q0, Q1, Q2, Q3; // quaternion of sensor frame relative to earth frame
+    float GyroscopeBias[3]; // rad/s, estimated by integral feedback
+    float Kp;
+    float Ki;
+} OrientationFilterTypeDef;
+
+/*
+ * Hard iron offset is the center of the min / max values of each axis.
+ * Soft iron correction is a per axis scale, which makes the min / max ranges equal (diagonal approximation).
+ */
+typedef struct {
+    int16_t Minimum[3];
+    int16_t Maximum[3];
+    float Offset[3];
+    float Scale[3];
+    bool IsCalibrating;
+    bool IsValid;
+} CompassCalibrationTypeDef;
+
+typedef struct {
+    float Roll; // degree
+    float Pitch;
+    float Yaw;
+} EulerAnglesTypeDef;
+
+void OrientationFilter_init(OrientationFilterTypeDef *aFilter);
+void OrientationFilter_update(OrientationFilterTypeDef *aFilter, const float *aGyroscopeRadiansPerSecond,
+        const float *aAccelerometer, const float *aCompass, float aDeltaSeconds);
+void OrientationFilter_getEulerAngles(OrientationFilterTypeDef *aFilter, EulerAnglesTypeDef *aAngles);
+
+void CompassCalibration_init(CompassCalibrationTypeDef *aCalibration);
+void CompassCalibration_start(CompassCalibrationTypeDef *aCalibration);
+void CompassCalibration_addSample(CompassCalibrationTypeDef *aCalibration, const int16_t *aCompassRaw);
+bool CompassCalibration_stop(CompassCalibrationTypeDef *aCalibration);
+void CompassCalibration_apply(CompassCalibrationTypeDef *aCalibration, const int16_t *aCompassRaw, float *aCompassCalibrated);
+
+#endif /* ORIENTATION_FILTER_H_ */
@@ -0,0 +1,93 @@
+/*
+ * @file sensorAcquisition.h
+ *
+ * Non blocking burst acquisition of the L3GD20 and LSM303DLHC FIFOs into a timestamped sample ring.
+ * Contains no HAL code. The transfers are done by the functions of a SensorBusTypeDef,
+ * so the FIFO and ring logic can also be driven by a simulated bus.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#ifndef SENSOR_ACQUISITION_H_
+#define SENSOR_ACQUISITION_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SENSOR_GYROSCOPE        0
+#define SENSOR_ACCELEROMETER    1
+#define SENSOR_COMPASS          2
+#define NUMBER_OF_SENSORS       3
+
+/*
+ * Both FIFOs have 32 entries of 3 * 16 bit
+ */
+#define SENSOR_FIFO_DEPTH               32
+#define SENSOR_BYTES_PER_SAMPLE         6
+#define SENSOR_BURST_BUFFER_SIZE        (SENSOR_FIFO_DEPTH * SENSOR_BYTES_PER_SAMPLE)
+
+/*
+ * Register addresses used by the burst state machine.
+ * The bus functions must add the read and auto increment flags required by SPI or I2C.
+ */
+#define SENSOR_L3GD20_FIFO_SRC_REG      0x2F
+#define SENSOR_L3GD20_OUT_X_L           0x28
+#define SENSOR_LSM303_FIFO_SRC_REG_A    0x2F
+#define SENSOR_LSM303_OUT_X_L_A         0x28
+#define SENSOR_LSM303_OUT_X_H_M         0x03
+
+#define SENSOR_FIFO_SRC_OVERRUN         0x40
+#define SENSOR_FIFO_SRC_EMPTY           0x20
+#define SENSOR_FIFO_SRC_COUNT_MASK      0x1F
+
+typedef struct {
+    uint32_t TimestampMicros;
+    int16_t Values[3]; // X, Y, Z. Gyroscope and compass raw, accelerometer raw right aligned 12 bit.
+    uint8_t Sensor; // SENSOR_*
+} SensorSampleTypeDef;
+
+/*
+ * The ring must hold the samples of the longest main loop period, plus one burst.
+ * 256 samples last 310 ms at the rates of the demo page (380 gyroscope, 400 accelerometer and 50 compass samples per second).
+ * The page loop consumes every 50 ms, plus the time for drawing, so 200 ms are assumed as its worst case.
+ * RAM is 12 bytes per sample.
+ */
+#if !defined(SENSOR_SAMPLE_RING_SIZE)
+#define SENSOR_SAMPLE_RING_SIZE 256 // must be power of 2
+#endif
+
+/*
+ * Bus functions. startRead() must not block.
+ * It returns false if the bus is in use, otherwise it calls SensorAcquisition_readCompleted() when the transfer has finished.
+ * All calls of SensorAcquisition_startBurst() and SensorAcquisition_readCompleted() must have the same interrupt priority.
+ */
+typedef struct {
+    bool (*startRead)(uint8_t aSensor, uint8_t aRegister, uint8_t *aBuffer, uint16_t aLength);
+} SensorBusTypeDef;
+
+typedef struct {
+    uint32_t Bursts;
+    uint32_t BurstsSkipped; // previous burst still running
+    uint32_t BusBusy; // read skipped because bus was used by another device
+    uint32_t BusErrors;
+    uint32_t Samples[NUMBER_OF_SENSORS];
+    uint32_t FifoOverruns[NUMBER_OF_SENSORS];
+    uint32_t RingOverruns; // samples lost, because main loop did not consume them in time
+} SensorAcquisitionStatisticsTypeDef;
+
+extern volatile SensorAcquisitionStatisticsTypeDef SensorAcquisitionStatistics;
+
+void SensorAcquisition_init(const SensorBusTypeDef *aBus, uint32_t aGyroscopeSamplePeriodMicros,
+        uint32_t aAccelerometerSamplePeriodMicros);
+bool SensorAcquisition_isIdle(void);
+bool SensorAcquisition_startBurst(uint32_t aTimestampMicros);
+void SensorAcquisition_readCompleted(bool aSuccess);
+
+uint16_t SensorAcquisition_getAvailable(void);
+uint16_t SensorAcquisition_getSamples(SensorSampleTypeDef *aSampleBuffer, uint16_t aMaxCount);
+
+#endif /* SENSOR_ACQUISITION_H_ */
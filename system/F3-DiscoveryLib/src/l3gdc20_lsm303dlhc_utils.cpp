@@ -11,8 +11,12 @@
 #include "timing.h"
 #include "l3gdc20_lsm303dlhc_utils.h"
 #include "stm32f3DiscoPeripherals.h"
+#include "stm32fx0xPeripherals.h"
+
+#include <string.h> // for memcpy
 
 extern "C" {
+#include "stm32f3_discovery.h"
 #include "stm32f3_discovery_accelerometer.h"
 #include "stm32f3_discovery_gyroscope.h"
 }
@@ -41,6 +45,11 @@ void readGyroscopeZeroCompensated(float aGyroscopeRawData[]) {
 }
 
 void setZeroAccelerometerGyroValue(void) {
+    // the polling BSP functions must not be used while acquisition uses the bus
+    bool tAcquisitionWasRunning = isSensorAcquisitionRunning();
+    if (tAcquisitionWasRunning) {
+        stopSensorAcquisition();
+    }
     // use oversampling
     AccelerometerZeroCompensation[0] = 0;
     AccelerometerZeroCompensation[1] = 0;
@@ -70,9 +79,266 @@ void setZeroAccelerometerGyroValue(void) {
     GyroscopeZeroCompensation[0] /= LSM303DLHC_CALIBRATION_OVERSAMPLING;
     GyroscopeZeroCompensation[1] /= LSM303DLHC_CALIBRATION_OVERSAMPLING;
     GyroscopeZeroCompensation[2] /= LSM303DLHC_CALIBRATION_OVERSAMPLING;
+    if (tAcquisitionWasRunning) {
+        startSensorAcquisition();
+    }
 }
 
 float readLSM303TempFloat(void) {
     float tTemp = readLSM303TempRaw();
     return tTemp / 2;
 }
+
+/*******************************************************
+ * Interrupt driven acquisition with FIFOs
+ * The FIFO watermark and data ready lines of the sensors share their EXTI lines with the user button,
+ * the touch panel and the MicroSD card detect. Therefore the FIFOs are read by a periodic timer interrupt.
+ * The L3GD20 is read by SPI1 with interrupt, since the SPI1 DMA channels are used by the MicroSD card.
+ * The LSM303DLHC is read by I2C1 with DMA.
+ * While acquisition is running, the polling BSP functions must not be used.
+ *******************************************************/
+extern I2C_HandleTypeDef I2cHandle; // from stm32f3_discovery.c - must remove static there
+static DMA_HandleTypeDef DMA17_I2C1RX_Handle;
+
+#define L3GD20_READ_MULTIPLE_BYTES  0xC0
+#define LSM303DLHC_AUTO_INCREMENT   0x80
+
+static volatile bool sSensorAcquisitionIsRunning = false;
+static bool startSensorRead(uint8_t aSensor, uint8_t aRegister, uint8_t *aBuffer, uint16_t aLength);
+static const SensorBusTypeDef sSensorBus = { &startSensorRead };
+
+// first byte is the register address
+static uint8_t sGyroscopeSPIBuffer[SENSOR_BURST_BUFFER_SIZE + 1];
+static uint8_t *sGyroscopeTargetBuffer;
+static uint16_t sGyroscopeTargetLength;
+static uint16_t sSPI1PrescalerOfInterruptedUser;
+
+static float sGyroscopeSensitivity; // mdps per digit
+static uint8_t sAccelerometerSensitivity; // mg per digit
+#define COMPASS_DIVIDER 16 // divider of readCompassRaw() with accelerometer FIFO disabled
+
+static bool startSensorRead(uint8_t aSensor, uint8_t aRegister, uint8_t *aBuffer, uint16_t aLength) {
+    if (aSensor == SENSOR_GYROSCOPE) {
+        if (!SPI1_tryAcquireFromISR()) {
+            return false;
+        }
+        sSPI1PrescalerOfInterruptedUser = SPI1_getPrescaler();
+        SPI1_setPrescaler(SPI_BAUDRATEPRESCALER_8); // 9 MHz, L3GD20 supports up to 10 MHz
+        sGyroscopeTargetBuffer = aBuffer;
+        sGyroscopeTargetLength = aLength;
+        sGyroscopeSPIBuffer[0] = aRegister | L3GD20_READ_MULTIPLE_BYTES;
+        GYRO_CS_LOW();
+        // TX and RX buffer can be the same, since a byte is received after it was sent
+        if (HAL_SPI_TransmitReceive_IT(SPI1HandlePtr, sGyroscopeSPIBuffer, sGyroscopeSPIBuffer, aLength + 1) != HAL_OK) {
+            GYRO_CS_HIGH();
+            SPI1_setPrescaler(sSPI1PrescalerOfInterruptedUser);
+            SPI1_releaseFromISR();
+            return false;
+        }
+        return true;
+    }
+
+    uint16_t tDeviceAddress = MAG_I2C_ADDRESS;
+    if (aSensor == SENSOR_ACCELEROMETER) {
+        tDeviceAddress = ACC_I2C_ADDRESS;
+        aRegister |= LSM303DLHC_AUTO_INCREMENT; // compass increments automatically
+    }
+    return (HAL_I2C_Mem_Read_DMA(&I2cHandle, tDeviceAddress, aRegister, I2C_MEMADD_SIZE_8BIT, aBuffer, aLength) == HAL_OK);
+}
+
+static void endGyroscopeRead(bool aSuccess) {
+    GYRO_CS_HIGH();
+    SPI1_setPrescaler(sSPI1PrescalerOfInterruptedUser);
+    SPI1_releaseFromISR();
+    if (aSuccess) {
+        memcpy(sGyroscopeTargetBuffer, &sGyroscopeSPIBuffer[1], sGyroscopeTargetLength);
+    }
+    SensorAcquisition_readCompleted(aSuccess);
+}
+
+extern "C" void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *aSPIHandle) {
+    endGyroscopeRead(true);
+}
+
+extern "C" void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *aSPIHandle) {
+    endGyroscopeRead(false);
+}
+
+extern "C" void HAL_I2C_MemRxCpltCallback(I2C_HandleTypeDef *aI2CHandle) {
+    SensorAcquisition_readCompleted(true);
+}
+
+extern "C" void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *aI2CHandle) {
+    SensorAcquisition_readCompleted(false);
+}
+
+extern "C" void TIM1_UP_TIM16_IRQHandler(void) {
+    if (__HAL_TIM_GET_FLAG(&TIM16Handle, TIM_FLAG_UPDATE) != RESET) {
+        __HAL_TIM_CLEAR_IT(&TIM16Handle, TIM_IT_UPDATE);
+        SensorAcquisition_startBurst(micros());
+    }
+}
+
+extern "C" void SPI1_IRQHandler(void) {
+    HAL_SPI_IRQHandler(SPI1HandlePtr);
+}
+
+extern "C" void I2C1_EV_IRQHandler(void) {
+    HAL_I2C_EV_IRQHandler(&I2cHandle);
+}
+
+extern "C" void I2C1_ER_IRQHandler(void) {
+    HAL_I2C_ER_IRQHandler(&I2cHandle);
+}
+
+extern "C" void DMA1_Channel7_IRQHandler(void) {
+    HAL_DMA_IRQHandler(I2cHandle.hdmarx);
+}
+
+static void initSensorAcquisitionIO(void) {
+    __DMA1_CLK_ENABLE()
+    ;
+    DMA17_I2C1RX_Handle.Instance = DMA1_Channel7;
+    DMA17_I2C1RX_Handle.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    DMA17_I2C1RX_Handle.Init.PeriphInc = DMA_PINC_DISABLE;
+    DMA17_I2C1RX_Handle.Init.MemInc = DMA_MINC_ENABLE;
+    DMA17_I2C1RX_Handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    DMA17_I2C1RX_Handle.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    DMA17_I2C1RX_Handle.Init.Mode = DMA_NORMAL;
+    DMA17_I2C1RX_Handle.Init.Priority = DMA_PRIORITY_LOW;
+    HAL_DMA_Init(&DMA17_I2C1RX_Handle);
+    __HAL_LINKDMA(&I2cHandle, hdmarx, DMA17_I2C1RX_Handle);
+
+    NVIC_SetPriority((IRQn_Type) (DMA1_Channel7_IRQn), SENSOR_ACQUISITION_INTERRUPT_PRIORITY);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (DMA1_Channel7_IRQn));
+    NVIC_SetPriority((IRQn_Type) (I2C1_EV_IRQn), SENSOR_ACQUISITION_INTERRUPT_PRIORITY);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (I2C1_EV_IRQn));
+    NVIC_SetPriority((IRQn_Type) (I2C1_ER_IRQn), SENSOR_ACQUISITION_INTERRUPT_PRIORITY);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (I2C1_ER_IRQn));
+    NVIC_SetPriority((IRQn_Type) (SPI1_IRQn), SENSOR_ACQUISITION_INTERRUPT_PRIORITY);
+    HAL_NVIC_EnableIRQ((IRQn_Type) (SPI1_IRQn));
+
+    Sensor_Timer_initialize(SENSOR_BURST_PERIOD_MICROS);
+}
+
+/*
+ * Sets output data rates and FIFO stream mode and reads the sensitivities
+ */
+static void initSensorsForAcquisition(void) {
+    uint8_t tValue;
+    /*
+     * Gyroscope 380 Hz, FIFO in stream mode
+     */
+    tValue = 0x8F; // 380 Hz, cutoff 20 Hz, all axes enabled
+    GYRO_IO_Write(&tValue, L3GD20_CTRL_REG1_ADDR, 1);
+    GYRO_IO_Read(&tValue, L3GD20_CTRL_REG5_ADDR, 1);
+    tValue |= 0x40; // FIFO enable
+    GYRO_IO_Write(&tValue, L3GD20_CTRL_REG5_ADDR, 1);
+    tValue = 0x40; // stream mode
+    GYRO_IO_Write(&tValue, L3GD20_FIFO_CTRL_REG_ADDR, 1);
+
+    GYRO_IO_Read(&tValue, L3GD20_CTRL_REG4_ADDR, 1);
+    tValue &= 0x30;
+    if (tValue == 0x00) {
+        sGyroscopeSensitivity = 8.75; // 250 dps
+    } else if (tValue == 0x10) {
+        sGyroscopeSensitivity = 17.5; // 500 dps
+    } else {
+        sGyroscopeSensitivity = 70; // 2000 dps
+    }
+
+    /*
+     * Accelerometer 400 Hz, FIFO in stream mode
+     */
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG1_A, 0x77); // 400 Hz, all axes enabled
+    tValue = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG5_A);
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG5_A, tValue | 0x40); // FIFO enable
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_FIFO_CTRL_REG_A, 0x80); // stream mode
+
+    tValue = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG4_A);
+    const uint8_t tAccelerometerSensitivities[4] = { 1, 2, 4, 12 }; // 2, 4, 8, 16 g
+    sAccelerometerSensitivity = tAccelerometerSensitivities[(tValue >> 4) & 0x03];
+
+    /*
+     * Compass 75 Hz, continuous conversion
+     */
+    COMPASSACCELERO_IO_Write(MAG_I2C_ADDRESS, LSM303DLHC_CRA_REG_M, LSM303DLHC_TEMPSENSOR_ENABLE | LSM303DLHC_ODR_75_HZ);
+    COMPASSACCELERO_IO_Write(MAG_I2C_ADDRESS, LSM303DLHC_MR_REG_M, LSM303DLHC_CONTINUOS_CONVERSION);
+}
+
+/*
+ * Bypass mode, required for the polling BSP functions
+ */
+static void disableSensorFifos(void) {
+    uint8_t tValue = 0x00; // bypass mode
+    GYRO_IO_Write(&tValue, L3GD20_FIFO_CTRL_REG_ADDR, 1);
+    GYRO_IO_Read(&tValue, L3GD20_CTRL_REG5_ADDR, 1);
+    tValue &= ~0x40;
+    GYRO_IO_Write(&tValue, L3GD20_CTRL_REG5_ADDR, 1);
+
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_FIFO_CTRL_REG_A, 0x00);
+    tValue = COMPASSACCELERO_IO_Read(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG5_A);
+    COMPASSACCELERO_IO_Write(ACC_I2C_ADDRESS, LSM303DLHC_CTRL_REG5_A, tValue & ~0x40);
+}
+
+/**
+ * Starts periodic reading of all sensor FIFOs into the sample ring
+ */
+void startSensorAcquisition(void) {
+    static bool sIOIsInitialized = false;
+    if (!sIOIsInitialized) {
+        sIOIsInitialized = true;
+        initSensorAcquisitionIO();
+    }
+    initSensorsForAcquisition();
+    SensorAcquisition_init(&sSensorBus, GYROSCOPE_SAMPLE_PERIOD_MICROS, ACCELEROMETER_SAMPLE_PERIOD_MICROS);
+    sSensorAcquisitionIsRunning = true;
+    Sensor_Timer_Start();
+}
+
+/**
+ * Stops timer, waits for end of running burst and restores bypass mode of FIFOs
+ */
+void stopSensorAcquisition(void) {
+    Sensor_Timer_Stop();
+    setTimeoutMillis(10);
+    while (!SensorAcquisition_isIdle()) {
+        if (isTimeoutSimple()) {
+            break;
+        }
+    }
+    sSensorAcquisitionIsRunning = false;
+    disableSensorFifos();
+}
+
+bool isSensorAcquisitionRunning(void) {
+    return sSensorAcquisitionIsRunning;
+}
+
+/**
+ * Same scaling as readAccelerometerZeroCompensated()
+ */
+void convertAccelerometerSampleZeroCompensated(SensorSampleTypeDef *aSample, int16_t *aAccelerometerData) {
+    // invert X value, it fits better :-)
+    aAccelerometerData[0] = (-aSample->Values[0] * sAccelerometerSensitivity) - AccelerometerZeroCompensation[0];
+    aAccelerometerData[1] = (aSample->Values[1] * sAccelerometerSensitivity) - AccelerometerZeroCompensation[1];
+    aAccelerometerData[2] = (aSample->Values[2] * sAccelerometerSensitivity) - AccelerometerZeroCompensation[2];
+}
+
+/**
+ * Same scaling as readGyroscopeZeroCompensated()
+ */
+void convertGyroscopeSampleZeroCompensated(SensorSampleTypeDef *aSample, float *aGyroscopeData) {
+    aGyroscopeData[0] = (aSample->Values[0] * sGyroscopeSensitivity) - GyroscopeZeroCompensation[0];
+    aGyroscopeData[1] = (aSample->Values[1] * sGyroscopeSensitivity) - GyroscopeZeroCompensation[1];
+    aGyroscopeData[2] = (aSample->Values[2] * sGyroscopeSensitivity) - GyroscopeZeroCompensation[2];
+}
+
+/**
+ * Same scaling as readCompassRaw(), but order is X, Y, Z
+ */
+void convertCompassSample(SensorSampleTypeDef *aSample, int16_t *aCompassData) {
+    aCompassData[0] = aSample->Values[0] / COMPASS_DIVIDER;
+    aCompassData[1] = aSample->Values[1] / COMPASS_DIVIDER;
+    aCompassData[2] = aSample->Values[2] / COMPASS_DIVIDER;
+}
@@ -0,0 +1,212 @@
+/*
+ * @file orientationFilter.cpp
+ *
+ * Based on the Mahony AHRS algorithm (R. Mahony et al. 2008, implementation of S. Madgwick).
+ * The error between measured and estimated direction of gravity and magnetic field is fed back to the gyroscope rates.
+ * Without valid compass values only roll and pitch are corrected and yaw drifts slowly.
+ * The cycles per update are measured and displayed by the accelerometer page.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "orientationFilter.h"
+#include <math.h>
+#include <stddef.h> // for NULL
+
+#define RADIANS_TO_DEGREE (180.0f / 3.14159265f)
+#define COMPASS_CALIBRATION_MIN_RANGE 100 // raw values, smaller ranges indicate that board was not rotated
+
+static float invSqrt(float aValue) {
+    return 1.0f / sqrtf(aValue);
+}
+
+void OrientationFilter_init(OrientationFilterTypeDef *aFilter) {
+    aFilter->Q0 = 1.0f;
+    aFilter->Q1 = 0.0f;
+    aFilter->Q2 = 0.0f;
+    aFilter->Q3 = 0.0f;
+    aFilter->GyroscopeBias[0] = 0.0f;
+    aFilter->GyroscopeBias[1] = 0.0f;
+    aFilter->GyroscopeBias[2] = 0.0f;
+    aFilter->Kp = ORIENTATION_FILTER_KP_DEFAULT;
+    aFilter->Ki = ORIENTATION_FILTER_KI_DEFAULT;
+}
+
+/**
+ * @param aAccelerometer any unit, only direction is used
+ * @param aCompass calibrated values, any unit. NULL if not available.
+ */
+void OrientationFilter_update(OrientationFilterTypeDef *aFilter, const float *aGyroscopeRadiansPerSecond,
+        const float *aAccelerometer, const float *aCompass, float aDeltaSeconds) {
+    float q0 = aFilter->Q0;
+    float q1 = aFilter->Q1;
+    float q2 = aFilter->Q2;
+    float q3 = aFilter->Q3;
+    float gx = aGyroscopeRadiansPerSecond[0];
+    float gy = aGyroscopeRadiansPerSecond[1];
+    float gz = aGyroscopeRadiansPerSecond[2];
+    float ax = aAccelerometer[0];
+    float ay = aAccelerometer[1];
+    float az = aAccelerometer[2];
+
+    float tSquareSum = ax * ax + ay * ay + az * az;
+    if (tSquareSum > 0.0f) {
+        float tNorm = invSqrt(tSquareSum);
+        ax *= tNorm;
+        ay *= tNorm;
+        az *= tNorm;
+
+        // estimated direction of gravity
+        float vx = 2.0f * (q1 * q3 - q0 * q2);
+        float vy = 2.0f * (q0 * q1 + q2 * q3);
+        float vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+
+        // error is cross product between estimated and measured direction
+        float ex = ay * vz - az * vy;
+        float ey = az * vx - ax * vz;
+        float ez = ax * vy - ay * vx;
+
+        if (aCompass != NULL) {
+            float mx = aCompass[0];
+            float my = aCompass[1];
+            float mz = aCompass[2];
+            tSquareSum = mx * mx + my * my + mz * mz;
+            if (tSquareSum > 0.0f) {
+                tNorm = invSqrt(tSquareSum);
+                mx *= tNorm;
+                my *= tNorm;
+                mz *= tNorm;
+
+                // reference direction of earth magnetic field
+                float hx = 2.0f * (mx * (0.5f - q2 * q2 - q3 * q3) + my * (q1 * q2 - q0 * q3) + mz * (q1 * q3 + q0 * q2));
+                float hy = 2.0f * (mx * (q1 * q2 + q0 * q3) + my * (0.5f - q1 * q1 - q3 * q3) + mz * (q2 * q3 - q0 * q1));
+                float bx = sqrtf(hx * hx + hy * hy);
+                float bz = 2.0f * (mx * (q1 * q3 - q0 * q2) + my * (q2 * q3 + q0 * q1) + mz * (0.5f - q1 * q1 - q2 * q2));
+
+                // estimated direction of magnetic field
+                float wx = 2.0f * (bx * (0.5f - q2 * q2 - q3 * q3) + bz * (q1 * q3 - q0 * q2));
+                float wy = 2.0f * (bx * (q1 * q2 - q0 * q3) + bz * (q0 * q1 + q2 * q3));
+                float wz = 2.0f * (bx * (q0 * q2 + q1 * q3) + bz * (0.5f - q1 * q1 - q2 * q2));
+
+                ex += my * wz - mz * wy;
+                ey += mz * wx - mx * wz;
+                ez += mx * wy - my * wx;
+            }
+        }
+
+        // integral feedback converges to the negative gyroscope bias
+        if (aFilter->Ki > 0.0f) {
+            aFilter->GyroscopeBias[0] -= aFilter->Ki * ex * aDeltaSeconds;
+            aFilter->GyroscopeBias[1] -= aFilter->Ki * ey * aDeltaSeconds;
+            aFilter->GyroscopeBias[2] -= aFilter->Ki * ez * aDeltaSeconds;
+        }
+        gx += aFilter->Kp * ex;
+        gy += aFilter->Kp * ey;
+        gz += aFilter->Kp * ez;
+    }
+    gx -= aFilter->GyroscopeBias[0];
+    gy -= aFilter->GyroscopeBias[1];
+    gz -= aFilter->GyroscopeBias[2];
+
+    // integrate rate of change of quaternion
+    float tHalfDelta = 0.5f * aDeltaSeconds;
+    gx *= tHalfDelta;
+    gy *= tHalfDelta;
+    gz *= tHalfDelta;
+    aFilter->Q0 = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    aFilter->Q1 = q1 + (q0 * gx + q2 * gz - q3 * gy);
+    aFilter->Q2 = q2 + (q0 * gy - q1 * gz + q3 * gx);
+    aFilter->Q3 = q3 + (q0 * gz + q1 * gy - q2 * gx);
+
+    float tNorm = invSqrt(
+            aFilter->Q0 * aFilter->Q0 + aFilter->Q1 * aFilter->Q1 + aFilter->Q2 * aFilter->Q2 + aFilter->Q3 * aFilter->Q3);
+    aFilter->Q0 *= tNorm;
+    aFilter->Q1 *= tNorm;
+    aFilter->Q2 *= tNorm;
+    aFilter->Q3 *= tNorm;
+}
+
+void OrientationFilter_getEulerAngles(OrientationFilterTypeDef *aFilter, EulerAnglesTypeDef *aAngles) {
+    float q0 = aFilter->Q0;
+    float q1 = aFilter->Q1;
+    float q2 = aFilter->Q2;
+    float q3 = aFilter->Q3;
+    aAngles->Roll = atan2f(2.0f * (q0 * q1 + q2 * q3), 1.0f - 2.0f * (q1 * q1 + q2 * q2)) * RADIANS_TO_DEGREE;
+    float tSinPitch = 2.0f * (q0 * q2 - q3 * q1);
+    if (tSinPitch > 1.0f) {
+        tSinPitch = 1.0f;
+    } else if (tSinPitch < -1.0f) {
+        tSinPitch = -1.0f;
+    }
+    aAngles->Pitch = asinf(tSinPitch) * RADIANS_TO_DEGREE;
+    aAngles->Yaw = atan2f(2.0f * (q0 * q3 + q1 * q2), 1.0f - 2.0f * (q2 * q2 + q3 * q3)) * RADIANS_TO_DEGREE;
+}
+
+/*
+ * Compass calibration
+ */
+void CompassCalibration_init(CompassCalibrationTypeDef *aCalibration) {
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        aCalibration->Offset[i] = 0.0f;
+        aCalibration->Scale[i] = 1.0f;
+    }
+    aCalibration->IsCalibrating = false;
+    aCalibration->IsValid = false;
+}
+
+void CompassCalibration_start(CompassCalibrationTypeDef *aCalibration) {
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        aCalibration->Minimum[i] = INT16_MAX;
+        aCalibration->Maximum[i] = INT16_MIN;
+    }
+    aCalibration->IsCalibrating = true;
+}
+
+void CompassCalibration_addSample(CompassCalibrationTypeDef *aCalibration, const int16_t *aCompassRaw) {
+    if (!aCalibration->IsCalibrating) {
+        return;
+    }
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        if (aCompassRaw[i] < aCalibration->Minimum[i]) {
+            aCalibration->Minimum[i] = aCompassRaw[i];
+        }
+        if (aCompassRaw[i] > aCalibration->Maximum[i]) {
+            aCalibration->Maximum[i] = aCompassRaw[i];
+        }
+    }
+}
+
+/**
+ * Computes offset and scale from the values collected since CompassCalibration_start()
+ * @return false if board was not rotated enough, previous calibration is kept then
+ */
+bool CompassCalibration_stop(CompassCalibrationTypeDef *aCalibration) {
+    aCalibration->IsCalibrating = false;
+    float tRange[3];
+    float tAverageRange = 0.0f;
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        int32_t tRangeInt = (int32_t) aCalibration->Maximum[i] - aCalibration->Minimum[i];
+        if (tRangeInt < COMPASS_CALIBRATION_MIN_RANGE) {
+            return false;
+        }
+        tRange[i] = tRangeInt;
+        tAverageRange += tRange[i];
+    }
+    tAverageRange /= 3;
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        aCalibration->Offset[i] = ((int32_t) aCalibration->Maximum[i] + aCalibration->Minimum[i]) / 2.0f;
+        aCalibration->Scale[i] = tAverageRange / tRange[i];
+    }
+    aCalibration->IsValid = true;
+    return true;
+}
+
+void CompassCalibration_apply(CompassCalibrationTypeDef *aCalibration, const int16_t *aCompassRaw, float *aCompassCalibrated) {
+    for (uint_fast8_t i = 0; i < 3; ++i) {
+        aCompassCalibrated[i] = (aCompassRaw[i] - aCalibration->Offset[i]) * aCalibration->Scale[i];
+    }
+}
@@ -0,0 +1,248 @@
+/*
+ * @file sensorAcquisition.cpp
+ *
+ * One burst reads the FIFO status and content of the gyroscope, then of the accelerometer and then the latest compass value.
+ * The compass has no FIFO, so its rate is limited to the burst rate.
+ * The sensors write their FIFOs with their output data rate, so the samples of one burst are evenly spaced.
+ * The newest sample gets the burst timestamp, the older ones are timestamped backwards with the sample period.
+ *
+ *  Created on: 19.10.2026
+ * @author Armin Joachimsmeyer
+ * armin.joachimsmeyer@gmail.com
+ * @copyright LGPL v3 (http://www.gnu.org/licenses/lgpl.html)
+ * @version 1.0.0
+ */
+
+#include "sensorAcquisition.h"
+#include <stddef.h> // for NULL
+#include <string.h> // for memset
+
+#define STATE_IDLE                      0
+#define STATE_GYROSCOPE_FIFO_STATUS     1
+#define STATE_GYROSCOPE_FIFO_DATA       2
+#define STATE_ACCELEROMETER_FIFO_STATUS 3
+#define STATE_ACCELEROMETER_FIFO_DATA   4
+#define STATE_COMPASS_DATA              5
+
+static const SensorBusTypeDef *sBus = NULL;
+static volatile uint8_t sState = STATE_IDLE;
+static uint32_t sBurstTimestampMicros;
+static uint32_t sSamplePeriodMicros[NUMBER_OF_SENSORS];
+static uint8_t sPendingSampleCount;
+static uint8_t sBurstBuffer[SENSOR_BURST_BUFFER_SIZE] __attribute__ ((aligned(4)));
+
+/*
+ * Ring with one producer (burst ISR) and one consumer (main loop)
+ */
+static SensorSampleTypeDef sSampleRing[SENSOR_SAMPLE_RING_SIZE];
+static volatile uint16_t sSampleRingIn = 0; // only written by producer
+static volatile uint16_t sSampleRingOut = 0; // only written by consumer
+
+volatile SensorAcquisitionStatisticsTypeDef SensorAcquisitionStatistics;
+
+static void startStep(uint8_t aState);
+
+/**
+ * @param aBus functions for non blocking register reads
+ * @param aGyroscopeSamplePeriodMicros 1000000 / output data rate
+ */
+void SensorAcquisition_init(const SensorBusTypeDef *aBus, uint32_t aGyroscopeSamplePeriodMicros,
+        uint32_t aAccelerometerSamplePeriodMicros) {
+    sBus = aBus;
+    sSamplePeriodMicros[SENSOR_GYROSCOPE] = aGyroscopeSamplePeriodMicros;
+    sSamplePeriodMicros[SENSOR_ACCELEROMETER] = aAccelerometerSamplePeriodMicros;
+    sSamplePeriodMicros[SENSOR_COMPASS] = 0;
+    sState = STATE_IDLE;
+    sSampleRingIn = 0;
+    sSampleRingOut = 0;
+    memset((void *) &SensorAcquisitionStatistics, 0, sizeof(SensorAcquisitionStatistics));
+}
+
+bool SensorAcquisition_isIdle(void) {
+    return sState == STATE_IDLE;
+}
+
+static void putSample(uint8_t aSensor, uint32_t aTimestampMicros, int16_t aX, int16_t aY, int16_t aZ) {
+    uint16_t tNextIn = (sSampleRingIn + 1) & (SENSOR_SAMPLE_RING_SIZE - 1);
+    if (tNextIn == sSampleRingOut) {
+        SensorAcquisitionStatistics.RingOverruns++;
+        return;
+    }
+    SensorSampleTypeDef *tSample = &sSampleRing[sSampleRingIn];
+    tSample->TimestampMicros = aTimestampMicros;
+    tSample->Values[0] = aX;
+    tSample->Values[1] = aY;
+    tSample->Values[2] = aZ;
+    tSample->Sensor = aSensor;
+    sSampleRingIn = tNextIn;
+    SensorAcquisitionStatistics.Samples[aSensor]++;
+}
+
+/**
+ * @return number of samples in FIFO
+ */
+static uint8_t getFifoCount(uint8_t aSensor, uint8_t aFifoSource) {
+    if (aFifoSource & SENSOR_FIFO_SRC_EMPTY) {
+        return 0;
+    }
+    if (aFifoSource & SENSOR_FIFO_SRC_OVERRUN) {
+        // oldest samples are already overwritten
+        SensorAcquisitionStatistics.FifoOverruns[aSensor]++;
+        return SENSOR_FIFO_DEPTH;
+    }
+    return aFifoSource & SENSOR_FIFO_SRC_COUNT_MASK;
+}
+
+/*
+ * Both FIFOs deliver little endian X, Y, Z. Accelerometer data is left aligned 12 bit.
+ */
+static void storeFifoSamples(uint8_t aSensor, uint8_t aCount) {
+    uint32_t tTimestampMicros = sBurstTimestampMicros - ((aCount - 1) * sSamplePeriodMicros[aSensor]);
+    uint8_t tShift = 0;
+    if (aSensor == SENSOR_ACCELEROMETER) {
+        tShift = 4;
+    }
+    uint8_t *tBufferPtr = sBurstBuffer;
+    for (uint_fast8_t i = 0; i < aCount; ++i) {
+        int16_t tX = ((int16_t) (tBufferPtr[1] << 8 | tBufferPtr[0])) >> tShift;
+        int16_t tY = ((int16_t) (tBufferPtr[3] << 8 | tBufferPtr[2])) >> tShift;
+        int16_t tZ = ((int16_t) (tBufferPtr[5] << 8 | tBufferPtr[4])) >> tShift;
+        putSample(aSensor, tTimestampMicros, tX, tY, tZ);
+        tBufferPtr += SENSOR_BYTES_PER_SAMPLE;
+        tTimestampMicros += sSamplePeriodMicros[aSensor];
+    }
+}
+
+/*
+ * Compass delivers big endian X, Z, Y
+ */
+static void storeCompassSample(void) {
+    int16_t tX = (int16_t) (sBurstBuffer[0] << 8 | sBurstBuffer[1]);
+    int16_t tZ = (int16_t) (sBurstBuffer[2] << 8 | sBurstBuffer[3]);
+    int16_t tY = (int16_t) (sBurstBuffer[4] << 8 | sBurstBuffer[5]);
+    putSample(SENSOR_COMPASS, sBurstTimestampMicros, tX, tY, tZ);
+}
+
+/**
+ * Starts reading of all sensors. To be called periodically by timer ISR.
+ * The period must be shorter than the time for the fastest sensor to fill its FIFO.
+ * @return false if previous burst is still running
+ */
+bool SensorAcquisition_startBurst(uint32_t aTimestampMicros) {
+    if (sBus == NULL || sState != STATE_IDLE) {
+        SensorAcquisitionStatistics.BurstsSkipped++;
+        return false;
+    }
+    SensorAcquisitionStatistics.Bursts++;
+    sBurstTimestampMicros = aTimestampMicros;
+    startStep(STATE_GYROSCOPE_FIFO_STATUS);
+    return true;
+}
+
+/*
+ * Starts the read of a step. If the bus is busy, the step is skipped and the next sensor is tried.
+ * The samples of a skipped FIFO are read with the next burst.
+ */
+static void startStep(uint8_t aState) {
+    while (aState != STATE_IDLE) {
+        sState = aState;
+        bool tStarted;
+        if (aState == STATE_GYROSCOPE_FIFO_STATUS) {
+            tStarted = sBus->startRead(SENSOR_GYROSCOPE, SENSOR_L3GD20_FIFO_SRC_REG, sBurstBuffer, 1);
+            aState = STATE_ACCELEROMETER_FIFO_STATUS;
+        } else if (aState == STATE_ACCELEROMETER_FIFO_STATUS) {
+            tStarted = sBus->startRead(SENSOR_ACCELEROMETER, SENSOR_LSM303_FIFO_SRC_REG_A, sBurstBuffer, 1);
+            aState = STATE_COMPASS_DATA;
+        } else {
+            tStarted = sBus->startRead(SENSOR_COMPASS, SENSOR_LSM303_OUT_X_H_M, sBurstBuffer, SENSOR_BYTES_PER_SAMPLE);
+            aState = STATE_IDLE;
+        }
+        if (tStarted) {
+            return;
+        }
+        SensorAcquisitionStatistics.BusBusy++;
+    }
+    sState = STATE_IDLE;
+}
+
+/*
+ * Reads the FIFO content if the FIFO is not empty, otherwise starts aNextState
+ */
+static void startFifoDataRead(uint8_t aSensor, uint8_t aRegister, uint8_t aDataState, uint8_t aNextState) {
+    uint8_t tCount = getFifoCount(aSensor, sBurstBuffer[0]);
+    if (tCount > 0) {
+        sState = aDataState;
+        sPendingSampleCount = tCount;
+        if (sBus->startRead(aSensor, aRegister, sBurstBuffer, tCount * SENSOR_BYTES_PER_SAMPLE)) {
+            return;
+        }
+        SensorAcquisitionStatistics.BusBusy++;
+    }
+    startStep(aNextState);
+}
+
+/**
+ * Called by the bus implementation when a transfer started by startRead() has finished.
+ */
+void SensorAcquisition_readCompleted(bool aSuccess) {
+    uint8_t tState = sState;
+    if (!aSuccess) {
+        SensorAcquisitionStatistics.BusErrors++;
+    }
+    switch (tState) {
+    case STATE_GYROSCOPE_FIFO_STATUS:
+        if (aSuccess) {
+            startFifoDataRead(SENSOR_GYROSCOPE, SENSOR_L3GD20_OUT_X_L, STATE_GYROSCOPE_FIFO_DATA, STATE_ACCELEROMETER_FIFO_STATUS);
+        } else {
+            startStep(STATE_ACCELEROMETER_FIFO_STATUS);
+        }
+        break;
+    case STATE_GYROSCOPE_FIFO_DATA:
+        if (aSuccess) {
+            storeFifoSamples(SENSOR_GYROSCOPE, sPendingSampleCount);
+        }
+        startStep(STATE_ACCELEROMETER_FIFO_STATUS);
+        break;
+    case STATE_ACCELEROMETER_FIFO_STATUS:
+        if (aSuccess) {
+            startFifoDataRead(SENSOR_ACCELEROMETER, SENSOR_LSM303_OUT_X_L_A, STATE_ACCELEROMETER_FIFO_DATA, STATE_COMPASS_DATA);
+        } else {
+            startStep(STATE_COMPASS_DATA);
+        }
+        break;
+    case STATE_ACCELEROMETER_FIFO_DATA:
+        if (aSuccess) {
+            storeFifoSamples(SENSOR_ACCELEROMETER, sPendingSampleCount);
+        }
+        startStep(STATE_COMPASS_DATA);
+        break;
+    case STATE_COMPASS_DATA:
+        if (aSuccess) {
+            storeCompassSample();
+        }
+        sState = STATE_IDLE;
+        break;
+    default:
+        break;
+    }
+}
+
+uint16_t SensorAcquisition_getAvailable(void) {
+    return (sSampleRingIn - sSampleRingOut) & (SENSOR_SAMPLE_RING_SIZE - 1);
+}
+
+/**
+ * To be called by main loop. Copies the oldest samples to aSampleBuffer and removes them from the ring.
+ * @return number of samples copied
+ */
+uint16_t SensorAcquisition_getSamples(SensorSampleTypeDef *aSampleBuffer, uint16_t aMaxCount) {
+    uint16_t tCount = 0;
+    uint16_t tOut = sSampleRingOut;
+    uint16_t tIn = sSampleRingIn;
+    while (tOut != tIn && tCount < aMaxCount) {
+        aSampleBuffer[tCount++] = sSampleRing[tOut];
+        tOut = (tOut + 1) & (SENSOR_SAMPLE_RING_SIZE - 1);
+    }
+    sSampleRingOut = tOut;
+    return tCount;
+}